@@ -55,6 +55,7 @@ char *w32_getenv (char *);
 #  ifdef HAVE_SOCKETS
 #    include <sys/types.h>
 #    include <sys/socket.h>
+#    include <sys/select.h>
 #    include <sys/un.h>
 #  endif /* HAVE_SOCKETS */
 # endif
@@ -119,6 +120,10 @@ int quiet = 0;
 /* Nonzero means args are expressions to be evaluated.  --eval.  */
 int eval = 0;
 
+/* Nonzero means evaluate expressions read from stdin, one per line,
+   over a single connection.  --stream.  */
+int stream = 0;
+
 /* Nonzero means don't open a new frame.  Inverse of --create-frame.  */
 int current_frame = 1;
 
@@ -172,6 +177,7 @@ struct option longopts[] =
   { "server-file",	required_argument, NULL, 'f' },
   { "display",	required_argument, NULL, 'd' },
   { "parent-id", required_argument, NULL, 'p' },
+  { "stream",	no_argument,	   NULL, 'S' },
   { 0, 0, 0, 0 }
 };
 
@@ -190,6 +196,20 @@ xmalloc (size_t size)
   return result;
 }
 
+/* Like realloc but get fatal error if memory is exhausted.  */
+
+static void *
+xrealloc (void *ptr, size_t size)
+{
+  void *result = realloc (ptr, size);
+  if (result == NULL)
+    {
+      perror ("realloc");
+      exit (EXIT_FAILURE);
+    }
+  return result;
+}
+
 /* From sysdep.c */
 #if !defined (HAVE_GET_CURRENT_DIR_NAME) || defined (BROKEN_GET_CURRENT_DIR_NAME)
 
@@ -511,6 +531,11 @@ decode_options (int argc, char **argv)
 	  quiet = 1;
 	  break;
 
+	case 'S':
+	  stream = 1;
+	  eval = 1;
+	  break;
+
 	case 'V':
 	  message (false, "emacsclient %s\n", VERSION);
 	  exit (EXIT_SUCCESS);
@@ -628,6 +653,8 @@ The following OPTIONS are accepted:\n\
 -F ALIST, --frame-parameters=ALIST\n\
 			Set the parameters of a new frame\n\
 -e, --eval    		Evaluate the FILE arguments as ELisp expressions\n\
+--stream		Evaluate expressions read from stdin, one per line,\n\
+			over a single connection\n\
 -n, --no-wait		Don't wait for the server to return\n\
 -q, --quiet		Don't display messages on success\n\
 -d DISPLAY, --display=DISPLAY\n\
@@ -1517,6 +1544,230 @@ start_daemon_and_retry_set_socket (void)
 #endif /* WINDOWSNT */
 }
 
+/* In --stream mode, each expression is sent as LENGTH:EXPR followed
+   by a newline, LENGTH being the number of bytes in EXPR.  Emacs
+   answers each one, in order, with =LENGTH:VALUE or !LENGTH:MESSAGE
+   followed by a newline.  Expressions are sent as soon as they are
+   read, without waiting for the answers to the previous ones.  */
+
+struct stream_buffer
+{
+  char *data;
+  size_t len, size;
+};
+
+/* Number of expressions sent but not answered yet.  */
+static size_t stream_pending;
+
+static void
+stream_buffer_add (struct stream_buffer *b, const char *data, size_t n)
+{
+  /* Keep room for a terminating null.  */
+  if (b->size - b->len <= n)
+    {
+      b->size = b->len + n + BUFSIZ;
+      b->data = xrealloc (b->data, b->size);
+    }
+  memcpy (b->data + b->len, data, n);
+  b->len += n;
+}
+
+/* Send each complete line of B to Emacs as an expression, and remove
+   it from B.  If EOF, send the incomplete last line too.  */
+
+static void
+stream_send_lines (struct stream_buffer *b, bool eof)
+{
+  char *p = b->data, *end = b->data + b->len;
+
+  if (b->len == 0)
+    return;
+
+  while (p < end)
+    {
+      char *nl = memchr (p, '\n', end - p);
+      char header[sizeof "18446744073709551615:"];
+
+      if (!nl)
+	{
+	  if (!eof)
+	    break;
+	  nl = end;
+	}
+      *nl = '\0';
+      if (nl > p)
+	{
+	  sprintf (header, "%lu:", (unsigned long) (nl - p));
+	  send_to_emacs (emacs_socket, header);
+	  send_to_emacs (emacs_socket, p);
+	  send_to_emacs (emacs_socket, "\n");
+	  stream_pending++;
+	}
+      p = nl < end ? nl + 1 : end;
+    }
+
+  b->len = end - p;
+  memmove (b->data, p, b->len);
+}
+
+/* Print the answers that B holds completely, and remove them from B.
+   If EOF, the connection is closed, and the last message may lack its
+   newline.  Return false if Emacs sent an error that ends the
+   connection, or something we cannot understand.  */
+
+static bool
+stream_print_answers (struct stream_buffer *b, bool eof, int *exit_status)
+{
+  size_t pos = 0;
+  bool ok = true;
+
+  while (ok && pos < b->len)
+    {
+      char *p = b->data + pos;
+      size_t avail = b->len - pos;
+
+      if (*p == '-')
+	{
+	  /* An ordinary message, as sent before the stream starts.  */
+	  char *nl = memchr (p, '\n', avail);
+	  if (!nl && !eof)
+	    break;
+	  pos += nl ? nl - p + 1 : avail;
+	  if (nl)
+	    *nl = '\0';
+	  else
+	    p[avail] = '\0';
+
+	  if (strprefix ("-emacs-pid ", p))
+	    emacs_pid = strtol (p + strlen ("-emacs-pid"), NULL, 10);
+	  else if (strprefix ("-error ", p))
+	    {
+	      fprintf (stderr, "*ERROR*: %s\n",
+		       unquote_argument (p + strlen ("-error ")));
+	      ok = false;
+	    }
+	}
+      else if (*p == '=' || *p == '!')
+	{
+	  char *colon = memchr (p, ':', avail);
+	  unsigned long len;
+	  size_t need;
+
+	  if (!colon)
+	    {
+	      if (eof)
+		ok = false;
+	      break;
+	    }
+	  len = strtoul (p + 1, NULL, 10);
+	  need = colon - p + 1 + len + 1;
+	  if (avail < need)
+	    break;
+
+	  if (*p == '=')
+	    {
+	      fwrite (colon + 1, 1, len, stdout);
+	      putchar ('\n');
+	    }
+	  else
+	    {
+	      fprintf (stderr, "*ERROR*: %.*s\n", (int) len, colon + 1);
+	      *exit_status = EXIT_FAILURE;
+	    }
+	  stream_pending--;
+	  pos += need;
+	}
+      else
+	{
+	  message (true, "%s: unexpected answer from Emacs\n", progname);
+	  ok = false;
+	}
+    }
+
+  fflush (stdout);
+  if (pos > 0)
+    {
+      b->len -= pos;
+      memmove (b->data, b->data + pos, b->len);
+    }
+  return ok;
+}
+
+/* Evaluate the expressions read from stdin, one per line, printing
+   their values as they arrive.  Return the exit status.  */
+
+static int
+stream_expressions (void)
+{
+  struct stream_buffer in = { NULL, 0, 0 }, out = { NULL, 0, 0 };
+  char chunk[BUFSIZ];
+  bool stdin_open = true;
+  int exit_status = EXIT_SUCCESS;
+
+  while (stdin_open || stream_pending > 0)
+    {
+      bool read_stdin, read_socket;
+      int rl;
+
+#ifndef WINDOWSNT
+      fd_set rfds;
+
+      FD_ZERO (&rfds);
+      if (stdin_open)
+	FD_SET (0, &rfds);
+      FD_SET (emacs_socket, &rfds);
+      if (select (emacs_socket + 1, &rfds, NULL, NULL, NULL) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  message (true, "%s: select: %s\n", progname, strerror (errno));
+	  return EXIT_FAILURE;
+	}
+      read_stdin = stdin_open && FD_ISSET (0, &rfds);
+      read_socket = FD_ISSET (emacs_socket, &rfds);
+#else
+      /* The console cannot be waited for along with a socket, so
+	 send the expressions one at a time.  */
+      read_stdin = stdin_open && stream_pending == 0;
+      read_socket = !read_stdin;
+#endif
+
+      if (read_stdin)
+	{
+	  rl = read (0, chunk, sizeof chunk);
+	  if (rl < 0 && errno == EINTR)
+	    continue;
+	  if (rl <= 0)
+	    stdin_open = false;
+	  else
+	    stream_buffer_add (&in, chunk, rl);
+	  stream_send_lines (&in, !stdin_open);
+	}
+
+      if (read_socket)
+	{
+	  rl = recv (emacs_socket, chunk, sizeof chunk, 0);
+	  if (rl < 0 && errno == EINTR)
+	    continue;
+	  if (rl > 0)
+	    stream_buffer_add (&out, chunk, rl);
+	  if (!stream_print_answers (&out, rl <= 0, &exit_status))
+	    return EXIT_FAILURE;
+	  if (rl <= 0)
+	    {
+	      if (stream_pending > 0)
+		{
+		  message (true, "%s: connection to Emacs closed\n", progname);
+		  exit_status = EXIT_FAILURE;
+		}
+	      break;
+	    }
+	}
+    }
+
+  return exit_status;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -1548,6 +1799,14 @@ main (int argc, char **argv)
       exit (EXIT_FAILURE);
     }
 
+  if (stream && argc - optind > 0)
+    {
+      message (true, "%s: --stream reads expressions from stdin only\n"
+	       "Try `%s --help' for more information\n",
+	       progname, progname);
+      exit (EXIT_FAILURE);
+    }
+
 #ifndef WINDOWSNT
   if (tty)
     {
@@ -1632,7 +1891,7 @@ main (int argc, char **argv)
   /* Unless we are certain we don't want to occupy the tty, send our
      tty information to Emacs.  For example, in daemon mode Emacs may
      need to occupy this tty if no other frame is available.  */
-  if (!current_frame || !eval)
+  if (!stream && (!current_frame || !eval))
     {
       const char *tty_type, *tty_name;
 
@@ -1652,7 +1911,9 @@ main (int argc, char **argv)
   if (!current_frame && !tty)
     send_to_emacs (emacs_socket, "-window-system ");
 
-  if ((argc - optind > 0))
+  if (stream)
+    send_to_emacs (emacs_socket, "-stream ");
+  else if ((argc - optind > 0))
     {
       int i;
       for (i = optind; i < argc; i++)
@@ -1718,6 +1979,13 @@ main (int argc, char **argv)
 
   send_to_emacs (emacs_socket, "\n");
 
+  if (stream)
+    {
+      exit_status = stream_expressions ();
+      CLOSE_SOCKET (emacs_socket);
+      return exit_status;
+    }
+
   /* Wait for an answer. */
   if (!eval && !tty && !nowait && !quiet)
     {
@@ -133,6 +133,10 @@ char pot_etags_version[] = "@(#) pot revision number is 17.38.1.4";
 #include <sys/stat.h>
 #include <c-strcase.h>
 
+#ifndef DOS_NT
+# include <sys/wait.h>
+#endif
+
 #include <assert.h>
 #ifdef NDEBUG
 # undef  assert			/* some systems have a buggy assert.h */
@@ -312,6 +316,7 @@ static void Yacc_entries (FILE *);
 static void just_read_file (FILE *);
 
 static language *get_language_from_langname (const char *);
+static compressor *get_compressor_from_suffix (char *, char **);
 static void readline (linebuffer *, FILE *);
 static long readline_internal (linebuffer *, FILE *);
 static bool nocase_tail (const char *);
@@ -327,6 +332,14 @@ static _Noreturn void pfatal (const char *);
 static void add_node (node *, node **);
 
 static void init (void);
+static void process_arguments (argument *, int, int, int);
+#ifndef DOS_NT
+static bool process_arguments_in_parallel (argument *, int, int);
+#endif
+static bool read_old_tags (void);
+static void skip_unchanged_files (argument *, int);
+static void write_updated_tags (void);
+static void write_tags_index (void);
 static void process_file_name (char *, language *);
 static void process_file (FILE *, char *, language *);
 static void find_entries (FILE *);
@@ -416,6 +429,8 @@ static bool cxref_style;	/* -x: create cxref style output */
 static bool cplusplus;		/* .[hc] means C++, not C (undocumented) */
 static bool ignoreindent;	/* -I: ignore indentation in C */
 static int packages_only;	/* --packages-only: in Ada, only tag packages*/
+static int jobs = 1;		/* -j: number of parallel processes */
+static int write_index;		/* --index: write an index of tag names */
 
 /* STDIN is defined in LynxOS system headers */
 #ifdef STDIN
@@ -447,6 +462,7 @@ static struct option longopts[] =
   { "no-regex",           no_argument,       NULL,               'R'   },
   { "ignore-case-regex",  required_argument, NULL,               'c'   },
   { "parse-stdin",        required_argument, NULL,               STDIN },
+  { "update",             no_argument,       NULL,               'u'   },
   { "version",            no_argument,       NULL,               'V'   },
 
 #if CTAGS /* Ctags options */
@@ -456,7 +472,6 @@ static struct option longopts[] =
   { "globals",            no_argument,       &globals,           1     },
   { "typedefs",           no_argument,       NULL,               't'   },
   { "typedefs-and-c++",   no_argument,       NULL,               'T'   },
-  { "update",             no_argument,       NULL,               'u'   },
   { "vgrind",             no_argument,       NULL,               'v'   },
   { "no-warn",            no_argument,       NULL,               'w'   },
 
@@ -464,6 +479,8 @@ static struct option longopts[] =
   { "no-defines",         no_argument,       NULL,               'D'   },
   { "no-globals",         no_argument,       &globals,           0     },
   { "include",            required_argument, NULL,               'i'   },
+  { "index",              no_argument,       &write_index,       1     },
+  { "jobs",               required_argument, NULL,               'j'   },
 #endif
   { NULL }
 };
@@ -884,6 +901,19 @@ Relative ones are stored relative to the output file's directory.\n");
         a tag, one should also consult the tags file FILE after\n\
         checking the current file.");
 
+  if (!CTAGS)
+    puts ("--index\n\
+        Also write a sorted index of the tag names, which etags.el\n\
+        uses to find tags without searching the whole tag file.  Its\n\
+        name is that of the tag file followed by \".idx\".");
+
+#ifndef DOS_NT
+  if (!CTAGS)
+    puts ("-j N, --jobs=N\n\
+        Parse the files with N processes working in parallel.  The tag\n\
+        file is the same as without this option.");
+#endif
+
   puts ("-l LANG, --language=LANG\n\
         Force the following files to be considered as written in the\n\
 	named language up to the next --language=LANG option.");
@@ -951,6 +981,11 @@ Relative ones are stored relative to the output file's directory.\n");
         files and then rewriting the new entries at the end of the\n\
         tags file.  It is often faster to simply rebuild the entire\n\
         tag file than to use this.");
+  else
+    puts ("-u, --update\n\
+        Update the tag entries for the given files that were modified\n\
+        since the tag file was written, leaving the entries for other\n\
+        files in place.  Files not yet in the tag file are added.");
 
   if (CTAGS)
     {
@@ -999,7 +1034,6 @@ main (int argc, char **argv)
   char **included_files;
   argument *argbuffer;
   int current_arg, file_count;
-  linebuffer filename_lb;
   bool help_asked = false;
   ptrdiff_t len;
  char *optstring;
@@ -1031,7 +1065,7 @@ main (int argc, char **argv)
   /* When the optstring begins with a '-' getopt_long does not rearrange the
      non-options arguments to be at the end, but leaves them alone. */
   optstring = concat ("-ac:Cf:Il:o:r:RSVhH",
-		      (CTAGS) ? "BxdtTuvw" : "Di:",
+		      (CTAGS) ? "BxdtTuvw" : "Di:j:u",
 		      "");
 
   while ((opt = getopt_long (argc, argv, optstring, longopts, NULL)) != EOF)
@@ -1123,13 +1157,22 @@ main (int argc, char **argv)
 	/* Etags options */
       case 'D': constantypedefs = false;			break;
       case 'i': included_files[nincluded_files++] = optarg;	break;
+      case 'u': update = true;					break;
+      case 'j':
+	jobs = atoi (optarg);
+	if (jobs < 1)
+	  {
+	    error ("-j option needs a positive number.");
+	    suggest_asking_for_help ();
+	    /* NOTREACHED */
+	  }
+	break;
 
 	/* Ctags options. */
       case 'B': searchar = '?';					break;
       case 'd': constantypedefs = true;				break;
       case 't': typedefs = true;				break;
       case 'T': typedefs = typedefs_or_cplusplus = true;	break;
-      case 'u': update = true;					break;
       case 'v': vgrind_style = true;			  /*FALLTHRU*/
       case 'x': cxref_style = true;				break;
       case 'w': no_warnings = true;				break;
@@ -1186,13 +1229,26 @@ main (int argc, char **argv)
   init ();			/* set up boolean "functions" */
 
   linebuffer_init (&lb);
-  linebuffer_init (&filename_lb);
   linebuffer_init (&filebuf);
   linebuffer_init (&token_name);
 
   if (!CTAGS)
     {
-      if (streq (tagfile, "-"))
+      if (update)
+	{
+	  if (streq (tagfile, "-"))
+	    fatal ("cannot update standard output", (char *)NULL);
+	  /* Without a tag file to update, write a new one.  */
+	  update = read_old_tags ();
+	}
+      if (update)
+	{
+	  /* Write the tags of the files parsed to a temporary file,
+	     to be merged with the old tags by write_updated_tags. */
+	  skip_unchanged_files (argbuffer, current_arg);
+	  tagf = tmpfile ();
+	}
+      else if (streq (tagfile, "-"))
 	{
 	  tagf = stdout;
 #ifdef DOS_NT
@@ -1211,40 +1267,11 @@ main (int argc, char **argv)
   /*
    * Loop through files finding functions.
    */
-  for (i = 0; i < current_arg; i++)
-    {
-      static language *lang;	/* non-NULL if language is forced */
-      char *this_file;
-
-      switch (argbuffer[i].arg_type)
-	{
-	case at_language:
-	  lang = argbuffer[i].lang;
-	  break;
-	case at_regexp:
-	  analyse_regex (argbuffer[i].what);
-	  break;
-	case at_filename:
-	      this_file = argbuffer[i].what;
-	      /* Input file named "-" means read file names from stdin
-		 (one per line) and use them. */
-	      if (streq (this_file, "-"))
-		{
-		  if (parsing_stdin)
-		    fatal ("cannot parse standard input AND read file names from it",
-			   (char *)NULL);
-		  while (readline_internal (&filename_lb, stdin) > 0)
-		    process_file_name (filename_lb.buffer, lang);
-		}
-	      else
-		process_file_name (this_file, lang);
-	  break;
-        case at_stdin:
-          this_file = argbuffer[i].what;
-          process_file (stdin, this_file, lang);
-          break;
-	}
-    }
+#ifndef DOS_NT
+  if (!(jobs > 1 && !CTAGS
+	&& process_arguments_in_parallel (argbuffer, current_arg, file_count)))
+#endif
+    process_arguments (argbuffer, current_arg, 0, file_count);
 
   free_regexps ();
   free (lb.buffer);
@@ -1269,8 +1296,13 @@ main (int argc, char **argv)
 	  while (nincluded_files-- > 0)
 	    fprintf (tagf, "\f\n%s,include\n", *included_files++);
 
-	  if (fclose (tagf) == EOF)
+	  if (update)
+	    write_updated_tags ();
+	  else if (fclose (tagf) == EOF)
 	    pfatal (tagfile);
+
+	  if (write_index && !streq (tagfile, "-"))
+	    write_tags_index ();
 	}
 
       exit (EXIT_SUCCESS);
@@ -1332,6 +1364,541 @@ main (int argc, char **argv)
 }
 
 
+/*
+ * Process the NARGS arguments in ARGBUFFER.  Of the file names, only
+ * those from the FIRST to before the LAST are processed, counting
+ * from 0; language and regexp arguments are always processed, as
+ * they apply to the file names after them.
+ */
+static void
+process_arguments (argument *argbuffer, int nargs, int first, int last)
+{
+  language *lang = NULL;	/* non-NULL if language is forced */
+  linebuffer filename_lb;
+  int i, file_index = 0;
+
+  linebuffer_init (&filename_lb);
+  for (i = 0; i < nargs; i++)
+    {
+      char *this_file;
+
+      switch (argbuffer[i].arg_type)
+	{
+	case at_language:
+	  lang = argbuffer[i].lang;
+	  break;
+	case at_regexp:
+	  analyse_regex (argbuffer[i].what);
+	  break;
+	case at_filename:
+	  this_file = argbuffer[i].what;
+	  file_index++;
+	  if (file_index <= first || file_index > last || this_file == NULL)
+	    break;
+	  /* Input file named "-" means read file names from stdin
+	     (one per line) and use them. */
+	  if (streq (this_file, "-"))
+	    {
+	      if (parsing_stdin)
+		fatal ("cannot parse standard input AND read file names from it",
+		       (char *)NULL);
+	      while (readline_internal (&filename_lb, stdin) > 0)
+		process_file_name (filename_lb.buffer, lang);
+	    }
+	  else
+	    process_file_name (this_file, lang);
+	  break;
+	case at_stdin:
+	  file_index++;
+	  if (file_index <= first || file_index > last)
+	    break;
+	  this_file = argbuffer[i].what;
+	  process_file (stdin, this_file, lang);
+	  break;
+	default:
+	  break;
+	}
+    }
+  free (filename_lb.buffer);
+}
+
+#ifndef DOS_NT
+
+static int
+compare_file_arguments (const void *a, const void *b)
+{
+  argument *const *pa = a;
+  argument *const *pb = b;
+  int cmp = strcmp ((*pa)->what, (*pb)->what);
+  return cmp ? cmp : (*pa > *pb) - (*pa < *pb);
+}
+
+/* Copy the contents of the temporary file FP to tagf, and close FP.  */
+static void
+copy_to_tagf (FILE *fp)
+{
+  char buf[BUFSIZ];
+  size_t n;
+
+  rewind (fp);
+  while ((n = fread (buf, 1, sizeof buf, fp)) > 0)
+    if (fwrite (buf, 1, n, tagf) != n)
+      pfatal (tagfile);
+  if (ferror (fp))
+    pfatal ("temporary file");
+  fclose (fp);
+}
+
+/*
+ * Process the NARGS arguments in ARGBUFFER, FILE_COUNT of which are
+ * file names, with `jobs' child processes.  Each child parses a
+ * consecutive share of the files and writes what it would write to
+ * tagf into three temporary files: the tags written as each file is
+ * done, the tags written at the end, and the entries of the files
+ * without tags.  These are copied to tagf, in that order and each in
+ * the order of the files, which gives the same tags file as
+ * processing the files in one process.  Return false, having done
+ * nothing, if the files can't be split: when reading file names or a
+ * file from standard input.
+ */
+static bool
+process_arguments_in_parallel (argument *argbuffer, int nargs, int file_count)
+{
+  FILE *(*parts)[3];
+  argument **files;
+  pid_t *pids;
+  bool failed = false;
+  int i, j, nfiles = 0;
+
+  if (parsing_stdin)
+    return false;
+  for (i = 0; i < nargs; i++)
+    if (argbuffer[i].arg_type == at_filename && argbuffer[i].what != NULL
+	&& streq (argbuffer[i].what, "-"))
+      return false;
+  if (jobs > file_count)
+    jobs = file_count;
+  if (jobs < 2)
+    return false;
+
+  /* A file named twice is tagged once, the first time, so drop the
+     later duplicates before splitting the files among the children.  */
+  files = xnew (file_count, argument *);
+  for (i = 0; i < nargs; i++)
+    if (argbuffer[i].arg_type == at_filename && argbuffer[i].what != NULL)
+      {
+	canonicalize_filename (argbuffer[i].what);
+	files[nfiles++] = &argbuffer[i];
+      }
+  qsort (files, nfiles, sizeof *files, compare_file_arguments);
+  for (i = j = 0; i < nfiles; i++)
+    if (i > j && streq (files[i]->what, files[j]->what))
+      files[i]->what = NULL;
+    else
+      j = i;
+  free (files);
+
+  parts = xmalloc (jobs * sizeof *parts);
+  pids = xnew (jobs, pid_t);
+  for (i = 0; i < jobs; i++)
+    for (j = 0; j < 3; j++)
+      if ((parts[i][j] = tmpfile ()) == NULL)
+	pfatal ("tmpfile");
+
+  fflush (stdout);
+  fflush (tagf);
+  for (i = 0; i < jobs; i++)
+    {
+      pids[i] = fork ();
+      if (pids[i] < 0)
+	pfatal ("fork");
+      if (pids[i] == 0)
+	{
+	  fdesc *fdp;
+
+	  tagf = parts[i][0];
+	  process_arguments (argbuffer, nargs,
+			     (long) file_count * i / jobs,
+			     (long) file_count * (i + 1) / jobs);
+	  tagf = parts[i][1];
+	  put_entries (nodehead);
+	  tagf = parts[i][2];
+	  for (fdp = fdhead; fdp != NULL; fdp = fdp->next)
+	    if (!fdp->written)
+	      fprintf (tagf, "\f\n%s,0\n", fdp->taggedfname);
+	  for (j = 0; j < 3; j++)
+	    if (fflush (parts[i][j]) == EOF)
+	      _exit (EXIT_FAILURE);
+	  _exit (EXIT_SUCCESS);
+	}
+    }
+
+  for (i = 0; i < jobs; i++)
+    {
+      int status;
+      if (waitpid (pids[i], &status, 0) < 0
+	  || !WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS)
+	failed = true;
+    }
+  if (failed)
+    fatal ("a parallel job failed", (char *)NULL);
+
+  /* The files without tags were written last, starting with the last
+     file processed; keep that order across the children too.  */
+  for (j = 0; j < 2; j++)
+    for (i = 0; i < jobs; i++)
+      copy_to_tagf (parts[i][j]);
+  for (i = jobs - 1; i >= 0; i--)
+    copy_to_tagf (parts[i][2]);
+
+  free (parts);
+  free (pids);
+  return true;
+}
+
+#endif /* !DOS_NT */
+
+
+/*
+ * Updating an etags tag file.  A tag file is a sequence of sections,
+ * each "\f\nFILE,SIZE\n" followed by SIZE bytes of tags for FILE, or
+ * "\f\nFILE,include\n".  An update keeps the sections of the old tag
+ * file in their order, replacing those of the files parsed again, and
+ * adds the sections of new files at the end.
+ */
+
+typedef struct
+{
+  char *name;			/* the file name in the section header */
+  bool include;			/* this is an include section */
+  char *start, *end;		/* the section, including its header */
+  bool used;			/* already written by the update */
+} tags_section;
+
+static char *old_tags;		/* contents of the old tag file */
+static tags_section *old_sections; /* its sections */
+static ptrdiff_t old_nsections;
+static time_t old_tags_mtime;	/* when the old tag file was written */
+
+/* Read FP, of SIZE bytes, into memory and return its contents.  */
+static char *
+read_whole_file (FILE *fp, ptrdiff_t size, const char *name)
+{
+  char *buf = xnew (size + 1, char);
+  if (fread (buf, 1, size, fp) != size)
+    pfatal (name);
+  buf[size] = '\0';
+  return buf;
+}
+
+/* Split BUF, the SIZE bytes of a tag file, into sections.  Return a
+   vector of them, and store their number in *COUNT.  */
+static tags_section *
+parse_tags_sections (char *buf, ptrdiff_t size, ptrdiff_t *count)
+{
+  tags_section *sections = NULL;
+  ptrdiff_t n = 0, allocated = 0;
+  char *p = buf, *end = buf + size;
+
+  while (p < end)
+    {
+      char *header, *eol, *comma;
+      tags_section *sp;
+
+      if (end - p < 2 || p[0] != '\f' || p[1] != '\n'
+	  || (eol = memchr (p + 2, '\n', end - p - 2)) == NULL)
+	fatal ("%s is not a valid tag file", tagfile);
+      header = p + 2;
+      for (comma = eol; comma > header && comma[-1] != ','; comma--)
+	continue;
+      if (comma == header)
+	fatal ("%s is not a valid tag file", tagfile);
+
+      if (n == allocated)
+	{
+	  allocated = allocated ? 2 * allocated : 256;
+	  xrnew (sections, allocated, tags_section);
+	}
+      sp = &sections[n++];
+      sp->name = savenstr (header, comma - 1 - header);
+      sp->include = strneq (comma, "include\n", sizeof "include");
+      sp->start = p;
+      sp->used = false;
+      if (sp->include)
+	sp->end = eol + 1;
+      else
+	{
+	  char *digits_end;
+	  long body = strtol (comma, &digits_end, 10);
+	  if (digits_end != eol || body < 0 || body > end - (eol + 1))
+	    fatal ("%s is not a valid tag file", tagfile);
+	  sp->end = eol + 1 + body;
+	}
+      p = sp->end;
+    }
+  *count = n;
+  return sections;
+}
+
+static int
+compare_sections (const void *a, const void *b)
+{
+  tags_section *const *pa = a;
+  tags_section *const *pb = b;
+  int cmp = strcmp ((*pa)->name, (*pb)->name);
+  return cmp ? cmp : (*pa)->include - (*pb)->include;
+}
+
+/* Return a vector of pointers to the N SECTIONS, sorted by name.  */
+static tags_section **
+sort_sections (tags_section *sections, ptrdiff_t n)
+{
+  tags_section **sorted = xnew (n + 1, tags_section *);
+  ptrdiff_t i;
+
+  for (i = 0; i < n; i++)
+    sorted[i] = &sections[i];
+  qsort (sorted, n, sizeof *sorted, compare_sections);
+  return sorted;
+}
+
+/* Return the section for NAME in SORTED, of N sections, or NULL.  */
+static tags_section *
+find_section (tags_section **sorted, ptrdiff_t n, char *name, bool include)
+{
+  tags_section key, *keyp = &key, **found;
+
+  key.name = name;
+  key.include = include;
+  found = bsearch (&keyp, sorted, n, sizeof *sorted, compare_sections);
+  return found ? *found : NULL;
+}
+
+/* Read the tag file to update.  Return false if there is none.  */
+static bool
+read_old_tags (void)
+{
+  struct stat st;
+  FILE *fp = fopen (tagfile, "r");
+
+  if (fp == NULL)
+    return false;
+  if (fstat (fileno (fp), &st) != 0)
+    pfatal (tagfile);
+  old_tags = read_whole_file (fp, st.st_size, tagfile);
+  fclose (fp);
+  old_tags_mtime = st.st_mtime;
+  old_sections = parse_tags_sections (old_tags, st.st_size, &old_nsections);
+  return true;
+}
+
+/* Drop from the NARGS arguments in ARGBUFFER the files that have a
+   section in the old tag file and were not modified since it was
+   written.  */
+static void
+skip_unchanged_files (argument *argbuffer, int nargs)
+{
+  tags_section **sorted = sort_sections (old_sections, old_nsections);
+  int i;
+
+  for (i = 0; i < nargs; i++)
+    {
+      char *file = argbuffer[i].what, *name, *ext;
+      struct stat st;
+
+      if (argbuffer[i].arg_type != at_filename || streq (file, "-"))
+	continue;
+      canonicalize_filename (file);
+      if (stat (file, &st) != 0 || st.st_mtime >= old_tags_mtime)
+	continue;
+      name = (get_compressor_from_suffix (file, &ext) == NULL
+	      ? savestr (file) : savenstr (file, ext - file));
+      if (filename_is_absolute (name))
+	ext = absolute_filename (name, NULL);
+      else
+	ext = relative_filename (name, tagfiledir);
+      if (find_section (sorted, old_nsections, ext, false))
+	argbuffer[i].what = NULL;
+      free (ext);
+      free (name);
+    }
+  free (sorted);
+}
+
+/* Write to FP those of the N SECTIONS that are not yet used, skipping
+   the include sections unless INCLUDES.  */
+static void
+write_unused_sections (FILE *fp, tags_section *sections, ptrdiff_t n,
+		       bool includes)
+{
+  ptrdiff_t i;
+
+  for (i = 0; i < n; i++)
+    if (!sections[i].used && (includes || !sections[i].include))
+      {
+	fwrite (sections[i].start, 1, sections[i].end - sections[i].start, fp);
+	sections[i].used = true;
+      }
+}
+
+/* Write the tag file, merging the old tags with the new ones in the
+   temporary file tagf.  */
+static void
+write_updated_tags (void)
+{
+  tags_section *new_sections, **sorted, *sp;
+  ptrdiff_t size, new_nsections, i, tail;
+  char *new_tags;
+  FILE *fp;
+
+  size = ftell (tagf);
+  rewind (tagf);
+  new_tags = read_whole_file (tagf, size, "temporary file");
+  fclose (tagf);
+  new_sections = parse_tags_sections (new_tags, size, &new_nsections);
+  sorted = sort_sections (new_sections, new_nsections);
+
+  /* The files new to the tag file go before the include sections at
+     its end, as they would in a new tag file.  */
+  for (tail = old_nsections;
+       tail > 0 && old_sections[tail - 1].include;
+       tail--)
+    continue;
+
+  fp = fopen (tagfile, "w");
+  if (fp == NULL)
+    pfatal (tagfile);
+  for (i = 0; i < old_nsections; i++)
+    {
+      if (i == tail)
+	write_unused_sections (fp, new_sections, new_nsections, false);
+      sp = find_section (sorted, new_nsections,
+			 old_sections[i].name, old_sections[i].include);
+      if (sp == NULL || sp->used)
+	sp = &old_sections[i];
+      else
+	sp->used = true;
+      fwrite (sp->start, 1, sp->end - sp->start, fp);
+    }
+  write_unused_sections (fp, new_sections, new_nsections, true);
+  if (fclose (fp) == EOF)
+    pfatal (tagfile);
+
+  free (sorted);
+  free (new_sections);
+  free (new_tags);
+}
+
+
+/*
+ * The index of a tag file, written by --index, has a line for each
+ * tag, "FOLDED\177NAME\177OFFSET\n": NAME is the tag name, explicit or
+ * implicit, FOLDED is NAME in lower case, and OFFSET is the byte
+ * offset of the tag line in the tag file.  The lines are sorted by
+ * FOLDED, then OFFSET, so etags.el can find all the tags for a name
+ * by bisecting the index.
+ */
+
+typedef struct
+{
+  char *name;			/* the tag name, in the tag file */
+  int namelen;
+  long offset;			/* where its tag line starts */
+} index_entry;
+
+static int
+compare_index_entries (const void *a, const void *b)
+{
+  const index_entry *ea = a, *eb = b;
+  int i, len = ea->namelen < eb->namelen ? ea->namelen : eb->namelen;
+
+  for (i = 0; i < len; i++)
+    {
+      int ca = lowcase (ea->name[i]), cb = lowcase (eb->name[i]);
+      if (ca != cb)
+	return ca - cb;
+    }
+  if (ea->namelen != eb->namelen)
+    return ea->namelen - eb->namelen;
+  return (ea->offset > eb->offset) - (ea->offset < eb->offset);
+}
+
+/* Write the index of the tag file just written.  */
+static void
+write_tags_index (void)
+{
+  char *tags, *p, *end, *index_name;
+  index_entry *entries = NULL;
+  ptrdiff_t n = 0, allocated = 0, i;
+  struct stat st;
+  FILE *fp;
+
+  fp = fopen (tagfile, "r");
+  if (fp == NULL || fstat (fileno (fp), &st) != 0)
+    pfatal (tagfile);
+  tags = read_whole_file (fp, st.st_size, tagfile);
+  fclose (fp);
+
+  for (p = tags, end = tags + st.st_size; p < end; )
+    {
+      char *eol = memchr (p, '\n', end - p), *del, *name, *name_end;
+
+      if (eol == NULL)
+	eol = end;
+      del = memchr (p, '\177', eol - p);
+      if (del != NULL && p[0] != '\f')
+	{
+	  name_end = memchr (del, '\001', eol - del);
+	  if (name_end != NULL)
+	    name = del + 1;	/* an explicit tag name */
+	  else
+	    {
+	      /* An implicit tag name: see make_tag.  */
+	      name_end = del;
+	      if (name_end > p && notinname (name_end[-1]))
+		name_end--;
+	      for (name = name_end; name > p && !notinname (name[-1]); name--)
+		continue;
+	    }
+	  if (name < name_end)
+	    {
+	      if (n == allocated)
+		{
+		  allocated = allocated ? 2 * allocated : 1024;
+		  xrnew (entries, allocated, index_entry);
+		}
+	      entries[n].name = name;
+	      entries[n].namelen = name_end - name;
+	      entries[n].offset = p - tags;
+	      n++;
+	    }
+	}
+      p = eol + 1;
+    }
+  qsort (entries, n, sizeof *entries, compare_index_entries);
+
+  index_name = concat (tagfile, ".idx", "");
+  fp = fopen (index_name, "w");
+  if (fp == NULL)
+    pfatal (index_name);
+  for (i = 0; i < n; i++)
+    {
+      int j;
+      for (j = 0; j < entries[i].namelen; j++)
+	putc (lowcase (entries[i].name[j]), fp);
+      putc ('\177', fp);
+      fwrite (entries[i].name, 1, entries[i].namelen, fp);
+      fprintf (fp, "\177%ld\n", entries[i].offset);
+    }
+  if (fclose (fp) == EOF)
+    pfatal (index_name);
+
+  free (index_name);
+  free (entries);
+  free (tags);
+}
+
+
 /*
  * Return a compressor given the file name.  If EXTPTR is non-zero,
  * return a pointer into FILE where the compressor-specific
@@ -0,0 +1,222 @@
+/* Compile the charset maps of Emacs into binary images.
+   Copyright (C) 2014 Free Software Foundation, Inc.
+
+This file is part of GNU Emacs.
+
+GNU Emacs is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GNU Emacs is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
+
+
+/* Usage: make-charset-map [-d DIR] FILE.map...
+
+   For each text map FILE.map, write DIR/FILE.cmap (DIR defaults to
+   the directory of FILE.map), an image that Emacs maps into memory
+   instead of parsing the text map.  An image that is newer than its
+   text map is left alone.
+
+   An image is a header of the 8 bytes "\177ECMAP1\n", the 32-bit
+   number 0x01020304 and the 32-bit number of entries, followed by the
+   entries, each the 32-bit numbers FROM, TO and C.  All numbers are in
+   the byte order of the machine.  Keep this in sync with
+   load_charset_map_from_image in src/charset.c.  */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define IMAGE_MAGIC "\177ECMAP1\n"
+#define IMAGE_BYTE_ORDER 0x01020304
+
+static char *progname;
+
+static _Noreturn void
+fatal (const char *message, const char *arg)
+{
+  fprintf (stderr, "%s: ", progname);
+  fprintf (stderr, message, arg);
+  putc ('\n', stderr);
+  exit (EXIT_FAILURE);
+}
+
+static void *
+xrealloc (void *ptr, size_t size)
+{
+  void *result = realloc (ptr, size);
+  if (!result)
+    fatal ("virtual memory exhausted", 0);
+  return result;
+}
+
+/* Read a hexadecimal number of the form "0xHHHH" from FP, skipping
+   comments, as read_hex in src/charset.c does.  */
+
+static unsigned
+read_hex (FILE *fp, bool *eof, bool *overflow)
+{
+  int c;
+  unsigned n;
+
+  while ((c = getc (fp)) != EOF)
+    {
+      if (c == '#')
+	{
+	  while ((c = getc (fp)) != EOF && c != '\n');
+	}
+      else if (c == '0')
+	{
+	  if ((c = getc (fp)) == EOF || c == 'x')
+	    break;
+	}
+    }
+  if (c == EOF)
+    {
+      *eof = 1;
+      return 0;
+    }
+  n = 0;
+  while (((c = getc (fp)) >= '0' && c <= '9')
+	 || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))
+    {
+      if (UINT_MAX >> 4 < n)
+	*overflow = 1;
+      n = ((n << 4)
+	   | (c - ('0' <= c && c <= '9' ? '0'
+		   : 'A' <= c && c <= 'F' ? 'A' - 10
+		   : 'a' - 10)));
+    }
+  if (c != EOF)
+    ungetc (c, fp);
+  return n;
+}
+
+/* Write the image of the text map FILE into DIR, or beside FILE if
+   DIR is null.  */
+
+static void
+compile_map (const char *file, const char *dir)
+{
+  const char *base = strrchr (file, '/');
+  size_t dirlen, baselen;
+  char *image, *temp;
+  struct stat map_st, image_st;
+  uint32_t *entries = NULL, header[2];
+  size_t n = 0, alloc = 0;
+  FILE *fp;
+
+  base = base ? base + 1 : file;
+  baselen = strlen (base);
+  if (baselen > 4 && !strcmp (base + baselen - 4, ".map"))
+    baselen -= 4;
+  if (!dir)
+    {
+      dir = file;
+      dirlen = base == file ? 0 : base - file - 1;
+    }
+  else
+    dirlen = strlen (dir);
+  image = xrealloc (NULL, dirlen + baselen + sizeof "/.cmap");
+  sprintf (image, "%.*s%s%.*s.cmap", (int) dirlen, dir,
+	   dirlen ? "/" : "", (int) baselen, base);
+
+  if (stat (file, &map_st) != 0)
+    fatal ("cannot stat %s", file);
+  if (stat (image, &image_st) == 0 && image_st.st_mtime > map_st.st_mtime)
+    {
+      free (image);
+      return;
+    }
+
+  fp = fopen (file, "r");
+  if (!fp)
+    fatal ("cannot open %s", file);
+  while (1)
+    {
+      unsigned from, to, c;
+      bool eof = 0, overflow = 0;
+
+      from = read_hex (fp, &eof, &overflow);
+      if (eof)
+	break;
+      if (getc (fp) == '-')
+	to = read_hex (fp, &eof, &overflow);
+      else
+	to = from;
+      if (eof)
+	break;
+      c = read_hex (fp, &eof, &overflow);
+      if (eof)
+	break;
+      if (overflow)
+	continue;
+
+      if (n == alloc)
+	{
+	  alloc = alloc ? 2 * alloc : 0x1000;
+	  entries = xrealloc (entries, alloc * 3 * sizeof *entries);
+	}
+      entries[3 * n] = from;
+      entries[3 * n + 1] = to;
+      entries[3 * n + 2] = c;
+      n++;
+    }
+  fclose (fp);
+
+  /* Write a temporary file and rename it, so that a running Emacs
+     never maps a partial image.  */
+  temp = xrealloc (NULL, strlen (image) + sizeof ".tmp");
+  sprintf (temp, "%s.tmp", image);
+  fp = fopen (temp, "wb");
+  if (!fp)
+    fatal ("cannot create %s", temp);
+  header[0] = IMAGE_BYTE_ORDER;
+  header[1] = n;
+  if (fwrite (IMAGE_MAGIC, 1, 8, fp) != 8
+      || fwrite (header, sizeof *header, 2, fp) != 2
+      || fwrite (entries, 3 * sizeof *entries, n, fp) != n
+      || fclose (fp) != 0)
+    fatal ("cannot write %s", temp);
+  if (rename (temp, image) != 0)
+    fatal ("cannot rename to %s", image);
+
+  free (temp);
+  free (image);
+  free (entries);
+}
+
+int
+main (int argc, char **argv)
+{
+  const char *dir = NULL;
+  int i = 1;
+
+  progname = argv[0];
+  if (i + 1 < argc && !strcmp (argv[i], "-d"))
+    {
+      dir = argv[i + 1];
+      i += 2;
+    }
+  if (i == argc)
+    {
+      fprintf (stderr, "Usage: %s [-d DIR] FILE.map...\n", progname);
+      return EXIT_FAILURE;
+    }
+  for (; i < argc; i++)
+    compile_map (argv[i], dir);
+  return EXIT_SUCCESS;
+}
@@ -190,6 +190,14 @@ in shell buffers.  You set this variable by calling one of:
 This function should accept three arguments: BEG, END, and FACE,
 and it should apply face FACE to the text between BEG and END.")
 
+(defvar ansi-color-face-properties nil
+  "Text properties to set to the faces of SGR control sequences.
+If non-nil, this is a list of text property names, and
+`ansi-color-apply-on-region' sets each of them to the face of the
+text, all at once, instead of calling `ansi-color-apply-face-function'.
+For example, the value (font-lock-face) works like a face function
+that calls `put-text-property', but is much faster on long output.")
+
 ;;;###autoload
 (defun ansi-color-for-comint-mode-on ()
   "Set `ansi-color-for-comint-mode' to t."
@@ -253,24 +261,60 @@ will be used for the next call to `ansi-color-apply'.  Set
 `ansi-color-context' to nil if you don't want this.
 
 This function can be added to `comint-preoutput-filter-functions'."
-  (let ((start 0) end result)
-    ;; if context was saved and is a string, prepend it
-    (if (cadr ansi-color-context)
-        (setq string (concat (cadr ansi-color-context) string)
-              ansi-color-context nil))
-    ;; find the next escape sequence
-    (while (setq end (string-match ansi-color-regexp string start))
-      (setq result (concat result (substring string start end))
-	    start (match-end 0)))
-    ;; save context, add the remainder of the string to the result
-    (let (fragment)
-      (if (string-match "\033" string start)
-	  (let ((pos (match-beginning 0)))
-	    (setq fragment (substring string pos)
-		  result (concat result (substring string start pos))))
-	(setq result (concat result (substring string start))))
-      (setq ansi-color-context (if fragment (list nil fragment))))
-    result))
+  (let ((scan (ansi-color--scan-string string ansi-color-context nil)))
+    (setq ansi-color-context (if (nth 2 scan) (list nil (nth 2 scan))))
+    (car scan)))
+
+(defun ansi-color--scan-string (string context faces)
+  "Remove the ANSI control sequences from STRING.
+CONTEXT is the value `ansi-color-context' had before STRING.  If
+FACES is non-nil, give the text the faces of the SGR control sequences
+as `font-lock-face' properties.  Return (RESULT CODES FRAGMENT), where
+RESULT is the text left and the others are the new context."
+  (let ((codes (car context)))
+    ;; If context was saved and is a string, prepend it.
+    (when (cadr context)
+      (setq string (concat (cadr context) string)))
+    (if (not (string-match-p "\033" string))
+        (progn
+          (when (and faces codes)
+            (put-text-property 0 (length string)
+                               'font-lock-face (ansi-color--find-face codes)
+                               string))
+          (list string codes nil))
+      (let ((multibyte (multibyte-string-p string))
+            fragment)
+        (with-temp-buffer
+          (set-buffer-multibyte multibyte)
+          (insert string)
+          (let ((scan (ansi-color-scan-region (point-min) (point-max) codes)))
+            (when faces
+              (ansi-color--apply-runs (car scan) '(font-lock-face)))
+            (setq codes (nth 1 scan))
+            (when (nth 2 scan)
+              (setq fragment (buffer-substring (nth 2 scan) (point-max)))
+              (delete-region (nth 2 scan) (point-max)))
+            (list (buffer-string) codes fragment)))))))
+
+(defun ansi-color--apply-runs (runs properties)
+  "Give the text of RUNS the faces of their codes.
+RUNS is a vector as returned by `ansi-color-scan-region'.  If
+PROPERTIES is non-nil, set each of these text properties to the face
+of each run; otherwise call `ansi-color-apply-face-function'."
+  (let (ranges)
+    (dotimes (i (length runs))
+      (let* ((run (aref runs i))
+             (face (ansi-color--find-face (nth 2 run))))
+        (cond ((null properties)
+               (funcall ansi-color-apply-face-function
+                        (nth 0 run) (nth 1 run) face))
+              (face
+               (let (plist)
+                 (dolist (prop properties)
+                   (setq plist (cons prop (cons face plist))))
+                 (push (list (nth 0 run) (nth 1 run) plist) ranges))))))
+    (when ranges
+      (add-text-properties-ranges (vconcat (nreverse ranges))))))
 
 (defun ansi-color--find-face (codes)
   "Return the face corresponding to CODES."
@@ -301,41 +345,10 @@ This information will be used for the next call to `ansi-color-apply'.
 Set `ansi-color-context' to nil if you don't want this.
 
 This function can be added to `comint-preoutput-filter-functions'."
-  (let ((codes (car ansi-color-context))
-	(start 0) end escape-sequence result
-	colorized-substring)
-    ;; If context was saved and is a string, prepend it.
-    (if (cadr ansi-color-context)
-        (setq string (concat (cadr ansi-color-context) string)
-              ansi-color-context nil))
-    ;; Find the next escape sequence.
-    (while (setq end (string-match ansi-color-regexp string start))
-      (setq escape-sequence (match-string 1 string))
-      ;; Colorize the old block from start to end using old face.
-      (when codes
-	(put-text-property start end 'font-lock-face (ansi-color--find-face codes) string))
-      (setq colorized-substring (substring string start end)
-	    start (match-end 0))
-      ;; Eliminate unrecognized ANSI sequences.
-      (while (string-match ansi-color-drop-regexp colorized-substring)
-	(setq colorized-substring
-	      (replace-match "" nil nil colorized-substring)))
-      (push colorized-substring result)
-      ;; Create new face, by applying escape sequence parameters.
-      (setq codes (ansi-color-apply-sequence escape-sequence codes)))
-    ;; if the rest of the string should have a face, put it there
-    (when codes
-      (put-text-property start (length string)
-                         'font-lock-face (ansi-color--find-face codes) string))
-    ;; save context, add the remainder of the string to the result
-    (let (fragment)
-      (if (string-match "\033" string start)
-	  (let ((pos (match-beginning 0)))
-	    (setq fragment (substring string pos))
-	    (push (substring string start pos) result))
-	(push (substring string start) result))
-      (setq ansi-color-context (if (or codes fragment) (list codes fragment))))
-    (apply 'concat (nreverse result))))
+  (let ((scan (ansi-color--scan-string string ansi-color-context t)))
+    (setq ansi-color-context (if (or (nth 1 scan) (nth 2 scan))
+                                 (cdr scan)))
+    (car scan)))
 
 ;; Working with regions
 
@@ -355,28 +368,18 @@ Every call to this function will set and use the buffer-local variable
 used for the next call to `ansi-color-apply-on-region'.  Specifically,
 it will override BEGIN, the start of the region.  Set
 `ansi-color-context-region' to nil if you don't want this."
-  (let ((end-marker (copy-marker end))
-	(start (or (cadr ansi-color-context-region) begin)))
-    (save-excursion
-      (goto-char start)
-      ;; Delete unrecognized escape sequences.
-      (while (re-search-forward ansi-color-drop-regexp end-marker t)
-        (replace-match ""))
-      (goto-char start)
-      ;; Delete SGR escape sequences.
-      (while (re-search-forward ansi-color-regexp end-marker t)
-        (replace-match ""))
-      ;; save context, add the remainder of the string to the result
-      (if (re-search-forward "\033" end-marker t)
-	  (setq ansi-color-context-region (list nil (match-beginning 0)))
-	(setq ansi-color-context-region nil)))))
+  (let* ((start (or (cadr ansi-color-context-region) begin))
+	 (fragment (nth 2 (ansi-color-scan-region start end nil))))
+    (setq ansi-color-context-region
+	  (if fragment (list nil (copy-marker fragment))))))
 
 (defun ansi-color-apply-on-region (begin end)
   "Translates SGR control sequences into overlays or extents.
 Delete all other control sequences without processing them.
 
 SGR control sequences are applied by calling the function
-specified by `ansi-color-apply-face-function'.  The default
+specified by `ansi-color-apply-face-function', or by setting the
+text properties in `ansi-color-face-properties'.  The default
 function sets foreground and background colors to the text
 between BEGIN and END, using overlays.  The colors used are given
 in `ansi-color-faces-vector' and `ansi-color-names-vector'.  See
@@ -389,44 +392,17 @@ ansi codes.  This information will be used for the next call to
 BEGIN, the start of the region and set the face with which to
 start.  Set `ansi-color-context-region' to nil if you don't want
 this."
-  (let ((codes (car ansi-color-context-region))
-	(start-marker (or (cadr ansi-color-context-region)
-			  (copy-marker begin)))
-	(end-marker (copy-marker end))
-	escape-sequence)
-    ;; First, eliminate unrecognized ANSI control sequences.
-    (save-excursion
-      (goto-char start-marker)
-      (while (re-search-forward ansi-color-drop-regexp end-marker t)
-	(replace-match "")))
-    (save-excursion
-      (goto-char start-marker)
-      ;; Find the next SGR sequence.
-      (while (re-search-forward ansi-color-regexp end-marker t)
-	;; Colorize the old block from start to end using old face.
-	(funcall ansi-color-apply-face-function
-		 start-marker (match-beginning 0)
-		 (ansi-color--find-face codes))
-        ;; store escape sequence and new start position
-        (setq escape-sequence (match-string 1)
-	      start-marker (copy-marker (match-end 0)))
-	;; delete the escape sequence
-	(replace-match "")
-	;; Update the list of ansi codes.
-	(setq codes (ansi-color-apply-sequence escape-sequence codes)))
-      ;; search for the possible start of a new escape sequence
-      (if (re-search-forward "\033" end-marker t)
-	  (progn
-	    ;; if the rest of the region should have a face, put it there
-	    (funcall ansi-color-apply-face-function
-		     start-marker (point) (ansi-color--find-face codes))
-	    ;; save codes and point
-	    (setq ansi-color-context-region
-		  (list codes (copy-marker (match-beginning 0)))))
-	;; if the rest of the region should have a face, put it there
-	(funcall ansi-color-apply-face-function
-		 start-marker end-marker (ansi-color--find-face codes))
-	(setq ansi-color-context-region (if codes (list codes)))))))
+  (let* ((start (or (cadr ansi-color-context-region) begin))
+	 ;; Delete the control sequences, and find the codes in effect
+	 ;; in each stretch of the text that is left.
+	 (scan (ansi-color-scan-region start end
+				       (car ansi-color-context-region)))
+	 (codes (nth 1 scan))
+	 (fragment (nth 2 scan)))
+    (ansi-color--apply-runs (car scan) ansi-color-face-properties)
+    (setq ansi-color-context-region
+	  (cond (fragment (list codes (copy-marker fragment)))
+		(codes (list codes))))))
 
 (defun ansi-color-apply-overlay-face (beg end face)
   "Make an overlay from BEG to END, and apply face FACE.
@@ -311,6 +311,10 @@ the list of old buffers.")
 (defvar auto-revert-remaining-buffers ()
   "Buffers not checked when user input stopped execution.")
 
+(defvar auto-revert--stale-buffers t
+  "Buffers that `auto-revert-buffers' found visiting changed files.
+The value t means that no such check is in progress.")
+
 (defvar auto-revert-tail-pos 0
   "Position of last known end of file.")
 
@@ -579,6 +583,18 @@ will use an up-to-date value of `auto-revert-interval'"
        (not (memq major-mode
 		  global-auto-revert-ignore-modes)))))
 
+(defun auto-revert--buffer-stale-p ()
+  "Return non-nil if the current buffer visits a changed file.
+Use the check made by `auto-revert-buffers' for local files when
+`buffer-stale-function' has its default value."
+  (if (and (listp auto-revert--stale-buffers)
+	   (eq buffer-stale-function #'buffer-stale--default-function)
+	   (not (find-file-name-handler buffer-file-name
+					'verify-visited-file-modtime)))
+      (memq (current-buffer) auto-revert--stale-buffers)
+    (funcall (or buffer-stale-function #'buffer-stale--default-function)
+	     t)))
+
 (defun auto-revert-handler ()
   "Revert current buffer, if appropriate.
 This is an internal function used by Auto-Revert Mode."
@@ -600,9 +616,7 @@ This is an internal function used by Auto-Revert Mode."
 				  (setq size
 					(nth 7 (file-attributes
 						buffer-file-name)))))
-		       (funcall (or buffer-stale-function
-                                    #'buffer-stale--default-function)
-                                t)))
+		       (auto-revert--buffer-stale-p)))
 		(and (or auto-revert-mode
 			 global-auto-revert-non-file-buffers)
 		     (funcall (or buffer-stale-function
@@ -703,29 +717,31 @@ the timer when no buffers need to be checked."
 	(if (not (memq buf remaining))
 	    (push buf new)))
       (setq bufs (nreverse (nconc new remaining)))
-      (while (and bufs
-		  (not (and auto-revert-stop-on-user-input
-			    (input-pending-p))))
-	(let ((buf (car bufs)))
-          (if (buffer-live-p buf)
-	      (with-current-buffer buf
-		;; Test if someone has turned off Auto-Revert Mode in a
-		;; non-standard way, for example by changing major mode.
-		(if (and (not auto-revert-mode)
-			 (not auto-revert-tail-mode)
-			 (memq buf auto-revert-buffer-list))
-		    (setq auto-revert-buffer-list
-			  (delq buf auto-revert-buffer-list)))
-		(when (auto-revert-active-p)
-		  ;; Enable file notification.
-		  (when (and auto-revert-use-notify buffer-file-name
-			     (not auto-revert-notify-watch-descriptor))
-		    (auto-revert-notify-add-watch))
-		  (auto-revert-handler)))
-	    ;; Remove dead buffer from `auto-revert-buffer-list'.
-	    (setq auto-revert-buffer-list
-		  (delq buf auto-revert-buffer-list))))
-	(setq bufs (cdr bufs)))
+      ;; Stat all the visited local files in one go.
+      (let ((auto-revert--stale-buffers (stale-file-buffers bufs)))
+	(while (and bufs
+		    (not (and auto-revert-stop-on-user-input
+			      (input-pending-p))))
+	  (let ((buf (car bufs)))
+	    (if (buffer-live-p buf)
+		(with-current-buffer buf
+		  ;; Test if someone has turned off Auto-Revert Mode in a
+		  ;; non-standard way, for example by changing major mode.
+		  (if (and (not auto-revert-mode)
+			   (not auto-revert-tail-mode)
+			   (memq buf auto-revert-buffer-list))
+		      (setq auto-revert-buffer-list
+			    (delq buf auto-revert-buffer-list)))
+		  (when (auto-revert-active-p)
+		    ;; Enable file notification.
+		    (when (and auto-revert-use-notify buffer-file-name
+			       (not auto-revert-notify-watch-descriptor))
+		      (auto-revert-notify-add-watch))
+		    (auto-revert-handler)))
+	      ;; Remove dead buffer from `auto-revert-buffer-list'.
+	      (setq auto-revert-buffer-list
+		    (delq buf auto-revert-buffer-list))))
+	  (setq bufs (cdr bufs))))
       (setq auto-revert-remaining-buffers bufs)
       ;; Check if we should cancel the timer.
       (when (and (not global-auto-revert-mode)
@@ -3181,6 +3181,12 @@ largest Emacs integer.")
 
 ;;; Multiply digit lists A and B.  [L L L; l l l]
 (defun math-mul-bignum (a b)
+  (if (fboundp 'digits-multiply)
+      (and a b
+	   (or (digits-multiply a b math-bignum-digit-size) (list 0)))
+    (math-mul-bignum-lisp a b)))
+
+(defun math-mul-bignum-lisp (a b)
   (and a b
        (let* ((sum (if (<= (car b) 1)
 		       (if (= (car b) 0)
@@ -3258,19 +3264,29 @@ largest Emacs integer.")
 				(car (math-div-bignum-digit (cdr a) b)))))
       (or (consp a) (setq a (math-bignum a)))
       (or (consp b) (setq b (math-bignum b)))
-      (let* ((alen (1- (length a)))
-	     (blen (1- (length b)))
-	     (d (/ math-bignum-digit-size (1+ (nth (1- blen) (cdr b)))))
-	     (res (math-div-bignum-big (math-mul-bignum-digit (cdr a) d 0)
-				       (math-mul-bignum-digit (cdr b) d 0)
-				       alen blen)))
-	(math-normalize (cons (if (eq (car a) (car b)) 'bigpos 'bigneg)
-			      (car res)))))))
+      (math-normalize
+       (cons (if (eq (car a) (car b)) 'bigpos 'bigneg)
+	     (if (fboundp 'digits-divide)
+		 (car (math-div-bignum (cdr a) (cdr b)))
+	       (let* ((alen (1- (length a)))
+		      (blen (1- (length b)))
+		      (d (/ math-bignum-digit-size (1+ (nth (1- blen) (cdr b))))))
+		 (car (math-div-bignum-big (math-mul-bignum-digit (cdr a) d 0)
+					   (math-mul-bignum-digit (cdr b) d 0)
+					   alen blen)))))))))
 
 
 ;;; Divide a bignum digit list by another.  [l.l l L]
-;;; The following division algorithm is borrowed from Knuth vol. II, sec. 4.3.1
+;;; With `digits-divide', Emacs does this with native big integers.
+;;; Otherwise, the following division algorithm is borrowed from
+;;; Knuth vol. II, sec. 4.3.1
 (defun math-div-bignum (a b)
+  (if (fboundp 'digits-divide)
+      (let ((res (digits-divide a b math-bignum-digit-size)))
+	(cons (or (car res) (list 0)) (or (cdr res) (list 0))))
+    (math-div-bignum-lisp a b)))
+
+(defun math-div-bignum-lisp (a b)
   (if (cdr b)
       (let* ((alen (length a))
 	     (blen (length b))
@@ -309,6 +309,21 @@ the function `comint-truncate-buffer' is on `comint-output-filter-functions'."
   :type 'integer
   :group 'comint)
 
+(defcustom comint-output-batch-interval nil
+  "If non-nil, the least time in seconds between insertions of output.
+Output that arrives sooner is held back, and inserted together with
+the output that follows it, so that the output filters run and the
+display is updated once for all of it.  This keeps Emacs responsive
+when a process writes a lot of output quickly.  With a value of 0,
+the output read in each pass of the command loop is inserted at once.
+
+Code that reads the output right after `accept-process-output'
+should call `comint-flush-output' first."
+  :type '(choice (const :tag "Insert output as it arrives" nil)
+		 (number :tag "Seconds"))
+  :group 'comint
+  :version "24.5")
+
 (defcustom comint-input-ring-size 500
   "Size of the input history ring in `comint-mode'."
   :type 'integer
@@ -1775,6 +1790,8 @@ Similarly for Soar, Scheme, etc."
   ;; post-command-hook.
   (when completion-in-region-mode
     (completion-in-region-mode -1))
+  ;; Let any output held back be seen before the input.
+  (comint-flush-output)
   ;; Note that the input string does not include its terminal newline.
   (let ((proc (get-buffer-process (current-buffer))))
     (if (not proc) (user-error "Current buffer has no process")
@@ -1994,95 +2011,143 @@ Make backspaces delete the previous character."
     ;; First check for killed buffer or no input.
     (when (and string oprocbuf (buffer-name oprocbuf))
       (with-current-buffer oprocbuf
-	;; Run preoutput filters
-	(let ((functions comint-preoutput-filter-functions))
-	  (while (and functions string)
-	    (if (eq (car functions) t)
-		(let ((functions
-                       (default-value 'comint-preoutput-filter-functions)))
-		  (while (and functions string)
-		    (setq string (funcall (car functions) string))
-		    (setq functions (cdr functions))))
-	      (setq string (funcall (car functions) string)))
-	    (setq functions (cdr functions))))
-
-	;; Insert STRING
-	(let ((inhibit-read-only t)
-              ;; The point should float after any insertion we do.
-	      (saved-point (copy-marker (point) t)))
-
-	  ;; We temporarily remove any buffer narrowing, in case the
-	  ;; process mark is outside of the restriction
-	  (save-restriction
-	    (widen)
-
-	    (goto-char (process-mark process))
-	    (set-marker comint-last-output-start (point))
-
-            ;; Try to skip repeated prompts, which can occur as a result of
-            ;; commands sent without inserting them in the buffer.
-            (let ((bol (save-excursion (forward-line 0) (point)))) ;No fields.
-              (when (and (not (bolp))
-                         (looking-back comint-prompt-regexp bol))
-                (let* ((prompt (buffer-substring bol (point)))
-                       (prompt-re (concat "\\`" (regexp-quote prompt))))
-                  (while (string-match prompt-re string)
-                    (setq string (substring string (match-end 0)))))))
-            (while (string-match (concat "\\(^" comint-prompt-regexp
-                                         "\\)\\1+")
-                                 string)
-              (setq string (replace-match "\\1" nil nil string)))
-
-	    ;; insert-before-markers is a bad thing. XXX
-	    ;; Luckily we don't have to use it any more, we use
-	    ;; window-point-insertion-type instead.
-	    (insert string)
-
-	    ;; Advance process-mark
-	    (set-marker (process-mark process) (point))
-
-	    (unless comint-inhibit-carriage-motion
-	      ;; Interpret any carriage motion characters (newline, backspace)
-	      (comint-carriage-motion comint-last-output-start (point)))
-
-	    ;; Run these hooks with point where the user had it.
-	    (goto-char saved-point)
-	    (run-hook-with-args 'comint-output-filter-functions string)
-	    (set-marker saved-point (point))
-
-	    (goto-char (process-mark process)) ; In case a filter moved it.
-
-	    (unless comint-use-prompt-regexp
-              (with-silent-modifications
-                (add-text-properties comint-last-output-start (point)
-                                     '(front-sticky
-				       (field inhibit-line-move-field-capture)
-				       rear-nonsticky t
-				       field output
-				       inhibit-line-move-field-capture t))))
-
-	    ;; Highlight the prompt, where we define `prompt' to mean
-	    ;; the most recent output that doesn't end with a newline.
-	    (let ((prompt-start (save-excursion (forward-line 0) (point)))
-		  (inhibit-read-only t))
-	      (when comint-prompt-read-only
-		(with-silent-modifications
-		  (or (= (point-min) prompt-start)
-		      (get-text-property (1- prompt-start) 'read-only)
-		      (put-text-property (1- prompt-start)
-					 prompt-start 'read-only 'fence))
-		  (add-text-properties prompt-start (point)
-				       '(read-only t front-sticky (read-only)))))
-	      (when comint-last-prompt
-		(remove-text-properties (car comint-last-prompt)
-					(cdr comint-last-prompt)
-					'(font-lock-face)))
-	      (setq comint-last-prompt
-		    (cons (copy-marker prompt-start) (point-marker)))
-	      (add-text-properties prompt-start (point)
-				   '(rear-nonsticky t
-				     font-lock-face comint-highlight-prompt)))
-	    (goto-char saved-point)))))))
+	(if comint-output-batch-interval
+	    (comint--queue-output process string)
+	  (comint--insert-output process string))))))
+
+(defvar-local comint--pending-output nil
+  "The output held back by `comint-output-batch-interval', last first.")
+(defvar-local comint--pending-process nil
+  "The process whose output `comint--pending-output' is.")
+(defvar-local comint--output-timer nil
+  "The timer that inserts `comint--pending-output'.")
+(defvar-local comint--last-output-flush 0
+  "The time, as a float, when held back output was last inserted.")
+
+(defun comint--queue-output (process string)
+  "Hold back STRING, output of PROCESS, until the next insertion."
+  (unless (eq process comint--pending-process)
+    (comint-flush-output))
+  (setq comint--pending-process process)
+  (push string comint--pending-output)
+  (unless comint--output-timer
+    (setq comint--output-timer
+	  (run-at-time (max 0 (- (+ comint--last-output-flush
+				    comint-output-batch-interval)
+				 (float-time)))
+		       nil #'comint--flush-output-timer (current-buffer)))))
+
+(defun comint--flush-output-timer (buffer)
+  (when (buffer-live-p buffer)
+    (with-current-buffer buffer
+      (setq comint--output-timer nil)
+      (comint-flush-output))))
+
+(defun comint-flush-output ()
+  "Insert the output held back by `comint-output-batch-interval'."
+  (when comint--output-timer
+    (cancel-timer comint--output-timer)
+    (setq comint--output-timer nil))
+  (when comint--pending-output
+    (let ((process comint--pending-process)
+	  (string (apply #'concat (nreverse comint--pending-output))))
+      (setq comint--pending-output nil
+	    comint--pending-process nil
+	    comint--last-output-flush (float-time))
+      (when (eq (process-buffer process) (current-buffer))
+	(comint--insert-output process string)))))
+
+(defun comint--insert-output (process string)
+  "Insert STRING, output of PROCESS, in the current buffer."
+  ;; Run preoutput filters
+  (let ((functions comint-preoutput-filter-functions))
+    (while (and functions string)
+      (if (eq (car functions) t)
+	  (let ((functions
+		 (default-value 'comint-preoutput-filter-functions)))
+	    (while (and functions string)
+	      (setq string (funcall (car functions) string))
+	      (setq functions (cdr functions))))
+	(setq string (funcall (car functions) string)))
+      (setq functions (cdr functions))))
+
+  ;; Insert STRING
+  (let ((inhibit-read-only t)
+	;; The point should float after any insertion we do.
+	(saved-point (copy-marker (point) t)))
+
+    ;; We temporarily remove any buffer narrowing, in case the
+    ;; process mark is outside of the restriction
+    (save-restriction
+      (widen)
+
+      (goto-char (process-mark process))
+      (set-marker comint-last-output-start (point))
+
+      ;; Try to skip repeated prompts, which can occur as a result of
+      ;; commands sent without inserting them in the buffer.
+      (let ((bol (save-excursion (forward-line 0) (point)))) ;No fields.
+	(when (and (not (bolp))
+		   (looking-back comint-prompt-regexp bol))
+	  (let* ((prompt (buffer-substring bol (point)))
+		 (prompt-re (concat "\\`" (regexp-quote prompt))))
+	    (while (string-match prompt-re string)
+	      (setq string (substring string (match-end 0)))))))
+      (while (string-match (concat "\\(^" comint-prompt-regexp
+				   "\\)\\1+")
+			   string)
+	(setq string (replace-match "\\1" nil nil string)))
+
+      ;; insert-before-markers is a bad thing. XXX
+      ;; Luckily we don't have to use it any more, we use
+      ;; window-point-insertion-type instead.
+      (insert string)
+
+      ;; Advance process-mark
+      (set-marker (process-mark process) (point))
+
+      (unless comint-inhibit-carriage-motion
+	;; Interpret any carriage motion characters (newline, backspace)
+	(comint-carriage-motion comint-last-output-start (point)))
+
+      ;; Run these hooks with point where the user had it.
+      (goto-char saved-point)
+      (run-hook-with-args 'comint-output-filter-functions string)
+      (set-marker saved-point (point))
+
+      (goto-char (process-mark process)) ; In case a filter moved it.
+
+      (unless comint-use-prompt-regexp
+	(with-silent-modifications
+	  (add-text-properties comint-last-output-start (point)
+			       '(front-sticky
+				 (field inhibit-line-move-field-capture)
+				 rear-nonsticky t
+				 field output
+				 inhibit-line-move-field-capture t))))
+
+      ;; Highlight the prompt, where we define `prompt' to mean
+      ;; the most recent output that doesn't end with a newline.
+      (let ((prompt-start (save-excursion (forward-line 0) (point)))
+	    (inhibit-read-only t))
+	(when comint-prompt-read-only
+	  (with-silent-modifications
+	    (or (= (point-min) prompt-start)
+		(get-text-property (1- prompt-start) 'read-only)
+		(put-text-property (1- prompt-start)
+				   prompt-start 'read-only 'fence))
+	    (add-text-properties prompt-start (point)
+				 '(read-only t front-sticky (read-only)))))
+	(when comint-last-prompt
+	  (remove-text-properties (car comint-last-prompt)
+				  (cdr comint-last-prompt)
+				  '(font-lock-face)))
+	(setq comint-last-prompt
+	      (cons (copy-marker prompt-start) (point-marker)))
+	(add-text-properties prompt-start (point)
+			     '(rear-nonsticky t
+			       font-lock-face comint-highlight-prompt)))
+      (goto-char saved-point))))
 
 (defun comint-preinput-scroll-to-bottom ()
   "Go to the end of buffer in all windows showing it.
@@ -2166,16 +2231,19 @@ SELECTED is the window that was originally selected."
 		  (>= (point) comint-last-output-start)))
 	 (goto-char (process-mark process)))))
 
-(defun comint-truncate-buffer (&optional _string)
+(defun comint-truncate-buffer (&optional string)
   "Truncate the buffer to `comint-buffer-maximum-size'.
-This function could be on `comint-output-filter-functions' or bound to a key."
+This function could be on `comint-output-filter-functions' or bound to a key.
+The text deleted cannot be undone, and the undo list is discarded.
+
+On `comint-output-filter-functions', where STRING is the output, the
+buffer is allowed to grow by an eighth before it is truncated, because
+deleting text from its front is expensive."
   (interactive)
-  (save-excursion
-    (goto-char (process-mark (get-buffer-process (current-buffer))))
-    (forward-line (- comint-buffer-maximum-size))
-    (beginning-of-line)
-    (let ((inhibit-read-only t))
-      (delete-region (point-min) (point)))))
+  (let ((inhibit-read-only t))
+    (delete-leading-lines comint-buffer-maximum-size
+			  (process-mark (get-buffer-process (current-buffer)))
+			  (and string (/ comint-buffer-maximum-size 8)))))
 
 (defun comint-strip-ctrl-m (&optional _string)
   "Strip trailing `^M' characters from the current output group.
@@ -451,6 +451,28 @@ If value is t, all buffers are restored immediately."
   :group 'desktop
   :version "22.1")
 
+(defcustom desktop-restore-placeholders nil
+  "Non-nil means restore lazily restored file buffers as placeholders.
+Each buffer visiting a file beyond the first `desktop-restore-eager'
+ones is then made at once, but empty: its file is read and its modes
+are set the first time it is shown in a window.  Until then it costs
+next to nothing, but it is listed like any other buffer.  Other
+buffers are restored when Emacs is idle, as usual."
+  :type 'boolean
+  :group 'desktop
+  :version "24.5")
+
+(defcustom desktop-save-serialized nil
+  "Non-nil means save the state of buffers in a compact binary form.
+Restoring such a desktop is much faster than evaluating the Lisp
+forms that are saved otherwise.  A buffer whose state cannot be
+serialized by `serialize-object' is saved as Lisp, as usual.  The
+desktop file cannot be read by Emacs versions without
+`deserialize-object'."
+  :type 'boolean
+  :group 'desktop
+  :version "24.5")
+
 (defcustom desktop-lazy-verbose t
   "Verbose reporting of lazily created buffers."
   :type 'boolean
@@ -999,24 +1021,35 @@ and don't save the buffer if they are the same."
 	     " kill-ring))\n"))
 
 	  (insert "\n;; Buffer section -- buffers listed in same order as in buffer list:\n")
-	  (dolist (l (mapcar 'desktop-buffer-info (buffer-list)))
+	  (dolist (l (mapcar (lambda (buffer)
+			       (or (desktop--placeholder-info buffer)
+				   (desktop-buffer-info buffer)))
+			     (buffer-list)))
 	    (let ((base (pop l)))
 	      (when (apply 'desktop-save-buffer-p l)
-		(insert "("
-			(if (or (not (integerp eager))
-				(if (zerop eager)
-				    nil
-				  (setq eager (1- eager))))
-			    "desktop-create-buffer"
-			  "desktop-append-buffer-args")
-			" "
-			desktop-file-version)
-		;; If there's a non-empty base name, we save it instead of the buffer name
-		(when (and base (not (string= base "")))
-		  (setcar (nthcdr 1 l) base))
-		(dolist (e l)
-		  (insert "\n  " (desktop-value-to-string e)))
-		(insert ")\n\n"))))
+		(let ((function
+		       (if (or (not (integerp eager))
+			       (if (zerop eager)
+				   nil
+				 (setq eager (1- eager))))
+			   "desktop-create-buffer"
+			 "desktop-append-buffer-args"))
+		      data)
+		  ;; If there's a non-empty base name, we save it instead of the buffer name
+		  (when (and base (not (string= base "")))
+		    (setcar (nthcdr 1 l) base))
+		  (when desktop-save-serialized
+		    (setq data (ignore-errors
+				 (serialize-object
+				  (cons (string-to-number desktop-file-version)
+					l)))))
+		  (if data
+		      (insert "(desktop-restore-serialized '" function
+			      "\n  \"" (base64-encode-string data t) "\")\n\n")
+		    (insert "(" function " " desktop-file-version)
+		    (dolist (e l)
+		      (insert "\n  " (desktop-value-to-string e)))
+		    (insert ")\n\n"))))))
 
 	  (setq default-directory desktop-dirname)
 	  ;; When auto-saving, avoid writing if nothing has changed since the last write.
@@ -1057,6 +1090,10 @@ This function also sets `desktop-dirname' to nil."
 
 (defvar desktop-lazy-timer nil)
 
+(defvar-local desktop--placeholder-args nil
+  "Arguments for `desktop-create-buffer' of this placeholder buffer.")
+(put 'desktop--placeholder-args 'permanent-local t)
+
 ;; ----------------------------------------------------------------------------
 (defun desktop-restoring-frameset-p ()
   "True if calling `desktop-restore-frameset' will actually restore it."
@@ -1436,13 +1473,76 @@ after that many seconds of idle time."
 			       (cons 'case-replace cr)
 			       (cons 'overwrite-mode (car mim)))))
 
+(defun desktop-restore-serialized (function data)
+  "Call FUNCTION with the arguments serialized in DATA.
+DATA is a base64-encoded string made by `serialize-object' from a
+list of arguments for `desktop-create-buffer'.  FUNCTION is that
+function or `desktop-append-buffer-args'."
+  (apply function (deserialize-object (base64-decode-string data))))
+
 (defun desktop-append-buffer-args (&rest args)
   "Append ARGS at end of `desktop-buffer-args-list'.
-ARGS must be an argument list for `desktop-create-buffer'."
-  (setq desktop-buffer-args-list (nconc desktop-buffer-args-list (list args)))
-  (unless desktop-lazy-timer
-    (setq desktop-lazy-timer
-          (run-with-idle-timer desktop-lazy-idle-delay t 'desktop-idle-create-buffers))))
+ARGS must be an argument list for `desktop-create-buffer'.
+If `desktop-restore-placeholders' is non-nil and ARGS are for a
+buffer visiting a file, make a placeholder buffer for them instead."
+  (unless (and desktop-restore-placeholders
+               (desktop--make-placeholder args))
+    (setq desktop-buffer-args-list (nconc desktop-buffer-args-list (list args)))
+    (unless desktop-lazy-timer
+      (setq desktop-lazy-timer
+            (run-with-idle-timer desktop-lazy-idle-delay t 'desktop-idle-create-buffers)))))
+
+(defun desktop--make-placeholder (args)
+  "Make a placeholder buffer to be restored from ARGS.
+ARGS are arguments for `desktop-create-buffer'.  Return the buffer,
+or nil if ARGS are not for a buffer visiting an existing file."
+  (let ((file (nth 1 args))
+        (name (nth 2 args)))
+    (when (and file
+               (not (assq (nth 3 args) desktop-buffer-mode-handlers))
+               (not (get-buffer name))
+               (file-exists-p file))
+      (with-current-buffer (generate-new-buffer name)
+        (setq buffer-file-name (expand-file-name file))
+        (setq default-directory (file-name-directory buffer-file-name))
+        (setq desktop--placeholder-args args)
+        (set-buffer-placeholder (current-buffer) #'desktop--materialize)
+        (current-buffer)))))
+
+(defun desktop--materialize ()
+  "Fill in the current buffer, a placeholder made by desktop.el.
+Read its file into it and restore the rest of its state."
+  (let ((args desktop--placeholder-args)
+        (file buffer-file-name))
+    (kill-local-variable 'desktop--placeholder-args)
+    (when args
+      ;; Read the file into this very buffer, which `find-file-noselect'
+      ;; then finds by its file name, so that the windows and Lisp
+      ;; objects referring to the placeholder see the restored buffer.
+      (let* ((auto-insert nil)
+             (coding-system-for-read
+              (or coding-system-for-read
+                  (cdr (assq 'buffer-file-coding-system (nth 9 args)))))
+             (truename (abbreviate-file-name (file-truename file))))
+        (find-file-noselect-1 (current-buffer) file nil nil truename
+                              (nthcdr 10 (file-attributes truename))))
+      (let ((desktop-first-buffer nil)
+            (desktop-buffer-ok-count 0)
+            (desktop-buffer-fail-count 0))
+        ;; `desktop-restore-file-buffer' switches to the buffer, but
+        ;; we are called while some window is about to display it.
+        (save-window-excursion
+          (apply #'desktop-create-buffer args))))))
+
+(defun desktop--placeholder-info (buffer)
+  "Return what `desktop-buffer-info' would, if BUFFER is a placeholder.
+This is the state BUFFER is to be restored to.  Return nil if BUFFER is
+not a placeholder made by desktop.el."
+  (let ((args (buffer-local-value 'desktop--placeholder-args buffer)))
+    (when (and args (buffer-placeholder buffer))
+      (cons nil (cons (desktop-file-name (buffer-file-name buffer)
+                                         desktop-dirname)
+                      (nthcdr 2 args))))))
 
 (defun desktop-lazy-create-buffer ()
   "Pop args from `desktop-buffer-args-list', create buffer and bury it."
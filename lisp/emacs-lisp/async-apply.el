@@ -0,0 +1,248 @@
+;;; async-apply.el --- run Lisp functions in background workers  -*- lexical-binding:t -*-
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; Maintainer: emacs-devel@gnu.org
+;; Keywords: lisp, processes
+;; Package: emacs
+
+;; This file is part of GNU Emacs.
+
+;; GNU Emacs is free software: you can redistribute it and/or modify
+;; it under the terms of the GNU General Public License as published by
+;; the Free Software Foundation, either version 3 of the License, or
+;; (at your option) any later version.
+
+;; GNU Emacs is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+
+;; You should have received a copy of the GNU General Public License
+;; along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.
+
+;;; Commentary:
+
+;; `async-apply' calls a function on a pool of worker Emacsen running
+;; in batch mode, and hands the value to a callback when it arrives,
+;; so that long computations such as indexing or parsing do not freeze
+;; the editor.  The workers stay alive between jobs, so a job costs a
+;; round trip through a pipe rather than the start of a new Emacs.
+;;
+;; The function and its arguments are printed and read back in the
+;; worker, and so is the value, so all of them must have a printed
+;; representation that can be read.  The worker shares nothing with
+;; the calling Emacs: pass the text of a buffer rather than the buffer,
+;; and name the libraries the function needs in FEATURES.
+;;
+;; Usage:
+;;
+;;   (async-apply #'my-index-files (list files)
+;;                (lambda (index) (setq my-index index))
+;;                nil '(my-indexer))
+
+;;; Code:
+
+(require 'cl-lib)
+
+(defgroup async-apply nil
+  "Running Lisp functions in background workers."
+  :group 'processes)
+
+(defcustom async-apply-pool-size 2
+  "Maximum number of worker processes `async-apply' runs at once."
+  :type 'integer
+  :version "24.5")
+
+(defcustom async-apply-program
+  (expand-file-name invocation-name invocation-directory)
+  "The Emacs executable that `async-apply' runs workers with."
+  :type 'file
+  :version "24.5")
+
+(cl-defstruct (async-apply--job (:constructor async-apply--make-job)
+                                (:copier nil))
+  id request callback error-callback
+  ;; nil while waiting, then `ok' or `error'.
+  status value)
+
+(cl-defstruct (async-apply--worker (:constructor async-apply--make-worker)
+                                   (:copier nil))
+  process
+  ;; The job being run, or nil if idle.
+  job
+  ;; Output received that does not make a whole line yet.
+  (pending ""))
+
+(defvar async-apply--workers nil
+  "The live workers.")
+
+(defvar async-apply--queue nil
+  "Jobs waiting for a worker, oldest first.")
+
+(defvar async-apply--last-id 0
+  "The id of the last job submitted.")
+
+;;; The calling side.
+
+(defun async-apply (function args &optional callback error-callback features)
+  "Call FUNCTION with ARGS in a background worker.
+Return a job object, which `async-apply-wait' accepts.
+
+When FUNCTION returns, CALLBACK is called with its value.  If it
+signals an error, ERROR-CALLBACK is called with the error object,
+which is (error \"...\") if the worker itself failed; if
+ERROR-CALLBACK is nil, the error is reported as a message.
+
+The worker is a separate Emacs, which first loads each of the
+FEATURES.  FUNCTION, ARGS and the value are printed and read back,
+so they must be readable; functions should be symbols or closures
+that refer to nothing but readable data."
+  (let ((job (async-apply--make-job
+              :id (cl-incf async-apply--last-id)
+              :callback callback
+              :error-callback error-callback)))
+    (setf (async-apply--job-request job)
+          (async-apply--print
+           (cons (async-apply--job-id job) (cons features
+                                                 (cons function args)))))
+    (setq async-apply--queue (nconc async-apply--queue (list job)))
+    (async-apply--dispatch)
+    job))
+
+(defun async-apply-wait (job &optional timeout)
+  "Wait for JOB, as returned by `async-apply', and return its value.
+If the job signaled an error, signal it again.  If TIMEOUT seconds
+pass first, return nil."
+  (let ((end (and timeout
+                  (time-add (current-time) (seconds-to-time timeout)))))
+    (while (and (null (async-apply--job-status job))
+                (or (null end) (time-less-p (current-time) end)))
+      (accept-process-output nil 0.05)))
+  (pcase (async-apply--job-status job)
+    (`ok (async-apply--job-value job))
+    (`error (signal (car (async-apply--job-value job))
+                    (cdr (async-apply--job-value job))))))
+
+(defun async-apply-shutdown ()
+  "Kill the workers of `async-apply' and cancel the waiting jobs."
+  (interactive)
+  (setq async-apply--queue nil)
+  (dolist (worker async-apply--workers)
+    (delete-process (async-apply--worker-process worker))))
+
+(defun async-apply--print (object)
+  "Return the printed representation of OBJECT as a single line."
+  (let ((print-escape-newlines t)
+        (print-length nil)
+        (print-level nil)
+        (print-circle t))
+    (prin1-to-string object)))
+
+(defun async-apply--dispatch ()
+  "Hand waiting jobs to idle workers, starting workers as allowed."
+  (let (worker)
+    (while (and async-apply--queue
+                (setq worker
+                      (or (cl-find-if-not #'async-apply--worker-job
+                                          async-apply--workers)
+                          (and (< (length async-apply--workers)
+                                  async-apply-pool-size)
+                               (async-apply--start-worker)))))
+      (let ((job (pop async-apply--queue)))
+        (setf (async-apply--worker-job worker) job)
+        (process-send-string (async-apply--worker-process worker)
+                             (concat (async-apply--job-request job) "\n"))))))
+
+(defun async-apply--start-worker ()
+  "Start a worker and return it."
+  (let* ((process-connection-type nil)
+         (process (start-process
+                   "async-apply" nil async-apply-program
+                   "-Q" "--batch"
+                   "-l" (locate-library "async-apply")
+                   "-f" "async-apply--serve"))
+         (worker (async-apply--make-worker :process process)))
+    (set-process-query-on-exit-flag process nil)
+    (set-process-coding-system process 'utf-8-emacs-unix 'utf-8-emacs-unix)
+    (process-put process 'async-apply-worker worker)
+    (set-process-filter process #'async-apply--filter)
+    (set-process-sentinel process #'async-apply--sentinel)
+    ;; The worker sees our `load-path', to find the libraries of jobs.
+    (process-send-string process (concat (async-apply--print load-path)
+                                         "\n"))
+    (push worker async-apply--workers)
+    worker))
+
+(defun async-apply--filter (process output)
+  (let* ((worker (process-get process 'async-apply-worker))
+         (text (concat (async-apply--worker-pending worker) output))
+         (start 0)
+         end)
+    (while (setq end (string-match "\n" text start))
+      (async-apply--finish worker (substring text start end))
+      (setq start (1+ end)))
+    (setf (async-apply--worker-pending worker) (substring text start))))
+
+(defun async-apply--finish (worker line)
+  "Handle LINE, a reply of WORKER to its job."
+  (let ((job (async-apply--worker-job worker))
+        (reply (condition-case err
+                   (read line)
+                 (error (list nil 'error 'error
+                              (format "Unreadable reply: %S" err))))))
+    (when job
+      (setf (async-apply--worker-job worker) nil)
+      (async-apply--complete job (nth 1 reply) (nthcdr 2 reply))
+      (async-apply--dispatch))))
+
+(defun async-apply--sentinel (process _event)
+  (unless (process-live-p process)
+    (let* ((worker (process-get process 'async-apply-worker))
+           (job (async-apply--worker-job worker)))
+      (setq async-apply--workers (delq worker async-apply--workers))
+      (when job
+        (setf (async-apply--worker-job worker) nil)
+        (async-apply--complete job 'error
+                               (list 'error "async-apply worker exited")))
+      (async-apply--dispatch))))
+
+(defun async-apply--complete (job status value)
+  "Record that JOB ended with STATUS and VALUE, and run its callback."
+  (setf (async-apply--job-status job) status
+        (async-apply--job-value job) value)
+  (if (eq status 'ok)
+      (when (async-apply--job-callback job)
+        (funcall (async-apply--job-callback job) value))
+    (if (async-apply--job-error-callback job)
+        (funcall (async-apply--job-error-callback job) value)
+      (message "async-apply job %d failed: %s"
+               (async-apply--job-id job) (error-message-string value)))))
+
+;;; The worker side.
+
+(defun async-apply--serve ()
+  "Serve `async-apply' jobs read from standard input, one per line."
+  (setq load-path (read (read-from-minibuffer "")))
+  (while t
+    (let* ((line (condition-case nil
+                     (read-from-minibuffer "")
+                   (error (kill-emacs 0))))
+           (request (read line))
+           (reply
+            (condition-case err
+                (progn
+                  (mapc #'require (nth 1 request))
+                  (let* ((value (apply (nth 2 request) (nthcdr 3 request)))
+                         (printed (async-apply--print value)))
+                    ;; Check that the caller can read the value back.
+                    (read printed)
+                    (concat "(" (number-to-string (car request)) " ok . "
+                            printed ")")))
+              (error
+               (async-apply--print (cons (car request) (cons 'error err)))))))
+      (send-string-to-terminal (concat reply "\n")))))
+
+(provide 'async-apply)
+
+;;; async-apply.el ends here
@@ -97,6 +97,107 @@ result.  The overhead of the `lambda's is accounted for."
 		`(benchmark-elapse (funcall ,code)))
 	     (- gcs-done ,gcs) (- gc-elapsed ,gc)))))
 
+(defun benchmark--percentile (sorted p)
+  "Return the P quantile, 0 < P <= 1, of the sorted list of numbers SORTED."
+  (nth (max 0 (1- (ceiling (* p (length sorted))))) sorted))
+
+(defun benchmark--bytes-allocated ()
+  "Return the number of bytes allocated since Emacs started."
+  (plist-get (gc-statistics) 'total-bytes))
+
+;;;###autoload
+(defun benchmark-call-stats (function &rest options)
+  "Time calls of FUNCTION with no arguments, and return statistics.
+FUNCTION is called a few times to warm up, and then as many times as
+it takes to know its mean time within a given precision.  A call that
+takes less than a millisecond is timed in batches of calls, so that
+the resolution of the clock does not matter.
+
+OPTIONS is a property list that can have these properties:
+  :warmup     the number of calls to make untimed first (default 3),
+  :min-runs   the least number of timings to take (default 10),
+  :max-runs   the most number of timings to take (default 1000),
+  :max-time   the seconds after which to stop timing (default 10),
+  :precision  the half-width of the 95% confidence interval of the
+              mean, relative to the mean, at which to stop (default 0.02).
+
+The value is a property list of :median, :p95, :p99, :mean, :stddev,
+:min and :max, in seconds per call, :ci95, the half-width of the 95%
+confidence interval of the mean, :runs, the number of timings taken,
+:batch, the number of calls in each, :bytes, the bytes allocated per
+call, and :gcs and :gc-elapsed, the collections per call and the time
+they took."
+  (let* ((warmup (or (plist-get options :warmup) 3))
+	 (min-runs (max 2 (or (plist-get options :min-runs) 10)))
+	 (max-runs (max min-runs (or (plist-get options :max-runs) 1000)))
+	 (max-time (or (plist-get options :max-time) 10))
+	 (precision (or (plist-get options :precision) 0.02))
+	 (batch 1)
+	 (start (float-time))
+	 (bytes 0) (gcs gcs-done) (gc gc-elapsed)
+	 times n sum sumsq mean stddev ci done)
+    ;; Warm up, and find how many calls take about a millisecond.
+    (let ((elapsed (benchmark-elapse
+		     (dotimes (_ (max 1 warmup))
+		       (funcall function)))))
+      (setq elapsed (/ elapsed (max 1 warmup)))
+      (when (< elapsed 1e-3)
+	(setq batch (ceiling (/ 1e-3 (max elapsed 1e-7))))))
+    (setq n 0 sum 0.0 sumsq 0.0
+	  gcs gcs-done gc gc-elapsed)
+    (while (not done)
+      (let* ((b0 (benchmark--bytes-allocated))
+	     (time (/ (benchmark-elapse
+			(dotimes (_ batch)
+			  (funcall function)))
+		      batch)))
+	(setq bytes (+ bytes (- (benchmark--bytes-allocated) b0))
+	      n (1+ n)
+	      sum (+ sum time)
+	      sumsq (+ sumsq (* time time)))
+	(push time times))
+      (setq mean (/ sum n)
+	    stddev (sqrt (max 0.0 (/ (- sumsq (* n mean mean)) (max 1 (1- n)))))
+	    ci (/ (* 1.96 stddev) (sqrt n))
+	    done (or (>= n max-runs)
+		     (> (- (float-time) start) max-time)
+		     (and (>= n min-runs)
+			  (<= ci (* precision mean))))))
+    (setq times (sort times #'<))
+    (let ((calls (* n batch)))
+      (list :median (benchmark--percentile times 0.5)
+	    :p95 (benchmark--percentile times 0.95)
+	    :p99 (benchmark--percentile times 0.99)
+	    :mean mean
+	    :stddev stddev
+	    :min (car times)
+	    :max (car (last times))
+	    :ci95 ci
+	    :runs n
+	    :batch batch
+	    :bytes (/ bytes (float calls))
+	    :gcs (/ (- gcs-done gcs) (float calls))
+	    :gc-elapsed (/ (- gc-elapsed gc) calls)))))
+
+;;;###autoload
+(defmacro benchmark-run-stats (&rest forms)
+  "Time FORMS repeatedly, and return statistics about the times.
+FORMS may start with keyword arguments, which are passed as OPTIONS to
+`benchmark-call-stats'; see it for them and for the value.  Unlike
+`benchmark-run', this warms up first, and takes as many timings as it
+needs to know the time reliably.  For example,
+
+  (benchmark-run-stats :max-time 5 (sort (number-sequence 1 1000) #'>))
+
+FORMS are wrapped in a `lambda', which is compiled if the code that
+uses this macro is."
+  (declare (indent 0) (debug t))
+  (let (options)
+    (while (keywordp (car forms))
+      (setq options (nconc options (list (car forms) (cadr forms)))
+	    forms (cddr forms)))
+    `(benchmark-call-stats (lambda () ,@forms) ,@options)))
+
 ;;;###autoload
 (defun benchmark (repetitions form)
   "Print the time taken for REPETITIONS executions of FORM.
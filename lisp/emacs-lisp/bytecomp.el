@@ -4655,6 +4655,117 @@ already up-to-date."
                   (prin1-to-string (cdr err)))
          nil)))))
 
+;;; Compiling with a pool of worker processes.
+
+(defvar byte-compile-parallel-jobs 4
+  "Number of worker processes used by `batch-byte-compile-parallel'.")
+
+(defvar byte-compile-worker--queue nil
+  "Files waiting to be handed to a compile worker.")
+
+(defconst byte-compile-worker--tag "\fbyte-compile-worker: "
+  "Prefix of the lines a compile worker uses to report a finished file.")
+
+(defun byte-compile-worker ()
+  "Byte-compile the files named on standard input, one per line.
+After each file, print a line saying whether it compiled; other
+output is compiler messages.  Exit at end of input.
+This is the worker side of `batch-byte-compile-parallel'."
+  (unless noninteractive
+    (error "`byte-compile-worker' is to be used only with -batch"))
+  (let (file)
+    (while (setq file (condition-case nil
+			  (read-from-minibuffer "")
+			(error nil)))
+      (unless (string= file "")
+	(let ((ok (batch-byte-compile-file file)))
+	  (princ (format "%s%s %s\n" byte-compile-worker--tag
+			 (if ok "ok" "failed") file)))))
+    (kill-emacs 0)))
+
+(defun byte-compile-worker--filter (proc string)
+  "Handle output STRING from compile worker PROC."
+  (let ((lines (split-string (concat (process-get proc 'pending) string)
+			     "\n")))
+    ;; The last element is an incomplete line, or "".
+    (process-put proc 'pending (car (last lines)))
+    (dolist (line (butlast lines))
+      (if (string-prefix-p byte-compile-worker--tag line)
+	  (let ((result (substring line (length byte-compile-worker--tag))))
+	    (unless (string-prefix-p "ok " result)
+	      (process-put proc 'failed t))
+	    (process-put proc 'busy nil)
+	    (byte-compile-worker--dispatch proc))
+	(message "%s" line)))))
+
+(defun byte-compile-worker--dispatch (proc)
+  "Hand the next queued file to idle compile worker PROC.
+Close its input if there is nothing left to compile."
+  (cond
+   ((process-get proc 'busy))
+   (byte-compile-worker--queue
+    (let ((file (pop byte-compile-worker--queue)))
+      (message "Compiling %s" file)
+      (process-put proc 'busy t)
+      (process-send-string proc (concat file "\n"))))
+   (t (process-send-eof proc))))
+
+;;;###autoload
+(defun batch-byte-compile-parallel ()
+  "Byte-compile the files remaining on the command line in parallel.
+Use this from the command line, with `-batch'; it kills Emacs when
+done, with a nonzero status if any file failed to compile.
+
+The files are handed, in command-line order, to a pool of
+`byte-compile-parallel-jobs' worker Emacs processes.  Each worker
+loads the compiler once and compiles many files, which avoids the
+cost of starting Emacs for every file.  The price is that a file is
+compiled in an environment affected by the files that the same worker
+compiled before it, so a few warnings can be missed.  Files that
+later ones need at compile time should come first on the command line."
+  (defvar command-line-args-left)	;Avoid 'free variable' warning
+  (unless noninteractive
+    (error "`batch-byte-compile-parallel' is to be used only with -batch"))
+  (let* ((byte-compile-worker--queue
+	  (mapcar #'expand-file-name command-line-args-left))
+	 (emacs (expand-file-name invocation-name invocation-directory))
+	 (process-connection-type nil)
+	 (workers
+	  (let (procs)
+	    (dotimes (i (max 1 (min byte-compile-parallel-jobs
+				    (length byte-compile-worker--queue))))
+	      (push (start-process
+		     (format "byte-compile-worker-%d" i) nil emacs
+		     "-batch" "--eval"
+		     (prin1-to-string
+		      `(setq load-path ',load-path
+			     load-prefer-newer ',load-prefer-newer
+			     max-lisp-eval-depth ,max-lisp-eval-depth
+			     max-specpdl-size ,max-specpdl-size
+			     byte-compile-root-dir
+			     ,(or byte-compile-root-dir default-directory)))
+		     "-l" "bytecomp" "-f" "byte-compile-worker")
+		    procs))
+	    procs))
+	 (error nil))
+    (setq command-line-args-left nil)
+    (dolist (proc workers)
+      (set-process-filter proc #'byte-compile-worker--filter)
+      (set-process-sentinel proc #'ignore)
+      (byte-compile-worker--dispatch proc))
+    (while (delq nil (mapcar #'process-live-p workers))
+      (accept-process-output nil 1))
+    (dolist (proc workers)
+      (when (or (process-get proc 'failed)
+		(process-get proc 'busy)
+		(not (eq (process-exit-status proc) 0)))
+	(setq error t)))
+    (when byte-compile-worker--queue
+      (message "Workers exited leaving %d files uncompiled"
+	       (length byte-compile-worker--queue))
+      (setq error t))
+    (kill-emacs (if error 1 0))))
+
 (defun byte-compile-refresh-preloaded ()
   "Reload any Lisp file that was changed since Emacs was dumped.
 Use with caution."
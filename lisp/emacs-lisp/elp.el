@@ -69,6 +69,12 @@
 ;; elp-set-master and M-x elp-unset-master to utilize this feature.
 ;; Only one master function can be set at a time.
 
+;; If elp-use-call-profiler is non-nil, elp lets the call profiler
+;; in C count and time the calls, which costs far less than the
+;; advice it otherwise wraps around each function, and also profiles
+;; primitives.  M-x elp-profile-all-calls profiles every call the
+;; call profiler can see, without instrumenting anything.
+
 ;; You can restore any function's original function definition with
 ;; elp-restore-function.  The other instrument, restore, and reset
 ;; functions are provided for symmetry.
@@ -78,6 +84,7 @@
 ;;   elp-reset-after-results
 ;;   elp-sort-by-function
 ;;   elp-report-limit
+;;   elp-use-call-profiler
 ;;
 ;; Here is a list of the interactive commands you can use:
 ;;   elp-instrument-function
@@ -91,6 +98,7 @@
 ;;   elp-reset-all
 ;;   elp-set-master
 ;;   elp-unset-master
+;;   elp-profile-all-calls
 ;;   elp-results
 
 ;; Note that there are plenty of factors that could make the times
@@ -183,6 +191,17 @@ In other words, a new unique buffer is create every time you run
   :type 'boolean
   :group 'elp)
 
+(defcustom elp-use-call-profiler nil
+  "Non-nil means count and time calls with the call profiler in C.
+Primitives are then timed where they are called, without advice, and
+other functions by a much cheaper advice than otherwise.  This only
+affects the functions instrumented afterwards.  A master function set
+by `elp-set-master' does not turn off the recording for primitives.
+See `call-profile-enable'."
+  :type 'boolean
+  :group 'elp
+  :version "24.5")
+
 
 ;; ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
 ;; end of user configuration variables
@@ -245,16 +264,25 @@ FUNSYM must be a symbol of a defined function."
     ;; been spent inside this function.  This number is added to on
     ;; function exit.
 
+    ;;
+    ;; With the call profiler, the info is kept in C instead, and the
+    ;; property is `call-profile'.
+
     ;; Put the info vector on the property list.
-    (put funsym elp-timer-info-property infovec)
+    (put funsym elp-timer-info-property
+         (if elp-use-call-profiler 'call-profile infovec))
 
-    ;; Set the symbol's new profiling function definition to run
-    ;; ELP wrapper.
-    (advice-add funsym :around (elp--make-wrapper funsym)
-                `((name . ,elp--advice-name) (depth . -99)))))
+    (if (and elp-use-call-profiler (subrp (symbol-function funsym)))
+        ;; Primitives are timed where they are dispatched.
+        (call-profile-enable (list funsym))
+      ;; Set the symbol's new profiling function definition to run
+      ;; ELP wrapper.
+      (advice-add funsym :around (elp--make-wrapper funsym)
+                  `((name . ,elp--advice-name) (depth . -99))))))
 
 (defun elp--instrumented-p (sym)
-  (advice-member-p elp--advice-name sym))
+  (or (advice-member-p elp--advice-name sym)
+      (eq (get sym elp-timer-info-property) 'call-profile)))
 
 (defun elp-restore-function (funsym)
   "Restore an instrumented function to its original definition.
@@ -269,6 +297,9 @@ Argument FUNSYM is the symbol of a defined function."
       (setq elp-master nil
             elp-record-p t))
 
+  (if (eq (get funsym elp-timer-info-property) 'call-profile)
+      (call-profile-disable (list funsym)))
+
   ;; Zap the properties.
   (put funsym elp-timer-info-property nil)
 
@@ -309,7 +340,8 @@ Use optional LIST if provided instead."
 (defun elp-restore-all ()
   "Restore the original definitions of all functions being profiled."
   (interactive)
-  (mapatoms #'elp-restore-function))
+  (mapatoms #'elp-restore-function)
+  (call-profile-disable))
 
 (defun elp-reset-function (funsym)
   "Reset the profiling information for FUNSYM."
@@ -317,10 +349,12 @@ Use optional LIST if provided instead."
   (let ((info (get funsym elp-timer-info-property)))
     (or info
 	(error "%s is not instrumented for profiling" funsym))
-    (aset info 0 0)			;reset call counter
-    (aset info 1 0.0)			;reset total time
-    ;; don't muck with aref 2 as that is the old symbol definition
-    ))
+    (if (eq info 'call-profile)
+        (call-profile-reset (list funsym))
+      (aset info 0 0)			;reset call counter
+      (aset info 1 0.0)			;reset total time
+      ;; don't muck with aref 2 as that is the old symbol definition
+      )))
 
 (defun elp-reset-list (&optional list)
   "Reset the profiling information for all functions in `elp-function-list'.
@@ -334,7 +368,17 @@ Use optional LIST if provided instead."
   (interactive)
   (mapatoms (lambda (sym)
               (if (get sym elp-timer-info-property)
-                  (elp-reset-function sym)))))
+                  (elp-reset-function sym))))
+  (call-profile-reset))
+
+;;;###autoload
+(defun elp-profile-all-calls ()
+  "Count and time every call that the call profiler in C can see.
+These are the calls of primitives, and the calls of other functions
+through `funcall' and `apply' from C.  Display the results with
+\\[elp-results], and stop with \\[elp-restore-all]."
+  (interactive)
+  (call-profile-enable t))
 
 (defun elp-set-master (funsym)
   "Set the master function for profiling."
@@ -377,10 +421,15 @@ original definition, use \\[elp-restore-function] or \\[elp-restore-all]."
            result)
       (or func
           (error "%s is not instrumented for profiling" funsym))
-      (if (not elp-record-p)
-          ;; when not recording, just call the original function symbol
-          ;; and return the results.
-          (setq result (apply func args))
+      (cond
+       ((not elp-record-p)
+        ;; when not recording, just call the original function symbol
+        ;; and return the results.
+        (setq result (apply func args)))
+       ((eq info 'call-profile)
+        ;; the call profiler does the recording
+        (setq result (call-profile-apply funsym func args)))
+       (t
         ;; we are recording times
         (let (enter-time exit-time)
           ;; increment the call-counter
@@ -390,7 +439,7 @@ original definition, use \\[elp-restore-function] or \\[elp-restore-all]."
                 exit-time (current-time))
           ;; calculate total time in function
           (cl-incf (aref info 1) (elp-elapsed-time enter-time exit-time))
-          ))
+          )))
       ;; turn off recording if this is the master function
       (if (and elp-master
                (eq funsym elp-master))
@@ -510,24 +559,33 @@ displayed."
 	   (at-header "Average Time")
 	   (elp-at-len    (length at-header))
 	   (resvec '())
+	   (results '())
 	   )				; end let*
       (mapatoms
        (lambda (funsym)
          (when (elp--instrumented-p funsym)
            (let* ((info (get funsym elp-timer-info-property))
-                  (symname (format "%s" funsym))
-                  (cc (aref info 0))
-                  (tt (aref info 1)))
-             (if (not info)
-                 (insert "No profiling information found for: "
-                         symname)
-               (setq longest (max longest (length symname)))
-               (push
-                (vector cc tt (if (zerop cc)
-                                  0.0 ;avoid arithmetic div-by-zero errors
-                                (/ (float tt) (float cc)))
-                        symname)
-                resvec))))))
+                  (symname (format "%s" funsym)))
+             (cond
+              ((not info)
+               (insert "No profiling information found for: "
+                       symname))
+              ((vectorp info)
+               (push (list funsym (aref info 0) (aref info 1))
+                     results)))))))
+      ;; the call profiler also has the functions it profiles itself
+      (setq results (append (call-profile-results) results))
+      (dolist (result results)
+        (let ((symname (format "%s" (nth 0 result)))
+              (cc (nth 1 result))
+              (tt (nth 2 result)))
+          (setq longest (max longest (length symname)))
+          (push
+           (vector cc tt (if (zerop cc)
+                             0.0 ;avoid arithmetic div-by-zero errors
+                           (/ (float tt) (float cc)))
+                   symname)
+           resvec)))
       ;; If printing to stdout, insert the header so it will print.
       ;; Otherwise use header-line-format.
       (setq elp-field-len (max titlelen longest))
@@ -102,6 +102,19 @@ It is called with two arguments, ID and COLS.  ID is a Lisp
 object identifying the entry, and COLS is a vector of column
 descriptors, as documented in `tabulated-list-entries'.")
 
+(defvar-local tabulated-list-print-lazily nil
+  "Whether `tabulated-list-print' formats entries only when displayed.
+If non-nil, the entries are first inserted as plain lines holding
+their column labels, and each is formatted with
+`tabulated-list-printer' just before a window shows it.  This makes
+printing very long lists fast.  If an integer, do this only when
+there are more entries than that.
+
+The printer must insert exactly one line for each entry.")
+
+(defvar-local tabulated-list--unprinted nil
+  "Non-nil if the buffer has entries not formatted yet.")
+
 (defvar-local tabulated-list-sort-key nil
   "Sort key for the current Tabulated List mode buffer.
 If nil, no additional sorting is performed.
@@ -290,6 +303,13 @@ to the entry with the same ID element as the current line."
 	 (setq entry-id (tabulated-list-get-id))
 	 (setq saved-col (current-column)))
     (erase-buffer)
+    (setq tabulated-list--unprinted
+	  (and tabulated-list-print-lazily
+	       (or (not (integerp tabulated-list-print-lazily))
+		   (> (length entries) tabulated-list-print-lazily))))
+    (when tabulated-list--unprinted
+      (add-function :before pre-redisplay-function
+		    #'tabulated-list--print-visible))
     (unless tabulated-list-use-header-line
       (tabulated-list-print-fake-header))
     ;; Sort the entries, if necessary.
@@ -317,16 +337,85 @@ to the entry with the same ID element as the current line."
       (and entry-id
 	   (equal entry-id (car elt))
 	   (setq saved-pt (point)))
-      (apply tabulated-list-printer elt))
+      (apply (if tabulated-list--unprinted
+		 #'tabulated-list--insert-unprinted
+	       tabulated-list-printer)
+	     elt))
     (set-buffer-modified-p nil)
     ;; If REMEMBER-POS was specified, move to the "old" location.
     (if saved-pt
 	(progn (goto-char saved-pt)
+	       (tabulated-list--print-lines (point) 1)
 	       (move-to-column saved-col)
 	       (when (eq (window-buffer) (current-buffer))
 		 (recenter)))
       (goto-char (point-min)))))
 
+(defun tabulated-list--insert-unprinted (id cols)
+  "Insert a line for the entry ID with COLS, to be formatted later.
+The line holds the column labels, so that it can be searched."
+  (let ((beg (point)))
+    (insert (make-string (max tabulated-list-padding 0) ?\s)
+	    (mapconcat (lambda (col) (if (stringp col) col (car col)))
+		       cols " ")
+	    "\n")
+    (add-text-properties beg (point)
+			 (list 'tabulated-list-id id
+			       'tabulated-list-entry cols
+			       'tabulated-list-unprinted t))))
+
+(defun tabulated-list--print-lines (pos count)
+  "Format the unprinted entries in COUNT lines from the line of POS.
+A tag put in the padding of an entry with `tabulated-list-put-tag'
+is kept.  If point is on one of these lines, its column is kept."
+  (when tabulated-list--unprinted
+    (let ((inhibit-read-only t)
+	  (buffer-undo-list t)
+	  (modified (buffer-modified-p))
+	  (col (and (get-text-property (line-beginning-position)
+				       'tabulated-list-unprinted)
+		    (current-column))))
+      (save-excursion
+	(goto-char pos)
+	(forward-line 0)
+	(while (and (> count 0) (not (eobp)))
+	  (when (get-text-property (point) 'tabulated-list-unprinted)
+	    (let* ((beg (point))
+		   (tag (buffer-substring-no-properties
+			 beg (min (+ beg (max tabulated-list-padding 0))
+				  (line-end-position)))))
+	      (delete-region beg (min (1+ (line-end-position)) (point-max)))
+	      (funcall tabulated-list-printer
+		       (get-text-property beg 'tabulated-list-id)
+		       (get-text-property beg 'tabulated-list-entry))
+	      (goto-char beg)
+	      (unless (string-match-p "\\` *\\'" tag)
+		(tabulated-list-put-tag tag))))
+	  (forward-line 1)
+	  (setq count (1- count))))
+      (when (and col (not (get-text-property (line-beginning-position)
+					      'tabulated-list-unprinted)))
+	(move-to-column col))
+      (set-buffer-modified-p modified))))
+
+(defun tabulated-list--print-visible (windows)
+  "Format the unprinted entries that WINDOWS are about to show.
+This is run by `pre-redisplay-function'.  Besides the lines from
+the start of each window, it formats those around point, which
+redisplay shows if point has moved out of view."
+  (dolist (window (cond ((eq windows t) (window-list-1 nil nil t))
+			(windows)
+			(t (list (selected-window)))))
+    (when (buffer-local-value 'tabulated-list--unprinted
+			      (window-buffer window))
+      (with-current-buffer (window-buffer window)
+	(let ((height (window-body-height window)))
+	  (tabulated-list--print-lines (window-start window) height)
+	  (save-excursion
+	    (goto-char (window-point window))
+	    (forward-line (- height))
+	    (tabulated-list--print-lines (point) (* 2 height))))))))
+
 (defun tabulated-list-print-entry (id cols)
   "Insert a Tabulated List entry at point.
 This is the default `tabulated-list-printer' function.  ID is a
@@ -416,6 +505,7 @@ If CHANGE-ENTRY-DATA is non-nil, modify the underlying entry data
 by setting the appropriate slot of the vector originally used to
 print this entry.  If `tabulated-list-entries' has a list value,
 this is the vector stored within it."
+  (tabulated-list--print-lines (point) 1)
   (let* ((opoint (point))
 	 (eol    (line-end-position))
 	 (pos    (line-beginning-position))
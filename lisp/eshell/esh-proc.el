@@ -77,6 +77,16 @@ variable's value to take effect."
   :type 'boolean
   :group 'eshell-proc)
 
+(defcustom eshell-direct-pipes t
+  "If non-nil, external commands in a pipeline write to each other directly.
+The output of an external command piped into another external command
+then goes straight to it, as in a shell, without passing through
+Emacs.  Commands that read from a pipeline use pipes rather than
+ptys, for their output as well as their input."
+  :version "24.5"
+  :type 'boolean
+  :group 'eshell-proc)
+
 (defcustom eshell-reset-signals
   "^\\(interrupt\\|killed\\|quit\\|stopped\\)"
   "If a termination signal matches this regexp, the terminal will be reset."
@@ -262,6 +272,22 @@ See `eshell-needs-pipe'."
 				   (file-name-nondirectory command)))
 	       (throw 'found t))))))
 
+(defun eshell-pipe-destination ()
+  "Return the process to pipe the output of the next command into.
+When `eshell-direct-pipes' is non-nil, this is the external process
+that gets both the standard output and the standard error of the
+command, if nothing else does.  Otherwise, return nil."
+  (let ((output (car (aref eshell-current-handles eshell-output-handle))))
+    (and eshell-direct-pipes
+	 (consp output) (null (cdr output))
+	 (equal output (car (aref eshell-current-handles eshell-error-handle)))
+	 (eshell-processp (car output))
+	 (eq (process-type (car output)) 'real)
+	 (eq (process-status (car output)) 'run)
+	 (null (process-tty-name (car output)))
+	 (not (file-remote-p default-directory))
+	 (car output))))
+
 (defun eshell-gather-process-output (command args)
   "Gather the output from COMMAND + ARGS."
   (unless (and (file-executable-p command)
@@ -277,8 +303,11 @@ See `eshell-needs-pipe'."
      ((fboundp 'start-file-process)
       (setq proc
 	    (let ((process-connection-type
-		   (unless (eshell-needs-pipe-p command)
+		   (unless (or (eshell-needs-pipe-p command)
+			       (and eshell-direct-pipes eshell-in-pipeline-p
+				    (not (eq eshell-in-pipeline-p 'first))))
 		     process-connection-type))
+		  (process-pipe-destination (eshell-pipe-destination))
 		  (command (or (file-remote-p command 'localname) command)))
 	      (apply 'start-file-process
 		     (file-name-nondirectory command) nil
@@ -1851,7 +1851,7 @@ the X resource ``reverseVideo'' is present, handle that."
 	  (x-setup-function-keys frame)
 	  (x-handle-reverse-video frame parameters)
 	  (frame-set-background-mode frame t)
-	  (face-set-after-frame-default frame parameters)
+	  (face-set-after-frame-default frame parameters t)
 	  (if (null visibility-spec)
 	      (make-frame-visible frame)
 	    (modify-frame-parameters frame (list visibility-spec)))
@@ -1860,22 +1860,53 @@ the X resource ``reverseVideo'' is present, handle that."
 	(delete-frame frame)))
     frame))
 
-(defun face-set-after-frame-default (frame &optional parameters)
+(defcustom face-copy-from-similar-frame nil
+  "Non-nil means new frames copy their faces from a similar frame.
+A frame is similar if it is on the same terminal, with the same
+display type and background mode.  Copying the face definitions
+is much faster than computing them from the face specs, which
+matters when many frames are created, but it also copies face
+attributes that were set for the other frame alone."
+  :type 'boolean
+  :group 'frames
+  :version "24.5")
+
+(defun face--similar-frame (frame)
+  "Return a live frame other than FRAME whose faces FRAME can copy.
+See `face-copy-from-similar-frame'."
+  (let ((terminal (frame-terminal frame))
+	(type (frame-parameter frame 'display-type))
+	(mode (frame-parameter frame 'background-mode)))
+    (catch 'found
+      (dolist (f (frame-list))
+	(and (not (eq f frame))
+	     (eq (frame-terminal f) terminal)
+	     (eq (frame-parameter f 'display-type) type)
+	     (eq (frame-parameter f 'background-mode) mode)
+	     (throw 'found f))))))
+
+(defun face-set-after-frame-default (frame &optional parameters new)
   "Initialize the frame-local faces of FRAME.
 Calculate the face definitions using the face specs, custom theme
-settings, X resources, and `face-new-frame-defaults'.
+settings, X resources, and `face-new-frame-defaults'.  If NEW is
+non-nil, FRAME has just been created, and the definitions are
+copied from a similar frame instead if `face-copy-from-similar-frame'
+says so.
 Finally, apply any relevant face attributes found amongst the
 frame parameters in PARAMETERS."
-  ;; The `reverse' is so that `default' goes first.
-  (dolist (face (nreverse (face-list)))
-    (condition-case ()
-	(progn
-	  ;; Initialize faces from face spec and custom theme.
-	  (face-spec-recalc face frame)
-	  ;; Apply attributes specified by face-new-frame-defaults
-	  (internal-merge-in-global-face face frame))
-      ;; Don't let invalid specs prevent frame creation.
-      (error nil)))
+  (let ((similar (and new face-copy-from-similar-frame
+		      (face--similar-frame frame))))
+    ;; The `reverse' is so that `default' goes first.
+    (dolist (face (nreverse (face-list)))
+      (condition-case ()
+	  (if similar
+	      (internal-copy-lisp-face face face similar frame)
+	    ;; Initialize faces from face spec and custom theme.
+	    (face-spec-recalc face frame)
+	    ;; Apply attributes specified by face-new-frame-defaults
+	    (internal-merge-in-global-face face frame))
+	;; Don't let invalid specs prevent frame creation.
+	(error nil))))
 
   ;; Apply attributes specified by frame parameters.
   (let ((face-params '((foreground-color default :foreground)
@@ -1924,7 +1955,7 @@ If PARAMETERS contains a `reverse' parameter, handle that."
             (set-locale-environment nil frame)
             (tty-run-terminal-initialization frame nil t))
 	  (frame-set-background-mode frame t)
-	  (face-set-after-frame-default frame parameters)
+	  (face-set-after-frame-default frame parameters t)
 	  (setq success t))
       (unless success
 	(delete-frame frame)))
@@ -190,6 +190,12 @@ car of that event, which is the symbol `file-notify'."
 	    (funcall callback (list desc action file file1))
 	  (funcall callback (list desc action file)))))))
 
+;; `inotify' delivers the events of a read at once, which keeps a
+;; burst of them from flooding the event queue.
+(defun file-notify--callback-batch (events)
+  "Handle EVENTS, a vector of events, with `file-notify-callback'."
+  (mapc 'file-notify-callback events))
+
 (defun file-notify-add-watch (file flags callback)
   "Add a watch for filesystem events pertaining to FILE.
 This arranges for filesystem events pertaining to FILE to be reported
@@ -286,7 +292,11 @@ FILE is the name of the file whose event is being reported."
 	      ((eq file-notify--library 'w32notify) 'attributes)))))
 
 	;; Call low-level function.
-	(setq desc (funcall func dir l-flags 'file-notify-callback))))
+	(setq desc
+	      (if (eq file-notify--library 'inotify)
+		  (funcall func dir (cons 'batch l-flags)
+			   'file-notify--callback-batch)
+		(funcall func dir l-flags 'file-notify-callback)))))
 
     ;; Return descriptor.
     (puthash desc
@@ -870,6 +870,26 @@ or mount points potentially requiring authentication as a different user.")
 ;;               (setq dir nil))))
 ;;       nil)))
 
+(defun prefetch-file-attributes (files &optional id-format)
+  "Say that the attributes of FILES are about to be needed.
+This lets a file name handler get the attributes of many remote files
+in one round trip, and then answer `file-attributes' with ID-FORMAT,
+and `file-exists-p', from its cache for a while; see
+`remote-file-name-inhibit-cache'.  FILES without a handler are
+ignored.  Return nil."
+  (let (groups)
+    (dolist (file files)
+      (let* ((file (expand-file-name file))
+	     (handler (find-file-name-handler file 'prefetch-file-attributes))
+	     (group (assq handler groups)))
+	(cond ((null handler))
+	      (group (push file (cdr group)))
+	      (t (push (list handler file) groups)))))
+    (dolist (group groups)
+      (funcall (car group) 'prefetch-file-attributes
+	       (nreverse (cdr group)) id-format))
+    nil))
+
 (defun locate-dominating-file (file name)
   "Look up the directory hierarchy from FILE for a directory containing NAME.
 Stop at the first parent directory containing a file NAME,
@@ -884,6 +904,16 @@ which we're looking."
   ;; Represent /home/luser/foo as ~/foo so that we don't try to look for
   ;; `name' in /home or in /.
   (setq file (abbreviate-file-name (expand-file-name file)))
+  (when (and (stringp name) (file-remote-p file))
+    ;; Over a remote connection, asking about the candidates one at a
+    ;; time would cost a round trip each.
+    (let ((dir file) parent candidates)
+      (while (and dir (not (string-match locate-dominating-stop-dir-regexp
+					 dir)))
+	(push (expand-file-name name dir) candidates)
+	(setq parent (file-name-directory (directory-file-name dir))
+	      dir (unless (equal parent dir) parent)))
+      (prefetch-file-attributes candidates)))
   (let ((root nil)
         ;; `user' is not initialized outside the loop because
         ;; `file' may not exist, so we may have to walk up part of the
@@ -6055,6 +6085,17 @@ need to be passed verbatim to shell commands."
 (defvar insert-directory-program (purecopy "ls")
   "Absolute or relative name of the `ls' program used by `insert-directory'.")
 
+(defcustom insert-directory-use-native nil
+  "Non-nil means `insert-directory' lists whole directories itself.
+It then uses `insert-directory-native' instead of running
+`insert-directory-program', whenever that function supports the
+switches.  This is much faster for large directories, and shows the
+start of the listing while the rest is inserted, if the buffer is
+being displayed.  File names sort as `ls' sorts them in the C locale."
+  :type 'boolean
+  :group 'dired
+  :version "24.5")
+
 (defcustom directory-free-space-program (purecopy "df")
   "Program to get the amount of free space on a file system.
 We assume the output has the format of `df'.
@@ -6217,6 +6258,10 @@ normally equivalent short `-D' option is just passed on to
     (if handler
 	(funcall handler 'insert-directory file switches
 		 wildcard full-directory-p)
+      (unless (and insert-directory-use-native
+		   full-directory-p (not wildcard)
+		   (fboundp 'insert-directory-native)
+		   (insert-directory--native file switches))
 	(let (result (beg (point)))
 
 	  ;; Read the actual directory using `insert-directory-program'.
@@ -6444,17 +6489,35 @@ normally equivalent short `-D' option is just passed on to
 					     'dired-filename t)))))))
 
 	  (if full-directory-p
-	      ;; Try to insert the amount of free space.
-	      (save-excursion
-		(goto-char beg)
-		;; First find the line to put it on.
-		(when (re-search-forward "^ *\\(total\\)" nil t)
-		  (let ((available (get-free-disk-space ".")))
-		    (when available
-		      ;; Replace "total" with "used", to avoid confusion.
-		      (replace-match "total used in directory" nil nil nil 1)
-		      (end-of-line)
-		      (insert " available " available))))))))))
+	      (insert-directory--free-space beg)))))))
+
+(defun insert-directory--free-space (beg)
+  "Insert the amount of free space in the listing that starts at BEG."
+  (save-excursion
+    (goto-char beg)
+    ;; First find the line to put it on.
+    (when (re-search-forward "^ *\\(total\\)" nil t)
+      (let ((available (get-free-disk-space ".")))
+	(when available
+	  ;; Replace "total" with "used", to avoid confusion.
+	  (replace-match "total used in directory" nil nil nil 1)
+	  (end-of-line)
+	  (insert " available " available))))))
+
+(defun insert-directory--native (dir switches)
+  "Insert a listing of DIR using `insert-directory-native', if possible.
+Return nil if that function does not support SWITCHES."
+  (let ((beg (point)))
+    (when (insert-directory-native dir switches
+				   #'insert-directory--show-progress)
+      (insert-directory--free-space beg)
+      t)))
+
+(defun insert-directory--show-progress ()
+  "Show the part of a directory listing inserted so far.
+Do nothing unless the current buffer is being displayed."
+  (when (get-buffer-window nil 'visible)
+    (redisplay)))
 
 (defun insert-directory-adj-pos (pos error-lines)
   "Convert `ls --dired' file name position value POS to a buffer position.
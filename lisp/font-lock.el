@@ -287,6 +287,19 @@ If a number, only buffers greater than this size have fontification messages."
 		 (integer :tag "size"))
   :group 'font-lock
   :version "24.1")
+
+(defcustom font-lock-keywords-single-pass nil
+  "If non-nil, fontify all regexp keywords in one scan of the text.
+Normally each element of `font-lock-keywords' is searched for over the
+whole region in turn.  If this is non-nil, the elements whose MATCHER
+is a regexp are searched for together, with `re-search-forward-multi',
+and the highlights of their matches are applied in buffer order,
+before the elements whose MATCHER is a function.  This is faster when
+there are many keywords, but keywords whose highlights overlap may come
+out differently, and the highlights must not change the text."
+  :type 'boolean
+  :group 'font-lock
+  :version "24.5")
 
 
 ;; Originally these variable values were face names such as `bold' etc.
@@ -1680,6 +1693,64 @@ LIMIT can be modified by the value of its PRE-MATCH-FORM."
     ;; Evaluate POST-MATCH-FORM.
     (eval (nth 2 keywords))))
 
+;; This is the body of the loop in `font-lock-fontify-keywords-region',
+;; for one match of one keyword.
+(defun font-lock-fontify-keyword-match (keyword end pos)
+  "Fontify the current match of KEYWORD, an element of `font-lock-keywords'.
+END is the end of the region being fontified, and POS a marker to use."
+  (when (and font-lock-multiline
+	     (>= (point)
+		 (save-excursion (goto-char (match-beginning 0))
+				 (forward-line 1) (point))))
+    ;; this is a multiline regexp match
+    ;; (setq font-lock-multiline t)
+    (put-text-property (if (= (point)
+			      (save-excursion
+				(goto-char (match-beginning 0))
+				(forward-line 1) (point)))
+			   (1- (point))
+			 (match-beginning 0))
+		       (point)
+		       'font-lock-multiline t))
+  ;; Apply each highlight to this instance of `matcher', which may be
+  ;; specific highlights or more keywords anchored to `matcher'.
+  (let ((highlights (cdr keyword)))
+    (while highlights
+      (if (numberp (car (car highlights)))
+	  (font-lock-apply-highlight (car highlights))
+	(set-marker pos (point))
+	(font-lock-fontify-anchored-keywords (car highlights) end)
+	;; Ensure forward progress.  `pos' is a marker because anchored
+	;; keyword may add/delete text (this happens e.g. in grep.el).
+	(if (< (point) pos) (goto-char pos)))
+      (setq highlights (cdr highlights)))))
+
+(defun font-lock-fontify-regexp-keywords (keywords start end pos)
+  "Fontify the elements of KEYWORDS with a regexp MATCHER in one scan.
+Search for them all together between START and END, fontifying their
+matches in buffer order.  POS is a marker to use.  Return the elements
+of KEYWORDS whose MATCHER is a function, which are left to the caller."
+  (let (regexp-keywords others)
+    (dolist (keyword keywords)
+      (if (stringp (car keyword))
+	  (push keyword regexp-keywords)
+	(push keyword others)))
+    (when (and regexp-keywords (< start end))
+      (let* ((vector (vconcat (nreverse regexp-keywords)))
+	     (regexps (vconcat (mapcar #'car vector)))
+	     (cache (make-vector (length vector) nil))
+	     index)
+	(goto-char start)
+	(while (setq index (re-search-forward-multi regexps end cache))
+	  ;; Beware empty string matches since they will loop
+	  ;; indefinitely.
+	  (when (= (point) (match-beginning 0))
+	    (if (< (point) end)
+		(forward-char 1)
+	      (aset cache index t)))
+	  (font-lock-fontify-keyword-match (aref vector index) end pos))))
+    (nreverse others)))
+
 (defun font-lock-fontify-keywords-region (start end &optional loudly)
   "Fontify according to `font-lock-keywords' between START and END.
 START should be at the beginning of a line.
@@ -1691,7 +1762,13 @@ LOUDLY, if non-nil, allows progress-meter bar."
 	(keywords (cddr font-lock-keywords))
 	(bufname (buffer-name)) (count 0)
         (pos (make-marker))
-	keyword matcher highlights)
+	keyword matcher)
+    ;;
+    ;; Fontify the items with a regexp matcher at once, if asked to.
+    (when font-lock-keywords-single-pass
+      (if loudly (message "Fontifying %s... (regexps)" bufname))
+      (setq keywords
+	    (font-lock-fontify-regexp-keywords keywords start end pos)))
     ;;
     ;; Fontify each item in `font-lock-keywords' from `start' to `end'.
     (while keywords
@@ -1709,32 +1786,7 @@ LOUDLY, if non-nil, allows progress-meter bar."
                   ;; loop indefinitely.
                   (or (> (point) (match-beginning 0))
                       (progn (forward-char 1) t)))
-	(when (and font-lock-multiline
-		   (>= (point)
-		       (save-excursion (goto-char (match-beginning 0))
-				       (forward-line 1) (point))))
-	  ;; this is a multiline regexp match
-	  ;; (setq font-lock-multiline t)
-	  (put-text-property (if (= (point)
-				    (save-excursion
-				      (goto-char (match-beginning 0))
-				      (forward-line 1) (point)))
-				 (1- (point))
-			       (match-beginning 0))
-			     (point)
-			     'font-lock-multiline t))
-	;; Apply each highlight to this instance of `matcher', which may be
-	;; specific highlights or more keywords anchored to `matcher'.
-	(setq highlights (cdr keyword))
-	(while highlights
-	  (if (numberp (car (car highlights)))
-	      (font-lock-apply-highlight (car highlights))
-	    (set-marker pos (point))
-            (font-lock-fontify-anchored-keywords (car highlights) end)
-            ;; Ensure forward progress.  `pos' is a marker because anchored
-            ;; keyword may add/delete text (this happens e.g. in grep.el).
-            (if (< (point) pos) (goto-char pos)))
-	  (setq highlights (cdr highlights))))
+	(font-lock-fontify-keyword-match keyword end pos))
       (setq keywords (cdr keywords)))
     (set-marker pos nil)))
 
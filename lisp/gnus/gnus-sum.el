@@ -4492,42 +4492,30 @@ Returns HEADER if it was entered in the DEPENDENCIES.  Returns nil otherwise."
 ;; This function has to be called with point after the article number
 ;; on the beginning of the line.
 (defsubst gnus-nov-parse-line (number dependencies &optional force-new)
-  (let ((eol (point-at-eol))
-	(buffer (current-buffer))
-	header references in-reply-to)
-
-    ;; overview: [num subject from date id refs chars lines misc]
-    (unwind-protect
-	(let (x)
-	  (narrow-to-region (point) eol)
-	  (unless (eobp)
-	    (forward-char))
-
-	  (setq header
-		(make-full-mail-header
-		 number			; number
-		 (condition-case ()	; subject
-		     (gnus-remove-odd-characters
-		      (funcall gnus-decode-encoded-word-function
-			       (setq x (nnheader-nov-field))))
-		   (error x))
-		 (condition-case ()	; from
-		     (gnus-remove-odd-characters
-		      (funcall gnus-decode-encoded-address-function
-			       (setq x (nnheader-nov-field))))
-		   (error x))
-		 (nnheader-nov-field)	; date
-		 (nnheader-nov-read-message-id number)	; id
-		 (setq references (nnheader-nov-field))	; refs
-		 (nnheader-nov-read-integer) ; chars
-		 (nnheader-nov-read-integer) ; lines
-		 (unless (eobp)
-		   (if (looking-at "Xref: ")
-		       (goto-char (match-end 0)))
-		   (nnheader-nov-field)) ; Xref
-		 (nnheader-nov-parse-extra)))) ; extra
-
-      (widen))
+  ;; overview: [num subject from date id refs chars lines misc]
+  ;; The first field is what is left of the number.
+  (let* ((fields (cdr (nnheader-nov-fields)))
+	 (subject (or (pop fields) ""))
+	 (from (or (pop fields) ""))
+	 header references in-reply-to)
+    (setq header
+	  (make-full-mail-header
+	   number			; number
+	   (condition-case ()		; subject
+	       (gnus-remove-odd-characters
+		(funcall gnus-decode-encoded-word-function subject))
+	     (error subject))
+	   (condition-case ()		; from
+	       (gnus-remove-odd-characters
+		(funcall gnus-decode-encoded-address-function from))
+	     (error from))
+	   (or (pop fields) "")		; date
+	   (nnheader-nov-message-id (or (pop fields) "") number) ; id
+	   (setq references (or (pop fields) "")) ; refs
+	   (nnheader-nov-integer (pop fields)) ; chars
+	   (nnheader-nov-integer (pop fields)) ; lines
+	   (nnheader-nov-xref fields)	; Xref
+	   (nnheader-nov-extra (cdr fields)))) ; extra
 
     (when (and (string= references "")
 	       (setq in-reply-to (mail-header-extra header))
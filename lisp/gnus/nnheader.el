@@ -406,7 +406,10 @@ on your system, you could say something like:
   (defvar nnheader-uniquify-message-id nil))
 
 (defmacro nnheader-nov-read-message-id (&optional number)
-  `(let ((id (nnheader-nov-field)))
+  `(nnheader-nov-message-id (nnheader-nov-field) ,number))
+
+(defmacro nnheader-nov-message-id (id &optional number)
+  `(let ((id ,id))
      (if (string-match "^<[^>]+>$" id)
 	 ,(if nnheader-uniquify-message-id
 	      `(if (string-match "__[^@]+@" id)
@@ -416,24 +419,59 @@ on your system, you could say something like:
 	    'id)
        (nnheader-generate-fake-message-id ,number))))
 
+(defun nnheader-nov-fields ()
+  "Return the tab-separated fields from point to the end of the line.
+Leave point at the end of the line."
+  (if (fboundp 'buffer-line-fields)
+      (buffer-line-fields ?\t)
+    (let ((eol (point-at-eol))
+	  (start (point))
+	  fields)
+      (while (search-forward "\t" eol t)
+	(push (buffer-substring start (1- (point))) fields)
+	(setq start (point)))
+      (push (buffer-substring start eol) fields)
+      (goto-char eol)
+      (nreverse fields))))
+
+(defsubst nnheader-nov-integer (field)
+  "Return the number in the NOV FIELD, or 0 if there is none."
+  (if (and field (string-match "\\`[0-9]+\\'" field))
+      (string-to-number field)
+    0))
+
+(defsubst nnheader-nov-xref (fields)
+  "Return the Xref of a NOV line, where FIELDS are the fields after Lines."
+  (when (and fields
+	     (not (and (null (cdr fields)) (equal (car fields) ""))))
+    (if (string-match "\\`Xref: " (car fields))
+	(substring (car fields) (match-end 0))
+      (car fields))))
+
+(defsubst nnheader-nov-extra (fields)
+  "Return the extra headers of a NOV line, in FIELDS after the Xref."
+  (let (out)
+    (dolist (string fields)
+      (when (string-match "^\\([^ :]+\\): " string)
+	(push (cons (intern (match-string 1 string))
+		    (substring string (match-end 0)))
+	      out)))
+    out))
+
 (defun nnheader-parse-nov ()
-  (let ((eol (point-at-eol))
-	(number (nnheader-nov-read-integer)))
+  (let* ((fields (nnheader-nov-fields))
+	 (number (nnheader-nov-integer (pop fields))))
     (vector
      number				; number
-     (nnheader-nov-field)		; subject
-     (nnheader-nov-field)		; from
-     (nnheader-nov-field)		; date
-     (nnheader-nov-read-message-id number) ; id
-     (nnheader-nov-field)		; refs
-     (nnheader-nov-read-integer)	; chars
-     (nnheader-nov-read-integer)	; lines
-     (if (eq (char-after) ?\n)
-	 nil
-       (if (looking-at "Xref: ")
-	   (goto-char (match-end 0)))
-       (nnheader-nov-field))		; Xref
-     (nnheader-nov-parse-extra))))	; extra
+     (or (pop fields) "")		; subject
+     (or (pop fields) "")		; from
+     (or (pop fields) "")		; date
+     (nnheader-nov-message-id (or (pop fields) "") number) ; id
+     (or (pop fields) "")		; refs
+     (nnheader-nov-integer (pop fields)) ; chars
+     (nnheader-nov-integer (pop fields)) ; lines
+     (nnheader-nov-xref fields)		; Xref
+     (nnheader-nov-extra (cdr fields))))) ; extra
 
 (defun nnheader-insert-nov (header)
   (princ (mail-header-number header) (current-buffer))
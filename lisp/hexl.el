@@ -63,7 +63,9 @@
 (defcustom hexl-program "hexl"
   "The program that will hexlify and dehexlify its stdin.
 `hexl-program' will always be concatenated with `hexl-options'
-and \"-de\" when dehexlifying a buffer."
+and \"-de\" when dehexlifying a buffer.
+With the default value, and options that `hexl-encode-region'
+supports, buffers are converted without running the program."
   :type 'string
   :group 'hexl)
 
@@ -828,6 +830,23 @@ to produce the command line options to pass to the hexl command."
       (setq opts (format "%s -group-by-%d-bits " opts hexl-bits)) )
     opts))
 
+(defun hexl-builtin-options ()
+  "Return (GROUP ISO) if the buffer can be converted without `hexl-program'.
+GROUP and ISO are the arguments for `hexl-encode-region' that match
+the options of `hexl-program'.  Return nil if `hexl-program' is not
+the default one, or `hexl-options' has an option only it supports."
+  (when (and (equal hexl-program "hexl")
+	     (fboundp 'hexl-encode-region))
+    (let ((group 2) (iso nil) (supported t))
+      (dolist (option (split-string (hexl-options)))
+	(cond ((member option '("-hex" "-big-endian" "-little-endian")))
+	      ((equal option "-iso") (setq iso t))
+	      ((string-match "\\`-group-by-\\(8\\|16\\|32\\|64\\)-bits\\'"
+			     option)
+	       (setq group (/ (string-to-number (match-string 1 option)) 8)))
+	      (t (setq supported nil))))
+      (and supported (list group iso)))))
+
 ;;;###autoload
 (defun hexlify-buffer ()
   "Convert a binary buffer to hexl format.
@@ -840,17 +859,25 @@ This discards the buffer's undo information."
   ;; Don't decode text in the ASCII part of `hexl' program output.
   (let ((coding-system-for-read 'raw-text)
 	(coding-system-for-write buffer-file-coding-system)
-	(buffer-undo-list t))
-    (apply 'call-process-region (point-min) (point-max)
-	   (expand-file-name hexl-program exec-directory)
-	   t t nil
-           ;; Manually encode the args, otherwise they're encoded using
-           ;; coding-system-for-write (i.e. buffer-file-coding-system) which
-           ;; may not be what we want (e.g. utf-16 on a non-utf-16 system).
-           (mapcar (lambda (s)
-                     (if (not (multibyte-string-p s)) s
-                       (encode-coding-string s locale-coding-system)))
-                   (split-string (hexl-options))))
+	(buffer-undo-list t)
+	(options (hexl-builtin-options)))
+    (if options
+	(progn
+	  (when enable-multibyte-characters
+	    (encode-coding-region (point-min) (point-max)
+				  buffer-file-coding-system))
+	  (hexl-encode-region (point-min) (point-max)
+			      (car options) (cadr options)))
+      (apply 'call-process-region (point-min) (point-max)
+	     (expand-file-name hexl-program exec-directory)
+	     t t nil
+	     ;; Manually encode the args, otherwise they're encoded using
+	     ;; coding-system-for-write (i.e. buffer-file-coding-system) which
+	     ;; may not be what we want (e.g. utf-16 on a non-utf-16 system).
+	     (mapcar (lambda (s)
+		       (if (not (multibyte-string-p s)) s
+			 (encode-coding-string s locale-coding-system)))
+		     (split-string (hexl-options)))))
     (if (> (point) (hexl-address-to-marker hexl-max-address))
 	(hexl-goto-address hexl-max-address))))
 
@@ -864,10 +891,17 @@ This discards the buffer's undo information."
        (setq buffer-undo-list nil))
   (let ((coding-system-for-write 'raw-text)
 	(coding-system-for-read buffer-file-coding-system)
-	(buffer-undo-list t))
-    (apply 'call-process-region (point-min) (point-max)
-	   (expand-file-name hexl-program exec-directory)
-	   t t nil "-de" (split-string (hexl-options)))))
+	(buffer-undo-list t)
+	(options (hexl-builtin-options)))
+    (if options
+	(progn
+	  (hexl-decode-region (point-min) (point-max) (car options))
+	  (when enable-multibyte-characters
+	    (decode-coding-region (point-min) (point-max)
+				  buffer-file-coding-system)))
+      (apply 'call-process-region (point-min) (point-max)
+	     (expand-file-name hexl-program exec-directory)
+	     t t nil "-de" (split-string (hexl-options))))))
 
 (defun hexl-char-after-point ()
   "Return char for ASCII hex digits at point."
@@ -610,7 +610,9 @@ Non-nil arguments are in recursive calls."
   ;; and use imenu--index-alist.
   (if alist
       (setq imenu--cleanup-seen (cons alist imenu--cleanup-seen))
-    (setq alist imenu--index-alist imenu--cleanup-seen (list alist)))
+    (setq alist imenu--index-alist imenu--cleanup-seen (list alist)
+	  ;; The markers of the items are about to go.
+	  imenu--generic-items nil))
 
   (when alist
     (dolist (item alist)
@@ -705,7 +707,7 @@ The alternate method, which is the one most often used, is to call
 	   index-alist))
 	;; Use generic expression if possible.
 	((and imenu-generic-expression)
-	 (imenu--generic-function imenu-generic-expression))
+	 (imenu--generic-function-incrementally imenu-generic-expression))
 	(t
 	 (user-error "This buffer cannot use `imenu-default-create-index-function'"))))
 
@@ -740,7 +742,15 @@ or
 The return value may also consist of nested index alists like:
  (INDEX-NAME . INDEX-ALIST)
 depending on PATTERNS."
-  (let ((index-alist (list 'dummy))
+  (imenu--generic-index
+   (imenu--generic-scan patterns (point-min) (point-max))
+   patterns))
+
+(defun imenu--generic-scan (patterns start end)
+  "Find the items of PATTERNS whose match starts between START and END.
+Return a list of elements (MENU-TITLE . ITEM), where ITEM is an
+element of the index alist made by `imenu--generic-function'."
+  (let ((items nil)
         (case-fold-search (if (or (local-variable-p 'imenu-case-fold-search)
 				  (not (local-variable-p 'font-lock-defaults)))
 			      imenu-case-fold-search
@@ -756,7 +766,7 @@ depending on PATTERNS."
         (mapc (lambda (c)
                 (modify-syntax-entry c (cdr syn) table))
               (car syn))))
-    (goto-char (point-max))
+    (goto-char end)
     (unwind-protect			; For syntax table.
 	(save-match-data
 	  (set-syntax-table table)
@@ -769,66 +779,171 @@ depending on PATTERNS."
 		  (index (nth 2 pat))
 		  (function (nth 3 pat))
 		  (rest (nthcdr 4 pat))
-		  start beg)
+		  found pos beg)
 	      ;; Go backwards for convenience of adding items in order.
-	      (goto-char (point-max))
+	      (goto-char end)
 	      (while (and (if (functionp regexp)
 			      (funcall regexp)
 			    (and
-			     (re-search-backward regexp nil t)
+			     (re-search-backward regexp start t)
 			     ;; Do not count invisible definitions.
 			     (let ((invis (invisible-p (point))))
 			       (or (not invis)
 				   (progn
 				     (while (and invis
-						 (not (bobp)))
+						 (> (point) start))
 				       (setq invis (not (re-search-backward
-							 regexp nil 'move))))
+							 regexp start 'move))))
 				     (not invis))))))
 			  ;; Exit the loop if we get an empty match,
 			  ;; because it means a bad regexp was specified.
 			  (not (= (match-beginning 0) (match-end 0))))
-		(setq start (point))
+		(setq pos (point))
 		;; Record the start of the line in which the match starts.
 		;; That's the official position of this definition.
 		(goto-char (match-beginning index))
 		(beginning-of-line)
 		(setq beg (point))
-		;; Add this sort of submenu only when we've found an
-		;; item for it, avoiding empty, duff menus.
-		(unless (assoc menu-title index-alist)
-		  (push (list menu-title) index-alist))
 		(if imenu-use-markers
 		    (setq beg (copy-marker beg)))
-		(let ((item
-		       (if function
-			   (nconc (list (match-string-no-properties index)
-					beg function)
-				  rest)
-			 (cons (match-string-no-properties index)
-			       beg)))
-		      ;; This is the desired submenu,
-		      ;; starting with its title (or nil).
-		      (menu (assoc menu-title index-alist)))
-		  ;; Insert the item unless it is already present.
-		  (unless (or (member item (cdr menu))
-                              (and imenu-generic-skip-comments-and-strings
-                                   (nth 8 (syntax-ppss))))
-		    (setcdr menu
-			    (cons item (cdr menu)))))
+		(unless (and imenu-generic-skip-comments-and-strings
+			     (nth 8 (syntax-ppss)))
+		  (push (cons menu-title
+			      (if function
+				  (nconc (list (match-string-no-properties index)
+					       beg function)
+					 rest)
+				(cons (match-string-no-properties index)
+				      beg)))
+			found))
 		;; Go to the start of the match, to make sure we
 		;; keep making progress backwards.
-		(goto-char start))))
+		(goto-char pos))
+	      (setq items (nconc items found))))
 	  (set-syntax-table old-table)))
-    ;; Sort each submenu by position.
-    ;; This is in case one submenu gets items from two different regexps.
-    (dolist (item index-alist)
-      (when (listp item)
-	(setcdr item (sort (cdr item) 'imenu--sort-by-position))))
+    items))
+
+(defun imenu--generic-index (items patterns)
+  "Return the index alist of ITEMS, found with PATTERNS.
+ITEMS is a list of elements (MENU-TITLE . ITEM), as returned by
+`imenu--generic-scan'."
+  (let ((menus nil)
+	(index-alist nil))
+    (dolist (item items)
+      (let ((menu (assoc (car item) menus)))
+	(unless menu
+	  (push (setq menu (list (car item))) menus))
+	(push (cdr item) (cdr menu))))
+    ;; Add a submenu only for the titles that have items, in the
+    ;; order of PATTERNS.  Sort each submenu by position, in case it
+    ;; gets items from several regexps, and drop duplicates.
+    (dolist (pat patterns)
+      (let ((menu (assoc (car pat) menus)))
+	(when (and menu (not (memq menu index-alist)))
+	  (setcdr menu (imenu--delete-duplicate-items
+			(sort (cdr menu) 'imenu--sort-by-position)))
+	  (push menu index-alist))))
     (let ((main-element (assq nil index-alist)))
-      (nconc (delq main-element (delq 'dummy index-alist))
+      (nconc (delq main-element index-alist)
 	     (cdr main-element)))))
 
+(defun imenu--delete-duplicate-items (items)
+  "Remove the duplicates from ITEMS, which are sorted by position."
+  (let (result same-position)
+    (dolist (item items)
+      (unless (and same-position
+		   (equal (cdr item) (cdr (car same-position))))
+	(setq same-position nil))
+      (unless (member item same-position)
+	(push item same-position)
+	(push item result)))
+    (nreverse result)))
+
+;;; Rescanning only the changed definitions.
+
+(defvar-local imenu--generic-items nil
+  "The items found by `imenu--generic-function-incrementally'.
+This is a list of elements (MENU-TITLE . ITEM), as returned by
+`imenu--generic-scan', for the patterns in `imenu--generic-patterns'.")
+
+(defvar-local imenu--generic-patterns nil
+  "The patterns `imenu--generic-items' were found with.")
+
+(defvar-local imenu--changed-region nil
+  "Markers (BEG . END) around the text changed since the last scan.
+This is nil if no text has changed.")
+
+(defun imenu--note-change (beg end _length)
+  "Extend `imenu--changed-region' to the text from BEG to END.
+This is run from `after-change-functions'."
+  (if imenu--changed-region
+      (progn
+	(when (< beg (car imenu--changed-region))
+	  (set-marker (car imenu--changed-region) beg))
+	(when (> end (cdr imenu--changed-region))
+	  (set-marker (cdr imenu--changed-region) end)))
+    (setq imenu--changed-region (cons (copy-marker beg) (copy-marker end t)))))
+
+(defun imenu--changed-definitions ()
+  "Return (BEG . END), the definitions around `imenu--changed-region'.
+BEG is the start of the definition where the changed text starts,
+and END the start of the one after the changed text."
+  (save-excursion
+    (let ((beg (car imenu--changed-region))
+	  (end (cdr imenu--changed-region)))
+      (goto-char beg)
+      (end-of-line)
+      (ignore-errors (beginning-of-defun))
+      (setq beg (min (line-beginning-position) beg))
+      (goto-char end)
+      (end-of-line)
+      (setq end (if (ignore-errors (beginning-of-defun -1))
+		    (max (point) end)
+		  (point-max)))
+      (cons beg end))))
+
+(defun imenu--item-position (item)
+  "Return the position of ITEM, an element of an index alist."
+  (let ((pos (if (consp (cdr item)) (cadr item) (cdr item))))
+    (if (markerp pos) (marker-position pos) pos)))
+
+(defun imenu--generic-function-incrementally (patterns)
+  "Return an index alist of the current buffer based on PATTERNS.
+This is like `imenu--generic-function', but after the first scan,
+it rescans only the definitions that changed since the previous
+scan, and keeps the items it found elsewhere.  That requires the
+positions to be markers, and the regexps of PATTERNS to be regexps
+rather than functions; otherwise, this scans the whole buffer."
+  (if (or (not imenu-use-markers)
+	  (let ((functions nil))
+	    (dolist (pat patterns functions)
+	      (when (functionp (nth 1 pat))
+		(setq functions t)))))
+      (imenu--generic-function patterns)
+    (if (not (and imenu--generic-items
+		  (equal patterns imenu--generic-patterns)))
+	(setq imenu--generic-items
+	      (imenu--generic-scan patterns (point-min) (point-max))
+	      imenu--generic-patterns patterns)
+      (when imenu--changed-region
+	(let* ((region (imenu--changed-definitions))
+	       (beg (car region))
+	       (end (cdr region))
+	       (kept nil))
+	  (dolist (item imenu--generic-items)
+	    (let ((pos (imenu--item-position (cdr item))))
+	      (when (and pos (or (< pos beg) (>= pos end)))
+		(push item kept))))
+	  (setq imenu--generic-items
+		(nconc (nreverse kept)
+		       (imenu--generic-scan patterns beg end))))))
+    (when imenu--changed-region
+      (set-marker (car imenu--changed-region) nil)
+      (set-marker (cdr imenu--changed-region) nil)
+      (setq imenu--changed-region nil))
+    (add-hook 'after-change-functions #'imenu--note-change nil t)
+    (imenu--generic-index imenu--generic-items patterns)))
+
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;;;
 ;;; The main functions for this package!
@@ -129,6 +129,21 @@ If nil, fontification is not deferred."
   :group 'jit-lock
   :type '(choice (const :tag "never" nil)
 	         (number :tag "seconds")))
+
+(defcustom jit-lock-background-size nil
+  "Size above which buffers are fontified in the background.
+In a buffer with more than this many characters, redisplay never
+waits for fontification.  The text it would fontify is displayed
+unfontified and fontified as soon as Emacs is idle, a chunk at a
+time; a chunk is given up when input arrives, and fontified again
+the next time Emacs is idle.
+If nil, buffers are fontified as they are displayed.
+
+The value of this variable is used when JIT Lock mode is turned on."
+  :group 'jit-lock
+  :type '(choice (const :tag "never" nil)
+		 (integer :tag "characters"))
+  :version "24.5")
 
 ;;; Variables that are not customizable.
 
@@ -151,11 +166,15 @@ If nil, contextual fontification is disabled.")
   "Timer for context fontification in Just-in-time Lock mode.")
 (defvar jit-lock-defer-timer nil
   "Timer for deferred fontification in Just-in-time Lock mode.")
+(defvar jit-lock-background-timer nil
+  "Timer for background fontification in Just-in-time Lock mode.")
 
 (defvar jit-lock-defer-buffers nil
   "List of buffers with pending deferred fontification.")
 (defvar jit-lock-stealth-buffers nil
   "List of buffers that are being fontified stealthily.")
+(defvar jit-lock-background-buffers nil
+  "List of buffers with pending background fontification.")
 
 ;;; JIT lock mode
 
@@ -186,6 +205,11 @@ following ways:
   corresponding to previous syntactic contexts.  This is useful where
   strings or comments span lines.
 
+- Background fontification of buffers larger than
+  `jit-lock-background-size'.  This means redisplay does not fontify
+  such buffers; the text it displays is fontified when Emacs is idle,
+  in chunks that are given up when input arrives.
+
 Stealth fontification only occurs while the system remains unloaded.
 If the system load rises above `jit-lock-stealth-load' percent, stealth
 fontification is suspended.  Stealth fontification intensity is controlled via
@@ -224,6 +248,11 @@ If you need to debug code run from jit-lock, see `jit-lock-debug-mode'."
             (run-with-idle-timer jit-lock-defer-time t
                                  'jit-lock-deferred-fontify)))
 
+    ;; Init background fontification timer.
+    (when (and jit-lock-background-size (null jit-lock-background-timer))
+      (setq jit-lock-background-timer
+            (run-with-idle-timer 0 t 'jit-lock-background-fontify)))
+
     ;; Initialize contextual fontification if requested.
     (when (eq jit-lock-contextually t)
       (unless jit-lock-context-timer
@@ -241,7 +270,7 @@ If you need to debug code run from jit-lock, see `jit-lock-debug-mode'."
    (t
     ;; Cancel our idle timers.
     (when (and (or jit-lock-stealth-timer jit-lock-defer-timer
-                   jit-lock-context-timer)
+                   jit-lock-context-timer jit-lock-background-timer)
                ;; Only if there's no other buffer using them.
                (not (catch 'found
                       (dolist (buf (buffer-list))
@@ -255,7 +284,10 @@ If you need to debug code run from jit-lock, see `jit-lock-debug-mode'."
         (setq jit-lock-context-timer nil))
       (when jit-lock-defer-timer
         (cancel-timer jit-lock-defer-timer)
-        (setq jit-lock-defer-timer nil)))
+        (setq jit-lock-defer-timer nil))
+      (when jit-lock-background-timer
+        (cancel-timer jit-lock-background-timer)
+        (setq jit-lock-background-timer nil)))
 
     ;; Remove hooks.
     (remove-hook 'after-change-functions 'jit-lock-after-change t)
@@ -328,17 +360,27 @@ Only applies to the current buffer."
 
 ;;; On demand fontification.
 
+(defsubst jit-lock-background-p ()
+  "Return non-nil if the current buffer is fontified in the background."
+  (and jit-lock-background-size
+       jit-lock-background-timer
+       (> (buffer-size) jit-lock-background-size)))
+
 (defun jit-lock-function (start)
   "Fontify current buffer starting at position START.
 This function is added to `fontification-functions' when `jit-lock-mode'
 is active."
   (when (and jit-lock-mode (not memory-full))
-    (if (null jit-lock-defer-timer)
+    (if (and (null jit-lock-defer-timer)
+	     (not (jit-lock-background-p)))
 	;; No deferral.
 	(jit-lock-fontify-now start (+ start jit-lock-chunk-size))
       ;; Record the buffer for later fontification.
-      (unless (memq (current-buffer) jit-lock-defer-buffers)
-	(push (current-buffer) jit-lock-defer-buffers))
+      (if (jit-lock-background-p)
+	  (unless (memq (current-buffer) jit-lock-background-buffers)
+	    (push (current-buffer) jit-lock-background-buffers))
+	(unless (memq (current-buffer) jit-lock-defer-buffers)
+	  (push (current-buffer) jit-lock-defer-buffers)))
       ;; Mark the area as defer-fontified so that the redisplay engine
       ;; is happy and so that the idle timer can find the places to fontify.
       (with-buffer-prepared-for-jit-lock
@@ -528,6 +570,51 @@ non-nil in a repeated invocation of this function."
 	(timer-activate-when-idle jit-lock-stealth-repeat-timer t)))))
 
 
+;;; Background fontification.
+
+(defun jit-lock-background-fontify ()
+  "Fontify the text of large buffers that redisplay deferred.
+This function is called each time Emacs becomes idle.  It fontifies
+the deferred text a chunk at a time, and stops as soon as input
+arrives; the interrupted chunk is deferred again, so that the rest
+is fontified the next time Emacs is idle."
+  (let ((interrupted nil))
+    (while (and jit-lock-background-buffers
+		(not interrupted)
+		(not memory-full))
+      (let ((buffer (car jit-lock-background-buffers)))
+	(when (buffer-live-p buffer)
+	  (with-current-buffer buffer
+	    (save-excursion
+	      (save-restriction
+		(widen)
+		(let ((pos (point-min))
+		      end)
+		  (while (and (not interrupted)
+			      (setq pos (text-property-any
+					 pos (point-max) 'fontified 'defer)))
+		    (setq end (next-single-property-change
+			       pos 'fontified nil
+			       (min (point-max) (+ pos jit-lock-chunk-size))))
+		    (with-buffer-prepared-for-jit-lock
+		     (put-text-property pos end 'fontified nil))
+		    (when (while-no-input
+			    (jit-lock-fontify-now pos end)
+			    nil)
+		      ;; Input arrived.  `jit-lock-fontify-now' may have
+		      ;; marked whole lines around the chunk fontified
+		      ;; before its functions were interrupted.
+		      (setq interrupted t)
+		      (with-buffer-prepared-for-jit-lock
+		       (put-text-property
+			(progn (goto-char pos) (line-beginning-position))
+			(progn (goto-char end) (line-beginning-position 2))
+			'fontified 'defer)))
+		    (setq pos end)))))))
+	(unless interrupted
+	  (setq jit-lock-background-buffers
+		(cdr jit-lock-background-buffers)))))))
+
 ;;; Deferred fontification.
 
 (defun jit-lock-deferred-fontify ()
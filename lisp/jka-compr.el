@@ -198,6 +198,41 @@ to keep: LEN chars starting BEG chars from the beginning."
     (delete-region start (+ start prefix))))
 
 
+(defvar jka-compr-zlib-chunk-size (* 256 1024)
+  "Number of compressed bytes to read at a time when uncompressing in Emacs.")
+
+(defun jka-compr-zlib-usable-p (info)
+  "Non-nil if files described by INFO can be uncompressed without a subprocess.
+That is so for gzip files when Emacs was built with zlib."
+  (and (equal (jka-compr-info-file-magic-bytes info) "\037\213")
+       (fboundp 'zlib-make-stream)
+       (zlib-available-p)))
+
+(defun jka-compr-zlib-uncompress (file)
+  "Insert the uncompressed contents of the gzip file FILE at point.
+FILE is read and uncompressed a chunk at a time, so that only one chunk
+of the compressed data is in memory at once."
+  (unless (file-exists-p file)
+    (signal 'file-error
+            (list "Opening input file" "No such file or directory" file)))
+  (let ((stream (zlib-make-stream 'decompress))
+        (output (current-buffer))
+        (offset 0))
+    (with-temp-buffer
+      (set-buffer-multibyte nil)
+      (while (progn
+               (erase-buffer)
+               (insert-file-contents-literally
+                file nil offset (+ offset jka-compr-zlib-chunk-size))
+               (> (buffer-size) 0))
+        (setq offset (+ offset (buffer-size)))
+        (let ((text (zlib-stream-feed stream (buffer-string))))
+          (with-current-buffer output
+            (insert text))))
+      (let ((text (zlib-stream-feed stream "" t)))
+        (with-current-buffer output
+          (insert text))))))
+
 (defun jka-compr-call-process (prog message infile output temp args)
   ;; call-process barfs if default-directory is inaccessible.
   (let ((default-directory
@@ -428,13 +463,15 @@ There should be no more than seven characters after the final `/'."
                       ;; really edit the buffer.
                       (let ((buffer-file-name
                              (if visit nil buffer-file-name)))
-                        (jka-compr-call-process uncompress-program
-                                                (concat uncompress-message
-                                                        " " base-name)
-                                                local-file
-                                                t
-                                                nil
-                                                uncompress-args)))
+                        (if (jka-compr-zlib-usable-p info)
+                            (jka-compr-zlib-uncompress local-file)
+                          (jka-compr-call-process uncompress-program
+                                                  (concat uncompress-message
+                                                          " " base-name)
+                                                  local-file
+                                                  t
+                                                  nil
+                                                  uncompress-args))))
                     (setq size (- (point) start))
                     (if replace
                         (delete-region (point) (point-max)))
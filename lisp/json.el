@@ -143,6 +143,16 @@ without indentation.")
                  'not-plist)))
   (null list))
 
+(defun json--plist-reverse (plist)
+  "Return a copy of PLIST with its key/value pairs in reverse order."
+  (let (res)
+    (while plist
+      (let ((prop (pop plist))
+            (val (pop plist)))
+        (push val res)
+        (push prop res)))
+    res))
+
 (defmacro json--with-indentation (body)
   `(let ((json--encoding-current-indentation
           (if json-encoding-pretty-print
@@ -401,7 +411,10 @@ Please see the documentation of `json-object-type' and `json-key-type'."
           (signal 'json-object-format (list "," (json-peek))))))
     ;; Skip over the "}"
     (json-advance)
-    elements))
+    ;; Keep the members of alists and plists in document order.
+    (cond ((eq json-object-type 'alist) (nreverse elements))
+          ((eq json-object-type 'plist) (json--plist-reverse elements))
+          (t elements))))
 
 ;; Hash table encoding
 
@@ -544,10 +557,28 @@ become JSON objects."
     table)
   "Readtable for JSON reader.")
 
+(defun json--native-p ()
+  "Non-nil if the C JSON functions can stand in for the Lisp code.
+They can if they exist and `json-key-type' is left to its default."
+  (and (fboundp 'json-parse-buffer)
+       (null json-key-type)
+       (memq json-object-type '(alist plist hash-table))))
+
 (defun json-read ()
   "Parse and return the JSON object following point.
 Advances point just past JSON object."
   (json-skip-whitespace)
+  (if (json--native-p)
+      (json-parse-buffer :object-type json-object-type
+                         :array-type (if (eq json-array-type 'list)
+                                         'list
+                                       'array)
+                         :null-object json-null
+                         :false-object json-false)
+    (json--read-1)))
+
+(defun json--read-1 ()
+  "Parse and return the JSON object following point, in Lisp."
   (let ((char (json-peek)))
     (if (not (eq char :json-eof))
         (let ((record (cdr (assq char json-readtable))))
@@ -578,6 +609,14 @@ Advances point just past JSON object."
 
 (defun json-encode (object)
   "Return a JSON representation of OBJECT as a string."
+  (if (and (fboundp 'json-serialize)
+           (not json-encoding-pretty-print)
+           (equal json-encoding-separator ","))
+      (json-serialize object :null-object json-null :false-object json-false)
+    (json--encode-1 object)))
+
+(defun json--encode-1 (object)
+  "Return a JSON representation of OBJECT as a string, in Lisp."
   (cond ((memq object (list t json-null json-false))
          (json-encode-keyword object))
         ((stringp object)      (json-encode-string object))
@@ -135,7 +135,7 @@ trust and key files, and priority string."
     (&rest spec
            &key process type hostname priority-string
            trustfiles crlfiles keylist min-prime-bits
-           verify-flags verify-error verify-hostname-error
+           verify-flags verify-error verify-hostname-error nowait
            &allow-other-keys)
   "Negotiate a SSL/TLS connection.  Returns proc.  Signals gnutls-error.
 
@@ -187,7 +187,12 @@ here's a recent version of the list.
     GNUTLS_VERIFY_DO_NOT_ALLOW_X509_V1_CA_CRT = 256
 
 It must be omitted, a number, or nil; if omitted or nil it
-defaults to GNUTLS_VERIFY_ALLOW_X509_V1_CA_CRT."
+defaults to GNUTLS_VERIFY_ALLOW_X509_V1_CA_CRT.
+
+If NOWAIT is non-nil, return without waiting for the handshake to
+finish.  The process sentinel is then called with \"TLS established\\n\"
+once the connection can be used, or with a string starting with
+\"TLS failed\" if the handshake or the verification failed."
   (let* ((type (or type 'gnutls-x509pki))
          (trustfiles (or trustfiles
                          (delq nil
@@ -233,13 +238,15 @@ defaults to GNUTLS_VERIFY_ALLOW_X509_V1_CA_CRT."
                              :keylist ,keylist
                              :verify-flags ,verify-flags
                              :verify-error ,verify-error
+                             :nowait ,nowait
                              :callbacks nil))
 
     (gnutls-message-maybe
      (setq ret (gnutls-boot process type params))
      "boot: %s" params)
 
-    (when (gnutls-errorp ret)
+    (when (and (gnutls-errorp ret)
+               (not (and nowait (eq ret 'gnutls-e-again))))
       ;; This is a error from the underlying C code.
       (signal 'gnutls-error (list process ret)))
 
@@ -886,6 +886,7 @@ of command line.")
     (make-auto-save-file-name . tramp-handle-make-auto-save-file-name)
     (make-directory . tramp-sh-handle-make-directory)
     (make-symbolic-link . tramp-sh-handle-make-symbolic-link)
+    (prefetch-file-attributes . tramp-sh-handle-prefetch-file-attributes)
     (process-file . tramp-sh-handle-process-file)
     (rename-file . tramp-sh-handle-rename-file)
     (set-file-acl . tramp-sh-handle-set-file-acl)
@@ -1623,17 +1624,19 @@ be non-negative integers."
 		     v localname
 		     (format "directory-files-and-attributes-%s" id-format)
 		   (save-excursion
-		     (mapcar
-		      (lambda (x)
-			(cons (car x)
-			      (tramp-convert-file-attributes v (cdr x))))
-		      (cond
-		       ((tramp-get-remote-stat v)
-			(tramp-do-directory-files-and-attributes-with-stat
-			 v localname id-format))
-		       ((tramp-get-remote-perl v)
-			(tramp-do-directory-files-and-attributes-with-perl
-			 v localname id-format)))))))))
+		     (tramp-sh-cache-file-attributes
+		      v localname id-format
+		      (mapcar
+		       (lambda (x)
+			 (cons (car x)
+			       (tramp-convert-file-attributes v (cdr x))))
+		       (cond
+			((tramp-get-remote-stat v)
+			 (tramp-do-directory-files-and-attributes-with-stat
+			  v localname id-format))
+			((tramp-get-remote-perl v)
+			 (tramp-do-directory-files-and-attributes-with-perl
+			  v localname id-format))))))))))
 	     result item)
 
 	(while temp
@@ -1647,6 +1650,84 @@ be non-negative integers."
 	    result
 	  (sort result (lambda (x y) (string< (car x) (car y)))))))))
 
+(defun tramp-sh-cache-file-attributes (vec directory id-format entries)
+  "Cache the attributes of the files in DIRECTORY from ENTRIES.
+ENTRIES is a list of (NAME . ATTRIBUTES), as returned by
+`directory-files-and-attributes' with ID-FORMAT.  This saves
+`file-attributes' and `file-exists-p' a round trip for each of the
+files, as long as `remote-file-name-inhibit-cache' allows.
+Return ENTRIES."
+  (dolist (entry entries entries)
+    (unless (member (car entry) '("." ".."))
+      (let ((localname (concat (file-name-as-directory directory)
+			       (car entry))))
+	(tramp-set-file-property
+	 vec localname (format "file-attributes-%s" id-format) (cdr entry))
+	(tramp-set-file-property vec localname "file-exists-p" t)))))
+
+(defvar tramp-sh-prefetch-batch-size 50
+  "Number of files whose attributes are asked for in one command.")
+
+(defun tramp-sh-handle-prefetch-file-attributes (files &optional id-format)
+  "Like `prefetch-file-attributes' for Tramp files."
+  (unless id-format (setq id-format 'integer))
+  (let (groups)
+    ;; Group the files not cached yet by connection.
+    (dolist (file files)
+      (with-parsed-tramp-file-name (expand-file-name file) nil
+	(when (eq (tramp-get-file-property
+		   v localname (format "file-attributes-%s" id-format) 'undef)
+		  'undef)
+	  (let* ((key (tramp-make-tramp-file-name method user host "" hop))
+		 (group (assoc key groups)))
+	    (if group
+		(push localname (cddr group))
+	      (push (list key v localname) groups))))))
+    (dolist (group groups)
+      (tramp-sh-prefetch-file-attributes
+       (nth 1 group) (nreverse (cddr group)) id-format))))
+
+(defun tramp-sh-prefetch-file-attributes (vec localnames id-format)
+  "Cache the attributes of the files LOCALNAMES on connection VEC.
+Ask for the attributes of `tramp-sh-prefetch-batch-size' files in
+each command, rather than sending a command for each file.  Do
+nothing if the remote host has no stat(1)."
+  (when (and localnames (tramp-get-remote-stat vec))
+    (tramp-message vec 5 "prefetch file attributes with stat: %s" localnames)
+    (while localnames
+      (let ((batch nil)
+	    attrs)
+	(while (and localnames
+		    (< (length batch) tramp-sh-prefetch-batch-size))
+	  (push (pop localnames) batch))
+	(setq batch (nreverse batch)
+	      attrs
+	      (tramp-send-command-and-read
+	       vec
+	       (format
+		(concat
+		 "echo \"(\"; for tramp_f in %s; do "
+		 "( (%s \"$tramp_f\" || %s -h \"$tramp_f\") && "
+		 "%s -c '((\"%%N\") %%h %s %s %%Xe0 %%Ye0 %%Ze0 %%se0 "
+		 "\"%%A\" t %%ie0 -1)' \"$tramp_f\" || echo nil); "
+		 "done; echo \")\"")
+		(mapconcat 'tramp-shell-quote-argument batch " ")
+		(tramp-get-file-exists-command vec)
+		(tramp-get-test-command vec)
+		(tramp-get-remote-stat vec)
+		(if (eq id-format 'integer) "%ue0" "\"%U\"")
+		(if (eq id-format 'integer) "%ge0" "\"%G\""))
+	       'noerror))
+	;; Cache nothing if the answer does not fit the question.
+	(when (and (listp attrs) (= (length attrs) (length batch)))
+	  (while batch
+	    (let ((localname (pop batch))
+		  (attr (tramp-convert-file-attributes vec (pop attrs))))
+	      (tramp-set-file-property
+	       vec localname (format "file-attributes-%s" id-format) attr)
+	      (tramp-set-file-property
+	       vec localname "file-exists-p" (not (null attr))))))))))
+
 (defun tramp-do-directory-files-and-attributes-with-perl
   (vec localname &optional id-format)
   "Implement `directory-files-and-attributes' for Tramp files using a Perl script."
@@ -2073,6 +2073,9 @@ ARGS are the arguments OPERATION has been called with."
     (when (processp (nth 0 args))
       (with-current-buffer (process-buffer (nth 0 args))
 	default-directory)))
+   ;; FILES.
+   ((eq operation 'prefetch-file-attributes)
+    (expand-file-name (car (nth 0 args))))
    ;; Unknown file primitive.
    (t (error "unknown file I/O primitive: %s" operation))))
 
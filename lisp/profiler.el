@@ -162,7 +162,8 @@ function name of a function itself."
                                 (:constructor profiler-make-profile))
   (tag 'profiler-profile)
   (version profiler-version)
-  ;; - `type' has a value indicating the kind of profile (`memory' or `cpu').
+  ;; - `type' has a value indicating the kind of profile (`memory',
+  ;;   `allocation' or `cpu').
   ;; - `log' indicates the profile log.
   ;; - `timestamp' has a value giving the time when the profile was obtained.
   ;; - `diff-p' indicates if this profile represents a diff between two profiles.
@@ -223,10 +224,14 @@ Optional argument MODE means only check for the specified mode (cpu or mem)."
      :log (profiler-cpu-log))))
 
 (defun profiler-memory-profile ()
-  "Return memory profile."
+  "Return memory profile.
+Its type is `allocation' if the memory profiler counts objects.
+See `profiler-memory-allocation-interval'."
   (when (profiler-memory-running-p)
     (profiler-make-profile
-     :type 'memory
+     :type (if (eq (profiler-memory-running-p) 'allocations)
+               'allocation
+             'memory)
      :timestamp (current-time)
      :log (profiler-memory-log))))
 
@@ -503,7 +508,8 @@ RET: expand or collapse"))
 	(count-percent (profiler-calltree-count-percent tree)))
     (profiler-format (cl-ecase (profiler-profile-type profiler-report-profile)
 		       (cpu profiler-report-cpu-line-format)
-		       (memory profiler-report-memory-line-format))
+		       ((memory allocation)
+			profiler-report-memory-line-format))
 		     name-part
 		     (if diff-p
 			 (list (if (> count 0)
@@ -591,7 +597,8 @@ RET: expand or collapse"))
 
 (defun profiler-report-make-buffer-name (profile)
   (format "*%s-Profiler-Report %s*"
-          (cl-ecase (profiler-profile-type profile) (cpu 'CPU) (memory 'Memory))
+          (cl-ecase (profiler-profile-type profile)
+            (cpu 'CPU) (memory 'Memory) (allocation 'Allocation))
           (format-time-string "%Y-%m-%d %T" (profiler-profile-timestamp profile))))
 
 (defun profiler-report-setup-buffer-1 (profile)
@@ -733,7 +740,11 @@ otherwise collapse."
 	    (memory
 	     (profiler-report-header-line-format
 	      profiler-report-memory-line-format
-	      "Function" (list "Bytes" "%")))))
+	      "Function" (list "Bytes" "%")))
+	    (allocation
+	     (profiler-report-header-line-format
+	      profiler-report-memory-line-format
+	      "Function" (list "Objects" "%")))))
     (let ((predicate (cl-ecase order
 		       (ascending #'profiler-calltree-count<)
 		       (descending #'profiler-calltree-count>))))
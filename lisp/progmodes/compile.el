@@ -585,6 +585,32 @@ Highlight entire line if t; don't highlight source lines if nil.")
 (defvar compilation-highlight-overlay nil
   "Overlay used to temporarily highlight compilation matches.")
 
+(defcustom compilation-parse-single-pass t
+  "If non-nil, search for all the error regexps at once.
+Each line of compilation output is then scanned once rather than once
+for each element of `compilation-error-regexp-alist', which is much
+faster with many elements.  The messages found are the same."
+  :type 'boolean
+  :group 'compilation
+  :version "24.5")
+
+(defcustom compilation-parse-visible-only t
+  "If non-nil, parse compilation output only when it is needed.
+Error messages are then parsed when they are displayed, or when
+\\[next-error] and similar commands look for them, rather than along
+with all the output before them.  This makes it quick to look at the
+end of a long log.  Directory changes are still parsed in order, so
+that the messages refer to the same files."
+  :type 'boolean
+  :group 'compilation
+  :version "24.5")
+
+(defvar compilation-parse-visible-slack 10000
+  "How far ahead of the parsed text displayed text is parsed in order.
+When `compilation-parse-visible-only' is non-nil, text displayed
+less than this many characters after the text parsed so far is
+parsed along with the text between, as if the option were nil.")
+
 (defcustom compilation-error-screen-columns t
   "If non-nil, column numbers in error messages are screen columns.
 Otherwise they are interpreted as character positions, with
@@ -1270,174 +1296,258 @@ FMTS is a list of format specs for transforming the file name.
     ;; we want to have it work even when font-lock is off, we'd then need to
     ;; use our own compilation-parsed text-property to keep track of the parts
     ;; that have already been parsed.
-    (goto-char start)
-    (while (re-search-forward (car compilation-directory-matcher)
-                              end t)
-      (compilation--flush-directory-cache (match-beginning 0) (match-end 0))
-      (when compilation-debug
-        (font-lock-append-text-property
-         (match-beginning 0) (match-end 0)
-         'compilation-debug
-         (vector 'directory compilation-directory-matcher)))
-      (dolist (elt (cdr compilation-directory-matcher))
-        (add-text-properties (match-beginning (car elt))
-                             (match-end (car elt))
-                             (compilation-directory-properties
-                              (car elt) (cdr elt)))))
-
+    (compilation--parse-directories start end)
     (compilation-parse-errors start end)))
 
+(defun compilation--parse-directories (start end)
+  "Parse the directory changes between START and END."
+  (goto-char start)
+  (while (re-search-forward (car compilation-directory-matcher)
+                            end t)
+    (compilation--flush-directory-cache (match-beginning 0) (match-end 0))
+    (when compilation-debug
+      (font-lock-append-text-property
+       (match-beginning 0) (match-end 0)
+       'compilation-debug
+       (vector 'directory compilation-directory-matcher)))
+    (dolist (elt (cdr compilation-directory-matcher))
+      (add-text-properties (match-beginning (car elt))
+                           (match-end (car elt))
+                           (compilation-directory-properties
+                            (car elt) (cdr elt))))))
+
 (defun compilation-parse-errors (start end &rest rules)
   "Parse errors between START and END.
 The errors recognized are the ones specified in RULES which default
 to `compilation-error-regexp-alist' if RULES is nil."
-  (dolist (item (or rules compilation-error-regexp-alist))
-    (if (symbolp item)
-        (setq item (cdr (assq item
-                              compilation-error-regexp-alist-alist))))
-    (let ((file (nth 1 item))
-          (line (nth 2 item))
-          (col (nth 3 item))
-          (type (nth 4 item))
-          (pat (car item))
-          end-line end-col fmt
-          props)
-
-      ;; omake reports some error indented, so skip the indentation.
-      ;; another solution is to modify (some?) regexps in
-      ;; `compilation-error-regexp-alist'.
-      ;; note that omake usage is not limited to ocaml and C (for stubs).
-      ;; FIXME-omake: Doing it here seems wrong, at least it should depend on
-      ;; whether or not omake's own error messages are recognized.
-      (cond
-       ((not (memq 'omake compilation-error-regexp-alist)) nil)
-       ((string-match "\\`\\([^^]\\|\\^\\( \\*\\|\\[\\)\\)" pat)
-        nil) ;; Not anchored or anchored but already allows empty spaces.
-       (t (setq pat (concat "^ *" (substring pat 1)))))
-
-      (if (consp file)	(setq fmt (cdr file)	  file (car file)))
-      (if (consp line)	(setq end-line (cdr line) line (car line)))
-      (if (consp col)	(setq end-col (cdr col)	  col (car col)))
-
-      (if (functionp line)
-          ;; The old compile.el had here an undocumented hook that
-          ;; allowed `line' to be a function that computed the actual
-          ;; error location.  Let's do our best.
-          (progn
-            (goto-char start)
-            (while (re-search-forward pat end t)
-              (save-match-data
-                (when compilation-debug
-                  (font-lock-append-text-property
-                   (match-beginning 0) (match-end 0)
-                   'compilation-debug (vector 'functionp item)))
-                (add-text-properties
-                 (match-beginning 0) (match-end 0)
-                 (compilation--compat-error-properties
-                  (funcall line (cons (match-string file)
-                                      (cons default-directory
-                                            (nthcdr 4 item)))
-                           (if col (match-string col))))))
-              (compilation--put-prop
-               file 'font-lock-face compilation-error-face)))
-
-        (unless (or (null (nth 5 item)) (integerp (nth 5 item)))
-          (error "HYPERLINK should be an integer: %s" (nth 5 item)))
-
-        (goto-char start)
-        (while (re-search-forward pat end t)
-          (when (setq props (compilation-error-properties
-                             file line end-line col end-col (or type 2) fmt))
-
-            (when (integerp file)
-              (compilation--put-prop
-               file 'font-lock-face
-               (if (consp type)
-                   (compilation-face type)
-                 (symbol-value (aref [compilation-info-face
-                                      compilation-warning-face
-                                      compilation-error-face]
-                                     (or type 2))))))
-
-            (compilation--put-prop
-             line 'font-lock-face compilation-line-face)
-            (compilation--put-prop
-             end-line 'font-lock-face compilation-line-face)
-
-            (compilation--put-prop
-             col 'font-lock-face compilation-column-face)
-            (compilation--put-prop
-             end-col 'font-lock-face compilation-column-face)
-
-	    ;; Obey HIGHLIGHT.
-            (dolist (extra-item (nthcdr 6 item))
-              (let ((mn (pop extra-item)))
-                (when (match-beginning mn)
-                  (let ((face (eval (car extra-item))))
-                    (cond
-                     ((null face))
-                     ((or (symbolp face) (stringp face))
-                      (put-text-property
-                       (match-beginning mn) (match-end mn)
-                       'font-lock-face face))
-		     ((and (listp face)
-			   (eq (car face) 'face)
-			   (or (symbolp (cadr face))
-			       (stringp (cadr face))))
-                      (compilation--put-prop mn 'font-lock-face (cadr face))
-                      (add-text-properties
-                       (match-beginning mn) (match-end mn)
-                       (nthcdr 2 face)))
-                     (t
-                      (error "Don't know how to handle face %S"
-                             face)))))))
-            (let ((mn (or (nth 5 item) 0)))
-              (when compilation-debug
-                (font-lock-append-text-property
-                 (match-beginning 0) (match-end 0)
-                 'compilation-debug (vector 'std item props)))
-              (add-text-properties
-               (match-beginning mn) (match-end mn)
-               (cddr props))
+  (let* ((items (mapcar (lambda (item)
+                          (if (symbolp item)
+                              (cdr (assq item
+                                         compilation-error-regexp-alist-alist))
+                            item))
+                        (or rules compilation-error-regexp-alist)))
+         (regexps (mapcar #'compilation--rule-regexp items)))
+    (if (and compilation-parse-single-pass (cdr items))
+        (compilation--parse-errors-single-pass start end items regexps)
+      (while items
+        (let ((item (pop items))
+              (pat (pop regexps)))
+          (goto-char start)
+          (while (re-search-forward pat end t)
+            (compilation--parse-match item)))))))
+
+(defun compilation--rule-regexp (item)
+  "Return the regexp to search for ITEM.
+ITEM is an element of `compilation-error-regexp-alist-alist'."
+  (let ((pat (car item)))
+    ;; omake reports some error indented, so skip the indentation.
+    ;; another solution is to modify (some?) regexps in
+    ;; `compilation-error-regexp-alist'.
+    ;; note that omake usage is not limited to ocaml and C (for stubs).
+    ;; FIXME-omake: Doing it here seems wrong, at least it should depend on
+    ;; whether or not omake's own error messages are recognized.
+    (cond
+     ((not (memq 'omake compilation-error-regexp-alist)) nil)
+     ((string-match "\\`\\([^^]\\|\\^\\( \\*\\|\\[\\)\\)" pat)
+      nil) ;; Not anchored or anchored but already allows empty spaces.
+     (t (setq pat (concat "^ *" (substring pat 1)))))
+
+    (let ((line (nth 2 item)))
+      (if (consp line) (setq line (car line)))
+      (unless (or (functionp line)
+                  (null (nth 5 item)) (integerp (nth 5 item)))
+        (error "HYPERLINK should be an integer: %s" (nth 5 item))))
+    pat))
+
+(defun compilation--parse-errors-single-pass (start end items regexps)
+  "Parse errors between START and END, scanning the text once.
+ITEMS are elements of `compilation-error-regexp-alist-alist', and
+REGEXPS the regexps to search for them.  All of REGEXPS are searched
+for at once, but the matches are handled rule by rule, as if each
+regexp had been searched for separately."
+  (let* ((items (vconcat items))
+         (regexps (vconcat regexps))
+         (cache (make-vector (length regexps) nil))
+         (matches (make-vector (length regexps) nil))
+         i)
+    (goto-char start)
+    (while (setq i (re-search-forward-multi regexps end cache))
+      (push (match-data t) (aref matches i)))
+    (dotimes (i (length items))
+      (dolist (data (nreverse (aref matches i)))
+        (set-match-data data)
+        (goto-char (match-end 0))
+        (compilation--parse-match (aref items i))))))
+
+(defun compilation--parse-match (item)
+  "Mark up the error message that the match data says ITEM matched.
+ITEM is an element of `compilation-error-regexp-alist-alist'."
+  (let ((file (nth 1 item))
+        (line (nth 2 item))
+        (col (nth 3 item))
+        (type (nth 4 item))
+        end-line end-col fmt
+        props)
+
+    (if (consp file)	(setq fmt (cdr file)	  file (car file)))
+    (if (consp line)	(setq end-line (cdr line) line (car line)))
+    (if (consp col)	(setq end-col (cdr col)	  col (car col)))
+
+    (if (functionp line)
+        ;; The old compile.el had here an undocumented hook that
+        ;; allowed `line' to be a function that computed the actual
+        ;; error location.  Let's do our best.
+        (progn
+          (save-match-data
+            (when compilation-debug
               (font-lock-append-text-property
-               (match-beginning mn) (match-end mn)
-               'font-lock-face (cadr props)))))))))
+               (match-beginning 0) (match-end 0)
+               'compilation-debug (vector 'functionp item)))
+            (add-text-properties
+             (match-beginning 0) (match-end 0)
+             (compilation--compat-error-properties
+              (funcall line (cons (match-string file)
+                                  (cons default-directory
+                                        (nthcdr 4 item)))
+                       (if col (match-string col))))))
+          (compilation--put-prop
+           file 'font-lock-face compilation-error-face))
+
+      (when (setq props (compilation-error-properties
+                         file line end-line col end-col (or type 2) fmt))
+
+        (when (integerp file)
+          (compilation--put-prop
+           file 'font-lock-face
+           (if (consp type)
+               (compilation-face type)
+             (symbol-value (aref [compilation-info-face
+                                  compilation-warning-face
+                                  compilation-error-face]
+                                 (or type 2))))))
+
+        (compilation--put-prop
+         line 'font-lock-face compilation-line-face)
+        (compilation--put-prop
+         end-line 'font-lock-face compilation-line-face)
+
+        (compilation--put-prop
+         col 'font-lock-face compilation-column-face)
+        (compilation--put-prop
+         end-col 'font-lock-face compilation-column-face)
+
+        ;; Obey HIGHLIGHT.
+        (dolist (extra-item (nthcdr 6 item))
+          (let ((mn (pop extra-item)))
+            (when (match-beginning mn)
+              (let ((face (eval (car extra-item))))
+                (cond
+                 ((null face))
+                 ((or (symbolp face) (stringp face))
+                  (put-text-property
+                   (match-beginning mn) (match-end mn)
+                   'font-lock-face face))
+                 ((and (listp face)
+                       (eq (car face) 'face)
+                       (or (symbolp (cadr face))
+                           (stringp (cadr face))))
+                  (compilation--put-prop mn 'font-lock-face (cadr face))
+                  (add-text-properties
+                   (match-beginning mn) (match-end mn)
+                   (nthcdr 2 face)))
+                 (t
+                  (error "Don't know how to handle face %S"
+                         face)))))))
+        (let ((mn (or (nth 5 item) 0)))
+          (when compilation-debug
+            (font-lock-append-text-property
+             (match-beginning 0) (match-end 0)
+             'compilation-debug (vector 'std item props)))
+          (add-text-properties
+           (match-beginning mn) (match-end mn)
+           (cddr props))
+          (font-lock-append-text-property
+           (match-beginning mn) (match-end mn)
+           'font-lock-face (cadr props)))))))
 
 (defvar compilation--parsed -1)
 (make-variable-buffer-local 'compilation--parsed)
 
+;; The text before this marker has had its directory changes parsed,
+;; either along with the rest of it or by `compilation--parse-visible'.
+(defvar compilation--parsed-directories nil)
+(make-variable-buffer-local 'compilation--parsed-directories)
+
+(defun compilation--init-parse ()
+  (unless (markerp compilation--parsed)
+    ;; We use a marker for compilation--parsed so that users (such as
+    ;; grep.el) don't need to flush-parse when they modify the buffer
+    ;; in a way that impacts buffer positions but does not require
+    ;; re-parsing.
+    (setq compilation--parsed (point-min-marker))
+    (setq compilation--parsed-directories (point-min-marker))))
+
+(defun compilation--parse-lines (start end)
+  "Parse the lines from the one of START to END, a line beginning.
+Parsing starts earlier if START is within a multiline message."
+  (goto-char start)
+  (forward-line 0)  ;Not line-beginning-position: ignore (comint) fields.
+  (while (and (not (bobp))
+              (get-text-property (1- (point)) 'compilation-multiline))
+    (forward-line -1))
+  (with-silent-modifications
+    (compilation--parse-region (point) end)))
+
 (defun compilation--ensure-parse (limit)
   "Make sure the text has been parsed up to LIMIT."
   (save-excursion
     (goto-char limit)
     (setq limit (line-beginning-position 2))
-    (unless (markerp compilation--parsed)
-      ;; We use a marker for compilation--parsed so that users (such as
-      ;; grep.el) don't need to flush-parse when they modify the buffer
-      ;; in a way that impacts buffer positions but does not require
-      ;; re-parsing.
-      (setq compilation--parsed (point-min-marker)))
+    (compilation--init-parse)
     (when (< compilation--parsed limit)
       (let ((start (max compilation--parsed (point-min))))
         (move-marker compilation--parsed limit)
-        (goto-char start)
-        (forward-line 0)  ;Not line-beginning-position: ignore (comint) fields.
-        (while (and (not (bobp))
-                    (get-text-property (1- (point)) 'compilation-multiline))
-          (forward-line -1))
-        (with-silent-modifications
-          (compilation--parse-region (point) compilation--parsed)))))
+        (compilation--parse-lines start limit)
+        (if (< compilation--parsed-directories compilation--parsed)
+            (move-marker compilation--parsed-directories
+                         compilation--parsed)))))
+  nil)
+
+(defun compilation--parse-visible (limit)
+  "Parse the text from point to LIMIT, which font-lock is about to show.
+If `compilation-parse-visible-only' is non-nil and much of the text
+before point has not been parsed yet, parse only its directory changes,
+which the messages from point on need, and leave the rest of it for
+when it is shown or \\[next-error] gets to it.  The text from point
+to LIMIT is parsed again, in order, when \\[next-error] gets there."
+  (compilation--init-parse)
+  (if (or (not compilation-parse-visible-only)
+          (< (point) (+ compilation--parsed compilation-parse-visible-slack)))
+      (compilation--ensure-parse limit)
+    (save-excursion
+      (let ((start (line-beginning-position)))
+        (goto-char limit)
+        (setq limit (line-beginning-position 2))
+        (when (< compilation--parsed-directories start)
+          (with-silent-modifications
+            (compilation--parse-directories compilation--parsed-directories
+                                            start)))
+        (compilation--parse-lines start limit)
+        (if (< compilation--parsed-directories limit)
+            (move-marker compilation--parsed-directories limit)))))
   nil)
 
 (defun compilation--flush-parse (start _end)
   "Mark the region between START and END for re-parsing."
-  (if (markerp compilation--parsed)
-      (move-marker compilation--parsed (min start compilation--parsed))))
+  (when (markerp compilation--parsed)
+    (move-marker compilation--parsed (min start compilation--parsed))
+    (move-marker compilation--parsed-directories
+                 (min start compilation--parsed-directories))))
 
 (defun compilation-mode-font-lock-keywords ()
   "Return expressions to highlight in Compilation mode."
   (append
-   '((compilation--ensure-parse))
+   '((compilation--parse-visible))
    compilation-mode-font-lock-keywords))
 
 (defun compilation-read-command (command)
@@ -2077,6 +2187,7 @@ Optional argument MINOR indicates this is called from
   (font-lock-remove-keywords nil (compilation-mode-font-lock-keywords))
   (remove-hook 'before-change-functions 'compilation--flush-parse t)
   (kill-local-variable 'compilation--parsed)
+  (kill-local-variable 'compilation--parsed-directories)
   (compilation--remove-properties)
   (font-lock-flush))
 
@@ -247,6 +247,12 @@ One argument, the tag info returned by `snarf-tag-function'.")
   "Tag order passed to `find-tag-in-order' for finding a tag.")
 (defvar find-tag-next-line-after-failure-p nil
   "Flag passed to `find-tag-in-order' for finding a tag.")
+(defvar find-tag-index-function nil
+  "Function to find the tag lines that may match a tag, or nil.
+Two arguments, the tag as passed to `find-tag-in-order' and the
+member of the tag order being tried.  The value is a list of the
+positions of those tag lines, which `find-tag-in-order' then tries
+instead of searching the whole tags table, or t to search it.")
 (defvar list-tags-function nil
   "Function to do the work of `list-tags' (which see).")
 (defvar tags-apropos-function nil
@@ -1130,15 +1136,28 @@ error message."
 
 	  ;; Iterate over the list of ordering predicates.
 	  (while order
-	    (while (funcall search-forward-func pattern nil t)
-	      ;; Naive match found.  Qualify the match.
-	      (and (funcall (car order) pattern)
-		   ;; Make sure it is not a previous qualified match.
-		   (not (member (set-marker match-marker (point-at-bol))
-				tag-lines-already-matched))
-		   (throw 'qualified-match-found nil))
-	      (if next-line-after-failure-p
-		  (forward-line 1)))
+	    (let ((lines (if find-tag-index-function
+			     (funcall find-tag-index-function pattern (car order))
+			   t)))
+	      (if (eq lines t)
+		  (while (funcall search-forward-func pattern nil t)
+		    ;; Naive match found.  Qualify the match.
+		    (and (funcall (car order) pattern)
+			 ;; Make sure it is not a previous qualified match.
+			 (not (member (set-marker match-marker (point-at-bol))
+				      tag-lines-already-matched))
+			 (throw 'qualified-match-found nil))
+		    (if next-line-after-failure-p
+			(forward-line 1)))
+		;; The index gave us the only lines that can match.
+		(dolist (line lines)
+		  (goto-char line)
+		  (while (funcall search-forward-func pattern
+				  (line-end-position) t)
+		    (and (funcall (car order) pattern)
+			 (not (member (set-marker match-marker (point-at-bol))
+				      tag-lines-already-matched))
+			 (throw 'qualified-match-found nil))))))
 	    ;; Try the next flavor of match.
 	    (setq order (cdr order))
 	    (goto-char (point-min)))
@@ -1247,6 +1266,7 @@ buffer-local values of tags table format variables."
 				      tag-partial-file-name-match-p
 				      tag-any-match-p))
 	       (find-tag-next-line-after-failure-p . nil)
+	       (find-tag-index-function . etags-find-tag-index)
 	       (list-tags-function . etags-list-tags)
 	       (tags-apropos-function . etags-tags-apropos)
 	       (tags-included-tables-function . etags-tags-included-tables)
@@ -1269,6 +1289,10 @@ buffer-local values of tags table format variables."
 
 
 (defun etags-tags-completion-table () ; Doc string?
+  (or (etags-index-completion-table)
+      (etags-tags-completion-table-1)))
+
+(defun etags-tags-completion-table-1 ()
   (let ((table (make-vector 511 0))
 	(progress-reporter
 	 (make-progress-reporter
@@ -1298,6 +1322,114 @@ buffer-local values of tags table format variables."
 		table)))
     table))
 
+
+;; The index of a TAGS file, written by "etags --index" as TAGS.idx,
+;; has a line "FOLDED\177NAME\177OFFSET" for each tag, sorted by FOLDED,
+;; the tag name in lower case.  OFFSET is the byte offset of the tag
+;; line in TAGS.  Bisecting it finds the tag lines for a name without
+;; reading the whole index, let alone searching all of TAGS.
+
+(defconst etags-index-chunk-size 4096
+  "Number of bytes of a tags index to read at a time.")
+
+(defun etags-index-file ()
+  "Return the index of the current tags table buffer, or nil.
+The index is used only if it is not older than the tags table and
+the buffer holds the bytes of the file, so that the offsets in the
+index are valid in the buffer."
+  (let ((index (and buffer-file-name (concat buffer-file-name ".idx"))))
+    (and index
+	 (file-exists-p index)
+	 (not (file-newer-than-file-p buffer-file-name index))
+	 (not (buffer-modified-p))
+	 (eql (1- (position-bytes (1+ (buffer-size))))
+	      (nth 7 (file-attributes buffer-file-name)))
+	 index)))
+
+(defun etags-index-lookup (index key)
+  "Return the offsets of the tag lines for KEY listed in INDEX.
+KEY is a tag name in lower case.  Return t if INDEX is not usable."
+  (let ((size (nth 7 (file-attributes index)))
+	(lo 0)
+	hi base offsets)
+    (setq hi size)
+    (with-temp-buffer
+      (set-buffer-multibyte nil)
+      (catch 'etags-index-lookup
+	;; Every line starting before LO is for a name less than KEY,
+	;; and every line starting at or after HI is for a name not less
+	;; than KEY.
+	(while (> (- hi lo) etags-index-chunk-size)
+	  (let ((mid (/ (+ lo hi) 2)))
+	    (erase-buffer)
+	    (insert-file-contents-literally
+	     index nil (1- mid) (min size (+ mid etags-index-chunk-size)))
+	    (unless (search-forward "\n" nil t)
+	      (throw 'etags-index-lookup t))
+	    (let ((start (+ mid (point) -2)))
+	      (cond
+	       ((>= start hi) (setq hi mid))
+	       ((not (looking-at "\\([^\177\n]*\\)\177"))
+		(throw 'etags-index-lookup t))
+	       ((string< (match-string 1) key) (setq lo (1+ start)))
+	       (t (setq hi start))))))
+	;; Now collect the lines for KEY, from the first one starting at
+	;; or after LO.
+	(setq base (max 0 (1- lo)))
+	(erase-buffer)
+	(insert-file-contents-literally
+	 index nil base (min size (+ base (* 2 etags-index-chunk-size))))
+	(or (zerop lo) (search-forward "\n" nil t))
+	(while (progn
+		 (unless (or (save-excursion (search-forward "\n" nil t))
+			     (>= (+ base (buffer-size)) size))
+		   ;; Read the next lines.
+		   (setq base (+ base (point) -1))
+		   (erase-buffer)
+		   (insert-file-contents-literally
+		    index nil base
+		    (min size (+ base (* 2 etags-index-chunk-size)))))
+		 (looking-at "\\([^\177\n]*\\)\177[^\177\n]*\177\\([0-9]+\\)\n"))
+	  (cond
+	   ((string< (match-string 1) key)
+	    (goto-char (match-end 0)))
+	   ((string= (match-string 1) key)
+	    (push (string-to-number (match-string 2)) offsets)
+	    (goto-char (match-end 0)))
+	   (t (goto-char (point-max)))))
+	(nreverse offsets)))))
+
+(defun etags-find-tag-index (tag order)
+  "Return the positions of the lines that may be tags named TAG.
+Use the index of the current tags table if there is one, and if
+ORDER looks for tags with that exact name; otherwise return t.
+This is the value of `find-tag-index-function' for etags."
+  (let ((index (and (memq order '(tag-exact-match-p tag-implicit-name-match-p))
+		    (string-match "\\`[[:ascii:]]+\\'" tag)
+		    (etags-index-file))))
+    (if (not index)
+	t
+      (let ((offsets (etags-index-lookup index (downcase tag))))
+	(if (eq offsets t)
+	    t
+	  (mapcar (lambda (offset) (byte-to-position (1+ offset)))
+		  offsets))))))
+
+(defun etags-index-completion-table ()
+  "Return a tags completion table made from the tags index, or nil."
+  (let ((index (etags-index-file))
+	(table (make-vector 511 0)))
+    (when index
+      (with-temp-buffer
+	(let ((coding-system-for-read 'utf-8-emacs-unix))
+	  (insert-file-contents index))
+	(while (search-forward "\177" nil t)
+	  (let ((start (point)))
+	    (when (search-forward "\177" (line-end-position) t)
+	      (intern (buffer-substring start (1- (point))) table))
+	    (forward-line 1))))
+      table)))
+
 (defun etags-snarf-tag (&optional use-explicit) ; Doc string?
   (let (tag-text line startpos explicit-start)
     (if (save-excursion
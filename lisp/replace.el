@@ -903,18 +903,11 @@ a previously found match."
 	(setq rstart (point)
 	      rend (point-max)))
       (goto-char rstart))
-    (let ((count 0)
-	  opoint
-	  (case-fold-search
-	   (if (and case-fold-search search-upper-case)
-	       (isearch-no-upper-case-p regexp t)
-	     case-fold-search)))
-      (while (and (< (point) rend)
-		  (progn (setq opoint (point))
-			 (re-search-forward regexp rend t)))
-	(if (= opoint (point))
-	    (forward-char 1)
-	  (setq count (1+ count))))
+    (let* ((case-fold-search
+	    (if (and case-fold-search search-upper-case)
+		(isearch-no-upper-case-p regexp t)
+	      case-fold-search))
+	   (count (/ (length (re-search-forward-all regexp rend)) 2)))
       (when interactive (message "%d occurrence%s"
 				 count
 				 (if (= count 1) "" "s")))
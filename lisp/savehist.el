@@ -80,6 +80,16 @@ minibuffer histories, such as `compile-command' or `kill-ring'."
   :type '(repeat variable)
   :group 'savehist)
 
+(defcustom savehist-save-serialized nil
+  "If non-nil, save histories in a compact binary form.
+Such histories are saved and loaded much faster than histories printed
+as Lisp.  A history that `serialize-object' cannot handle is printed
+as usual.  The history file cannot be loaded by Emacs versions without
+`deserialize-object'."
+  :type 'boolean
+  :version "24.5"
+  :group 'savehist)
+
 (defcustom savehist-ignored-variables nil ;; '(command-history)
   "List of additional variables not to save."
   :type '(repeat variable)
@@ -288,9 +298,17 @@ If AUTO-SAVE is non-nil, compare the saved contents to the one last saved,
 	(dolist (symbol savehist-minibuffer-history-variables)
 	  (when (and (boundp symbol)
 		     (not (memq symbol savehist-ignored-variables)))
-	    (let ((value (savehist-trim-history (symbol-value symbol)))
-		  excess-space)
-	      (when value		; Don't save empty histories.
+	    (let* ((value (savehist-trim-history (symbol-value symbol)))
+		   (data (and value savehist-save-serialized
+			      (ignore-errors (serialize-object value))))
+		   excess-space)
+	      (cond
+	       (data
+		(insert "(setq ")
+		(prin1 symbol (current-buffer))
+		(insert " (deserialize-object (base64-decode-string \""
+			(base64-encode-string data t) "\")))\n"))
+	       (value		; Don't save empty histories.
 		(insert "(setq ")
 		(prin1 symbol (current-buffer))
 		(insert " '(")
@@ -322,7 +340,7 @@ If AUTO-SAVE is non-nil, compare the saved contents to the one last saved,
 		  (goto-char excess-space)
 		  (if (eq (following-char) ?\s)
 		      (delete-region (point) (1+ (point)))))
-		(insert "))\n"))))))
+		(insert "))\n")))))))
       ;; Save the additional variables.
       (dolist (symbol savehist-additional-variables)
 	(when (boundp symbol)
@@ -91,9 +91,12 @@ all upper-case names.  The most often used ones, in addition to
 DATA-TYPE is usually `STRING', but can also be one of the symbols
 in `selection-converter-alist', which see.  This argument is
 ignored on MS-Windows and MS-DOS."
-  (let ((data (x-get-selection-internal (or type 'PRIMARY)
-					(or data-type 'STRING)))
-	coding)
+  (x--decode-selection (x-get-selection-internal (or type 'PRIMARY)
+						  (or data-type 'STRING))))
+
+(defun x--decode-selection (data)
+  "Decode DATA, the value of a selection, as `x-get-selection' does."
+  (let (coding data-type)
     (when (and (stringp data)
 	       (setq data-type (get-text-property 0 'foreign-selection data)))
       (setq coding (or next-selection-coding-system
@@ -107,13 +110,48 @@ ignored on MS-Windows and MS-DOS."
 			     ((eq data-type 'STRING)
 			      'iso-8859-1)
 			     (t
-			      (error "Unknown selection data type: %S" type))))
+			      (error "Unknown selection data type: %S"
+				     data-type))))
 	    data (if coding (decode-coding-string data coding)
 		   (string-to-multibyte data)))
       (setq next-selection-coding-system nil)
       (put-text-property 0 (length data) 'foreign-selection data-type data))
     data))
 
+(defvar x-selection-timeout)
+(declare-function x-request-selection-internal "xselect.c"
+		  (selection-symbol target-type callback
+				    &optional time-stamp terminal))
+
+(defun x-get-selection-async (callback &optional type data-type)
+  "Retrieve the value of an X Windows selection without waiting for it.
+Return at once, and call CALLBACK with the value, decoded as
+`x-get-selection' does, once it has arrived.  If the selection
+cannot be converted, or its owner does not answer within
+`x-selection-timeout' milliseconds, call CALLBACK with nil instead.
+Large selections arrive in chunks while Emacs goes on with other work.
+
+TYPE and DATA-TYPE are as for `x-get-selection'."
+  ;; STATE is (DONE CALLBACK TIMER).
+  (let ((state (list nil callback nil)))
+    (when (> x-selection-timeout 0)
+      (setcar (cddr state)
+	      (run-at-time (/ x-selection-timeout 1000.0) nil
+			   #'x--get-selection-async-finish state nil)))
+    (x-request-selection-internal
+     (or type 'PRIMARY) (or data-type 'STRING)
+     (apply-partially #'x--get-selection-async-finish state))
+    nil))
+
+(defun x--get-selection-async-finish (state data)
+  "Call the callback in STATE of `x-get-selection-async' with DATA.
+Do nothing if it has been called already."
+  (unless (car state)
+    (setcar state t)
+    (when (nth 2 state)
+      (cancel-timer (nth 2 state)))
+    (funcall (nth 1 state) (x--decode-selection data))))
+
 (defun x-get-clipboard ()
   "Return text pasted to the clipboard."
   (x-get-selection-internal 'CLIPBOARD 'STRING))
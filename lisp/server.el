@@ -765,6 +765,53 @@ Server mode runs a process that accepts commands from the
                        (point-min) (point-max))))
             (server-reply-print (server-quote-arg text) proc)))))))
 
+(defun server-process-stream (proc string)
+  "Evaluate the requests in STRING, sent by PROC after `-stream'.
+Each request is LENGTH:EXPR followed by a newline, where LENGTH is
+the number of bytes in EXPR.  Each is answered, in order, with
+=LENGTH:VALUE or !LENGTH:MESSAGE followed by a newline, VALUE being
+the printed value of EXPR and MESSAGE the message of the error it
+signaled.  An incomplete request is kept for the next call."
+  (let ((coding-system (and (default-value 'enable-multibyte-characters)
+                            (or file-name-coding-system
+                                default-file-name-coding-system)))
+        (dir (process-get proc 'server-client-directory))
+        (start 0))
+    (with-current-buffer (get-buffer-create server-buffer)
+      (let ((default-directory
+              (if (and dir (file-directory-p dir)) dir default-directory)))
+        (while (and (eq (string-match "\\([0-9]+\\):" string start) start)
+                    (< (+ (match-end 0)
+                          (string-to-number (match-string 1 string)))
+                       (length string)))
+          (let* ((beg (match-end 0))
+                 (end (+ beg (string-to-number (match-string 1 string))))
+                 (expr (substring string beg end)))
+            (unless (eq (aref string end) ?\n)
+              (error "Malformed stream request"))
+            (setq start (1+ end))
+            (if coding-system
+                (setq expr (decode-coding-string expr coding-system)))
+            (server-stream-reply proc expr coding-system)))))
+    (unless (eq (string-match "[0-9]*\\(?::\\|\\'\\)" string start) start)
+      (error "Malformed stream request"))
+    (when (< start (length string))
+      (process-put proc 'previous-string (substring string start)))))
+
+(defun server-stream-reply (proc expr coding-system)
+  "Eval EXPR and send the result back to stream client PROC.
+CODING-SYSTEM, if non-nil, encodes the reply."
+  (let* ((reply (condition-case err
+                    (concat "=" (prin1-to-string
+                                 (with-local-quit
+                                   (eval (car (read-from-string expr))))))
+                  (error (concat "!" (error-message-string err)))))
+         (text (encode-coding-string (substring reply 1)
+                                     (or coding-system 'utf-8-unix))))
+    (server-send-string proc (concat (substring reply 0 1)
+                                     (number-to-string (length text))
+                                     ":" text "\n"))))
+
 (defconst server-msg-size 1024
   "Maximum size of a message sent to a client.")
 
@@ -980,6 +1027,13 @@ The following commands are accepted by the server:
   Do nothing, but put the comment in the server log.
   Useful for debugging.
 
+`-stream'
+  Keep the connection open and treat everything the client sends
+  after this line as a stream of expressions to evaluate, framed
+  by length.  The client can send the next expression without
+  waiting for the value of the previous one.  See
+  `server-process-stream'.
+
 
 The following commands are accepted by the client:
 
@@ -1028,6 +1082,11 @@ The following commands are accepted by the client:
     (when prev
       (setq string (concat prev string))
       (process-put proc 'previous-string nil)))
+  (when (process-get proc 'server-stream)
+    (condition-case err
+        (server-process-stream proc string)
+      (error (server-return-error proc err)))
+    (cl-return-from server-process-filter))
   (condition-case err
       (progn
 	(server-add-client proc)
@@ -1039,10 +1098,6 @@ The following commands are accepted by the client:
             (when (> (length string) 0)
               (process-put proc 'previous-string string))
 
-          ;; In earlier versions of server.el (where we used an `emacsserver'
-          ;; process), there could be multiple lines.  Nowadays this is not
-          ;; supported any more.
-          (cl-assert (eq (match-end 0) (length string)))
 	  (let ((request (substring string 0 (match-beginning 0)))
 		(coding-system (and (default-value 'enable-multibyte-characters)
 				    (or file-name-coding-system
@@ -1060,6 +1115,7 @@ The following commands are accepted by the client:
 		tty-type   ; string.
 		files
 		filepos
+		stream     ; t if the client sends expressions after this line.
 		args-left)
 	    ;; Remove this line from STRING.
 	    (setq string (substring string (match-end 0)))
@@ -1177,6 +1233,9 @@ The following commands are accepted by the client:
                          commands)
                    (setq filepos nil)))
 
+                ;; -stream:  Evaluate the expressions that follow.
+                (`"-stream" (setq stream t))
+
                 ;; -env NAME=VALUE:  An environment variable.
                 (`"-env"
                  (let ((var (pop args-left)))
@@ -1195,6 +1254,15 @@ The following commands are accepted by the client:
                 ;; Unknown command.
                 (arg (error "Unknown command: %s" arg))))
 
+	    ;; In earlier versions of server.el (where we used an
+	    ;; `emacsserver' process), there could be multiple lines.
+	    ;; Nowadays only the requests of a stream may follow.
+	    (cl-assert (or stream (equal string "")))
+	    (when stream
+	      (process-put proc 'server-stream t)
+	      (server-process-stream proc string)
+	      (cl-return-from server-process-filter))
+
 	    ;; If both -no-wait and -tty are given with file or sexp
 	    ;; arguments, use an existing frame.
 	    (and nowait
@@ -364,6 +364,17 @@ encountered an error during printing.  Otherwise nil.")
   "Time when current operation started.  Used by `ses-time-check' to decide
 when to emit a progress message.")
 
+(defvar ses--deferred-print nil
+  "Hash table of the (ROW . COL) of cells to print, or nil.
+While `ses-update-cells' binds this, `ses-calculate-cell' records cells
+here rather than printing them, so that they are printed in buffer
+order once all are calculated.")
+
+(defvar ses--print-cursor nil
+  "A cons (ROW . MARKER) of a row and the start of its print line, or nil.
+While this is bound, `ses-goto-print' moves forward from there to rows
+that are not before ROW, rather than from the beginning of the buffer.")
+
 
 ;;----------------------------------------------------------------------------
 ;; Macros
@@ -993,7 +1004,9 @@ the old and FORCE is nil."
 				  `(error ,(format "Found cycle on cells %S"
 						   (ses-cell-symbol cell)))
 				  cycle-error formula-error)))))))
-    (setq printer-error (ses-print-cell row col))
+    (if ses--deferred-print
+	(puthash (cons row col) t ses--deferred-print)
+      (setq printer-error (ses-print-cell row col)))
     (or
      (and cycle-error
 	  (error (error-message-string cycle-error)))
@@ -1014,6 +1027,106 @@ the old and FORCE is nil."
   "Recalculate cells in LIST, checking for dependency loops.  Prints
 progress messages every second.  Dependent cells are not recalculated
 if the cell's value is unchanged and FORCE is nil."
+  (let ((order (ses-recalculation-order list)))
+    (if (eq order 'cycle)
+	(ses-update-cells-by-passes list force)
+      (ses-update-cells-in-order order list force))))
+
+(defun ses-cell-dependents (sym)
+  "Return the symbols of the cells whose formulas refer to cell SYM."
+  (let ((rowcol (ses-sym-rowcol sym)))
+    (ses-cell-references (car rowcol) (cdr rowcol))))
+
+(defun ses-recalculation-order (list)
+  "Return the cells in LIST and the cells that depend on them, in order.
+Every cell comes after the cells that its formula refers to, so a
+single pass in this order recalculates each cell at most once.  The
+result is `cycle' if some of these cells depend on themselves."
+  (let ((state (make-hash-table :test 'eq))
+	order)
+    ;; A depth-first search of the dependents, which pushes each cell
+    ;; after all its dependents.  The stack holds each cell being
+    ;; visited with its dependents left to visit.
+    (catch 'cycle
+      (dolist (root list)
+	(unless (gethash root state)
+	  (puthash root 'visiting state)
+	  (let ((stack (list (cons root (ses-cell-dependents root)))))
+	    (while stack
+	      (let ((frame (car stack)))
+		(if (null (cdr frame))
+		    (progn
+		      (puthash (car frame) 'done state)
+		      (push (car frame) order)
+		      (pop stack))
+		  (let* ((next (pop (cdr frame)))
+			 (next-state (gethash next state)))
+		    (cond
+		     ((eq next-state 'visiting)
+		      (throw 'cycle 'cycle))
+		     ((null next-state)
+		      (puthash next 'visiting state)
+		      (push (cons next (ses-cell-dependents next)) stack))))))))))
+      order)))
+
+(defun ses-update-cells-in-order (order list force)
+  "Recalculate the cells of ORDER that are in LIST or need it.
+ORDER is as returned by `ses-recalculation-order' for LIST.  A cell
+needs recalculation when a cell that it refers to has changed, or
+FORCE is non-nil.  The cells are printed when all are calculated."
+  (let ((dirty (make-hash-table :test 'eq))
+	(left (length order))
+	(pos (point))
+	(ses--deferred-print (make-hash-table :test 'equal)))
+    (dolist (sym list)
+      (puthash sym t dirty))
+    (setq ses-start-time (float-time))
+    (with-temp-message " "
+      (unwind-protect
+	  (dolist (sym order)
+	    (when (gethash sym dirty)
+	      (ses-time-check "Recalculating... (%d cells left)" left)
+	      ;; ses-update-cells is called from post-command-hook, so
+	      ;; inhibit-quit is implicitly bound to t.
+	      (when quit-flag
+		;; Abort the recalculation.  User will probably undo now.
+		(error "Quit"))
+	      ;; ses-calculate-cell queues the dependents of a cell whose
+	      ;; value changed.
+	      (let ((rowcol (ses-sym-rowcol sym))
+		    (ses--deferred-recalc nil))
+		(ses-calculate-cell (car rowcol) (cdr rowcol) force)
+		(dolist (ref ses--deferred-recalc)
+		  (puthash ref t dirty))))
+	    (setq left (1- left)))
+	(let ((cells nil))
+	  (maphash (lambda (rowcol _) (push rowcol cells)) ses--deferred-print)
+	  (setq ses--deferred-print nil)
+	  (ses-print-cells
+	   (sort cells (lambda (a b)
+			 (or (< (car a) (car b))
+			     (and (= (car a) (car b))
+				  (< (cdr a) (cdr b)))))))))
+      (message " "))
+    ;; Can't use save-excursion here: if the cell under point is updated,
+    ;; save-excursion's marker will move past the cell.
+    (goto-char pos)))
+
+(defun ses-print-cells (cells)
+  "Print CELLS, a list of (ROW . COL) sorted in buffer order.
+This moves from one cell to the next instead of starting from the
+beginning of the buffer for each.  Result is nil."
+  (let ((ses--print-cursor (cons 0 (copy-marker (point-min)))))
+    (unwind-protect
+	(dolist (rowcol cells)
+	  (ses-print-cell (car rowcol) (cdr rowcol)))
+      (set-marker (cdr ses--print-cursor) nil))
+    nil))
+
+(defun ses-update-cells-by-passes (list &optional force)
+  "Recalculate cells in LIST in passes, as `ses-update-cells' does.
+In each pass, recalculate the cells whose formulas refer only to cells
+that are done.  This copes with circular references, which it reports."
   (let ((ses--deferred-recalc list)
 	(nextlist             list)
 	(pos		      (point))
@@ -1082,8 +1195,15 @@ if the cell's value is unchanged and FORCE is nil."
   "Move point to print area for cell (ROW,COL)."
   (let ((inhibit-point-motion-hooks t)
 	(n 0))
-    (goto-char (point-min))
-    (forward-line row)
+    (if (and ses--print-cursor (>= row (car ses--print-cursor)))
+	(progn
+	  (goto-char (cdr ses--print-cursor))
+	  (forward-line (- row (car ses--print-cursor))))
+      (goto-char (point-min))
+      (forward-line row))
+    (when ses--print-cursor
+      (setcar ses--print-cursor row)
+      (set-marker (cdr ses--print-cursor) (point)))
     ;; Calculate column position.
     (dotimes (c col)
       (setq n (+ n (ses-col-width c) 1)))
@@ -547,10 +547,11 @@ buffer."
   (shell-dirtrack-mode 1)
 
   ;; By default, ansi-color applies faces using overlays.  This is
-  ;; very inefficient in Shell buffers (e.g. Bug#10835).  We use a
-  ;; custom `ansi-color-apply-face-function' to convert color escape
-  ;; sequences into `font-lock-face' properties.
+  ;; very inefficient in Shell buffers (e.g. Bug#10835).  We convert
+  ;; color escape sequences into `font-lock-face' properties instead,
+  ;; as `shell-apply-ansi-color' does, but for all the output at once.
   (setq-local ansi-color-apply-face-function #'shell-apply-ansi-color)
+  (setq-local ansi-color-face-properties '(ansi-color-face font-lock-face))
   (shell-reapply-ansi-color)
 
   ;; This is not really correct, since the shell buffer does not really
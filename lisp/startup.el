@@ -538,6 +538,9 @@ It is the default value of the variable `top-level'."
 	    eol-mnemonic-mac  "(Mac)")))
 
     (set-locale-environment nil)
+    ;; These are consulted for each character displayed or measured.
+    (mapc #'freeze-char-table
+          (list char-width-table char-script-table printable-chars))
     ;; Decode all default-directory's (probably, only *scratch* exists
     ;; at this point).  default-directory of *scratch* is the basis
     ;; for many other file-name variables and directory lists, so it
@@ -1011,7 +1011,22 @@ might need to be approximated if it is not supported directly."
        (let ((color (tty-color-canonicalize color)))
 	  (or (assoc color (tty-color-alist frame))
 	      (let ((rgb (tty-color-standard-values color)))
-		(and rgb (tty-color-approximate rgb frame)))))))
+		(and rgb
+		     (let ((pixel (tty-color-24bit rgb frame)))
+		       (if pixel
+			   (cons color (cons pixel rgb))
+			 (tty-color-approximate rgb frame)))))))))
+
+(defun tty-color-24bit (rgb &optional frame)
+  "Return the color index of RGB on a 24-bit terminal.
+RGB is a list of three integers in the 0..65535 range.  Value is nil
+unless FRAME's terminal supports 24-bit color.
+FRAME defaults to the selected frame."
+  (when (= (display-color-cells frame) 16777216)
+    (let ((r (ash (car rgb) -8))
+	  (g (ash (cadr rgb) -8))
+	  (b (ash (nth 2 rgb) -8)))
+      (logior (ash r 16) (ash g 8) b))))
 
 (defun tty-color-gray-shades (&optional display)
   "Return the number of gray colors supported by DISPLAY's terminal.
@@ -56,6 +56,14 @@ The relevant features are:
   (let* ((end-marker-length (length xterm-paste-ending-sequence))
          (pasted-text (with-temp-buffer
                         (set-buffer-multibyte nil)
+                        ;; Take the whole paste from the input queue at
+                        ;; once if we can, and read the rest, if any,
+                        ;; event by event.
+                        (insert (subst-char-in-string
+                                 ?\r ?\n
+                                 (read-raw-input-until
+                                  xterm-paste-ending-sequence)
+                                 t))
                         (while (not (search-backward
                                      xterm-paste-ending-sequence
                                      (- (point) end-marker-length) t))
@@ -760,6 +768,11 @@ versions of xterm."
     (if (> ncolors 0)
 	;; Clear the 8 default tty colors registered by startup.el
 	(tty-color-clear))
+    ;; On a 24-bit terminal, color indices above 7 are RGB values, so
+    ;; register only the 8 ANSI colors; `tty-color-desc' computes the
+    ;; rest directly.
+    (if (= ncolors 16777216)
+	(setq ncolors 8))
     ;; Only register as many colors as are supported by the display.
     (while (and (> ncolors 0) colors)
       (tty-color-define (car color) (cadr color)
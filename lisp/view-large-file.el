@@ -0,0 +1,162 @@
+;;; view-large-file.el --- view files too large to visit, a window at a time
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; Maintainer: emacs-devel@gnu.org
+;; Keywords: files
+
+;; This file is part of GNU Emacs.
+
+;; GNU Emacs is free software: you can redistribute it and/or modify
+;; it under the terms of the GNU General Public License as published by
+;; the Free Software Foundation, either version 3 of the License, or
+;; (at your option) any later version.
+
+;; GNU Emacs is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+
+;; You should have received a copy of the GNU General Public License
+;; along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.
+
+;;; Commentary:
+
+;; A buffer holds all of the text of the file it visits, so a file of
+;; many gigabytes cannot be visited at all.  `view-large-file' instead
+;; shows such a file literally, `view-large-file-window-size' bytes at
+;; a time, reading only the part of the file it shows.  The commands of
+;; `view-large-file-mode' move that window through the file, and search
+;; forward across windows.
+
+;;; Code:
+
+(defgroup view-large-file nil
+  "View files too large to visit, a window at a time."
+  :group 'view
+  :version "24.5")
+
+(defcustom view-large-file-window-size (* 1024 1024)
+  "Number of bytes of the file that `view-large-file' shows at a time."
+  :type 'integer
+  :group 'view-large-file)
+
+(defvar-local view-large-file-name nil
+  "Name of the file shown in a `view-large-file' buffer.")
+
+(defvar-local view-large-file-start 0
+  "Byte offset in the file of the text shown in a `view-large-file' buffer.")
+
+(defvar-local view-large-file-size 0
+  "Size in bytes of the file shown, when it was last read.")
+
+(defvar view-large-file-mode-map
+  (let ((map (make-sparse-keymap)))
+    (define-key map "\C-c\C-n" 'view-large-file-next)
+    (define-key map "\C-c\C-p" 'view-large-file-previous)
+    (define-key map "\C-c\C-g" 'view-large-file-goto-offset)
+    (define-key map "\C-c\C-s" 'view-large-file-re-search-forward)
+    map)
+  "Keymap for `view-large-file-mode'.")
+
+(define-minor-mode view-large-file-mode
+  "Minor mode for a buffer showing part of a large file.
+\\<view-large-file-mode-map>\
+\\[view-large-file-next] and \\[view-large-file-previous] show the next \
+and previous parts of the file,
+\\[view-large-file-goto-offset] shows the part at a given byte offset, and
+\\[view-large-file-re-search-forward] searches forward through the rest \
+of the file."
+  :lighter (:eval (format " Large[%d%%]"
+                          (if (zerop view-large-file-size) 100
+                            (/ (* 100.0 (view-large-file-offset (point)))
+                               view-large-file-size)))))
+
+(defun view-large-file-offset (pos)
+  "Return the byte offset in the file of buffer position POS."
+  (+ view-large-file-start (- pos (point-min))))
+
+(defun view-large-file--read (start)
+  "Show the part of the file that starts at byte offset START.
+START is moved back if need be, so that the last part of the file
+shown is a whole window too.  Return the offset actually used."
+  (let* ((size (nth 7 (file-attributes view-large-file-name)))
+         (start (max 0 (min start (- size view-large-file-window-size))))
+         (inhibit-read-only t))
+    (erase-buffer)
+    (insert-file-contents-literally
+     view-large-file-name nil start
+     (min size (+ start view-large-file-window-size)))
+    (set-buffer-modified-p nil)
+    (setq view-large-file-size size
+          view-large-file-start start)))
+
+(defun view-large-file-goto-offset (offset)
+  "Show the part of the file at byte OFFSET, and move point there."
+  (interactive "nByte offset: ")
+  (view-large-file--read offset)
+  (goto-char (min (point-max)
+                  (+ (point-min) (max 0 (- offset view-large-file-start))))))
+
+(defun view-large-file-next ()
+  "Show the next part of the file."
+  (interactive)
+  (if (>= (view-large-file-offset (point-max)) view-large-file-size)
+      (message "End of file")
+    (view-large-file--read (+ view-large-file-start
+                              view-large-file-window-size))
+    (goto-char (point-min))))
+
+(defun view-large-file-previous ()
+  "Show the previous part of the file."
+  (interactive)
+  (if (zerop view-large-file-start)
+      (message "Beginning of file")
+    (view-large-file--read (- view-large-file-start
+                              view-large-file-window-size))
+    (goto-char (point-max))))
+
+(defun view-large-file-re-search-forward (regexp)
+  "Search forward from point for REGEXP, through the rest of the file.
+Show the part of the file where the match is, and leave point after it.
+Successive parts searched overlap by half a window, so that only
+matches longer than that can be missed."
+  (interactive "sRe search forward: ")
+  (let ((from (view-large-file-offset (point)))
+        (start view-large-file-start)
+        (overlap (/ view-large-file-window-size 2)))
+    (while (not (re-search-forward regexp nil t))
+      (when (>= (view-large-file-offset (point-max)) view-large-file-size)
+        (unless (= view-large-file-start start)
+          (view-large-file--read start)
+          (goto-char (+ (point-min) (- from start))))
+        (signal 'search-failed (list regexp)))
+      (let ((next (view-large-file-offset (max (point-min)
+                                               (- (point-max) overlap)))))
+        (view-large-file--read next)
+        (goto-char (+ (point-min) (max 0 (- from view-large-file-start))))))
+    (point)))
+
+;;;###autoload
+(defun view-large-file (file)
+  "View FILE literally, `view-large-file-window-size' bytes at a time.
+Only the part of FILE shown is read, so FILE can be much larger than
+a buffer could hold.  The buffer is in View mode, and in
+`view-large-file-mode', whose commands show other parts of FILE."
+  (interactive "fView large file: ")
+  (let* ((file (expand-file-name file))
+         (buffer (generate-new-buffer (file-name-nondirectory file))))
+    (with-current-buffer buffer
+      (set-buffer-multibyte nil)
+      (setq buffer-undo-list t
+            default-directory (file-name-directory file)
+            view-large-file-name file)
+      (view-large-file--read 0)
+      (goto-char (point-min))
+      (view-large-file-mode 1)
+      (view-mode-enter nil #'kill-buffer))
+    (switch-to-buffer buffer)))
+
+(provide 'view-large-file)
+
+;;; view-large-file.el ends here
@@ -2333,6 +2333,19 @@ shall be resized horizontally."
      frame t)
     nil))
 
+(defvar window--resize-defer nil
+  "Non-nil means `window-resize-apply' leaves glyph matrices alone.
+Bound by `with-window-resize-batch'.")
+
+(defmacro with-window-resize-batch (&rest body)
+  "Evaluate BODY, which resizes windows, as one batch.
+The glyph matrices of the frames whose windows BODY resizes are
+reallocated once, by the next redisplay, instead of once for each
+resize.  Return the value of the last form in BODY."
+  (declare (indent 0) (debug t))
+  `(let ((window--resize-defer t))
+     ,@body))
+
 (defun window-resize (window delta &optional horizontal ignore pixelwise)
   "Resize WINDOW vertically by DELTA lines.
 WINDOW can be an arbitrary window and defaults to the selected
@@ -2410,7 +2423,7 @@ instead."
 	;; Otherwise, resize all other windows in the same combination.
 	(window--resize-siblings window delta horizontal ignore))
       (when (window--resize-apply-p frame horizontal)
-	(if (window-resize-apply frame horizontal)
+	(if (window-resize-apply frame horizontal window--resize-defer)
 	    (progn
 	      (window--pixel-to-total frame horizontal)
 	      (run-window-configuration-change-hook frame))
@@ -3081,7 +3094,7 @@ move it as far as possible in the desired direction."
       (unless (zerop delta)
 	;; Don't report an error in the standard case.
 	(when (window--resize-apply-p frame horizontal)
-	  (if (window-resize-apply frame horizontal)
+	  (if (window-resize-apply frame horizontal window--resize-defer)
 	      (progn
 		(window--pixel-to-total frame horizontal)
 		(run-window-configuration-change-hook frame))
@@ -4703,14 +4716,16 @@ window."
     (window--resize-reset (window-frame window))
     (balance-windows-1 window)
     (when (window--resize-apply-p frame)
-      (window-resize-apply frame)
+      ;; The horizontal pass below, or redisplay, reallocates the
+      ;; glyph matrices.
+      (window-resize-apply frame nil t)
       (window--pixel-to-total frame)
       (run-window-configuration-change-hook frame))
     ;; Balance horizontally.
     (window--resize-reset (window-frame window) t)
     (balance-windows-1 window t)
     (when (window--resize-apply-p frame t)
-      (window-resize-apply frame t)
+      (window-resize-apply frame t window--resize-defer)
       (window--pixel-to-total frame t)
       (run-window-configuration-change-hook frame))))
 
@@ -4759,6 +4774,8 @@ specific buffers."
                                  (window-list nil 'nomini))))
          (changelog nil)
 	 (pixelwise window-resize-pixelwise)
+	 ;; Reallocate glyph matrices once, not after each step.
+	 (window--resize-defer t)
 	 next)
     ;; Resizing a window changes the size of surrounding windows in complex
     ;; ways, so it's difficult to balance them all.  The introduction of
@@ -21,6 +21,7 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <config.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #ifdef ENABLE_CHECKING
 #include <signal.h>		/* For SIGABRT.  */
@@ -31,11 +32,14 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #endif
 
 #include <gc.h>
+#include <gc/gc_mark.h>
 
 #include "lisp.h"
+#include "sysstdio.h"
 #include "process.h"
 #include "intervals.h"
 #include "character.h"
+#include "coding.h"
 #include "buffer.h"
 #include "window.h"
 #include "keyboard.h"
@@ -47,6 +51,7 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 
 #include <verify.h>
 #include <execinfo.h>           /* For backtrace.  */
+#include <timespec.h>
 
 #if (defined ENABLE_CHECKING			\
      && defined HAVE_VALGRIND_VALGRIND_H	\
@@ -95,17 +100,44 @@ EMACS_INT memory_full_cons_threshold = 1 << 10;
 
 bool gc_in_progress;
 
+/* True once incremental collection has been turned on.  The collector
+   cannot go back to stop-the-world mode after that.  */
+
+bool gc_incremental;
+
 /* True means abort if try to GC.
    This is for code which is written on the assumption that
    no GC will happen, so as to verify that assumption.  */
 
 bool abort_on_gc;
 
-/* Number of live and free conses etc.  */
+/* Number of live objects of each type, as counted by the last call
+   to `garbage-collect'.  */
+
+struct gc_census
+{
+  EMACS_INT conses, symbols, strings, string_bytes, floats, intervals;
+  EMACS_INT vector_slots;
+  EMACS_INT misc[Lisp_Misc_Limit - Lisp_Misc_Free];
+  EMACS_INT vectorlikes[PVEC_FONT + 1];
+};
+
+/* Boehm GC 7.4 added the collection event callback and the heap
+   enumeration used for the census.  */
 
-static EMACS_INT total_conses, total_markers, total_symbols, total_buffers;
-static EMACS_INT total_free_conses, total_free_markers, total_free_symbols;
-static EMACS_INT total_free_floats, total_floats;
+#if (GC_VERSION_MAJOR > 7 \
+     || (GC_VERSION_MAJOR == 7 && GC_VERSION_MINOR >= 4))
+# define HAVE_GC_EVENTS 1
+#endif
+
+/* Time at which the current collection started, and the total time
+   spent collecting.  These are updated from inside the collector,
+   where no Lisp object may be allocated, so `gc-elapsed' is only
+   brought up to date by gc_update_elapsed.  */
+
+static struct timespec gc_start_time;
+static struct timespec gc_total_time;
+static bool gc_elapsed_stale;
 
 /* Points to memory space allocated as "spare", to be freed if we run
    out of memory. */
@@ -139,6 +171,23 @@ extern Lisp_Object which_symbols (Lisp_Object, EMACS_INT) EXTERNALLY_VISIBLE;
 # define DEADP(x) 0
 #endif
 
+/* Tell the memory profiler about an allocation of SIZE bytes.  */
+
+#define MALLOC_PROBE(size)			\
+  do {						\
+    if (profiler_memory_running)		\
+      malloc_probe (size);			\
+  } while (0)
+
+/* Tell the memory profiler about a new Lisp object, for which SIZE
+   bytes were allocated without MALLOC_PROBE.  */
+
+#define OBJECT_PROBE(size)			\
+  do {						\
+    if (profiler_memory_running)		\
+      object_probe (size);			\
+  } while (0)
+
 /* Recording what needs to be marked for gc.  */
 
 struct gcpro *gcprolist;
@@ -197,6 +246,7 @@ xmalloc (size_t size)
   void *val = GC_MALLOC (size);
   if (!val && size)
     memory_full (size);
+  MALLOC_PROBE (size);
   return val;
 }
 
@@ -233,6 +283,7 @@ xmalloc_atomic (size_t size)
   void *val = GC_MALLOC_ATOMIC (size);
   if (! val && size)
     memory_full (size);
+  MALLOC_PROBE (size);
   return val;
 }
 
@@ -447,6 +498,7 @@ init_strings (void)
 static Lisp_Object
 allocate_string (void)
 {
+  OBJECT_PROBE (sizeof (struct Lisp_String));
   return scm_make_smob (lisp_string_tag);
 }
 
@@ -468,9 +520,11 @@ allocate_string_data (Lisp_Object string,
     string_overflow ();
 
   data = GC_MALLOC_ATOMIC (nbytes + 1);
+  MALLOC_PROBE (nbytes + 1);
   s->data = data;
   s->size = nchars;
   s->size_byte = nbytes;
+  s->scheme = 0;
   s->data[nbytes] = '\0';
 }
 
@@ -574,8 +628,17 @@ make_uninit_bool_vector (EMACS_INT nbits)
   EMACS_INT needed_elements = ((bool_header_size - header_size + word_bytes
 				+ word_size - 1)
 			       / word_size);
-  struct Lisp_Bool_Vector *p
-    = (struct Lisp_Bool_Vector *) allocate_vector (needed_elements);
+  struct Lisp_Bool_Vector *p;
+
+  if (min ((PTRDIFF_MAX - header_size) / word_size, MOST_POSITIVE_FIXNUM)
+      < needed_elements)
+    memory_full (SIZE_MAX);
+
+  /* The bits hold no pointers, and the header's back pointer to the
+     smob is not needed to keep the smob alive, so the collector need
+     not scan a bool vector.  */
+  p = xmalloc_atomic (header_size + needed_elements * word_size);
+  SCM_NEWSMOB (p->header.self, lisp_vectorlike_tag, p);
   XSETVECTOR (val, p);
   XSETPVECTYPESIZE (XVECTOR (val), PVEC_BOOL_VECTOR, 0, 0);
   p->size = nbits;
@@ -766,6 +829,7 @@ make_formatted_string (char *buf, const char *format, ...)
 Lisp_Object
 make_float (double float_value)
 {
+  OBJECT_PROBE (word_size + sizeof (double));
   return scm_from_double (float_value);
 }
 
@@ -778,6 +842,7 @@ DEFUN ("cons", Fcons, Scons, 2, 2, 0,
        doc: /* Create a new cons, give it CAR and CDR as components, and return it.  */)
   (Lisp_Object car, Lisp_Object cdr)
 {
+  OBJECT_PROBE (2 * word_size);
   return scm_cons (car, cdr);
 }
 
@@ -950,6 +1015,7 @@ allocate_vectorlike (ptrdiff_t len)
     {
       p = xmalloc (header_size + len * word_size);
       SCM_NEWSMOB (p->header.self, lisp_vectorlike_tag, p);
+      OBJECT_PROBE (0);
     }
 
   return p;
@@ -1574,6 +1640,199 @@ staticpro (Lisp_Object *varaddress)
   return;
 }
 
+/***********************************************************************
+			   Collector statistics
+ ***********************************************************************/
+
+#ifdef HAVE_GC_EVENTS
+
+/* Called by Boehm GC at the start and end of each collection.  */
+
+static void
+gc_event_callback (GC_EventType event)
+{
+  switch (event)
+    {
+    case GC_EVENT_START:
+      gc_in_progress = true;
+      gc_start_time = current_timespec ();
+      break;
+
+    case GC_EVENT_END:
+      gc_total_time = timespec_add (gc_total_time,
+				    timespec_sub (current_timespec (),
+						  gc_start_time));
+      gcs_done++;
+      gc_elapsed_stale = true;
+      pending_signals = 1;
+      gc_in_progress = false;
+      break;
+
+    default:
+      break;
+    }
+}
+
+#endif /* HAVE_GC_EVENTS */
+
+/* Make the collector follow `gc-max-pause'.  */
+
+static void
+gc_apply_max_pause (void)
+{
+  if (NUMBERP (Vgc_max_pause) && XFLOATINT (Vgc_max_pause) > 0)
+    {
+      double ms = XFLOATINT (Vgc_max_pause);
+
+      if (!gc_incremental)
+	{
+	  GC_enable_incremental ();
+	  gc_incremental = true;
+	}
+      GC_set_time_limit (ms < 1 ? 1
+			 : ms < GC_TIME_UNLIMITED ? ms : GC_TIME_UNLIMITED);
+    }
+  else if (gc_incremental)
+    GC_set_time_limit (GC_TIME_UNLIMITED);
+}
+
+/* Bring `gc-elapsed' up to date with the collections done since it
+   was last set, and pick up any change to `gc-max-pause'.  This is
+   called from safe points, where consing is allowed.  */
+
+void
+gc_update_elapsed (void)
+{
+  if (gc_elapsed_stale)
+    {
+      gc_elapsed_stale = false;
+      Vgc_elapsed = make_float (timespectod (gc_total_time));
+      gc_apply_max_pause ();
+    }
+}
+
+static EMACS_INT
+count_intervals (INTERVAL i)
+{
+  EMACS_INT n = 0;
+
+  for (; i; i = i->right)
+    n += 1 + count_intervals (i->left);
+  return n;
+}
+
+#ifdef HAVE_GC_EVENTS
+
+/* Classify the heap object P, of SIZE bytes, into the census DATA.
+   Lisp objects are recognized by the type word of their Guile cell;
+   this runs with the allocation lock held, so it must not allocate.
+   A cons is an untagged two-word cell, which cannot be told apart
+   from other two-word blocks, so the cons count is an estimate.  */
+
+static void
+census_object (void *p, size_t size, void *data)
+{
+  struct gc_census *census = data;
+  scm_t_bits word0 = *(scm_t_bits *) p;
+  size_t kind_size;
+
+  if (GC_get_kind_and_size (p, &kind_size) != GC_I_NORMAL)
+    return;
+
+  if (SCM_TYP16 (word0) == lisp_string_tag)
+    {
+      struct Lisp_String *s = (void *) ((scm_t_bits *) p)[1];
+
+      census->strings++;
+      if (s)
+	{
+	  census->string_bytes += s->size_byte < 0 ? s->size : s->size_byte;
+	  census->intervals += count_intervals (s->intervals);
+	}
+    }
+  else if (SCM_TYP16 (word0) == lisp_vectorlike_tag)
+    {
+      struct vectorlike_header *h = (void *) ((scm_t_bits *) p)[1];
+
+      if (!h)
+	return;
+      if (h->size & PSEUDOVECTOR_FLAG)
+	{
+	  int type = (h->size & PVEC_TYPE_MASK) >> PSEUDOVECTOR_AREA_BITS;
+
+	  if (type <= PVEC_FONT)
+	    census->vectorlikes[type]++;
+	  if (type == PVEC_BUFFER)
+	    {
+	      struct buffer *b = (struct buffer *) h;
+
+	      if (!b->base_buffer && b->text)
+		census->intervals += count_intervals (b->text->intervals);
+	    }
+	}
+      else
+	{
+	  census->vectorlikes[PVEC_NORMAL_VECTOR]++;
+	  census->vector_slots += h->size;
+	}
+    }
+  else if (SCM_TYP16 (word0) == lisp_misc_tag)
+    {
+      struct Lisp_Misc_Any *m = (void *) ((scm_t_bits *) p)[1];
+
+      if (m && Lisp_Misc_Free <= m->type && m->type < Lisp_Misc_Limit)
+	census->misc[m->type - Lisp_Misc_Free]++;
+    }
+  else if (SCM_TYP7 (word0) == scm_tc7_symbol)
+    census->symbols++;
+  else if (SCM_TYP16 (word0) == scm_tc16_real)
+    census->floats++;
+  else if (size == 2 * sizeof (scm_t_bits) && !(word0 & 1))
+    census->conses++;
+}
+
+static void *
+take_census (void *data)
+{
+  GC_enumerate_reachable_objects_inner (census_object, data);
+  return NULL;
+}
+
+#endif /* HAVE_GC_EVENTS */
+
+static Lisp_Object
+census_entry (const char *name, size_t size, EMACS_INT used)
+{
+  return list4 (intern (name), make_number (size),
+		make_number (used), make_number (0));
+}
+
+DEFUN ("gc-statistics", Fgc_statistics, Sgc_statistics, 0, 0, 0,
+       doc: /* Return a property list of statistics about the garbage collector.
+The properties are:
+- `heap-size', the number of bytes in the collector's heap,
+- `free-bytes', the number of those bytes not in use,
+- `bytes-since-gc', the number of bytes allocated since the last collection,
+- `total-bytes', the number of bytes allocated since Emacs started,
+- `gcs-done', the number of collections done, like `gcs-done',
+- `gc-elapsed', the time spent collecting in seconds, like `gc-elapsed'.
+Unlike `garbage-collect', this does not trigger a collection.  */)
+  (void)
+{
+  GC_word heap_size, free_bytes, unmapped_bytes, bytes_since_gc, total_bytes;
+
+  GC_get_heap_usage_safe (&heap_size, &free_bytes, &unmapped_bytes,
+			  &bytes_since_gc, &total_bytes);
+  gc_update_elapsed ();
+  return listn (CONSTYPE_HEAP, 12,
+		intern ("heap-size"), make_number (heap_size),
+		intern ("free-bytes"), make_number (free_bytes),
+		intern ("bytes-since-gc"), make_number (bytes_since_gc),
+		intern ("total-bytes"), make_number (total_bytes),
+		intern ("gcs-done"), make_number (gcs_done),
+		intern ("gc-elapsed"), Vgc_elapsed);
+}
+
 DEFUN ("garbage-collect", Fgarbage_collect, Sgarbage_collect, 0, 0, "",
        doc: /* Reclaim storage for Lisp objects no longer needed.
 Garbage collection happens automatically if you cons more than
@@ -1584,17 +1843,447 @@ where each entry has the form (NAME SIZE USED FREE), where:
 - SIZE is the number of bytes used by each one,
 - USED is the number of those objects that were found live in the heap,
 - FREE is the number of those objects that are not live but that Emacs
-  keeps around for future allocations (maybe because it does not know how
-  to return them to the OS).
-However, if there was overflow in pure space, `garbage-collect'
-returns nil, because real GC can't be done.
+  keeps around for future allocations.  The collector keeps free memory
+  in a common pool, so this is always 0 except for the `heap' entry,
+  whose USED and FREE are in units of SIZE bytes.
+See also `gc-statistics'.
 See Info node `(elisp)Garbage Collection'.  */)
   (void)
 {
+  struct gc_census census;
+  GC_word heap_size, free_bytes, unmapped_bytes, bytes_since_gc, total_bytes;
+  Lisp_Object result;
+
+  memset (&census, 0, sizeof census);
+  gc_apply_max_pause ();
   GC_gcollect ();
-  return Qt;
+#ifdef HAVE_GC_EVENTS
+  GC_call_with_alloc_lock (take_census, &census);
+#endif
+  GC_get_heap_usage_safe (&heap_size, &free_bytes, &unmapped_bytes,
+			  &bytes_since_gc, &total_bytes);
+  consing_since_gc = 0;
+  gc_update_elapsed ();
+
+  result = list4 (list4 (intern ("heap"), make_number (1024),
+			 make_number ((heap_size - free_bytes) / 1024),
+			 make_number (free_bytes / 1024)),
+		  census_entry ("vector-slots", word_size,
+				census.vector_slots),
+		  census_entry ("intervals", sizeof (struct interval),
+				census.intervals),
+		  census_entry ("string-bytes", 1, census.string_bytes));
+  result = Fcons (census_entry ("hash-tables",
+				sizeof (struct Lisp_Hash_Table),
+				census.vectorlikes[PVEC_HASH_TABLE]),
+		  result);
+  result = Fcons (census_entry ("buffers", sizeof (struct buffer),
+				census.vectorlikes[PVEC_BUFFER]),
+		  result);
+  result = Fcons (census_entry ("vectors", header_size,
+				census.vectorlikes[PVEC_NORMAL_VECTOR]),
+		  result);
+  result = Fcons (census_entry ("overlays", sizeof (union Lisp_Misc),
+				census.misc[Lisp_Misc_Overlay
+					    - Lisp_Misc_Free]),
+		  result);
+  result = Fcons (census_entry ("markers", sizeof (union Lisp_Misc),
+				census.misc[Lisp_Misc_Marker
+					    - Lisp_Misc_Free]),
+		  result);
+  result = Fcons (census_entry ("floats", sizeof (double), census.floats),
+		  result);
+  result = Fcons (census_entry ("strings", sizeof (struct Lisp_String),
+				census.strings),
+		  result);
+  result = Fcons (census_entry ("symbols", 2 * word_size, census.symbols),
+		  result);
+  result = Fcons (census_entry ("conses", 2 * word_size, census.conses),
+		  result);
+  return result;
 }
 
+/* The census of memory-census.  Each root, an interned symbol, a
+   live buffer or a live frame, is charged with the objects reachable
+   from it that no earlier root reaches.  Objects are numbered in the
+   order they are found, for the heap graph.  */
+
+enum census_type
+  {
+    CENSUS_CONS, CENSUS_STRING, CENSUS_FLOAT, CENSUS_SYMBOL,
+    CENSUS_MARKER, CENSUS_OVERLAY, CENSUS_MISC,
+    /* Followed by one type per enum pvec_type.  */
+    CENSUS_VECTORLIKE,
+    CENSUS_TYPES = CENSUS_VECTORLIKE + PVEC_FONT + 1
+  };
+
+static const char *const census_type_names[CENSUS_TYPES] =
+  {
+    "conses", "strings", "floats", "symbols", "markers", "overlays", "misc",
+    "vectors", "free-vectors", "processes", "frames", "windows",
+    "bool-vectors", "buffers", "hash-tables", "terminals",
+    "window-configurations", "string-builders", "zlib-streams",
+    "other-vectors", "compiled-functions", "char-tables",
+    "sub-char-tables", "fonts"
+  };
+
+struct census_count
+{
+  Lisp_Object object;
+  EMACS_INT count, bytes;
+};
+
+struct memory_census
+{
+  /* Object numbers, by object.  */
+  Lisp_Object ids;
+
+  /* Objects found but not yet scanned, of which there are PENDING in
+     room for PENDING_SIZE.  */
+  Lisp_Object *pending;
+  ptrdiff_t npending, pending_size;
+
+  /* The totals by type, and by root, of which there are NROOTS in
+     room for ROOTS_SIZE.  */
+  struct census_count types[CENSUS_TYPES];
+  struct census_count *roots;
+  ptrdiff_t nroots, roots_size;
+
+  /* The heap graph file, or NULL.  */
+  FILE *graph;
+};
+
+/* Return true if OBJ is a root of the census, so that it is not
+   scanned when it is found from another object.  */
+
+static bool
+census_root_p (Lisp_Object obj)
+{
+  return ((SYMBOLP (obj) && SYMBOL_INTERNED_P (obj))
+	  || (BUFFERP (obj) && BUFFER_LIVE_P (XBUFFER (obj)))
+	  || (FRAMEP (obj) && FRAME_LIVE_P (XFRAME (obj))));
+}
+
+/* Return the number of OBJ, numbering it if it has none.  Set *FRESH
+   if it is new.  */
+
+static EMACS_INT
+census_id (struct memory_census *c, Lisp_Object obj, bool *fresh)
+{
+  struct Lisp_Hash_Table *h = XHASH_TABLE (c->ids);
+  EMACS_UINT hash;
+  ptrdiff_t i = hash_lookup (h, obj, &hash);
+
+  *fresh = i < 0;
+  if (i >= 0)
+    return XINT (HASH_VALUE (h, i));
+  hash_put (h, obj, make_number (h->count), hash);
+  return h->count - 1;
+}
+
+/* Note that the object being scanned refers to OBJ.  */
+
+static void
+census_visit (struct memory_census *c, Lisp_Object obj)
+{
+  EMACS_INT id;
+  bool fresh;
+
+  switch (XTYPE (obj))
+    {
+    case Lisp_Int:
+    case Lisp_Other:
+      return;
+    default:
+      break;
+    }
+  if (NILP (obj) || EQ (obj, Qunbound))
+    return;
+
+  id = census_id (c, obj, &fresh);
+  if (c->graph)
+    fprintf (c->graph, " %"pI"d", id);
+  if (fresh && !census_root_p (obj))
+    {
+      if (c->npending == c->pending_size)
+	c->pending = xpalloc (c->pending, &c->pending_size, 1, -1,
+			      sizeof *c->pending);
+      c->pending[c->npending++] = obj;
+    }
+}
+
+/* Visit the property lists of the intervals in I, and return how
+   many there are.  */
+
+static EMACS_INT
+census_intervals (struct memory_census *c, INTERVAL i)
+{
+  EMACS_INT n = 0;
+
+  for (; i; i = i->right)
+    {
+      census_visit (c, i->plist);
+      n += 1 + census_intervals (c, i->left);
+    }
+  return n;
+}
+
+/* Count OBJ, which root OWNER reaches, and visit what it refers to.  */
+
+static void
+census_scan (struct memory_census *c, Lisp_Object obj, EMACS_INT owner)
+{
+  struct census_count *root = &c->roots[c->nroots - 1];
+  enum census_type type;
+  EMACS_INT bytes;
+  bool fresh;
+
+  if (c->graph)
+    fprintf (c->graph, "N %"pI"d", census_id (c, obj, &fresh));
+
+  switch (XTYPE (obj))
+    {
+    case Lisp_Cons:
+      type = CENSUS_CONS;
+      bytes = 2 * word_size;
+      if (c->graph)
+	fprintf (c->graph, " %s %"pI"d %"pI"d",
+		 census_type_names[type], bytes, owner);
+      census_visit (c, XCAR (obj));
+      census_visit (c, XCDR (obj));
+      break;
+
+    case Lisp_Float:
+      type = CENSUS_FLOAT;
+      bytes = sizeof (double);
+      if (c->graph)
+	fprintf (c->graph, " %s %"pI"d %"pI"d",
+		 census_type_names[type], bytes, owner);
+      break;
+
+    case Lisp_String:
+      type = CENSUS_STRING;
+      bytes = (sizeof (struct Lisp_String) + SBYTES (obj) + 1
+	       + (count_intervals (string_intervals (obj))
+		  * sizeof (struct interval)));
+      if (c->graph)
+	fprintf (c->graph, " %s %"pI"d %"pI"d",
+		 census_type_names[type], bytes, owner);
+      census_intervals (c, string_intervals (obj));
+      break;
+
+    case Lisp_Symbol:
+      type = CENSUS_SYMBOL;
+      bytes = 2 * word_size;
+      if (c->graph)
+	fprintf (c->graph, " %s %"pI"d %"pI"d",
+		 census_type_names[type], bytes, owner);
+      census_visit (c, find_symbol_value (obj));
+      census_visit (c, Fsymbol_function (obj));
+      census_visit (c, symbol_plist (obj));
+      break;
+
+    case Lisp_Misc:
+      type = (MARKERP (obj) ? CENSUS_MARKER
+	      : OVERLAYP (obj) ? CENSUS_OVERLAY
+	      : CENSUS_MISC);
+      bytes = sizeof (union Lisp_Misc);
+      if (c->graph)
+	fprintf (c->graph, " %s %"pI"d %"pI"d",
+		 census_type_names[type], bytes, owner);
+      if (type == CENSUS_OVERLAY)
+	{
+	  census_visit (c, XOVERLAY (obj)->start);
+	  census_visit (c, XOVERLAY (obj)->end);
+	  census_visit (c, XOVERLAY (obj)->plist);
+	}
+      break;
+
+    default:
+      {
+	struct Lisp_Vector *v = XVECTOR (obj);
+	ptrdiff_t size = v->header.size, nlisp, i;
+	enum pvec_type pvec = PVEC_NORMAL_VECTOR;
+
+	if (size & PSEUDOVECTOR_FLAG)
+	  {
+	    pvec = (size & PVEC_TYPE_MASK) >> PSEUDOVECTOR_AREA_BITS;
+	    nlisp = size & PSEUDOVECTOR_SIZE_MASK;
+	    bytes = header_size + word_size * (nlisp + ((size & PSEUDOVECTOR_REST_MASK)
+							>> PSEUDOVECTOR_SIZE_BITS));
+	  }
+	else
+	  {
+	    nlisp = size;
+	    bytes = header_size + word_size * size;
+	  }
+	if (pvec == PVEC_BOOL_VECTOR)
+	  bytes = (bool_header_size
+		   + bool_vector_bytes (bool_vector_size (obj)));
+	else if (pvec == PVEC_BUFFER)
+	  {
+	    struct buffer *b = XBUFFER (obj);
+
+	    bytes = sizeof *b;
+	    if (!b->base_buffer && b->text)
+	      bytes += (b->text->z_byte - BEG_BYTE + b->text->gap_size
+			+ (count_intervals (b->text->intervals)
+			   * sizeof (struct interval)));
+	  }
+	type = CENSUS_VECTORLIKE + min (pvec, PVEC_FONT);
+	if (c->graph)
+	  fprintf (c->graph, " %s %"pI"d %"pI"d",
+		   census_type_names[type], bytes, owner);
+	for (i = 0; i < nlisp; i++)
+	  census_visit (c, v->contents[i]);
+	if (pvec == PVEC_BUFFER)
+	  {
+	    struct buffer *b = XBUFFER (obj);
+	    struct Lisp_Overlay *ov;
+	    Lisp_Object overlay;
+
+	    if (!b->base_buffer && b->text)
+	      census_intervals (c, b->text->intervals);
+	    for (ov = b->overlays_before; ov; ov = ov->next)
+	      {
+		XSETMISC (overlay, ov);
+		census_visit (c, overlay);
+	      }
+	    for (ov = b->overlays_after; ov; ov = ov->next)
+	      {
+		XSETMISC (overlay, ov);
+		census_visit (c, overlay);
+	      }
+	  }
+      }
+      break;
+    }
+
+  if (c->graph)
+    putc ('\n', c->graph);
+  c->types[type].count++;
+  c->types[type].bytes += bytes;
+  root->count++;
+  root->bytes += bytes;
+}
+
+/* Charge ROOT with the objects it reaches that are not yet counted.  */
+
+static void
+census_root (Lisp_Object root, Lisp_Object census)
+{
+  struct memory_census *c = XSAVE_POINTER (census, 0);
+  EMACS_INT id;
+  bool fresh;
+
+  if (c->nroots == c->roots_size)
+    c->roots = xpalloc (c->roots, &c->roots_size, 1, -1, sizeof *c->roots);
+  c->roots[c->nroots].object = root;
+  c->roots[c->nroots].count = c->roots[c->nroots].bytes = 0;
+  c->nroots++;
+
+  id = census_id (c, root, &fresh);
+  if (c->graph)
+    {
+      Lisp_Object name = (SYMBOLP (root) ? SYMBOL_NAME (root)
+			  : BUFFERP (root) ? BVAR (XBUFFER (root), name)
+			  : XFRAME (root)->name);
+      fprintf (c->graph, "R %"pI"d %s\n", id,
+	       STRINGP (name) ? SSDATA (name) : "");
+    }
+  census_scan (c, root, id);
+  while (c->npending > 0)
+    census_scan (c, c->pending[--c->npending], id);
+}
+
+static int
+census_count_compare (const void *a, const void *b)
+{
+  EMACS_INT x = ((const struct census_count *) a)->bytes;
+  EMACS_INT y = ((const struct census_count *) b)->bytes;
+
+  return (x < y) - (x > y);
+}
+
+static Lisp_Object
+census_counts (struct census_count *counts, ptrdiff_t n)
+{
+  Lisp_Object result = Qnil;
+
+  qsort (counts, n, sizeof *counts, census_count_compare);
+  while (n-- > 0)
+    if (counts[n].count > 0)
+      result = Fcons (list3 (counts[n].object, make_number (counts[n].count),
+			     make_number (counts[n].bytes)),
+		      result);
+  return result;
+}
+
+static void
+census_close_graph (void *arg)
+{
+  struct memory_census *c = arg;
+
+  if (c->graph)
+    fclose (c->graph);
+  c->graph = NULL;
+}
+
+DEFUN ("memory-census", Fmemory_census, Smemory_census, 0, 1, 0,
+       doc: /* Count the Lisp objects reachable from the roots, by type and by root.
+The roots are the interned symbols, the live buffers and the live
+frames, in that order.  Each object is charged to the first root that
+reaches it.  A symbol is charged with its value, function definition
+and property list.  A buffer is charged with its text, its text
+properties and overlays, and its local variables.
+
+Return a list (TYPES ROOTS).  TYPES has an element (TYPE COUNT BYTES)
+for each type of object, and ROOTS an element (ROOT COUNT BYTES) for
+each root that reaches objects, both sorted by decreasing BYTES.
+BYTES are approximations, as the collector rounds the size of objects
+up.  Objects only reachable from Guile code or from C variables are
+not found.
+
+If FILE is non-nil, also write the heap graph to FILE.  Its lines are
+`R ID NAME' for a root and `N ID TYPE BYTES ROOT-ID CHILD-ID...' for
+an object, where objects are numbered from 0.  Roots appear as the
+children of objects, but their own children are only listed on their
+own line.  */)
+  (Lisp_Object file)
+{
+  struct memory_census census;
+  Lisp_Object tail, buffer, frame, result;
+  int i;
+  dynwind_begin ();
+
+  memset (&census, 0, sizeof census);
+  census.ids = make_hash_table (hashtest_eq, make_number (DEFAULT_HASH_SIZE),
+				make_float (DEFAULT_REHASH_SIZE),
+				make_float (DEFAULT_REHASH_THRESHOLD),
+				Qnil);
+  if (!NILP (file))
+    {
+      file = Fexpand_file_name (file, Qnil);
+      census.graph = emacs_fopen (SSDATA (ENCODE_FILE (file)), "w");
+      if (!census.graph)
+	report_file_error ("Opening heap graph file", file);
+      record_unwind_protect_ptr (census_close_graph, &census);
+    }
+
+  map_obarray (Vobarray, census_root, make_save_ptr (&census));
+  FOR_EACH_LIVE_BUFFER (tail, buffer)
+    census_root (buffer, make_save_ptr (&census));
+  FOR_EACH_FRAME (tail, frame)
+    census_root (frame, make_save_ptr (&census));
+
+  for (i = 0; i < CENSUS_TYPES; i++)
+    census.types[i].object = intern (census_type_names[i]);
+  result = list2 (census_counts (census.types, CENSUS_TYPES),
+		  census_counts (census.roots, census.nroots));
+  dynwind_end ();
+  return result;
+}
+
 #ifdef ENABLE_CHECKING
 
 bool suppress_checking;
@@ -1635,6 +2324,9 @@ init_alloc_once (void)
 
   refill_memory_reserve ();
   gc_cons_threshold = GC_DEFAULT_THRESHOLD;
+#ifdef HAVE_GC_EVENTS
+  GC_set_on_collection_event (gc_event_callback);
+#endif
 }
 
 void
@@ -1710,6 +2402,19 @@ do hash-consing of the objects allocated to pure space.  */);
 The time is in seconds as a floating point value.  */);
   DEFVAR_INT ("gcs-done", gcs_done,
 	      doc: /* Accumulated number of garbage collections done.  */);
+
+  DEFVAR_LISP ("gc-max-pause", Vgc_max_pause,
+	       doc: /* Longest pause, in milliseconds, wanted from one garbage collection.
+If this is a positive number, the collector runs incrementally and
+generationally, doing a little marking at a time and trying to keep
+each pause below this many milliseconds.  That costs some throughput,
+so it suits interactive sessions with large heaps better than batch jobs.
+If nil, each collection runs to completion in one go.
+
+Setting this takes effect at the next garbage collection.  Once
+incremental collection has been turned on it stays on, and nil only
+removes the time limit.  */);
+  Vgc_max_pause = Qnil;
 }
 
 /* When compiled with GCC, GDB might say "No enum type named
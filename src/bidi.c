@@ -1340,12 +1340,23 @@ bidi_find_paragraph_start (ptrdiff_t pos, ptrdiff_t pos_byte)
   ptrdiff_t limit = ZV, limit_byte = ZV_BYTE;
   struct region_cache *bpc = bidi_paragraph_cache_on_off ();
   ptrdiff_t n = 0, oldpos = pos, next;
+  ptrdiff_t begv = BEGV, begv_byte = BEGV_BYTE;
   struct buffer *cache_buffer = current_buffer;
 
   if (cache_buffer->base_buffer)
     cache_buffer = cache_buffer->base_buffer;
 
-  while (pos_byte > BEGV_BYTE
+  /* In a buffer with long lines, look back no further than the start
+     of the chunk of `long-line-threshold' characters POS is in, so
+     that the search costs no more than that.  */
+  if (current_buffer->long_line_optimizations_p
+      && RANGED_INTEGERP (1, Vlong_line_threshold, PTRDIFF_MAX))
+    {
+      begv = max (BEGV, pos - (pos - BEG) % XINT (Vlong_line_threshold));
+      begv_byte = CHAR_TO_BYTE (begv);
+    }
+
+  while (pos_byte > begv_byte
 	 && n++ < MAX_PARAGRAPH_SEARCH
 	 && fast_looking_at (re, pos, pos_byte, limit, limit_byte, Qnil) < 0)
     {
@@ -1360,11 +1371,14 @@ bidi_find_paragraph_start (ptrdiff_t pos, ptrdiff_t pos_byte)
 	  break;
 	}
       else
-	pos = find_newline_no_quit (pos, pos_byte, -1, &pos_byte);
+	pos = find_newline (pos, pos_byte, begv, begv_byte, -1, NULL,
+			    &pos_byte, false);
     }
   if (n >= MAX_PARAGRAPH_SEARCH)
     pos = BEGV, pos_byte = BEGV_BYTE;
-  if (bpc)
+  /* A search cut short at a chunk start did not find a paragraph
+     start, so there is nothing to remember.  */
+  if (bpc && !(begv > BEGV && pos == begv))
     know_region_cache (cache_buffer, bpc, pos, oldpos);
   /* Positions returned by the region cache are not limited to
      BEGV..ZV range, so we limit them here.  */
@@ -243,6 +243,7 @@ static void
 bset_file_truename (struct buffer *b, Lisp_Object val)
 {
   b->INTERNAL_FIELD (file_truename) = val;
+  buffer_file_index_valid = 0;
 }
 static void
 bset_fringe_cursor_alist (struct buffer *b, Lisp_Object val)
@@ -392,6 +393,74 @@ Value is nil if OBJECT is not a buffer or if it has been killed.  */)
 	  ? Qt : Qnil);
 }
 
+DEFUN ("buffer-placeholder", Fbuffer_placeholder, Sbuffer_placeholder,
+       0, 1, 0,
+       doc: /* Return the function that fills in BUFFER, if it is a placeholder.
+A placeholder buffer stands for a buffer whose text and modes are only
+made when it is first needed; see `set-buffer-placeholder'.  Return nil
+if BUFFER is an ordinary buffer.  BUFFER defaults to the current
+buffer.  */)
+  (Lisp_Object buffer)
+{
+  if (NILP (buffer))
+    return current_buffer->placeholder;
+  CHECK_BUFFER (buffer);
+  return XBUFFER (buffer)->placeholder;
+}
+
+DEFUN ("set-buffer-placeholder", Fset_buffer_placeholder,
+       Sset_buffer_placeholder, 2, 2, 0,
+       doc: /* Make BUFFER a placeholder filled in by FUNCTION.
+The first time BUFFER is shown in a window, `set-window-buffer' calls
+FUNCTION with no arguments and BUFFER current, before the window shows
+it.  Until then, looking BUFFER up, listing it or making it current
+does not call FUNCTION; use `materialize-buffer' to fill it in sooner.
+If FUNCTION is nil, BUFFER becomes an ordinary buffer again.  */)
+  (Lisp_Object buffer, Lisp_Object function)
+{
+  CHECK_BUFFER (buffer);
+  if (!BUFFER_LIVE_P (XBUFFER (buffer)))
+    error ("Selecting deleted buffer");
+  XBUFFER (buffer)->placeholder = function;
+  return function;
+}
+
+/* If BUFFER is a live placeholder buffer, fill it in by calling its
+   function.  BUFFER stops being a placeholder first, so that the
+   function can display it and so that an error does not make it try
+   again each time.  */
+
+void
+materialize_buffer (Lisp_Object buffer)
+{
+  struct buffer *b = XBUFFER (buffer);
+  Lisp_Object function = b->placeholder;
+
+  if (NILP (function) || !BUFFER_LIVE_P (b))
+    return;
+  b->placeholder = Qnil;
+
+  dynwind_begin ();
+  record_unwind_current_buffer ();
+  set_buffer_internal (b);
+  call0 (function);
+  dynwind_end ();
+}
+
+DEFUN ("materialize-buffer", Fmaterialize_buffer, Smaterialize_buffer,
+       0, 1, 0,
+       doc: /* Fill in BUFFER now if it is a placeholder buffer.
+See `set-buffer-placeholder'.  BUFFER defaults to the current buffer.
+Return BUFFER.  */)
+  (Lisp_Object buffer)
+{
+  if (NILP (buffer))
+    XSETBUFFER (buffer, current_buffer);
+  CHECK_BUFFER (buffer);
+  materialize_buffer (buffer);
+  return buffer;
+}
+
 DEFUN ("buffer-list", Fbuffer_list, Sbuffer_list, 0, 1, 0,
        doc: /* Return a list of all existing live buffers.
 If the optional arg FRAME is a frame, we return the buffer list in the
@@ -454,6 +523,118 @@ assoc_ignore_text_properties (register Lisp_Object key, Lisp_Object list)
   return Qnil;
 }
 
+/* Hash tables of the live buffers by name, and by file name and file
+   truename, or nil before init_buffer has made them.  Buffer names
+   are unique and only change here, so buffer_name_index is kept up to
+   date.  File names are also set from Lisp, so the other two tables
+   are rebuilt when they are next needed after a change has cleared
+   buffer_file_index_valid.  A file name visited by several buffers
+   maps to t there.  */
+
+static Lisp_Object buffer_name_index;
+static Lisp_Object buffer_file_index, buffer_truename_index;
+bool buffer_file_index_valid;
+
+static Lisp_Object
+make_buffer_index (void)
+{
+  return make_hash_table (hashtest_equal, make_number (DEFAULT_HASH_SIZE),
+			  make_float (DEFAULT_REHASH_SIZE),
+			  make_float (DEFAULT_REHASH_THRESHOLD),
+			  Qnil);
+}
+
+/* Record that BUFFER is named NAME.  */
+
+static void
+index_buffer_name (Lisp_Object name, Lisp_Object buffer)
+{
+  if (!NILP (buffer_name_index))
+    {
+      struct Lisp_Hash_Table *h = XHASH_TABLE (buffer_name_index);
+      EMACS_UINT hash;
+      ptrdiff_t i = hash_lookup (h, name, &hash);
+
+      if (i >= 0)
+	set_hash_value_slot (h, i, buffer);
+      else
+	hash_put (h, name, buffer, hash);
+    }
+}
+
+static void
+unindex_buffer_name (Lisp_Object name)
+{
+  if (!NILP (buffer_name_index))
+    hash_remove_from_table (XHASH_TABLE (buffer_name_index), name);
+}
+
+/* Add BUFFER to INDEX under KEY, unless KEY is not a string.  */
+
+static void
+index_buffer_file (Lisp_Object index, Lisp_Object key, Lisp_Object buffer)
+{
+  struct Lisp_Hash_Table *h = XHASH_TABLE (index);
+  EMACS_UINT hash;
+  ptrdiff_t i;
+
+  if (!STRINGP (key))
+    return;
+  i = hash_lookup (h, key, &hash);
+  if (i >= 0)
+    set_hash_value_slot (h, i, Qt);
+  else
+    hash_put (h, key, buffer, hash);
+}
+
+/* Return the live buffer whose file name, or file truename if
+   TRUENAME, is FILENAME.  */
+
+static Lisp_Object
+find_file_buffer (Lisp_Object filename, bool truename)
+{
+  Lisp_Object tail, buf, index;
+
+  if (!NILP (buffer_file_index))
+    {
+      if (!buffer_file_index_valid)
+	{
+	  Fclrhash (buffer_file_index);
+	  Fclrhash (buffer_truename_index);
+	  FOR_EACH_LIVE_BUFFER (tail, buf)
+	    {
+	      index_buffer_file (buffer_file_index,
+				 BVAR (XBUFFER (buf), filename), buf);
+	      index_buffer_file (buffer_truename_index,
+				 BVAR (XBUFFER (buf), file_truename), buf);
+	    }
+	  buffer_file_index_valid = 1;
+	}
+
+      index = truename ? buffer_truename_index : buffer_file_index;
+      {
+	struct Lisp_Hash_Table *h = XHASH_TABLE (index);
+	ptrdiff_t i = hash_lookup (h, filename, NULL);
+
+	if (i < 0)
+	  return Qnil;
+	/* Unless several buffers visit FILENAME, we are done.  */
+	if (BUFFERP (HASH_VALUE (h, i)))
+	  return HASH_VALUE (h, i);
+      }
+    }
+
+  FOR_EACH_LIVE_BUFFER (tail, buf)
+    {
+      Lisp_Object name = (truename
+			  ? BVAR (XBUFFER (buf), file_truename)
+			  : BVAR (XBUFFER (buf), filename));
+      if (STRINGP (name) && !NILP (Fstring_equal (name, filename)))
+	return buf;
+    }
+  return Qnil;
+}
+
 DEFUN ("get-buffer", Fget_buffer, Sget_buffer, 1, 1, 0,
        doc: /* Return the buffer named BUFFER-OR-NAME.
 BUFFER-OR-NAME must be either a string or a buffer.  If BUFFER-OR-NAME
@@ -465,6 +646,14 @@ BUFFER-OR-NAME is a buffer, return it as given.  */)
     return buffer_or_name;
   CHECK_STRING (buffer_or_name);
 
+  if (!NILP (buffer_name_index))
+    {
+      struct Lisp_Hash_Table *h = XHASH_TABLE (buffer_name_index);
+      ptrdiff_t i = hash_lookup (h, buffer_or_name, NULL);
+
+      return i >= 0 ? HASH_VALUE (h, i) : Qnil;
+    }
+
   return Fcdr (assoc_ignore_text_properties (buffer_or_name, Vbuffer_alist));
 }
 
@@ -475,7 +664,7 @@ If there is no such live buffer, return nil.
 See also `find-buffer-visiting'.  */)
   (register Lisp_Object filename)
 {
-  register Lisp_Object tail, buf, handler;
+  register Lisp_Object handler;
 
   CHECK_STRING (filename);
   filename = Fexpand_file_name (filename, Qnil);
@@ -490,27 +679,13 @@ See also `find-buffer-visiting'.  */)
       return BUFFERP (handled_buf) ? handled_buf : Qnil;
     }
 
-  FOR_EACH_LIVE_BUFFER (tail, buf)
-    {
-      if (!STRINGP (BVAR (XBUFFER (buf), filename))) continue;
-      if (!NILP (Fstring_equal (BVAR (XBUFFER (buf), filename), filename)))
-	return buf;
-    }
-  return Qnil;
+  return find_file_buffer (filename, 0);
 }
 
 Lisp_Object
 get_truename_buffer (register Lisp_Object filename)
 {
-  register Lisp_Object tail, buf;
-
-  FOR_EACH_LIVE_BUFFER (tail, buf)
-    {
-      if (!STRINGP (BVAR (XBUFFER (buf), file_truename))) continue;
-      if (!NILP (Fstring_equal (BVAR (XBUFFER (buf), file_truename), filename)))
-	return buf;
-    }
-  return Qnil;
+  return find_file_buffer (filename, 1);
 }
 
 DEFUN ("get-buffer-create", Fget_buffer_create, Sget_buffer_create, 1, 1, 0,
@@ -576,7 +751,11 @@ even if it is dead.  The return value is never nil.  */)
   BUF_END_UNCHANGED (b) = 0;
   BUF_BEG_UNCHANGED (b) = 0;
   *(BUF_GPT_ADDR (b)) = *(BUF_Z_ADDR (b)) = 0; /* Put an anchor '\0'.  */
+  b->text->gap_moves = 0;
+  b->text->gap_moved_bytes = 0;
+  b->text->gap_growth = 0;
   b->text->inhibit_shrinking = false;
+  b->text->rtl = false;
   b->text->redisplay = false;
 
   b->newline_cache = 0;
@@ -606,6 +785,7 @@ even if it is dead.  The return value is never nil.  */)
   /* Put this in the alist of all live buffers.  */
   XSETBUFFER (buffer, b);
   Vbuffer_alist = nconc2 (Vbuffer_alist, list1 (Fcons (name, buffer)));
+  index_buffer_name (name, buffer);
   /* And run buffer-list-update-hook.  */
   if (!NILP (Vrun_hooks))
     call1 (Vrun_hooks, Qbuffer_list_update_hook);
@@ -653,12 +833,14 @@ static void
 set_buffer_overlays_before (struct buffer *b, struct Lisp_Overlay *o)
 {
   b->overlays_before = o;
+  invalidate_overlay_index (b);
 }
 
 static void
 set_buffer_overlays_after (struct buffer *b, struct Lisp_Overlay *o)
 {
   b->overlays_after = o;
+  invalidate_overlay_index (b);
 }
 
 /* Clone per-buffer values of buffer FROM.
@@ -818,6 +1000,7 @@ CLONE nil means the indirect buffer's state is reset to default values.  */)
   /* Put this in the alist of all live buffers.  */
   XSETBUFFER (buf, b);
   Vbuffer_alist = nconc2 (Vbuffer_alist, list1 (Fcons (name, buf)));
+  index_buffer_name (name, buf);
 
   bset_mark (b, Fmake_marker ());
 
@@ -938,6 +1121,8 @@ reset_buffer (register struct buffer *b)
   /* It is more conservative to start out "changed" than "unchanged".  */
   b->clip_changed = 0;
   b->prevent_redisplay_optimizations_p = 1;
+  b->long_line_optimizations_p = 0;
+  b->placeholder = Qnil;
   bset_backed_up (b, Qnil);
   BUF_AUTOSAVE_MODIFF (b) = 0;
   b->auto_save_failure_time = 0;
@@ -1035,6 +1220,7 @@ reset_buffer_local_variables (struct buffer *b, bool permanent_too)
 	  bset_local_var_alist (b, XCDR (tmp));
 	else
 	  XSETCDR (last, XCDR (tmp));
+      b->local_var_tick++;
     }
 
   for (i = 0; i < last_per_buffer_idx; ++i)
@@ -1513,7 +1699,9 @@ This does not change the name of the visited file (if any).  */)
   update_mode_lines = 11;
 
   XSETBUFFER (buf, current_buffer);
+  unindex_buffer_name (Fcar (Frassq (buf, Vbuffer_alist)));
   Fsetcar (Frassq (buf, Vbuffer_alist), newname);
+  index_buffer_name (newname, buf);
   if (NILP (BVAR (current_buffer, filename))
       && !NILP (BVAR (current_buffer, auto_save_file_name)))
     call0 (intern ("rename-auto-save-file"));
@@ -1677,6 +1865,7 @@ compact_buffer (struct buffer *buffer)
 					   GAP_BYTES_DFL);
 	  if (BUF_GAP_SIZE (buffer) > size)
 	    make_gap_1 (buffer, -(BUF_GAP_SIZE (buffer) - size));
+	  buffer->text->gap_growth = 0;
 	}
       BUF_COMPACT (buffer) = BUF_MODIFF (buffer);
     }
@@ -1851,7 +2040,9 @@ cleaning up all windows currently displaying the buffer to be killed. */)
   tem = Vinhibit_quit;
   Vinhibit_quit = Qt;
   /* Remove the buffer from the list of all buffers.  */
+  unindex_buffer_name (BVAR (b, name));
   Vbuffer_alist = Fdelq (Frassq (buffer, Vbuffer_alist), Vbuffer_alist);
+  buffer_file_index_valid = 0;
   /* If replace_buffer_in_windows didn't do its job fix that now.  */
   replace_buffer_in_windows_safely (buffer);
   Vinhibit_quit = tem;
@@ -1920,6 +2111,7 @@ cleaning up all windows currently displaying the buffer to be killed. */)
      either.  */
   b->overlays_before = NULL;
   b->overlays_after = NULL;
+  b->overlay_index = NULL;
 
   /* Reset the local variables, so that this buffer's local values
      won't be protected from GC.  They would be protected
@@ -2251,6 +2443,7 @@ so the buffer is truly empty after this.  */)
   del_range (BEG, Z);
 
   current_buffer->last_window_start = 1;
+  current_buffer->long_line_optimizations_p = 0;
   /* Prevent warnings, or suspension of auto saving, that would happen
      if future size is less than past size.  Use of erase-buffer
      implies that the future text is not really related to the past text.  */
@@ -2381,6 +2574,7 @@ DEFUN ("buffer-swap-text", Fbuffer_swap_text, Sbuffer_swap_text,
   swapfield (overlays_before, struct Lisp_Overlay *);
   swapfield (overlays_after, struct Lisp_Overlay *);
   swapfield (overlay_center, ptrdiff_t);
+  swapfield (overlay_index, struct overlay_index *);
   swapfield_ (undo_list, Lisp_Object);
   swapfield_ (mark, Lisp_Object);
   swapfield_ (enable_multibyte_characters, Lisp_Object);
@@ -2493,6 +2687,7 @@ current buffer is cleared.  */)
 
   /* If the cached position is for this buffer, clear it out.  */
   clear_charpos_cache (current_buffer);
+  invalidate_overlay_index (current_buffer);
 
   if (NILP (flag))
     begv = BEGV_BYTE, zv = ZV_BYTE;
@@ -2701,6 +2896,11 @@ current buffer is cleared.  */)
 
       BUF_MARKERS (current_buffer) = markers;
 
+      /* The bytes may now form right-to-left characters.  */
+      if (multibyte_text_rtl_p (BEG_ADDR, GPT_BYTE - BEG_BYTE)
+	  || multibyte_text_rtl_p (GAP_END_ADDR, Z_BYTE - GPT_BYTE))
+	note_rtl_text ();
+
       /* Do this last, so it can calculate the new correspondences
 	 between chars and bytes.  */
       set_intervals_multibyte (1);
@@ -2813,6 +3013,236 @@ swap_out_buffer_local_variables (struct buffer *b)
     }
 }
 
+/* The overlay index.
+
+   Walking overlays_before and overlays_after costs time proportional
+   to the number of overlays, and redisplay asks about overlays at each
+   position where something changes.  So the overlay queries below
+   work instead on a snapshot of the buffer's overlays sorted by start
+   position, built when first needed and discarded whenever an overlay
+   is added, removed or moved, or the text changes.  Each entry of
+   MAX_END is the largest end position in the implicit binary tree
+   rooted at the middle entry of a range, as in an interval tree, so a
+   query visits O(log N + K) entries to find K overlays.  */
+
+struct overlay_index_entry
+{
+  ptrdiff_t start, end;
+  Lisp_Object overlay;
+};
+
+struct overlay_index
+{
+  bool valid;
+  ptrdiff_t n, size;
+
+  /* The overlays, sorted by start position.  */
+  struct overlay_index_entry *entries;
+
+  /* The largest end position in each subtree; see above.  */
+  ptrdiff_t *max_end;
+
+  /* All end positions in increasing order.  */
+  ptrdiff_t *ends;
+};
+
+/* Discard the overlay index of B, and of any buffer sharing its text,
+   whose overlays move with it.  */
+
+void
+invalidate_overlay_index (struct buffer *b)
+{
+  if (b->indirections == 0)
+    {
+      if (b->overlay_index)
+	b->overlay_index->valid = false;
+    }
+  else
+    {
+      struct buffer *other;
+
+      FOR_EACH_BUFFER (other)
+	if (other->text == b->text && other->overlay_index)
+	  other->overlay_index->valid = false;
+    }
+}
+
+static int
+compare_overlay_index_entries (const void *a, const void *b)
+{
+  const struct overlay_index_entry *e1 = a, *e2 = b;
+  return e1->start < e2->start ? -1 : e1->start > e2->start;
+}
+
+static int
+compare_positions (const void *a, const void *b)
+{
+  ptrdiff_t p1 = *(const ptrdiff_t *) a, p2 = *(const ptrdiff_t *) b;
+  return p1 < p2 ? -1 : p1 > p2;
+}
+
+/* Compute INDEX->max_end for the subtree of entries LO..HI-1, and
+   return it.  */
+
+static ptrdiff_t
+fill_overlay_max_end (struct overlay_index *index, ptrdiff_t lo, ptrdiff_t hi)
+{
+  ptrdiff_t mid, m;
+
+  if (lo >= hi)
+    return PTRDIFF_MIN;
+  mid = lo + (hi - lo) / 2;
+  m = max (index->entries[mid].end,
+	   max (fill_overlay_max_end (index, lo, mid),
+		fill_overlay_max_end (index, mid + 1, hi)));
+  index->max_end[mid] = m;
+  return m;
+}
+
+static void
+add_to_overlay_index (struct overlay_index *index, struct Lisp_Overlay *tail)
+{
+  for (; tail; tail = tail->next)
+    {
+      Lisp_Object overlay;
+      struct overlay_index_entry *e;
+
+      XSETMISC (overlay, tail);
+      if (index->n == index->size)
+	{
+	  index->entries = xpalloc (index->entries, &index->size, 1,
+				    OVERLAY_COUNT_MAX, sizeof *index->entries);
+	  index->max_end = xnrealloc (index->max_end, index->size,
+				      sizeof *index->max_end);
+	  index->ends = xnrealloc (index->ends, index->size,
+				   sizeof *index->ends);
+	}
+      e = &index->entries[index->n];
+      e->overlay = overlay;
+      e->start = OVERLAY_POSITION (OVERLAY_START (overlay));
+      e->end = OVERLAY_POSITION (OVERLAY_END (overlay));
+      index->ends[index->n] = e->end;
+      index->n++;
+    }
+}
+
+/* Return the up-to-date overlay index of the current buffer.  */
+
+static struct overlay_index *
+current_overlay_index (void)
+{
+  struct overlay_index *index = current_buffer->overlay_index;
+
+  if (!index)
+    {
+      index = xzalloc (sizeof *index);
+      current_buffer->overlay_index = index;
+    }
+  if (!index->valid)
+    {
+      index->n = 0;
+      add_to_overlay_index (index, current_buffer->overlays_before);
+      add_to_overlay_index (index, current_buffer->overlays_after);
+      qsort (index->entries, index->n, sizeof *index->entries,
+	     compare_overlay_index_entries);
+      qsort (index->ends, index->n, sizeof *index->ends, compare_positions);
+      fill_overlay_max_end (index, 0, index->n);
+      index->valid = true;
+    }
+  return index;
+}
+
+/* Return the number of entries of INDEX whose start position is less
+   than POS, or at most POS if INCLUSIVE.  */
+
+static ptrdiff_t
+overlay_index_count_starts (struct overlay_index *index, ptrdiff_t pos,
+			    bool inclusive)
+{
+  ptrdiff_t lo = 0, hi = index->n;
+
+  while (lo < hi)
+    {
+      ptrdiff_t mid = lo + (hi - lo) / 2;
+      ptrdiff_t start = index->entries[mid].start;
+      if (start < pos || (inclusive && start == pos))
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+/* Likewise for end positions less than POS.  */
+
+static ptrdiff_t
+overlay_index_count_ends (struct overlay_index *index, ptrdiff_t pos)
+{
+  ptrdiff_t lo = 0, hi = index->n;
+
+  while (lo < hi)
+    {
+      ptrdiff_t mid = lo + (hi - lo) / 2;
+      if (index->ends[mid] < pos)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+/* State of an overlay index query: the vector being filled, as in
+   overlays_at and overlays_in.  */
+
+struct overlay_query
+{
+  Lisp_Object **vec_ptr;
+  ptrdiff_t *len_ptr;
+  ptrdiff_t idx;
+  bool extend;
+};
+
+static void
+overlay_query_store (struct overlay_query *q, Lisp_Object overlay)
+{
+  if (q->idx == *q->len_ptr && q->extend)
+    *q->vec_ptr = xpalloc (*q->vec_ptr, q->len_ptr, 1, OVERLAY_COUNT_MAX,
+			   sizeof **q->vec_ptr);
+  if (q->idx < *q->len_ptr)
+    (*q->vec_ptr)[q->idx] = overlay;
+  /* Keep counting overlays even if we can't return them all.  */
+  q->idx++;
+}
+
+/* Store in Q the overlays among entries LO..HI-1 of INDEX that start
+   at or before END and end at or after BEG, and that satisfy the
+   conditions of overlays_at (if AT) or overlays_in.  */
+
+static void
+overlay_index_query (struct overlay_index *index, ptrdiff_t lo, ptrdiff_t hi,
+		     ptrdiff_t beg, ptrdiff_t end, bool at,
+		     struct overlay_query *q)
+{
+  while (lo < hi)
+    {
+      ptrdiff_t mid = lo + (hi - lo) / 2;
+      struct overlay_index_entry *e = &index->entries[mid];
+
+      if (index->max_end[mid] < beg)
+	return;
+      overlay_index_query (index, lo, mid, beg, end, at, q);
+      if (e->start > end)
+	return;
+      if (at
+	  ? e->start <= beg && beg < e->end
+	  : ((beg < e->end && e->start < end)
+	     || (e->start == e->end
+		 && (beg == e->end || (end == Z && e->end == end)))))
+	overlay_query_store (q, e->overlay);
+      lo = mid + 1;
+    }
+}
+
 /* Find all the overlays in the current buffer that contain position POS.
    Return the number found, and store them in a vector in *VEC_PTR.
    Store in *LEN_PTR the size allocated for the vector.
@@ -2840,126 +3270,51 @@ overlays_at (EMACS_INT pos, bool extend, Lisp_Object **vec_ptr,
 	     ptrdiff_t *len_ptr,
 	     ptrdiff_t *next_ptr, ptrdiff_t *prev_ptr, bool change_req)
 {
-  Lisp_Object overlay, start, end;
-  struct Lisp_Overlay *tail;
-  ptrdiff_t idx = 0;
-  ptrdiff_t len = *len_ptr;
-  Lisp_Object *vec = *vec_ptr;
-  ptrdiff_t next = ZV;
-  ptrdiff_t prev = BEGV;
-  bool inhibit_storing = 0;
-
-  for (tail = current_buffer->overlays_before; tail; tail = tail->next)
-    {
-      ptrdiff_t startpos, endpos;
+  struct overlay_index *index = current_overlay_index ();
+  struct overlay_query q = { vec_ptr, len_ptr, 0, extend };
 
-      XSETMISC (overlay, tail);
+  overlay_index_query (index, 0, index->n, pos, pos, true, &q);
 
-      start = OVERLAY_START (overlay);
-      end = OVERLAY_END (overlay);
-      endpos = OVERLAY_POSITION (end);
-      if (endpos < pos)
-	{
-	  if (prev < endpos)
-	    prev = endpos;
-	  break;
-	}
-      startpos = OVERLAY_POSITION (start);
-      /* This one ends at or after POS
-	 so its start counts for PREV_PTR if it's before POS.  */
-      if (prev < startpos && startpos < pos)
-	prev = startpos;
-      if (endpos == pos)
-	continue;
-      if (startpos <= pos)
-	{
-	  if (idx == len)
-	    {
-	      /* The supplied vector is full.
-		 Either make it bigger, or don't store any more in it.  */
-	      if (extend)
-		{
-		  vec = xpalloc (vec, len_ptr, 1, OVERLAY_COUNT_MAX,
-				 sizeof *vec);
-		  *vec_ptr = vec;
-		  len = *len_ptr;
-		}
-	      else
-		inhibit_storing = 1;
-	    }
-
-	  if (!inhibit_storing)
-	    vec[idx] = overlay;
-	  /* Keep counting overlays even if we can't return them all.  */
-	  idx++;
-	}
-      else if (startpos < next)
-	next = startpos;
+  if (next_ptr)
+    {
+      ptrdiff_t i = overlay_index_count_starts (index, pos, true);
+      *next_ptr = (i < index->n && index->entries[i].start < ZV
+		   ? index->entries[i].start : ZV);
     }
 
-  for (tail = current_buffer->overlays_after; tail; tail = tail->next)
+  if (prev_ptr)
     {
-      ptrdiff_t startpos, endpos;
-
-      XSETMISC (overlay, tail);
-
-      start = OVERLAY_START (overlay);
-      end = OVERLAY_END (overlay);
-      startpos = OVERLAY_POSITION (start);
-      if (pos < startpos)
-	{
-	  if (startpos < next)
-	    next = startpos;
-	  break;
-	}
-      endpos = OVERLAY_POSITION (end);
-      if (pos < endpos)
-	{
-	  if (idx == len)
+      /* The last place before POS where an overlay starts or ends.
+	 Overlays ending before POS started before their end.  */
+      ptrdiff_t prev = BEGV;
+      ptrdiff_t i = overlay_index_count_starts (index, pos, false);
+      ptrdiff_t j = overlay_index_count_ends (index, pos);
+
+      if (i > 0)
+	prev = max (prev, index->entries[i - 1].start);
+      if (j > 0)
+	prev = max (prev, index->ends[j - 1]);
+
+      /* An empty overlay at POS counts unless CHANGE_REQ.  */
+      if (!change_req)
+	for (; i < index->n && index->entries[i].start == pos; i++)
+	  if (index->entries[i].end == pos)
 	    {
-	      if (extend)
-		{
-		  vec = xpalloc (vec, len_ptr, 1, OVERLAY_COUNT_MAX,
-				 sizeof *vec);
-		  *vec_ptr = vec;
-		  len = *len_ptr;
-		}
-	      else
-		inhibit_storing = 1;
+	      prev = max (prev, pos);
+	      break;
 	    }
-
-	  if (!inhibit_storing)
-	    vec[idx] = overlay;
-	  idx++;
-
-	  if (startpos < pos && startpos > prev)
-	    prev = startpos;
-	}
-      else if (endpos < pos && endpos > prev)
-	prev = endpos;
-      else if (endpos == pos && startpos > prev
-	       && (!change_req || startpos < pos))
-	prev = startpos;
+      *prev_ptr = prev;
     }
 
-  if (next_ptr)
-    *next_ptr = next;
-  if (prev_ptr)
-    *prev_ptr = prev;
-  return idx;
+  return q.idx;
 }
-
+
 /* Find all the overlays in the current buffer that overlap the range
    BEG-END, or are empty at BEG, or are empty at END provided END
    denotes the position at the end of the current buffer.
 
    Return the number found, and store them in a vector in *VEC_PTR.
    Store in *LEN_PTR the size allocated for the vector.
-   Store in *NEXT_PTR the next position after POS where an overlay starts,
-     or ZV if there are no more overlays.
-   Store in *PREV_PTR the previous position before POS where an overlay ends,
-     or BEGV if there are no previous overlays.
-   NEXT_PTR and/or PREV_PTR may be 0, meaning don't store that info.
 
    *VEC_PTR and *LEN_PTR should contain a valid vector and size
    when this function is called.
@@ -2971,115 +3326,13 @@ overlays_at (EMACS_INT pos, bool extend, Lisp_Object **vec_ptr,
 
 static ptrdiff_t
 overlays_in (EMACS_INT beg, EMACS_INT end, bool extend,
-	     Lisp_Object **vec_ptr, ptrdiff_t *len_ptr,
-	     ptrdiff_t *next_ptr, ptrdiff_t *prev_ptr)
+	     Lisp_Object **vec_ptr, ptrdiff_t *len_ptr)
 {
-  Lisp_Object overlay, ostart, oend;
-  struct Lisp_Overlay *tail;
-  ptrdiff_t idx = 0;
-  ptrdiff_t len = *len_ptr;
-  Lisp_Object *vec = *vec_ptr;
-  ptrdiff_t next = ZV;
-  ptrdiff_t prev = BEGV;
-  bool inhibit_storing = 0;
-  bool end_is_Z = end == Z;
-
-  for (tail = current_buffer->overlays_before; tail; tail = tail->next)
-    {
-      ptrdiff_t startpos, endpos;
+  struct overlay_index *index = current_overlay_index ();
+  struct overlay_query q = { vec_ptr, len_ptr, 0, extend };
 
-      XSETMISC (overlay, tail);
-
-      ostart = OVERLAY_START (overlay);
-      oend = OVERLAY_END (overlay);
-      endpos = OVERLAY_POSITION (oend);
-      if (endpos < beg)
-	{
-	  if (prev < endpos)
-	    prev = endpos;
-	  break;
-	}
-      startpos = OVERLAY_POSITION (ostart);
-      /* Count an interval if it overlaps the range, is empty at the
-	 start of the range, or is empty at END provided END denotes the
-	 end of the buffer.  */
-      if ((beg < endpos && startpos < end)
-	  || (startpos == endpos
-	      && (beg == endpos || (end_is_Z && endpos == end))))
-	{
-	  if (idx == len)
-	    {
-	      /* The supplied vector is full.
-		 Either make it bigger, or don't store any more in it.  */
-	      if (extend)
-		{
-		  vec = xpalloc (vec, len_ptr, 1, OVERLAY_COUNT_MAX,
-				 sizeof *vec);
-		  *vec_ptr = vec;
-		  len = *len_ptr;
-		}
-	      else
-		inhibit_storing = 1;
-	    }
-
-	  if (!inhibit_storing)
-	    vec[idx] = overlay;
-	  /* Keep counting overlays even if we can't return them all.  */
-	  idx++;
-	}
-      else if (startpos < next)
-	next = startpos;
-    }
-
-  for (tail = current_buffer->overlays_after; tail; tail = tail->next)
-    {
-      ptrdiff_t startpos, endpos;
-
-      XSETMISC (overlay, tail);
-
-      ostart = OVERLAY_START (overlay);
-      oend = OVERLAY_END (overlay);
-      startpos = OVERLAY_POSITION (ostart);
-      if (end < startpos)
-	{
-	  if (startpos < next)
-	    next = startpos;
-	  break;
-	}
-      endpos = OVERLAY_POSITION (oend);
-      /* Count an interval if it overlaps the range, is empty at the
-	 start of the range, or is empty at END provided END denotes the
-	 end of the buffer.  */
-      if ((beg < endpos && startpos < end)
-	  || (startpos == endpos
-	      && (beg == endpos || (end_is_Z && endpos == end))))
-	{
-	  if (idx == len)
-	    {
-	      if (extend)
-		{
-		  vec = xpalloc (vec, len_ptr, 1, OVERLAY_COUNT_MAX,
-				 sizeof *vec);
-		  *vec_ptr = vec;
-		  len = *len_ptr;
-		}
-	      else
-		inhibit_storing = 1;
-	    }
-
-	  if (!inhibit_storing)
-	    vec[idx] = overlay;
-	  idx++;
-	}
-      else if (endpos < beg && endpos > prev)
-	prev = endpos;
-    }
-
-  if (next_ptr)
-    *next_ptr = next;
-  if (prev_ptr)
-    *prev_ptr = prev;
-  return idx;
+  overlay_index_query (index, 0, index->n, beg, end, false, &q);
+  return q.idx;
 }
 
 
@@ -3096,11 +3349,11 @@ mouse_face_overlay_overlaps (Lisp_Object overlay)
 
   size = 10;
   v = alloca (size * sizeof *v);
-  n = overlays_in (start, end, 0, &v, &size, NULL, NULL);
+  n = overlays_in (start, end, 0, &v, &size);
   if (n > size)
     {
       v = alloca (n * sizeof *v);
-      overlays_in (start, end, 0, &v, &n, NULL, NULL);
+      overlays_in (start, end, 0, &v, &n);
     }
 
   for (i = 0; i < n; ++i)
@@ -3188,6 +3441,30 @@ compare_overlays (const void *v1, const void *v2)
     return XLI (s1->overlay) < XLI (s2->overlay) ? -1 : 1;
 }
 
+/* Fill in S for OVERLAY, which spans BEG..END.  */
+
+static void
+fill_sortvec (struct sortvec *s, Lisp_Object overlay,
+	      ptrdiff_t beg, ptrdiff_t end)
+{
+  Lisp_Object tem = Foverlay_get (overlay, Qpriority);
+
+  s->overlay = overlay;
+  s->beg = beg;
+  s->end = end;
+  s->priority = 0;
+  s->spriority = 0;
+  if (INTEGERP (tem))
+    s->priority = XINT (tem);
+  else if (CONSP (tem))
+    {
+      Lisp_Object car = XCAR (tem);
+      Lisp_Object cdr = XCDR (tem);
+      s->priority  = INTEGERP (car) ? XINT (car) : 0;
+      s->spriority = INTEGERP (cdr) ? XINT (cdr) : 0;
+    }
+}
+
 /* Sort an array of overlays by priority.  The array is modified in place.
    The return value is the new size; this may be smaller than the original
    size if some of the overlays were invalid or were window-specific.  */
@@ -3204,7 +3481,6 @@ sort_overlays (Lisp_Object *overlay_vec, ptrdiff_t noverlays, struct window *w)
 
   for (i = 0, j = 0; i < noverlays; i++)
     {
-      Lisp_Object tem;
       Lisp_Object overlay;
 
       overlay = overlay_vec[i];
@@ -3224,27 +3500,9 @@ sort_overlays (Lisp_Object *overlay_vec, ptrdiff_t noverlays, struct window *w)
 	    }
 
 	  /* This overlay is good and counts: put it into sortvec.  */
-	  sortvec[j].overlay = overlay;
-	  sortvec[j].beg = OVERLAY_POSITION (OVERLAY_START (overlay));
-	  sortvec[j].end = OVERLAY_POSITION (OVERLAY_END (overlay));
-	  tem = Foverlay_get (overlay, Qpriority);
-	  if (NILP (tem))
-	    {
-	      sortvec[j].priority = 0;
-	      sortvec[j].spriority = 0;
-	    }
-	  else if (INTEGERP (tem))
-	    {
-	      sortvec[j].priority = XINT (tem);
-	      sortvec[j].spriority = 0;
-	    }
-	  else if (CONSP (tem))
-	    {
-	      Lisp_Object car = XCAR (tem);
-	      Lisp_Object cdr = XCDR (tem);
-	      sortvec[j].priority  = INTEGERP (car) ? XINT (car) : 0;
-	      sortvec[j].spriority = INTEGERP (cdr) ? XINT (cdr) : 0;
-	    }
+	  fill_sortvec (&sortvec[j], overlay,
+			OVERLAY_POSITION (OVERLAY_START (overlay)),
+			OVERLAY_POSITION (OVERLAY_END (overlay)));
 	  j++;
 	}
     }
@@ -3262,6 +3520,92 @@ sort_overlays (Lisp_Object *overlay_vec, ptrdiff_t noverlays, struct window *w)
   return (noverlays);
 }
 
+/* State of a search for the overlay with the highest priority among
+   those at a position that have a non-nil value for a property.  */
+
+struct overlay_prop_query
+{
+  Lisp_Object prop;
+  struct window *w;
+  bool found;
+  struct sortvec best;
+  Lisp_Object value;
+};
+
+static void
+overlay_index_prop_query (struct overlay_index *index, ptrdiff_t lo,
+			  ptrdiff_t hi, ptrdiff_t pos,
+			  struct overlay_prop_query *q)
+{
+  while (lo < hi)
+    {
+      ptrdiff_t mid = lo + (hi - lo) / 2;
+      struct overlay_index_entry *e = &index->entries[mid];
+
+      if (index->max_end[mid] < pos)
+	return;
+      overlay_index_prop_query (index, lo, mid, pos, q);
+      if (e->start > pos)
+	return;
+      if (e->start <= pos && pos < e->end)
+	{
+	  Lisp_Object tem = Foverlay_get (e->overlay, q->prop);
+
+	  if (!NILP (tem))
+	    {
+	      Lisp_Object window = (q->w ? Foverlay_get (e->overlay, Qwindow)
+				    : Qnil);
+
+	      if (!WINDOWP (window) || XWINDOW (window) == q->w)
+		{
+		  struct sortvec s;
+
+		  fill_sortvec (&s, e->overlay, e->start, e->end);
+		  if (!q->found || compare_overlays (&s, &q->best) > 0)
+		    {
+		      q->found = true;
+		      q->best = s;
+		      q->value = tem;
+		    }
+		}
+	    }
+	}
+      lo = mid + 1;
+    }
+}
+
+/* Return the value of PROP in the overlay with the highest priority,
+   in the order of sort_overlays, among the overlays of the current
+   buffer that contain POS and have a non-nil PROP.  If W is non-null,
+   ignore overlays limited to some other window.  Store that overlay in
+   *OVERLAY, or nil if there is none, in which case return nil.
+
+   This gives the same answer as collecting the overlays at POS with
+   overlays_at, sorting them and taking the first one with PROP, but
+   allocates nothing and sorts nothing.  */
+
+Lisp_Object
+overlay_property_at (ptrdiff_t pos, Lisp_Object prop, struct window *w,
+		     Lisp_Object *overlay)
+{
+  struct overlay_prop_query q;
+
+  q.prop = prop;
+  q.w = w;
+  q.found = false;
+  q.value = Qnil;
+  *overlay = Qnil;
+  if (!buffer_has_overlays ())
+    return Qnil;
+  {
+    struct overlay_index *index = current_overlay_index ();
+    overlay_index_prop_query (index, 0, index->n, pos, &q);
+  }
+  if (q.found)
+    *overlay = q.best.overlay;
+  return q.value;
+}
+
 struct sortstr
 {
   Lisp_Object string, string2;
@@ -3648,6 +3992,8 @@ fix_start_end_in_overlays (register ptrdiff_t start, register ptrdiff_t end)
   struct Lisp_Overlay *tail, *parent;
   ptrdiff_t startpos, endpos;
 
+  invalidate_overlay_index (current_buffer);
+
   /* This algorithm shifts links around instead of consing and GCing.
      The loop invariant is that before_list (resp. after_list) is a
      well-formed list except that its last element, the CDR of beforep
@@ -4244,8 +4590,7 @@ end of the buffer.  */)
 
   /* Put all the overlays we want in a vector in overlay_vec.
      Store the length in len.  */
-  noverlays = overlays_in (XINT (beg), XINT (end), 1, &overlay_vec, &len,
-			   NULL, NULL);
+  noverlays = overlays_in (XINT (beg), XINT (end), 1, &overlay_vec, &len);
 
   /* Make a list of them all.  */
   result = Flist (noverlays, overlay_vec);
@@ -5258,6 +5603,9 @@ init_buffer_once (void)
   last_per_buffer_idx = idx;
 
   Vbuffer_alist = Qnil;
+  buffer_name_index = Qnil;
+  buffer_file_index = Qnil;
+  buffer_truename_index = Qnil;
   current_buffer = 0;
   all_buffers = 0;
 
@@ -5288,9 +5636,17 @@ void
 init_buffer (int initialized)
 {
   char *pwd;
-  Lisp_Object temp;
+  Lisp_Object temp, tail, buf;
   ptrdiff_t len;
 
+  /* Hash tables can be made now; index the buffers made so far.  */
+  buffer_name_index = make_buffer_index ();
+  buffer_file_index = make_buffer_index ();
+  buffer_truename_index = make_buffer_index ();
+  buffer_file_index_valid = 0;
+  FOR_EACH_LIVE_BUFFER (tail, buf)
+    index_buffer_name (BVAR (XBUFFER (buf), name), buf);
+
 #ifdef USE_MMAP_FOR_BUFFERS
   if (initialized)
     {
@@ -5438,6 +5794,9 @@ syms_of_buffer (void)
   staticpro (&Qmode_class);
   staticpro (&QSFundamental);
   staticpro (&Vbuffer_alist);
+  staticpro (&buffer_name_index);
+  staticpro (&buffer_file_index);
+  staticpro (&buffer_truename_index);
   staticpro (&Qprotected_field);
   staticpro (&Qpermanent_local);
   staticpro (&Qkill_buffer_hook);
@@ -416,6 +416,14 @@ extern void enlarge_buffer_text (struct buffer *, ptrdiff_t);
 /* This data structure describes the actual text contents of a buffer.
    It is shared between indirect buffers and their base buffer.  */
 
+/* A character position and the byte position where that character
+   starts.  */
+struct pos_index_entry
+  {
+    ptrdiff_t charpos;
+    ptrdiff_t bytepos;
+  };
+
 struct buffer_text
   {
     /* Actual address of buffer contents.  If REL_ALLOC is defined,
@@ -472,11 +480,39 @@ struct buffer_text
        to move a marker within a buffer.  */
     struct Lisp_Marker *markers;
 
+    /* Known character/byte position pairs, about POS_INDEX_INTERVAL
+       bytes apart and in increasing order, used to convert between
+       positions in multibyte text without walking MARKERS.  Only the
+       first POS_INDEX_VALID entries are correct; a change to the text
+       discards the entries after it.  See marker.c.  */
+    struct pos_index_entry *pos_index;
+    ptrdiff_t pos_index_size;
+    ptrdiff_t pos_index_valid;
+
+    /* How many times the gap was moved, and how many bytes of text
+       were copied to move it, since the buffer was made.  */
+    EMACS_INT gap_moves;
+    EMACS_INT gap_moved_bytes;
+
+    /* How much extra space make_gap_larger gave the gap the last time.
+       It doubles each time the gap has to grow again before
+       compact_buffer shrinks it, so that a buffer that keeps growing
+       does not move the text after the gap for every GAP_BYTES_DFL
+       bytes inserted.  */
+    ptrdiff_t gap_growth;
+
     /* Usually false.  Temporarily true in decode_coding_gap to
        prevent Fgarbage_collect from shrinking the gap and losing
        not-yet-decoded bytes.  */
     bool_bf inhibit_shrinking : 1;
 
+    /* True if the text may have a strong right-to-left character or a
+       right-to-left directional control, see char_rtl_p.  Set when
+       such a character is inserted into multibyte text and cleared
+       only when the text is erased, so that redisplay need not reorder
+       text that is known to be left-to-right.  */
+    bool_bf rtl : 1;
+
     /* True if it needs to be redisplayed.  */
     bool_bf redisplay : 1;
   };
@@ -485,6 +521,20 @@ struct buffer_text
 
 #define BVAR(buf, field) ((buf)->INTERNAL_FIELD (field))
 
+/* Most number of separate ranges of changed text a buffer keeps for
+   `deferred-change-functions'; beyond that, the closest ones are
+   merged.  */
+enum { DEFERRED_CHANGE_RANGES = 8 };
+
+/* An entry of a buffer's cache of local variable bindings: CELL is
+   the variable's element of local_var_alist, or nil if it has none,
+   as of the buffer's local_var_tick TICK.  */
+struct local_var_cache_entry
+{
+  Lisp_Object cell;
+  EMACS_INT tick;
+};
+
 /* This is the structure that the buffer Lisp object points to.  */
 
 struct buffer
@@ -854,6 +904,16 @@ struct buffer
   /* Non-zero whenever the narrowing is changed in this buffer.  */
   bool_bf clip_changed : 1;
 
+  /* Non-zero means redisplay found lines longer than
+     `long-line-threshold' in this buffer.  */
+  bool_bf long_line_optimizations_p : 1;
+
+  /* Non-nil in a placeholder buffer, whose text and modes have not
+     been filled in yet.  This is the function that fills them in,
+     which materialize_buffer calls the first time the buffer is shown
+     in a window.  */
+  Lisp_Object placeholder;
+
   /* List of overlays that end at or before the current center,
      in order of end-position.  */
   struct Lisp_Overlay *overlays_before;
@@ -865,6 +925,31 @@ struct buffer
   /* Position where the overlay lists are centered.  */
   ptrdiff_t overlay_center;
 
+  /* The overlays above sorted by position, for answering overlay queries
+     without walking the lists, or NULL.  See buffer.c.  */
+  struct overlay_index *overlay_index;
+
+  /* Running estimate of the memory used by undo_list, in the units
+     truncate_undo_list uses, or -1 if unknown.  It is valid only while
+     undo_list is still undo_size_list, the list it was computed for;
+     Lisp code that sets `buffer-undo-list' invalidates it that way.  */
+  EMACS_INT undo_size;
+  Lisp_Object undo_size_list;
+
+  /* Text changed since `deferred-change-functions' last ran, as
+     DEFERRED_CHANGE_COUNT disjoint ranges sorted by position.  */
+  int deferred_change_count;
+  struct { ptrdiff_t beg, end; } deferred_changes[DEFERRED_CHANGE_RANGES];
+
+  /* Bindings of localized variables in local_var_alist, indexed by
+     their slot numbers, so that switching buffers does not cost an
+     assq per variable; see buffer_local_cell in data.c.  An entry is
+     valid only while its tick equals LOCAL_VAR_TICK, which is bumped
+     whenever local_var_alist changes.  */
+  struct local_var_cache_entry *local_var_cache;
+  ptrdiff_t local_var_cache_size;
+  EMACS_INT local_var_tick;
+
   /* Changes in the buffer are recorded here for undo, and t means
      don't record anything.  This information belongs to the base
      buffer of an indirect buffer.  But we can't store it in the
@@ -921,10 +1006,13 @@ bset_enable_multibyte_characters (struct buffer *b, Lisp_Object val)
 {
   b->INTERNAL_FIELD (enable_multibyte_characters) = val;
 }
+extern bool buffer_file_index_valid;
+
 INLINE void
 bset_filename (struct buffer *b, Lisp_Object val)
 {
   b->INTERNAL_FIELD (filename) = val;
+  buffer_file_index_valid = 0;
 }
 INLINE void
 bset_keymap (struct buffer *b, Lisp_Object val)
@@ -940,6 +1028,7 @@ INLINE void
 bset_local_var_alist (struct buffer *b, Lisp_Object val)
 {
   b->INTERNAL_FIELD (local_var_alist) = val;
+  b->local_var_tick++;
 }
 INLINE void
 bset_mark_active (struct buffer *b, Lisp_Object val)
@@ -1071,9 +1160,12 @@ extern void delete_all_overlays (struct buffer *);
 extern void reset_buffer (struct buffer *);
 extern void compact_buffer (struct buffer *);
 extern void evaporate_overlays (ptrdiff_t);
+extern void invalidate_overlay_index (struct buffer *);
 extern ptrdiff_t overlays_at (EMACS_INT, bool, Lisp_Object **,
 			      ptrdiff_t *, ptrdiff_t *, ptrdiff_t *, bool);
 extern ptrdiff_t sort_overlays (Lisp_Object *, ptrdiff_t, struct window *);
+extern Lisp_Object overlay_property_at (ptrdiff_t, Lisp_Object,
+					 struct window *, Lisp_Object *);
 extern void recenter_overlay_lists (struct buffer *, ptrdiff_t);
 extern ptrdiff_t overlay_strings (ptrdiff_t, struct window *, unsigned char **);
 extern void validate_region (Lisp_Object *, Lisp_Object *);
@@ -1081,6 +1173,7 @@ extern void set_buffer_internal_1 (struct buffer *);
 extern void set_buffer_temp (struct buffer *);
 extern Lisp_Object buffer_local_value (Lisp_Object, Lisp_Object);
 extern void record_buffer (Lisp_Object);
+extern void materialize_buffer (Lisp_Object);
 extern void fix_overlays_before (struct buffer *, ptrdiff_t, ptrdiff_t);
 extern void mmap_set_vars (bool);
 extern void restore_buffer (Lisp_Object);
@@ -1337,6 +1430,10 @@ INLINE void
 set_per_buffer_value (struct buffer *b, int offset, Lisp_Object value)
 {
   *(Lisp_Object *)(offset + (char *) b) = value;
+  /* Lisp can set `buffer-file-name' and `buffer-file-truename'.  */
+  if (offset == PER_BUFFER_VAR_OFFSET (filename)
+      || offset == PER_BUFFER_VAR_OFFSET (file_truename))
+    buffer_file_index_valid = 0;
 }
 
 /* Downcase a character C, or make no change if that cannot be done.  */
@@ -62,6 +62,13 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include "msdos.h"
 #endif
 
+/* Where the parent can poll the child's pipes, call-process-region
+   streams its input to the child instead of using a temporary file.  */
+#if !defined MSDOS && !defined WINDOWSNT
+#define CALLPROC_PIPE_INPUT
+#include <poll.h>
+#endif
+
 #ifdef HAVE_NS
 #include "nsterm.h"
 #endif
@@ -84,6 +91,27 @@ static pid_t synch_process_pid;
 
 static Lisp_Object synch_process_tempfile;
 
+#ifdef CALLPROC_PIPE_INPUT
+/* The input that call-process-region is streaming to the subprocess
+   through a pipe, if any.  Like the variables above, this is static
+   because call_process is never invoked reentrantly.  */
+static struct
+{
+  /* The write end of the pipe, or -1 if no input is being streamed.  */
+  int fd;
+
+  /* The string or buffer holding the input, and the part of it not
+     yet encoded: fixnums for a string, markers for a buffer.  */
+  Lisp_Object object, start, end;
+
+  /* The encoded text not yet written, and how much of it has been.  */
+  Lisp_Object encoded;
+  ptrdiff_t encoded_sent;
+
+  struct coding_system coding;
+} callproc_input = { .fd = -1 };
+#endif
+
 /* Indexes of file descriptors that need closing on call_process_kill.  */
 enum
   {
@@ -274,7 +302,231 @@ usage: (call-process PROGRAM &optional INFILE DESTINATION DISPLAY &rest ARGS)  *
   return tem0;
 }
 
+#ifdef CALLPROC_PIPE_INPUT
+
+/* Stop streaming input to the subprocess, which sees end of file.  */
+
+static void
+call_process_close_input (void)
+{
+  if (0 <= callproc_input.fd)
+    emacs_close (callproc_input.fd);
+  callproc_input.fd = -1;
+  if (MARKERP (callproc_input.start))
+    {
+      unchain_marker (XMARKER (callproc_input.start));
+      unchain_marker (XMARKER (callproc_input.end));
+    }
+  callproc_input.object = callproc_input.start = callproc_input.end = Qnil;
+  callproc_input.encoded = Qnil;
+}
+
+static ptrdiff_t
+call_process_input_pos (Lisp_Object pos)
+{
+  return MARKERP (pos) ? marker_position (pos) : XINT (pos);
+}
+
+/* Write as much of the streamed input to its pipe as the pipe takes
+   without blocking, encoding the next piece of it first if all the
+   encoded text has been written.  Encode only a piece at a time, so
+   that the input text is never copied all at once.  */
+
+static void
+call_process_send_input (void)
+{
+  enum { CALLPROC_INPUT_CHUNK = 64 * 1024 };
+  struct sigaction action, old_action;
+  ptrdiff_t left = SBYTES (callproc_input.encoded) - callproc_input.encoded_sent;
+  ssize_t written;
+
+  if (left == 0)
+    {
+      Lisp_Object object = callproc_input.object;
+      ptrdiff_t from = call_process_input_pos (callproc_input.start);
+      ptrdiff_t to = call_process_input_pos (callproc_input.end);
+      ptrdiff_t from_byte, to_byte;
+      bool old_immediate_quit = immediate_quit;
+
+      if (from >= to)
+	{
+	  call_process_close_input ();
+	  return;
+	}
+      to = min (to, from + CALLPROC_INPUT_CHUNK);
+      if (to == call_process_input_pos (callproc_input.end))
+	callproc_input.coding.mode |= CODING_MODE_LAST_BLOCK;
+
+      /* Encoding allocates, and may switch buffers.  */
+      immediate_quit = 0;
+      if (STRINGP (object))
+	{
+	  from_byte = string_char_to_byte (object, from);
+	  to_byte = string_char_to_byte (object, to);
+	  callproc_input.start = make_number (to);
+	}
+      else
+	{
+	  from_byte = buf_charpos_to_bytepos (XBUFFER (object), from);
+	  to_byte = buf_charpos_to_bytepos (XBUFFER (object), to);
+	  set_marker_both (callproc_input.start, object, to, to_byte);
+	}
+      encode_coding_object (&callproc_input.coding, object,
+			    from, from_byte, to, to_byte, Qt);
+      callproc_input.encoded = callproc_input.coding.dst_object;
+      callproc_input.encoded_sent = 0;
+      immediate_quit = old_immediate_quit;
+      left = SBYTES (callproc_input.encoded);
+      if (left == 0)
+	return;
+    }
+
+  /* In batch mode Emacs does not ignore SIGPIPE, but a subprocess that
+     stops reading its input should not kill Emacs.  */
+  action.sa_handler = SIG_IGN;
+  action.sa_flags = 0;
+  sigemptyset (&action.sa_mask);
+  sigaction (SIGPIPE, &action, &old_action);
+  written = write (callproc_input.fd,
+		   SSDATA (callproc_input.encoded) + callproc_input.encoded_sent,
+		   left);
+  sigaction (SIGPIPE, &old_action, 0);
+
+  if (0 <= written)
+    callproc_input.encoded_sent += written;
+  else if (! (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+    /* The subprocess does not want the rest of its input.  */
+    call_process_close_input ();
+}
+
+/* Wait until the subprocess output FD is readable or FD is negative,
+   streaming input to the subprocess meanwhile.  */
+
+static void
+call_process_wait_for_output (int fd)
+{
+  while (0 <= callproc_input.fd)
+    {
+      struct pollfd fds[2];
+      nfds_t nfds = 0;
+
+      fds[nfds].fd = callproc_input.fd;
+      fds[nfds++].events = POLLOUT;
+      if (0 <= fd)
+	{
+	  fds[nfds].fd = fd;
+	  fds[nfds++].events = POLLIN;
+	}
+      if (poll (fds, nfds, -1) < 0)
+	{
+	  if (errno == EINTR)
+	    {
+	      QUIT;
+	      continue;
+	    }
+	  call_process_close_input ();
+	  break;
+	}
+      if (fds[0].revents)
+	call_process_send_input ();
+      if (nfds > 1 && fds[1].revents)
+	break;
+    }
+}
+
+#endif /* CALLPROC_PIPE_INPUT */
+
+/* Like emacs_read, but for the output of call_process, feeding the
+   subprocess its streamed input until the output is readable.  */
+
+static ptrdiff_t
+call_process_read (int fd, void *buf, ptrdiff_t nbyte)
+{
+#ifdef CALLPROC_PIPE_INPUT
+  call_process_wait_for_output (fd);
+#endif
+  return emacs_read (fd, buf, nbyte);
+}
+
+/* Read all of the output of a subprocess from FD into the gap of the
+   current buffer at point, then decode it there with CODING and leave
+   point after it.  This avoids copying the output through a separate
+   buffer, and decodes it all at once.  Return the number of bytes
+   read.  */
+
+static EMACS_INT
+call_process_read_into_gap (int fd, struct coding_system *coding)
+{
+  enum { CALLPROC_GAP_READ_MIN = 64 * 1024 };
+  ptrdiff_t inserted = 0;
+
+  immediate_quit = 0;
+  prepare_to_modify_buffer (PT, PT, NULL);
+  move_gap_both (PT, PT_BYTE);
+
+  /* The text read is not part of the buffer until all of it is read,
+     so a quit meanwhile does no harm.  Grow the gap geometrically, so
+     that the read text is moved only a few times.  */
+  immediate_quit = 1;
+  QUIT;
+  while (1)
+    {
+      ptrdiff_t this_read;
+
+      if (GAP_SIZE - inserted < CALLPROC_GAP_READ_MIN)
+	{
+	  immediate_quit = 0;
+	  make_gap (max (CALLPROC_GAP_READ_MIN, inserted));
+	  immediate_quit = 1;
+	  QUIT;
+	}
+      this_read = call_process_read (fd, (char *) GPT_ADDR + inserted,
+				     GAP_SIZE - inserted);
+      if (this_read <= 0)
+	break;
+      inserted += this_read;
+    }
+  immediate_quit = 0;
+  coding->mode |= CODING_MODE_LAST_BLOCK;
+
+  if (NILP (BVAR (current_buffer, enable_multibyte_characters))
+      && ! CODING_MAY_REQUIRE_DECODING (coding))
+    {
+      if (inserted > 0)
+	{
+	  GAP_SIZE -= inserted;
+	  GPT += inserted;
+	  GPT_BYTE += inserted;
+	  ZV += inserted;
+	  ZV_BYTE += inserted;
+	  Z += inserted;
+	  Z_BYTE += inserted;
+	  if (GAP_SIZE > 0)
+	    *GPT_ADDR = 0;
+	  adjust_after_insert (PT, PT_BYTE, PT + inserted, PT_BYTE + inserted,
+			       inserted);
+	  TEMP_SET_PT_BOTH (PT + inserted, PT_BYTE + inserted);
+	}
+    }
+  else if (inserted > 0 || CODING_REQUIRE_FLUSHING (coding))
+    {
+      dynwind_begin ();
+      /* decode_coding_gap wants the undecoded text at the end of the
+	 gap.  */
+      memmove (GAP_END_ADDR - inserted, GPT_ADDR, inserted);
+      /* See the comment in call_process about modification hooks.  */
+      specbind (Qinhibit_modification_hooks, Qt);
+      decode_coding_gap (coding, inserted, inserted);
+      dynwind_end ();
+      TEMP_SET_PT_BOTH (PT + coding->produced_char,
+			PT_BYTE + coding->produced);
+    }
+  return inserted;
+}
+
 /* Like Fcall_process (NARGS, ARGS), except use FILEFD as the input file.
+   If FILEFD is the pipe set up by create_input_pipe, write the input
+   to the pipe while reading the output.
 
    If TEMPFILE_INDEX is nonnegative, it is the specpdl index of an
    unwinder that is intended to remove the input temporary file; in
@@ -766,7 +1018,23 @@ call_process (ptrdiff_t nargs, Lisp_Object *args, int *filefd, Lisp_Object *temp
   immediate_quit = 1;
   QUIT;
 
-  if (0 <= fd0)
+  /* Reading into the gap is not possible while the input is streamed
+     from the same buffer, as encoding the input may move the gap.  */
+  if (0 <= fd0 && !display_p
+#ifdef CALLPROC_PIPE_INPUT
+      && ! (0 <= callproc_input.fd
+	    && EQ (callproc_input.object, Fcurrent_buffer ()))
+#endif
+      )
+    {
+      EMACS_INT total_read = call_process_read_into_gap (fd0, &process_coding);
+
+      Vlast_coding_system_used = CODING_ID_NAME (process_coding.id);
+      if (inherit_process_coding_system)
+	call1 (intern ("after-insert-file-set-buffer-file-coding-system"),
+	       make_number (total_read));
+    }
+  else if (0 <= fd0)
     {
       enum { CALLPROC_BUFFER_SIZE_MIN = 16 * 1024 };
       enum { CALLPROC_BUFFER_SIZE_MAX = 4 * CALLPROC_BUFFER_SIZE_MIN };
@@ -786,8 +1054,8 @@ call_process (ptrdiff_t nargs, Lisp_Object *args, int *filefd, Lisp_Object *temp
 	  nread = carryover;
 	  while (nread < bufsize - 1024)
 	    {
-	      int this_read = emacs_read (fd0, buf + nread,
-					  bufsize - nread);
+	      int this_read = call_process_read (fd0, buf + nread,
+						 bufsize - nread);
 
 	      if (this_read < 0)
 		goto give_up;
@@ -892,6 +1160,11 @@ call_process (ptrdiff_t nargs, Lisp_Object *args, int *filefd, Lisp_Object *temp
 	       make_number (total_read));
     }
 
+#ifdef CALLPROC_PIPE_INPUT
+  /* Send the rest of the input, unless the subprocess stops reading.  */
+  call_process_wait_for_output (-1);
+#endif
+
 #ifndef MSDOS
   /* Wait for it to terminate, unless it already has.  */
   wait_for_termination (pid, &status, fd0 < 0);
@@ -924,6 +1197,34 @@ call_process (ptrdiff_t nargs, Lisp_Object *args, int *filefd, Lisp_Object *temp
   return make_number (WEXITSTATUS (status));
 }
 
+/* Return the coding system for encoding the input of
+   call-process-region.  NARGS and ARGS are the same as for
+   call-process-region.  */
+
+static Lisp_Object
+call_process_region_coding (ptrdiff_t nargs, Lisp_Object *args)
+{
+  Lisp_Object val;
+
+  if (!NILP (Vcoding_system_for_write))
+    val = Vcoding_system_for_write;
+  else if (NILP (BVAR (current_buffer, enable_multibyte_characters)))
+    val = Qraw_text;
+  else
+    {
+      Lisp_Object coding_systems;
+      Lisp_Object *args2;
+      USE_SAFE_ALLOCA;
+      SAFE_NALLOCA (args2, 1, nargs + 1);
+      args2[0] = Qcall_process_region;
+      memcpy (args2 + 1, args, nargs * sizeof *args);
+      coding_systems = Ffind_operation_coding_system (nargs + 1, args2);
+      val = CONSP (coding_systems) ? XCDR (coding_systems) : Qnil;
+      SAFE_FREE ();
+    }
+  return complement_process_encoding_system (val);
+}
+
 /* Create a temporary file suitable for storing the input data of
    call-process-region.  NARGS and ARGS are the same as for
    call-process-region.  Store into *FILENAME_STRING_PTR a Lisp string
@@ -996,23 +1297,7 @@ create_temp_file (ptrdiff_t nargs, Lisp_Object *args,
   start = args[0];
   end = args[1];
   /* Decide coding-system of the contents of the temporary file.  */
-  if (!NILP (Vcoding_system_for_write))
-    val = Vcoding_system_for_write;
-  else if (NILP (BVAR (current_buffer, enable_multibyte_characters)))
-    val = Qraw_text;
-  else
-    {
-      Lisp_Object coding_systems;
-      Lisp_Object *args2;
-      USE_SAFE_ALLOCA;
-      SAFE_NALLOCA (args2, 1, nargs + 1);
-      args2[0] = Qcall_process_region;
-      memcpy (args2 + 1, args, nargs * sizeof *args);
-      coding_systems = Ffind_operation_coding_system (nargs + 1, args2);
-      val = CONSP (coding_systems) ? XCDR (coding_systems) : Qnil;
-      SAFE_FREE ();
-    }
-  val = complement_process_encoding_system (val);
+  val = call_process_region_coding (nargs, args);
 
   {
     dynwind_begin ();
@@ -1035,6 +1320,84 @@ create_temp_file (ptrdiff_t nargs, Lisp_Object *args,
   UNGCPRO;
 }
 
+#ifdef CALLPROC_PIPE_INPUT
+
+/* Arrange for call-process-region to stream its input, the text from
+   START to END or the string START, through a pipe to the subprocess.
+   NARGS and ARGS are the same as for call-process-region.  Store into
+   *FDP a file descriptor for the subprocess to read, and return true;
+   return false if the input should go through a temporary file.
+   Unwind-protect both ends of the pipe.  */
+
+static bool
+create_input_pipe (ptrdiff_t nargs, Lisp_Object *args,
+		   Lisp_Object start, Lisp_Object end, int *fdp)
+{
+  Lisp_Object buffer = nargs > 4 ? args[4] : Qnil;
+  int fds[2];
+
+  if (! call_process_region_use_pipe)
+    return 0;
+  if (CONSP (buffer) && !EQ (XCAR (buffer), QCfile))
+    buffer = XCAR (buffer);
+  /* With BUFFER 0 nothing would be left to feed the pipe.  */
+  if (INTEGERP (buffer))
+    return 0;
+  if (nargs > 3 && !NILP (args[3]))
+    {
+      /* Let Fdelete_region complain about a string.  */
+      if (! INTEGERP (start))
+	return 0;
+    }
+  else if (INTEGERP (start) && XINT (start) < PT && PT < XINT (end)
+	   && (EQ (buffer, Qt)
+	       || ((STRINGP (buffer) || BUFFERP (buffer))
+		   && EQ (Fget_buffer (buffer), Fcurrent_buffer ()))))
+    /* Output inserted within the region would become its input.  */
+    return 0;
+
+  setup_coding_system (Fcheck_coding_system
+		       (call_process_region_coding (nargs, args)),
+		       &callproc_input.coding);
+  /* A pre-write conversion wants all of the text at once.  */
+  if (! NILP (CODING_ATTR_PRE_WRITE (CODING_ID_ATTRS
+				     (callproc_input.coding.id))))
+    return 0;
+  callproc_input.coding.dst_multibyte = 0;
+
+  if (emacs_pipe (fds) != 0)
+    report_file_error ("Creating pipe", Qnil);
+  callproc_input.fd = fds[1];
+  record_unwind_protect_void (call_process_close_input);
+  *fdp = fds[0];
+  record_unwind_protect_ptr (close_file_ptr_unwind, fdp);
+  fcntl (fds[1], F_SETFL, O_NONBLOCK);
+
+  if (STRINGP (start))
+    {
+      callproc_input.object = start;
+      callproc_input.start = make_number (0);
+      callproc_input.end = make_number (SCHARS (start));
+    }
+  else
+    {
+      ptrdiff_t from = NILP (start) ? BEG : XINT (start);
+      ptrdiff_t to = NILP (start) ? Z : XINT (end);
+
+      XSETBUFFER (callproc_input.object, current_buffer);
+      /* Output inserted at either end of the region stays out of it.  */
+      callproc_input.start
+	= build_marker (current_buffer, from, CHAR_TO_BYTE (from));
+      XMARKER (callproc_input.start)->insertion_type = 1;
+      callproc_input.end = build_marker (current_buffer, to, CHAR_TO_BYTE (to));
+    }
+  callproc_input.encoded = empty_unibyte_string;
+  callproc_input.encoded_sent = 0;
+  return 1;
+}
+
+#endif /* CALLPROC_PIPE_INPUT */
+
 DEFUN ("call-process-region", Fcall_process_region, Scall_process_region,
        3, MANY, 0,
        doc: /* Send text from START to END to a synchronous process running PROGRAM.
@@ -1062,12 +1425,13 @@ If you quit, the process is killed with SIGINT, or SIGKILL if you quit again.
 usage: (call-process-region START END PROGRAM &optional DELETE BUFFER DISPLAY &rest ARGS)  */)
   (ptrdiff_t nargs, Lisp_Object *args)
 {
-  struct gcpro gcpro1;
+  struct gcpro gcpro1, gcpro2, gcpro3;
   Lisp_Object infile, val;
   dynwind_begin ();
   Lisp_Object start = args[0];
   Lisp_Object end = args[1];
-  bool empty_input;
+  Lisp_Object streamed_start = Qnil, streamed_end = Qnil;
+  bool empty_input, delete_after = 0;
   int fd;
 
   if (STRINGP (start))
@@ -1082,21 +1446,42 @@ usage: (call-process-region START END PROGRAM &optional DELETE BUFFER DISPLAY &r
       empty_input = XINT (start) == XINT (end);
     }
 
-  if (!empty_input)
-    create_temp_file (nargs, args, &infile, &fd);
-  else
+  infile = Qnil;
+  if (empty_input)
     {
-      infile = Qnil;
       fd = emacs_open (NULL_DEVICE, O_RDONLY, 0);
       if (fd < 0)
 	report_file_error ("Opening null device", Qnil);
       record_unwind_protect_ptr (close_file_ptr_unwind, &fd);
     }
+#ifdef CALLPROC_PIPE_INPUT
+  else if (create_input_pipe (nargs, args, start, end, &fd))
+    {
+      if (MARKERP (callproc_input.start))
+	{
+	  streamed_start = Fcopy_marker (callproc_input.start, Qt);
+	  streamed_end = Fcopy_marker (callproc_input.end, Qnil);
+	}
+    }
+#endif
+  else
+    create_temp_file (nargs, args, &infile, &fd);
 
-  GCPRO1 (infile);
+  GCPRO3 (infile, streamed_start, streamed_end);
 
   if (nargs > 3 && !NILP (args[3]))
-    Fdelete_region (start, end);
+    {
+      /* Streamed input is deleted once the subprocess is done with it.
+	 Meanwhile, insert any output after it, where it will end up.  */
+      if (MARKERP (streamed_start))
+	{
+	  delete_after = 1;
+	  if (XINT (start) < PT && PT < XINT (end))
+	    SET_PT (XINT (end));
+	}
+      else
+	Fdelete_region (start, end);
+    }
 
   if (nargs > 3)
     {
@@ -1111,6 +1496,13 @@ usage: (call-process-region START END PROGRAM &optional DELETE BUFFER DISPLAY &r
   args[1] = infile;
 
   val = call_process (nargs, args, &fd, &infile);
+  if (delete_after)
+    Fdelete_region (streamed_start, streamed_end);
+  if (MARKERP (streamed_start))
+    {
+      unchain_marker (XMARKER (streamed_start));
+      unchain_marker (XMARKER (streamed_end));
+    }
   dynwind_end ();
   return val;
 }
@@ -1674,6 +2066,23 @@ syms_of_callproc (void)
   synch_process_tempfile = make_number (0);
   staticpro (&synch_process_tempfile);
 
+#ifdef CALLPROC_PIPE_INPUT
+  callproc_input.object = callproc_input.start = callproc_input.end = Qnil;
+  callproc_input.encoded = Qnil;
+  staticpro (&callproc_input.object);
+  staticpro (&callproc_input.start);
+  staticpro (&callproc_input.end);
+  staticpro (&callproc_input.encoded);
+#endif
+
+  DEFVAR_BOOL ("call-process-region-use-pipe", call_process_region_use_pipe,
+	       doc: /* Non-nil means `call-process-region' streams its input through a pipe.
+The text is then sent to the program a piece at a time while its output
+is read, instead of being written to a temporary file first.  The
+temporary file is still used where the input cannot be streamed, such
+as when BUFFER is 0 or the coding system has a pre-write conversion.  */);
+  call_process_region_use_pipe = 1;
+
   DEFVAR_LISP ("shell-file-name", Vshell_file_name,
 	       doc: /* File name to load inferior shells from.
 Initialized from the SHELL environment variable, or to a system-dependent
@@ -203,6 +203,13 @@ casify_region (enum case_action flag, Lisp_Object b, Lisp_Object e)
   ptrdiff_t opoint = PT;
   ptrdiff_t opoint_byte = PT_BYTE;
 
+  /* For plain up- and downcasing, the result for each ASCII character
+     that converts to another ASCII character, or 0200 if it doesn't.
+     Runs of such characters are converted in place without decoding
+     them or consulting the syntax table.  */
+  unsigned char ascii_map[0200];
+  bool use_ascii_map = flag == CASE_UP || flag == CASE_DOWN;
+
   if (EQ (b, e))
     /* Not modifying because nothing marked */
     return;
@@ -220,10 +227,45 @@ casify_region (enum case_action flag, Lisp_Object b, Lisp_Object e)
 
   SETUP_BUFFER_SYNTAX_TABLE ();	/* For syntax_prefix_flag_p.  */
 
+  if (use_ascii_map)
+    for (c = 0; c < 0200; c++)
+      {
+	int c2 = (flag == CASE_DOWN ? downcase (c)
+		  : uppercasep (c) ? c : upcase1 (c));
+	ascii_map[c] = ASCII_CHAR_P (c2) ? c2 : 0200;
+      }
+
   while (start < end)
     {
       int c2, len;
 
+      if (use_ascii_map)
+	{
+	  /* Convert the run of ASCII bytes here, stopping at the gap.  */
+	  ptrdiff_t stop = (start_byte < GPT_BYTE ? GPT_BYTE : Z_BYTE);
+	  ptrdiff_t limit = min (end - start, stop - start_byte), n;
+	  unsigned char *p = BYTE_POS_ADDR (start_byte);
+
+	  for (n = 0; n < limit && p[n] < 0200; n++)
+	    {
+	      unsigned char to = ascii_map[p[n]];
+
+	      if (to == 0200)
+		break;
+	      if (to != p[n])
+		{
+		  p[n] = to;
+		  if (first < 0)
+		    first = start + n;
+		  last = start + n;
+		}
+	    }
+	  start += n;
+	  start_byte += n;
+	  if (n > 0)
+	    continue;
+	}
+
       if (multibyte)
 	{
 	  c = FETCH_MULTIBYTE_CHAR (start_byte);
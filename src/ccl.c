@@ -870,6 +870,47 @@ struct ccl_prog_stack
 /* For the moment, we only support depth 256 of stack.  */
 static struct ccl_prog_stack ccl_prog_stack_struct[256];
 
+/* Fetch and decode the next CCL code, or stop if the user quit.  We
+   can't just signal Qquit, instead stop as if the whole data is
+   processed.  Don't reset Vquit_flag, it must be handled later at a
+   safer place.  */
+#define CCL_FETCH()					\
+  do {							\
+    if (!NILP (Vquit_flag) && NILP (Vinhibit_quit))	\
+      {							\
+	if (src)					\
+	  src = source + src_size;			\
+	ccl->status = CCL_STAT_QUIT;			\
+	goto ccl_error_handler;				\
+      }							\
+    this_ic = ic;					\
+    GET_CCL_CODE (code, ccl_prog, ic++);		\
+    field1 = code >> 8;					\
+    field2 = (code & 0xFF) >> 5;			\
+  } while (0)
+
+/* With GCC, ccl_driver uses threaded code: each command ends by
+   fetching the next one and jumping straight to its label through
+   `ccl_targets', rather than going back to the top of the loop and
+   through the switch.  The indirect jump at the end of each command
+   is predicted separately, which pays off for the short loops that
+   decoding and font encoding programs run per character.  */
+#if defined __GNUC__ && !defined CCL_DEBUG
+#define CCL_THREADED
+#endif
+
+#ifdef CCL_THREADED
+#define CCL_CASE(op) case op: insn_##op
+#define CCL_NEXT				\
+  do {						\
+    CCL_FETCH ();				\
+    goto *ccl_targets[code & 0x1F];		\
+  } while (0)
+#else
+#define CCL_CASE(op) case op
+#define CCL_NEXT break
+#endif
+
 void
 ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size, int dst_size, Lisp_Object charset_list)
 {
@@ -888,6 +929,44 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
   int eof_ic = ccl->eof_ic;
   int eof_hit = 0;
 
+#ifdef CCL_THREADED
+  static void *const ccl_targets[32] =
+    {
+      [CCL_SetRegister] = &&insn_CCL_SetRegister,
+      [CCL_SetShortConst] = &&insn_CCL_SetShortConst,
+      [CCL_SetConst] = &&insn_CCL_SetConst,
+      [CCL_SetArray] = &&insn_CCL_SetArray,
+      [CCL_Jump] = &&insn_CCL_Jump,
+      [CCL_JumpCond] = &&insn_CCL_JumpCond,
+      [CCL_WriteRegisterJump] = &&insn_CCL_WriteRegisterJump,
+      [CCL_WriteRegisterReadJump] = &&insn_CCL_WriteRegisterReadJump,
+      [CCL_WriteConstJump] = &&insn_CCL_WriteConstJump,
+      [CCL_WriteConstReadJump] = &&insn_CCL_WriteConstReadJump,
+      [CCL_WriteStringJump] = &&insn_CCL_WriteStringJump,
+      [CCL_WriteArrayReadJump] = &&insn_CCL_WriteArrayReadJump,
+      [CCL_ReadJump] = &&insn_CCL_ReadJump,
+      [CCL_ReadBranch] = &&insn_CCL_ReadBranch,
+      [CCL_Branch] = &&insn_CCL_Branch,
+      [CCL_ReadRegister] = &&insn_CCL_ReadRegister,
+      [CCL_WriteExprConst] = &&insn_CCL_WriteExprConst,
+      [CCL_WriteRegister] = &&insn_CCL_WriteRegister,
+      [CCL_WriteExprRegister] = &&insn_CCL_WriteExprRegister,
+      [CCL_Call] = &&insn_CCL_Call,
+      [CCL_WriteConstString] = &&insn_CCL_WriteConstString,
+      [CCL_WriteArray] = &&insn_CCL_WriteArray,
+      [CCL_End] = &&insn_CCL_End,
+      [CCL_ExprSelfConst] = &&insn_CCL_ExprSelfConst,
+      [CCL_ExprSelfReg] = &&insn_CCL_ExprSelfReg,
+      [CCL_SetExprConst] = &&insn_CCL_SetExprConst,
+      [CCL_SetExprReg] = &&insn_CCL_SetExprReg,
+      [CCL_ReadJumpCondExprConst] = &&insn_CCL_ReadJumpCondExprConst,
+      [CCL_JumpCondExprConst] = &&insn_CCL_JumpCondExprConst,
+      [CCL_ReadJumpCondExprReg] = &&insn_CCL_ReadJumpCondExprReg,
+      [CCL_JumpCondExprReg] = &&insn_CCL_JumpCondExprReg,
+      [CCL_Extension] = &&insn_CCL_Extension,
+    };
+#endif
+
   if (ccl->buf_magnification == 0) /* We can't read/produce any bytes.  */
     dst = NULL;
 
@@ -908,21 +987,7 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
       ccl_backtrace_table[ccl_backtrace_idx] = 0;
 #endif
 
-      if (!NILP (Vquit_flag) && NILP (Vinhibit_quit))
-	{
-	  /* We can't just signal Qquit, instead break the loop as if
-             the whole data is processed.  Don't reset Vquit_flag, it
-             must be handled later at a safer place.  */
-	  if (src)
-	    src = source + src_size;
-	  ccl->status = CCL_STAT_QUIT;
-	  break;
-	}
-
-      this_ic = ic;
-      GET_CCL_CODE (code, ccl_prog, ic++);
-      field1 = code >> 8;
-      field2 = (code & 0xFF) >> 5;
+      CCL_FETCH ();
 
 #define rrr field2
 #define RRR (field1 & 7)
@@ -930,72 +995,75 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 #define ADDR field1
 #define EXCMD (field1 >> 6)
 
+#ifdef CCL_THREADED
+      goto *ccl_targets[code & 0x1F];
+#endif
       switch (code & 0x1F)
 	{
-	case CCL_SetRegister:	/* 00000000000000000RRRrrrXXXXX */
+	CCL_CASE (CCL_SetRegister):	/* 00000000000000000RRRrrrXXXXX */
 	  reg[rrr] = reg[RRR];
-	  break;
+	  CCL_NEXT;
 
-	case CCL_SetShortConst:	/* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
+	CCL_CASE (CCL_SetShortConst):	/* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
 	  reg[rrr] = field1;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_SetConst:	/* 00000000000000000000rrrXXXXX */
+	CCL_CASE (CCL_SetConst):	/* 00000000000000000000rrrXXXXX */
 	  reg[rrr] = XINT (ccl_prog[ic++]);
-	  break;
+	  CCL_NEXT;
 
-	case CCL_SetArray:	/* CCCCCCCCCCCCCCCCCCCCRRRrrrXXXXX */
+	CCL_CASE (CCL_SetArray):	/* CCCCCCCCCCCCCCCCCCCCRRRrrrXXXXX */
 	  i = reg[RRR];
 	  j = field1 >> 3;
 	  if (0 <= i && i < j)
 	    reg[rrr] = XINT (ccl_prog[ic + i]);
 	  ic += j;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_Jump:		/* A--D--D--R--E--S--S-000XXXXX */
+	CCL_CASE (CCL_Jump):		/* A--D--D--R--E--S--S-000XXXXX */
 	  ic += ADDR;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_JumpCond:	/* A--D--D--R--E--S--S-rrrXXXXX */
+	CCL_CASE (CCL_JumpCond):	/* A--D--D--R--E--S--S-rrrXXXXX */
 	  if (!reg[rrr])
 	    ic += ADDR;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteRegisterJump: /* A--D--D--R--E--S--S-rrrXXXXX */
+	CCL_CASE (CCL_WriteRegisterJump): /* A--D--D--R--E--S--S-rrrXXXXX */
 	  i = reg[rrr];
 	  CCL_WRITE_CHAR (i);
 	  ic += ADDR;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteRegisterReadJump: /* A--D--D--R--E--S--S-rrrXXXXX */
+	CCL_CASE (CCL_WriteRegisterReadJump): /* A--D--D--R--E--S--S-rrrXXXXX */
 	  i = reg[rrr];
 	  CCL_WRITE_CHAR (i);
 	  ic++;
 	  CCL_READ_CHAR (reg[rrr]);
 	  ic += ADDR - 1;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteConstJump: /* A--D--D--R--E--S--S-000XXXXX */
+	CCL_CASE (CCL_WriteConstJump): /* A--D--D--R--E--S--S-000XXXXX */
 	  i = XINT (ccl_prog[ic]);
 	  CCL_WRITE_CHAR (i);
 	  ic += ADDR;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteConstReadJump: /* A--D--D--R--E--S--S-rrrXXXXX */
+	CCL_CASE (CCL_WriteConstReadJump): /* A--D--D--R--E--S--S-rrrXXXXX */
 	  i = XINT (ccl_prog[ic]);
 	  CCL_WRITE_CHAR (i);
 	  ic++;
 	  CCL_READ_CHAR (reg[rrr]);
 	  ic += ADDR - 1;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteStringJump: /* A--D--D--R--E--S--S-000XXXXX */
+	CCL_CASE (CCL_WriteStringJump): /* A--D--D--R--E--S--S-000XXXXX */
 	  j = XINT (ccl_prog[ic++]);
 	  CCL_WRITE_STRING (j);
 	  ic += ADDR - 1;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteArrayReadJump: /* A--D--D--R--E--S--S-rrrXXXXX */
+	CCL_CASE (CCL_WriteArrayReadJump): /* A--D--D--R--E--S--S-rrrXXXXX */
 	  i = reg[rrr];
 	  j = XINT (ccl_prog[ic]);
 	  if (0 <= i && i < j)
@@ -1006,25 +1074,25 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	  ic += j + 2;
 	  CCL_READ_CHAR (reg[rrr]);
 	  ic += ADDR - (j + 2);
-	  break;
+	  CCL_NEXT;
 
-	case CCL_ReadJump:	/* A--D--D--R--E--S--S-rrrYYYYY */
+	CCL_CASE (CCL_ReadJump):	/* A--D--D--R--E--S--S-rrrYYYYY */
 	  CCL_READ_CHAR (reg[rrr]);
 	  ic += ADDR;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_ReadBranch:	/* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
+	CCL_CASE (CCL_ReadBranch):	/* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
 	  CCL_READ_CHAR (reg[rrr]);
 	  /* fall through ... */
-	case CCL_Branch:	/* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
+	CCL_CASE (CCL_Branch):	/* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
 	{
 	  int ioff = 0 <= reg[rrr] && reg[rrr] < field1 ? reg[rrr] : field1;
 	  int incr = XINT (ccl_prog[ic + ioff]);
 	  ic += incr;
 	}
-	  break;
+	  CCL_NEXT;
 
-	case CCL_ReadRegister:	/* CCCCCCCCCCCCCCCCCCCCrrXXXXX */
+	CCL_CASE (CCL_ReadRegister):	/* CCCCCCCCCCCCCCCCCCCCrrXXXXX */
 	  while (1)
 	    {
 	      CCL_READ_CHAR (reg[rrr]);
@@ -1033,9 +1101,9 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	      field1 = code >> 8;
 	      field2 = (code & 0xFF) >> 5;
 	    }
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteExprConst:  /* 1:00000OPERATION000RRR000XXXXX */
+	CCL_CASE (CCL_WriteExprConst):  /* 1:00000OPERATION000RRR000XXXXX */
 	  rrr = 7;
 	  i = reg[RRR];
 	  j = XINT (ccl_prog[ic]);
@@ -1043,7 +1111,7 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	  jump_address = ic + 1;
 	  goto ccl_set_expr;
 
-	case CCL_WriteRegister:	/* CCCCCCCCCCCCCCCCCCCrrrXXXXX */
+	CCL_CASE (CCL_WriteRegister):	/* CCCCCCCCCCCCCCCCCCCrrrXXXXX */
 	  while (1)
 	    {
 	      i = reg[rrr];
@@ -1053,9 +1121,9 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	      field1 = code >> 8;
 	      field2 = (code & 0xFF) >> 5;
 	    }
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteExprRegister: /* 1:00000OPERATIONRrrRRR000XXXXX */
+	CCL_CASE (CCL_WriteExprRegister): /* 1:00000OPERATIONRrrRRR000XXXXX */
 	  rrr = 7;
 	  i = reg[RRR];
 	  j = reg[Rrr];
@@ -1063,7 +1131,7 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	  jump_address = ic;
 	  goto ccl_set_expr;
 
-	case CCL_Call:		/* 1:CCCCCCCCCCCCCCCCCCCCFFFXXXXX */
+	CCL_CASE (CCL_Call):		/* 1:CCCCCCCCCCCCCCCCCCCCFFFXXXXX */
 	  {
 	    Lisp_Object slot;
 	    int prog_id;
@@ -1098,9 +1166,9 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	    ic = CCL_HEADER_MAIN;
 	    eof_ic = XFASTINT (ccl_prog[CCL_HEADER_EOF]);
 	  }
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteConstString: /* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
+	CCL_CASE (CCL_WriteConstString): /* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
 	  if (!rrr)
 	    CCL_WRITE_CHAR (field1);
 	  else
@@ -1108,9 +1176,9 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	      CCL_WRITE_STRING (field1);
 	      ic += (field1 + 2) / 3;
 	    }
-	  break;
+	  CCL_NEXT;
 
-	case CCL_WriteArray:	/* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
+	CCL_CASE (CCL_WriteArray):	/* CCCCCCCCCCCCCCCCCCCCrrrXXXXX */
 	  i = reg[rrr];
 	  if (0 <= i && i < field1)
 	    {
@@ -1118,9 +1186,9 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	      CCL_WRITE_CHAR (j);
 	    }
 	  ic += field1;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_End:		/* 0000000000000000000000XXXXX */
+	CCL_CASE (CCL_End):		/* 0000000000000000000000XXXXX */
 	  if (stack_idx > 0)
 	    {
 	      stack_idx--;
@@ -1129,7 +1197,7 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	      eof_ic = ccl_prog_stack_struct[stack_idx].eof_ic;
 	      if (eof_hit)
 		ic = eof_ic;
-	      break;
+	      CCL_NEXT;
 	    }
 	  if (src)
 	    src = src_end;
@@ -1138,12 +1206,12 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	  ic--;
 	  CCL_SUCCESS;
 
-	case CCL_ExprSelfConst: /* 00000OPERATION000000rrrXXXXX */
+	CCL_CASE (CCL_ExprSelfConst): /* 00000OPERATION000000rrrXXXXX */
 	  i = XINT (ccl_prog[ic++]);
 	  op = field1 >> 6;
 	  goto ccl_expr_self;
 
-	case CCL_ExprSelfReg:	/* 00000OPERATION000RRRrrrXXXXX */
+	CCL_CASE (CCL_ExprSelfReg):	/* 00000OPERATION000RRRrrrXXXXX */
 	  i = reg[RRR];
 	  op = field1 >> 6;
 
@@ -1171,25 +1239,25 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	    case CCL_NE: reg[rrr] = reg[rrr] != i; break;
 	    default: CCL_INVALID_CMD;
 	    }
-	  break;
+	  CCL_NEXT;
 
-	case CCL_SetExprConst:	/* 00000OPERATION000RRRrrrXXXXX */
+	CCL_CASE (CCL_SetExprConst):	/* 00000OPERATION000RRRrrrXXXXX */
 	  i = reg[RRR];
 	  j = XINT (ccl_prog[ic++]);
 	  op = field1 >> 6;
 	  jump_address = ic;
 	  goto ccl_set_expr;
 
-	case CCL_SetExprReg:	/* 00000OPERATIONRrrRRRrrrXXXXX */
+	CCL_CASE (CCL_SetExprReg):	/* 00000OPERATIONRrrRRRrrrXXXXX */
 	  i = reg[RRR];
 	  j = reg[Rrr];
 	  op = field1 >> 6;
 	  jump_address = ic;
 	  goto ccl_set_expr;
 
-	case CCL_ReadJumpCondExprConst: /* A--D--D--R--E--S--S-rrrXXXXX */
+	CCL_CASE (CCL_ReadJumpCondExprConst): /* A--D--D--R--E--S--S-rrrXXXXX */
 	  CCL_READ_CHAR (reg[rrr]);
-	case CCL_JumpCondExprConst: /* A--D--D--R--E--S--S-rrrXXXXX */
+	CCL_CASE (CCL_JumpCondExprConst): /* A--D--D--R--E--S--S-rrrXXXXX */
 	  i = reg[rrr];
 	  jump_address = ic + ADDR;
 	  op = XINT (ccl_prog[ic++]);
@@ -1197,9 +1265,9 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	  rrr = 7;
 	  goto ccl_set_expr;
 
-	case CCL_ReadJumpCondExprReg: /* A--D--D--R--E--S--S-rrrXXXXX */
+	CCL_CASE (CCL_ReadJumpCondExprReg): /* A--D--D--R--E--S--S-rrrXXXXX */
 	  CCL_READ_CHAR (reg[rrr]);
-	case CCL_JumpCondExprReg:
+	CCL_CASE (CCL_JumpCondExprReg):
 	  i = reg[rrr];
 	  jump_address = ic + ADDR;
 	  op = XINT (ccl_prog[ic++]);
@@ -1256,9 +1324,9 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	    }
 	  else if (!reg[rrr])
 	    ic = jump_address;
-	  break;
+	  CCL_NEXT;
 
-	case CCL_Extension:
+	CCL_CASE (CCL_Extension):
 	  switch (EXCMD)
 	    {
 	    case CCL_ReadMultibyteChar2:
@@ -1704,7 +1772,7 @@ ccl_driver (struct ccl_program *ccl, int *source, int *destination, int src_size
 	    default:
 	      CCL_INVALID_CMD;
 	    }
-	  break;
+	  CCL_NEXT;
 
 	default:
 	  CCL_INVALID_CMD;
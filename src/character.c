@@ -333,6 +333,35 @@ usage: (char-width CHAR)  */)
   return make_number (width);
 }
 
+/* Return true if the LEN bytes at STR are all printable ASCII
+   characters, each of which occupies one column.  */
+
+static bool
+printable_ascii_p (const unsigned char *str, ptrdiff_t len)
+{
+  ptrdiff_t i;
+
+  for (i = 0; i < len; i++)
+    if (! (' ' <= str[i] && str[i] < 0177))
+      return false;
+  return true;
+}
+
+/* Return the width of a text of LEN characters, each one column
+   wide, with PRECISION and *NCHARS and *NBYTES as in c_string_width.  */
+
+static ptrdiff_t
+printable_ascii_width (ptrdiff_t len, ptrdiff_t precision,
+		       ptrdiff_t *nchars, ptrdiff_t *nbytes)
+{
+  if (precision > 0)
+    {
+      len = min (len, precision);
+      *nchars = *nbytes = len;
+    }
+  return len;
+}
+
 /* Return width of string STR of length LEN when displayed in the
    current buffer.  The width is measured by how many columns it
    occupies on the screen.  If PRECISION > 0, return the width of
@@ -348,6 +377,9 @@ c_string_width (const unsigned char *str, ptrdiff_t len, int precision,
   ptrdiff_t width = 0;
   struct Lisp_Char_Table *dp = buffer_display_table ();
 
+  if (!dp && printable_ascii_p (str, len))
+    return printable_ascii_width (len, precision, nchars, nbytes);
+
   while (i_byte < len)
     {
       int bytes;
@@ -410,6 +442,12 @@ lisp_string_width (Lisp_Object string, ptrdiff_t precision,
   ptrdiff_t width = 0;
   struct Lisp_Char_Table *dp = buffer_display_table ();
 
+  /* Without a display table or text properties that might compose
+     characters, plain ASCII text is one column per character.  */
+  if (!dp && len == SBYTES (string) && !string_intervals (string)
+      && printable_ascii_p (str, len))
+    return printable_ascii_width (len, precision, nchars, nbytes);
+
   while (i < len)
     {
       ptrdiff_t chars, bytes, thiswidth;
@@ -526,6 +564,51 @@ multibyte_chars_in_text (const unsigned char *ptr, ptrdiff_t nbytes)
   return chars;
 }
 
+/* Return true if C is a character of bidirectional type R or AL, or
+   one of the directional controls RLM, RLE, RLO and RLI.  Text with
+   none of these is displayed the same with and without bidirectional
+   reordering, in a paragraph that is not forced to be right-to-left.
+   The ranges are the blocks of the right-to-left scripts, which also
+   have some neutral characters, so this may say true for more
+   characters than it must.  */
+
+bool
+char_rtl_p (int c)
+{
+  return ((c >= 0x0590 && c <= 0x08FF)
+	  || c == 0x200F || c == 0x202B || c == 0x202E || c == 0x2067
+	  || (c >= 0xFB1D && c <= 0xFDFF)
+	  || (c >= 0xFE70 && c <= 0xFEFF)
+	  || (c >= 0x10800 && c <= 0x10FFF)
+	  || (c >= 0x1E800 && c <= 0x1EFFF));
+}
+
+/* Return true if the NBYTES bytes of multibyte text at PTR have a
+   character for which char_rtl_p is true.  */
+
+bool
+multibyte_text_rtl_p (const unsigned char *ptr, ptrdiff_t nbytes)
+{
+  const unsigned char *endp = ptr + nbytes;
+
+  while (ptr < endp)
+    {
+      /* U+0590 is the first character whose first byte is 0xD6, and
+	 no byte that is not the first of a character is that large.  */
+      if (*ptr < 0xD6)
+	ptr++;
+      else
+	{
+	  int len, c = STRING_CHAR_AND_LENGTH (ptr, len);
+
+	  if (char_rtl_p (c))
+	    return true;
+	  ptr += len;
+	}
+    }
+  return false;
+}
+
 /* Parse unibyte text at STR of LEN bytes as a multibyte text, count
    characters and bytes in it, and store them in *NCHARS and *NBYTES
    respectively.  On counting bytes, pay attention to that 8-bit
@@ -33,7 +33,13 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <unistd.h>
 #include <limits.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <c-ctype.h>
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
 #include "lisp.h"
 #include "character.h"
 #include "charset.h"
@@ -460,6 +466,133 @@ read_hex (FILE *fp, bool *eof, bool *overflow)
   return n;
 }
 
+#ifdef HAVE_MMAP
+
+/* Binary images of charset maps, made at build time by
+   lib-src/make-charset-map from the text maps.  An image FOO.cmap
+   starts with a header, followed by the entries of FOO.map in order,
+   each the three 32-bit numbers FROM, TO and C in native byte order,
+   the layout of the elements of `charset_map_entries'.  Keep this in
+   sync with lib-src/make-charset-map.c.  */
+
+#define CHARSET_MAP_IMAGE_MAGIC "\177ECMAP1\n"
+#define CHARSET_MAP_IMAGE_BYTE_ORDER 0x01020304
+
+struct charset_map_image_header
+{
+  char magic[8];
+  uint32_t byte_order;
+  uint32_t n_entries;
+};
+
+/* Load the map of CHARSET from the image of MAPFILE if there is one
+   in `charset-map-path' that is no older than the text map beside it.
+   The image is mapped into memory, where it is shared with the other
+   Emacs processes, and used in place if all its entries are valid for
+   CHARSET.  Return true if the map was loaded.  */
+
+static bool
+load_charset_map_from_image (struct charset *charset, Lisp_Object mapfile,
+			     int control_flag)
+{
+  unsigned min_code = CHARSET_MIN_CODE (charset);
+  unsigned max_code = CHARSET_MAX_CODE (charset);
+  Lisp_Object suffixes, found;
+  struct charset_map_image_header header;
+  struct charset_map_entries *head, *entries;
+  struct stat st;
+  uint32_t const *image;
+  void *data;
+  ptrdiff_t n, i;
+  int fd, n_entries;
+  bool valid = 1;
+
+  suffixes = list3 (build_string (".cmap"), build_string (".map"),
+		    build_string (".TXT"));
+  dynwind_begin ();
+  specbind (Qfile_name_handler_alist, Qnil);
+  fd = openp (Vcharset_map_path, mapfile, suffixes, &found, Qnil, true);
+  dynwind_end ();
+  if (fd < 0)
+    return 0;
+  if (! (STRINGP (found) && SBYTES (found) > 5
+	 && !strcmp (SSDATA (found) + SBYTES (found) - 5, ".cmap"))
+      || fstat (fd, &st) != 0
+      || st.st_size < sizeof header
+      || (st.st_size - sizeof header) % (3 * sizeof *image) != 0)
+    {
+      emacs_close (fd);
+      return 0;
+    }
+  data = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  emacs_close (fd);
+  if (data == MAP_FAILED)
+    return 0;
+  memcpy (&header, data, sizeof header);
+  n = (st.st_size - sizeof header) / (3 * sizeof *image);
+  if (memcmp (header.magic, CHARSET_MAP_IMAGE_MAGIC, sizeof header.magic)
+      || header.byte_order != CHARSET_MAP_IMAGE_BYTE_ORDER
+      || header.n_entries != n)
+    {
+      munmap (data, st.st_size);
+      return 0;
+    }
+  image = (uint32_t const *) ((char const *) data + sizeof header);
+
+  for (i = 0; i < n && valid; i++)
+    {
+      uint32_t from = image[3 * i], to = image[3 * i + 1];
+      uint32_t c = image[3 * i + 2];
+      valid = ! (from < min_code || to > max_code || from > to
+		 || c > MAX_CHAR);
+    }
+
+  /* Make the same chain of blocks of 0x10000 entries as
+     load_charset_map_from_file, pointing into the image if we can.  */
+  head = entries = xzalloc (sizeof *head);
+  n_entries = 0;
+  if (valid)
+    {
+      entries->entry = (void *) image;
+      n_entries = min (n, 0x10000);
+      for (i = n_entries; i < n; i += n_entries)
+	{
+	  entries = entries->next = xzalloc (sizeof *entries);
+	  entries->entry = (void *) (image + 3 * i);
+	  n_entries = min (n - i, 0x10000);
+	}
+    }
+  else
+    {
+      entries->entry = xmalloc_atomic (0x10000 * sizeof *entries->entry);
+      for (i = 0; i < n; i++)
+	{
+	  uint32_t from = image[3 * i], to = image[3 * i + 1];
+	  uint32_t c = image[3 * i + 2];
+
+	  if (from < min_code || to > max_code || from > to || c > MAX_CHAR)
+	    continue;
+	  if (n_entries == 0x10000)
+	    {
+	      entries = entries->next = xzalloc (sizeof *entries);
+	      entries->entry
+		= xmalloc_atomic (0x10000 * sizeof *entries->entry);
+	      n_entries = 0;
+	    }
+	  entries->entry[n_entries].from = from;
+	  entries->entry[n_entries].to = to;
+	  entries->entry[n_entries].c = c;
+	  n_entries++;
+	}
+    }
+
+  load_charset_map (charset, head, n_entries, control_flag);
+  munmap (data, st.st_size);
+  return 1;
+}
+
+#endif /* HAVE_MMAP */
+
 /* Return a mapping vector for CHARSET loaded from MAPFILE.
    Each line of MAPFILE has this form
 	0xAAAA 0xCCCC
@@ -490,6 +623,11 @@ load_charset_map_from_file (struct charset *charset, Lisp_Object mapfile,
   int n_entries;
   ptrdiff_t count;
 
+#ifdef HAVE_MMAP
+  if (load_charset_map_from_image (charset, mapfile, control_flag))
+    return;
+#endif
+
   suffixes = list2 (build_string (".map"), build_string (".TXT"));
 
   dynwind_begin ();
@@ -34,6 +34,9 @@ const int chartab_size[4] =
     (1 << CHARTAB_SIZE_BITS_2),
     (1 << CHARTAB_SIZE_BITS_3) };
 
+/* Modification count of all char-tables; see lisp.h.  */
+EMACS_INT char_table_modiff;
+
 /* Number of characters each element of Nth level char-table
    covers.  */
 static const int chartab_chars[4] =
@@ -94,11 +97,13 @@ static void
 set_char_table_ascii (Lisp_Object table, Lisp_Object val)
 {
   XCHAR_TABLE (table)->ascii = val;
+  char_table_modiff++;
 }
 static void
 set_char_table_parent (Lisp_Object table, Lisp_Object val)
 {
   XCHAR_TABLE (table)->parent = val;
+  char_table_modiff++;
 }
 
 DEFUN ("make-char-table", Fmake_char_table, Smake_char_table, 1, 2, 0,
@@ -233,12 +238,191 @@ sub_char_table_ref (Lisp_Object table, int c, bool is_uniprop)
   return val;
 }
 
+/* Frozen char-tables.
+
+   `freeze-char-table' makes a flat copy of the values a char-table
+   has for the characters below CHAR_TABLE_FROZEN_CHARS, in two
+   stages: for each block of CHAR_TABLE_FROZEN_BLOCK characters, the
+   number of a block of value numbers, shared between blocks with the
+   same contents.  A lookup then takes three array references instead
+   of a descent through sub char-tables, defaults and parents.
+
+   A copy is used only while char_table_modiff is unchanged, so any
+   change to a char-table thaws it.  It is made again once
+   CHAR_TABLE_REFREEZE lookups have gone by without further change.  */
+
+#define CHAR_TABLE_FROZEN_BITS 7
+#define CHAR_TABLE_FROZEN_BLOCK (1 << CHAR_TABLE_FROZEN_BITS)
+#define CHAR_TABLE_FROZEN_CHARS 0x30000
+#define CHAR_TABLE_FROZEN_BLOCKS \
+  (CHAR_TABLE_FROZEN_CHARS >> CHAR_TABLE_FROZEN_BITS)
+
+enum { CHAR_TABLE_FROZEN_ENTRIES = 8, CHAR_TABLE_REFREEZE = 1024 };
+
+struct char_table_frozen
+{
+  Lisp_Object table;
+
+  /* The copy is valid while this equals char_table_modiff.  */
+  EMACS_INT modiff;
+
+  /* While the copy is stale, the value of char_table_modiff when it
+     was last seen to change, and the lookups made since then.  */
+  EMACS_INT thawed_modiff;
+  int quiet;
+
+  /* The distinct values, the block of each block of characters, and
+     the value numbers of the blocks.  */
+  Lisp_Object *values;
+  unsigned short *index;
+  unsigned short *blocks;
+};
+
+/* Most recently frozen first.  */
+static struct char_table_frozen char_table_frozen[CHAR_TABLE_FROZEN_ENTRIES];
+static int char_table_frozen_used;
+
+/* Fill F with a flat copy of TABLE.  Return false if TABLE has too
+   many distinct values for one.  */
+
+static bool
+char_table_freeze_1 (struct char_table_frozen *f, Lisp_Object table)
+{
+  Lisp_Object numbers, uniform;
+  struct Lisp_Hash_Table *hn, *hu;
+  Lisp_Object *values = NULL;
+  ptrdiff_t nvalues = 0, values_size = 0;
+  unsigned short *index, *blocks;
+  unsigned short block[CHAR_TABLE_FROZEN_BLOCK];
+  int b, i, nblocks = 0;
+
+  numbers = make_hash_table (hashtest_eql, make_number (DEFAULT_HASH_SIZE),
+			     make_float (DEFAULT_REHASH_SIZE),
+			     make_float (DEFAULT_REHASH_THRESHOLD), Qnil);
+  uniform = make_hash_table (hashtest_eql, make_number (DEFAULT_HASH_SIZE),
+			     make_float (DEFAULT_REHASH_SIZE),
+			     make_float (DEFAULT_REHASH_THRESHOLD), Qnil);
+  hn = XHASH_TABLE (numbers);
+  hu = XHASH_TABLE (uniform);
+  index = xmalloc (CHAR_TABLE_FROZEN_BLOCKS * sizeof *index);
+  blocks = xmalloc (CHAR_TABLE_FROZEN_CHARS * sizeof *blocks);
+
+  for (b = 0; b < CHAR_TABLE_FROZEN_BLOCKS; b++)
+    {
+      int base = b << CHAR_TABLE_FROZEN_BITS;
+      struct char_table_run runs[CHAR_TABLE_FROZEN_BLOCK];
+      ptrdiff_t j, r, n;
+
+      n = char_table_runs (table, base, base + CHAR_TABLE_FROZEN_BLOCK - 1,
+			   runs, CHAR_TABLE_FROZEN_BLOCK);
+      for (r = 0, i = 0; r < n; r++)
+	{
+	  Lisp_Object val = runs[r].val;
+	  EMACS_UINT hash;
+
+	  j = hash_lookup (hn, val, &hash);
+	  if (j >= 0)
+	    j = XFASTINT (HASH_VALUE (hn, j));
+	  else
+	    {
+	      if (nvalues > USHRT_MAX)
+		return false;
+	      if (nvalues == values_size)
+		values = xpalloc (values, &values_size, 1, -1, sizeof *values);
+	      values[nvalues] = val;
+	      hash_put (hn, val, make_number (nvalues), hash);
+	      j = nvalues++;
+	    }
+	  for (; i <= runs[r].to - base; i++)
+	    block[i] = j;
+	}
+
+      /* Share the block with an earlier one with the same contents,
+	 if that is easy to find.  */
+      for (i = 1; i < CHAR_TABLE_FROZEN_BLOCK; i++)
+	if (block[i] != block[0])
+	  break;
+      if (i == CHAR_TABLE_FROZEN_BLOCK)
+	{
+	  EMACS_UINT hash;
+	  j = hash_lookup (hu, make_number (block[0]), &hash);
+	  if (j >= 0)
+	    {
+	      index[b] = XFASTINT (HASH_VALUE (hu, j));
+	      continue;
+	    }
+	  hash_put (hu, make_number (block[0]), make_number (nblocks), hash);
+	}
+      else if (nblocks > 0
+	       && !memcmp (blocks + ((nblocks - 1) << CHAR_TABLE_FROZEN_BITS),
+			   block, sizeof block))
+	{
+	  index[b] = nblocks - 1;
+	  continue;
+	}
+      memcpy (blocks + (nblocks << CHAR_TABLE_FROZEN_BITS), block,
+	      sizeof block);
+      index[b] = nblocks++;
+    }
+
+  f->table = table;
+  f->modiff = f->thawed_modiff = char_table_modiff;
+  f->quiet = 0;
+  f->values = values;
+  f->index = index;
+  f->blocks = xrealloc (blocks, ((nblocks << CHAR_TABLE_FROZEN_BITS)
+				 * sizeof *blocks));
+  return true;
+}
+
+/* Return the frozen copy of TABLE, or NULL if there is none that is
+   up to date.  */
+
+static struct char_table_frozen *
+char_table_frozen_lookup (Lisp_Object table)
+{
+  int i;
+
+  for (i = 0; i < char_table_frozen_used; i++)
+    {
+      struct char_table_frozen *f = &char_table_frozen[i];
+
+      if (EQ (f->table, table))
+	{
+	  if (f->modiff == char_table_modiff)
+	    return f;
+	  if (f->thawed_modiff != char_table_modiff)
+	    {
+	      f->thawed_modiff = char_table_modiff;
+	      f->quiet = 0;
+	    }
+	  else if (++f->quiet >= CHAR_TABLE_REFREEZE)
+	    {
+	      f->quiet = 0;
+	      if (char_table_freeze_1 (f, table))
+		return f;
+	    }
+	  return NULL;
+	}
+    }
+  return NULL;
+}
+
 Lisp_Object
 char_table_ref (Lisp_Object table, int c)
 {
   struct Lisp_Char_Table *tbl = XCHAR_TABLE (table);
   Lisp_Object val;
 
+  if (char_table_frozen_used > 0 && c < CHAR_TABLE_FROZEN_CHARS)
+    {
+      struct char_table_frozen *f = char_table_frozen_lookup (table);
+      if (f)
+	return f->values[f->blocks[(f->index[c >> CHAR_TABLE_FROZEN_BITS]
+				    << CHAR_TABLE_FROZEN_BITS)
+				   + (c & (CHAR_TABLE_FROZEN_BLOCK - 1))]];
+    }
+
   if (ASCII_CHAR_P (c))
     {
       val = tbl->ascii;
@@ -397,6 +581,57 @@ char_table_ref_and_range (Lisp_Object table, int c, int *from, int *to)
   return val;
 }
 
+/* Like char_table_ref_and_range, but look in the parents of TABLE
+   for the characters that have no value in TABLE.  */
+
+static Lisp_Object
+char_table_ref_and_range_inherit (Lisp_Object table, int c,
+				  int *from, int *to)
+{
+  Lisp_Object val = char_table_ref_and_range (table, c, from, to);
+
+  if (NILP (val) && CHAR_TABLE_P (XCHAR_TABLE (table)->parent))
+    val = char_table_ref_and_range_inherit (XCHAR_TABLE (table)->parent,
+					    c, from, to);
+  return val;
+}
+
+/* Store in RUNS, which has room for NRUNS elements, the successive
+   runs of characters from FROM to TO that share a value in TABLE, as
+   `aref' gives it: nil values are included, uniprop values are not
+   decoded.  Each run is as long as it can be within FROM..TO.  Return
+   the number of runs stored; if they end before TO, call again from
+   the character after the last one.  */
+
+ptrdiff_t
+char_table_runs (Lisp_Object table, int from, int to,
+		 struct char_table_run *runs, ptrdiff_t nruns)
+{
+  ptrdiff_t n = 0;
+  int c = from;
+
+  while (c <= to)
+    {
+      int run_from = c, run_to = to;
+      Lisp_Object val = char_table_ref_and_range_inherit (table, c, &run_from,
+							  &run_to);
+
+      if (n > 0 && EQ (runs[n - 1].val, val))
+	runs[n - 1].to = run_to;
+      else if (n == nruns)
+	break;
+      else
+	{
+	  runs[n].from = c;
+	  runs[n].to = run_to;
+	  runs[n].val = val;
+	  n++;
+	}
+      c = run_to + 1;
+    }
+  return n;
+}
+
 
 static void
 sub_char_table_set (Lisp_Object table, int c, Lisp_Object val, bool is_uniprop)
@@ -719,6 +954,48 @@ optimize_sub_char_table (Lisp_Object table, Lisp_Object test)
   return (optimizable ? elt : table);
 }
 
+DEFUN ("freeze-char-table", Ffreeze_char_table, Sfreeze_char_table,
+       1, 1, 0,
+       doc: /* Speed up lookups in CHAR-TABLE by making a flat copy of it.
+The copy holds the values, defaults and inherited values included, of
+the characters below #x30000.  Any change to a char-table makes the
+copy stale; it is made again once lookups in CHAR-TABLE go on for a
+while without further changes.  This is worth it for tables that are
+consulted for each character and seldom changed, such as
+`char-width-table'.  Only the last few tables frozen are kept.
+
+Return non-nil if CHAR-TABLE could be frozen.  */)
+  (Lisp_Object char_table)
+{
+  struct char_table_frozen f;
+  int i;
+
+  CHECK_CHAR_TABLE (char_table);
+
+  for (i = 0; i < char_table_frozen_used; i++)
+    if (EQ (char_table_frozen[i].table, char_table))
+      break;
+  if (i == char_table_frozen_used
+      && char_table_frozen_used < CHAR_TABLE_FROZEN_ENTRIES)
+    char_table_frozen_used++;
+  /* Drop the entry for CHAR-TABLE, or else the oldest one.  */
+  if (i == CHAR_TABLE_FROZEN_ENTRIES)
+    i--;
+  memmove (char_table_frozen + 1, char_table_frozen,
+	   i * sizeof *char_table_frozen);
+  char_table_frozen[0].table = Qnil;
+
+  if (! char_table_freeze_1 (&f, char_table))
+    {
+      char_table_frozen_used--;
+      memmove (char_table_frozen, char_table_frozen + 1,
+	       char_table_frozen_used * sizeof *char_table_frozen);
+      return Qnil;
+    }
+  char_table_frozen[0] = f;
+  return Qt;
+}
+
 DEFUN ("optimize-char-table", Foptimize_char_table, Soptimize_char_table,
        1, 2, 0,
        doc: /* Optimize CHAR-TABLE.
@@ -728,15 +1005,31 @@ equivalent and can be merged.  It defaults to `equal'.  */)
 {
   Lisp_Object elt;
   int i;
+  /* Whether the values `aref' gives are the ones stored.  */
+  bool plain;
 
   CHECK_CHAR_TABLE (char_table);
 
+  plain = (NILP (XCHAR_TABLE (char_table)->defalt)
+	   && NILP (XCHAR_TABLE (char_table)->parent)
+	   && !UNIPROP_TABLE_P (char_table));
   for (i = 0; i < chartab_size[0]; i++)
     {
       elt = XCHAR_TABLE (char_table)->contents[i];
       if (SUB_CHAR_TABLE_P (elt))
-	set_char_table_contents
-	  (char_table, i, optimize_sub_char_table (elt, test));
+	{
+	  struct char_table_run run;
+	  int from = i * chartab_chars[0], to = from + chartab_chars[0] - 1;
+
+	  /* A block whose characters all have the same value needs
+	     no comparisons.  */
+	  if (plain && char_table_runs (char_table, from, to, &run, 1) == 1
+	      && run.to == to)
+	    elt = run.val;
+	  else
+	    elt = optimize_sub_char_table (elt, test);
+	  set_char_table_contents (char_table, i, elt);
+	}
     }
   /* Reset the `ascii' cache, in case it got optimized away.  */
   set_char_table_ascii (char_table, char_table_ascii (char_table));
@@ -745,6 +1038,16 @@ equivalent and can be merged.  It defaults to `equal'.  */)
 }
 
 
+/* Return the value of C in TABLE, not looking in the parent.  */
+
+static Lisp_Object
+char_table_ref_shallow (Lisp_Object table, int c)
+{
+  int from = c, to = c;
+
+  return char_table_ref_and_range (table, c, &from, &to);
+}
+
 /* Map C_FUNCTION or FUNCTION over TABLE (top or sub char-table),
    calling it for each character or group of characters that share a
    value.  RANGE is a cons (FROM . TO) specifying the range of target
@@ -827,13 +1130,10 @@ map_sub_char_table (void (*c_function) (Lisp_Object, Lisp_Object, Lisp_Object),
 		  if (! NILP (XCHAR_TABLE (top)->parent))
 		    {
 		      Lisp_Object parent = XCHAR_TABLE (top)->parent;
-		      Lisp_Object temp = XCHAR_TABLE (parent)->parent;
 
-		      /* This is to get a value of FROM in PARENT
-			 without checking the parent of PARENT.  */
-		      set_char_table_parent (parent, Qnil);
-		      val = CHAR_TABLE_REF (parent, from);
-		      set_char_table_parent (parent, temp);
+		      /* Get a value of FROM in PARENT without checking
+			 the parent of PARENT.  */
+		      val = char_table_ref_shallow (parent, from);
 		      XSETCDR (range, make_number (c - 1));
 		      val = map_sub_char_table (c_function, function,
 						parent, arg, val, range,
@@ -906,16 +1206,12 @@ map_char_table (void (*c_function) (Lisp_Object, Lisp_Object, Lisp_Object),
      recursively.  */
   while (NILP (val) && ! NILP (XCHAR_TABLE (table)->parent))
     {
-      Lisp_Object temp;
       int from = XINT (XCAR (range));
 
       parent = XCHAR_TABLE (table)->parent;
-      temp = XCHAR_TABLE (parent)->parent;
-      /* This is to get a value of FROM in PARENT without checking the
-	 parent of PARENT.  */
-      set_char_table_parent (parent, Qnil);
-      val = CHAR_TABLE_REF (parent, from);
-      set_char_table_parent (parent, temp);
+      /* Get a value of FROM in PARENT without checking the parent of
+	 PARENT.  */
+      val = char_table_ref_shallow (parent, from);
       val = map_sub_char_table (c_function, function, parent, arg, val, range,
 				parent);
       table = parent;
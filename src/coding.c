@@ -289,6 +289,11 @@ encode_coding_XXX (struct coding_system *coding)
 #ifdef HAVE_WCHAR_H
 #include <wchar.h>
 #endif /* HAVE_WCHAR_H */
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 #include "lisp.h"
 #include "character.h"
@@ -6206,6 +6211,32 @@ static Lisp_Object adjust_coding_eol_type (struct coding_system *coding,
 					   int eol_seen);
 
 
+/* The source text is scanned for ASCII a word at a time.  A word is
+   loaded with memcpy, as the text need not be aligned.  It matters
+   only whether some byte of a word is zero, and not which, so the
+   borrows that ASCII_WORD_HAS_ZERO lets propagate do no harm.  */
+
+typedef uintptr_t ascii_word;
+#define ASCII_WORD_ONES ((ascii_word) -1 / 0xFF)
+#define ASCII_WORD_HIGH_BITS (ASCII_WORD_ONES * 0x80)
+#define ASCII_WORD_HAS_ZERO(w) \
+  (((w) - ASCII_WORD_ONES) & ~(w) & ASCII_WORD_HIGH_BITS)
+#define ASCII_WORD_HAS_BYTE(w, c) \
+  ASCII_WORD_HAS_ZERO ((w) ^ (ASCII_WORD_ONES * (c)))
+/* Whether some byte of W, a word of ASCII, is less than N.  */
+#define ASCII_WORD_HAS_LESS(w, n) \
+  (((w) - ASCII_WORD_ONES * (n)) & ~(w) & ASCII_WORD_HIGH_BITS)
+
+/* If the sizeof (ascii_word) bytes at SRC are ASCII with no CR, return
+   true and store them in *W.  */
+
+static bool
+ascii_word_at (const unsigned char *src, ascii_word *w)
+{
+  memcpy (w, src, sizeof *w);
+  return ! (*w & ASCII_WORD_HIGH_BITS) && ! ASCII_WORD_HAS_BYTE (*w, '\r');
+}
+
 /* Return the number of ASCII characters at the head of the source.
    By side effects, set coding->head_ascii and update
    coding->eol_seen.  The value of coding->eol_seen is "logical or" of
@@ -6229,6 +6260,15 @@ check_ascii (struct coding_system *coding)
       /* We don't have to check EOL format.  */
       while (src < end && !( *src & 0x80))
 	{
+	  ascii_word w;
+
+	  if (end - src >= (ptrdiff_t) sizeof w && ascii_word_at (src, &w))
+	    {
+	      if (ASCII_WORD_HAS_BYTE (w, '\n'))
+		eol_seen |= EOL_SEEN_LF;
+	      src += sizeof w;
+	      continue;
+	    }
 	  if (*src++ == '\n')
 	    eol_seen |= EOL_SEEN_LF;
 	}
@@ -6239,7 +6279,15 @@ check_ascii (struct coding_system *coding)
       while (src < end)
 	{
 	  int c = *src;
+	  ascii_word w;
 
+	  if (end - src >= (ptrdiff_t) sizeof w && ascii_word_at (src, &w))
+	    {
+	      if (ASCII_WORD_HAS_BYTE (w, '\n'))
+		eol_seen |= EOL_SEEN_LF;
+	      src += sizeof w;
+	      continue;
+	    }
 	  if (c & 0x80)
 	    break;
 	  src++;
@@ -6277,32 +6325,32 @@ check_ascii (struct coding_system *coding)
 }
 
 
-/* Return the number of characters at the source if all the bytes are
-   valid UTF-8 (of Unicode range).  Otherwise, return -1.  By side
-   effects, update coding->eol_seen.  The value of coding->eol_seen is
-   "logical or" of EOL_SEEN_LF, EOL_SEEN_CR, and EOL_SEEN_CRLF, but
-   the value is reliable only when all the source bytes are valid
-   UTF-8.  */
+/* Return the number of characters from SRC to END, the last byte of
+   the text, if they are all valid UTF-8 (of Unicode range).
+   Otherwise, return -1.  "Logical or" EOL_SEEN_LF, EOL_SEEN_CR, and
+   EOL_SEEN_CRLF for the end-of-lines seen into *EOL_SEEN.  This does
+   not touch any Lisp object, so it can run on another thread.  */
 
 static ptrdiff_t
-check_utf_8 (struct coding_system *coding)
+utf_8_scan (const unsigned char *src, const unsigned char *end,
+	    int *eol_seen_p)
 {
-  const unsigned char *src, *end;
-  int eol_seen;
-  ptrdiff_t nchars = coding->head_ascii;
+  int eol_seen = *eol_seen_p;
+  ptrdiff_t nchars = 0;
 
-  if (coding->head_ascii < 0)
-    check_ascii (coding);
-  else
-    coding_set_source (coding);
-  src = coding->source + coding->head_ascii;
-  /* We look ahead one byte for CR LF.  */
-  end = coding->source + coding->src_bytes - 1;
-  eol_seen = coding->eol_seen;
   while (src < end)
     {
       int c = *src;
+      ascii_word w;
 
+      if (end - src >= (ptrdiff_t) sizeof w && ascii_word_at (src, &w))
+	{
+	  if (ASCII_WORD_HAS_BYTE (w, '\n'))
+	    eol_seen |= EOL_SEEN_LF;
+	  src += sizeof w;
+	  nchars += sizeof w;
+	  continue;
+	}
       if (UTF_8_1_OCTET_P (*src))
 	{
 	  src++;
@@ -6373,10 +6421,136 @@ check_utf_8 (struct coding_system *coding)
       else if (*src  == '\n')
 	eol_seen |= EOL_SEEN_LF;
     }
-  coding->eol_seen = eol_seen;
+  *eol_seen_p = eol_seen;
   return nchars;
 }
 
+#ifdef HAVE_PTHREAD
+
+/* Source texts at least this long are checked by several threads.  */
+#define UTF_8_PARALLEL_BYTES (16 << 20)
+
+/* The most threads that check one text.  */
+#define UTF_8_MAX_THREADS 16
+
+struct utf_8_scan_job
+{
+  const unsigned char *src, *last;
+  int eol_seen;
+  ptrdiff_t nchars;
+};
+
+static void *
+utf_8_scan_thread (void *arg)
+{
+  struct utf_8_scan_job *job = arg;
+
+  job->nchars = utf_8_scan (job->src, job->last, &job->eol_seen);
+  return NULL;
+}
+
+/* Like utf_8_scan, but split the text into pieces checked on as many
+   threads as there are processors.  Each piece but the last ends
+   with a newline, so that no character or CR LF straddles two pieces
+   and the pieces add up to what one scan of the whole text finds.  */
+
+static ptrdiff_t
+utf_8_scan_parallel (const unsigned char *src, const unsigned char *last,
+		     int *eol_seen_p)
+{
+  struct utf_8_scan_job job[UTF_8_MAX_THREADS];
+  pthread_t thread[UTF_8_MAX_THREADS];
+  bool started[UTF_8_MAX_THREADS];
+  long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+  ptrdiff_t bytes = last + 1 - src;
+  ptrdiff_t nchars = 0;
+  ptrdiff_t piece;
+  int njobs, i;
+  sigset_t blocked, oldset;
+
+  njobs = min (ncpu, min (UTF_8_MAX_THREADS,
+			  bytes / (UTF_8_PARALLEL_BYTES / 4)));
+  if (njobs < 2)
+    return utf_8_scan (src, last, eol_seen_p);
+  piece = bytes / njobs;
+
+  for (i = 0; ; i++)
+    {
+      const unsigned char *nl
+	= (i < njobs - 1 && last - src > piece
+	   ? memchr (src + piece, '\n', last - (src + piece)) : NULL);
+
+      job[i].src = src;
+      job[i].last = nl ? nl : last;
+      job[i].eol_seen = EOL_SEEN_NONE;
+      if (! nl)
+	break;
+      src = nl + 1;
+    }
+  njobs = i + 1;
+
+  /* Signals must go to the main thread, so the others block them.  */
+  sigfillset (&blocked);
+  pthread_sigmask (SIG_BLOCK, &blocked, &oldset);
+  for (i = 0; i < njobs - 1; i++)
+    started[i] = pthread_create (&thread[i], NULL, utf_8_scan_thread,
+				 &job[i]) == 0;
+  pthread_sigmask (SIG_SETMASK, &oldset, 0);
+
+  utf_8_scan_thread (&job[njobs - 1]);
+  for (i = 0; i < njobs - 1; i++)
+    {
+      if (started[i])
+	pthread_join (thread[i], NULL);
+      else
+	utf_8_scan_thread (&job[i]);
+    }
+
+  for (i = 0; i < njobs; i++)
+    {
+      if (job[i].nchars < 0)
+	return -1;
+      nchars += job[i].nchars;
+      *eol_seen_p |= job[i].eol_seen;
+    }
+  return nchars;
+}
+
+#endif	/* HAVE_PTHREAD */
+
+/* Return the number of characters at the source if all the bytes are
+   valid UTF-8 (of Unicode range).  Otherwise, return -1.  By side
+   effects, update coding->eol_seen.  The value of coding->eol_seen is
+   "logical or" of EOL_SEEN_LF, EOL_SEEN_CR, and EOL_SEEN_CRLF, but
+   the value is reliable only when all the source bytes are valid
+   UTF-8.  */
+
+static ptrdiff_t
+check_utf_8 (struct coding_system *coding)
+{
+  const unsigned char *src, *last;
+  int eol_seen;
+  ptrdiff_t nchars;
+
+  if (coding->head_ascii < 0)
+    check_ascii (coding);
+  else
+    coding_set_source (coding);
+  src = coding->source + coding->head_ascii;
+  last = coding->source + coding->src_bytes - 1;
+  eol_seen = coding->eol_seen;
+#ifdef HAVE_PTHREAD
+  if (last - src >= UTF_8_PARALLEL_BYTES)
+    nchars = utf_8_scan_parallel (src, last, &eol_seen);
+  else
+#endif
+    nchars = utf_8_scan (src, last, &eol_seen);
+  if (nchars < 0)
+    return -1;
+  coding->eol_seen = eol_seen;
+  return coding->head_ascii + nchars;
+}
+
 
 /* Detect how end-of-line of a text of length SRC_BYTES pointed by
    SOURCE is encoded.  If CATEGORY is one of
@@ -6546,6 +6720,24 @@ detect_coding (struct coding_system *coding)
       detect_info.checked = detect_info.found = detect_info.rejected = 0;
       for (src = coding->source; src < src_end; src++)
 	{
+	  ascii_word w;
+
+	  /* A word of printable ASCII counts only for head_ascii.  This
+	     makes detecting ASCII-only text, which never settles on a
+	     coding system, cheap enough to do on every chunk of a
+	     process's output.  */
+	  if (src_end - src >= (ptrdiff_t) sizeof w)
+	    {
+	      memcpy (&w, src, sizeof w);
+	      if (! (w & ASCII_WORD_HIGH_BITS)
+		  && ! ASCII_WORD_HAS_LESS (w, 0x20))
+		{
+		  if (! eight_bit_found)
+		    coding->head_ascii += sizeof w;
+		  src += sizeof w - 1;
+		  continue;
+		}
+	    }
 	  c = *src;
 	  if (c & 0x80)
 	    {
@@ -7911,14 +8103,19 @@ decode_coding_gap (struct coding_system *coding,
       if (chars != bytes)
 	{
 	  /* There exists a non-ASCII byte.  */
+	  /* Detection may already have found whether it is all valid
+	     UTF-8; if it did not run, check_utf_8 finds that out.  */
 	  if (EQ (CODING_ATTR_TYPE (attrs), Qutf_8)
-	      && coding->detected_utf8_bytes == coding->src_bytes)
+	      && (coding->detected_utf8_bytes == coding->src_bytes
+		  || coding->detected_utf8_bytes < 0))
 	    {
-	      if (coding->detected_utf8_chars >= 0)
+	      if (coding->detected_utf8_bytes == coding->src_bytes
+		  && coding->detected_utf8_chars >= 0)
 		chars = coding->detected_utf8_chars;
 	      else
 		chars = check_utf_8 (coding);
-	      if (CODING_UTF_8_BOM (coding) != utf_without_bom
+	      if (chars > 0
+		  && CODING_UTF_8_BOM (coding) != utf_without_bom
 		  && coding->head_ascii == 0
 		  && coding->source[0] == UTF_8_BOM_1
 		  && coding->source[1] == UTF_8_BOM_2
@@ -8001,6 +8198,75 @@ decode_coding_gap (struct coding_system *coding,
 }
 
 
+/* Insert the source text of CODING in the buffer CODING->dst_object
+   as is, if that decodes it: if it is ASCII, or valid UTF-8 for a
+   UTF-8 coding system, and needs no EOL conversion.  Return true if
+   it was inserted.  This is the common case for process output and
+   strings, and is much faster than decode_coding.  */
+
+static bool
+decode_coding_by_copy (struct coding_system *coding)
+{
+  Lisp_Object attrs = CODING_ID_ATTRS (coding->id);
+  Lisp_Object eol_type;
+  ptrdiff_t bytes = coding->src_bytes;
+  ptrdiff_t chars;
+  bool utf_8 = EQ (CODING_ATTR_TYPE (attrs), Qutf_8);
+
+  if (disable_ascii_optimization
+      || coding->src_multibyte
+      || bytes == 0
+      || NILP (CODING_ATTR_ASCII_COMPAT (attrs))
+      || ! NILP (CODING_ATTR_POST_READ (attrs))
+      || ! NILP (get_translation_table (attrs, 0, NULL))
+      || (utf_8 && CODING_UTF_8_BOM (coding) == utf_with_bom))
+    return 0;
+
+  chars = coding->head_ascii;
+  if (chars < 0)
+    chars = check_ascii (coding);
+  if (chars != bytes)
+    {
+      if (! utf_8 || ! coding->dst_multibyte)
+	return 0;
+      /* A text split in the middle of a character fails here, and is
+	 left to decode_coding, which carries the partial character
+	 over to the next call.  */
+      chars = check_utf_8 (coding);
+      if (chars < 0)
+	return 0;
+      if (CODING_UTF_8_BOM (coding) != utf_without_bom
+	  && coding->source[0] == UTF_8_BOM_1)
+	return 0;
+    }
+
+  eol_type = CODING_ID_EOL_TYPE (coding->id);
+  if (VECTORP (eol_type) && coding->eol_seen != EOL_SEEN_NONE)
+    eol_type = adjust_coding_eol_type (coding, coding->eol_seen);
+  if (! (inhibit_eol_conversion || VECTORP (eol_type) || EQ (eol_type, Qunix)))
+    return 0;
+
+  if (utf_8)
+    CODING_UTF_8_BOM (coding) = utf_without_bom;
+  set_buffer_internal (XBUFFER (coding->dst_object));
+  if (GPT != PT)
+    move_gap_both (PT, PT_BYTE);
+  if (GAP_SIZE < bytes)
+    make_gap (bytes - GAP_SIZE);
+  coding_set_source (coding);
+  memcpy (GPT_ADDR, coding->source, bytes);
+  insert_from_gap (chars, bytes, 0);
+
+  coding->consumed = bytes;
+  coding->consumed_char = chars;
+  coding->produced = bytes;
+  coding->produced_char = chars;
+  coding->carryover_bytes = 0;
+  coding->errors = 0;
+  record_conversion_result (coding, CODING_RESULT_SUCCESS);
+  return 1;
+}
+
 /* Decode the text in the range FROM/FROM_BYTE and TO/TO_BYTE in
    SRC_OBJECT into DST_OBJECT by coding context CODING.
 
@@ -8094,6 +8360,9 @@ decode_coding_object (struct coding_system *coding,
 	}
     }
 
+  coding->head_ascii = -1;
+  coding->detected_utf8_bytes = coding->detected_utf8_chars = -1;
+  coding->eol_seen = EOL_SEEN_NONE;
   if (CODING_REQUIRE_DETECTION (coding))
     detect_coding (coding);
   attrs = CODING_ID_ATTRS (coding->id);
@@ -8126,7 +8395,9 @@ decode_coding_object (struct coding_system *coding,
       coding->dst_multibyte = 1;
     }
 
-  decode_coding (coding);
+  if (! (! BUFFERP (src_object) && BUFFERP (coding->dst_object)
+	 && decode_coding_by_copy (coding)))
+    decode_coding (coding);
 
   if (BUFFERP (coding->dst_object))
     set_buffer_internal (XBUFFER (coding->dst_object));
@@ -8422,6 +8693,58 @@ encode_coding_object (struct coding_system *coding,
   dynwind_end ();
 }
 
+/* Return true if CODING would encode the text from FROM_BYTE to
+   TO_BYTE of the current buffer into the same bytes, so that the
+   text can be written out as it is.  That is so for ASCII text with
+   an ASCII compatible coding system, and for UTF-8 text without raw
+   bytes, provided there is no EOL conversion, translation, pre-write
+   conversion or BOM.  CODING->src_multibyte must be set up.  */
+
+bool
+encode_coding_is_identity (struct coding_system *coding,
+			   ptrdiff_t from_byte, ptrdiff_t to_byte)
+{
+  Lisp_Object attrs = CODING_ID_ATTRS (coding->id);
+  bool utf_8 = (EQ (CODING_ATTR_TYPE (attrs), Qutf_8)
+		&& CODING_UTF_8_BOM (coding) == utf_without_bom);
+  int i;
+
+  if (NILP (CODING_ATTR_ASCII_COMPAT (attrs))
+      || ! NILP (CODING_ATTR_PRE_WRITE (attrs))
+      || ! NILP (get_translation_table (attrs, 1, NULL))
+      || ! EQ (CODING_ID_EOL_TYPE (coding->id), Qunix)
+      || CODING_REQUIRE_ANNOTATION (coding)
+      || coding->mode & CODING_MODE_SELECTIVE_DISPLAY)
+    return 0;
+  if (utf_8 && ! coding->src_multibyte)
+    return 1;
+
+  /* Check the text on either side of the gap.  */
+  for (i = 0; i < 2; i++)
+    {
+      ptrdiff_t beg = i == 0 ? from_byte : max (from_byte, GPT_BYTE);
+      ptrdiff_t end = i == 0 ? min (to_byte, GPT_BYTE) : to_byte;
+      const unsigned char *p, *pend;
+
+      if (beg >= end)
+	continue;
+      p = BYTE_POS_ADDR (beg);
+      pend = p + (end - beg);
+      if (utf_8)
+	{
+	  /* Raw bytes are the only multibyte characters that UTF-8
+	     does not encode as they are represented.  */
+	  if (memchr (p, 0xC0, pend - p) || memchr (p, 0xC1, pend - p))
+	    return 0;
+	}
+      else
+	for (; p < pend; p++)
+	  if (*p & 0x80)
+	    return 0;
+    }
+  return 1;
+}
+
 
 Lisp_Object
 preferred_coding_system (void)
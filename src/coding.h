@@ -721,6 +721,8 @@ extern void decode_coding_object (struct coding_system *,
 extern void encode_coding_object (struct coding_system *,
                                   Lisp_Object, ptrdiff_t, ptrdiff_t,
                                   ptrdiff_t, ptrdiff_t, Lisp_Object);
+extern bool encode_coding_is_identity (struct coding_system *,
+				       ptrdiff_t, ptrdiff_t);
 
 #if defined (WINDOWSNT) || defined (CYGWIN)
 
@@ -644,6 +644,34 @@ compose_text (ptrdiff_t start, ptrdiff_t end, Lisp_Object components,
 
 static Lisp_Object gstring_hash_table;
 
+/* When each entry of gstring_hash_table was last used, indexed by its
+   ID, and the clock that dates them.  When the table has more than
+   `composition-gstring-cache-size' entries, the least recently used
+   are removed.  */
+
+static EMACS_INT *gstring_used;
+static ptrdiff_t gstring_used_size;
+static EMACS_INT gstring_clock;
+
+/* Counts reported by `composition-gstring-cache-statistics'.  */
+
+static EMACS_INT gstring_hits, gstring_misses, gstring_evictions;
+
+static void
+gstring_touch (ptrdiff_t id)
+{
+  if (id >= gstring_used_size)
+    {
+      ptrdiff_t old_size = gstring_used_size;
+
+      gstring_used = xpalloc (gstring_used, &gstring_used_size,
+			      id + 1 - old_size, -1, sizeof *gstring_used);
+      memset (gstring_used + old_size, 0,
+	      (gstring_used_size - old_size) * sizeof *gstring_used);
+    }
+  gstring_used[id] = ++gstring_clock;
+}
+
 static Lisp_Object gstring_lookup_cache (Lisp_Object);
 
 static Lisp_Object
@@ -652,7 +680,14 @@ gstring_lookup_cache (Lisp_Object header)
   struct Lisp_Hash_Table *h = XHASH_TABLE (gstring_hash_table);
   ptrdiff_t i = hash_lookup (h, header, NULL);
 
-  return (i >= 0 ? HASH_VALUE (h, i) : Qnil);
+  if (i < 0)
+    {
+      gstring_misses++;
+      return Qnil;
+    }
+  gstring_hits++;
+  gstring_touch (i);
+  return HASH_VALUE (h, i);
 }
 
 Lisp_Object
@@ -680,6 +715,7 @@ composition_gstring_put_cache (Lisp_Object gstring, ptrdiff_t len)
     LGSTRING_SET_GLYPH (copy, i, Fcopy_sequence (LGSTRING_GLYPH (gstring, i)));
   i = hash_put (h, LGSTRING_HEADER (copy), copy, hash);
   LGSTRING_SET_ID (copy, make_number (i));
+  gstring_touch (i);
   return copy;
 }
 
@@ -688,9 +724,79 @@ composition_gstring_from_id (ptrdiff_t id)
 {
   struct Lisp_Hash_Table *h = XHASH_TABLE (gstring_hash_table);
 
+  gstring_touch (id);
   return HASH_VALUE (h, id);
 }
 
+struct gstring_age
+{
+  EMACS_INT used;
+  ptrdiff_t id;
+};
+
+static int
+compare_gstring_age (const void *a, const void *b)
+{
+  EMACS_INT used_a = ((const struct gstring_age *) a)->used;
+  EMACS_INT used_b = ((const struct gstring_age *) b)->used;
+
+  return used_a < used_b ? -1 : used_a > used_b;
+}
+
+/* If there are more glyph-strings in the cache than
+   `composition-gstring-cache-size', remove the least recently used
+   until a quarter of the room is free again.  Since this changes what
+   the IDs in glyph matrices refer to, the caller must be prepared to
+   redisplay everything, as redisplay_internal is when it clears the
+   face cache.  Value is true if anything was removed.  */
+
+bool
+composition_gstring_trim_cache (void)
+{
+  struct Lisp_Hash_Table *h = XHASH_TABLE (gstring_hash_table);
+  struct gstring_age *ages;
+  ptrdiff_t i, n, size = HASH_TABLE_SIZE (h);
+  EMACS_INT target;
+  USE_SAFE_ALLOCA;
+
+  if (composition_gstring_cache_size <= 0
+      || h->count <= composition_gstring_cache_size)
+    return 0;
+  target = composition_gstring_cache_size - composition_gstring_cache_size / 4;
+
+  SAFE_NALLOCA (ages, 1, h->count);
+  for (i = n = 0; i < size && n < h->count; i++)
+    if (!NILP (HASH_HASH (h, i)))
+      {
+	ages[n].used = i < gstring_used_size ? gstring_used[i] : 0;
+	ages[n].id = i;
+	n++;
+      }
+  qsort (ages, n, sizeof *ages, compare_gstring_age);
+  for (i = 0; i < n && h->count > target; i++)
+    {
+      hash_remove_from_table (h, HASH_KEY (h, ages[i].id));
+      gstring_evictions++;
+    }
+  SAFE_FREE ();
+  return 1;
+}
+
+DEFUN ("composition-gstring-cache-statistics",
+       Fcomposition_gstring_cache_statistics,
+       Scomposition_gstring_cache_statistics, 0, 0, 0,
+       doc: /* Return a list (COUNT HITS MISSES EVICTIONS) for the glyph-string cache.
+COUNT is how many shaped glyph-strings are cached now.  HITS and
+MISSES count how often a glyph-string was found in the cache and how
+often it had to be made, and EVICTIONS how many were removed because
+the cache was full.  See `composition-gstring-cache-size'.  */)
+  (void)
+{
+  return list4 (make_number (XHASH_TABLE (gstring_hash_table)->count),
+		make_number (gstring_hits), make_number (gstring_misses),
+		make_number (gstring_evictions));
+}
+
 bool
 composition_gstring_p (Lisp_Object gstring)
 {
@@ -1970,6 +2076,15 @@ The default value is the function `compose-chars-after'.  */);
   DEFSYM (Qauto_composed, "auto-composed");
   DEFSYM (Qauto_composition_function, "auto-composition-function");
 
+  DEFVAR_INT ("composition-gstring-cache-size", composition_gstring_cache_size,
+	      doc: /* Maximum number of shaped glyph-strings to keep.
+Automatic composition remembers how each sequence of characters was
+shaped with each font, so that recurring sequences need not be shaped
+again in any buffer.  When more than this many are remembered, the
+least recently used are forgotten at the end of redisplay, and all
+windows are redisplayed.  Zero or less means no limit.  */);
+  composition_gstring_cache_size = 8192;
+
   DEFVAR_LISP ("auto-composition-mode", Vauto_composition_mode,
 	       doc: /* Non-nil if Auto-Composition mode is enabled.
 Use the command `auto-composition-mode' to change this variable. */);
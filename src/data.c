@@ -81,7 +81,7 @@ static Lisp_Object Qoverlay, Qwindow_configuration;
 static Lisp_Object Qprocess, Qmarker;
 static Lisp_Object Qcompiled_function, Qframe;
 Lisp_Object Qbuffer;
-static Lisp_Object Qchar_table, Qbool_vector, Qhash_table;
+static Lisp_Object Qchar_table, Qbool_vector, Qhash_table, Qzlib_stream;
 static Lisp_Object Qsubrp;
 static Lisp_Object Qmany, Qunevalled;
 Lisp_Object Qfont_spec, Qfont_entity, Qfont_object;
@@ -287,6 +287,10 @@ for example, (type-of 1) returns `integer'.  */)
 	return Qframe;
       if (HASH_TABLE_P (object))
 	return Qhash_table;
+      if (STRING_BUILDER_P (object))
+	return Qstring_builder;
+      if (ZLIB_STREAM_P (object))
+	return Qzlib_stream;
       if (FONT_SPEC_P (object))
 	return Qfont_spec;
       if (FONT_ENTITY_P (object))
@@ -666,6 +670,26 @@ DEFUN ("symbol-plist", Fsymbol_plist, Ssymbol_plist, 1, 1, 0,
   return symbol_plist (symbol);
 }
 
+/* The names of symbols as Lisp strings, so that the name of a symbol
+   is converted from Scheme only once.  The keys are weak.  */
+static Lisp_Object symbol_names;
+
+Lisp_Object
+symbol_name_string (Lisp_Object sym)
+{
+  Lisp_Object name;
+
+  if (!symbol_names)
+    symbol_names = scm_make_weak_key_hash_table (SCM_UNDEFINED);
+  name = scm_hashq_ref (symbol_names, sym, SCM_BOOL_F);
+  if (!STRINGP (name))
+    {
+      name = Fstring_from_scheme (scm_call_1 (symbol_name_fn, sym));
+      scm_hashq_set_x (symbol_names, sym, name);
+    }
+  return name;
+}
+
 DEFUN ("symbol-name", Fsymbol_name, Ssymbol_name, 1, 1, 0,
        doc: /* Return SYMBOL's name, a string.  */)
   (register Lisp_Object symbol)
@@ -1028,6 +1052,38 @@ swap_in_global_binding (sym_t symbol)
   set_blv_found (blv, 0);
 }
 
+/* Return the element of B's local_var_alist for SYMBOL, whose
+   buffer-local value is BLV, or nil if B has no local binding for it.
+   Remember the answer in B's cache until local_var_alist changes.  */
+
+static Lisp_Object
+buffer_local_cell (struct buffer *b, sym_t symbol,
+		   struct Lisp_Buffer_Local_Value *blv)
+{
+  struct local_var_cache_entry *e;
+  Lisp_Object var;
+
+  if (b->local_var_cache_size <= blv->slot)
+    {
+      ptrdiff_t size = max (blv_slot_count, 2 * b->local_var_cache_size);
+      struct local_var_cache_entry *cache = xzalloc (size * sizeof *cache);
+      if (b->local_var_cache)
+	memcpy (cache, b->local_var_cache,
+		b->local_var_cache_size * sizeof *cache);
+      b->local_var_cache = cache;
+      b->local_var_cache_size = size;
+    }
+
+  e = &b->local_var_cache[blv->slot];
+  if (e->tick == b->local_var_tick && e->tick != 0)
+    return e->cell;
+
+  XSETSYMBOL (var, symbol);
+  e->cell = assq_no_quit (var, BVAR (b, local_var_alist));
+  e->tick = b->local_var_tick;
+  return e->cell;
+}
+
 /* Set up the buffer-local symbol SYMBOL for validity in the current buffer.
    VALCONTENTS is the contents of its value cell,
    which points to a struct Lisp_Buffer_Local_Value.
@@ -1065,7 +1121,7 @@ swap_in_symval_forwarding (sym_t symbol, struct Lisp_Buffer_Local_Value *blv)
 	  }
 	else
 	  {
-	    tem1 = assq_no_quit (var, BVAR (current_buffer, local_var_alist));
+	    tem1 = buffer_local_cell (current_buffer, symbol, blv);
 	    set_blv_where (blv, Fcurrent_buffer ());
 	  }
       }
@@ -1101,6 +1157,16 @@ find_symbol_value (Lisp_Object symbol)
     case SYMBOL_LOCALIZED:
       {
 	struct Lisp_Buffer_Local_Value *blv = SYMBOL_BLV (sym);
+
+	/* A variable with no C forwarding keeps every binding's value
+	   in its cons cell, so another buffer's binding can be read
+	   there without swapping it in.  */
+	if (!blv->fwd && !blv->frame_local
+	    && !(BUFFERP (blv->where) && XBUFFER (blv->where) == current_buffer))
+	  {
+	    Lisp_Object cell = buffer_local_cell (current_buffer, sym, blv);
+	    return XCDR (NILP (cell) ? blv->defcell : cell);
+	  }
 	swap_in_symval_forwarding (sym, blv);
 	return blv->fwd ? do_symval_forwarding (blv->fwd) : blv_value (blv);
       }
@@ -1200,10 +1266,9 @@ set_internal (Lisp_Object symbol, Lisp_Object newval, Lisp_Object where,
 
 	    /* Find the new binding.  */
 	    XSETSYMBOL (symbol, sym); /* May have changed via aliasing.  */
-	    tem1 = Fassq (symbol,
-			  (blv->frame_local
-			   ? XFRAME (where)->param_alist
-			   : BVAR (XBUFFER (where), local_var_alist)));
+	    tem1 = (blv->frame_local
+		    ? Fassq (symbol, XFRAME (where)->param_alist)
+		    : buffer_local_cell (XBUFFER (where), sym, blv));
 	    set_blv_where (blv, where);
 	    blv->found = 1;
 
@@ -1444,6 +1509,9 @@ union Lisp_Val_Fwd
     union Lisp_Fwd *fwd;
   };
 
+/* Number of slots handed out to buffer-local values so far.  */
+static ptrdiff_t blv_slot_count;
+
 static struct Lisp_Buffer_Local_Value *
 make_blv (sym_t sym, bool forwarded,
 	  union Lisp_Val_Fwd valcontents)
@@ -1468,6 +1536,7 @@ make_blv (sym_t sym, bool forwarded,
   set_blv_defcell (blv, tem);
   set_blv_valcell (blv, tem);
   set_blv_found (blv, 0);
+  blv->slot = blv_slot_count++;
   return blv;
 }
 
@@ -2138,6 +2207,7 @@ bool-vector.  IDX starts at 0.  */)
 	args_out_of_range (array, idx);
       CHECK_CHARACTER (newelt);
       c = XFASTINT (newelt);
+      string_text_changed (array);
 
       if (STRING_MULTIBYTE (array))
 	{
@@ -2199,6 +2269,24 @@ arithcompare (Lisp_Object num1, Lisp_Object num2, enum Arith_Comparison comparis
   double f1 = 0, f2 = 0;
   bool floatp = 0;
 
+  /* Fast path for the common case of two fixnums.  */
+  if (INTEGERP (num1) && INTEGERP (num2))
+    {
+      EMACS_INT i1 = XINT (num1), i2 = XINT (num2);
+      bool result;
+      switch (comparison)
+	{
+	case ARITH_EQUAL: result = i1 == i2; break;
+	case ARITH_NOTEQUAL: result = i1 != i2; break;
+	case ARITH_LESS: result = i1 < i2; break;
+	case ARITH_LESS_OR_EQUAL: result = i1 <= i2; break;
+	case ARITH_GRTR: result = i1 > i2; break;
+	case ARITH_GRTR_OR_EQUAL: result = i1 >= i2; break;
+	default: emacs_abort ();
+	}
+      return result ? Qt : Qnil;
+    }
+
   CHECK_NUMBER_OR_FLOAT_COERCE_MARKER (num1);
   CHECK_NUMBER_OR_FLOAT_COERCE_MARKER (num2);
 
@@ -2251,6 +2339,8 @@ arithcompare_driver (ptrdiff_t nargs, Lisp_Object *args,
                      enum Arith_Comparison comparison)
 {
   ptrdiff_t argnum;
+  if (nargs == 2)
+    return arithcompare (args[0], args[1], comparison);
   for (argnum = 1; argnum < nargs; ++argnum)
     {
       if (EQ (Qnil, arithcompare (args[argnum - 1], args[argnum], comparison)))
@@ -2480,6 +2570,35 @@ enum arithop
 
 static Lisp_Object float_arith_driver (double, ptrdiff_t, enum arithop,
                                        ptrdiff_t, Lisp_Object *);
+
+/* Return A CODE B for fixnums A and B if the result is a fixnum, or
+   Qnil to let arith_driver handle overflow.  Only Aadd, Asub and
+   Amult are handled.  */
+
+static Lisp_Object
+fixnum_arith2 (enum arithop code, EMACS_INT a, EMACS_INT b)
+{
+  EMACS_INT r;
+
+  switch (code)
+    {
+    case Aadd:
+      r = a + b;
+      break;
+    case Asub:
+      r = a - b;
+      break;
+    case Amult:
+      if (INT_MULTIPLY_OVERFLOW (a, b))
+	return Qnil;
+      r = a * b;
+      break;
+    default:
+      emacs_abort ();
+    }
+  return FIXNUM_OVERFLOW_P (r) ? Qnil : make_number (r);
+}
+
 static Lisp_Object
 arith_driver (enum arithop code, ptrdiff_t nargs, Lisp_Object *args)
 {
@@ -2489,6 +2608,17 @@ arith_driver (enum arithop code, ptrdiff_t nargs, Lisp_Object *args)
   EMACS_INT next, ok_accum;
   bool overflow = 0;
 
+  /* Two fixnums are the most common case by far.  Fixnums are
+     narrower than EMACS_INT, so their sum and difference cannot
+     overflow it.  */
+  if (nargs == 2 && INTEGERP (args[0]) && INTEGERP (args[1])
+      && (code == Aadd || code == Asub || code == Amult))
+    {
+      val = fixnum_arith2 (code, XINT (args[0]), XINT (args[1]));
+      if (!NILP (val))
+	return val;
+    }
+
   switch (code)
     {
     case Alogior:
@@ -2737,6 +2867,88 @@ Both X and Y must be numbers or markers.  */)
   return val;
 }
 
+/* Digit lists, such as the big integers of Calc, are lists of
+   nonnegative integers less than a base, least significant first.
+   They are converted to Guile integers, which are bignums as needed,
+   for the arithmetic.  */
+
+static Lisp_Object
+check_digit_base (Lisp_Object base)
+{
+  CHECK_NATNUM (base);
+  if (XINT (base) < 2)
+    args_out_of_range (base, make_number (2));
+  return base;
+}
+
+/* Return the integer that DIGITS stand for in BASE.  */
+
+static SCM
+digits_to_integer (Lisp_Object digits, Lisp_Object base)
+{
+  SCM n = SCM_INUM0;
+  Lisp_Object tail;
+
+  CHECK_LIST (digits);
+  for (tail = Freverse (digits); CONSP (tail); tail = XCDR (tail))
+    {
+      Lisp_Object digit = XCAR (tail);
+
+      CHECK_NATNUM (digit);
+      if (XINT (digit) >= XINT (base))
+	args_out_of_range (digit, base);
+      n = scm_sum (scm_product (n, base), digit);
+    }
+  return n;
+}
+
+/* Return the digits of N, a nonnegative integer, in BASE.  */
+
+static Lisp_Object
+integer_to_digits (SCM n, Lisp_Object base)
+{
+  Lisp_Object digits = Qnil;
+
+  while (scm_is_false (scm_zero_p (n)))
+    {
+      SCM digit;
+
+      scm_euclidean_divide (n, base, &n, &digit);
+      digits = Fcons (digit, digits);
+    }
+  return Fnreverse (digits);
+}
+
+DEFUN ("digits-multiply", Fdigits_multiply, Sdigits_multiply, 3, 3, 0,
+       doc: /* Return the product of the digit lists A and B in BASE.
+A digit list is a list of the digits of a nonnegative integer in BASE,
+least significant first, as in the big integers of Calc.  The product
+has no high zero digits; zero has no digits at all.  */)
+  (Lisp_Object a, Lisp_Object b, Lisp_Object base)
+{
+  check_digit_base (base);
+  return integer_to_digits (scm_product (digits_to_integer (a, base),
+					 digits_to_integer (b, base)),
+			    base);
+}
+
+DEFUN ("digits-divide", Fdigits_divide, Sdigits_divide, 3, 3, 0,
+       doc: /* Divide the digit list A by the digit list B in BASE.
+Return (QUOTIENT . REMAINDER), both digit lists as for `digits-multiply'.
+Signal `arith-error' if B is zero.  */)
+  (Lisp_Object a, Lisp_Object b, Lisp_Object base)
+{
+  SCM x, y, q, r;
+
+  check_digit_base (base);
+  x = digits_to_integer (a, base);
+  y = digits_to_integer (b, base);
+  if (scm_is_true (scm_zero_p (y)))
+    xsignal0 (Qarith_error);
+  scm_euclidean_divide (x, y, &q, &r);
+  return Fcons (integer_to_digits (q, base), integer_to_digits (r, base));
+}
+
 DEFUN ("max", Fmax, Smax, 1, MANY, 0,
        doc: /* Return largest of all the arguments (which must be numbers or markers).
 The value is always a number; markers are converted to numbers.
@@ -3484,6 +3696,7 @@ syms_of_data (void)
   DEFSYM (Qchar_table, "char-table");
   DEFSYM (Qbool_vector, "bool-vector");
   DEFSYM (Qhash_table, "hash-table");
+  DEFSYM (Qzlib_stream, "zlib-stream");
   DEFSYM (Qmisc, "misc");
 
   DEFSYM (Qdefun, "defun");
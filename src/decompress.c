@@ -52,6 +52,20 @@ DEF_ZLIB_FN (int, inflate,
 DEF_ZLIB_FN (int, inflateEnd,
 	     (z_streamp strm));
 
+DEF_ZLIB_FN (int, inflateReset,
+	     (z_streamp strm));
+
+DEF_ZLIB_FN (int, deflateInit2_,
+	     (z_streamp strm, int level, int method, int windowBits,
+	      int memLevel, int strategy, const char *version,
+	      int stream_size));
+
+DEF_ZLIB_FN (int, deflate,
+	     (z_streamp strm, int flush));
+
+DEF_ZLIB_FN (int, deflateEnd,
+	     (z_streamp strm));
+
 static bool zlib_initialized;
 
 static bool
@@ -68,17 +82,29 @@ init_zlib_functions (void)
   LOAD_ZLIB_FN (library, inflateInit2_);
   LOAD_ZLIB_FN (library, inflate);
   LOAD_ZLIB_FN (library, inflateEnd);
+  LOAD_ZLIB_FN (library, inflateReset);
+  LOAD_ZLIB_FN (library, deflateInit2_);
+  LOAD_ZLIB_FN (library, deflate);
+  LOAD_ZLIB_FN (library, deflateEnd);
   return true;
 }
 
 #define fn_inflateInit2(strm, windowBits) \
         fn_inflateInit2_((strm), (windowBits), ZLIB_VERSION, sizeof(z_stream))
 
+#define fn_deflateInit2(strm, level, method, windowBits, memLevel, strategy) \
+        fn_deflateInit2_((strm), (level), (method), (windowBits), \
+			 (memLevel), (strategy), ZLIB_VERSION, sizeof(z_stream))
+
 #else /* !WINDOWSNT */
 
 #define fn_inflateInit2		inflateInit2
 #define fn_inflate		inflate
 #define fn_inflateEnd		inflateEnd
+#define fn_inflateReset		inflateReset
+#define fn_deflateInit2		deflateInit2
+#define fn_deflate		deflate
+#define fn_deflateEnd		deflateEnd
 
 #endif	/* WINDOWSNT */
 
@@ -225,6 +251,205 @@ This function can be called only in unibyte buffers.  */)
   return Qt;
 }
 
+
+/* Streams, for data that arrives piecemeal, from a process or from a
+   file read a chunk at a time.  */
+
+struct Lisp_Zlib_Stream
+{
+  struct vectorlike_header header;
+
+  z_stream stream;
+
+  /* True for compression, false for decompression.  */
+  bool compress;
+
+  /* True when decompression has reached the end of a gzip member.
+     More input starts another member, as with `gzip -d'.  */
+  bool member_end;
+
+  /* True once the last input has been given; zlib's state is freed.  */
+  bool finished;
+};
+
+static Lisp_Object Qzlib_error, Qzlib_stream_p, Qcompress, Qdecompress;
+
+/* zlib's working memory comes from the garbage collector, so that a
+   stream that is dropped without being finished does not leak.  */
+
+static voidpf
+zlib_alloc (voidpf opaque, uInt items, uInt size)
+{
+  return xnmalloc (items, size);
+}
+
+static void
+zlib_free (voidpf opaque, voidpf address)
+{
+  xfree (address);
+}
+
+static struct Lisp_Zlib_Stream *
+check_zlib_stream (Lisp_Object stream)
+{
+  CHECK_TYPE (ZLIB_STREAM_P (stream), Qzlib_stream_p, stream);
+  return SMOB_PTR (stream);
+}
+
+static _Noreturn void
+zlib_stream_error (struct Lisp_Zlib_Stream *z, Lisp_Object stream,
+		   const char *message)
+{
+  if (z->stream.msg)
+    message = z->stream.msg;
+  xsignal2 (Qzlib_error, build_string (message), stream);
+}
+
+DEFUN ("zlib-make-stream", Fzlib_make_stream, Szlib_make_stream, 1, 2, 0,
+       doc: /* Return a new zlib stream for MODE, `decompress' or `compress'.
+A decompression stream accepts gzip or zlib data, including several
+gzip members in a row.  A compression stream produces gzip data; LEVEL,
+from 0 to 9, trades speed for size and defaults to zlib's usual choice.
+Use `zlib-stream-feed' to pass data through the stream.  */)
+  (Lisp_Object mode, Lisp_Object level)
+{
+  struct Lisp_Zlib_Stream *z;
+  Lisp_Object stream;
+  int status;
+
+#ifdef WINDOWSNT
+  if (!zlib_initialized)
+    zlib_initialized = init_zlib_functions ();
+  if (!zlib_initialized)
+    error ("zlib library not found");
+#endif
+
+  if (!EQ (mode, Qcompress) && !EQ (mode, Qdecompress))
+    signal_error ("Invalid zlib stream mode", mode);
+  if (!NILP (level))
+    CHECK_RANGED_INTEGER (level, 0, 9);
+
+  z = ALLOCATE_PSEUDOVECTOR (struct Lisp_Zlib_Stream, stream,
+			     PVEC_ZLIB_STREAM);
+  XSETPSEUDOVECTOR (stream, z, PVEC_ZLIB_STREAM);
+  memset (&z->stream, 0, sizeof z->stream);
+  z->stream.zalloc = zlib_alloc;
+  z->stream.zfree = zlib_free;
+  z->compress = EQ (mode, Qcompress);
+  z->member_end = false;
+  z->finished = false;
+
+  /* As for `zlib-decompress-region', 32 means "detect gzip or zlib";
+     16 asks for a gzip header when compressing.  */
+  if (z->compress)
+    status = fn_deflateInit2 (&z->stream,
+			      NILP (level) ? Z_DEFAULT_COMPRESSION : XINT (level),
+			      Z_DEFLATED, MAX_WBITS + 16, 8,
+			      Z_DEFAULT_STRATEGY);
+  else
+    status = fn_inflateInit2 (&z->stream, MAX_WBITS + 32);
+  if (status != Z_OK)
+    zlib_stream_error (z, stream, "Cannot initialize zlib stream");
+  return stream;
+}
+
+DEFUN ("zlib-stream-p", Fzlib_stream_p, Szlib_stream_p, 1, 1, 0,
+       doc: /* Return t if OBJECT is a zlib stream.  */)
+  (Lisp_Object object)
+{
+  return ZLIB_STREAM_P (object) ? Qt : Qnil;
+}
+
+DEFUN ("zlib-stream-feed", Fzlib_stream_feed, Szlib_stream_feed, 2, 3, 0,
+       doc: /* Pass the unibyte string INPUT through zlib stream STREAM.
+Return the output that is ready, as a unibyte string; a stream may
+hold back some output until it has seen more input.  Input can be split
+anywhere, so this can be called from a process filter or on successive
+chunks of a file.
+
+Non-nil FINISH says that INPUT is the last input: the rest of the
+output is returned, and STREAM cannot be used again.  Finishing a
+decompression stream in the middle of compressed data signals
+`zlib-error', as does corrupt input.  */)
+  (Lisp_Object stream, Lisp_Object input, Lisp_Object finish)
+{
+  struct Lisp_Zlib_Stream *z = check_zlib_stream (stream);
+  Lisp_Object builder;
+  ptrdiff_t pos = 0, nbytes;
+
+  CHECK_STRING (input);
+  if (STRING_MULTIBYTE (input))
+    {
+      if (SCHARS (input) != SBYTES (input))
+	signal_error ("zlib input must be unibyte", input);
+      input = Fstring_to_unibyte (input);
+    }
+  if (z->finished)
+    signal_error ("zlib stream is already finished", stream);
+
+  builder = Fmake_string_builder ();
+  nbytes = SBYTES (input);
+
+  for (;;)
+    {
+      /* Produce output a bounded piece at a time, as
+	 `zlib-decompress-region' does.  */
+      unsigned char out[16 * 1024];
+      ptrdiff_t avail_in = min (nbytes - pos, UINT_MAX);
+      int status;
+
+      if (z->member_end && avail_in > 0)
+	{
+	  fn_inflateReset (&z->stream);
+	  z->member_end = false;
+	}
+
+      z->stream.next_in = SDATA (input) + pos;
+      z->stream.avail_in = avail_in;
+      z->stream.next_out = out;
+      z->stream.avail_out = sizeof out;
+      if (z->compress)
+	status = fn_deflate (&z->stream,
+			     NILP (finish) || avail_in < nbytes - pos
+			     ? Z_NO_FLUSH : Z_FINISH);
+      else
+	status = fn_inflate (&z->stream, Z_NO_FLUSH);
+      pos += avail_in - z->stream.avail_in;
+      string_builder_append (XSTRING_BUILDER (builder), out,
+			     sizeof out - z->stream.avail_out,
+			     sizeof out - z->stream.avail_out, false);
+
+      if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+	zlib_stream_error (z, stream, "Corrupt compressed data");
+
+      if (status == Z_STREAM_END)
+	{
+	  if (z->compress)
+	    break;
+	  z->member_end = true;
+	}
+      else if (pos == nbytes && z->stream.avail_out != 0
+	       && (!z->compress || NILP (finish)))
+	break;
+      if (z->member_end && pos == nbytes)
+	break;
+      QUIT;
+    }
+
+  if (!NILP (finish))
+    {
+      if (!z->compress && !z->member_end)
+	zlib_stream_error (z, stream, "Truncated compressed data");
+      if (z->compress)
+	fn_deflateEnd (&z->stream);
+      else
+	fn_inflateEnd (&z->stream);
+      z->finished = true;
+    }
+
+  return Fstring_builder_string (builder, Qnil);
+}
+
 
 /***********************************************************************
 			    Initialization
@@ -235,6 +460,15 @@ syms_of_decompress (void)
 #include "decompress.x"
 
   DEFSYM (Qzlib_dll, "zlib");
+  DEFSYM (Qzlib_error, "zlib-error");
+  DEFSYM (Qzlib_stream_p, "zlib-stream-p");
+  DEFSYM (Qcompress, "compress");
+  DEFSYM (Qdecompress, "decompress");
+
+  Fput (Qzlib_error, Qerror_conditions,
+	Fpurecopy (list2 (Qzlib_error, Qerror)));
+  Fput (Qzlib_error, Qerror_message,
+	build_pure_c_string ("zlib error"));
 }
 
 #endif /* HAVE_ZLIB */
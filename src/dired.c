@@ -31,6 +31,7 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 
 #include <errno.h>
 #include <fcntl.h>
+#include <math.h>
 #include <unistd.h>
 
 #include <dirent.h>
@@ -53,13 +54,36 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 
 static Lisp_Object Qdirectory_files;
 static Lisp_Object Qdirectory_files_and_attributes;
+static Lisp_Object Qdirectory_files_recursively;
 static Lisp_Object Qfile_name_completion;
 static Lisp_Object Qfile_name_all_completions;
 static Lisp_Object Qfile_attributes;
 static Lisp_Object Qfile_attributes_lessp;
+static Lisp_Object Qinsert_directory;
+static Lisp_Object Qdired_filename;
+
+/* The names of the users, or groups, that own the files listed by
+   one call of directory_files_internal.  The files of a directory
+   mostly have the same few owners, so this saves looking up the same
+   name for each of them.  An ID whose name is unknown has nil.  */
+
+#define ID_NAME_CACHE_SIZE 8
+
+struct id_name_cache
+{
+  int n;
+  uintmax_t id[ID_NAME_CACHE_SIZE];
+  Lisp_Object name[ID_NAME_CACHE_SIZE];
+};
+
+struct owner_names
+{
+  struct id_name_cache users, groups;
+};
 
 static ptrdiff_t scmp (const char *, const char *, ptrdiff_t);
-static Lisp_Object file_attributes (int, char const *, Lisp_Object);
+static Lisp_Object file_attributes (int, char const *, Lisp_Object,
+				    struct owner_names *);
 
 /* Return the number of bytes in DP's name.  */
 static ptrdiff_t
@@ -146,6 +170,9 @@ directory_files_internal (Lisp_Object directory, Lisp_Object full,
   dynwind_begin ();
   struct gcpro gcpro1, gcpro2, gcpro3, gcpro4, gcpro5;
   struct dirent *dp;
+  struct owner_names owners;
+
+  owners.users.n = owners.groups.n = 0;
 
   /* Because of file name handlers, these functions might call
      Ffuncall, and cause a GC.  */
@@ -296,7 +323,7 @@ directory_files_internal (Lisp_Object directory, Lisp_Object full,
 	  if (attrs)
 	    {
 	      Lisp_Object fileattrs
-		= file_attributes (fd, dp->d_name, id_format);
+		= file_attributes (fd, dp->d_name, id_format, &owners);
 	      list = Fcons (Fcons (finalname, fileattrs), list);
 	    }
 	  else
@@ -368,6 +395,145 @@ which see.  */)
   return directory_files_internal (directory, full, match, nosort, 1, id_format);
 }
 
+/* Return true if DP, an entry of the directory FD, is a directory
+   and not a symbolic link to one.  The entry's type usually tells.  */
+
+static bool
+dirent_directory_p (int fd, struct dirent *dp)
+{
+  struct stat st;
+
+#ifdef DT_UNKNOWN
+  if (dp->d_type != DT_UNKNOWN)
+    return dp->d_type == DT_DIR;
+#endif
+  return (fstatat (fd, dp->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0
+	  && S_ISDIR (st.st_mode));
+}
+
+/* Push onto LIST the files below DIRECTORY, a directory name, as
+   Fdirectory_files_recursively describes, and return the new list.
+   Each directory is read and closed before its subdirectories are
+   walked, so only one is open at a time.  A subdirectory that cannot
+   be read is skipped, but not DIRECTORY itself if it is TOPLEVEL.  */
+
+static Lisp_Object
+directory_files_recursively (Lisp_Object directory, Lisp_Object match,
+			     Lisp_Object prune, bool include_directories,
+			     Lisp_Object list, bool toplevel)
+{
+  DIR *d;
+  int fd;
+  Lisp_Object entries = Qnil, tail;
+  struct dirent *dp;
+  dynwind_begin ();
+
+  d = open_directory (SSDATA (ENCODE_FILE (directory)), &fd);
+  if (d == NULL)
+    {
+      if (toplevel)
+	report_file_error ("Opening directory", directory);
+      dynwind_end ();
+      return list;
+    }
+  record_unwind_protect_ptr (directory_files_internal_unwind, d);
+
+  for (;;)
+    {
+      Lisp_Object name;
+
+      errno = 0;
+      dp = readdir (d);
+      if (!dp)
+	{
+	  if (errno == EAGAIN || errno == EINTR)
+	    {
+	      QUIT;
+	      continue;
+	    }
+	  break;
+	}
+      if (dp->d_name[0] == '.'
+	  && (dp->d_name[1] == 0
+	      || (dp->d_name[1] == '.' && dp->d_name[2] == 0)))
+	continue;
+
+      name = DECODE_FILE (make_unibyte_string (dp->d_name,
+					       dirent_namelen (dp)));
+      entries = Fcons (Fcons (name, dirent_directory_p (fd, dp) ? Qt : Qnil),
+		       entries);
+    }
+
+  dynwind_end ();
+
+  /* Sort the entries by name, as `file-attributes-lessp' does.  */
+  entries = Fsort (entries, Qfile_attributes_lessp);
+  for (tail = entries; CONSP (tail); tail = XCDR (tail))
+    {
+      Lisp_Object name = XCAR (XCAR (tail));
+      Lisp_Object file = concat2 (directory, name);
+      bool wanted = NILP (match) || fast_string_match (match, name) >= 0;
+
+      QUIT;
+      if (NILP (XCDR (XCAR (tail))))
+	{
+	  if (wanted)
+	    list = Fcons (file, list);
+	}
+      else
+	{
+	  if (wanted && include_directories)
+	    list = Fcons (file, list);
+	  if (NILP (prune) || fast_string_match (prune, name) < 0)
+	    list = directory_files_recursively (Ffile_name_as_directory (file),
+						match, prune,
+						include_directories,
+						list, 0);
+	}
+    }
+
+  return list;
+}
+
+DEFUN ("directory-files-recursively", Fdirectory_files_recursively,
+       Sdirectory_files_recursively, 1, 4, 0,
+       doc: /* Return a list of the files in DIRECTORY and all its subdirectories.
+The files are given by absolute file names.  The files of each
+directory come in the order of `string-lessp', each subdirectory
+followed by the files below it.  Symbolic links to directories are not
+followed, and subdirectories that cannot be read are skipped.
+There are three optional arguments:
+If MATCH is non-nil, mention only files whose names (without directory)
+ match the regexp MATCH.
+If INCLUDE-DIRECTORIES is non-nil, mention the subdirectories that match
+ MATCH too.  Otherwise mention only files that are not directories.
+If PRUNE is non-nil, do not look into the subdirectories whose names
+ (without directory) match the regexp PRUNE.
+This is much faster than walking the tree with `directory-files'.  */)
+  (Lisp_Object directory, Lisp_Object match, Lisp_Object include_directories,
+   Lisp_Object prune)
+{
+  Lisp_Object handler;
+  directory = Fexpand_file_name (directory, Qnil);
+
+  /* If the file name has special constructs in it,
+     call the corresponding file handler.  */
+  handler = Ffind_file_name_handler (directory, Qdirectory_files_recursively);
+  if (!NILP (handler))
+    return call5 (handler, Qdirectory_files_recursively, directory,
+		  match, include_directories, prune);
+
+  if (!NILP (match))
+    CHECK_STRING (match);
+  if (!NILP (prune))
+    CHECK_STRING (prune);
+
+  return Fnreverse (directory_files_recursively
+		    (Ffile_name_as_directory (directory), match, prune,
+		     !NILP (include_directories), Qnil, 1));
+}
+
+
 
 static Lisp_Object file_name_completion (Lisp_Object, Lisp_Object, bool,
 					 Lisp_Object);
@@ -429,9 +595,89 @@ These are all file names in directory DIRECTORY which begin with FILE.  */)
   return file_name_completion (file, directory, 1, Qnil);
 }
 
-static int file_name_completion_stat (int, struct dirent *, struct stat *);
+static int file_name_completion_stat (int, char const *, struct stat *);
 static Lisp_Object Qdefault_directory;
 
+/* The names in the directory that file_name_completion read last,
+   sorted bytewise, and the kind of file each is, as far as it found
+   out: 0 not known, 1 not a directory, 2 a directory, 3 cannot be
+   statted.  They are reused while the directory's modification time
+   stays the same, so that completing again in a large directory, as
+   repeated TABs do, does not read it all again.  COMPLETION_DIR is the
+   encoded name of the directory, or nil if the names are not to be
+   reused; only then are they not sorted either.  */
+static Lisp_Object completion_dir;
+static Lisp_Object completion_names;
+static Lisp_Object completion_kinds;
+static struct timespec completion_dir_mtime;
+static dev_t completion_dir_dev;
+static ino_t completion_dir_ino;
+
+/* Make completion_names and completion_kinds those of the directory
+   D, open on FD, whose encoded name is ENCODED_DIR, unless they are
+   its already and it has not changed since.  */
+
+static void
+read_completion_names (DIR *d, int fd, Lisp_Object encoded_dir)
+{
+  Lisp_Object names = Qnil;
+  bool reusable = 0;
+#ifndef DOS_NT
+  struct stat st;
+
+  if (fstat (fd, &st) == 0)
+    {
+      struct timespec mtime = get_stat_mtime (&st);
+
+      if (!NILP (completion_dir)
+	  && st.st_dev == completion_dir_dev
+	  && st.st_ino == completion_dir_ino
+	  && timespec_cmp (mtime, completion_dir_mtime) == 0
+	  && !NILP (Fstring_equal (encoded_dir, completion_dir)))
+	return;
+
+      /* A directory changed twice within the resolution of its time
+	 stamp can keep the same time stamp, so trust only one that is
+	 safely in the past.  */
+      reusable = (timespec_cmp (mtime,
+				timespec_sub (current_timespec (),
+					      make_timespec (2, 0)))
+		  < 0);
+      completion_dir_mtime = mtime;
+      completion_dir_dev = st.st_dev;
+      completion_dir_ino = st.st_ino;
+    }
+#endif
+
+  completion_dir = Qnil;
+  for (;;)
+    {
+      struct dirent *dp;
+
+      errno = 0;
+      dp = readdir (d);
+      if (!dp)
+	{
+	  if (errno == EAGAIN || errno == EINTR)
+	    {
+	      QUIT;
+	      continue;
+	    }
+	  break;
+	}
+      names = Fcons (make_unibyte_string (dp->d_name, dirent_namelen (dp)),
+		     names);
+    }
+
+  if (reusable)
+    names = Fsort (names, Qstring_lessp);
+  completion_names = Fvconcat (1, &names);
+  completion_kinds = Fmake_vector (make_number (ASIZE (completion_names)),
+				   make_number (0));
+  if (reusable)
+    completion_dir = encoded_dir;
+}
+
 static Lisp_Object
 file_name_completion (Lisp_Object file, Lisp_Object dirname, bool all_flag,
 		      Lisp_Object predicate)
@@ -446,6 +692,9 @@ file_name_completion (Lisp_Object file, Lisp_Object dirname, bool all_flag,
   Lisp_Object bestmatch, tem, elt, name;
   Lisp_Object encoded_file;
   Lisp_Object encoded_dir;
+  Lisp_Object names, kinds;
+  ptrdiff_t i, file_nbytes;
+  bool sorted;
   struct stat st;
   bool directoryp;
   /* If not INCLUDEALL, exclude files in completion-ignored-extensions as
@@ -480,39 +729,62 @@ file_name_completion (Lisp_Object file, Lisp_Object dirname, bool all_flag,
 
   record_unwind_protect_ptr (directory_files_internal_unwind, d);
 
-  /* Loop reading blocks */
-  /* (att3b compiler bug requires do a null comparison this way) */
-  while (1)
+  /* PREDICATE may complete in another directory, so hold on to the
+     names of this one.  */
+  read_completion_names (d, fd, encoded_dir);
+  names = completion_names;
+  kinds = completion_kinds;
+  sorted = !NILP (completion_dir) && !completion_ignore_case;
+  file_nbytes = SBYTES (encoded_file);
+
+  /* In sorted names, unless case is ignored, the names that start with
+     FILE follow one another; find the first.  */
+  i = 0;
+  if (sorted)
     {
-      struct dirent *dp;
-      ptrdiff_t len;
-      bool canexclude = 0;
+      ptrdiff_t hi = ASIZE (names);
 
-      errno = 0;
-      dp = readdir (d);
-      if (!dp)
+      while (i < hi)
 	{
-	  if (errno == EAGAIN || errno == EINTR)
-	    {
-	      QUIT;
-	      continue;
-	    }
-	  break;
+	  ptrdiff_t mid = i + (hi - i) / 2;
+	  Lisp_Object n = AREF (names, mid);
+	  int cmp = memcmp (SDATA (n), SDATA (encoded_file),
+			    min (SBYTES (n), file_nbytes));
+
+	  if (cmp < 0 || (cmp == 0 && SBYTES (n) < file_nbytes))
+	    i = mid + 1;
+	  else
+	    hi = mid;
 	}
+    }
 
-      len = dirent_namelen (dp);
+  for (; i < ASIZE (names); i++)
+    {
+      char const *d_name = SSDATA (AREF (names, i));
+      ptrdiff_t len = SBYTES (AREF (names, i));
+      bool canexclude = 0;
+      int kind;
 
       QUIT;
-      if (len < SCHARS (encoded_file)
-	  || (scmp (dp->d_name, SSDATA (encoded_file),
-		    SCHARS (encoded_file))
-	      >= 0))
-	continue;
+      if (len < file_nbytes
+	  || scmp (d_name, SSDATA (encoded_file), file_nbytes) >= 0)
+	{
+	  if (sorted)
+	    break;
+	  continue;
+	}
 
-      if (file_name_completion_stat (fd, dp, &st) < 0)
+      kind = XINT (AREF (kinds, i));
+      if (kind == 0)
+	{
+	  kind = (file_name_completion_stat (fd, d_name, &st) < 0 ? 3
+		  : S_ISDIR (st.st_mode) ? 2 : 1);
+	  ASET (kinds, i, make_number (kind));
+	}
+      if (kind == 3)
 	continue;
 
-      directoryp = S_ISDIR (st.st_mode) != 0;
+      directoryp = kind == 2;
       tem = Qnil;
       /* If all_flag is set, always include all.
 	 It would not actually be helpful to the user to ignore any possible
@@ -530,7 +802,7 @@ file_name_completion (Lisp_Object file, Lisp_Object dirname, bool all_flag,
 	      && matchcount > 1
 	      && !includeall /* This match may allow includeall to 0.  */
 	      && len >= bestmatchsize
-	      && 0 > scmp (dp->d_name, SSDATA (bestmatch), bestmatchsize))
+	      && 0 > scmp (d_name, SSDATA (bestmatch), bestmatchsize))
 	    continue;
 #endif
 
@@ -541,7 +813,7 @@ file_name_completion (Lisp_Object file, Lisp_Object dirname, bool all_flag,
 #endif
 	      /* "." and ".." are never interesting as completions, and are
 		 actually in the way in a directory with only one file.  */
-	      if (TRIVIAL_DIRECTORY_ENTRY (dp->d_name))
+	      if (TRIVIAL_DIRECTORY_ENTRY (d_name))
 		canexclude = 1;
 	      else if (len > SCHARS (encoded_file))
 		/* Ignore directories if they match an element of
@@ -568,7 +840,7 @@ file_name_completion (Lisp_Object file, Lisp_Object dirname, bool all_flag,
 		    if (skip < 0)
 		      continue;
 
-		    if (scmp (dp->d_name + skip, p1, elt_len) >= 0)
+		    if (scmp (d_name + skip, p1, elt_len) >= 0)
 		      continue;
 		    break;
 		  }
@@ -590,7 +862,7 @@ file_name_completion (Lisp_Object file, Lisp_Object dirname, bool all_flag,
 		    skip = len - SCHARS (elt);
 		    if (skip < 0) continue;
 
-		    if (scmp (dp->d_name + skip, SSDATA (elt), SCHARS (elt))
+		    if (scmp (d_name + skip, SSDATA (elt), SCHARS (elt))
 			>= 0)
 		      continue;
 		    break;
@@ -618,7 +890,7 @@ file_name_completion (Lisp_Object file, Lisp_Object dirname, bool all_flag,
 	}
       /* FIXME: If we move this `decode' earlier we can eliminate
 	 the repeated ENCODE_FILE on Vcompletion_ignored_extensions.  */
-      name = make_unibyte_string (dp->d_name, len);
+      name = make_unibyte_string (d_name, len);
       name = DECODE_FILE (name);
 
       {
@@ -785,7 +1057,7 @@ scmp (const char *s1, const char *s2, ptrdiff_t len)
 }
 
 static int
-file_name_completion_stat (int fd, struct dirent *dp, struct stat *st_addr)
+file_name_completion_stat (int fd, char const *name, struct stat *st_addr)
 {
   int value;
 
@@ -803,9 +1075,9 @@ file_name_completion_stat (int fd, struct dirent *dp, struct stat *st_addr)
   /* We want to return success if a link points to a nonexistent file,
      but we want to return the status for what the link points to,
      in case it is a directory.  */
-  value = fstatat (fd, dp->d_name, st_addr, AT_SYMLINK_NOFOLLOW);
+  value = fstatat (fd, name, st_addr, AT_SYMLINK_NOFOLLOW);
   if (value == 0 && S_ISLNK (st_addr->st_mode))
-    fstatat (fd, dp->d_name, st_addr, 0);
+    fstatat (fd, name, st_addr, 0);
 #ifdef MSDOS
   _djstat_flags = save_djstat_flags;
 #endif /* MSDOS */
@@ -842,6 +1114,40 @@ stat_gname (struct stat *st)
 #endif
 }
 
+/* Return the name of the owner ID of the file whose status is ST, as
+   looked up by LOOKUP, or nil if it has none.  Look in CACHE first,
+   and remember the name there.  */
+
+static Lisp_Object
+cached_id_name (struct id_name_cache *cache, uintmax_t id,
+		char *(*lookup) (struct stat *), struct stat *st)
+{
+  Lisp_Object name = Qnil;
+  char *str;
+  int i;
+
+#ifndef WINDOWSNT
+  /* On MS-Windows the name comes with the file, not from the ID.  */
+  for (i = 0; i < min (cache->n, ID_NAME_CACHE_SIZE); i++)
+    if (cache->id[i] == id)
+      return (STRINGP (cache->name[i]) ? Fcopy_sequence (cache->name[i])
+	      : cache->name[i]);
+#endif
+
+  block_input ();
+  str = lookup (st);
+  if (str)
+    name = build_unibyte_string (str);
+  unblock_input ();
+  if (STRINGP (name))
+    name = DECODE_SYSTEM (name);
+
+  i = cache->n++ % ID_NAME_CACHE_SIZE;
+  cache->id[i] = id;
+  cache->name[i] = name;
+  return name;
+}
+
 DEFUN ("file-attributes", Ffile_attributes, Sfile_attributes, 1, 2, 0,
        doc: /* Return a list of attributes of file FILENAME.
 Value is nil if specified file cannot be opened.
@@ -904,21 +1210,27 @@ so last access time will always be midnight of that day.  */)
     }
 
   encoded = ENCODE_FILE (filename);
-  return file_attributes (AT_FDCWD, SSDATA (encoded), id_format);
+  return file_attributes (AT_FDCWD, SSDATA (encoded), id_format, NULL);
 }
 
+/* Return the attributes of the file NAME relative to the directory
+   FD, as `file-attributes' does.  If OWNERS is not null, look up the
+   names of the file's owners in it first.  */
+
 static Lisp_Object
-file_attributes (int fd, char const *name, Lisp_Object id_format)
+file_attributes (int fd, char const *name, Lisp_Object id_format,
+		 struct owner_names *owners)
 {
   Lisp_Object values[12];
   struct stat s;
   int lstat_result;
+  struct owner_names owners_here;
 
   /* An array to hold the mode string generated by filemodestring,
      including its terminating space and null byte.  */
   char modes[sizeof "-rwxr-xr-x "];
 
-  char *uname = NULL, *gname = NULL;
+  Lisp_Object uname = Qnil, gname = Qnil;
 
 #ifdef WINDOWSNT
   /* We usually don't request accurate owner and group info, because
@@ -928,7 +1240,14 @@ file_attributes (int fd, char const *name, Lisp_Object id_format)
   w32_stat_get_owner_group = 1;
 #endif
 
+  /* Like lstat, do not mount a file system on an automount point just
+     to report on it.  */
+#ifdef AT_NO_AUTOMOUNT
+  lstat_result = fstatat (fd, name, &s,
+			  AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT);
+#else
   lstat_result = fstatat (fd, name, &s, AT_SYMLINK_NOFOLLOW);
+#endif
 
 #ifdef WINDOWSNT
   w32_stat_get_owner_group = 0;
@@ -943,17 +1262,20 @@ file_attributes (int fd, char const *name, Lisp_Object id_format)
 
   if (!(NILP (id_format) || EQ (id_format, Qinteger)))
     {
-      block_input ();
-      uname = stat_uname (&s);
-      gname = stat_gname (&s);
-      unblock_input ();
+      if (! owners)
+	{
+	  owners = &owners_here;
+	  owners->users.n = owners->groups.n = 0;
+	}
+      uname = cached_id_name (&owners->users, s.st_uid, stat_uname, &s);
+      gname = cached_id_name (&owners->groups, s.st_gid, stat_gname, &s);
     }
-  if (uname)
-    values[2] = DECODE_SYSTEM (build_unibyte_string (uname));
+  if (STRINGP (uname))
+    values[2] = uname;
   else
     values[2] = make_fixnum_or_float (s.st_uid);
-  if (gname)
-    values[3] = DECODE_SYSTEM (build_unibyte_string (gname));
+  if (STRINGP (gname))
+    values[3] = gname;
   else
     values[3] = make_fixnum_or_float (s.st_gid);
 
@@ -986,7 +1308,451 @@ Comparison is in lexicographic order and case is significant.  */)
   return Fstring_lessp (Fcar (f1), Fcar (f2));
 }
 
+
+/* The switches of `ls' that insert-directory-native understands.  */
+
+struct listing_switches
+{
+  bool all, almost_all, no_backups, classify, human, numeric, dired;
+  bool long_format, show_owner, show_group, reverse;
+
+  /* How to sort: 'n' by name, 'S' by size, 't' by time, 'U' not.  */
+  int sort;
 
+  /* Which time to show and sort by: 'm' modification, 'c' status
+     change, 'u' access.  */
+  int time;
+};
+
+/* Add the switches in the LEN bytes of WORD, a command line argument
+   of `ls', to SW.  Return false if they include one that
+   insert-directory-native does not support.  */
+
+static bool
+parse_listing_word (char const *word, ptrdiff_t len,
+		    struct listing_switches *sw)
+{
+  ptrdiff_t i;
+
+  if (len == 0)
+    return 1;
+  if (word[0] != '-')
+    return 0;
+  if (len > 1 && word[1] == '-')
+    {
+      if (len == sizeof "--dired" - 1 && !memcmp (word, "--dired", len))
+	return sw->dired = 1;
+      return 0;
+    }
+
+  for (i = 1; i < len; i++)
+    switch (word[i])
+      {
+      case 'a': sw->all = 1; break;
+      case 'A': sw->almost_all = 1; break;
+      case 'B': sw->no_backups = 1; break;
+      case 'c': case 'u': sw->time = word[i]; break;
+      case 'F': sw->classify = 1; break;
+      case 'g': sw->show_owner = 0; sw->long_format = 1; break;
+      case 'G': sw->show_group = 0; break;
+      case 'h': sw->human = 1; break;
+      case 'l': sw->long_format = 1; break;
+      case 'n': sw->numeric = 1; sw->long_format = 1; break;
+      case 'o': sw->show_group = 0; sw->long_format = 1; break;
+      case 'r': sw->reverse = 1; break;
+      case 'S': case 't': case 'U': sw->sort = word[i]; break;
+      default: return 0;
+      }
+  return 1;
+}
+
+/* Parse SWITCHES, a string of `ls' switches or a list of them, into
+   SW.  Return false if insert-directory-native cannot list with
+   them.  */
+
+static bool
+parse_listing_switches (Lisp_Object switches, struct listing_switches *sw)
+{
+  memset (sw, 0, sizeof *sw);
+  sw->show_owner = sw->show_group = 1;
+  sw->sort = 'n';
+  sw->time = 'm';
+
+  if (STRINGP (switches))
+    {
+      char const *p = SSDATA (switches), *end = p + SBYTES (switches);
+
+      while (p < end)
+	{
+	  char const *word = p;
+
+	  while (p < end && *p != ' ')
+	    p++;
+	  if (!parse_listing_word (word, p - word, sw))
+	    return 0;
+	  while (p < end && *p == ' ')
+	    p++;
+	}
+    }
+  else
+    {
+      Lisp_Object tail;
+
+      for (tail = switches; CONSP (tail); tail = XCDR (tail))
+	{
+	  CHECK_STRING (XCAR (tail));
+	  if (!parse_listing_word (SSDATA (XCAR (tail)),
+				   SBYTES (XCAR (tail)), sw))
+	    return 0;
+	}
+    }
+
+  return sw->long_format;
+}
+
+/* A file listed by insert-directory-native.  */
+
+struct listing_entry
+{
+  /* The name, as in the directory and decoded.  */
+  Lisp_Object encoded, name;
+
+  /* The target of a symbolic link, or nil.  */
+  Lisp_Object link;
+
+  /* The names of the owners, or nil to show their numbers.  */
+  Lisp_Object uname, gname;
+
+  struct stat st;
+};
+
+/* How qsort is to order the entries.  */
+static int listing_sort, listing_time;
+static bool listing_reverse;
+
+static struct timespec
+listing_entry_time (struct stat const *st, int which)
+{
+  return (which == 'c' ? get_stat_ctime (st)
+	  : which == 'u' ? get_stat_atime (st)
+	  : get_stat_mtime (st));
+}
+
+static int
+listing_entry_cmp (void const *a, void const *b)
+{
+  struct listing_entry const *x = a, *y = b;
+  int cmp = 0;
+
+  /* Sizes and times sort the largest and newest first, and fall back
+     on the names.  */
+  if (listing_sort == 'S')
+    cmp = (x->st.st_size < y->st.st_size) - (x->st.st_size > y->st.st_size);
+  else if (listing_sort == 't')
+    cmp = timespec_cmp (listing_entry_time (&y->st, listing_time),
+			listing_entry_time (&x->st, listing_time));
+  if (cmp == 0)
+    {
+      ptrdiff_t xlen = SBYTES (x->encoded), ylen = SBYTES (y->encoded);
+
+      cmp = memcmp (SDATA (x->encoded), SDATA (y->encoded), min (xlen, ylen));
+      if (cmp == 0)
+	cmp = (xlen > ylen) - (xlen < ylen);
+    }
+  return listing_reverse ? -cmp : cmp;
+}
+
+/* Store in BUF the SIZE in bytes as `ls -h' shows it: rounded up to
+   at most three digits and followed by a unit.  */
+
+static void
+human_readable_size (char *buf, double size)
+{
+  static char const units[] = "KMGTPEZY";
+  int unit = -1;
+
+  if (size < 1024)
+    {
+      sprintf (buf, "%.0f", size);
+      return;
+    }
+  while (size >= 1024 && unit < (int) sizeof units - 2)
+    {
+      size /= 1024;
+      unit++;
+    }
+  if (size < 10 && ceil (size * 10) < 100)
+    {
+      sprintf (buf, "%.1f%c", ceil (size * 10) / 10, units[unit]);
+      return;
+    }
+  size = ceil (size);
+  if (size >= 1024 && unit < (int) sizeof units - 2)
+    sprintf (buf, "1.0%c", units[unit + 1]);
+  else
+    sprintf (buf, "%.0f%c", size, units[unit]);
+}
+
+/* Insert the owner NAME, or the number ID if NAME is nil, padded with
+   spaces to WIDTH columns.  */
+
+static void
+insert_listing_owner (Lisp_Object name, uprintmax_t id, int width)
+{
+  static char const spaces[] = "                ";
+  ptrdiff_t len;
+
+  if (STRINGP (name))
+    {
+      insert_from_string (name, 0, 0, SCHARS (name), SBYTES (name), 0);
+      len = SCHARS (name);
+    }
+  else
+    {
+      char buf[INT_STRLEN_BOUND (uprintmax_t) + 1];
+
+      len = sprintf (buf, "%"pMu, id);
+      insert (buf, len);
+    }
+  for (; len < width; len += sizeof spaces - 1)
+    insert (spaces, min (width - len, sizeof spaces - 1));
+}
+
+/* The number of lines insert-directory-native inserts before it first
+   calls its PROGRESS function, about a screenful, and then between
+   calls.  */
+#define LISTING_FIRST_CHUNK 100
+#define LISTING_CHUNK 2000
+
+DEFUN ("insert-directory-native", Finsert_directory_native,
+       Sinsert_directory_native, 2, 3, 0,
+       doc: /* Insert a long listing of DIRECTORY at point, like `ls -l'.
+SWITCHES are switches of `ls', as a string or a list of strings.
+Return t, leaving point after the listing, or nil without inserting
+anything if SWITCHES ask for something that this function does not
+support, or if DIRECTORY has a file name handler.
+
+This supports the long formats of the switches -l, -g, -o and -n, as
+well as the switches -a, -A, -B, -c, -u, -F, -G, -h, -r, -S, -t and
+-U, and `--dired', which indents the lines by two spaces.  The files
+are stated in one pass, and each file name gets the text property
+`dired-filename'.  Names sort in the byte order of the file names,
+as with `ls' in the C locale.
+
+If PROGRESS is non-nil, it is a function to call with no arguments
+after the first screenful of lines, and then every few thousand lines,
+so that it can show the part of the listing inserted so far.  */)
+  (Lisp_Object directory, Lisp_Object switches, Lisp_Object progress)
+{
+  struct listing_switches sw;
+  struct listing_entry *entries = NULL;
+  ptrdiff_t nentries = 0, nalloc = 0, i;
+  struct owner_names owners;
+  Lisp_Object dirfilename, recent_format, old_format;
+  struct timespec now, half_year_ago;
+  uintmax_t blocks = 0;
+  int link_width = 0, uid_width = 0, gid_width = 0, size_width = 0;
+  char buf[sizeof "-rwxrwxrwx " + 2 * INT_STRLEN_BOUND (uprintmax_t) + 64];
+  struct dirent *dp;
+  DIR *d;
+  int fd;
+
+  CHECK_STRING (directory);
+  directory = Fexpand_file_name (directory, Qnil);
+  if (!NILP (Ffind_file_name_handler (directory, Qinsert_directory))
+      || !parse_listing_switches (switches, &sw))
+    return Qnil;
+
+  dynwind_begin ();
+  owners.users.n = owners.groups.n = 0;
+  dirfilename = ENCODE_FILE (Fdirectory_file_name (directory));
+  d = open_directory (SSDATA (dirfilename), &fd);
+  if (d == NULL)
+    report_file_error ("Opening directory", directory);
+  record_unwind_protect_ptr (directory_files_internal_unwind, d);
+
+  /* Stat all the files first, as the columns must be wide enough for
+     all of them, and the files must be sorted.  */
+  for (;;)
+    {
+      struct listing_entry *e;
+      ptrdiff_t len;
+
+      errno = 0;
+      dp = readdir (d);
+      if (!dp)
+	{
+	  if (errno == EAGAIN || errno == EINTR)
+	    {
+	      QUIT;
+	      continue;
+	    }
+	  break;
+	}
+
+      len = dirent_namelen (dp);
+      if (dp->d_name[0] == '.' && !sw.all
+	  && (!sw.almost_all || len == 1 || (len == 2 && dp->d_name[1] == '.')))
+	continue;
+      if (sw.no_backups && dp->d_name[len - 1] == '~')
+	continue;
+      QUIT;
+
+      if (nentries == nalloc)
+	entries = xpalloc (entries, &nalloc, 1, -1, sizeof *entries);
+      e = &entries[nentries];
+      /* Skip a file removed since it was read.  */
+      if (fstatat (fd, dp->d_name, &e->st, AT_SYMLINK_NOFOLLOW) != 0)
+	continue;
+      e->encoded = make_unibyte_string (dp->d_name, len);
+      e->name = DECODE_FILE (e->encoded);
+      e->link = (S_ISLNK (e->st.st_mode)
+		 ? emacs_readlinkat (fd, dp->d_name) : Qnil);
+      e->uname = e->gname = Qnil;
+      if (!sw.numeric)
+	{
+	  e->uname = cached_id_name (&owners.users, e->st.st_uid,
+				     stat_uname, &e->st);
+	  e->gname = cached_id_name (&owners.groups, e->st.st_gid,
+				     stat_gname, &e->st);
+	}
+      nentries++;
+    }
+
+  if (sw.sort != 'U' && nentries > 1)
+    {
+      listing_sort = sw.sort;
+      listing_time = sw.time;
+      listing_reverse = sw.reverse;
+      qsort (entries, nentries, sizeof *entries, listing_entry_cmp);
+    }
+
+  for (i = 0; i < nentries; i++)
+    {
+      struct stat *st = &entries[i].st;
+
+#if defined WINDOWSNT || defined MSDOS
+      blocks += (st->st_size + 1023) / 1024 * 2;
+#else
+      blocks += st->st_blocks;
+#endif
+      link_width = max (link_width, sprintf (buf, "%"pMu,
+					     (uprintmax_t) st->st_nlink));
+      uid_width = max (uid_width,
+		       (STRINGP (entries[i].uname)
+			? SCHARS (entries[i].uname)
+			: sprintf (buf, "%"pMu, (uprintmax_t) st->st_uid)));
+      gid_width = max (gid_width,
+		       (STRINGP (entries[i].gname)
+			? SCHARS (entries[i].gname)
+			: sprintf (buf, "%"pMu, (uprintmax_t) st->st_gid)));
+      if (sw.human)
+	human_readable_size (buf, st->st_size);
+      else
+	sprintf (buf, "%"pMd, (printmax_t) st->st_size);
+      size_width = max (size_width, (int) strlen (buf));
+    }
+
+  /* The "total" line counts blocks of 1024 bytes, rounded up.  */
+  if (sw.human)
+    human_readable_size (buf, (blocks + 1) / 2 * 1024.0);
+  else
+    sprintf (buf, "%"pMu, (uprintmax_t) ((blocks + 1) / 2));
+  if (sw.dired)
+    insert ("  ", 2);
+  insert ("total ", 6);
+  insert (buf, strlen (buf));
+  insert ("\n", 1);
+
+  /* Like `ls', show the time of day for files changed in the past half
+     year, and the year for others.  */
+  recent_format = build_string ("%b %e %H:%M");
+  old_format = build_string ("%b %e  %Y");
+  now = current_timespec ();
+  half_year_ago = timespec_sub (now, make_timespec (15778476, 0));
+
+  for (i = 0; i < nentries; i++)
+    {
+      struct listing_entry *e = &entries[i];
+      struct timespec t = listing_entry_time (&e->st, sw.time);
+      Lisp_Object time_string;
+      char modes[sizeof "-rwxrwxrwx "];
+      ptrdiff_t start;
+
+      QUIT;
+      if (sw.dired)
+	insert ("  ", 2);
+      filemodestring (&e->st, modes);
+      insert (buf, sprintf (buf, "%.10s %*"pMu" ", modes, link_width,
+			    (uprintmax_t) e->st.st_nlink));
+      if (sw.show_owner)
+	{
+	  insert_listing_owner (e->uname, e->st.st_uid, uid_width);
+	  insert (" ", 1);
+	}
+      if (sw.show_group)
+	{
+	  insert_listing_owner (e->gname, e->st.st_gid, gid_width);
+	  insert (" ", 1);
+	}
+      if (sw.human)
+	{
+	  char size[32];
+
+	  human_readable_size (size, e->st.st_size);
+	  insert (buf, sprintf (buf, "%*s ", size_width, size));
+	}
+      else
+	insert (buf, sprintf (buf, "%*"pMd" ", size_width,
+			      (printmax_t) e->st.st_size));
+
+      time_string = Fformat_time_string ((timespec_cmp (half_year_ago, t) < 0
+					  && timespec_cmp (t, now) <= 0)
+					 ? recent_format : old_format,
+					 make_lisp_time (t), Qnil);
+      insert_from_string (time_string, 0, 0, SCHARS (time_string),
+			  SBYTES (time_string), 0);
+      insert (" ", 1);
+
+      start = PT;
+      insert_from_string (e->name, 0, 0, SCHARS (e->name),
+			  SBYTES (e->name), 0);
+      Fput_text_property (make_number (start), make_number (PT),
+			  Qdired_filename, Qt, Qnil);
+
+      if (STRINGP (e->link))
+	{
+	  insert (" -> ", 4);
+	  insert_from_string (e->link, 0, 0, SCHARS (e->link),
+			      SBYTES (e->link), 0);
+	}
+      else if (sw.classify)
+	{
+	  mode_t mode = e->st.st_mode;
+
+	  if (S_ISDIR (mode))
+	    insert ("/", 1);
+	  else if (S_ISFIFO (mode))
+	    insert ("|", 1);
+	  else if (S_ISSOCK (mode))
+	    insert ("=", 1);
+	  else if (S_ISREG (mode) && (mode & (S_IXUSR | S_IXGRP | S_IXOTH)))
+	    insert ("*", 1);
+	}
+      insert ("\n", 1);
+
+      if (!NILP (progress) && i + 1 < nentries
+	  && (i + 1 == LISTING_FIRST_CHUNK
+	      || (i + 1) % LISTING_CHUNK == 0))
+	call0 (progress);
+    }
+
+  dynwind_end ();
+  xfree (entries);
+  return Qt;
+}
+
+
 DEFUN ("system-users", Fsystem_users, Ssystem_users, 0, 0, 0,
        doc: /* Return a list of user names currently registered in the system.
 If we don't know how to determine that on this platform, just
@@ -1032,12 +1798,20 @@ syms_of_dired (void)
 
   DEFSYM (Qdirectory_files, "directory-files");
   DEFSYM (Qdirectory_files_and_attributes, "directory-files-and-attributes");
+  DEFSYM (Qdirectory_files_recursively, "directory-files-recursively");
   DEFSYM (Qfile_name_completion, "file-name-completion");
   DEFSYM (Qfile_name_all_completions, "file-name-all-completions");
   DEFSYM (Qfile_attributes, "file-attributes");
   DEFSYM (Qfile_attributes_lessp, "file-attributes-lessp");
+  DEFSYM (Qinsert_directory, "insert-directory");
+  DEFSYM (Qdired_filename, "dired-filename");
   DEFSYM (Qdefault_directory, "default-directory");
 
+  completion_dir = completion_names = completion_kinds = Qnil;
+  staticpro (&completion_dir);
+  staticpro (&completion_names);
+  staticpro (&completion_kinds);
+
   DEFVAR_LISP ("completion-ignored-extensions", Vcompletion_ignored_extensions,
 	       doc: /* Completion ignores file names ending in any string in this list.
 It does not ignore them if all possible completions end in one of
@@ -705,6 +705,12 @@ struct glyph_matrix
   /* Width and height of the matrix in columns and rows.  */
   int matrix_w, matrix_h;
 
+  /* Number of glyphs allocated for each row of a window matrix
+     managing its own storage.  This can exceed matrix_w, so that a
+     window growing in small steps does not reallocate every row each
+     time.  */
+  ptrdiff_t row_glyphs_allocated;
+
   /* If this structure describes a window matrix of window W,
      window_pixel_left is the value of W->pixel_left, window_pixel_top
      the value of W->pixel_top, window_height and window_width are width
@@ -1773,6 +1779,17 @@ enum face_id
 
 #define MAX_FACE_ID  ((1 << FACE_ID_BITS) - 1)
 
+/* An entry of the memo of a face cache: the id FACE_ID of the face
+   realized by merging the text property value PROP into the face
+   BASE_FACE_ID.  FACE_ID is negative if the entry is unused.  */
+
+struct face_memo
+{
+  Lisp_Object prop;
+  int base_face_id;
+  int face_id;
+};
+
 /* A cache of realized faces.  Each frame has its own cache because
    Emacs allows different frame-local face definitions.  */
 
@@ -1791,6 +1808,11 @@ struct face_cache
   ptrdiff_t size;
   int used;
 
+  /* Faces found for `face' properties by face_at_buffer_position,
+     hashed by property value and base face.  Cleared whenever faces
+     are freed.  */
+  struct face_memo *memo;
+
   /* Flag indicating that attributes of the `menu' face have been
      changed.  */
   bool_bf menu_face_changed_p : 1;
@@ -1854,6 +1876,14 @@ GLYPH_CODE_P (Lisp_Object gc)
 
 extern int face_change_count;
 
+/* Number of faces realized so far.  */
+
+extern EMACS_INT faces_realized;
+
+/* Incremented whenever a realized face is freed.  */
+
+extern EMACS_INT face_cache_generation;
+
 /* For reordering of bidirectional text.  */
 #define BIDI_MAXLEVEL 64
 
@@ -2229,6 +2259,13 @@ struct it
   /* Position at which redisplay end trigger functions should be run.  */
   ptrdiff_t redisplay_end_trigger_charpos;
 
+  /* If positive, the start of the buffer line from which the iterator
+     is moving and saving checkpoints, see start_it_checkpoints.  */
+  ptrdiff_t checkpoint_line_start;
+
+  /* Position of the last checkpoint saved.  */
+  ptrdiff_t last_checkpoint;
+
   /* True means multibyte characters are enabled.  */
   bool_bf multibyte_p : 1;
 
@@ -2945,6 +2982,10 @@ struct image
   /* Width and height of the image.  */
   int width, height;
 
+  /* Approximate number of bytes the image takes on the display, as
+     counted in the `bytes' of its cache.  */
+  ptrdiff_t bytes;
+
   /* These values are used for the rectangles displayed for images
      that can't be loaded.  */
 #define DEFAULT_IMAGE_WIDTH 30
@@ -3018,6 +3059,9 @@ struct image_cache
   /* Number of images in the cache.  */
   ptrdiff_t used;
 
+  /* Sum of the `bytes' of the images in the cache.  */
+  ptrdiff_t bytes;
+
   /* Reference count (number of frames sharing this cache).  */
   ptrdiff_t refcount;
 };
@@ -3174,6 +3218,8 @@ void remember_mouse_glyph (struct frame *, int, int, NativeRectangle *);
 
 void mark_window_display_accurate (Lisp_Object, int);
 void redisplay_preserve_echo_area (int);
+void clear_glyph_row_caches (void);
+bool start_it_checkpoints (struct it *, ptrdiff_t);
 void init_iterator (struct it *, struct window *, ptrdiff_t,
                     ptrdiff_t, struct glyph_row *, enum face_id);
 void init_iterator_to_row_start (struct it *, struct window *,
@@ -3298,6 +3344,7 @@ void x_kill_gs_process (Pixmap, struct frame *);
 struct image_cache *make_image_cache (void);
 void free_image_cache (struct frame *);
 void clear_image_caches (Lisp_Object);
+extern bool image_cache_full;
 void mark_image_cache (struct image_cache *);
 bool valid_image_p (Lisp_Object);
 void prepare_image_for_display (struct frame *, struct image *);
@@ -3510,6 +3557,7 @@ extern void do_line_insertion_deletion_costs (struct frame *, const char *,
 					      const char *, int);
 void scrolling_1 (struct frame *, int, int, int, int *, int *, int *,
                   int *, int);
+extern bool scrolling_by_hash (struct frame *, int, int, int *, int *, int *);
 
 /* Defined in frame.c */
 
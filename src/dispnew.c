@@ -485,12 +485,23 @@ adjust_glyph_matrix (struct window *w, struct glyph_matrix *matrix, int x, int y
 	{
 	  struct glyph_row *row = matrix->rows;
 	  struct glyph_row *end = row + matrix->rows_allocated;
+	  bool grow_p = dim.width > matrix->row_glyphs_allocated;
+
+	  /* Leave room for the window to grow by half before the rows
+	     need reallocating again.  */
+	  if (grow_p)
+	    matrix->row_glyphs_allocated
+	      = max (dim.width, (matrix->row_glyphs_allocated
+				 + matrix->row_glyphs_allocated / 2));
 
 	  while (row < end)
 	    {
-	      row->glyphs[LEFT_MARGIN_AREA]
-		= xnrealloc (row->glyphs[LEFT_MARGIN_AREA],
-			     dim.width, sizeof (struct glyph));
+	      /* Rows added above have no glyphs yet.  */
+	      if (grow_p || !row->glyphs[LEFT_MARGIN_AREA])
+		row->glyphs[LEFT_MARGIN_AREA]
+		  = xnrealloc (row->glyphs[LEFT_MARGIN_AREA],
+			       matrix->row_glyphs_allocated,
+			       sizeof (struct glyph));
 
 	      /* The mode line never has marginal areas.  */
 	      if (row == matrix->rows + dim.height - 1
@@ -1080,13 +1091,12 @@ line_hash_code (struct frame *f, struct glyph_row *row)
     {
       struct glyph *glyph = row->glyphs[TEXT_AREA];
       struct glyph *end = glyph + row->used[TEXT_AREA];
+      int space = FRAME_MUST_WRITE_SPACES (f) ? SPACEGLYPH : 0;
 
       while (glyph < end)
 	{
-	  int c = glyph->u.ch;
+	  int c = glyph->u.ch - space;
 	  int face_id = glyph->face_id;
-	  if (FRAME_MUST_WRITE_SPACES (f))
-	    c -= SPACEGLYPH;
 	  hash = (((hash << 4) + (hash >> 24)) & 0x0fffffff) + c;
 	  hash = (((hash << 4) + (hash >> 24)) & 0x0fffffff) + face_id;
 	  ++glyph;
@@ -1191,6 +1201,13 @@ row_equal_p (struct glyph_row *a, struct glyph_row *b, bool mouse_face_p)
 	  a_end = a_glyph + a->used[area];
 	  b_glyph = b->glyphs[area];
 
+	  /* Identical bytes mean identical glyphs.  Unchanged rows
+	     usually are identical, so this saves comparing them field
+	     by field; other rows typically differ in their first
+	     glyph's position and fail this test at once.  */
+	  if (memcmp (a_glyph, b_glyph, a->used[area] * sizeof *a_glyph) == 0)
+	    continue;
+
 	  while (a_glyph < a_end
 		 && GLYPH_EQUAL_P (a_glyph, b_glyph))
 	    ++a_glyph, ++b_glyph;
@@ -2954,6 +2971,7 @@ redraw_frame (struct frame *f)
     FRAME_TERMINAL (f)->set_terminal_modes_hook (FRAME_TERMINAL (f));
   clear_frame (f);
   clear_current_matrices (f);
+  clear_glyph_row_caches ();
   update_end (f);
   windows_or_buffers_changed = 13;
   /* Mark all windows as inaccurate, so that every window will have
@@ -3093,6 +3111,8 @@ update_frame (struct frame *f, bool force_p, bool inhibit_hairy_id_p)
   set_window_update_flags (root_window, false);
 
   display_completed = !paused_p;
+  if (!paused_p)
+    note_input_latency (INPUT_LATENCY_UPDATE);
   return paused_p;
 }
 
@@ -4486,8 +4506,11 @@ update_frame_1 (struct frame *f, bool force_p, bool inhibit_id_p,
 	      if (display_output)
 		{
 		  ptrdiff_t outq = __fpending (display_output);
-		  if (outq > 900
-		      || (outq > 20 && ((i - 1) % preempt_count == 0)))
+		  /* With a large output buffer, the whole update is
+		     written at once by the final flush.  */
+		  if (FRAME_TTY (f)->output_buffer_size == 0
+		      && (outq > 900
+			  || (outq > 20 && ((i - 1) % preempt_count == 0))))
 		    fflush (display_output);
 		}
 	    }
@@ -4683,6 +4706,21 @@ scrolling (struct frame *frame)
   if (window_size < 2)
     return 0;
 
+  {
+    Lisp_Object terminal, method;
+
+    XSETTERMINAL (terminal, FRAME_TERMINAL (frame));
+    method = Fterminal_parameter (terminal, Qscroll_line_matching);
+    if (NILP (method))
+      method = Vscroll_line_matching;
+    if (EQ (method, Qhash)
+	&& scrolling_by_hash (frame, window_size, unchanged_at_top,
+			      draw_cost + unchanged_at_top - 1,
+			      old_hash + unchanged_at_top - 1,
+			      new_hash + unchanged_at_top - 1))
+      return 0;
+  }
+
   scrolling_1 (frame, window_size, unchanged_at_top, unchanged_at_bottom,
 	       draw_cost + unchanged_at_top - 1,
 	       old_draw_cost + unchanged_at_top - 1,
@@ -6234,6 +6272,8 @@ syms_of_display (void)
 
   DEFSYM (Qdisplay_table, "display-table");
   DEFSYM (Qredisplay_dont_pause, "redisplay-dont-pause");
+  DEFSYM (Qscroll_line_matching, "scroll-line-matching");
+  DEFSYM (Qhash, "hash");
 
   DEFVAR_INT ("baud-rate", baud_rate,
 	      doc: /* The output baud rate of the terminal.
@@ -6304,6 +6344,16 @@ Each element can be:
 See `buffer-display-table' for more information.  */);
   Vstandard_display_table = Qnil;
 
+  DEFVAR_LISP ("scroll-line-matching", Vscroll_line_matching,
+	       doc: /* How text terminals find lines to reuse when the display scrolls.
+The value `hash' means to match old and new lines by their hash codes,
+which takes time about linear in the number of lines.  Any other value
+means to compute the cheapest sequence of line insertions and
+deletions, which takes time quadratic in the number of lines.
+A terminal parameter `scroll-line-matching' overrides this value for
+that terminal.  */);
+  Vscroll_line_matching = Qnil;
+
   DEFVAR_BOOL ("redisplay-dont-pause", redisplay_dont_pause,
 	       doc: /* Non-nil means display update isn't paused when input is detected.  */);
   redisplay_dont_pause = 1;
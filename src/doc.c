@@ -27,6 +27,12 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <unistd.h>
 
 #include <c-ctype.h>
+#include <stat-time.h>
+#include <timespec.h>
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include "lisp.h"
 #include "character.h"
@@ -42,6 +48,94 @@ static ptrdiff_t get_doc_string_buffer_size;
 
 static unsigned char *read_bytecode_pointer;
 
+#ifdef HAVE_MMAP
+
+/* Doc string files mapped into memory, most recently used first.
+   Looking up a doc string in one of them costs a `stat' to check that
+   the file has not changed, rather than an open, a seek and reads.
+   The DOC file is used all the time, and a few .elc files with
+   dynamic doc strings may be in use at once.  */
+
+struct doc_file_map
+{
+  char *name;
+  char const *data;
+  ptrdiff_t size;
+  dev_t dev;
+  ino_t ino;
+  struct timespec mtime;
+};
+
+enum { DOC_FILE_MAPS = 8 };
+static struct doc_file_map doc_file_maps[DOC_FILE_MAPS];
+
+static void
+unmap_doc_file (struct doc_file_map *map)
+{
+  munmap ((void *) map->data, map->size);
+  xfree (map->name);
+  map->name = NULL;
+}
+
+/* Return the mapping of the file NAME, mapping it if necessary, or
+   NULL if it cannot be mapped.  */
+
+static struct doc_file_map *
+map_doc_file (char const *name)
+{
+  struct doc_file_map map;
+  struct stat st;
+  void *data;
+  int i, fd;
+
+  if (stat (name, &st) != 0)
+    return NULL;
+
+  for (i = 0; i < DOC_FILE_MAPS - 1 && doc_file_maps[i].name; i++)
+    if (!strcmp (doc_file_maps[i].name, name))
+      break;
+  map = doc_file_maps[i];
+
+  if (map.name && !strcmp (map.name, name)
+      && map.dev == st.st_dev && map.ino == st.st_ino
+      && map.size == st.st_size
+      && timespec_cmp (map.mtime, get_stat_mtime (&st)) == 0)
+    ;
+  else
+    {
+      fd = emacs_open (name, O_RDONLY, 0);
+      if (fd < 0)
+	return NULL;
+      if (fstat (fd, &st) != 0
+	  || ! (0 < st.st_size && st.st_size <= min (PTRDIFF_MAX, SIZE_MAX)))
+	{
+	  emacs_close (fd);
+	  return NULL;
+	}
+      data = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      emacs_close (fd);
+      if (data == MAP_FAILED)
+	return NULL;
+
+      /* Replace the entry for NAME if the file changed, or else the
+	 least recently used entry.  */
+      if (map.name)
+	unmap_doc_file (&doc_file_maps[i]);
+      map.name = xstrdup (name);
+      map.data = data;
+      map.size = st.st_size;
+      map.dev = st.st_dev;
+      map.ino = st.st_ino;
+      map.mtime = get_stat_mtime (&st);
+    }
+
+  memmove (&doc_file_maps[1], &doc_file_maps[0], i * sizeof map);
+  doc_file_maps[0] = map;
+  return &doc_file_maps[0];
+}
+
+#endif /* HAVE_MMAP */
+
 /* `readchar' in lread.c calls back here to fetch the next byte.
    If UNREADFLAG is 1, we unread a byte.  */
 
@@ -84,6 +178,9 @@ get_doc_string (Lisp_Object filepos, bool unibyte, bool definition)
   int offset;
   EMACS_INT position;
   Lisp_Object file, tem, pos;
+#ifdef HAVE_MMAP
+  struct doc_file_map *map;
+#endif
   USE_SAFE_ALLOCA;
 
   if (INTEGERP (filepos))
@@ -128,6 +225,33 @@ get_doc_string (Lisp_Object filepos, bool unibyte, bool definition)
       name = SSDATA (file);
     }
 
+#ifdef HAVE_MMAP
+  map = map_doc_file (name);
+  if (map && position < map->size)
+    {
+      /* Copy the doc string, with at least 1024 bytes before it for
+	 the consistency checks below, out of the mapped file.  */
+      char const *start, *end;
+      ptrdiff_t len;
+
+      offset = min (position, 1024);
+      start = map->data + position - offset;
+      end = memchr (map->data + position, '\037', map->size - position);
+      if (!end)
+	end = map->data + map->size;
+      len = end - start;
+      if (get_doc_string_buffer_size <= len)
+	get_doc_string_buffer
+	  = xpalloc (get_doc_string_buffer, &get_doc_string_buffer_size,
+		     len + 1 - get_doc_string_buffer_size, -1, 1);
+      memcpy (get_doc_string_buffer, start, len);
+      get_doc_string_buffer[len] = 0;
+      p = get_doc_string_buffer + len;
+      SAFE_FREE ();
+      goto check;
+    }
+#endif
+
   fd = emacs_open (name, O_RDONLY, 0);
   if (fd < 0)
     {
@@ -208,6 +332,9 @@ get_doc_string (Lisp_Object filepos, bool unibyte, bool definition)
   dynwind_end ();
   SAFE_FREE ();
 
+#ifdef HAVE_MMAP
+ check:
+#endif
   /* Sanity checking.  */
   if (CONSP (filepos))
     {
@@ -1030,6 +1030,27 @@ See also `gap-position'.  */)
   return temp;
 }
 
+DEFUN ("gap-statistics", Fgap_statistics, Sgap_statistics, 0, 1, 0,
+       doc: /* Return a list (MOVES BYTES) describing motion of BUFFER's gap.
+MOVES is how many times the gap was moved, and BYTES how many bytes
+of text were copied to move it, since the buffer was made.
+BUFFER defaults to the current buffer.
+See also `gap-position'.  */)
+  (Lisp_Object buffer)
+{
+  struct buffer *b;
+
+  if (NILP (buffer))
+    b = current_buffer;
+  else
+    {
+      CHECK_BUFFER (buffer);
+      b = XBUFFER (buffer);
+    }
+  return list2 (make_number (b->text->gap_moves),
+		make_number (b->text->gap_moved_bytes));
+}
+
 DEFUN ("position-bytes", Fposition_bytes, Sposition_bytes, 1, 1, 0,
        doc: /* Return the byte position for character position POSITION.
 If POSITION is out of range, the value is nil.  */)
@@ -2493,14 +2514,24 @@ make_buffer_string_both (ptrdiff_t start, ptrdiff_t start_byte,
 {
   Lisp_Object result, tem, tem1;
 
-  if (start < GPT && GPT < end)
-    move_gap_both (start, start_byte);
-
   if (! NILP (BVAR (current_buffer, enable_multibyte_characters)))
     result = make_uninit_multibyte_string (end - start, end_byte - start_byte);
   else
     result = make_uninit_string (end - start);
-  memcpy (SDATA (result), BYTE_POS_ADDR (start_byte), end_byte - start_byte);
+
+  /* Copy the text on each side of the gap, rather than moving the gap
+     out of the way: that would move as much text again, and the next
+     insertion would likely move it back.  */
+  if (start_byte < GPT_BYTE && GPT_BYTE < end_byte)
+    {
+      ptrdiff_t before = GPT_BYTE - start_byte;
+
+      memcpy (SDATA (result), BYTE_POS_ADDR (start_byte), before);
+      memcpy (SDATA (result) + before, GAP_END_ADDR,
+	      end_byte - start_byte - before);
+    }
+  else
+    memcpy (SDATA (result), BYTE_POS_ADDR (start_byte), end_byte - start_byte);
 
   /* If desired, update and copy the text properties.  */
   if (props)
@@ -2586,6 +2617,49 @@ they can be in either order.  */)
   return make_buffer_string (b, e, 0);
 }
 
+DEFUN ("buffer-line-fields", Fbuffer_line_fields, Sbuffer_line_fields,
+       1, 1, 0,
+       doc: /* Return the fields of the text from point to the end of the line.
+The value is a list of the strings between occurrences of SEPARATOR,
+an ASCII character other than newline, without text properties.
+Point is left at the end of the line, before the newline.
+
+This is faster than splitting the line with `search-forward' and
+`buffer-substring', when parsing tables such as news overview data.  */)
+  (Lisp_Object separator)
+{
+  ptrdiff_t pos = PT, pos_byte = PT_BYTE;
+  ptrdiff_t start = pos, start_byte = pos_byte;
+  Lisp_Object fields = Qnil;
+  int sep;
+
+  CHECK_CHARACTER (separator);
+  sep = XFASTINT (separator);
+  if (! ASCII_CHAR_P (sep) || sep == '\n')
+    error ("Invalid field separator");
+
+  while (true)
+    {
+      /* An ASCII byte is never part of a multibyte character.  */
+      int c = pos_byte < ZV_BYTE ? FETCH_BYTE (pos_byte) : '\n';
+
+      if (c == sep || c == '\n')
+	{
+	  fields = Fcons (make_buffer_string_both (start, start_byte,
+						   pos, pos_byte, 0),
+			  fields);
+	  if (c == '\n')
+	    break;
+	  start = pos + 1;
+	  start_byte = pos_byte + 1;
+	}
+      INC_BOTH (pos, pos_byte);
+    }
+
+  SET_PT_BOTH (pos, pos_byte);
+  return Fnreverse (fields);
+}
+
 DEFUN ("buffer-string", Fbuffer_string, Sbuffer_string, 0, 0, 0,
        doc: /* Return the contents of the current buffer as a string.
 If narrowing is in effect, this function returns only the visible part
@@ -2644,107 +2718,138 @@ They default to the values of (point-min) and (point-max) in BUFFER.  */)
   return Qnil;
 }
 
-DEFUN ("compare-buffer-substrings", Fcompare_buffer_substrings, Scompare_buffer_substrings,
-       6, 6, 0,
-       doc: /* Compare two substrings of two buffers; return result as number.
-Return -N if first string is less after N-1 chars, +N if first string is
-greater after N-1 chars, or 0 if strings match.  Each substring is
-represented as three arguments: BUFFER, START and END.  That makes six
-args in all, three for each substring.
+/* Decode BUFFER, START and END as a substring of a buffer for
+   `compare-buffer-substrings' and friends: store the buffer in *BP and
+   the ordered positions in *BEG and *END.  */
 
-The value of `case-fold-search' in the current buffer
-determines whether case is significant or ignored.  */)
-  (Lisp_Object buffer1, Lisp_Object start1, Lisp_Object end1, Lisp_Object buffer2, Lisp_Object start2, Lisp_Object end2)
+static void
+decode_buffer_substring (Lisp_Object buffer, Lisp_Object start,
+			 Lisp_Object end, struct buffer **bp,
+			 ptrdiff_t *beg, ptrdiff_t *endp)
 {
-  register EMACS_INT begp1, endp1, begp2, endp2, temp;
-  register struct buffer *bp1, *bp2;
-  register Lisp_Object trt
-    = (!NILP (BVAR (current_buffer, case_fold_search))
-       ? BVAR (current_buffer, case_canon_table) : Qnil);
-  ptrdiff_t chars = 0;
-  ptrdiff_t i1, i2, i1_byte, i2_byte;
+  struct buffer *b;
+  EMACS_INT begpos, endpos, temp;
 
-  /* Find the first buffer and its substring.  */
-
-  if (NILP (buffer1))
-    bp1 = current_buffer;
+  if (NILP (buffer))
+    b = current_buffer;
   else
     {
-      Lisp_Object buf1;
-      buf1 = Fget_buffer (buffer1);
-      if (NILP (buf1))
-	nsberror (buffer1);
-      bp1 = XBUFFER (buf1);
-      if (!BUFFER_LIVE_P (bp1))
+      Lisp_Object buf;
+      buf = Fget_buffer (buffer);
+      if (NILP (buf))
+	nsberror (buffer);
+      b = XBUFFER (buf);
+      if (!BUFFER_LIVE_P (b))
 	error ("Selecting deleted buffer");
     }
 
-  if (NILP (start1))
-    begp1 = BUF_BEGV (bp1);
+  if (NILP (start))
+    begpos = BUF_BEGV (b);
   else
     {
-      CHECK_NUMBER_COERCE_MARKER (start1);
-      begp1 = XINT (start1);
+      CHECK_NUMBER_COERCE_MARKER (start);
+      begpos = XINT (start);
     }
-  if (NILP (end1))
-    endp1 = BUF_ZV (bp1);
+  if (NILP (end))
+    endpos = BUF_ZV (b);
   else
     {
-      CHECK_NUMBER_COERCE_MARKER (end1);
-      endp1 = XINT (end1);
+      CHECK_NUMBER_COERCE_MARKER (end);
+      endpos = XINT (end);
     }
 
-  if (begp1 > endp1)
-    temp = begp1, begp1 = endp1, endp1 = temp;
+  if (begpos > endpos)
+    temp = begpos, begpos = endpos, endpos = temp;
 
-  if (!(BUF_BEGV (bp1) <= begp1
-	&& begp1 <= endp1
-        && endp1 <= BUF_ZV (bp1)))
-    args_out_of_range (start1, end1);
+  if (!(BUF_BEGV (b) <= begpos
+	&& begpos <= endpos
+        && endpos <= BUF_ZV (b)))
+    args_out_of_range (start, end);
 
-  /* Likewise for second substring.  */
+  *bp = b;
+  *beg = begpos;
+  *endp = endpos;
+}
 
-  if (NILP (buffer2))
-    bp2 = current_buffer;
-  else
-    {
-      Lisp_Object buf2;
-      buf2 = Fget_buffer (buffer2);
-      if (NILP (buf2))
-	nsberror (buffer2);
-      bp2 = XBUFFER (buf2);
-      if (!BUFFER_LIVE_P (bp2))
-	error ("Selecting deleted buffer");
-    }
+/* Return the length in bytes of the common prefix of the text of
+   buffers B1 and B2 from byte positions FROM1 and FROM2, not going past
+   TO1 and TO2, cut back to a character boundary.  The buffers must
+   both be unibyte or both multibyte.  */
 
-  if (NILP (start2))
-    begp2 = BUF_BEGV (bp2);
-  else
-    {
-      CHECK_NUMBER_COERCE_MARKER (start2);
-      begp2 = XINT (start2);
-    }
-  if (NILP (end2))
-    endp2 = BUF_ZV (bp2);
-  else
-    {
-      CHECK_NUMBER_COERCE_MARKER (end2);
-      endp2 = XINT (end2);
-    }
+static ptrdiff_t
+buffer_substrings_prefix (struct buffer *b1, ptrdiff_t from1, ptrdiff_t to1,
+			  struct buffer *b2, ptrdiff_t from2, ptrdiff_t to2)
+{
+  ptrdiff_t n = buffers_prefix_match (b1, from1, to1, b2, from2, to2);
+
+  if (! NILP (BVAR (b1, enable_multibyte_characters)))
+    while (from1 + n < to1 && ! CHAR_HEAD_P (BUF_FETCH_BYTE (b1, from1 + n)))
+      n--;
+  return n;
+}
+
+/* Likewise for the common suffix before TO1 and TO2.  */
+
+static ptrdiff_t
+buffer_substrings_suffix (struct buffer *b1, ptrdiff_t from1, ptrdiff_t to1,
+			  struct buffer *b2, ptrdiff_t from2, ptrdiff_t to2)
+{
+  ptrdiff_t n = buffers_suffix_match (b1, from1, to1, b2, from2, to2);
+
+  if (! NILP (BVAR (b1, enable_multibyte_characters)))
+    while (n > 0 && ! CHAR_HEAD_P (BUF_FETCH_BYTE (b1, to1 - n)))
+      n--;
+  return n;
+}
+
+DEFUN ("compare-buffer-substrings", Fcompare_buffer_substrings, Scompare_buffer_substrings,
+       6, 6, 0,
+       doc: /* Compare two substrings of two buffers; return result as number.
+Return -N if first string is less after N-1 chars, +N if first string is
+greater after N-1 chars, or 0 if strings match.  Each substring is
+represented as three arguments: BUFFER, START and END.  That makes six
+args in all, three for each substring.
 
-  if (begp2 > endp2)
-    temp = begp2, begp2 = endp2, endp2 = temp;
+The value of `case-fold-search' in the current buffer
+determines whether case is significant or ignored.  */)
+  (Lisp_Object buffer1, Lisp_Object start1, Lisp_Object end1, Lisp_Object buffer2, Lisp_Object start2, Lisp_Object end2)
+{
+  ptrdiff_t begp1, endp1, begp2, endp2;
+  struct buffer *bp1, *bp2;
+  register Lisp_Object trt
+    = (!NILP (BVAR (current_buffer, case_fold_search))
+       ? BVAR (current_buffer, case_canon_table) : Qnil);
+  ptrdiff_t chars = 0;
+  ptrdiff_t i1, i2, i1_byte, i2_byte;
 
-  if (!(BUF_BEGV (bp2) <= begp2
-	&& begp2 <= endp2
-        && endp2 <= BUF_ZV (bp2)))
-    args_out_of_range (start2, end2);
+  decode_buffer_substring (buffer1, start1, end1, &bp1, &begp1, &endp1);
+  decode_buffer_substring (buffer2, start2, end2, &bp2, &begp2, &endp2);
 
   i1 = begp1;
   i2 = begp2;
   i1_byte = buf_charpos_to_bytepos (bp1, i1);
   i2_byte = buf_charpos_to_bytepos (bp2, i2);
 
+  /* Without case folding, and if both buffers represent text the same
+     way, equal bytes are equal characters; skip the common prefix
+     without decoding it.  */
+  if (NILP (trt)
+      && (NILP (BVAR (bp1, enable_multibyte_characters))
+	  == NILP (BVAR (bp2, enable_multibyte_characters))))
+    {
+      ptrdiff_t n
+	= buffer_substrings_prefix (bp1, i1_byte,
+				    buf_charpos_to_bytepos (bp1, endp1),
+				    bp2, i2_byte,
+				    buf_charpos_to_bytepos (bp2, endp2));
+
+      chars = buf_bytepos_to_charpos (bp1, i1_byte + n) - i1;
+      i1 += chars;
+      i1_byte += n;
+      i2 += chars;
+      i2_byte += n;
+    }
+
   while (i1 < endp1 && i2 < endp2)
     {
       /* When we find a mismatch, we must compare the
@@ -2802,7 +2907,417 @@ determines whether case is significant or ignored.  */)
   /* Same length too => they are equal.  */
   return make_number (0);
 }
-
+
+DEFUN ("compare-buffer-substrings-affixes", Fcompare_buffer_substrings_affixes,
+       Scompare_buffer_substrings_affixes, 6, 6, 0,
+       doc: /* Return how much two substrings of two buffers agree at each end.
+The value is (PREFIX . SUFFIX), where PREFIX is the number of characters
+at the start of the first substring that equal those at the start of
+the second, and SUFFIX is the number of characters that agree at the
+end of both, not counting any that are part of the prefix.  Each
+substring is represented as three arguments: BUFFER, START and END,
+like in `compare-buffer-substrings'.
+
+Case is always significant, and text properties are ignored.  This is
+useful for finding the part of a buffer that must change to make it
+look like another, as when reverting a buffer.  */)
+  (Lisp_Object buffer1, Lisp_Object start1, Lisp_Object end1, Lisp_Object buffer2, Lisp_Object start2, Lisp_Object end2)
+{
+  ptrdiff_t begp1, endp1, begp2, endp2;
+  ptrdiff_t beg1_byte, end1_byte, beg2_byte, end2_byte;
+  ptrdiff_t prefix, suffix;
+  struct buffer *bp1, *bp2;
+
+  decode_buffer_substring (buffer1, start1, end1, &bp1, &begp1, &endp1);
+  decode_buffer_substring (buffer2, start2, end2, &bp2, &begp2, &endp2);
+  beg1_byte = buf_charpos_to_bytepos (bp1, begp1);
+  end1_byte = buf_charpos_to_bytepos (bp1, endp1);
+  beg2_byte = buf_charpos_to_bytepos (bp2, begp2);
+  end2_byte = buf_charpos_to_bytepos (bp2, endp2);
+
+  if (NILP (BVAR (bp1, enable_multibyte_characters))
+      == NILP (BVAR (bp2, enable_multibyte_characters)))
+    {
+      ptrdiff_t n = buffer_substrings_prefix (bp1, beg1_byte, end1_byte,
+					      bp2, beg2_byte, end2_byte);
+      prefix = buf_bytepos_to_charpos (bp1, beg1_byte + n) - begp1;
+      beg1_byte += n;
+      beg2_byte += n;
+      n = buffer_substrings_suffix (bp1, beg1_byte, end1_byte,
+				    bp2, beg2_byte, end2_byte);
+      suffix = endp1 - buf_bytepos_to_charpos (bp1, end1_byte - n);
+    }
+  else
+    {
+      /* One buffer is unibyte and the other multibyte.  Compare
+	 characters one at a time, with raw bytes of the unibyte
+	 buffer as eight-bit characters.  */
+      struct buffer *mb = bp1, *ub = bp2;
+      ptrdiff_t mpos = beg1_byte, upos = begp2, mend = end1_byte, uend = endp2;
+      ptrdiff_t n = 0;
+      int c;
+
+      if (NILP (BVAR (bp1, enable_multibyte_characters)))
+	{
+	  mb = bp2, ub = bp1;
+	  mpos = beg2_byte, upos = begp1, mend = end2_byte, uend = endp1;
+	}
+
+      while (mpos < mend && upos < uend)
+	{
+	  QUIT;
+	  c = BUF_FETCH_BYTE (ub, upos);
+	  MAKE_CHAR_MULTIBYTE (c);
+	  if (BUF_FETCH_MULTIBYTE_CHAR (mb, mpos) != c)
+	    break;
+	  BUF_INC_POS (mb, mpos);
+	  upos++, n++;
+	}
+      prefix = n;
+
+      n = 0;
+      while (mend > mpos && uend > upos)
+	{
+	  ptrdiff_t p = mend;
+
+	  QUIT;
+	  BUF_DEC_POS (mb, p);
+	  c = BUF_FETCH_BYTE (ub, uend - 1);
+	  MAKE_CHAR_MULTIBYTE (c);
+	  if (BUF_FETCH_MULTIBYTE_CHAR (mb, p) != c)
+	    break;
+	  mend = p, uend--, n++;
+	}
+      suffix = n;
+    }
+
+  return Fcons (make_number (prefix), make_number (suffix));
+}
+
+/* Replacing the text of a buffer by that of another, touching only
+   the lines that differ.  The lines of the two texts are compared with
+   the O(ND) difference algorithm of Eugene W. Myers, "An O(ND)
+   Difference Algorithm and Its Variations", Algorithmica 1 (1986),
+   which takes time proportional to the number of differences D.  */
+
+/* The largest number of differing lines to look for, since the search
+   needs D * D words of memory.  */
+enum { DIFF_MAX_COST = 1000 };
+
+struct diff_line
+{
+  ptrdiff_t charpos, bytepos, nbytes;
+  EMACS_UINT hash;
+};
+
+/* Split the text of buffer B from CHARPOS and BYTEPOS to END_BYTE into
+   lines and store them into a new array in *PLINES, followed by an
+   entry for the end of the text.  Return the number of lines.  */
+
+static ptrdiff_t
+diff_split_lines (struct buffer *b, ptrdiff_t charpos, ptrdiff_t bytepos,
+		  ptrdiff_t end_byte, struct diff_line **plines)
+{
+  struct diff_line *lines = NULL;
+  ptrdiff_t n = 0, size = 0;
+  bool multibyte = ! NILP (BVAR (b, enable_multibyte_characters));
+
+  while (true)
+    {
+      struct diff_line *line;
+      EMACS_UINT hash = 0;
+      unsigned char c;
+
+      if (n == size)
+	lines = xpalloc (lines, &size, 1, -1, sizeof *lines);
+      line = &lines[n];
+      line->charpos = charpos;
+      line->bytepos = bytepos;
+      line->nbytes = 0;
+      line->hash = 0;
+      if (bytepos == end_byte)
+	break;
+      do
+	{
+	  c = BUF_FETCH_BYTE (b, bytepos);
+	  bytepos++;
+	  hash = sxhash_combine (hash, c);
+	  if (! multibyte || CHAR_HEAD_P (c))
+	    charpos++;
+	}
+      while (c != '\n' && bytepos < end_byte);
+      line->nbytes = bytepos - line->bytepos;
+      line->hash = hash;
+      n++;
+    }
+
+  *plines = lines;
+  return n;
+}
+
+/* Number the NA lines LA of buffer A and the NB lines LB of buffer B
+   so that lines get the same number if and only if their text is the
+   same, storing the numbers into CA and CB.  */
+
+static void
+diff_number_lines (struct buffer *a, struct diff_line *la, ptrdiff_t na,
+		   struct buffer *b, struct diff_line *lb, ptrdiff_t nb,
+		   ptrdiff_t *ca, ptrdiff_t *cb)
+{
+  ptrdiff_t size = 1, i;
+  ptrdiff_t *table;
+
+  while (size < 2 * (na + nb))
+    size *= 2;
+  table = xmalloc_atomic (size * sizeof *table);
+  for (i = 0; i < size; i++)
+    table[i] = -1;
+
+  /* Line I is line I of A if I < NA, and line I - NA of B otherwise.
+     Its number is the index of the first line with the same text.  */
+  for (i = 0; i < na + nb; i++)
+    {
+      struct buffer *buf = i < na ? a : b;
+      struct diff_line *line = i < na ? &la[i] : &lb[i - na];
+      ptrdiff_t h;
+
+      for (h = line->hash & (size - 1); ; h = (h + 1) & (size - 1))
+	{
+	  ptrdiff_t j = table[h];
+	  struct buffer *jbuf;
+	  struct diff_line *jline;
+
+	  if (j < 0)
+	    {
+	      table[h] = i;
+	      break;
+	    }
+	  jbuf = j < na ? a : b;
+	  jline = j < na ? &la[j] : &lb[j - na];
+	  if (jline->hash == line->hash && jline->nbytes == line->nbytes
+	      && (buffers_prefix_match (jbuf, jline->bytepos,
+					jline->bytepos + jline->nbytes,
+					buf, line->bytepos,
+					line->bytepos + line->nbytes)
+		  == line->nbytes))
+	    break;
+	}
+      if (i < na)
+	ca[i] = table[h];
+      else
+	cb[i - na] = table[h];
+    }
+
+  xfree (table);
+}
+
+/* The furthest X reached on diagonal K after D differences, stored in
+   TRACE for every D so that the path can be retraced.  */
+#define DIFF_V(trace, d, k) ((trace)[(d) * (d) + (k) + (d)])
+
+/* Return the X at which the furthest reaching path with D differences
+   on diagonal K starts its final run of equal lines, and store the
+   diagonal it came from into *PREV_K.  Return -1 if no path with D
+   differences reaches diagonal K within the NA by NB grid.  */
+
+static ptrdiff_t
+diff_step (ptrdiff_t *trace, ptrdiff_t d, ptrdiff_t k,
+	   ptrdiff_t na, ptrdiff_t nb, ptrdiff_t *prev_k)
+{
+  ptrdiff_t down = -1, right = -1;
+
+  *prev_k = k;
+  if (d == 0)
+    return 0;
+
+  /* Insert a line of B, coming down from diagonal K + 1.  */
+  if (k + 1 <= d - 1)
+    {
+      ptrdiff_t x = DIFF_V (trace, d - 1, k + 1);
+      if (0 <= x && x - (k + 1) < nb)
+	down = x;
+    }
+  /* Delete a line of A, coming right from diagonal K - 1.  */
+  if (- (d - 1) <= k - 1)
+    {
+      ptrdiff_t x = DIFF_V (trace, d - 1, k - 1);
+      if (0 <= x && x < na)
+	right = x + 1;
+    }
+
+  if (down < 0 && right < 0)
+    return -1;
+  if (down >= right)
+    {
+      *prev_k = k + 1;
+      return down;
+    }
+  *prev_k = k - 1;
+  return right;
+}
+
+/* Replace the lines LA[ALO] to LA[AHI] of the current buffer with the
+   lines LB[BLO] to LB[BHI] of buffer B.  */
+
+static void
+diff_replace_lines (struct diff_line *la, ptrdiff_t alo, ptrdiff_t ahi,
+		    struct buffer *b, struct diff_line *lb,
+		    ptrdiff_t blo, ptrdiff_t bhi)
+{
+  TEMP_SET_PT_BOTH (la[alo].charpos, la[alo].bytepos);
+  if (blo < bhi)
+    insert_from_buffer (b, lb[blo].charpos,
+			lb[bhi].charpos - lb[blo].charpos, 0);
+  if (alo < ahi)
+    del_range_both (PT, PT_BYTE,
+		    PT + (la[ahi].charpos - la[alo].charpos),
+		    PT_BYTE + (la[ahi].bytepos - la[alo].bytepos), 1);
+}
+
+DEFUN ("replace-buffer-contents", Freplace_buffer_contents,
+       Sreplace_buffer_contents, 1, 1, "bSource buffer: ",
+       doc: /* Replace accessible portion of current buffer with that of SOURCE.
+SOURCE can be a buffer or a string that names a buffer.
+Interactively, prompt for SOURCE.
+
+As far as possible the replacement is non-destructive: only the lines
+that differ are replaced, so the text that stays the same keeps its
+markers, text properties and overlays, and the undo list records just
+the changes.  The work done is proportional to the number of changed
+lines.  If there are too many of them to compare cheaply, the whole
+changed region is replaced at once.
+
+Return t.  */)
+  (Lisp_Object source)
+{
+  struct buffer *a = current_buffer, *b;
+  struct diff_line *la, *lb;
+  ptrdiff_t prefix = 0, suffix = 0, na, nb, x, k, d, cost = -1;
+  ptrdiff_t *ca, *cb, *trace = NULL, trace_size = 0;
+  ptrdiff_t old_chars = ZV - BEGV;
+  bool same_representation;
+  Lisp_Object buf;
+
+  buf = Fget_buffer (source);
+  if (NILP (buf))
+    nsberror (source);
+  b = XBUFFER (buf);
+  if (!BUFFER_LIVE_P (b))
+    error ("Selecting deleted buffer");
+  if (a == b)
+    error ("Cannot replace a buffer with itself");
+
+  same_representation = (NILP (BVAR (a, enable_multibyte_characters))
+			 == NILP (BVAR (b, enable_multibyte_characters)));
+  if (same_representation
+      && ZV_BYTE - BEGV_BYTE == BUF_ZV_BYTE (b) - BUF_BEGV_BYTE (b)
+      && (buffers_prefix_match (a, BEGV_BYTE, ZV_BYTE,
+				b, BUF_BEGV_BYTE (b), BUF_ZV_BYTE (b))
+	  == ZV_BYTE - BEGV_BYTE))
+    return Qt;
+
+  dynwind_begin ();
+  record_unwind_protect (save_excursion_restore, save_excursion_save ());
+  prepare_to_modify_buffer (BEGV, ZV, NULL);
+  dynwind_begin ();
+  specbind (Qinhibit_modification_hooks, Qt);
+
+  /* Only the text between the common prefix and suffix can differ.
+     Leave the partial lines at their edges to the comparison.  */
+  if (same_representation)
+    {
+      prefix = buffer_substrings_prefix (a, BEGV_BYTE, ZV_BYTE,
+					 b, BUF_BEGV_BYTE (b),
+					 BUF_ZV_BYTE (b));
+      while (prefix > 0 && FETCH_BYTE (BEGV_BYTE + prefix - 1) != '\n')
+	prefix--;
+      suffix = buffer_substrings_suffix (a, BEGV_BYTE + prefix, ZV_BYTE,
+					 b, BUF_BEGV_BYTE (b) + prefix,
+					 BUF_ZV_BYTE (b));
+      while (suffix > 0 && FETCH_BYTE (ZV_BYTE - suffix--) != '\n')
+	continue;
+    }
+  na = diff_split_lines (a, BYTE_TO_CHAR (BEGV_BYTE + prefix),
+			 BEGV_BYTE + prefix, ZV_BYTE - suffix, &la);
+  nb = diff_split_lines (b, buf_bytepos_to_charpos (b, BUF_BEGV_BYTE (b)
+						    + prefix),
+			 BUF_BEGV_BYTE (b) + prefix, BUF_ZV_BYTE (b) - suffix,
+			 &lb);
+
+  if (same_representation)
+    {
+      ca = xmalloc_atomic ((na + nb) * sizeof *ca);
+      cb = ca + na;
+      diff_number_lines (a, la, na, b, lb, nb, ca, cb);
+
+      /* Find the furthest reaching path on each diagonal K for D
+	 differences, for increasing D, until one reaches the end.  */
+      for (d = 0; d <= DIFF_MAX_COST && cost < 0; d++)
+	{
+	  if (trace_size < (d + 1) * (d + 1))
+	    trace = xpalloc (trace, &trace_size,
+			     (d + 1) * (d + 1) - trace_size, -1,
+			     sizeof *trace);
+	  for (k = -d; k <= d; k += 2)
+	    {
+	      ptrdiff_t prev_k;
+
+	      x = diff_step (trace, d, k, na, nb, &prev_k);
+	      if (0 <= x)
+		while (x < na && x - k < nb && ca[x] == cb[x - k])
+		  x++;
+	      DIFF_V (trace, d, k) = x;
+	      if (x == na && x - k == nb)
+		{
+		  cost = d;
+		  break;
+		}
+	    }
+	}
+    }
+
+  if (cost < 0)
+    diff_replace_lines (la, 0, na, b, lb, 0, nb);
+  else
+    {
+      /* Retrace the path from the end, replacing each run of changed
+	 lines as it is found.  Working backwards keeps the positions of
+	 the lines before it valid.  */
+      ptrdiff_t alo = 0, ahi = -1, blo = 0, bhi = 0;
+
+      x = na;
+      k = na - nb;
+      for (d = cost; d > 0; d--)
+	{
+	  ptrdiff_t prev_k, prev_x;
+	  ptrdiff_t x0 = diff_step (trace, d, k, na, nb, &prev_k);
+
+	  if (x0 < x && 0 <= ahi)
+	    {
+	      diff_replace_lines (la, alo, ahi, b, lb, blo, bhi);
+	      ahi = -1;
+	    }
+	  if (ahi < 0)
+	    {
+	      ahi = x0;
+	      bhi = x0 - k;
+	    }
+	  prev_x = DIFF_V (trace, d - 1, prev_k);
+	  alo = prev_x;
+	  blo = prev_x - prev_k;
+	  x = prev_x;
+	  k = prev_k;
+	}
+      if (0 <= ahi)
+	diff_replace_lines (la, alo, ahi, b, lb, blo, bhi);
+    }
+
+  dynwind_end ();
+  signal_after_change (BEGV, old_chars, ZV - BEGV);
+  dynwind_end ();
+  return Qt;
+}
+
 static void
 subst_char_in_region_unwind (Lisp_Object arg)
 {
@@ -2925,6 +3440,8 @@ Both characters must have the same length of multi-byte form.  */)
 	    {
 	      changed = -1;
 	      modify_text (pos, XINT (end));
+	      if (multibyte_p && char_rtl_p (toc))
+		note_rtl_text ();
 
 	      if (! NILP (noundo))
 		{
@@ -3174,6 +3691,8 @@ It returns the number of characters changed.  */)
 		}
 	      else
 		{
+		  if (multibyte && char_rtl_p (nc))
+		    note_rtl_text ();
 		  record_change (pos, 1);
 		  while (str_len-- > 0)
 		    *p++ = *str++;
@@ -3225,6 +3744,309 @@ It returns the number of characters changed.  */)
   return make_number (cnt);
 }
 
+/* Return the length of the control sequence starting with the ESC at
+   byte position BYTE of the current buffer and ending before LIMIT,
+   or 0 if there is none.  Set *SGR to whether it is a Select Graphic
+   Rendition sequence.  The sequences are those that the regexps
+   `ansi-color-regexp' and `ansi-color-drop-regexp' match; they are
+   all ASCII, so their length in bytes is also their length in
+   characters.  */
+
+static ptrdiff_t
+ansi_sequence_length (ptrdiff_t byte, ptrdiff_t limit, bool *sgr)
+{
+  ptrdiff_t p = byte + 2, q;
+  int c;
+
+  *sgr = false;
+  if (limit <= p || FETCH_BYTE (byte + 1) != '[')
+    return 0;
+  for (q = p; q < limit; q++)
+    {
+      c = FETCH_BYTE (q);
+      if (! (('0' <= c && c <= '9') || c == ';'))
+	break;
+    }
+  if (q == limit)
+    return 0;
+  c = FETCH_BYTE (q);
+  if (c == 'm')
+    *sgr = true;
+  else if (c == 'H' || c == 'f')
+    ;
+  else if (q == p && c && strchr ("ABCDsuK", c))
+    ;
+  else if (q == p + 1 && (c == 'J' || c == 'K')
+	   && (FETCH_BYTE (p) == '1' || FETCH_BYTE (p) == '2'))
+    ;
+  else if (q == p && c == '=')
+    {
+      for (q = p + 1; q < limit; q++)
+	{
+	  c = FETCH_BYTE (q);
+	  if (! ('0' <= c && c <= '9'))
+	    break;
+	}
+      if (q == p + 1 || q == limit || ! (c == 'h' || c == 'I'))
+	return 0;
+    }
+  else
+    return 0;
+  return q + 1 - byte;
+}
+
+/* Change the N codes in CODES by the SGR parameter CODE, the way
+   `ansi-color-apply-sequence' does, and return their new number.  */
+
+static ptrdiff_t
+ansi_apply_code (EMACS_INT *codes, ptrdiff_t n, EMACS_INT code)
+{
+  ptrdiff_t i, j;
+  EMACS_INT remove[3];
+  int nremove = 0, k;
+
+  switch (code / 10)
+    {
+    case 0:
+      if (code == 0 || code == 8 || code == 9)
+	return 0;
+      remove[nremove++] = code;
+      break;
+
+    case 2:
+      if (code == 20 || code == 26 || code == 28 || code == 29)
+	return 0;
+      if (code == 22)
+	remove[nremove++] = 1;
+      if (code == 25)
+	remove[nremove++] = 6;
+      remove[nremove++] = code - 20;
+      break;
+
+    case 3:
+    case 4:
+      if (code % 10 == 8)
+	return 0;
+      /* Replace the first color of the same kind.  */
+      for (i = 0; i < n; i++)
+	if (codes[i] / 10 == code / 10)
+	  {
+	    memmove (codes + i, codes + i + 1, (n - i - 1) * sizeof *codes);
+	    n--;
+	    break;
+	  }
+      if (code % 10 == 9)
+	return n;
+      memmove (codes + 1, codes, n * sizeof *codes);
+      codes[0] = code;
+      return n + 1;
+
+    default:
+      return 0;
+    }
+
+  for (i = j = 0; i < n; i++)
+    {
+      for (k = 0; k < nremove; k++)
+	if (codes[i] == remove[k])
+	  break;
+      if (k == nremove)
+	codes[j++] = codes[i];
+    }
+  n = j;
+  if (code / 10 == 0)
+    {
+      memmove (codes + 1, codes, n * sizeof *codes);
+      codes[0] = code;
+      n++;
+    }
+  return n;
+}
+
+DEFUN ("ansi-color-scan-region", Fansi_color_scan_region,
+       Sansi_color_scan_region, 3, 3, 0,
+       doc: /* Delete the ANSI control sequences from START to END.
+Delete the SGR control sequences that `ansi-color-regexp' matches and
+the sequences that `ansi-color-drop-regexp' matches, in one pass over
+the text.
+
+CODES is the list of SGR codes in effect at START, in the format that
+`ansi-color-apply-sequence' takes and returns.  The SGR sequences
+change it as that function would.
+
+The value is a list (RUNS CODES FRAGMENT).  RUNS is a vector of lists
+(BEG END CODES), one for each nonempty stretch of text between the
+SGR sequences, giving the codes in effect there.  CODES is the list
+of codes in effect at the end, and FRAGMENT is the position of an
+escape character that follows the last SGR sequence without starting
+a complete control sequence, or nil.  The text from FRAGMENT on may be
+the start of a sequence that more text will complete; the last run
+ends there.  All positions are those after the deletions.  */)
+  (Lisp_Object start, Lisp_Object end, Lisp_Object codes)
+{
+  ptrdiff_t beg, stop, limit, pos, pos_byte, removed, fragment, run_start;
+  ptrdiff_t ncodes, maxcodes, ndeletions, deletions_size = 0, i;
+  ptrdiff_t *deletions = NULL;
+  EMACS_INT *code_array;
+  EMACS_INT chars_modiff;
+  Lisp_Object tail, runs, codes_list;
+  bool multibyte = !NILP (BVAR (current_buffer, enable_multibyte_characters));
+  bool prepared = false, codes_changed;
+  USE_SAFE_ALLOCA;
+
+  validate_region (&start, &end);
+
+  /* The codes can only grow by the codes 1-7 and 30-47, each at most
+     once.  */
+  maxcodes = 32;
+  for (tail = codes; CONSP (tail); tail = XCDR (tail))
+    {
+      CHECK_NUMBER (XCAR (tail));
+      maxcodes++;
+    }
+  SAFE_NALLOCA (code_array, 1, maxcodes);
+
+ scan:
+  beg = XINT (start);
+  stop = XINT (end);
+  chars_modiff = CHARS_MODIFF;
+  ncodes = 0;
+  for (tail = codes; CONSP (tail); tail = XCDR (tail))
+    code_array[ncodes++] = XINT (XCAR (tail));
+  codes_list = codes;
+  codes_changed = false;
+  runs = Qnil;
+  ndeletions = 0;
+  removed = 0;
+  fragment = -1;
+  run_start = beg;
+
+  pos = beg;
+  pos_byte = CHAR_TO_BYTE (beg);
+  limit = CHAR_TO_BYTE (stop);
+  while (pos_byte < limit)
+    {
+      int c = FETCH_BYTE (pos_byte);
+      bool sgr;
+      ptrdiff_t len;
+
+      if (c != 033)
+	{
+	  pos_byte += multibyte ? BYTES_BY_CHAR_HEAD (c) : 1;
+	  pos++;
+	  continue;
+	}
+
+      len = ansi_sequence_length (pos_byte, limit, &sgr);
+      if (len == 0)
+	{
+	  if (fragment < 0)
+	    fragment = pos - removed;
+	  pos_byte++;
+	  pos++;
+	  continue;
+	}
+
+      if (ndeletions == deletions_size)
+	deletions = xpalloc (deletions, &deletions_size, 1, -1,
+			     2 * sizeof *deletions);
+      deletions[2 * ndeletions] = pos;
+      deletions[2 * ndeletions + 1] = pos + len;
+      ndeletions++;
+
+      if (sgr)
+	{
+	  ptrdiff_t p = pos_byte + 2, q = pos_byte + len - 1;
+	  EMACS_INT code = 0;
+
+	  if (run_start < pos - removed)
+	    {
+	      if (codes_changed)
+		{
+		  codes_list = Qnil;
+		  for (i = ncodes; i > 0; i--)
+		    codes_list = Fcons (make_number (code_array[i - 1]),
+					codes_list);
+		  codes_changed = false;
+		}
+	      runs = Fcons (list3 (make_number (run_start),
+				   make_number (pos - removed), codes_list),
+			    runs);
+	    }
+
+	  /* Each parameter ends with ";" or the final "m"; an empty
+	     one is 0.  Parameters too big to be meaningful are
+	     clamped, to keep them out of the known ranges.  */
+	  for (; p <= q; p++)
+	    {
+	      c = FETCH_BYTE (p);
+	      if (c == ';' || p == q)
+		{
+		  ncodes = ansi_apply_code (code_array, ncodes, code);
+		  codes_changed = true;
+		  code = 0;
+		}
+	      else
+		code = min (code * 10 + c - '0', 1000);
+	    }
+	  fragment = -1;
+	  run_start = pos - removed;
+	}
+
+      removed += len;
+      pos_byte += len;
+      pos += len;
+    }
+
+  if (ndeletions > 0 && !prepared)
+    {
+      /* Run the hooks once for all the deletions.  If they change the
+	 text, look at it again.  */
+      prepare_to_modify_buffer (beg, stop, NULL);
+      prepared = true;
+      if (CHARS_MODIFF != chars_modiff)
+	{
+	  if (XINT (end) > ZV)
+	    XSETFASTINT (end, ZV);
+	  if (XINT (start) > XINT (end))
+	    start = end;
+	  goto scan;
+	}
+    }
+
+  /* Delete from the end, so that the positions of the deletions still
+     to be made do not change.  */
+  for (i = ndeletions; i > 0; i--)
+    {
+      ptrdiff_t from = deletions[2 * i - 2], to = deletions[2 * i - 1];
+      del_range_2 (from, CHAR_TO_BYTE (from), to, CHAR_TO_BYTE (to), 0);
+    }
+  xfree (deletions);
+  stop -= removed;
+  if (prepared)
+    {
+      signal_after_change (beg, stop + removed - beg, stop - beg);
+      update_compositions (beg, stop, CHECK_ALL);
+    }
+
+  if (codes_changed)
+    {
+      codes_list = Qnil;
+      for (i = ncodes; i > 0; i--)
+	codes_list = Fcons (make_number (code_array[i - 1]), codes_list);
+    }
+  if (run_start < (fragment < 0 ? stop : fragment))
+    runs = Fcons (list3 (make_number (run_start),
+			 make_number (fragment < 0 ? stop : fragment),
+			 codes_list),
+		  runs);
+
+  SAFE_FREE ();
+  runs = Fnreverse (runs);
+  return list3 (Fvconcat (1, &runs), codes_list,
+		fragment < 0 ? Qnil : make_number (fragment));
+}
+
 DEFUN ("delete-region", Fdelete_region, Sdelete_region, 2, 2, "r",
        doc: /* Delete the text between START and END.
 If called interactively, delete the region between point and mark.
@@ -3247,6 +4069,68 @@ DEFUN ("delete-and-extract-region", Fdelete_and_extract_region,
   return del_range_1 (XINT (start), XINT (end), 1, 1);
 }
 
+DEFUN ("delete-leading-lines", Fdelete_leading_lines,
+       Sdelete_leading_lines, 1, 3, 0,
+       doc: /* Delete the text before the last LINES lines before END.
+Text is deleted from the beginning of the accessible portion of the
+buffer up to the start of the line LINES lines before the one END is
+on, as `forward-line' with argument -LINES would find it.  END
+defaults to the end of the accessible portion.
+
+If SLACK is a positive number, delete nothing unless that would
+delete at least SLACK lines.  Deleting text from the front of a buffer
+moves the rest of it, so a process filter that keeps a buffer from
+growing does better to do so only once in SLACK lines.
+
+The deletion is not recorded for undo; the buffer's undo list is
+discarded instead, because the positions in it would no longer be
+right.  Return the number of characters deleted.  */)
+  (Lisp_Object lines, Lisp_Object end, Lisp_Object slack)
+{
+  ptrdiff_t e, from, from_byte, shortage, deleted;
+  EMACS_INT n, s;
+
+  CHECK_NATNUM (lines);
+  n = min (XFASTINT (lines), PTRDIFF_MAX - 2);
+  s = 0;
+  if (!NILP (slack))
+    {
+      CHECK_NATNUM (slack);
+      s = min (XFASTINT (slack), PTRDIFF_MAX);
+    }
+  if (NILP (end))
+    e = ZV;
+  else
+    {
+      CHECK_NUMBER_COERCE_MARKER (end);
+      e = clip_to_bounds (BEGV, XINT (end), ZV);
+    }
+
+  /* Find the start of the first line to keep.  */
+  from = find_newline (e, CHAR_TO_BYTE (e), BEGV, BEGV_BYTE, - n - 1,
+		       &shortage, &from_byte, 1);
+  if (shortage > 0)
+    return make_number (0);
+  if (s > 0)
+    {
+      find_newline (from, from_byte, BEGV, BEGV_BYTE, - s,
+		    &shortage, NULL, 1);
+      if (shortage > 0)
+	return make_number (0);
+    }
+
+  dynwind_begin ();
+  record_unwind_protect (subst_char_in_region_unwind,
+			 EQ (BVAR (current_buffer, undo_list), Qt)
+			 ? Qt : Qnil);
+  bset_undo_list (current_buffer, Qt);
+  deleted = from - BEGV;
+  del_range (BEGV, from);
+  dynwind_end ();
+
+  return make_number (deleted);
+}
+
 DEFUN ("widen", Fwiden, Swiden, 0, 0, "",
        doc: /* Remove restrictions (narrowing) from current buffer.
 This allows the buffer's full text to be seen and edited.  */)
@@ -3546,6 +4430,201 @@ usage: (propertize STRING &rest PROPERTIES)  */)
   return string;
 }
 
+/* Parsed format strings.  Most calls to `format' use a constant format
+   string like "%s: %d", so remember how the last few format strings
+   split into literal text and simple conversions, and build the result
+   for those directly.  Entries are keyed by the format string object
+   and checked against a copy of its text, since strings are mutable.  */
+
+struct format_piece
+{
+  /* Literal text of the format string, copied as is.  */
+  ptrdiff_t start, len;
+
+  /* The conversion following the text, 's' or 'd', or 0 if the piece
+     consumes no argument.  */
+  char conversion;
+};
+
+struct format_spec
+{
+  /* False if the format uses anything but %s, %d and %%.  */
+  bool simple;
+  ptrdiff_t npieces;
+  struct format_piece *pieces;
+  ptrdiff_t len;
+  char *text;
+};
+
+enum { FORMAT_CACHE_SIZE = 64 };
+
+static struct format_cache_entry
+{
+  Lisp_Object format;
+  struct format_spec *spec;
+} format_cache[FORMAT_CACHE_SIZE];
+
+/* Split FORMAT, a string of LEN bytes, into pieces.  */
+
+static struct format_spec *
+parse_format_spec (const char *format, ptrdiff_t len)
+{
+  struct format_spec *spec = xmalloc (sizeof *spec);
+  ptrdiff_t i, start = 0, n = 0, size = 0;
+
+  spec->text = xmalloc_atomic (len);
+  memcpy (spec->text, format, len);
+  spec->len = len;
+  spec->simple = 1;
+  spec->pieces = NULL;
+
+  for (i = 0; ; i++)
+    {
+      char conversion = 0;
+      ptrdiff_t end = i;
+
+      if (i == len)
+	;
+      else if (format[i] != '%')
+	continue;
+      else if (i + 1 < len
+	       && (format[i + 1] == 's' || format[i + 1] == 'd'))
+	conversion = format[i + 1];
+      else if (i + 1 < len && format[i + 1] == '%')
+	end = i + 1;
+      else
+	{
+	  spec->simple = 0;
+	  break;
+	}
+
+      if (n == size)
+	spec->pieces = xpalloc (spec->pieces, &size, 1, -1,
+				sizeof *spec->pieces);
+      spec->pieces[n].start = start;
+      spec->pieces[n].len = end - start;
+      spec->pieces[n].conversion = conversion;
+      n++;
+      if (i == len)
+	break;
+      start = i + 2;
+      i++;
+    }
+
+  spec->npieces = n;
+  return spec;
+}
+
+/* Return the parsed form of the format string FORMAT.  */
+
+static struct format_spec *
+lookup_format_spec (Lisp_Object format)
+{
+  struct format_cache_entry *entry
+    = &format_cache[scm_ihashq (format, FORMAT_CACHE_SIZE)];
+
+  if (! (EQ (entry->format, format)
+	 && entry->spec->len == SBYTES (format)
+	 && memcmp (entry->spec->text, SDATA (format), SBYTES (format)) == 0))
+    {
+      entry->spec = parse_format_spec (SSDATA (format), SBYTES (format));
+      entry->format = format;
+    }
+  return entry->spec;
+}
+
+/* Try to do the work of `format' for ARGS without the general
+   machinery: the format string must be ASCII, use only %s, %d and %%,
+   and the arguments must have no text properties.  Return nil if
+   ARGS need the general case.  */
+
+static Lisp_Object
+format_simple (ptrdiff_t nargs, Lisp_Object *args)
+{
+  Lisp_Object format = args[0], val;
+  struct format_spec *spec;
+  bool multibyte = STRING_MULTIBYTE (format);
+  ptrdiff_t i, n, nchars, nbytes;
+  char *buf, *p;
+  USE_SAFE_ALLOCA;
+
+  if (SCHARS (format) != SBYTES (format) || string_intervals (format))
+    return Qnil;
+  spec = lookup_format_spec (format);
+  if (! spec->simple)
+    return Qnil;
+
+  for (n = 1; n < nargs; n++)
+    if (STRINGP (args[n]) && STRING_MULTIBYTE (args[n]))
+      multibyte = 1;
+
+  /* Check the arguments and size the result.  */
+  nbytes = nchars = 0;
+  for (i = 0, n = 1; i < spec->npieces; i++)
+    {
+      struct format_piece *piece = &spec->pieces[i];
+      Lisp_Object arg;
+
+      nbytes += piece->len;
+      nchars += piece->len;
+      if (! piece->conversion)
+	continue;
+      if (! (n < nargs))
+	return Qnil;
+      arg = args[n++];
+      if (INTEGERP (arg))
+	nbytes += INT_STRLEN_BOUND (EMACS_INT);
+      else if (piece->conversion == 'd')
+	return Qnil;
+      else
+	{
+	  if (SYMBOLP (arg))
+	    arg = SYMBOL_NAME (arg);
+	  if (! STRINGP (arg) || string_intervals (arg)
+	      || (STRING_MULTIBYTE (arg)
+		  ? ! multibyte
+		  : (multibyte
+		     && (count_size_as_multibyte (SDATA (arg), SBYTES (arg))
+			 != SBYTES (arg)))))
+	    return Qnil;
+	  nbytes += SBYTES (arg);
+	  nchars += SCHARS (arg);
+	}
+    }
+
+  /* Build the result.  */
+  buf = SAFE_ALLOCA (nbytes + 1);
+  p = buf;
+  for (i = 0, n = 1; i < spec->npieces; i++)
+    {
+      struct format_piece *piece = &spec->pieces[i];
+      Lisp_Object arg;
+
+      memcpy (p, spec->text + piece->start, piece->len);
+      p += piece->len;
+      if (! piece->conversion)
+	continue;
+      arg = args[n++];
+      if (INTEGERP (arg))
+	{
+	  int len = sprintf (p, "%"pI"d", XINT (arg));
+	  p += len;
+	  nchars += len;
+	}
+      else
+	{
+	  if (SYMBOLP (arg))
+	    arg = SYMBOL_NAME (arg);
+	  memcpy (p, SDATA (arg), SBYTES (arg));
+	  p += SBYTES (arg);
+	}
+    }
+
+  val = make_specified_string (buf, nchars, p - buf, multibyte);
+  SAFE_FREE ();
+  return val;
+}
+
 DEFUN ("format", Fformat, Sformat, 1, MANY, 0,
        doc: /* Format a string out of a format-string and arguments.
 The first argument is a format control string.
@@ -3643,6 +4722,11 @@ usage: (format STRING &rest OBJECTS)  */)
      the caller in the interpreter should take care of that.  */
 
   CHECK_STRING (args[0]);
+
+  val = format_simple (nargs, args);
+  if (! NILP (val))
+    return val;
+
   format_start = SSDATA (args[0]);
   formatlen = SBYTES (args[0]);
 
@@ -4761,6 +5845,9 @@ Transposing beyond buffer boundaries is an error.  */)
   /* When doing multiple transpositions, it might be nice
      to optimize this.  Perhaps the markers in any one buffer
      should be organized in some sorted data tree.  */
+  /* The text after START1 now maps differently between characters
+     and bytes, unless the regions had the same lengths.  */
+  truncate_pos_index (current_buffer, start1_byte);
   if (NILP (leave_markers))
     {
       transpose_markers (start1, end1, start2, end2,
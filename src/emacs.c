@@ -710,8 +710,15 @@ string_from_scheme (Lisp_Object scheme_string)
                                  nbytes);
 }
 
+/* Procedures from the Elisp runtime that the C code calls on hot
+   paths.  They are resolved once at startup rather than looked up by
+   name in each call.  */
 Lisp_Object xsymbol_fn;
 Lisp_Object symbol_function_fn;
+Lisp_Object set_symbol_function_fn;
+Lisp_Object symbol_name_fn;
+Lisp_Object symbol_plist_fn;
+Lisp_Object set_symbol_plist_fn;
 
 static int main2 (void *, int, char **);
 
@@ -1201,6 +1208,12 @@ Using an Emacs configured with --with-x-toolkit=lucid does not have this problem
 
       xsymbol_fn = scm_c_public_ref ("language elisp runtime", "symbol-desc");
       symbol_function_fn = scm_c_public_ref ("language elisp runtime", "symbol-function");
+      set_symbol_function_fn
+        = scm_c_public_ref ("language elisp runtime", "set-symbol-function!");
+      symbol_name_fn = scm_c_public_ref ("language elisp runtime", "symbol-name");
+      symbol_plist_fn = scm_c_public_ref ("language elisp runtime", "symbol-plist");
+      set_symbol_plist_fn
+        = scm_c_public_ref ("language elisp runtime", "set-symbol-plist!");
 
       init_guile ();
       init_fns_once ();
@@ -1482,6 +1495,7 @@ Using an Emacs configured with --with-x-toolkit=lucid does not have this problem
       syms_of_marker ();
       syms_of_minibuf ();
       syms_of_process ();
+      syms_of_profiler ();
       syms_of_search ();
       syms_of_frame ();
       syms_of_syntax ();
@@ -1523,6 +1537,8 @@ Using an Emacs configured with --with-x-toolkit=lucid does not have this problem
 #ifdef HAVE_LIBXML2
       syms_of_xml ();
 #endif
+      syms_of_json ();
+      syms_of_serialize ();
 
 #ifdef HAVE_ZLIB
       syms_of_decompress ();
@@ -27,9 +27,11 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include "commands.h"
 #include "keyboard.h"
 #include "dispextern.h"
+#include "systime.h"
 #include "guile.h"
 
 static void unbind_once (void *ignore);
+static void unbind_batch (void *data);
 
 /* Chain of condition and catch handlers currently in effect.  */
 
@@ -81,6 +83,16 @@ union specbinding *specpdl_base;
 
 union specbinding *specpdl_ptr;
 
+/* The specpdl index just past the binding most recently made by
+   specbind, while the Guile unwind handler that undoes that binding
+   is still the innermost entry of the current dynwind extent; -1
+   otherwise.  While it is set, the next specbind can let that
+   handler undo its binding too, instead of registering one of its
+   own.  Anything that opens or closes a dynwind extent, or registers
+   another unwind handler, must reset it.  */
+
+static ptrdiff_t specbind_batch_end = -1;
+
 /* Depth in Lisp evaluations and function calls.  */
 
 EMACS_INT lisp_eval_depth;
@@ -152,25 +164,14 @@ make_catch_handler (Lisp_Object tag)
   return c;
 }
 
-struct handler *
-make_condition_handler (Lisp_Object tag)
-{
-  struct handler *c = xmalloc (sizeof (*c));
-  c->type = CONDITION_CASE;
-  c->tag_or_ch = tag;
-  c->val = Qnil;
-  c->var = Qnil;
-  c->body = Qnil;
-  c->next = handlerlist;
-  c->lisp_eval_depth = lisp_eval_depth;
-  c->interrupt_input_blocked = interrupt_input_blocked;
-  c->ptag = make_prompt_tag ();
-  return c;
-}
-
 static Lisp_Object eval_fn;
 static Lisp_Object funcall_fn;
 
+/* Guile's prompt procedures, resolved once by init_eval_once.  */
+static Lisp_Object abort_to_prompt_fn;
+static Lisp_Object call_with_prompt_fn;
+static Lisp_Object make_prompt_tag_fn;
+
 void
 init_eval_once (void)
 {
@@ -187,6 +188,9 @@ init_eval_once (void)
 
   eval_fn = scm_c_public_ref ("language elisp runtime", "eval-elisp");
   funcall_fn = scm_c_public_ref ("elisp-functions", "funcall");
+  abort_to_prompt_fn = scm_c_public_ref ("guile", "abort-to-prompt");
+  call_with_prompt_fn = scm_c_public_ref ("guile", "call-with-prompt");
+  make_prompt_tag_fn = scm_c_public_ref ("guile", "make-prompt-tag");
 
   //scm_set_smob_apply (lisp_vectorlike_tag, apply_lambda, 0, 0, 1);
 }
@@ -575,6 +579,7 @@ icc_thunk (void *data)
 {
   Lisp_Object tem;
   struct icc_thunk_env *e = data;
+  specbind_batch_end = -1;
   scm_dynwind_begin (0);
   scm_dynwind_unwind_handler (restore_handler, e->c, 0);
   scm_dynwind_unwind_handler (set_handlerlist,
@@ -601,37 +606,19 @@ icc_thunk (void *data)
     default:
       emacs_abort ();
     }
+  specbind_batch_end = -1;
   scm_dynwind_end ();
   return tem;
 }
 
-static Lisp_Object
-icc_handler (void *data, Lisp_Object k, Lisp_Object v)
-{
-  Lisp_Object (*f) (Lisp_Object) = data;
-  return f (v);
-}
-
-struct icc_handler_n_env
-{
-  Lisp_Object (*fun) (Lisp_Object, ptrdiff_t, Lisp_Object *);
-  ptrdiff_t nargs;
-  Lisp_Object *args;
-};
-
-static Lisp_Object
-icc_handler_n (void *data, Lisp_Object k, Lisp_Object v)
-{
-  struct icc_handler_n_env *e = data;
-  return e->fun (v, e->nargs, e->args);
-}
-
 static Lisp_Object
 icc_lisp_handler (void *data, Lisp_Object k, Lisp_Object val)
 {
   Lisp_Object tem;
   struct handler *h = data;
   Lisp_Object var = h->var;
+  Lisp_Object body = h->body;
+  specbind_batch_end = -1;
   scm_dynwind_begin (0);
   if (!NILP (var))
     {
@@ -644,11 +631,122 @@ icc_lisp_handler (void *data, Lisp_Object k, Lisp_Object val)
 #endif
         specbind (var, val);
     }
-  tem = Fprogn (h->body);
+  tem = Fprogn (body);
+  specbind_batch_end = -1;
   scm_dynwind_end ();
   return tem;
 }
 
+/* Catches and condition handlers set up from C.
+
+   Each catch needs a handler, a prompt tag and two closures for
+   call-with-prompt.  Redisplay, timers and process filters set up
+   catches all the time, so rather than allocating these afresh every
+   time, keep them in CATCH_FRAMES, indexed by how deeply the catch is
+   nested.  The handler of a frame is on `handlerlist' exactly while
+   its body runs, so the innermost live frame is the one HANDLERLIST
+   points to, and every frame above it is free for reuse.  This also
+   recovers the frames of catches that a nonlocal exit has skipped.  */
+
+struct catch_frame
+{
+  /* This must come first, so that HANDLERLIST can be converted back
+     to the frame containing it.  */
+  struct handler h;
+
+  /* The index of this frame in CATCH_FRAMES.  */
+  ptrdiff_t index;
+
+  /* Closures over ENV and over this frame, passed to
+     call-with-prompt as the body and the handler.  */
+  Lisp_Object thunk, handler;
+
+  struct icc_thunk_env env;
+
+  /* What to do when the prompt is aborted to.  */
+  enum { CATCH_HANDLER_1, CATCH_HANDLER_N, CATCH_HANDLER_LISP } htype;
+  union
+  {
+    Lisp_Object (*hfun) (Lisp_Object);
+    Lisp_Object (*hfunn) (Lisp_Object, ptrdiff_t, Lisp_Object *);
+  };
+};
+
+static struct catch_frame **catch_frames;
+static ptrdiff_t catch_frames_size;
+
+static Lisp_Object
+catch_frame_handler (void *data, Lisp_Object k, Lisp_Object v)
+{
+  struct catch_frame *f = data;
+
+  /* The body has exited, so anything run from here may reuse F;
+     fetch what is needed from it first.  */
+  switch (f->htype)
+    {
+    case CATCH_HANDLER_1:
+      return f->hfun (v);
+    case CATCH_HANDLER_N:
+      {
+        Lisp_Object (*hfunn) (Lisp_Object, ptrdiff_t, Lisp_Object *)
+          = f->hfunn;
+        return hfunn (v, f->env.nargs, f->env.args);
+      }
+    case CATCH_HANDLER_LISP:
+      return icc_lisp_handler (&f->h, k, v);
+    default:
+      emacs_abort ();
+    }
+}
+
+/* Return a frame for a new catch of TYPE for TAG_OR_CH, nested in
+   the current innermost one.  */
+
+static struct catch_frame *
+push_catch_frame (enum handlertype type, Lisp_Object tag_or_ch)
+{
+  ptrdiff_t i = (handlerlist == handlerlist_sentinel
+                 ? 0 : ((struct catch_frame *) handlerlist)->index + 1);
+  struct catch_frame *f;
+
+  if (i == catch_frames_size)
+    {
+      ptrdiff_t old_size = catch_frames_size;
+      catch_frames = xpalloc (catch_frames, &catch_frames_size, 1, -1,
+                              sizeof *catch_frames);
+      memset (catch_frames + old_size, 0,
+              (catch_frames_size - old_size) * sizeof *catch_frames);
+    }
+
+  f = catch_frames[i];
+  if (!f)
+    {
+      f = xmalloc (sizeof *f);
+      f->index = i;
+      f->h.ptag = make_prompt_tag ();
+      f->env.c = &f->h;
+      f->thunk = make_c_closure (icc_thunk, &f->env, 0, 0);
+      f->handler = make_c_closure (catch_frame_handler, f, 2, 0);
+      catch_frames[i] = f;
+    }
+
+  f->h.type = type;
+  f->h.tag_or_ch = tag_or_ch;
+  f->h.val = Qnil;
+  f->h.var = Qnil;
+  f->h.body = Qnil;
+  f->h.next = handlerlist;
+  f->h.lisp_eval_depth = lisp_eval_depth;
+  f->h.interrupt_input_blocked = interrupt_input_blocked;
+  return f;
+}
+
+static Lisp_Object
+run_catch_frame (struct catch_frame *f)
+{
+  return call_with_prompt (f->h.ptag, f->thunk, f->handler);
+}
+
 /* Set up a catch, then call C function FUNC on argument ARG.
    FUNC should return a Lisp_Object.
    This is how catches are done from within C code.  */
@@ -656,14 +754,14 @@ icc_lisp_handler (void *data, Lisp_Object k, Lisp_Object val)
 Lisp_Object
 internal_catch (Lisp_Object tag, Lisp_Object (*func) (Lisp_Object), Lisp_Object arg)
 {
-  struct handler *c = make_catch_handler (tag);
-  struct icc_thunk_env env = { .type = ICC_1,
-                               .fun1 = func,
-                               .arg1 = arg,
-                               .c = c };
-  return call_with_prompt (c->ptag,
-                           make_c_closure (icc_thunk, &env, 0, 0),
-                           make_c_closure (icc_handler, Fidentity, 2, 0));
+  struct catch_frame *f = push_catch_frame (CATCHER, tag);
+
+  f->env.type = ICC_1;
+  f->env.fun1 = func;
+  f->env.arg1 = arg;
+  f->htype = CATCH_HANDLER_1;
+  f->hfun = Fidentity;
+  return run_catch_frame (f);
 }
 
 /* Unwind the specbind, catch, and handler stacks back to CATCH, and
@@ -752,18 +850,16 @@ ilcc1 (Lisp_Object var, Lisp_Object bodyform, Lisp_Object handlers)
       Lisp_Object body = XCDR (clause);
       if (!CONSP (condition))
         condition = Fcons (condition, Qnil);
-      struct handler *c = make_condition_handler (condition);
-      c->var = var;
-      c->body = body;
-      struct icc_thunk_env env = { .type = ICC_3,
-                                   .fun3 = ilcc1,
-                                   .arg1 = var,
-                                   .arg2 = bodyform,
-                                   .arg3 = XCDR (handlers),
-                                   .c = c };
-      return call_with_prompt (c->ptag,
-                               make_c_closure (icc_thunk, &env, 0, 0),
-                               make_c_closure (icc_lisp_handler, c, 2, 0));
+      struct catch_frame *f = push_catch_frame (CONDITION_CASE, condition);
+      f->h.var = var;
+      f->h.body = body;
+      f->env.type = ICC_3;
+      f->env.fun3 = ilcc1;
+      f->env.arg1 = var;
+      f->env.arg2 = bodyform;
+      f->env.arg3 = XCDR (handlers);
+      f->htype = CATCH_HANDLER_LISP;
+      return run_catch_frame (f);
     }
   else
     {
@@ -812,13 +908,13 @@ Lisp_Object
 internal_condition_case (Lisp_Object (*bfun) (void), Lisp_Object handlers,
 			 Lisp_Object (*hfun) (Lisp_Object))
 {
-  Lisp_Object val;
-  struct handler *c = make_condition_handler (handlers);
+  struct catch_frame *f = push_catch_frame (CONDITION_CASE, handlers);
 
-  struct icc_thunk_env env = { .type = ICC_0, .fun0 = bfun, .c = c };
-  return call_with_prompt (c->ptag,
-                           make_c_closure (icc_thunk, &env, 0, 0),
-                           make_c_closure (icc_handler, hfun, 2, 0));
+  f->env.type = ICC_0;
+  f->env.fun0 = bfun;
+  f->htype = CATCH_HANDLER_1;
+  f->hfun = hfun;
+  return run_catch_frame (f);
 }
 
 /* Like internal_condition_case but call BFUN with ARG as its argument.  */
@@ -827,16 +923,14 @@ Lisp_Object
 internal_condition_case_1 (Lisp_Object (*bfun) (Lisp_Object), Lisp_Object arg,
 			   Lisp_Object handlers, Lisp_Object (*hfun) (Lisp_Object))
 {
-  Lisp_Object val;
-  struct handler *c = make_condition_handler (handlers);
+  struct catch_frame *f = push_catch_frame (CONDITION_CASE, handlers);
 
-  struct icc_thunk_env env = { .type = ICC_1,
-                               .fun1 = bfun,
-                               .arg1 = arg,
-                               .c = c };
-  return call_with_prompt (c->ptag,
-                           make_c_closure (icc_thunk, &env, 0, 0),
-                           make_c_closure (icc_handler, hfun, 2, 0));
+  f->env.type = ICC_1;
+  f->env.fun1 = bfun;
+  f->env.arg1 = arg;
+  f->htype = CATCH_HANDLER_1;
+  f->hfun = hfun;
+  return run_catch_frame (f);
 }
 
 /* Like internal_condition_case_1 but call BFUN with ARG1 and ARG2 as
@@ -849,16 +943,15 @@ internal_condition_case_2 (Lisp_Object (*bfun) (Lisp_Object, Lisp_Object),
 			   Lisp_Object handlers,
 			   Lisp_Object (*hfun) (Lisp_Object))
 {
-  Lisp_Object val;
-  struct handler *c = make_condition_handler (handlers);
-  struct icc_thunk_env env = { .type = ICC_2,
-                               .fun2 = bfun,
-                               .arg1 = arg1,
-                               .arg2 = arg2,
-                               .c = c };
-  return call_with_prompt (c->ptag,
-                           make_c_closure (icc_thunk, &env, 0, 0),
-                           make_c_closure (icc_handler, hfun, 2, 0));
+  struct catch_frame *f = push_catch_frame (CONDITION_CASE, handlers);
+
+  f->env.type = ICC_2;
+  f->env.fun2 = bfun;
+  f->env.arg1 = arg1;
+  f->env.arg2 = arg2;
+  f->htype = CATCH_HANDLER_1;
+  f->hfun = hfun;
+  return run_catch_frame (f);
 }
 
 /* Like internal_condition_case but call BFUN with NARGS as first,
@@ -873,18 +966,15 @@ internal_condition_case_n (Lisp_Object (*bfun) (ptrdiff_t, Lisp_Object *),
 						ptrdiff_t nargs,
 						Lisp_Object *args))
 {
-  Lisp_Object val;
-  struct handler *c = make_condition_handler (handlers);
+  struct catch_frame *f = push_catch_frame (CONDITION_CASE, handlers);
 
-  struct icc_thunk_env env = { .type = ICC_N,
-                               .funn = bfun,
-                               .nargs = nargs,
-                               .args = args,
-                               .c = c };
-  struct icc_handler_n_env henv = { .fun = hfun, .nargs = nargs, .args = args };
-  return call_with_prompt (c->ptag,
-                           make_c_closure (icc_thunk, &env, 0, 0),
-                           make_c_closure (icc_handler_n, &henv, 2, 0));
+  f->env.type = ICC_N;
+  f->env.funn = bfun;
+  f->env.nargs = nargs;
+  f->env.args = args;
+  f->htype = CATCH_HANDLER_N;
+  f->hfunn = hfun;
+  return run_catch_frame (f);
 }
 
 
@@ -1965,9 +2055,221 @@ DEFUN ("functionp", Ffunctionp, Sfunctionp, 1, 1, 0,
   return Qnil;
 }
 
+/* Arity of Guile procedures seen by Ffuncall, so that the direct call
+   path does not have to ask Guile for it on every call.  The cache is
+   direct-mapped on the address of the procedure.  MAX_ARGS is MANY
+   for procedures taking a rest argument.  */
+
+struct funcall_arity
+{
+  Lisp_Object fun;
+  short min_args, max_args;
+};
+
+enum { FUNCALL_ARITY_CACHE_SIZE = 512 };
+
+static struct funcall_arity funcall_arity_cache[FUNCALL_ARITY_CACHE_SIZE];
+
+/* Return the cache entry describing the arity of FUN, a Guile
+   procedure.  Return NULL if Guile does not know its arity.  */
+
+static struct funcall_arity *
+funcall_arity (Lisp_Object fun)
+{
+  struct funcall_arity *entry
+    = &funcall_arity_cache[(XLI (fun) >> 3) % FUNCALL_ARITY_CACHE_SIZE];
+  Lisp_Object arity;
+
+  if (EQ (entry->fun, fun))
+    return entry;
+
+  arity = scm_procedure_minimum_arity (fun);
+  if (scm_is_false (arity))
+    return NULL;
+
+  entry->fun = fun;
+  entry->min_args = scm_to_short (XCAR (arity));
+  if (scm_is_true (XCAR (XCDR (XCDR (arity)))))
+    entry->max_args = MANY;
+  else
+    entry->max_args = entry->min_args + scm_to_short (XCAR (XCDR (arity)));
+  return entry;
+}
+
+/* Try to call ARGS[0] on the rest of ARGS without going through the
+   Elisp `funcall' procedure.  This is possible when the function is a
+   Guile procedure, which includes every DEFUN other than special
+   forms, and the number of arguments is acceptable to it.  Return
+   SCM_UNDEFINED if the call has to take the general path.  */
+
+static Lisp_Object
+funcall_direct (ptrdiff_t nargs, Lisp_Object *args)
+{
+  Lisp_Object fun = args[0];
+  struct funcall_arity *arity;
+  ptrdiff_t numargs = nargs - 1;
+
+  if (SYMBOLP (fun) && !NILP (fun))
+    fun = scm_call_1 (symbol_function_fn, fun);
+
+  if (!fun || SYMBOLP (fun) || CONSP (fun)
+      || scm_is_false (scm_procedure_p (fun)))
+    return SCM_UNDEFINED;
+
+  arity = funcall_arity (fun);
+  if (!arity
+      || numargs < arity->min_args
+      || (arity->max_args != MANY && numargs > arity->max_args))
+    return SCM_UNDEFINED;
+
+  switch (numargs)
+    {
+    case 0: return scm_call_0 (fun);
+    case 1: return scm_call_1 (fun, args[1]);
+    case 2: return scm_call_2 (fun, args[1], args[2]);
+    case 3: return scm_call_3 (fun, args[1], args[2], args[3]);
+    default: return scm_call_n (fun, args + 1, numargs);
+    }
+}
+
+/* The call profiler.  call_profile_table maps function symbols to
+   vectors [COUNT NANOSECONDS DEPTH SELECTED], or is nil until the
+   profiler is first used.  While call_profile_enabled, the gsubrs of
+   DEFUNs and Ffuncall count and time the calls of the functions whose
+   entry is SELECTED; if call_profile_all, every function they call
+   gets a selected entry.  call-profile-apply times the calls of any
+   function, which is how Lisp functions called from compiled code are
+   profiled.  DEPTH is the number of calls of the function under way,
+   so that only the outermost of recursive calls adds its time.  */
+
+bool call_profile_enabled;
+static bool call_profile_all;
+static Lisp_Object call_profile_table;
+static struct call_profile_frame *call_profile_current;
+
+static intmax_t
+call_profile_now (void)
+{
+  struct timespec now = current_timespec ();
+  return (intmax_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+/* Return the entry of SYMBOL in the profile, or nil if it has none.
+   If CREATE, give it an entry first, selected if SELECTED.  */
+
+static Lisp_Object
+call_profile_entry (Lisp_Object symbol, bool create, bool selected)
+{
+  struct Lisp_Hash_Table *h;
+  EMACS_UINT hash;
+  ptrdiff_t i;
+  Lisp_Object entry;
+
+  if (NILP (call_profile_table))
+    {
+      if (!create)
+	return Qnil;
+      call_profile_table
+	= make_hash_table (hashtest_eq, make_number (DEFAULT_HASH_SIZE),
+			   make_float (DEFAULT_REHASH_SIZE),
+			   make_float (DEFAULT_REHASH_THRESHOLD),
+			   Qnil);
+    }
+  h = XHASH_TABLE (call_profile_table);
+  i = hash_lookup (h, symbol, &hash);
+  if (i >= 0)
+    return HASH_VALUE (h, i);
+  if (!create)
+    return Qnil;
+  entry = Fmake_vector (make_number (4), make_number (0));
+  ASET (entry, 3, selected ? Qt : Qnil);
+  hash_put (h, symbol, entry, hash);
+  return entry;
+}
+
+/* End the timed call FRAME, normally or by a nonlocal exit.  */
+
+static void
+call_profile_exit (void *arg)
+{
+  struct call_profile_frame *frame = arg;
+  Lisp_Object entry = call_profile_entry (frame->symbol, 0, 0);
+
+  call_profile_current = frame->outer;
+  /* The entry is gone if the function was dropped during the call.  */
+  if (VECTORP (entry) && XINT (AREF (entry, 2)) > 0)
+    {
+      EMACS_INT depth = XINT (AREF (entry, 2)) - 1;
+
+      ASET (entry, 2, make_number (depth));
+      if (depth == 0)
+	ASET (entry, 1, make_number (XINT (AREF (entry, 1))
+				     + call_profile_now () - frame->start));
+    }
+}
+
+/* Start timing a call of SYMBOL in FRAME, which has ENTRY as its
+   entry.  The caller must call dynwind_end when the call returns.  */
+
+static void
+call_profile_push (struct call_profile_frame *frame, Lisp_Object symbol,
+		   Lisp_Object entry, bool funcall)
+{
+  EMACS_INT depth = XINT (AREF (entry, 2));
+
+  ASET (entry, 0, make_number (XINT (AREF (entry, 0)) + 1));
+  ASET (entry, 2, make_number (depth + 1));
+  frame->symbol = symbol;
+  frame->start = depth == 0 ? call_profile_now () : 0;
+  frame->outer = call_profile_current;
+  frame->funcall = funcall;
+  call_profile_current = frame;
+  dynwind_begin ();
+  record_unwind_protect_ptr (call_profile_exit, frame);
+}
+
+/* Start timing the call of SYMBOL in FRAME if the profiler wants it,
+   and return true if so.  */
+
+static bool
+call_profile_enter (struct call_profile_frame *frame, Lisp_Object symbol,
+		    bool funcall)
+{
+  Lisp_Object entry = call_profile_entry (symbol, call_profile_all, 1);
+
+  if (!VECTORP (entry) || NILP (AREF (entry, 3)))
+    return 0;
+  call_profile_push (frame, symbol, entry, funcall);
+  return 1;
+}
+
+/* Like call_profile_enter, for the DEFUN named LNAME.  SYMBOL caches
+   its symbol.  */
+
+bool
+call_profile_enter_subr (struct call_profile_frame *frame,
+			 Lisp_Object *symbol, const char *lname)
+{
+  if (!*symbol)
+    *symbol = intern_c_string (lname);
+  return call_profile_enter (frame, *symbol, 0);
+}
+
 static Lisp_Object
 Ffuncall1 (ptrdiff_t nargs, Lisp_Object *args)
 {
+  Lisp_Object val = funcall_direct (nargs, args);
+  struct call_profile_frame frame;
+
+  if (!SCM_UNBNDP (val))
+    return val;
+  if (call_profile_enabled && SYMBOLP (args[0]) && !NILP (args[0])
+      && call_profile_enter (&frame, args[0], 1))
+    {
+      val = scm_call_n (funcall_fn, args, nargs);
+      dynwind_end ();
+      return val;
+    }
   return scm_call_n (funcall_fn, args, nargs);
 }
 
@@ -2095,6 +2397,131 @@ funcall_lambda (Lisp_Object fun, ptrdiff_t nargs,
   return val;
 }
 
+DEFUN ("call-profile-enable", Fcall_profile_enable, Scall_profile_enable,
+       1, 1, 0,
+       doc: /* Start counting and timing the calls of FUNCTIONS.
+FUNCTIONS is a list of function symbols, or t to profile the calls of
+every function.  The calls recorded are those of primitives, and those
+that go through `funcall' or `apply' from C; Lisp functions called
+from compiled Lisp code are only seen through `call-profile-apply'.
+Use `call-profile-results' to get the results.  */)
+  (Lisp_Object functions)
+{
+  if (EQ (functions, Qt))
+    call_profile_all = 1;
+  else
+    {
+      Lisp_Object tail;
+
+      for (tail = functions; CONSP (tail); tail = XCDR (tail))
+	{
+	  CHECK_SYMBOL (XCAR (tail));
+	  ASET (call_profile_entry (XCAR (tail), 1, 1), 3, Qt);
+	}
+      CHECK_LIST_END (tail, functions);
+    }
+  call_profile_enabled = 1;
+  return Qnil;
+}
+
+DEFUN ("call-profile-disable", Fcall_profile_disable, Scall_profile_disable,
+       0, 1, 0,
+       doc: /* Stop counting and timing the calls of FUNCTIONS.
+FUNCTIONS is a list of function symbols, whose results are discarded.
+If it is nil, stop recording any call, but keep the results.  */)
+  (Lisp_Object functions)
+{
+  Lisp_Object tail;
+
+  if (NILP (functions))
+    {
+      call_profile_enabled = call_profile_all = 0;
+      return Qnil;
+    }
+  for (tail = functions; CONSP (tail); tail = XCDR (tail))
+    if (!NILP (call_profile_table))
+      hash_remove_from_table (XHASH_TABLE (call_profile_table), XCAR (tail));
+  CHECK_LIST_END (tail, functions);
+  return Qnil;
+}
+
+DEFUN ("call-profile-reset", Fcall_profile_reset, Scall_profile_reset,
+       0, 1, 0,
+       doc: /* Reset the call counts and times of FUNCTIONS to zero.
+FUNCTIONS is a list of function symbols; nil means all functions.  */)
+  (Lisp_Object functions)
+{
+  struct Lisp_Hash_Table *h;
+  ptrdiff_t i;
+
+  if (NILP (call_profile_table))
+    return Qnil;
+  h = XHASH_TABLE (call_profile_table);
+  for (i = 0; i < HASH_TABLE_SIZE (h); ++i)
+    if (!NILP (HASH_HASH (h, i))
+	&& (NILP (functions) || !NILP (Fmemq (HASH_KEY (h, i), functions))))
+      {
+	Lisp_Object entry = HASH_VALUE (h, i);
+
+	ASET (entry, 0, make_number (0));
+	ASET (entry, 1, make_number (0));
+      }
+  return Qnil;
+}
+
+DEFUN ("call-profile-results", Fcall_profile_results, Scall_profile_results,
+       0, 0, 0,
+       doc: /* Return the calls recorded by the call profiler.
+The value is a list of elements (FUNCTION COUNT SECONDS), where COUNT
+is the number of calls of FUNCTION and SECONDS the time they took,
+not counting twice the time of recursive calls.  */)
+  (void)
+{
+  struct Lisp_Hash_Table *h;
+  Lisp_Object results = Qnil;
+  ptrdiff_t i;
+
+  if (NILP (call_profile_table))
+    return Qnil;
+  h = XHASH_TABLE (call_profile_table);
+  for (i = 0; i < HASH_TABLE_SIZE (h); ++i)
+    if (!NILP (HASH_HASH (h, i)))
+      {
+	Lisp_Object entry = HASH_VALUE (h, i);
+
+	results = Fcons (list3 (HASH_KEY (h, i), AREF (entry, 0),
+				make_float (XINT (AREF (entry, 1)) / 1e9)),
+			 results);
+      }
+  return results;
+}
+
+DEFUN ("call-profile-apply", Fcall_profile_apply, Scall_profile_apply,
+       3, 3, 0,
+       doc: /* Call FUNCTION with ARGS, counting and timing the call as one of SYMBOL.
+This records the call whether or not the call profiler is enabled, and
+is meant for advice around SYMBOL.  */)
+  (Lisp_Object symbol, Lisp_Object function, Lisp_Object args)
+{
+  struct call_profile_frame frame;
+  Lisp_Object apply_args[2], val;
+
+  CHECK_SYMBOL (symbol);
+  apply_args[0] = function;
+  apply_args[1] = args;
+  /* If Ffuncall is already timing this very call, leave it to it.  */
+  if (call_profile_current && call_profile_current->funcall
+      && EQ (call_profile_current->symbol, symbol))
+    {
+      call_profile_current->funcall = 0;
+      return Fapply (2, apply_args);
+    }
+  call_profile_push (&frame, symbol, call_profile_entry (symbol, 1, 0), 0);
+  val = Fapply (2, apply_args);
+  dynwind_end ();
+  return val;
+}
+
 DEFUN ("fetch-bytecode", Ffetch_bytecode, Sfetch_bytecode,
        1, 1, 0,
        doc: /* If byte-compiled OBJECT is lazy-loaded, fetch it now.  */)
@@ -2235,7 +2662,17 @@ specbind (Lisp_Object symbol, Lisp_Object value)
     }
 
  done:
-  scm_dynwind_unwind_handler (unbind_once, NULL, SCM_F_WIND_EXPLICITLY);
+  /* A `let' of several variables, or a function binding several
+     dynamic parameters, then needs only one Guile unwind handler.  */
+  if (specbind_batch_end == SPECPDL_INDEX () - 1)
+    specbind_batch_end++;
+  else
+    {
+      ptrdiff_t base = SPECPDL_INDEX () - 1;
+      scm_dynwind_unwind_handler (unbind_batch, (void *) base,
+                                  SCM_F_WIND_EXPLICITLY);
+      specbind_batch_end = base + 1;
+    }
 }
 
 /* Push unwind-protect entries of various types.  */
@@ -2257,6 +2694,7 @@ void
 record_unwind_protect_ptr_1 (void (*function) (void *), void *arg,
                              bool wind_explicitly)
 {
+  specbind_batch_end = -1;
   scm_dynwind_unwind_handler (function,
                               arg,
                               (wind_explicitly
@@ -2350,15 +2788,31 @@ unbind_once (void *ignore)
     }
 }
 
+/* Undo the bindings made by specbind at specpdl index DATA and above.
+   One call of this handler covers all the consecutive bindings made
+   in a dynwind extent with no other unwind handler in between.  */
+
+static void
+unbind_batch (void *data)
+{
+  ptrdiff_t base = (ptrdiff_t) data;
+
+  specbind_batch_end = -1;
+  while (SPECPDL_INDEX () > base)
+    unbind_once (NULL);
+}
+
 void
 dynwind_begin (void)
 {
+  specbind_batch_end = -1;
   scm_dynwind_begin (0);
 }
 
 void
 dynwind_end (void)
 {
+  specbind_batch_end = -1;
   scm_dynwind_end ();
 }
 
@@ -2375,34 +2829,27 @@ context where binding is lexical by default.  */)
 _Noreturn SCM
 abort_to_prompt (SCM tag, SCM arglst)
 {
-  static SCM var = SCM_UNDEFINED;
-  if (SCM_UNBNDP (var))
-    var = scm_c_public_lookup ("guile", "abort-to-prompt");
-
-  scm_apply_1 (scm_variable_ref (var), tag, arglst);
+  scm_apply_1 (abort_to_prompt_fn, tag, arglst);
   emacs_abort ();
 }
 
 SCM
 call_with_prompt (SCM tag, SCM thunk, SCM handler)
 {
-  static SCM var = SCM_UNDEFINED;
-  if (SCM_UNBNDP (var))
-    var = scm_c_public_lookup ("guile", "call-with-prompt");
+  SCM val;
 
-  return scm_call_3 (scm_variable_ref (var), tag, thunk, handler);
+  specbind_batch_end = -1;
+  val = scm_call_3 (call_with_prompt_fn, tag, thunk, handler);
+  specbind_batch_end = -1;
+  return val;
 }
 
 SCM
 make_prompt_tag (void)
 {
-  static SCM var = SCM_UNDEFINED;
-  if (SCM_UNBNDP (var))
-    var = scm_c_public_lookup ("guile", "make-prompt-tag");
-
-  return scm_call_0 (scm_variable_ref (var));
+  return scm_call_0 (make_prompt_tag_fn);
 }
-
+
 void
 syms_of_eval (void)
 {
@@ -2550,6 +2997,8 @@ alist of active lexical bindings.  */);
   Vautoload_queue = Qnil;
   staticpro (&Vsignaling_function);
   Vsignaling_function = Qnil;
+  staticpro (&call_profile_table);
+  call_profile_table = Qnil;
 
   inhibit_lisp_code = Qnil;
 }
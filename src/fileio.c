@@ -90,6 +90,10 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <netio.h>
 #endif
 
+#ifndef DOS_NT
+#include <sys/uio.h>
+#endif
+
 #include "commands.h"
 
 /* True during writing of auto-save files.  */
@@ -344,6 +348,98 @@ Lisp_Object Qwrite_region;
 static Lisp_Object Qverify_visited_file_modtime;
 static Lisp_Object Qset_visited_file_modtime;
 
+/* Where each regexp of `file-name-handler-alist' matched the file
+   names looked up last, since one file name is usually looked up for
+   several operations in a row.  HANDLER_REGEXPS holds the regexps (or
+   nil for an element that has none) that the positions are for; when
+   the alist no longer has those, the positions are forgotten.  A
+   regexp changed in place with `aset' goes unnoticed.  */
+
+#define HANDLER_MATCH_CACHE_SIZE 16
+
+static Lisp_Object handler_regexps;
+static struct
+{
+  /* A copy of the file name, or nil if the entry is unused.  */
+  Lisp_Object filename;
+  /* The syntax table the regexps were matched with.  */
+  Lisp_Object syntax_table;
+  /* A vector of where each regexp matched, or -1.  */
+  Lisp_Object positions;
+} handler_matches[HANDLER_MATCH_CACHE_SIZE];
+static int handler_match_next;
+
+/* Return a vector of where each regexp of `file-name-handler-alist'
+   matches FILENAME, or -1 for those that do not match it.  */
+
+static Lisp_Object
+file_name_handler_matches (Lisp_Object filename)
+{
+  Lisp_Object chain, positions;
+  ptrdiff_t i, n = 0;
+  bool same = VECTORP (handler_regexps);
+
+  /* Check that the alist still has the regexps of the cache.  */
+  for (chain = Vfile_name_handler_alist; CONSP (chain); chain = XCDR (chain))
+    {
+      Lisp_Object elt = XCAR (chain);
+      Lisp_Object regexp
+	= CONSP (elt) && STRINGP (XCAR (elt)) ? XCAR (elt) : Qnil;
+
+      if (same && (n == ASIZE (handler_regexps)
+		   || !EQ (AREF (handler_regexps, n), regexp)))
+	same = 0;
+      n++;
+    }
+  if (same && n != ASIZE (handler_regexps))
+    same = 0;
+
+  if (! same)
+    {
+      handler_regexps = Fmake_vector (make_number (n), Qnil);
+      i = 0;
+      for (chain = Vfile_name_handler_alist; i < n; chain = XCDR (chain), i++)
+	{
+	  Lisp_Object elt = XCAR (chain);
+
+	  if (CONSP (elt) && STRINGP (XCAR (elt)))
+	    ASET (handler_regexps, i, XCAR (elt));
+	}
+      for (i = 0; i < HANDLER_MATCH_CACHE_SIZE; i++)
+	handler_matches[i].filename = Qnil;
+    }
+  else
+    for (i = 0; i < HANDLER_MATCH_CACHE_SIZE; i++)
+      {
+	Lisp_Object name = handler_matches[i].filename;
+
+	if (STRINGP (name)
+	    && SBYTES (name) == SBYTES (filename)
+	    && STRING_MULTIBYTE (name) == STRING_MULTIBYTE (filename)
+	    && EQ (handler_matches[i].syntax_table,
+		   BVAR (current_buffer, syntax_table))
+	    && !memcmp (SDATA (name), SDATA (filename), SBYTES (name)))
+	  return handler_matches[i].positions;
+      }
+
+  positions = Fmake_vector (make_number (n), make_number (-1));
+  for (i = 0; i < n; i++)
+    {
+      Lisp_Object regexp = AREF (handler_regexps, i);
+
+      if (STRINGP (regexp))
+	ASET (positions, i,
+	      make_number (fast_string_match (regexp, filename)));
+      QUIT;
+    }
+
+  i = handler_match_next++ % HANDLER_MATCH_CACHE_SIZE;
+  handler_matches[i].filename = Fcopy_sequence (filename);
+  handler_matches[i].syntax_table = BVAR (current_buffer, syntax_table);
+  handler_matches[i].positions = positions;
+  return positions;
+}
+
 DEFUN ("find-file-name-handler", Ffind_file_name_handler,
        Sfind_file_name_handler, 2, 2, 0,
        doc: /* Return FILENAME's handler function for OPERATION, if it has one.
@@ -358,8 +454,8 @@ use the standard functions without calling themselves recursively.  */)
   (Lisp_Object filename, Lisp_Object operation)
 {
   /* This function must not munge the match data.  */
-  Lisp_Object chain, inhibited_handlers, result;
-  ptrdiff_t pos = -1;
+  Lisp_Object chain, inhibited_handlers, result, positions;
+  ptrdiff_t pos = -1, i;
 
   result = Qnil;
   CHECK_STRING (filename);
@@ -369,23 +465,26 @@ use the standard functions without calling themselves recursively.  */)
   else
     inhibited_handlers = Qnil;
 
-  for (chain = Vfile_name_handler_alist; CONSP (chain);
-       chain = XCDR (chain))
+  if (! CONSP (Vfile_name_handler_alist))
+    return Qnil;
+
+  positions = file_name_handler_matches (filename);
+  for (chain = Vfile_name_handler_alist, i = 0;
+       CONSP (chain) && i < ASIZE (positions);
+       chain = XCDR (chain), i++)
     {
       Lisp_Object elt;
       elt = XCAR (chain);
       if (CONSP (elt))
 	{
-	  Lisp_Object string = XCAR (elt);
-	  ptrdiff_t match_pos;
+	  ptrdiff_t match_pos = XINT (AREF (positions, i));
 	  Lisp_Object handler = XCDR (elt);
 	  Lisp_Object operations = Qnil;
 
-	  if (SYMBOLP (handler))
+	  if (match_pos > pos && SYMBOLP (handler))
 	    operations = Fget (handler, Qoperations);
 
-	  if (STRINGP (string)
-	      && (match_pos = fast_string_match (string, filename)) > pos
+	  if (match_pos > pos
 	      && (NILP (operations) || ! NILP (Fmemq (operation, operations))))
 	    {
 	      Lisp_Object tem;
@@ -3298,6 +3397,15 @@ otherwise, if FILE2 does not exist, the answer is t.  */)
 /* Some buffer offsets are stored in 'int' variables.  */
 verify (READ_BUF_SIZE <= INT_MAX);
 
+/* The most that insert-file-contents reads from a regular file at a
+   time when reading straight into the gap.  This is much larger than
+   READ_BUF_SIZE, so that big files take few system calls, but still
+   small enough for quitting between reads to be prompt.  */
+#ifndef READ_GAP_SIZE
+#define READ_GAP_SIZE (4 << 20)
+#endif
+verify (READ_BUF_SIZE <= READ_GAP_SIZE && READ_GAP_SIZE <= INT_MAX);
+
 /* This function is called after Lisp functions to decide a coding
    system are called, or when they cause an error.  Before they are
    called, the current buffer is set unibyte and it contains only a
@@ -3324,7 +3432,7 @@ decide_coding_unwind (Lisp_Object unwind_data)
   buffer = XCDR (unwind_data);
 
   set_buffer_internal (XBUFFER (buffer));
-  adjust_markers_for_delete (BEG, BEG_BYTE, Z, Z_BYTE);
+  adjust_markers_for_delete (BEG, BEG_BYTE, Z, Z_BYTE, NULL);
   adjust_overlays_for_delete (BEG, Z - BEG);
   set_buffer_intervals (current_buffer, NULL);
   TEMP_SET_PT_BOTH (BEG, BEG_BYTE);
@@ -3763,10 +3871,9 @@ by calling `format-decode', which see.  */)
 	      break;
 	    }
 
-	  bufpos = 0;
-	  while (bufpos < nread && same_at_start < ZV_BYTE
-		 && FETCH_BYTE (same_at_start) == read_buf[bufpos])
-	    same_at_start++, bufpos++;
+	  bufpos = buffer_prefix_match (current_buffer, same_at_start, ZV_BYTE,
+					(unsigned char *) read_buf, nread);
+	  same_at_start += bufpos;
 	  /* If we found a discrepancy, stop the scan.
 	     Otherwise loop around and scan the next bufferful.  */
 	  if (bufpos != nread)
@@ -3821,9 +3928,11 @@ by calling `format-decode', which see.  */)
 
 	  /* Compare with same_at_start to avoid counting some buffer text
 	     as matching both at the file's beginning and at the end.  */
-	  while (bufpos > 0 && same_at_end > same_at_start
-		 && FETCH_BYTE (same_at_end - 1) == read_buf[bufpos - 1])
-	    same_at_end--, bufpos--;
+	  trial = buffer_suffix_match (current_buffer, same_at_start,
+				       same_at_end, (unsigned char *) read_buf,
+				       total_read);
+	  same_at_end -= trial;
+	  bufpos -= trial;
 
 	  /* If we found a discrepancy, stop the scan.
 	     Otherwise loop around and scan the preceding bufferful.  */
@@ -3976,10 +4085,9 @@ by calling `format-decode', which see.  */)
       /* Compare the beginning of the converted string with the buffer
 	 text.  */
 
-      bufpos = 0;
-      while (bufpos < inserted && same_at_start < same_at_end
-	     && FETCH_BYTE (same_at_start) == decoded[bufpos])
-	same_at_start++, bufpos++;
+      bufpos = buffer_prefix_match (current_buffer, same_at_start,
+				    same_at_end, decoded, inserted);
+      same_at_start += bufpos;
 
       /* If the file matches the head of buffer completely,
 	 there's no need to replace anything.  */
@@ -4013,9 +4121,10 @@ by calling `format-decode', which see.  */)
 
       /* Compare with same_at_start to avoid counting some buffer text
 	 as matching both at the file's beginning and at the end.  */
-      while (bufpos > 0 && same_at_end > same_at_start
-	     && FETCH_BYTE (same_at_end - 1) == decoded[bufpos - 1])
-	same_at_end--, bufpos--;
+      temp = buffer_suffix_match (current_buffer, same_at_start,
+				  same_at_end, decoded, inserted);
+      same_at_end -= temp;
+      bufpos -= temp;
 
       /* Extend the end of non-matching text area to the next
 	 multibyte character boundary.  */
@@ -4107,6 +4216,12 @@ by calling `format-decode', which see.  */)
 	report_file_error ("Setting file position", orig_filename);
     }
 
+#ifdef POSIX_FADV_SEQUENTIAL
+  /* All of the file is about to be read in order.  */
+  if (! not_regular && total > READ_GAP_SIZE)
+    posix_fadvise (fd, beg_offset, total, POSIX_FADV_SEQUENTIAL);
+#endif
+
   /* In the following loop, HOW_MUCH contains the total bytes read so
      far for a regular file, and not changed for a special file.  But,
      before exiting the loop, it is set to a negative value if I/O
@@ -4124,7 +4239,8 @@ by calling `format-decode', which see.  */)
     while (how_much < total)
       {
 	/* try is reserved in some compilers (Microsoft C) */
-	ptrdiff_t trytry = min (total - how_much, READ_BUF_SIZE);
+	ptrdiff_t trytry = min (total - how_much,
+				not_regular ? READ_BUF_SIZE : READ_GAP_SIZE);
 	ptrdiff_t this;
 
 	if (not_regular)
@@ -5199,6 +5315,47 @@ a_write (int desc, Lisp_Object string, ptrdiff_t pos,
 
 enum { E_WRITE_MAX = 8 * 1024 * 1024 };
 
+/* Write the text from START_BYTE to END_BYTE of the current buffer
+   into descriptor DESC as it is.  If the text spans the gap, write
+   both parts with one system call where possible.  Return true if
+   successful.  */
+
+static bool
+e_write_buffer_text (int desc, ptrdiff_t start_byte, ptrdiff_t end_byte)
+{
+#ifndef DOS_NT
+  if (start_byte < GPT_BYTE && GPT_BYTE < end_byte)
+    {
+      struct iovec iov[2];
+      ssize_t n;
+
+      iov[0].iov_base = BYTE_POS_ADDR (start_byte);
+      iov[0].iov_len = GPT_BYTE - start_byte;
+      iov[1].iov_base = GAP_END_ADDR;
+      iov[1].iov_len = end_byte - GPT_BYTE;
+      while ((n = writev (desc, iov, 2)) < 0 && errno == EINTR)
+	if (pending_signals)
+	  process_pending_signals ();
+      if (n < 0)
+	return 0;
+      /* Write whatever writev left, the usual way.  */
+      start_byte += n;
+    }
+#endif
+
+  while (start_byte < end_byte)
+    {
+      ptrdiff_t stop = (start_byte < GPT_BYTE
+			? min (end_byte, GPT_BYTE) : end_byte);
+      ptrdiff_t nbytes = stop - start_byte;
+
+      if (emacs_write_sig (desc, BYTE_POS_ADDR (start_byte), nbytes) != nbytes)
+	return 0;
+      start_byte = stop;
+    }
+  return 1;
+}
+
 /* Write text in the range START and END into descriptor DESC,
    encoding them with coding system CODING.  If STRING is nil, START
    and END are character positions of the current buffer, else they
@@ -5214,6 +5371,18 @@ e_write (int desc, Lisp_Object string, ptrdiff_t start, ptrdiff_t end,
       end = SCHARS (string);
     }
 
+  else if (start < end)
+    {
+      ptrdiff_t start_byte = CHAR_TO_BYTE (start);
+      ptrdiff_t end_byte = CHAR_TO_BYTE (end);
+
+      /* Text that needs no encoding goes straight from the buffer.  */
+      coding->src_multibyte = (end - start) < (end_byte - start_byte);
+      if (! CODING_REQUIRE_ENCODING (coding)
+	  || encode_coding_is_identity (coding, start_byte, end_byte))
+	return e_write_buffer_text (desc, start_byte, end_byte);
+    }
+
   /* We used to have a code for handling selective display here.  But,
      now it is handled within encode_coding.  */
 
@@ -5247,42 +5416,23 @@ e_write (int desc, Lisp_Object string, ptrdiff_t start, ptrdiff_t end,
 	  ptrdiff_t start_byte = CHAR_TO_BYTE (start);
 	  ptrdiff_t end_byte = CHAR_TO_BYTE (end);
 
+	  ptrdiff_t nchars = min (end - start, E_WRITE_MAX);
+
 	  coding->src_multibyte = (end - start) < (end_byte - start_byte);
-	  if (CODING_REQUIRE_ENCODING (coding))
-	    {
-	      ptrdiff_t nchars = min (end - start, E_WRITE_MAX);
 
-	      /* Likewise.  */
-	      if (nchars == E_WRITE_MAX)
-		coding->raw_destination = 1;
+	  /* Likewise.  */
+	  if (nchars == E_WRITE_MAX)
+	    coding->raw_destination = 1;
 
-	      encode_coding_object
-		(coding, Fcurrent_buffer (), start, start_byte,
-		 start + nchars, CHAR_TO_BYTE (start + nchars), Qt);
-	    }
-	  else
-	    {
-	      coding->dst_object = Qnil;
-	      coding->dst_pos_byte = start_byte;
-	      if (start >= GPT || end <= GPT)
-		{
-		  coding->consumed_char = end - start;
-		  coding->produced = end_byte - start_byte;
-		}
-	      else
-		{
-		  coding->consumed_char = GPT - start;
-		  coding->produced = GPT_BYTE - start_byte;
-		}
-	    }
+	  encode_coding_object
+	    (coding, Fcurrent_buffer (), start, start_byte,
+	     start + nchars, CHAR_TO_BYTE (start + nchars), Qt);
 	}
 
       if (coding->produced > 0)
 	{
 	  char *buf = (coding->raw_destination ? (char *) coding->destination
-		       : (STRINGP (coding->dst_object)
-			  ? SSDATA (coding->dst_object)
-			  : (char *) BYTE_POS_ADDR (coding->dst_pos_byte)));
+		       : SSDATA (coding->dst_object));
 	  coding->produced -= emacs_write_sig (desc, buf, coding->produced);
 
 	  if (coding->raw_destination)
@@ -5345,6 +5495,51 @@ See Info node `(elisp)Modification Time' for more details.  */)
   return Qnil;
 }
 
+DEFUN ("stale-file-buffers", Fstale_file_buffers, Sstale_file_buffers,
+       0, 1, 0,
+       doc: /* Return the buffers in BUFFERS whose visited files have changed.
+A buffer is in the value if its visited file is readable but its last
+mod time or size does not match what the buffer records, that is, if
+`verify-visited-file-modtime' would return nil and the file exists.
+BUFFERS defaults to the list of all buffers.
+
+Killed buffers, buffers not visiting a file, and buffers whose visited
+file name has a file name handler are not checked and never returned.
+This is much faster than checking each buffer from Lisp.  */)
+  (Lisp_Object buffers)
+{
+  Lisp_Object tail, value = Qnil;
+
+  if (NILP (buffers))
+    buffers = Fbuffer_list (Qnil);
+
+  for (tail = buffers; CONSP (tail); tail = XCDR (tail))
+    {
+      Lisp_Object buf = XCAR (tail);
+      Lisp_Object filename;
+      struct buffer *b;
+      struct stat st;
+
+      CHECK_BUFFER (buf);
+      b = XBUFFER (buf);
+      if (!BUFFER_LIVE_P (b)
+	  || !STRINGP (BVAR (b, filename))
+	  || b->modtime.tv_nsec == UNKNOWN_MODTIME_NSECS
+	  || !NILP (Ffind_file_name_handler (BVAR (b, filename),
+					     Qverify_visited_file_modtime)))
+	continue;
+
+      filename = ENCODE_FILE (BVAR (b, filename));
+      if (stat (SSDATA (filename), &st) == 0
+	  && (timespec_cmp (get_stat_mtime (&st), b->modtime) != 0
+	      || (0 <= b->modtime_size && st.st_size != b->modtime_size))
+	  && faccessat (AT_FDCWD, SSDATA (filename), R_OK, AT_EACCESS) == 0)
+	value = Fcons (buf, value);
+    }
+
+  return Fnreverse (value);
+}
+
 DEFUN ("visited-file-modtime", Fvisited_file_modtime,
        Svisited_file_modtime, 0, 0, 0,
        doc: /* Return the current buffer's recorded visited file modification time.
@@ -5800,6 +5995,8 @@ init_fileio (void)
 void
 syms_of_fileio (void)
 {
+  int i;
+
 #include "fileio.x"
 
   DEFSYM (Qoperations, "operations");
@@ -5922,6 +6119,18 @@ primitive to handle the operation \"the usual way\".
 See Info node `(elisp)Magic File Names' for more details.  */);
   Vfile_name_handler_alist = Qnil;
 
+  handler_regexps = Qnil;
+  staticpro (&handler_regexps);
+  for (i = 0; i < HANDLER_MATCH_CACHE_SIZE; i++)
+    {
+      handler_matches[i].filename = Qnil;
+      handler_matches[i].syntax_table = Qnil;
+      handler_matches[i].positions = Qnil;
+      staticpro (&handler_matches[i].filename);
+      staticpro (&handler_matches[i].syntax_table);
+      staticpro (&handler_matches[i].positions);
+    }
+
   DEFVAR_LISP ("set-auto-coding-function",
 	       Vset_auto_coding_function,
 	       doc: /* If non-nil, a function to call to decide a coding system of file.
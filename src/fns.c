@@ -45,6 +45,7 @@ static Lisp_Object Qprovide, Qrequire;
 static Lisp_Object Qyes_or_no_p_history;
 Lisp_Object Qcursor_in_echo_area;
 static Lisp_Object Qwidget_type;
+Lisp_Object Qstring_builder, Qstring_builder_p;
 static Lisp_Object Qcodeset, Qdays, Qmonths, Qpaper;
 
 static Lisp_Object Qmd5, Qsha1, Qsha224, Qsha256, Qsha384, Qsha512;
@@ -439,6 +440,45 @@ struct textprop_rec
   ptrdiff_t to;			/* refer to VAL (the target string) */
 };
 
+/* Return the concatenation of ARGS if they are all strings of the
+   same multibyteness without text properties, or nil otherwise.  Such
+   strings need no conversion, so the result is sized in one pass and
+   filled by memcpy.  */
+
+static Lisp_Object
+concat_plain_strings (ptrdiff_t nargs, Lisp_Object *args)
+{
+  ptrdiff_t i, nchars = 0, nbytes = 0;
+  bool multibyte;
+  unsigned char *p;
+  Lisp_Object val;
+
+  if (nargs == 0 || !STRINGP (args[0]))
+    return Qnil;
+  multibyte = STRING_MULTIBYTE (args[0]);
+  for (i = 0; i < nargs; i++)
+    {
+      Lisp_Object this = args[i];
+      if (!STRINGP (this) || STRING_MULTIBYTE (this) != multibyte
+	  || string_intervals (this))
+	return Qnil;
+      if (STRING_BYTES_BOUND - nbytes < SBYTES (this))
+	string_overflow ();
+      nchars += SCHARS (this);
+      nbytes += SBYTES (this);
+    }
+
+  val = (multibyte
+	 ? make_uninit_multibyte_string (nchars, nbytes)
+	 : make_uninit_string (nchars));
+  for (p = SDATA (val), i = 0; i < nargs; i++)
+    {
+      memcpy (p, SDATA (args[i]), SBYTES (args[i]));
+      p += SBYTES (args[i]);
+    }
+  return val;
+}
+
 static Lisp_Object
 concat (ptrdiff_t nargs, Lisp_Object *args,
 	enum concat_target_type target_type, bool last_special)
@@ -464,6 +504,13 @@ concat (ptrdiff_t nargs, Lisp_Object *args,
   ptrdiff_t num_textprops = 0;
   USE_SAFE_ALLOCA;
 
+  if (target_type == concat_string)
+    {
+      val = concat_plain_strings (nargs, args);
+      if (!NILP (val))
+	return val;
+    }
+
   tail = Qnil;
 
   /* In append, the last arg isn't treated like the others */
@@ -1074,22 +1121,41 @@ an error is signaled.  */)
   return string;
 }
 
+/* The Guile string kept in a Lisp string is shared through
+   substring/copy, which copies the text only when one side writes to
+   it.  Repeated crossings of an unchanged string thus cost nothing.  */
+
 DEFUN ("string-to-scheme", Fstring_to_scheme, Sstring_to_scheme, 1, 1, 0, 0)
   (Lisp_Object string)
 {
+  struct Lisp_String *s;
+
   CHECK_STRING (string);
-  return scm_from_utf8_stringn (SSDATA (string), SBYTES (string));
+  s = XSTRING (string);
+  if (!s->scheme)
+    s->scheme = scm_from_utf8_stringn (SSDATA (string), SBYTES (string));
+  return scm_c_substring_copy (s->scheme, 0,
+			       scm_c_string_length (s->scheme));
 }
 
 DEFUN ("string-from-scheme", Fstring_from_scheme, Sstring_from_scheme, 1, 1, 0, 0)
   (Lisp_Object string)
 {
   char *s;
-  size_t lenp;
+  size_t nchars, nbytes;
+  Lisp_Object val;
 
-  CHECK_STRING (string);
-  s = scm_to_utf8_stringn (string, &lenp);
-  return make_string (s, lenp);
+  if (!scm_is_string (string))
+    wrong_type_argument (Qstringp, string);
+  nchars = scm_c_string_length (string);
+  s = scm_to_utf8_stringn (string, &nbytes);
+  /* Characters of Guile are Unicode, whose UTF-8 is also the internal
+     representation of Emacs.  */
+  val = make_specified_string (s, nchars, nbytes, nchars != nbytes);
+  free (s);
+  if (nbytes)
+    XSTRING (val)->scheme = scm_c_substring_copy (string, 0, nchars);
+  return val;
 }
 
 DEFUN ("copy-alist", Fcopy_alist, Scopy_alist, 1, 1, 0,
@@ -1800,34 +1866,136 @@ See also the function `nreverse', which is used more often.  */)
   return new;
 }
 
-DEFUN ("sort", Fsort, Ssort, 2, 2, 0,
-       doc: /* Sort LIST, stably, comparing elements using PREDICATE.
-Returns the sorted list.  LIST is modified by side effects.
-PREDICATE is called with two elements of LIST, and should return non-nil
-if the first element should sort before the second.  */)
-  (Lisp_Object list, Lisp_Object predicate)
-{
-  Lisp_Object front, back;
-  register Lisp_Object len, tem;
-  struct gcpro gcpro1, gcpro2;
-  EMACS_INT length;
+/* The definitions of `<' and `string-lessp' when Emacs started, so
+   that sort can tell whether PREDICATE is one of them.  */
+static Lisp_Object sort_lss_function, sort_string_lessp_function;
 
-  front = list;
-  len = Flength (list);
-  length = XINT (len);
-  if (length < 2)
-    return list;
+enum sort_predicate { SORT_CALL, SORT_LSS, SORT_STRING_LESSP };
 
-  XSETINT (len, (length / 2) - 1);
-  tem = Fnthcdr (len, list);
-  back = Fcdr (tem);
-  Fsetcdr (tem, Qnil);
+/* Length of the runs that sort_vector_1 sorts by insertion before it
+   starts merging.  */
+enum { SORT_RUN = 16 };
 
-  GCPRO2 (front, back);
-  front = Fsort (front, predicate);
-  back = Fsort (back, predicate);
-  UNGCPRO;
-  return merge (front, back, predicate);
+static enum sort_predicate
+sort_predicate_kind (Lisp_Object predicate)
+{
+  Lisp_Object fn = (SYMBOLP (predicate) ? indirect_function (predicate)
+		    : predicate);
+
+  if (EQ (fn, sort_lss_function))
+    return SORT_LSS;
+  if (EQ (fn, sort_string_lessp_function))
+    return SORT_STRING_LESSP;
+  return SORT_CALL;
+}
+
+/* Return true if A sorts before B under PREDICATE, whose kind is KIND.
+   The common predicates are applied directly, without a funcall.  */
+
+static bool
+sort_less (Lisp_Object predicate, enum sort_predicate kind,
+	   Lisp_Object a, Lisp_Object b)
+{
+  switch (kind)
+    {
+    case SORT_LSS:
+      if (INTEGERP (a) && INTEGERP (b))
+	return XINT (a) < XINT (b);
+      return !NILP (arithcompare (a, b, ARITH_LESS));
+    case SORT_STRING_LESSP:
+      return !NILP (Fstring_lessp (a, b));
+    default:
+      return !NILP (call2 (predicate, a, b));
+    }
+}
+
+/* Sort the N elements at VEC stably, comparing them with PREDICATE.
+   Short runs are sorted by insertion, and then merged bottom-up.  */
+
+static void
+sort_vector_1 (Lisp_Object *vec, ptrdiff_t n, Lisp_Object predicate)
+{
+  enum sort_predicate kind = sort_predicate_kind (predicate);
+  ptrdiff_t lo, mid, hi, i, j, k, width;
+  Lisp_Object *tmp, x;
+  USE_SAFE_ALLOCA;
+
+  for (lo = 0; lo < n; lo += SORT_RUN)
+    {
+      hi = min (lo + SORT_RUN, n);
+      for (i = lo + 1; i < hi; i++)
+	{
+	  x = vec[i];
+	  for (j = i; j > lo && sort_less (predicate, kind, x, vec[j - 1]); j--)
+	    vec[j] = vec[j - 1];
+	  vec[j] = x;
+	}
+    }
+
+  if (n <= SORT_RUN)
+    return;
+
+  SAFE_ALLOCA_LISP (tmp, n);
+  for (width = SORT_RUN; width < n; width *= 2)
+    for (lo = 0; lo < n - width; lo += 2 * width)
+      {
+	mid = lo + width;
+	hi = min (lo + 2 * width, n);
+
+	/* Nothing to do if the two runs are already in order.  */
+	if (!sort_less (predicate, kind, vec[mid], vec[mid - 1]))
+	  continue;
+
+	/* Merge from a copy of the left run; the output never
+	   overtakes the unread part of the right run.  */
+	memcpy (tmp + lo, vec + lo, (mid - lo) * word_size);
+	i = lo, j = mid, k = lo;
+	while (i < mid && j < hi)
+	  vec[k++] = (sort_less (predicate, kind, vec[j], tmp[i])
+		      ? vec[j++] : tmp[i++]);
+	while (i < mid)
+	  vec[k++] = tmp[i++];
+      }
+  SAFE_FREE ();
+}
+
+/* Sort LIST by copying its elements to a vector, sorting that, and
+   storing them back into the same conses in order.  */
+
+static void
+sort_list (Lisp_Object list, Lisp_Object predicate)
+{
+  ptrdiff_t length = XFASTINT (Flength (list)), i;
+  Lisp_Object *vec, tail;
+  USE_SAFE_ALLOCA;
+
+  if (length < 2)
+    return;
+
+  SAFE_ALLOCA_LISP (vec, length);
+  for (i = 0, tail = list; i < length; i++, tail = XCDR (tail))
+    vec[i] = XCAR (tail);
+  sort_vector_1 (vec, length, predicate);
+  for (i = 0, tail = list; i < length; i++, tail = XCDR (tail))
+    XSETCAR (tail, vec[i]);
+  SAFE_FREE ();
+}
+
+DEFUN ("sort", Fsort, Ssort, 2, 2, 0,
+       doc: /* Sort SEQ, stably, comparing elements using PREDICATE.
+Returns the sorted sequence.  SEQ should be a list or vector.  SEQ is
+modified by side effects.  PREDICATE is called with two elements of
+SEQ, and should return non-nil if the first element should sort before
+the second.  */)
+  (Lisp_Object seq, Lisp_Object predicate)
+{
+  if (CONSP (seq))
+    sort_list (seq, predicate);
+  else if (VECTORP (seq))
+    sort_vector_1 (XVECTOR (seq)->contents, ASIZE (seq), predicate);
+  else if (!NILP (seq))
+    wrong_type_argument (Qsequencep, seq);
+  return seq;
 }
 
 Lisp_Object
@@ -2175,6 +2343,7 @@ ARRAY is a vector, string, char-table, or bool-vector.  */)
       CHECK_CHARACTER (item);
       charval = XFASTINT (item);
       size = SCHARS (array);
+      string_text_changed (array);
       if (STRING_MULTIBYTE (array))
 	{
 	  unsigned char str[MAX_MULTIBYTE_LENGTH];
@@ -2381,6 +2550,173 @@ SEQUENCE may be a list, a vector, a bool-vector, or a string.  */)
   return ret;
 }
 
+/* String builders.  A builder holds text in a byte buffer that grows
+   geometrically, so appending is amortized O(1) per byte and the text
+   is copied once more when the string is made.  */
+
+/* Make room for NBYTES more bytes in builder B.  */
+
+static void
+string_builder_reserve (struct Lisp_String_Builder *b, ptrdiff_t nbytes)
+{
+  ptrdiff_t room = b->size - b->nbytes;
+  if (room < nbytes)
+    b->data = xpalloc (b->data, &b->size, nbytes - room,
+		       STRING_BYTES_BOUND, 1);
+}
+
+/* Append NCHARS characters in NBYTES bytes at P to builder B.  P holds
+   multibyte text if MULTIBYTE, otherwise unibyte text.  Converting as
+   needed, B's text stays unibyte until multibyte text is appended,
+   just as `concat' would decide.  */
+
+void
+string_builder_append (struct Lisp_String_Builder *b,
+		       const unsigned char *p, ptrdiff_t nchars,
+		       ptrdiff_t nbytes, bool multibyte)
+{
+  if (multibyte && !b->multibyte)
+    {
+      /* Convert the text so far; a no-op if it is all ASCII.  */
+      ptrdiff_t size = count_size_as_multibyte (b->data, b->nbytes);
+      if (size != b->nbytes)
+	{
+	  unsigned char *data = xmalloc_atomic (size + nbytes);
+	  copy_text (b->data, data, b->nbytes, 0, 1);
+	  xfree (b->data);
+	  b->data = data;
+	  b->size = size + nbytes;
+	  b->nbytes = size;
+	}
+      b->multibyte = true;
+    }
+
+  if (!multibyte && b->multibyte)
+    {
+      ptrdiff_t size = count_size_as_multibyte (p, nbytes);
+      string_builder_reserve (b, size);
+      copy_text (p, b->data + b->nbytes, nbytes, 0, 1);
+      nbytes = size;
+    }
+  else
+    {
+      string_builder_reserve (b, nbytes);
+      memcpy (b->data + b->nbytes, p, nbytes);
+    }
+  b->nchars += nchars;
+  b->nbytes += nbytes;
+}
+
+/* Append the text of STRING to builder B.  */
+
+void
+string_builder_append_string (struct Lisp_String_Builder *b,
+			      Lisp_Object string)
+{
+  string_builder_append (b, SDATA (string), SCHARS (string), SBYTES (string),
+			 STRING_MULTIBYTE (string));
+}
+
+DEFUN ("make-string-builder", Fmake_string_builder, Smake_string_builder,
+       0, 0, 0,
+       doc: /* Return a new, empty string builder.
+Use `string-builder-append', or print to the builder with `princ' and
+friends, to add text to it, and `string-builder-string' to get the
+text as a string.  Accumulating output this way takes time
+proportional to its length, unlike repeated calls to `concat'.  Text
+properties are not kept.  */)
+  (void)
+{
+  struct Lisp_String_Builder *b
+    = ALLOCATE_PSEUDOVECTOR (struct Lisp_String_Builder, nchars,
+			     PVEC_STRING_BUILDER);
+  Lisp_Object builder;
+
+  b->nchars = b->nbytes = 0;
+  b->size = 64;
+  b->data = xmalloc_atomic (b->size);
+  b->multibyte = false;
+  XSETSTRING_BUILDER (builder, b);
+  return builder;
+}
+
+DEFUN ("string-builder-p", Fstring_builder_p, Sstring_builder_p, 1, 1, 0,
+       doc: /* Return t if OBJECT is a string builder.  */)
+  (Lisp_Object object)
+{
+  return STRING_BUILDER_P (object) ? Qt : Qnil;
+}
+
+DEFUN ("string-builder-append", Fstring_builder_append,
+       Sstring_builder_append, 1, MANY, 0,
+       doc: /* Append each of OBJECTS to string builder BUILDER.
+Each of OBJECTS must be a string or a character.  Return BUILDER.
+usage: (string-builder-append BUILDER &rest OBJECTS)  */)
+  (ptrdiff_t nargs, Lisp_Object *args)
+{
+  struct Lisp_String_Builder *b;
+  ptrdiff_t i;
+
+  CHECK_STRING_BUILDER (args[0]);
+  b = XSTRING_BUILDER (args[0]);
+  for (i = 1; i < nargs; i++)
+    {
+      Lisp_Object obj = args[i];
+      if (CHARACTERP (obj))
+	{
+	  int c = XFASTINT (obj);
+	  unsigned char str[MAX_MULTIBYTE_LENGTH];
+
+	  if (ASCII_CHAR_P (c) || CHAR_BYTE8_P (c))
+	    {
+	      str[0] = CHAR_TO_BYTE8 (c);
+	      string_builder_append (b, str, 1, 1, false);
+	    }
+	  else
+	    string_builder_append (b, str, 1, CHAR_STRING (c, str), true);
+	}
+      else
+	{
+	  CHECK_STRING (obj);
+	  string_builder_append_string (b, obj);
+	}
+    }
+  return args[0];
+}
+
+DEFUN ("string-builder-length", Fstring_builder_length,
+       Sstring_builder_length, 1, 1, 0,
+       doc: /* Return the number of characters in string builder BUILDER.  */)
+  (Lisp_Object builder)
+{
+  CHECK_STRING_BUILDER (builder);
+  return make_number (XSTRING_BUILDER (builder)->nchars);
+}
+
+DEFUN ("string-builder-string", Fstring_builder_string,
+       Sstring_builder_string, 1, 2, 0,
+       doc: /* Return the text in string builder BUILDER as a new string.
+If RESET is non-nil, also empty BUILDER.  */)
+  (Lisp_Object builder, Lisp_Object reset)
+{
+  struct Lisp_String_Builder *b;
+  Lisp_Object val;
+
+  CHECK_STRING_BUILDER (builder);
+  b = XSTRING_BUILDER (builder);
+  val = (b->multibyte
+	 ? make_uninit_multibyte_string (b->nchars, b->nbytes)
+	 : make_uninit_string (b->nchars));
+  memcpy (SDATA (val), b->data, b->nbytes);
+
+  if (!NILP (reset))
+    {
+      b->nchars = b->nbytes = 0;
+      b->multibyte = false;
+    }
+  return val;
+}
+
 DEFUN ("mapcar", Fmapcar, Smapcar, 2, 2, 0,
        doc: /* Apply FUNCTION to each element of SEQUENCE, and make a list of the results.
 The result is a list just as long as SEQUENCE.
@@ -2968,7 +3304,7 @@ into shorter lines.  */)
   encoded = SAFE_ALLOCA (allength);
   encoded_length = base64_encode_1 ((char *) BYTE_POS_ADDR (ibeg),
 				    encoded, length, NILP (no_line_break),
-				    !NILP (BVAR (current_buffer, enable_multibyte_characters)));
+				    length != XFASTINT (end) - XFASTINT (beg));
   if (encoded_length > allength)
     emacs_abort ();
 
@@ -3024,7 +3360,7 @@ into shorter lines.  */)
 
   encoded_length = base64_encode_1 (SSDATA (string),
 				    encoded, length, NILP (no_line_break),
-				    STRING_MULTIBYTE (string));
+				    SCHARS (string) != length);
   if (encoded_length > allength)
     emacs_abort ();
 
@@ -3041,6 +3377,54 @@ into shorter lines.  */)
   return encoded_string;
 }
 
+/* Encode the LENGTH unibyte bytes at FROM into TO, as base64_encode_1
+   does, but a whole line of triplets at a time, with no per-character
+   checks.  */
+
+static ptrdiff_t
+base64_encode_unibyte (const unsigned char *from, char *to,
+		       ptrdiff_t length, bool line_break)
+{
+  /* The number of input bytes that make up one output line.  */
+  ptrdiff_t line_bytes = (line_break
+			  ? MIME_LINE_LENGTH / 4 * 3
+			  : length / 3 * 3 + 3);
+  ptrdiff_t i = 0;
+  char *e = to;
+  unsigned int value;
+
+  while (length - i >= 3)
+    {
+      ptrdiff_t end = i + min (line_bytes, (length - i) / 3 * 3);
+
+      if (i > 0)
+	*e++ = '\n';
+      for (; i < end; i += 3, e += 4)
+	{
+	  value = from[i] << 16 | from[i + 1] << 8 | from[i + 2];
+	  e[0] = base64_value_to_char[value >> 18];
+	  e[1] = base64_value_to_char[0x3f & value >> 12];
+	  e[2] = base64_value_to_char[0x3f & value >> 6];
+	  e[3] = base64_value_to_char[0x3f & value];
+	}
+    }
+
+  /* A final partial triplet starts a new line if the last one is full.  */
+  if (i < length)
+    {
+      if (i > 0 && i % line_bytes == 0)
+	*e++ = '\n';
+      value = from[i] << 16 | (i + 1 < length ? from[i + 1] << 8 : 0);
+      e[0] = base64_value_to_char[value >> 18];
+      e[1] = base64_value_to_char[0x3f & value >> 12];
+      e[2] = i + 1 < length ? base64_value_to_char[0x3f & value >> 6] : '=';
+      e[3] = '=';
+      e += 4;
+    }
+
+  return e - to;
+}
+
 static ptrdiff_t
 base64_encode_1 (const char *from, char *to, ptrdiff_t length,
 		 bool line_break, bool multibyte)
@@ -3052,6 +3436,10 @@ base64_encode_1 (const char *from, char *to, ptrdiff_t length,
   unsigned int value;
   int bytes;
 
+  if (!multibyte)
+    return base64_encode_unibyte ((const unsigned char *) from, to, length,
+				  line_break);
+
   while (i < length)
     {
       if (multibyte)
@@ -3251,6 +3639,35 @@ base64_decode_1 (const char *from, char *to, ptrdiff_t length,
 
   while (1)
     {
+      /* Decode whole quadruplets in bulk until one has whitespace,
+	 padding or something invalid in it, and leave that one to the
+	 general code below.  */
+      while (length - i >= 4)
+	{
+	  unsigned char c0 = from[i], c1 = from[i + 1];
+	  unsigned char c2 = from[i + 2], c3 = from[i + 3];
+	  int k;
+
+	  if ((c0 | c1 | c2 | c3) & 0x80
+	      || (base64_char_to_value[c0] | base64_char_to_value[c1]
+		  | base64_char_to_value[c2] | base64_char_to_value[c3]) < 0)
+	    break;
+	  value = (base64_char_to_value[c0] << 18
+		   | base64_char_to_value[c1] << 12
+		   | base64_char_to_value[c2] << 6
+		   | base64_char_to_value[c3]);
+	  i += 4;
+	  for (k = 16; k >= 0; k -= 8)
+	    {
+	      c = 0xff & value >> k;
+	      if (multibyte && c >= 128)
+		e += BYTE8_STRING (c, e);
+	      else
+		*e++ = c;
+	    }
+	  nchars += 3;
+	}
+
       /* Process first byte of a quadruplet. */
 
       READ_QUADRUPLET_BYTE (e-to);
@@ -3318,81 +3735,365 @@ base64_decode_1 (const char *from, char *to, ptrdiff_t length,
     }
 }
 
+/* Hexl dump functions, in the format of lib-src/hexl.c.  Each line
+   shows 16 bytes: the address of the first, the bytes in hex with a
+   space after each group, and the bytes as text.  */
 
-
-/***********************************************************************
- *****                                                             *****
- *****			     Hash Tables                           *****
- *****                                                             *****
- ***********************************************************************/
+static const char hexl_digits[16] = "0123456789abcdef";
 
-/* Implemented by gerd@gnu.org.  This hash table implementation was
-   inspired by CMUCL hash tables.  */
+/* Return the mask of byte indexes within a group of GROUP bytes.  */
 
-/* Ideas:
+static int
+hexl_group_mask (Lisp_Object group)
+{
+  if (NILP (group))
+    return 1;
+  CHECK_NUMBER (group);
+  if (XINT (group) != 1 && XINT (group) != 2
+      && XINT (group) != 4 && XINT (group) != 8)
+    error ("Invalid hexl group size: %"pI"d", XINT (group));
+  return XINT (group) - 1;
+}
 
-   1. For small tables, association lists are probably faster than
-   hash tables because they have lower overhead.
+/* Write the hexl dump of the LENGTH bytes of text at FROM into TO,
+   grouping the bytes as in GROUP_MASK.  If MULTIBYTE, the text is
+   multibyte and so is the dump.  If ISO, show the characters of ISO
+   8859 as text.  Store the number of characters written in *NCHARS.
+   Return the number of bytes written, or -1 if the text has a
+   character that is not a byte.  TO needs room for HEXL_LINE_BYTES
+   for every 16 bytes at FROM, and for one more line.  */
 
-   For uses of hash tables where the O(1) behavior of table
-   operations is not a requirement, it might therefore be a good idea
-   not to hash.  Instead, we could just do a linear search in the
-   key_and_value vector of the hash table.  This could be done
-   if a `:linear-search t' argument is given to make-hash-table.  */
+#define HEXL_LINE_BYTES (2 * sizeof (EMACS_UINT) + 2 + 3 * 16 + 1 + 2 * 16 + 1)
 
-/* Various symbols.  */
+static ptrdiff_t
+hexl_encode_1 (const unsigned char *from, char *to, ptrdiff_t length,
+	       int group_mask, bool multibyte, bool iso,
+	       ptrdiff_t *nchars)
+{
+  char *e = to;
+  ptrdiff_t i = 0, n = 0;
+  EMACS_UINT address = 0;
+  unsigned char line[16];
 
-static Lisp_Object Qhash_table_p;
-static Lisp_Object Qkey, Qvalue, Qeql;
-Lisp_Object Qeq, Qequal;
-Lisp_Object QCtest, QCsize, QCrehash_size, QCrehash_threshold, QCweakness;
-static Lisp_Object Qhash_table_test, Qkey_or_value, Qkey_and_value;
+  while (i < length)
+    {
+      int j, count, digits;
+      EMACS_UINT a;
 
-
-/***********************************************************************
-			       Utilities
- ***********************************************************************/
+      for (count = 0; count < 16 && i < length; count++)
+	{
+	  int c;
 
-static void
-CHECK_HASH_TABLE (Lisp_Object x)
-{
-  CHECK_TYPE (HASH_TABLE_P (x), Qhash_table_p, x);
-}
+	  if (multibyte)
+	    {
+	      int bytes;
+	      c = STRING_CHAR_AND_LENGTH (from + i, bytes);
+	      if (CHAR_BYTE8_P (c))
+		c = CHAR_TO_BYTE8 (c);
+	      else if (c >= 256)
+		return -1;
+	      i += bytes;
+	    }
+	  else
+	    c = from[i++];
+	  line[count] = c;
+	}
 
-static void
-set_hash_key_and_value (struct Lisp_Hash_Table *h, Lisp_Object key_and_value)
-{
-  h->key_and_value = key_and_value;
+      /* The address, in at least 8 digits.  */
+      for (digits = 8, a = address >> 31 >> 1; a; a >>= 4)
+	digits++;
+      for (j = digits - 1; j >= 0; j--)
+	*e++ = hexl_digits[(address >> (4 * j)) & 0xf];
+      *e++ = ':';
+      *e++ = ' ';
+      n += digits + 2;
+
+      for (j = 0; j < 16; j++)
+	{
+	  if (j < count)
+	    {
+	      *e++ = hexl_digits[line[j] >> 4];
+	      *e++ = hexl_digits[line[j] & 0xf];
+	    }
+	  else
+	    {
+	      *e++ = ' ';
+	      *e++ = ' ';
+	    }
+	  n += 2;
+	  if ((j & group_mask) == group_mask)
+	    {
+	      *e++ = ' ';
+	      n++;
+	    }
+	}
+
+      *e++ = ' ';
+      n++;
+      for (j = 0; j < count; j++)
+	{
+	  int c = line[j];
+
+	  if (c < 0x20 || (c >= 0x7f && (!iso || c < 0xa0)))
+	    *e++ = '.';
+	  else if (c >= 0x80 && multibyte)
+	    e += BYTE8_STRING (c, e);
+	  else
+	    *e++ = c;
+	}
+      *e++ = '\n';
+      n += count + 1;
+      address += 16;
+    }
+
+  *nchars = n;
+  return e - to;
 }
-static void
-set_hash_next (struct Lisp_Hash_Table *h, Lisp_Object next)
+
+/* Return the value of the hex digit C, or -1 if it is not one.  */
+
+static int
+hexl_digit_value (int c)
 {
-  h->next = next;
+  return ('0' <= c && c <= '9' ? c - '0'
+	  : 'a' <= c && c <= 'f' ? c - 'a' + 10
+	  : 'A' <= c && c <= 'F' ? c - 'A' + 10
+	  : -1);
 }
-static void
-set_hash_next_slot (struct Lisp_Hash_Table *h, ptrdiff_t idx, Lisp_Object val)
+
+/* Read the bytes of the hexl dump of LENGTH bytes at FROM, grouped as
+   in GROUP_MASK, into TO.  If MULTIBYTE, write them in multibyte form
+   and store the number of characters in *NCHARS.  Return the number of
+   bytes written.  A line ends where its hex part does, so the last
+   line may be short; anything else that is not hex ends the dump, as
+   it does for lib-src/hexl.c.  TO needs room for LENGTH bytes.  */
+
+static ptrdiff_t
+hexl_decode_1 (const unsigned char *from, char *to, ptrdiff_t length,
+	       int group_mask, bool multibyte, ptrdiff_t *nchars)
 {
-  gc_aset (h->next, idx, val);
+  const unsigned char *p = from, *lim = from + length;
+  char *e = to;
+  ptrdiff_t n = 0;
+
+  /* Each line starts with 8 digits of address, a colon and a space.
+     Longer addresses come only after 4 GB, which a buffer cannot
+     hold.  */
+  while (lim - p >= 10)
+    {
+      int j;
+
+      p += 10;
+      for (j = 0; j < 16; j++)
+	{
+	  int hi, lo;
+
+	  if (lim - p < 2
+	      || (hi = hexl_digit_value (p[0])) < 0
+	      || (lo = hexl_digit_value (p[1])) < 0)
+	    break;
+	  p += 2;
+	  if (multibyte && hi >= 8)
+	    e += BYTE8_STRING (hi << 4 | lo, e);
+	  else
+	    *e++ = hi << 4 | lo;
+	  n++;
+	  if ((j & group_mask) == group_mask && p < lim)
+	    p++;
+	}
+      if (j < 16 && (p == lim || *p != ' '))
+	break;
+
+      /* Skip the text part.  */
+      p = memchr (p, '\n', lim - p);
+      if (!p)
+	break;
+      p++;
+    }
+
+  *nchars = n;
+  return e - to;
 }
-static void
-set_hash_hash (struct Lisp_Hash_Table *h, Lisp_Object hash)
+
+DEFUN ("hexl-encode-region", Fhexl_encode_region, Shexl_encode_region,
+       2, 4, 0,
+       doc: /* Replace the region between BEG and END with its hexl dump.
+The region should contain bytes, that is, ASCII and raw bytes.
+Optional third argument GROUP is the number of bytes per group in the
+hex part of the dump: 1, 2, 4 or 8; nil means 2.  Optional fourth
+argument ISO non-nil means show the ISO 8859 characters from 160 to
+255 as text rather than as dots.  This makes the same dump as the
+`hexl' program.  Return the length of the dump.  */)
+  (Lisp_Object beg, Lisp_Object end, Lisp_Object group, Lisp_Object iso)
 {
-  h->hash = hash;
-}
-static void
-set_hash_hash_slot (struct Lisp_Hash_Table *h, ptrdiff_t idx, Lisp_Object val)
+  char *encoded;
+  ptrdiff_t allength, length, lines;
+  ptrdiff_t ibeg, iend, encoded_length, encoded_chars;
+  ptrdiff_t old_pos = PT;
+  bool multibyte = !NILP (BVAR (current_buffer, enable_multibyte_characters));
+  int group_mask = hexl_group_mask (group);
+  USE_SAFE_ALLOCA;
+
+  validate_region (&beg, &end);
+
+  ibeg = CHAR_TO_BYTE (XFASTINT (beg));
+  iend = CHAR_TO_BYTE (XFASTINT (end));
+  move_gap_both (XFASTINT (beg), ibeg);
+
+  length = iend - ibeg;
+  lines = length / 16 + 1;
+  if (min (PTRDIFF_MAX, SIZE_MAX) / HEXL_LINE_BYTES < lines)
+    memory_full (SIZE_MAX);
+  allength = lines * HEXL_LINE_BYTES;
+
+  encoded = SAFE_ALLOCA (allength);
+  encoded_length = hexl_encode_1 (BYTE_POS_ADDR (ibeg), encoded, length,
+				  group_mask, multibyte, !NILP (iso),
+				  &encoded_chars);
+  if (encoded_length > allength)
+    emacs_abort ();
+
+  if (encoded_length < 0)
+    {
+      SAFE_FREE ();
+      error ("Multibyte character in data for hexl encoding");
+    }
+
+  /* Insert the dump first, to preserve markers.  */
+  TEMP_SET_PT_BOTH (XFASTINT (beg), ibeg);
+  insert_1_both (encoded, encoded_chars, encoded_length, 0, 1, 0);
+  SAFE_FREE ();
+  del_range_both (PT, PT_BYTE, XFASTINT (end) + encoded_chars,
+		  iend + encoded_length, 1);
+
+  /* If point was outside of the region, restore it exactly; else just
+     move to the beginning of the region.  */
+  if (old_pos >= XFASTINT (end))
+    old_pos += encoded_chars - (XFASTINT (end) - XFASTINT (beg));
+  else if (old_pos > XFASTINT (beg))
+    old_pos = XFASTINT (beg);
+  SET_PT (old_pos > ZV ? ZV : old_pos);
+
+  return make_number (encoded_chars);
+}
+
+DEFUN ("hexl-decode-region", Fhexl_decode_region, Shexl_decode_region,
+       2, 3, 0,
+       doc: /* Replace the hexl dump between BEG and END with its bytes.
+Optional third argument GROUP is the number of bytes per group in the
+dump, as for `hexl-encode-region'.  In a multibyte buffer, the bytes
+from 128 up are inserted as raw bytes.  Return the length of the
+decoded text.  */)
+  (Lisp_Object beg, Lisp_Object end, Lisp_Object group)
 {
-  gc_aset (h->hash, idx, val);
+  char *decoded;
+  ptrdiff_t allength, length;
+  ptrdiff_t ibeg, iend, decoded_length, decoded_chars;
+  ptrdiff_t old_pos = PT;
+  bool multibyte = !NILP (BVAR (current_buffer, enable_multibyte_characters));
+  int group_mask = hexl_group_mask (group);
+  USE_SAFE_ALLOCA;
+
+  validate_region (&beg, &end);
+
+  ibeg = CHAR_TO_BYTE (XFASTINT (beg));
+  iend = CHAR_TO_BYTE (XFASTINT (end));
+  move_gap_both (XFASTINT (beg), ibeg);
+
+  /* Every byte takes two hex digits, which is room enough for its
+     multibyte form.  */
+  length = iend - ibeg;
+  allength = length;
+  decoded = SAFE_ALLOCA (allength);
+  decoded_length = hexl_decode_1 (BYTE_POS_ADDR (ibeg), decoded, length,
+				  group_mask, multibyte, &decoded_chars);
+  if (decoded_length > allength)
+    emacs_abort ();
+
+  TEMP_SET_PT_BOTH (XFASTINT (beg), ibeg);
+  insert_1_both (decoded, decoded_chars, decoded_length, 0, 1, 0);
+  SAFE_FREE ();
+  del_range_both (PT, PT_BYTE, XFASTINT (end) + decoded_chars,
+		  iend + decoded_length, 1);
+
+  if (old_pos >= XFASTINT (end))
+    old_pos += decoded_chars - (XFASTINT (end) - XFASTINT (beg));
+  else if (old_pos > XFASTINT (beg))
+    old_pos = XFASTINT (beg);
+  SET_PT (old_pos > ZV ? ZV : old_pos);
+
+  return make_number (decoded_chars);
+}
+
+
+\f
+/***********************************************************************
+ *****                                                             *****
+ *****			     Hash Tables                           *****
+ *****                                                             *****
+ ***********************************************************************/
+
+/* Implemented by gerd@gnu.org.  This hash table implementation was
+   inspired by CMUCL hash tables.  */
+
+/* Ideas:
+
+   1. For small tables, association lists are probably faster than
+   hash tables because they have lower overhead.
+
+   For uses of hash tables where the O(1) behavior of table
+   operations is not a requirement, it might therefore be a good idea
+   not to hash.  Instead, we could just do a linear search in the
+   key_and_value vector of the hash table.  This could be done
+   if a `:linear-search t' argument is given to make-hash-table.  */
+
+/* Various symbols.  */
+
+static Lisp_Object Qhash_table_p;
+static Lisp_Object Qkey, Qvalue, Qeql;
+Lisp_Object Qeq, Qequal;
+Lisp_Object QCtest, QCsize, QCrehash_size, QCrehash_threshold, QCweakness;
+static Lisp_Object Qhash_table_test, Qkey_or_value, Qkey_and_value;
+static Lisp_Object QCconcurrency, Qread_mostly;
+
+
+/***********************************************************************
+			       Utilities
+ ***********************************************************************/
+
+static void
+CHECK_HASH_TABLE (Lisp_Object x)
+{
+  CHECK_TYPE (HASH_TABLE_P (x), Qhash_table_p, x);
 }
+
 static void
-set_hash_index (struct Lisp_Hash_Table *h, Lisp_Object index)
+set_hash_key_and_value (struct Lisp_Hash_Table *h, Lisp_Object key_and_value)
 {
-  h->index = index;
+  h->key_and_value = key_and_value;
+  gc_write_barrier (h);
 }
 static void
-set_hash_index_slot (struct Lisp_Hash_Table *h, ptrdiff_t idx, Lisp_Object val)
+set_hash_next (struct Lisp_Hash_Table *h, Lisp_Object next)
 {
-  gc_aset (h->index, idx, val);
+  h->next = next;
+  gc_write_barrier (h);
+}
+static void
+set_hash_next_slot (struct Lisp_Hash_Table *h, ptrdiff_t idx, Lisp_Object val)
+{
+  gc_aset (h->next, idx, val);
+}
+static void
+set_hash_hash (struct Lisp_Hash_Table *h, Lisp_Object hash)
+{
+  h->hash = hash;
+  gc_write_barrier (h);
+}
+static void
+set_hash_hash_slot (struct Lisp_Hash_Table *h, ptrdiff_t idx, Lisp_Object val)
+{
+  gc_aset (h->hash, idx, val);
 }
 
 /* If OBJ is a Lisp hash table, return a pointer to its struct
@@ -3478,7 +4179,7 @@ larger_vector (Lisp_Object vec, ptrdiff_t incr_min, ptrdiff_t nitems_max)
 			 Low-level Functions
  ***********************************************************************/
 
-static struct hash_table_test hashtest_eq;
+struct hash_table_test hashtest_eq;
 struct hash_table_test hashtest_eql, hashtest_equal;
 
 /* Compare KEY1 which has hash code HASH1 and KEY2 with hash code
@@ -3554,7 +4255,7 @@ hashfn_eql (struct hash_table_test *ht, Lisp_Object key)
 static EMACS_UINT
 hashfn_equal (struct hash_table_test *ht, Lisp_Object key)
 {
-  return scm_ihash (key, MOST_POSITIVE_FIXNUM);
+  return sxhash (key, 0);
 }
 
 /* Value is a hash code for KEY for use in hash table H which uses as
@@ -3577,6 +4278,202 @@ hashfn_user_defined (struct hash_table_test *ht, Lisp_Object key)
 #define INDEX_SIZE_BOUND \
   ((ptrdiff_t) min (MOST_POSITIVE_FIXNUM, PTRDIFF_MAX / word_size))
 
+/* Return the number of bits of a probe index for a table of SIZE
+   entries.  Keeping the index at least twice the table size bounds
+   the load factor by 1/2, so probe sequences stay short and an empty
+   slot always exists.  */
+
+static int
+probe_bits_for_size (ptrdiff_t size)
+{
+  int bits = 1;
+  while (((ptrdiff_t) 1 << bits) < 2 * size)
+    bits++;
+  return bits;
+}
+
+/* Return the home slot of HASH in a probe index of 1 << BITS slots.
+   The hash functions for `eq' and `eql' return object addresses,
+   whose low bits are mostly zero, so scramble with a Fibonacci
+   multiplier and take the high bits.  */
+
+static ptrdiff_t
+probe_home (int bits, EMACS_UINT hash)
+{
+  return (uint64_t) hash * 0x9e3779b97f4a7c15u >> (64 - bits);
+}
+
+/* Allocate an empty probe index sized for SIZE entries in H.  */
+
+static void
+alloc_hash_probe (struct Lisp_Hash_Table *h, ptrdiff_t size)
+{
+  h->probe_bits = probe_bits_for_size (size);
+  h->probe = xzalloc_atomic (sizeof *h->probe << h->probe_bits);
+}
+
+/* Record entry I with hash code HASH in PROBE, of 1 << BITS slots.  */
+
+static void
+hash_probe_insert (ptrdiff_t *probe, int bits, ptrdiff_t i, EMACS_UINT hash)
+{
+  ptrdiff_t mask = ((ptrdiff_t) 1 << bits) - 1;
+  ptrdiff_t slot = probe_home (bits, hash);
+
+  while (probe[slot])
+    slot = (slot + 1) & mask;
+
+  /* Publish the slot only after the entry itself, for the sake of
+     hash_lookup_concurrent.  */
+  __atomic_store_n (&probe[slot], i + 1, __ATOMIC_RELEASE);
+}
+
+/* Empty SLOT of the probe index of H, shifting later members of its
+   probe run back so that lookups need no tombstones.  */
+
+static void
+hash_probe_delete (struct Lisp_Hash_Table *h, ptrdiff_t slot)
+{
+  int bits = h->probe_bits;
+  ptrdiff_t mask = ((ptrdiff_t) 1 << bits) - 1;
+  ptrdiff_t j;
+
+  h->probe[slot] = 0;
+  for (j = (slot + 1) & mask; h->probe[j]; j = (j + 1) & mask)
+    {
+      ptrdiff_t home
+	= probe_home (bits, XUINT (HASH_HASH (h, h->probe[j] - 1)));
+
+      /* The entry at J can fill the hole unless its home lies
+	 cyclically in (SLOT, J].  */
+      if (slot <= j ? (slot < home && home <= j) : (slot < home || home <= j))
+	continue;
+      h->probe[slot] = h->probe[j];
+      h->probe[j] = 0;
+      slot = j;
+    }
+}
+
+/* Return the slot of PROBE, of 1 << BITS slots, holding KEY, whose
+   hash code is HASH, in H, or -1 if KEY is not there.  Negative slots
+   are tombstones left in an old index by hash_remove_from_table.  */
+
+static ptrdiff_t
+hash_probe_find (struct Lisp_Hash_Table *h, ptrdiff_t *probe, int bits,
+		 Lisp_Object key, EMACS_UINT hash)
+{
+  ptrdiff_t mask = ((ptrdiff_t) 1 << bits) - 1;
+  ptrdiff_t slot = probe_home (bits, hash);
+  ptrdiff_t e;
+
+  while ((e = probe[slot]) != 0)
+    {
+      ptrdiff_t i = e - 1;
+      if (0 < e
+	  && (EQ (key, HASH_KEY (h, i))
+	      || (h->test.cmpfn
+		  && hash == XUINT (HASH_HASH (h, i))
+		  && h->test.cmpfn (&h->test, key, HASH_KEY (h, i)))))
+	return slot;
+      slot = (slot + 1) & mask;
+    }
+  return -1;
+}
+
+/* Move up to N slots of the old probe index of H, left behind by a
+   resize, into the current one.  Free the old index once all of it
+   has been moved.  A negative N means move everything.  */
+
+static void
+hash_migrate (struct Lisp_Hash_Table *h, ptrdiff_t n)
+{
+  ptrdiff_t old_slots;
+
+  if (!h->old_probe)
+    return;
+  old_slots = (ptrdiff_t) 1 << h->old_probe_bits;
+  for (; n != 0 && h->migrate_pos < old_slots; n--)
+    {
+      ptrdiff_t e = h->old_probe[h->migrate_pos++];
+      if (0 < e)
+	hash_probe_insert (h->probe, h->probe_bits, e - 1,
+			   XUINT (HASH_HASH (h, e - 1)));
+    }
+  if (h->migrate_pos == old_slots)
+    {
+      xfree (h->old_probe);
+      h->old_probe = NULL;
+    }
+}
+
+/* What hash_lookup_concurrent reads in a read-mostly table.  Writers
+   never modify an index or vectors once they have been replaced, so a
+   reader can finish with the snapshot it loaded; the garbage collector
+   reclaims old snapshots once no reader holds them.  */
+
+struct hash_snapshot
+{
+  ptrdiff_t *probe;
+  int probe_bits;
+  Lisp_Object key_and_value, hash;
+};
+
+/* Make the current index and vectors of read-mostly table H visible to
+   concurrent readers.  */
+
+static void
+publish_hash_snapshot (struct Lisp_Hash_Table *h)
+{
+  struct hash_snapshot *snap = xmalloc (sizeof *snap);
+  snap->probe = h->probe;
+  snap->probe_bits = h->probe_bits;
+  snap->key_and_value = h->key_and_value;
+  snap->hash = h->hash;
+  __atomic_store_n (&h->snapshot, snap, __ATOMIC_RELEASE);
+}
+
+/* Rebuild read-mostly table H with room for NEW_SIZE entries, which
+   must be at least its current size, in fresh vectors and a fresh
+   index.  Entries removed since the last rebuild are only now put
+   back on the free list, since readers of the old snapshot may still
+   be looking at them.  */
+
+static void
+rebuild_read_mostly_table (struct Lisp_Hash_Table *h, ptrdiff_t new_size)
+{
+  ptrdiff_t old_size = HASH_TABLE_SIZE (h);
+  Lisp_Object key_and_value, hash, next;
+  ptrdiff_t i;
+
+  key_and_value = Fmake_vector (make_number (2 * new_size), Qnil);
+  hash = Fmake_vector (make_number (new_size), Qnil);
+  next = Fmake_vector (make_number (new_size), Qnil);
+  for (i = 0; i < old_size; i++)
+    if (!NILP (HASH_HASH (h, i)))
+      {
+	ASET (key_and_value, 2 * i, HASH_KEY (h, i));
+	ASET (key_and_value, 2 * i + 1, HASH_VALUE (h, i));
+	ASET (hash, i, HASH_HASH (h, i));
+      }
+
+  set_hash_key_and_value (h, key_and_value);
+  set_hash_hash (h, hash);
+  set_hash_next (h, next);
+  h->next_free = Qnil;
+  for (i = new_size - 1; 0 <= i; i--)
+    if (NILP (HASH_HASH (h, i)))
+      {
+	set_hash_next_slot (h, i, h->next_free);
+	h->next_free = make_number (i);
+      }
+
+  alloc_hash_probe (h, new_size);
+  for (i = 0; i < old_size; i++)
+    if (!NILP (HASH_HASH (h, i)))
+      hash_probe_insert (h->probe, h->probe_bits, i, XUINT (HASH_HASH (h, i)));
+  publish_hash_snapshot (h);
+}
+
 /* Create and initialize a new hash table.
 
    TEST specifies the test the hash table will use to compare keys.
@@ -3606,9 +4503,8 @@ make_hash_table (struct hash_table_test test,
 {
   struct Lisp_Hash_Table *h;
   Lisp_Object table;
-  EMACS_INT index_size, sz;
+  EMACS_INT sz;
   ptrdiff_t i;
-  double index_float;
 
   /* Preconditions.  */
   eassert (SYMBOLP (test.name));
@@ -3623,11 +4519,7 @@ make_hash_table (struct hash_table_test test,
     size = make_number (1);
 
   sz = XFASTINT (size);
-  index_float = sz / XFLOAT_DATA (rehash_threshold);
-  index_size = (index_float < INDEX_SIZE_BOUND + 1
-		? next_almost_prime (index_float)
-		: INDEX_SIZE_BOUND + 1);
-  if (INDEX_SIZE_BOUND < max (index_size, 2 * sz))
+  if (INDEX_SIZE_BOUND / 2 < sz)
     error ("Hash table too large");
 
   /* Allocate a table and initialize it.  */
@@ -3642,7 +4534,11 @@ make_hash_table (struct hash_table_test test,
   h->key_and_value = Fmake_vector (make_number (2 * sz), Qnil);
   h->hash = Fmake_vector (size, Qnil);
   h->next = Fmake_vector (size, Qnil);
-  h->index = Fmake_vector (make_number (index_size), Qnil);
+  alloc_hash_probe (h, sz);
+  h->old_probe = NULL;
+  h->migrate_pos = h->migrate_step = 0;
+  h->read_mostly = false;
+  h->snapshot = NULL;
 
   /* Set up the free list.  */
   for (i = 0; i < sz - 1; ++i)
@@ -3666,12 +4562,16 @@ copy_hash_table (struct Lisp_Hash_Table *h1)
   Lisp_Object table;
   struct Lisp_Hash_Table *h2;
 
+  hash_migrate (h1, -1);
   h2 = allocate_hash_table ();
   *h2 = *h1;
   h2->key_and_value = Fcopy_sequence (h1->key_and_value);
   h2->hash = Fcopy_sequence (h1->hash);
   h2->next = Fcopy_sequence (h1->next);
-  h2->index = Fcopy_sequence (h1->index);
+  h2->probe = xmalloc_atomic (sizeof *h2->probe << h2->probe_bits);
+  memcpy (h2->probe, h1->probe, sizeof *h2->probe << h2->probe_bits);
+  if (h2->read_mostly)
+    publish_hash_snapshot (h2);
   XSET_HASH_TABLE (table, h2);
 
   return table;
@@ -3687,9 +4587,8 @@ maybe_resize_hash_table (struct Lisp_Hash_Table *h)
   if (NILP (h->next_free))
     {
       ptrdiff_t old_size = HASH_TABLE_SIZE (h);
-      EMACS_INT new_size, index_size, nsize;
+      EMACS_INT new_size;
       ptrdiff_t i;
-      double index_float;
 
       if (INTEGERP (h->rehash_size))
 	new_size = old_size + XFASTINT (h->rehash_size);
@@ -3705,14 +4604,18 @@ maybe_resize_hash_table (struct Lisp_Hash_Table *h)
 	  else
 	    new_size = INDEX_SIZE_BOUND + 1;
 	}
-      index_float = new_size / XFLOAT_DATA (h->rehash_threshold);
-      index_size = (index_float < INDEX_SIZE_BOUND + 1
-		    ? next_almost_prime (index_float)
-		    : INDEX_SIZE_BOUND + 1);
-      nsize = max (index_size, 2 * new_size);
-      if (INDEX_SIZE_BOUND < nsize)
+      if (INDEX_SIZE_BOUND / 2 < new_size)
 	error ("Hash table too large to resize");
 
+      /* A read-mostly table whose free list ran out mostly because of
+	 removals is rebuilt at the same size to reclaim them.  */
+      if (h->read_mostly)
+	{
+	  rebuild_read_mostly_table (h, (2 * h->count <= old_size
+					 ? old_size : new_size));
+	  return;
+	}
+
 #ifdef ENABLE_CHECKING
       if (HASH_TABLE_P (Vpurify_flag)
 	  && XHASH_TABLE (Vpurify_flag) == h)
@@ -3728,7 +4631,19 @@ maybe_resize_hash_table (struct Lisp_Hash_Table *h)
 						2 * (new_size - old_size), -1));
       set_hash_next (h, larger_vector (h->next, new_size - old_size, -1));
       set_hash_hash (h, larger_vector (h->hash, new_size - old_size, -1));
-      set_hash_index (h, Fmake_vector (make_number (index_size), Qnil));
+      /* Rather than rehashing every entry now, keep the old index
+	 and move it into the new one a few slots at a time from
+	 hash_put and hash_remove_from_table.  Entry numbers survive
+	 the resize, so lookups may consult either index meanwhile.
+	 The step is chosen so that the move is done by the time the
+	 new entries run out.  */
+      hash_migrate (h, -1);
+      h->old_probe = h->probe;
+      h->old_probe_bits = h->probe_bits;
+      h->migrate_pos = 0;
+      h->migrate_step = (((ptrdiff_t) 1 << h->old_probe_bits)
+			 / (new_size - old_size) + 1);
+      alloc_hash_probe (h, new_size);
 
       /* Update the free list.  Do it so that new entries are added at
          the end of the free list.  This makes some operations like
@@ -3749,16 +4664,6 @@ maybe_resize_hash_table (struct Lisp_Hash_Table *h)
 	}
       else
 	XSETFASTINT (h->next_free, old_size);
-
-      /* Rehash.  */
-      for (i = 0; i < old_size; ++i)
-	if (!NILP (HASH_HASH (h, i)))
-	  {
-	    EMACS_UINT hash_code = XUINT (HASH_HASH (h, i));
-	    ptrdiff_t start_of_bucket = hash_code % ASIZE (h->index);
-	    set_hash_next_slot (h, i, HASH_INDEX (h, start_of_bucket));
-	    set_hash_index_slot (h, start_of_bucket, make_number (i));
-	  }
     }
 }
 
@@ -3771,30 +4676,63 @@ ptrdiff_t
 hash_lookup (struct Lisp_Hash_Table *h, Lisp_Object key, EMACS_UINT *hash)
 {
   EMACS_UINT hash_code;
-  ptrdiff_t start_of_bucket;
-  Lisp_Object idx;
+  ptrdiff_t slot;
 
   hash_code = h->test.hashfn (&h->test, key);
   eassert ((hash_code & ~INTMASK) == 0);
   if (hash)
     *hash = hash_code;
 
-  start_of_bucket = hash_code % ASIZE (h->index);
-  idx = HASH_INDEX (h, start_of_bucket);
-
-  /* We need not gcpro idx since it's either an integer or nil.  */
-  while (!NILP (idx))
+  slot = hash_probe_find (h, h->probe, h->probe_bits, key, hash_code);
+  if (0 <= slot)
+    return h->probe[slot] - 1;
+  if (h->old_probe)
     {
-      ptrdiff_t i = XFASTINT (idx);
-      if (EQ (key, HASH_KEY (h, i))
-	  || (h->test.cmpfn
-	      && hash_code == XUINT (HASH_HASH (h, i))
-	      && h->test.cmpfn (&h->test, key, HASH_KEY (h, i))))
-	break;
-      idx = HASH_NEXT (h, i);
+      slot = hash_probe_find (h, h->old_probe, h->old_probe_bits,
+			      key, hash_code);
+      if (0 <= slot)
+	return h->old_probe[slot] - 1;
     }
+  return -1;
+}
+
+
+/* Lookup KEY in read-mostly hash table H from any thread, without
+   locking.  If found, store its value in *VALUE and return true.
+   H's test must not call Lisp, which make-hash-table ensures.  An
+   entry being added or removed concurrently may or may not be
+   seen.  */
 
-  return NILP (idx) ? -1 : XFASTINT (idx);
+bool
+hash_lookup_concurrent (struct Lisp_Hash_Table *h, Lisp_Object key,
+			Lisp_Object *value)
+{
+  struct hash_snapshot *snap
+    = __atomic_load_n (&h->snapshot, __ATOMIC_ACQUIRE);
+  EMACS_UINT hash_code = h->test.hashfn (&h->test, key);
+  ptrdiff_t mask = ((ptrdiff_t) 1 << snap->probe_bits) - 1;
+  ptrdiff_t slot = probe_home (snap->probe_bits, hash_code);
+  ptrdiff_t e;
+
+  eassert (h->read_mostly);
+  while ((e = __atomic_load_n (&snap->probe[slot], __ATOMIC_ACQUIRE)) != 0)
+    {
+      if (0 < e)
+	{
+	  Lisp_Object k = AREF (snap->key_and_value, 2 * (e - 1));
+	  Lisp_Object hc = AREF (snap->hash, e - 1);
+	  if (EQ (key, k)
+	      || (h->test.cmpfn
+		  && INTEGERP (hc) && hash_code == XUINT (hc)
+		  && h->test.cmpfn (&h->test, key, k)))
+	    {
+	      *value = AREF (snap->key_and_value, 2 * (e - 1) + 1);
+	      return true;
+	    }
+	}
+      slot = (slot + 1) & mask;
+    }
+  return false;
 }
 
 
@@ -3806,12 +4744,13 @@ ptrdiff_t
 hash_put (struct Lisp_Hash_Table *h, Lisp_Object key, Lisp_Object value,
 	  EMACS_UINT hash)
 {
-  ptrdiff_t start_of_bucket, i;
+  ptrdiff_t i;
 
   eassert ((hash & ~INTMASK) == 0);
 
   /* Increment count after resizing because resizing may fail.  */
   maybe_resize_hash_table (h);
+  hash_migrate (h, h->migrate_step);
   h->count++;
 
   /* Store key/value in the key_and_value vector.  */
@@ -3823,62 +4762,73 @@ hash_put (struct Lisp_Hash_Table *h, Lisp_Object key, Lisp_Object value,
   /* Remember its hash code.  */
   set_hash_hash_slot (h, i, make_number (hash));
 
-  /* Add new entry to its collision chain.  */
-  start_of_bucket = hash % ASIZE (h->index);
-  set_hash_next_slot (h, i, HASH_INDEX (h, start_of_bucket));
-  set_hash_index_slot (h, start_of_bucket, make_number (i));
+  /* Add new entry to the probe index.  */
+  set_hash_next_slot (h, i, Qnil);
+  hash_probe_insert (h->probe, h->probe_bits, i, hash);
   return i;
 }
 
 
 /* Remove the entry matching KEY from hash table H, if there is one.  */
 
-static void
+void
 hash_remove_from_table (struct Lisp_Hash_Table *h, Lisp_Object key)
 {
   EMACS_UINT hash_code;
-  ptrdiff_t start_of_bucket;
-  Lisp_Object idx, prev;
+  ptrdiff_t slot, i = -1;
 
   hash_code = h->test.hashfn (&h->test, key);
   eassert ((hash_code & ~INTMASK) == 0);
-  start_of_bucket = hash_code % ASIZE (h->index);
-  idx = HASH_INDEX (h, start_of_bucket);
-  prev = Qnil;
+  hash_migrate (h, h->migrate_step);
 
-  /* We need not gcpro idx, prev since they're either integers or nil.  */
-  while (!NILP (idx))
+  if (h->read_mostly)
     {
-      ptrdiff_t i = XFASTINT (idx);
-
-      if (EQ (key, HASH_KEY (h, i))
-	  || (h->test.cmpfn
-	      && hash_code == XUINT (HASH_HASH (h, i))
-	      && h->test.cmpfn (&h->test, key, HASH_KEY (h, i))))
+      /* Leave a tombstone, and keep the key and value so that a
+	 concurrent reader which already matched the key still finds a
+	 consistent value.  The entry is reclaimed by the next rebuild;
+	 only its hash code is cleared, which marks it unused.  */
+      slot = hash_probe_find (h, h->probe, h->probe_bits, key, hash_code);
+      if (0 <= slot)
 	{
-	  /* Take entry out of collision chain.  */
-	  if (NILP (prev))
-	    set_hash_index_slot (h, start_of_bucket, HASH_NEXT (h, i));
-	  else
-	    set_hash_next_slot (h, XFASTINT (prev), HASH_NEXT (h, i));
-
-	  /* Clear slots in key_and_value and add the slots to
-	     the free list.  */
-	  set_hash_key_slot (h, i, Qnil);
-	  set_hash_value_slot (h, i, Qnil);
+	  i = h->probe[slot] - 1;
+	  __atomic_store_n (&h->probe[slot], -1, __ATOMIC_RELEASE);
 	  set_hash_hash_slot (h, i, Qnil);
-	  set_hash_next_slot (h, i, h->next_free);
-	  h->next_free = make_number (i);
 	  h->count--;
 	  eassert (h->count >= 0);
-	  break;
 	}
-      else
+      return;
+    }
+
+  /* Take entry out of the probe index, and out of the old one if it
+     has not been moved yet.  The old index is read-only apart from
+     this, so a tombstone keeps its probe runs intact.  */
+  slot = hash_probe_find (h, h->probe, h->probe_bits, key, hash_code);
+  if (0 <= slot)
+    {
+      i = h->probe[slot] - 1;
+      hash_probe_delete (h, slot);
+    }
+  if (h->old_probe)
+    {
+      slot = hash_probe_find (h, h->old_probe, h->old_probe_bits,
+			      key, hash_code);
+      if (0 <= slot)
 	{
-	  prev = idx;
-	  idx = HASH_NEXT (h, i);
+	  i = h->old_probe[slot] - 1;
+	  h->old_probe[slot] = -1;
 	}
     }
+  if (i < 0)
+    return;
+
+  /* Clear slots in key_and_value and add the slots to the free list.  */
+  set_hash_key_slot (h, i, Qnil);
+  set_hash_value_slot (h, i, Qnil);
+  set_hash_hash_slot (h, i, Qnil);
+  set_hash_next_slot (h, i, h->next_free);
+  h->next_free = make_number (i);
+  h->count--;
+  eassert (h->count >= 0);
 }
 
 
@@ -3887,7 +4837,16 @@ hash_remove_from_table (struct Lisp_Hash_Table *h, Lisp_Object key)
 static void
 hash_clear (struct Lisp_Hash_Table *h)
 {
-  if (h->count > 0)
+  if (h->read_mostly)
+    {
+      /* Concurrent readers may still use the current vectors, so
+	 start over with new ones.  */
+      ptrdiff_t size = HASH_TABLE_SIZE (h);
+      set_hash_hash (h, Fmake_vector (make_number (size), Qnil));
+      h->count = 0;
+      rebuild_read_mostly_table (h, size);
+    }
+  else if (h->count > 0)
     {
       ptrdiff_t i, size = HASH_TABLE_SIZE (h);
 
@@ -3899,8 +4858,12 @@ hash_clear (struct Lisp_Hash_Table *h)
 	  set_hash_hash_slot (h, i, Qnil);
 	}
 
-      for (i = 0; i < ASIZE (h->index); ++i)
-	ASET (h->index, i, Qnil);
+      memset (h->probe, 0, sizeof *h->probe << h->probe_bits);
+      if (h->old_probe)
+	{
+	  xfree (h->old_probe);
+	  h->old_probe = NULL;
+	}
 
       h->next_free = make_number (0);
       h->count = 0;
@@ -3921,25 +4884,171 @@ hash_string (char const *ptr, ptrdiff_t len)
 {
   char const *p = ptr;
   char const *end = p + len;
-  unsigned char c;
-  EMACS_UINT hash = 0;
+  EMACS_UINT hash = len;
+  ptrdiff_t step = sizeof hash;
 
-  while (p != end)
+  /* Take a word at a time, then the bytes left over.  */
+  while (end - p >= step)
     {
-      c = *p++;
+      EMACS_UINT c;
+      memcpy (&c, p, step);
+      p += step;
       hash = sxhash_combine (hash, c);
     }
+  while (p != end)
+    hash = sxhash_combine (hash, (unsigned char) *p++);
 
   return hash;
 }
 
+/* Maximum depth up to which to dive into Lisp structures.  */
+
+#define SXHASH_MAX_DEPTH 3
+
+/* Maximum length up to which to take list and vector elements into
+   account.  */
+
+#define SXHASH_MAX_LEN   7
+
+/* Return a hash for the float VAL, from its bits.  */
+
+static EMACS_UINT
+sxhash_float (double val)
+{
+  EMACS_UINT hash = 0;
+  enum {
+    WORDS_PER_DOUBLE = (sizeof val / sizeof hash
+			+ (sizeof val % sizeof hash != 0))
+  };
+  union {
+    double val;
+    EMACS_UINT word[WORDS_PER_DOUBLE];
+  } u;
+  int i;
+
+  memset (&u, 0, sizeof u);
+  u.val = val;
+  for (i = 0; i < WORDS_PER_DOUBLE; i++)
+    hash = sxhash_combine (hash, u.word[i]);
+  return SXHASH_REDUCE (hash);
+}
+
+/* Return a hash for list LIST.  DEPTH is the current depth in the
+   list.  We don't recurse deeper than SXHASH_MAX_DEPTH in it.  */
+
+static EMACS_UINT
+sxhash_list (Lisp_Object list, int depth)
+{
+  EMACS_UINT hash = 0;
+  int i;
+
+  if (depth < SXHASH_MAX_DEPTH)
+    for (i = 0;
+	 CONSP (list) && i < SXHASH_MAX_LEN;
+	 list = XCDR (list), ++i)
+      hash = sxhash_combine (hash, sxhash (XCAR (list), depth + 1));
+
+  if (!NILP (list))
+    hash = sxhash_combine (hash, sxhash (list, depth + 1));
+
+  return SXHASH_REDUCE (hash);
+}
+
+/* Return a hash for the first SIZE slots of vector-like object VEC.
+   DEPTH is the current depth in the Lisp structure.  */
+
+static EMACS_UINT
+sxhash_vector (Lisp_Object vec, ptrdiff_t size, int depth)
+{
+  EMACS_UINT hash = ASIZE (vec);
+  ptrdiff_t i, n = min (SXHASH_MAX_LEN, size);
+
+  for (i = 0; i < n; ++i)
+    hash = sxhash_combine (hash, sxhash (AREF (vec, i), depth + 1));
+
+  return SXHASH_REDUCE (hash);
+}
+
+/* Return a hash for bool-vector VEC.  */
+
+static EMACS_UINT
+sxhash_bool_vector (Lisp_Object vec)
+{
+  EMACS_INT size = XBOOL_VECTOR (vec)->size;
+  ptrdiff_t nbytes = ((size + BOOL_VECTOR_BITS_PER_CHAR - 1)
+		      / BOOL_VECTOR_BITS_PER_CHAR);
+
+  return SXHASH_REDUCE (sxhash_combine (size, hash_string
+					((char *) XBOOL_VECTOR (vec)->data,
+					 min (SXHASH_MAX_LEN, nbytes))));
+}
+
 /* Return a hash code for OBJ.  DEPTH is the current depth in the Lisp
-   structure.  Value is an unsigned integer clipped to INTMASK.  */
+   structure.  Value is an unsigned integer clipped to INTMASK.
+
+   Objects that are `equal' get the same hash, following the
+   smob equality functions below: strings by their bytes, markers by
+   buffer and position, overlays by their bounds and properties, and
+   vectors, compiled functions, char-tables and fonts by their first
+   few slots.  Other Lisp objects are only `equal' when they are
+   `eq', so they hash by identity.  */
 
 EMACS_UINT
 sxhash (Lisp_Object obj, int depth)
 {
-  return scm_ihash (obj, MOST_POSITIVE_FIXNUM);
+  EMACS_UINT hash;
+
+  if (depth > SXHASH_MAX_DEPTH)
+    return 0;
+
+  if (INTEGERP (obj))
+    hash = XUINT (obj);
+  else if (SYMBOLP (obj))
+    return scm_ihashq (obj, MOST_POSITIVE_FIXNUM);
+  else if (STRINGP (obj))
+    hash = hash_string (SSDATA (obj), SBYTES (obj));
+  else if (CONSP (obj))
+    return sxhash_list (obj, depth);
+  else if (FLOATP (obj))
+    return sxhash_float (XFLOAT_DATA (obj));
+  else if (MARKERP (obj))
+    {
+      struct Lisp_Marker *m = XMARKER (obj);
+      hash = (m->buffer
+	      ? sxhash_combine ((uintptr_t) m->buffer, m->bytepos) : 0);
+    }
+  else if (OVERLAYP (obj))
+    hash = sxhash_combine (sxhash_combine (sxhash (OVERLAY_START (obj),
+						   depth + 1),
+					   sxhash (OVERLAY_END (obj),
+						   depth + 1)),
+			   sxhash (XOVERLAY (obj)->plist, depth + 1));
+  else if (BOOL_VECTOR_P (obj))
+    return sxhash_bool_vector (obj);
+  else if (WINDOW_CONFIGURATIONP (obj))
+    /* These compare by contents in ways not worth mirroring here.  */
+    hash = PVEC_WINDOW_CONFIGURATION;
+  else if (VECTORLIKEP (obj))
+    {
+      ptrdiff_t size = ASIZE (obj);
+
+      if (size & PSEUDOVECTOR_FLAG)
+	{
+	  if (((size & PVEC_TYPE_MASK) >> PSEUDOVECTOR_AREA_BITS)
+	      < PVEC_COMPILED)
+	    return scm_ihashq (obj, MOST_POSITIVE_FIXNUM);
+	  size &= PSEUDOVECTOR_SIZE_MASK;
+	}
+      return sxhash_vector (obj, size, depth);
+    }
+  else if (MISCP (obj))
+    return scm_ihashq (obj, MOST_POSITIVE_FIXNUM);
+  else
+    /* Not a Lisp object; let Guile hash it consistently with
+       `equal?'.  */
+    return scm_ihash (obj, MOST_POSITIVE_FIXNUM);
+
+  return SXHASH_REDUCE (hash);
 }
 
 
@@ -3989,10 +5098,17 @@ key, value, one of key or value, or both key and value, depending on
 WEAK.  WEAK t is equivalent to `key-and-value'.  Default value of WEAK
 is nil.
 
+:concurrency CONCURRENCY -- CONCURRENCY must be nil or `read-mostly'.
+A read-mostly table can be read by C code running in other threads
+without locking, while the main thread keeps modifying it.  Its test
+must be `eq', `eql' or `equal', and removed entries occupy space until
+the table is next rebuilt.  Default value is nil.
+
 usage: (make-hash-table &rest KEYWORD-ARGS)  */)
   (ptrdiff_t nargs, Lisp_Object *args)
 {
   Lisp_Object test, size, rehash_size, rehash_threshold, weak;
+  Lisp_Object concurrency, table;
   struct hash_table_test testdesc;
   char *used;
   ptrdiff_t i;
@@ -4061,12 +5177,27 @@ usage: (make-hash-table &rest KEYWORD-ARGS)  */)
       && !EQ (weak, Qkey_and_value))
     signal_error ("Invalid hash table weakness", weak);
 
+  /* Look for `:concurrency CONCURRENCY'.  */
+  i = get_key_arg (QCconcurrency, nargs, args, used);
+  concurrency = i ? args[i] : Qnil;
+  if (!NILP (concurrency) && !EQ (concurrency, Qread_mostly))
+    signal_error ("Invalid hash table concurrency", concurrency);
+  if (!NILP (concurrency) && testdesc.hashfn == hashfn_user_defined)
+    signal_error ("Read-mostly hash tables need a predefined test", test);
+
   /* Now, all args should have been used up, or there's a problem.  */
   for (i = 0; i < nargs; ++i)
     if (!used[i])
       signal_error ("Invalid argument list", args[i]);
 
-  return make_hash_table (testdesc, size, rehash_size, rehash_threshold, weak);
+  table = make_hash_table (testdesc, size, rehash_size, rehash_threshold,
+			   weak);
+  if (!NILP (concurrency))
+    {
+      XHASH_TABLE (table)->read_mostly = true;
+      publish_hash_snapshot (XHASH_TABLE (table));
+    }
+  return table;
 }
 
 
@@ -4078,6 +5209,52 @@ DEFUN ("copy-hash-table", Fcopy_hash_table, Scopy_hash_table, 1, 1, 0,
 }
 
 
+DEFUN ("hash-table-from-pairs", Fhash_table_from_pairs,
+       Shash_table_from_pairs, 1, 2, 0,
+       doc: /* Return a new hash table holding the entries of PAIRS.
+PAIRS is an alist or a vector whose elements are (KEY . VALUE) conses.
+If a key occurs more than once, the first occurrence wins, as with
+`assoc'.  TEST is the table's test, as for `make-hash-table'; it
+defaults to `eql'.  The table is sized to fit PAIRS exactly, so it is
+built without intermediate resizes.  */)
+  (Lisp_Object pairs, Lisp_Object test)
+{
+  Lisp_Object args[4], table, tail, elt;
+  struct Lisp_Hash_Table *h;
+  ptrdiff_t i, n;
+
+  if (VECTORP (pairs))
+    n = ASIZE (pairs);
+  else
+    n = XFASTINT (Flength (pairs));
+
+  args[0] = QCtest;
+  args[1] = NILP (test) ? Qeql : test;
+  args[2] = QCsize;
+  args[3] = make_number (n);
+  table = Fmake_hash_table (4, args);
+  h = XHASH_TABLE (table);
+
+  for (i = 0, tail = pairs; i < n; i++)
+    {
+      EMACS_UINT hash;
+
+      if (VECTORP (pairs))
+	elt = AREF (pairs, i);
+      else
+	{
+	  elt = XCAR (tail);
+	  tail = XCDR (tail);
+	}
+      CHECK_CONS (elt);
+      if (hash_lookup (h, XCAR (elt), &hash) < 0)
+	hash_put (h, XCAR (elt), XCDR (elt), hash);
+    }
+
+  return table;
+}
+
+
 DEFUN ("hash-table-count", Fhash_table_count, Shash_table_count, 1, 1, 0,
        doc: /* Return the number of elements in TABLE.  */)
   (Lisp_Object table)
@@ -4243,7 +5420,136 @@ returns nil, then (funcall TEST x1 x2) also returns nil.  */)
 #include "sha256.h"
 #include "sha512.h"
 
-/* ALGORITHM is a symbol: md5, sha1, sha224 and so on. */
+/* Return true if encoding ASCII text with CODING_SYSTEM leaves it
+   unchanged, so that such text can be hashed as it is.  */
+
+static bool
+coding_system_keeps_ascii_p (Lisp_Object coding_system)
+{
+  ptrdiff_t id = CODING_SYSTEM_ID (coding_system);
+  Lisp_Object attrs;
+
+  if (id < 0)
+    return false;
+  attrs = CODING_ID_ATTRS (id);
+  return (!NILP (CODING_ATTR_ASCII_COMPAT (attrs))
+	  && NILP (CODING_ATTR_PRE_WRITE (attrs))
+	  && NILP (CODING_ATTR_ENCODE_TBL (attrs))
+	  && EQ (CODING_ID_EOL_TYPE (id), Qunix));
+}
+
+/* A message digest being computed incrementally.  */
+
+struct secure_hash_ctx
+{
+  Lisp_Object algorithm;
+  union
+  {
+    struct md5_ctx md5;
+    struct sha1_ctx sha1;
+    struct sha256_ctx sha256;
+    struct sha512_ctx sha512;
+  } u;
+};
+
+/* Start computing a digest with ALGORITHM in CTX, and return the size
+   of the digest.  ALGORITHM is a symbol: md5, sha1, sha224 and so
+   on.  */
+
+static int
+secure_hash_init (struct secure_hash_ctx *ctx, Lisp_Object algorithm)
+{
+  ctx->algorithm = algorithm;
+  if (EQ (algorithm, Qmd5))
+    {
+      md5_init_ctx (&ctx->u.md5);
+      return MD5_DIGEST_SIZE;
+    }
+  else if (EQ (algorithm, Qsha1))
+    {
+      sha1_init_ctx (&ctx->u.sha1);
+      return SHA1_DIGEST_SIZE;
+    }
+  else if (EQ (algorithm, Qsha224))
+    {
+      sha224_init_ctx (&ctx->u.sha256);
+      return SHA224_DIGEST_SIZE;
+    }
+  else if (EQ (algorithm, Qsha256))
+    {
+      sha256_init_ctx (&ctx->u.sha256);
+      return SHA256_DIGEST_SIZE;
+    }
+  else if (EQ (algorithm, Qsha384))
+    {
+      sha384_init_ctx (&ctx->u.sha512);
+      return SHA384_DIGEST_SIZE;
+    }
+  else if (EQ (algorithm, Qsha512))
+    {
+      sha512_init_ctx (&ctx->u.sha512);
+      return SHA512_DIGEST_SIZE;
+    }
+  else
+    error ("Invalid algorithm arg: %s", SDATA (Fsymbol_name (algorithm)));
+}
+
+/* Add the LEN bytes at P to the digest in CTX.  */
+
+static void
+secure_hash_process (struct secure_hash_ctx *ctx, const void *p, size_t len)
+{
+  Lisp_Object algorithm = ctx->algorithm;
+
+  if (EQ (algorithm, Qmd5))
+    md5_process_bytes (p, len, &ctx->u.md5);
+  else if (EQ (algorithm, Qsha1))
+    sha1_process_bytes (p, len, &ctx->u.sha1);
+  else if (EQ (algorithm, Qsha224) || EQ (algorithm, Qsha256))
+    sha256_process_bytes (p, len, &ctx->u.sha256);
+  else
+    sha512_process_bytes (p, len, &ctx->u.sha512);
+}
+
+/* Store the digest in CTX into RESBUF.  */
+
+static void
+secure_hash_finish (struct secure_hash_ctx *ctx, void *resbuf)
+{
+  Lisp_Object algorithm = ctx->algorithm;
+
+  if (EQ (algorithm, Qmd5))
+    md5_finish_ctx (&ctx->u.md5, resbuf);
+  else if (EQ (algorithm, Qsha1))
+    sha1_finish_ctx (&ctx->u.sha1, resbuf);
+  else if (EQ (algorithm, Qsha224))
+    sha224_finish_ctx (&ctx->u.sha256, resbuf);
+  else if (EQ (algorithm, Qsha256))
+    sha256_finish_ctx (&ctx->u.sha256, resbuf);
+  else if (EQ (algorithm, Qsha384))
+    sha384_finish_ctx (&ctx->u.sha512, resbuf);
+  else
+    sha512_finish_ctx (&ctx->u.sha512, resbuf);
+}
+
+/* Add the bytes of the current buffer from FROM_BYTE to TO_BYTE to the
+   digest in CTX.  The text is hashed where it lies, one piece on each
+   side of the gap, so the gap is not moved and nothing is copied.  */
+
+static void
+secure_hash_buffer_bytes (struct secure_hash_ctx *ctx,
+			  ptrdiff_t from_byte, ptrdiff_t to_byte)
+{
+  if (from_byte < GPT_BYTE)
+    {
+      ptrdiff_t end = min (to_byte, GPT_BYTE);
+      secure_hash_process (ctx, BYTE_POS_ADDR (from_byte), end - from_byte);
+      from_byte = end;
+    }
+  if (from_byte < to_byte)
+    secure_hash_process (ctx, BYTE_POS_ADDR (from_byte),
+			 to_byte - from_byte);
+}
 
 static Lisp_Object
 secure_hash (Lisp_Object algorithm, Lisp_Object object, Lisp_Object start,
@@ -4256,10 +5562,15 @@ secure_hash (Lisp_Object algorithm, Lisp_Object object, Lisp_Object start,
   register struct buffer *bp;
   EMACS_INT temp;
   int digest_size;
-  void *(*hash_func) (const char *, size_t, void *);
+  struct secure_hash_ctx ctx;
   Lisp_Object digest;
 
   CHECK_SYMBOL (algorithm);
+  digest_size = secure_hash_init (&ctx, algorithm);
+
+  /* allocate 2 x digest_size so that it can be re-used to hold the
+     hexified value */
+  digest = make_uninit_string (digest_size * 2);
 
   if (STRINGP (object))
     {
@@ -4284,7 +5595,11 @@ secure_hash (Lisp_Object algorithm, Lisp_Object object, Lisp_Object start,
 	    xsignal1 (Qcoding_system_error, coding_system);
 	}
 
-      if (STRING_MULTIBYTE (object))
+      /* Pure ASCII text encodes to itself in the usual coding
+	 systems; don't copy it just to hash the same bytes.  */
+      if (STRING_MULTIBYTE (object)
+	  && !(SCHARS (object) == SBYTES (object)
+	       && coding_system_keeps_ascii_p (coding_system)))
 	object = code_convert_string (object, coding_system, Qnil, 1, 0, 1);
 
       size = SCHARS (object);
@@ -4294,6 +5609,9 @@ secure_hash (Lisp_Object algorithm, Lisp_Object object, Lisp_Object start,
       end_byte = (end_char == size
 		  ? SBYTES (object)
 		  : string_char_to_byte (object, end_char));
+
+      secure_hash_process (&ctx, SSDATA (object) + start_byte,
+			   end_byte - start_byte);
     }
   else
     {
@@ -4390,55 +5708,34 @@ secure_hash (Lisp_Object algorithm, Lisp_Object object, Lisp_Object start,
 	    }
 	}
 
-      object = make_buffer_string (b, e, 0);
-      dynwind_end ();
+      /* The function above may have run Lisp code.  */
+      if (!(BEGV <= b && e <= ZV))
+	args_out_of_range (start, end);
 
-      if (STRING_MULTIBYTE (object))
-	object = code_convert_string (object, coding_system, Qnil, 1, 0, 0);
-      start_byte = 0;
-      end_byte = SBYTES (object);
-    }
+      start_byte = CHAR_TO_BYTE (b);
+      end_byte = CHAR_TO_BYTE (e);
 
-  if (EQ (algorithm, Qmd5))
-    {
-      digest_size = MD5_DIGEST_SIZE;
-      hash_func	  = md5_buffer;
-    }
-  else if (EQ (algorithm, Qsha1))
-    {
-      digest_size = SHA1_DIGEST_SIZE;
-      hash_func	  = sha1_buffer;
-    }
-  else if (EQ (algorithm, Qsha224))
-    {
-      digest_size = SHA224_DIGEST_SIZE;
-      hash_func	  = sha224_buffer;
-    }
-  else if (EQ (algorithm, Qsha256))
-    {
-      digest_size = SHA256_DIGEST_SIZE;
-      hash_func	  = sha256_buffer;
-    }
-  else if (EQ (algorithm, Qsha384))
-    {
-      digest_size = SHA384_DIGEST_SIZE;
-      hash_func	  = sha384_buffer;
-    }
-  else if (EQ (algorithm, Qsha512))
-    {
-      digest_size = SHA512_DIGEST_SIZE;
-      hash_func	  = sha512_buffer;
-    }
-  else
-    error ("Invalid algorithm arg: %s", SDATA (Fsymbol_name (algorithm)));
+      /* Unibyte text is never encoded, and pure ASCII text encodes to
+	 itself in the usual coding systems; hash either directly out of
+	 the buffer instead of copying it into a string first.  */
+      if (NILP (BVAR (current_buffer, enable_multibyte_characters))
+	  || (end_byte - start_byte == e - b
+	      && coding_system_keeps_ascii_p (coding_system)))
+	{
+	  secure_hash_buffer_bytes (&ctx, start_byte, end_byte);
+	  dynwind_end ();
+	}
+      else
+	{
+	  object = make_buffer_string (b, e, 0);
+	  dynwind_end ();
 
-  /* allocate 2 x digest_size so that it can be re-used to hold the
-     hexified value */
-  digest = make_uninit_string (digest_size * 2);
+	  object = code_convert_string (object, coding_system, Qnil, 1, 0, 0);
+	  secure_hash_process (&ctx, SSDATA (object), SBYTES (object));
+	}
+    }
 
-  hash_func (SSDATA (object) + start_byte,
-	     end_byte - start_byte,
-	     SSDATA (digest));
+  secure_hash_finish (&ctx, SSDATA (digest));
 
   if (NILP (binary))
     {
@@ -4503,6 +5800,117 @@ If BINARY is non-nil, returns a string in binary form.  */)
   return secure_hash (algorithm, object, start, end, Qnil, Qnil, binary);
 }
 
+/* A fast non-cryptographic 64-bit hash, computed over text that may
+   arrive in several pieces.  The value depends only on the bytes
+   hashed, not on how they were split up.  */
+
+struct fast_hash
+{
+  uint64_t h;
+  uint64_t length;
+  unsigned char tail[8];
+  int ntail;
+};
+
+static uint64_t
+fast_hash_mix (uint64_t h, uint64_t w)
+{
+  w *= 0x87c37b91114253d5;
+  w = (w << 31) | (w >> 33);
+  w *= 0x4cf5ad432745937f;
+  h ^= w;
+  h = (h << 27) | (h >> 37);
+  return h * 5 + 0x52dce729;
+}
+
+static uint64_t
+fast_hash_word (unsigned char const *p)
+{
+  uint64_t w = 0;
+  int i;
+  for (i = 7; i >= 0; i--)
+    w = (w << 8) | p[i];
+  return w;
+}
+
+static void
+fast_hash_process (struct fast_hash *fh, unsigned char const *p, ptrdiff_t len)
+{
+  fh->length += len;
+  if (fh->ntail)
+    {
+      int n = min (len, 8 - fh->ntail);
+      memcpy (fh->tail + fh->ntail, p, n);
+      fh->ntail += n;
+      p += n, len -= n;
+      if (fh->ntail < 8)
+	return;
+      fh->h = fast_hash_mix (fh->h, fast_hash_word (fh->tail));
+      fh->ntail = 0;
+    }
+  for (; len >= 8; p += 8, len -= 8)
+    fh->h = fast_hash_mix (fh->h, fast_hash_word (p));
+  memcpy (fh->tail, p, len);
+  fh->ntail = len;
+}
+
+static uint64_t
+fast_hash_finish (struct fast_hash *fh)
+{
+  uint64_t h = fh->h;
+
+  if (fh->ntail)
+    {
+      memset (fh->tail + fh->ntail, 0, 8 - fh->ntail);
+      h = fast_hash_mix (h, fast_hash_word (fh->tail));
+    }
+  h ^= fh->length;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53;
+  h ^= h >> 33;
+  return h;
+}
+
+DEFUN ("buffer-hash", Fbuffer_hash, Sbuffer_hash, 0, 1, 0,
+       doc: /* Return a hash of the contents of BUFFER-OR-NAME.
+The hash is a string of 16 hexadecimal digits, computed from the
+internal representation of the whole text of the buffer, ignoring
+narrowing and text properties.  It is meant for quickly noticing
+whether the text has changed; it is not a cryptographic checksum, and
+two buffers with the same text but different multibyteness may hash
+differently.  Use `secure-hash' when that matters.
+
+BUFFER-OR-NAME defaults to the current buffer.  */)
+  (Lisp_Object buffer_or_name)
+{
+  struct buffer *b;
+  struct fast_hash fh;
+  uint64_t h;
+  char hex[16];
+  int i;
+
+  if (NILP (buffer_or_name))
+    b = current_buffer;
+  else
+    {
+      Lisp_Object buffer = Fget_buffer (buffer_or_name);
+      if (NILP (buffer))
+	nsberror (buffer_or_name);
+      b = XBUFFER (buffer);
+    }
+
+  memset (&fh, 0, sizeof fh);
+  fast_hash_process (&fh, BUF_BEG_ADDR (b), BUF_GPT_BYTE (b) - BUF_BEG_BYTE (b));
+  fast_hash_process (&fh, BUF_GAP_END_ADDR (b), BUF_Z_BYTE (b) - BUF_GPT_BYTE (b));
+  h = fast_hash_finish (&fh);
+
+  for (i = 15; i >= 0; i--, h >>= 4)
+    hex[i] = "0123456789abcdef"[h & 0xf];
+  return make_unibyte_string (hex, 16);
+}
+
 DEFUN ("eval-scheme", Feval_scheme, Seval_scheme, 1, 1,
        "sEval Scheme: ",
        doc: /* Evaluate a string containing a Scheme expression.  */)
@@ -4551,14 +5959,24 @@ syms_of_fns (void)
   DEFSYM (Qvalue, "value");
   DEFSYM (Qhash_table_test, "hash-table-test");
   DEFSYM (Qkey_or_value, "key-or-value");
+  DEFSYM (QCconcurrency, ":concurrency");
+  DEFSYM (Qread_mostly, "read-mostly");
   DEFSYM (Qkey_and_value, "key-and-value");
 
   DEFSYM (Qstring_lessp, "string-lessp");
+
+  /* syms_of_data has defined `<' by now.  */
+  sort_lss_function = Fsymbol_function (intern_c_string ("<"));
+  staticpro (&sort_lss_function);
+  sort_string_lessp_function = Fsymbol_function (Qstring_lessp);
+  staticpro (&sort_string_lessp_function);
   DEFSYM (Qprovide, "provide");
   DEFSYM (Qrequire, "require");
   DEFSYM (Qyes_or_no_p_history, "yes-or-no-p-history");
   DEFSYM (Qcursor_in_echo_area, "cursor-in-echo-area");
   DEFSYM (Qwidget_type, "widget-type");
+  DEFSYM (Qstring_builder, "string-builder");
+  DEFSYM (Qstring_builder_p, "string-builder-p");
 
   staticpro (&string_char_byte_cache_string);
   string_char_byte_cache_string = Qnil;
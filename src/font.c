@@ -210,6 +210,7 @@ font_make_object (int size, Lisp_Object entity, int pixelsize)
   /* GC can happen before the driver is set up,
      so avoid dangling pointer here (Bug#17771).  */
   font->driver = NULL;
+  font->glyph_cache = NULL;
   XSETFONT (font_object, font);
 
   if (! NILP (entity))
@@ -232,6 +233,7 @@ static Lisp_Object font_open_entity (struct frame *, Lisp_Object, int);
 static Lisp_Object font_matching_entity (struct frame *, Lisp_Object *,
                                          Lisp_Object);
 static unsigned font_encode_char (Lisp_Object, int);
+static void font_free_glyph_cache (struct font *);
 
 /* Number of registered font drivers.  */
 static int num_font_drivers;
@@ -2580,6 +2582,7 @@ font_clear_cache (struct frame *f, Lisp_Object cache, struct font_driver *driver
   Lisp_Object entity;
   ptrdiff_t i;
 
+  font_clear_match_cache ();
   /* CACHE = (DRIVER-TYPE NUM-FRAMES FONT-CACHE-DATA ...) */
   for (tail = XCDR (XCDR (cache)); CONSP (tail); tail = XCDR (tail))
     {
@@ -2607,6 +2610,7 @@ font_clear_cache (struct frame *f, Lisp_Object cache, struct font_driver *driver
 			{
 			  eassert (font && driver == font->driver);
 			  driver->close (font);
+			  font_free_glyph_cache (font);
 			}
 		    }
 		  if (driver->free_entity)
@@ -2911,6 +2915,7 @@ font_close_object (struct frame *f, Lisp_Object font_object)
     return;
   FONT_ADD_LOG ("close", font_object, Qnil);
   font->driver->close (font);
+  font_free_glyph_cache (font);
 #ifdef HAVE_WINDOW_SYSTEM
   eassert (FRAME_DISPLAY_INFO (f)->n_fonts);
   FRAME_DISPLAY_INFO (f)->n_fonts--;
@@ -2950,7 +2955,7 @@ font_has_char (struct frame *f, Lisp_Object font, int c)
       if (result >= 0)
 	return result;
     }
-  return (fontp->driver->encode_char (fontp, c) != FONT_INVALID_CODE);
+  return (font_glyph_code (fontp, c) != FONT_INVALID_CODE);
 }
 
 
@@ -2963,7 +2968,171 @@ font_encode_char (Lisp_Object font_object, int c)
 
   eassert (FONT_OBJECT_P (font_object));
   font = XFONT_OBJECT (font_object);
-  return font->driver->encode_char (font, c);
+  return font_glyph_code (font, c);
+}
+
+
+/* Glyph cache.
+
+   Redisplay asks for the glyph code and the metrics of each character
+   it lays out, and the answer for a given font never changes, so each
+   font remembers what its driver already told it.  Characters and
+   glyph codes below FONT_GLYPH_CACHE_DENSE are looked up directly;
+   others go to open-addressed tables of FONT_GLYPH_CACHE_SIZE slots,
+   in which a key that finds no free slot within FONT_GLYPH_CACHE_PROBES
+   slots replaces the one in its home slot.  */
+
+#define FONT_GLYPH_CACHE_DENSE 256
+#define FONT_GLYPH_CACHE_SIZE 512
+#define FONT_GLYPH_CACHE_PROBES 8
+
+/* Value of a glyph code not asked for yet.  */
+#define FONT_GLYPH_CACHE_UNKNOWN (FONT_INVALID_CODE - 1)
+
+struct font_glyph_cache
+{
+  /* Glyph codes of characters below FONT_GLYPH_CACHE_DENSE.  */
+  unsigned dense_code[FONT_GLYPH_CACHE_DENSE];
+
+  /* Glyph codes of other characters.  A slot is free if C is -1.  */
+  struct
+  {
+    int c;
+    unsigned code;
+  } code[FONT_GLYPH_CACHE_SIZE];
+
+  /* Metrics of glyph codes below FONT_GLYPH_CACHE_DENSE and of others.
+     A slot is free if CODE is FONT_INVALID_CODE.  */
+  struct font_glyph_metrics
+  {
+    unsigned code;
+    struct font_metrics metrics;
+  } dense_metrics[FONT_GLYPH_CACHE_DENSE], metrics[FONT_GLYPH_CACHE_SIZE];
+};
+
+/* How often the glyph caches of all fonts answered a question, and
+   how often they had to ask the driver.  */
+static EMACS_INT glyph_code_hits, glyph_code_misses;
+static EMACS_INT glyph_metrics_hits, glyph_metrics_misses;
+
+static struct font_glyph_cache *
+font_glyph_cache (struct font *font)
+{
+  struct font_glyph_cache *cache = font->glyph_cache;
+  int i;
+
+  if (cache)
+    return cache;
+  cache = xmalloc (sizeof *cache);
+  for (i = 0; i < FONT_GLYPH_CACHE_DENSE; i++)
+    {
+      cache->dense_code[i] = FONT_GLYPH_CACHE_UNKNOWN;
+      cache->dense_metrics[i].code = FONT_INVALID_CODE;
+    }
+  for (i = 0; i < FONT_GLYPH_CACHE_SIZE; i++)
+    {
+      cache->code[i].c = -1;
+      cache->metrics[i].code = FONT_INVALID_CODE;
+    }
+  font->glyph_cache = cache;
+  return cache;
+}
+
+static void
+font_free_glyph_cache (struct font *font)
+{
+  xfree (font->glyph_cache);
+  font->glyph_cache = NULL;
+}
+
+/* Return the glyph code of character C in FONT, asking FONT's driver
+   only the first time.  */
+
+unsigned
+font_glyph_code (struct font *font, int c)
+{
+  struct font_glyph_cache *cache = font_glyph_cache (font);
+  unsigned code;
+  int i, slot, home;
+
+  eassert (c >= 0);
+  if (c < FONT_GLYPH_CACHE_DENSE)
+    {
+      code = cache->dense_code[c];
+      if (code != FONT_GLYPH_CACHE_UNKNOWN)
+	{
+	  glyph_code_hits++;
+	  return code;
+	}
+      glyph_code_misses++;
+      code = font->driver->encode_char (font, c);
+      cache->dense_code[c] = code;
+      return code;
+    }
+
+  home = slot = (unsigned) c % FONT_GLYPH_CACHE_SIZE;
+  for (i = 0; i < FONT_GLYPH_CACHE_PROBES; i++)
+    {
+      if (cache->code[slot].c == c)
+	{
+	  glyph_code_hits++;
+	  return cache->code[slot].code;
+	}
+      if (cache->code[slot].c < 0)
+	break;
+      slot = (slot + 1) % FONT_GLYPH_CACHE_SIZE;
+    }
+  if (i == FONT_GLYPH_CACHE_PROBES)
+    slot = home;
+  glyph_code_misses++;
+  code = font->driver->encode_char (font, c);
+  cache->code[slot].c = c;
+  cache->code[slot].code = code;
+  return code;
+}
+
+/* Store in *METRICS the metrics of the glyph CODE of FONT, asking
+   FONT's driver only the first time.  */
+
+void
+font_glyph_metrics (struct font *font, unsigned code,
+		    struct font_metrics *metrics)
+{
+  struct font_glyph_cache *cache = font_glyph_cache (font);
+  struct font_glyph_metrics *entry;
+  int i, slot, home;
+
+  if (code == FONT_INVALID_CODE)
+    {
+      font->driver->text_extents (font, &code, 1, metrics);
+      return;
+    }
+  if (code < FONT_GLYPH_CACHE_DENSE)
+    entry = &cache->dense_metrics[code];
+  else
+    {
+      home = slot = code % FONT_GLYPH_CACHE_SIZE;
+      for (i = 0; i < FONT_GLYPH_CACHE_PROBES; i++)
+	{
+	  if (cache->metrics[slot].code == code
+	      || cache->metrics[slot].code == FONT_INVALID_CODE)
+	    break;
+	  slot = (slot + 1) % FONT_GLYPH_CACHE_SIZE;
+	}
+      if (i == FONT_GLYPH_CACHE_PROBES)
+	slot = home;
+      entry = &cache->metrics[slot];
+    }
+
+  if (entry->code == code)
+    glyph_metrics_hits++;
+  else
+    {
+      glyph_metrics_misses++;
+      font->driver->text_extents (font, &code, 1, &entry->metrics);
+      entry->code = code;
+    }
+  *metrics = entry->metrics;
 }
 
 
@@ -3088,6 +3257,105 @@ font_select_entity (struct frame *f, Lisp_Object entities,
   return font_sort_entities (entities, prefer, f, c);
 }
 
+/* Font match cache.
+
+   Fontset fallback asks font_find_for_lface for a font for each
+   character that the fonts opened so far lack, and each such call
+   lists and scores every candidate font.  FONT_MATCH_CACHE maps the
+   frame, the font spec, the face's font attributes and the script of
+   the character to the entity found last time; an entity found for
+   one character of a script is used for another if it has that
+   character too.  A failure is remembered only when no character was
+   asked for.  The cache is emptied when the font drivers of a frame
+   or their caches change, when the Xft settings change, and when
+   `face-ignored-fonts' or `face-alternative-font-family-alist' is
+   set to a new value.  */
+
+static Lisp_Object font_match_cache;
+static Lisp_Object font_match_cache_ignored, font_match_cache_alternatives;
+
+/* Empty the cache when it has grown to this many entries.  */
+#define FONT_MATCH_CACHE_MAX 1024
+
+void
+font_clear_match_cache (void)
+{
+  font_match_cache = Qnil;
+}
+
+/* Return the key of FONT_MATCH_CACHE for font_find_for_lface's
+   arguments.  */
+
+static Lisp_Object
+font_match_key (struct frame *f, Lisp_Object *attrs, Lisp_Object spec, int c)
+{
+  static int const lface_index[] =
+    { LFACE_FAMILY_INDEX, LFACE_FOUNDRY_INDEX, LFACE_HEIGHT_INDEX,
+      LFACE_WEIGHT_INDEX, LFACE_SLANT_INDEX, LFACE_SWIDTH_INDEX };
+  int nlface = sizeof lface_index / sizeof lface_index[0];
+  int nfont = FONT_SIZE_INDEX - FONT_ADSTYLE_INDEX + 1;
+  Lisp_Object key = make_uninit_vector (2 + nlface + nfont + FONT_SPEC_MAX);
+  Lisp_Object frame;
+  int i, j = 0;
+
+  XSETFRAME (frame, f);
+  ASET (key, j++, frame);
+  ASET (key, j++, c < 0 ? Qt : CHAR_TABLE_REF (Vchar_script_table, c));
+  for (i = 0; i < nlface; i++)
+    ASET (key, j++, attrs[lface_index[i]]);
+  for (i = FONT_ADSTYLE_INDEX; i <= FONT_SIZE_INDEX; i++)
+    ASET (key, j++, (FONTP (attrs[LFACE_FONT_INDEX])
+		     ? AREF (attrs[LFACE_FONT_INDEX], i) : Qnil));
+  for (i = 0; i < FONT_SPEC_MAX; i++)
+    ASET (key, j++, AREF (spec, i));
+  return key;
+}
+
+/* Return the index in FONT_MATCH_CACHE of the entry for KEY, or -1 if
+   there is none.  Store KEY's hash code in *HASH.  */
+
+static ptrdiff_t
+font_match_cache_lookup (Lisp_Object key, EMACS_UINT *hash)
+{
+  if (! EQ (font_match_cache_ignored, Vface_ignored_fonts)
+      || ! EQ (font_match_cache_alternatives,
+	       Vface_alternative_font_family_alist)
+      || (HASH_TABLE_P (font_match_cache)
+	  && XHASH_TABLE (font_match_cache)->count >= FONT_MATCH_CACHE_MAX))
+    font_clear_match_cache ();
+  if (NILP (font_match_cache))
+    {
+      font_match_cache
+	= make_hash_table (hashtest_equal, make_number (DEFAULT_HASH_SIZE),
+			   make_float (DEFAULT_REHASH_SIZE),
+			   make_float (DEFAULT_REHASH_THRESHOLD),
+			   Qnil);
+      font_match_cache_ignored = Vface_ignored_fonts;
+      font_match_cache_alternatives = Vface_alternative_font_family_alist;
+    }
+  return hash_lookup (XHASH_TABLE (font_match_cache), key, hash);
+}
+
+/* Record ENTITY as the result of font_find_for_lface for KEY, whose
+   hash code is HASH.  */
+
+static void
+font_match_cache_put (Lisp_Object key, EMACS_UINT hash, Lisp_Object entity)
+{
+  struct Lisp_Hash_Table *h;
+  ptrdiff_t i;
+
+  if (NILP (font_match_cache))
+    return;
+  h = XHASH_TABLE (font_match_cache);
+  i = hash_lookup (h, key, NULL);
+  if (i >= 0)
+    set_hash_value_slot (h, i, entity);
+  else
+    hash_put (h, key, entity, hash);
+}
+
+
 /* Return a font-entity that satisfies SPEC and is the best match for
    face's font related attributes in ATTRS.  C, if not negative, is a
    character that the entity must support.  */
@@ -3098,6 +3366,9 @@ font_find_for_lface (struct frame *f, Lisp_Object *attrs, Lisp_Object spec, int
   Lisp_Object work;
   Lisp_Object entities, val;
   Lisp_Object foundry[3], *family, registry[3], adstyle[3];
+  Lisp_Object key;
+  ptrdiff_t cached;
+  EMACS_UINT hash;
   int pixel_size;
   int i, j, k, l;
   USE_SAFE_ALLOCA;
@@ -3126,6 +3397,15 @@ font_find_for_lface (struct frame *f, Lisp_Object *attrs, Lisp_Object spec, int
 	return Qnil;
     }
 
+  key = font_match_key (f, attrs, spec, c);
+  cached = font_match_cache_lookup (key, &hash);
+  if (cached >= 0)
+    {
+      val = HASH_VALUE (XHASH_TABLE (font_match_cache), cached);
+      if (c < 0 || (! NILP (val) && font_has_char (f, val, c) > 0))
+	return val;
+    }
+
   work = copy_font_spec (spec);
   ASET (work, FONT_TYPE_INDEX, AREF (spec, FONT_TYPE_INDEX));
   pixel_size = font_pixel_size (f, spec);
@@ -3229,6 +3509,7 @@ font_find_for_lface (struct frame *f, Lisp_Object *attrs, Lisp_Object spec, int
 		      if (! NILP (val))
 			{
 			  SAFE_FREE ();
+			  font_match_cache_put (key, hash, val);
 			  return val;
 			}
 		    }
@@ -3238,6 +3519,8 @@ font_find_for_lface (struct frame *f, Lisp_Object *attrs, Lisp_Object spec, int
     }
 
   SAFE_FREE ();
+  if (c < 0)
+    font_match_cache_put (key, hash, Qnil);
   return Qnil;
 }
 
@@ -3428,6 +3711,7 @@ free_font_driver_list (struct frame *f)
 {
   struct font_driver_list *list, *next;
 
+  font_clear_match_cache ();
   for (list = f->font_driver_list; list; list = next)
     {
       next = list->next;
@@ -3451,6 +3735,7 @@ font_update_drivers (struct frame *f, Lisp_Object new_drivers)
   Lisp_Object active_drivers = Qnil;
   struct font_driver_list *list;
 
+  font_clear_match_cache ();
   /* At first, turn off non-requested drivers, and turn on requested
      drivers.  */
   for (list = f->font_driver_list; list; list = list->next)
@@ -4289,11 +4574,11 @@ void
 font_fill_lglyph_metrics (Lisp_Object glyph, Lisp_Object font_object)
 {
   struct font *font = XFONT_OBJECT (font_object);
-  unsigned code = font->driver->encode_char (font, LGLYPH_CHAR (glyph));
+  unsigned code = font_glyph_code (font, LGLYPH_CHAR (glyph));
   struct font_metrics metrics;
 
   LGLYPH_SET_CODE (glyph, code);
-  font->driver->text_extents (font, &code, 1, &metrics);
+  font_glyph_metrics (font, code, &metrics);
   LGLYPH_SET_LBEARING (glyph, metrics.lbearing);
   LGLYPH_SET_RBEARING (glyph, metrics.rbearing);
   LGLYPH_SET_WIDTH (glyph, metrics.width);
@@ -4536,6 +4821,21 @@ corresponding character.  */)
 }
 #endif	/* 0 */
 
+DEFUN ("font-glyph-cache-statistics", Ffont_glyph_cache_statistics,
+       Sfont_glyph_cache_statistics, 0, 0, 0,
+       doc: /* Return a list (CODE-HITS CODE-MISSES METRICS-HITS METRICS-MISSES).
+CODE-HITS and CODE-MISSES count how often the glyph code of a
+character was found in the glyph cache of a font and how often the
+font driver had to be asked for it.  METRICS-HITS and METRICS-MISSES
+count the same for the metrics of a glyph.  */)
+  (void)
+{
+  return list4 (make_number (glyph_code_hits),
+		make_number (glyph_code_misses),
+		make_number (glyph_metrics_hits),
+		make_number (glyph_metrics_misses));
+}
+
 #ifdef FONT_DEBUG
 
 DEFUN ("open-font", Fopen_font, Sopen_font, 1, 3, 0,
@@ -4734,7 +5034,7 @@ the corresponding element is nil.  */)
       unsigned code;
       struct font_metrics metrics;
 
-      code = font->driver->encode_char (font, c);
+      code = font_glyph_code (font, c);
       if (code == FONT_INVALID_CODE)
 	{
 	  ASET (vec, i, Qnil);
@@ -4745,7 +5045,7 @@ the corresponding element is nil.  */)
       LGLYPH_SET_TO (g, i);
       LGLYPH_SET_CHAR (g, c);
       LGLYPH_SET_CODE (g, code);
-      font->driver->text_extents (font, &code, 1, &metrics);
+      font_glyph_metrics (font, code, &metrics);
       LGLYPH_SET_WIDTH (g, metrics.width);
       LGLYPH_SET_LBEARING (g, metrics.lbearing);
       LGLYPH_SET_RBEARING (g, metrics.rbearing);
@@ -5108,6 +5408,13 @@ syms_of_font (void)
   staticpro (&scratch_font_prefer);
   scratch_font_prefer = Ffont_spec (0, NULL);
 
+  staticpro (&font_match_cache);
+  font_match_cache = Qnil;
+  staticpro (&font_match_cache_ignored);
+  font_match_cache_ignored = Qnil;
+  staticpro (&font_match_cache_alternatives);
+  font_match_cache_alternatives = Qnil;
+
   staticpro (&Vfont_log_deferred);
   Vfont_log_deferred = Fmake_vector (make_number (3), Qnil);
 
@@ -399,6 +399,10 @@ struct font
   /* Font-driver for the font.  */
   struct font_driver *driver;
 
+  /* Glyph codes and metrics already obtained from the driver, or NULL
+     if none were asked for yet.  See font_glyph_code.  */
+  struct font_glyph_cache *glyph_cache;
+
   /* There are more members in this structure, but they are private
      to the font-driver.  */
 };
@@ -759,6 +763,9 @@ extern Lisp_Object font_get_name (Lisp_Object font_object);
 extern Lisp_Object font_spec_from_name (Lisp_Object font_name);
 extern Lisp_Object font_get_frame (Lisp_Object font_object);
 extern int font_has_char (struct frame *, Lisp_Object, int);
+extern unsigned font_glyph_code (struct font *, int);
+extern void font_glyph_metrics (struct font *, unsigned,
+				struct font_metrics *);
 
 extern void font_clear_prop (Lisp_Object *attrs,
                              enum font_property_index prop);
@@ -772,6 +779,7 @@ extern Lisp_Object font_load_for_lface (struct frame *f, Lisp_Object *lface,
 extern void font_prepare_for_face (struct frame *f, struct face *face);
 extern void font_done_for_face (struct frame *f, struct face *face);
 extern void clear_font_cache (struct frame *);
+extern void font_clear_match_cache (void);
 
 extern Lisp_Object font_open_by_spec (struct frame *f, Lisp_Object spec);
 extern Lisp_Object font_open_by_name (struct frame *f, Lisp_Object name);
@@ -1313,18 +1313,6 @@ check_fontset_name (Lisp_Object name, Lisp_Object *frame)
   return FONTSET_FROM_ID (id);
 }
 
-static void
-accumulate_script_ranges (Lisp_Object arg, Lisp_Object range, Lisp_Object val)
-{
-  if (EQ (XCAR (arg), val))
-    {
-      if (CONSP (range))
-	XSETCDR (arg, Fcons (Fcons (XCAR (range), XCDR (range)), XCDR (arg)));
-      else
-	XSETCDR (arg, Fcons (Fcons (range, range), XCDR (arg)));
-    }
-}
-
 
 /* Callback function for map_charset_chars in Fset_fontset_font.
    ARG is a vector [ FONTSET FONT_DEF ADD ASCII SCRIPT_RANGE_LIST ].
@@ -1512,18 +1500,30 @@ appended.  By default, FONT-SPEC overrides the previous settings.  */)
   else if (SYMBOLP (target) && !NILP (target))
     {
       Lisp_Object script_list;
-      Lisp_Object val;
 
       range_list = Qnil;
       script_list = XCHAR_TABLE (Vchar_script_table)->extras[0];
       if (! NILP (Fmemq (target, script_list)))
 	{
+	  struct char_table_run runs[64];
+	  ptrdiff_t i, n;
+	  int c = 0;
+
 	  if (EQ (target, Qlatin))
 	    ascii_changed = 1;
-	  val = list1 (target);
-	  map_char_table (accumulate_script_ranges, Qnil, Vchar_script_table,
-			  val);
-	  range_list = Fnreverse (XCDR (val));
+	  do
+	    {
+	      n = char_table_runs (Vchar_script_table, c, MAX_CHAR,
+				   runs, ARRAYELTS (runs));
+	      for (i = 0; i < n; i++)
+		if (EQ (runs[i].val, target))
+		  range_list = Fcons (Fcons (make_number (runs[i].from),
+					     make_number (runs[i].to)),
+				      range_list);
+	      c = runs[n - 1].to + 1;
+	    }
+	  while (c <= MAX_CHAR);
+	  range_list = Fnreverse (range_list);
 	}
       if (CHARSETP (target))
 	{
@@ -1847,7 +1847,7 @@ DEFUN ("internal-char-font", Finternal_char_font, Sinternal_char_font, 1, 2, 0,
   face = FACE_FROM_ID (f, face_id);
   if (face->font)
     {
-      unsigned code = face->font->driver->encode_char (face->font, c);
+      unsigned code = font_glyph_code (face->font, c);
       Lisp_Object font_object;
 
       if (code == FONT_INVALID_CODE)
@@ -32,6 +32,7 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #endif
 
 static bool emacs_gnutls_handle_error (gnutls_session_t, int);
+static void gnutls_finish_boot (struct Lisp_Process *, int);
 
 static Lisp_Object Qgnutls_dll;
 static Lisp_Object Qgnutls_code;
@@ -40,6 +41,17 @@ static Lisp_Object Qgnutls_e_interrupted, Qgnutls_e_again,
   Qgnutls_e_invalid_session, Qgnutls_e_not_ready_for_handshake;
 static bool gnutls_global_initialized;
 
+/* Sessions saved for resumption, as an alist of (HOSTNAME . DATA),
+   most recently used first, where DATA is a unibyte string holding
+   what gnutls_session_get_data returned.  */
+static Lisp_Object gnutls_sessions;
+
+/* The number of sessions kept in gnutls_sessions.  */
+enum { GNUTLS_SESSIONS_MAX = 16 };
+
+/* The largest amount of plaintext a TLS record can carry.  */
+enum { GNUTLS_RECORD_MAX = 16 * 1024 };
+
 /* The following are for the property list of `gnutls-boot'.  */
 static Lisp_Object QCgnutls_bootprop_priority;
 static Lisp_Object QCgnutls_bootprop_trustfiles;
@@ -51,6 +63,7 @@ static Lisp_Object QCgnutls_bootprop_hostname;
 static Lisp_Object QCgnutls_bootprop_min_prime_bits;
 static Lisp_Object QCgnutls_bootprop_verify_flags;
 static Lisp_Object QCgnutls_bootprop_verify_error;
+static Lisp_Object QCgnutls_bootprop_nowait;
 
 /* Callback keys for `gnutls-boot'.  Unused currently.  */
 static Lisp_Object QCgnutls_bootprop_callbacks_verify;
@@ -128,6 +141,10 @@ DEF_GNUTLS_FN (size_t, gnutls_record_check_pending, (gnutls_session_t));
 DEF_GNUTLS_FN (ssize_t, gnutls_record_recv, (gnutls_session_t, void *, size_t));
 DEF_GNUTLS_FN (ssize_t, gnutls_record_send,
 	       (gnutls_session_t, const void *, size_t));
+DEF_GNUTLS_FN (int, gnutls_session_get_data,
+	       (gnutls_session_t, void *, size_t *));
+DEF_GNUTLS_FN (int, gnutls_session_set_data,
+	       (gnutls_session_t, const void *, size_t));
 DEF_GNUTLS_FN (const char *, gnutls_strerror, (int));
 DEF_GNUTLS_FN (void, gnutls_transport_set_errno, (gnutls_session_t, int));
 DEF_GNUTLS_FN (const char *, gnutls_check_version, (const char *));
@@ -191,6 +208,8 @@ init_gnutls_functions (void)
   LOAD_GNUTLS_FN (library, gnutls_record_check_pending);
   LOAD_GNUTLS_FN (library, gnutls_record_recv);
   LOAD_GNUTLS_FN (library, gnutls_record_send);
+  LOAD_GNUTLS_FN (library, gnutls_session_get_data);
+  LOAD_GNUTLS_FN (library, gnutls_session_set_data);
   LOAD_GNUTLS_FN (library, gnutls_strerror);
   LOAD_GNUTLS_FN (library, gnutls_transport_set_errno);
   LOAD_GNUTLS_FN (library, gnutls_check_version);
@@ -251,6 +270,8 @@ init_gnutls_functions (void)
 #define fn_gnutls_record_check_pending		gnutls_record_check_pending
 #define fn_gnutls_record_recv			gnutls_record_recv
 #define fn_gnutls_record_send			gnutls_record_send
+#define fn_gnutls_session_get_data		gnutls_session_get_data
+#define fn_gnutls_session_set_data		gnutls_session_set_data
 #define fn_gnutls_strerror			gnutls_strerror
 #ifdef WINDOWSNT
 #define fn_gnutls_transport_set_errno		gnutls_transport_set_errno
@@ -349,7 +370,11 @@ emacs_gnutls_handshake (struct Lisp_Process *proc)
       emacs_gnutls_handle_error (state, ret);
       QUIT;
     }
-  while (ret < 0 && fn_gnutls_error_is_fatal (ret) == 0);
+  while (ret < 0 && fn_gnutls_error_is_fatal (ret) == 0
+	 /* A handshake going on in the background waits for the peer
+	    to answer instead of spinning.  */
+	 && (NILP (proc->gnutls_boot_parameters)
+	     || ret == GNUTLS_E_INTERRUPTED));
 
   proc->gnutls_initstage = GNUTLS_STAGE_HANDSHAKE_TRIED;
 
@@ -437,10 +462,18 @@ emacs_gnutls_read (struct Lisp_Process *proc, char *buf, ptrdiff_t nbyte)
          per process (connection), not globally.  */
       if (proc->gnutls_handshakes_tried < GNUTLS_EMACS_HANDSHAKES_LIMIT)
         {
+          int ret;
+
           proc->gnutls_handshakes_tried++;
-          emacs_gnutls_handshake (proc);
+          ret = emacs_gnutls_handshake (proc);
           GNUTLS_LOG2i (5, log_level, "Retried handshake",
                         proc->gnutls_handshakes_tried);
+          if (!NILP (proc->gnutls_boot_parameters))
+            {
+              if (ret == GNUTLS_E_SUCCESS || fn_gnutls_error_is_fatal (ret))
+                gnutls_finish_boot (proc, ret);
+              errno = EAGAIN;
+            }
           return -1;
         }
 
@@ -449,8 +482,24 @@ emacs_gnutls_read (struct Lisp_Process *proc, char *buf, ptrdiff_t nbyte)
       return 0;
     }
   rtnval = fn_gnutls_record_recv (state, buf, nbyte);
-  if (rtnval >= 0)
-    return rtnval;
+  if (rtnval > 0)
+    {
+      /* Each call yields at most one record, so go on decrypting the
+	 records that have already arrived while there is room.  The
+	 socket is nonblocking; an error is seen again on the next
+	 call.  */
+      ptrdiff_t total = rtnval;
+      while (total < nbyte)
+	{
+	  rtnval = fn_gnutls_record_recv (state, buf + total, nbyte - total);
+	  if (rtnval <= 0)
+	    break;
+	  total += rtnval;
+	}
+      return total;
+    }
+  else if (rtnval == 0)
+    return 0;
   else if (rtnval == GNUTLS_E_UNEXPECTED_PACKET_LENGTH)
     /* The peer closed the connection. */
     return 0;
@@ -728,6 +777,190 @@ emacs_gnutls_global_deinit (void)
 }
 #endif
 
+/* Remember the session STATE with HOSTNAME, so that the next
+   connection to HOSTNAME can resume it instead of doing a full
+   handshake.  */
+static void
+gnutls_save_session (gnutls_session_t state, Lisp_Object hostname)
+{
+  size_t size = 0;
+  Lisp_Object data, tail;
+
+  fn_gnutls_session_get_data (state, NULL, &size);
+  if (size == 0 || STRING_BYTES_BOUND < size)
+    return;
+  data = make_uninit_string (size);
+  if (fn_gnutls_session_get_data (state, SDATA (data), &size)
+      != GNUTLS_E_SUCCESS)
+    return;
+  if (size < SBYTES (data))
+    data = Fsubstring (data, make_number (0), make_number (size));
+
+  gnutls_sessions = Fdelete (Fassoc (hostname, gnutls_sessions),
+			     gnutls_sessions);
+  gnutls_sessions = Fcons (Fcons (hostname, data), gnutls_sessions);
+  tail = Fnthcdr (make_number (GNUTLS_SESSIONS_MAX - 1), gnutls_sessions);
+  if (CONSP (tail))
+    XSETCDR (tail, Qnil);
+}
+
+/* Verify the peer of PROC, whose handshake just succeeded, as
+   `gnutls-boot' with PROPLIST asks, and mark PROC as ready to use.
+   Return nil on success, a string describing a verification failure
+   after which PROC's TLS state was freed, or a GnuTLS error.  */
+static Lisp_Object
+gnutls_verify_boot (Lisp_Object proc, Lisp_Object proplist)
+{
+  int ret;
+  int max_log_level = XPROCESS (proc)->gnutls_log_level;
+  gnutls_session_t state = XPROCESS (proc)->gnutls_state;
+  unsigned int peer_verification;
+  Lisp_Object hostname = Fplist_get (proplist, QCgnutls_bootprop_hostname);
+  Lisp_Object loglevel = Fplist_get (proplist, QCgnutls_bootprop_loglevel);
+  Lisp_Object verify_error = Fplist_get (proplist,
+					 QCgnutls_bootprop_verify_error);
+  bool verify_error_all = EQ (verify_error, Qt);
+  char *c_hostname = SSDATA (hostname);
+
+  /* Now verify the peer, following
+     http://www.gnu.org/software/gnutls/manual/html_node/Verifying-peer_0027s-certificate.html.
+     The peer should present at least one certificate in the chain; do a
+     check of the certificate's hostname with
+     gnutls_x509_crt_check_hostname() against :hostname.  */
+
+  ret = fn_gnutls_certificate_verify_peers2 (state, &peer_verification);
+  if (ret < GNUTLS_E_SUCCESS)
+    return gnutls_make_error (ret);
+
+  if (XINT (loglevel) > 0 && peer_verification & GNUTLS_CERT_INVALID)
+    message ("%s certificate could not be verified.", c_hostname);
+
+  if (peer_verification & GNUTLS_CERT_REVOKED)
+    GNUTLS_LOG2 (1, max_log_level, "certificate was revoked (CRL):",
+		 c_hostname);
+
+  if (peer_verification & GNUTLS_CERT_SIGNER_NOT_FOUND)
+    GNUTLS_LOG2 (1, max_log_level, "certificate signer was not found:",
+		 c_hostname);
+
+  if (peer_verification & GNUTLS_CERT_SIGNER_NOT_CA)
+    GNUTLS_LOG2 (1, max_log_level, "certificate signer is not a CA:",
+		 c_hostname);
+
+  if (peer_verification & GNUTLS_CERT_INSECURE_ALGORITHM)
+    GNUTLS_LOG2 (1, max_log_level,
+		 "certificate was signed with an insecure algorithm:",
+		 c_hostname);
+
+  if (peer_verification & GNUTLS_CERT_NOT_ACTIVATED)
+    GNUTLS_LOG2 (1, max_log_level, "certificate is not yet activated:",
+		 c_hostname);
+
+  if (peer_verification & GNUTLS_CERT_EXPIRED)
+    GNUTLS_LOG2 (1, max_log_level, "certificate has expired:",
+		 c_hostname);
+
+  if (peer_verification != 0)
+    {
+      if (verify_error_all
+          || !NILP (Fmember (QCgnutls_bootprop_trustfiles, verify_error)))
+        {
+	  emacs_gnutls_deinit (proc);
+	  return format2 ("Certificate validation failed %s, "
+			  "verification code %d",
+			  hostname, make_number (peer_verification));
+        }
+      else
+	{
+          GNUTLS_LOG2 (1, max_log_level, "certificate validation failed:",
+                       c_hostname);
+	}
+    }
+
+  /* Up to here the process is the same for X.509 certificates and
+     OpenPGP keys.  From now on X.509 certificates are assumed.  This
+     can be easily extended to work with openpgp keys as well.  */
+  if (fn_gnutls_certificate_type_get (state) == GNUTLS_CRT_X509)
+    {
+      gnutls_x509_crt_t gnutls_verify_cert;
+      const gnutls_datum_t *gnutls_verify_cert_list;
+      unsigned int gnutls_verify_cert_list_size;
+
+      ret = fn_gnutls_x509_crt_init (&gnutls_verify_cert);
+      if (ret < GNUTLS_E_SUCCESS)
+	return gnutls_make_error (ret);
+
+      gnutls_verify_cert_list =
+	fn_gnutls_certificate_get_peers (state, &gnutls_verify_cert_list_size);
+
+      if (gnutls_verify_cert_list == NULL)
+	{
+	  fn_gnutls_x509_crt_deinit (gnutls_verify_cert);
+	  emacs_gnutls_deinit (proc);
+	  return build_string ("No x509 certificate was found");
+	}
+
+      /* We only check the first certificate in the given chain.  */
+      ret = fn_gnutls_x509_crt_import (gnutls_verify_cert,
+				       &gnutls_verify_cert_list[0],
+				       GNUTLS_X509_FMT_DER);
+
+      if (ret < GNUTLS_E_SUCCESS)
+	{
+	  fn_gnutls_x509_crt_deinit (gnutls_verify_cert);
+	  return gnutls_make_error (ret);
+	}
+
+      if (!fn_gnutls_x509_crt_check_hostname (gnutls_verify_cert, c_hostname))
+	{
+          if (verify_error_all
+              || !NILP (Fmember (QCgnutls_bootprop_hostname, verify_error)))
+            {
+	      fn_gnutls_x509_crt_deinit (gnutls_verify_cert);
+	      emacs_gnutls_deinit (proc);
+	      return format2 ("The x509 certificate does not match \"%s\"",
+			      hostname, Qnil);
+            }
+	  else
+	    {
+              GNUTLS_LOG2 (1, max_log_level, "x509 certificate does not match:",
+                           c_hostname);
+	    }
+	}
+      fn_gnutls_x509_crt_deinit (gnutls_verify_cert);
+    }
+
+  /* Set this flag only if the whole initialization succeeded.  */
+  XPROCESS (proc)->gnutls_p = 1;
+
+  if (gnutls_resume_sessions)
+    gnutls_save_session (state,
+			 Fsubstring_no_properties (hostname, Qnil, Qnil));
+
+  /* Read whole records at a time.  */
+  if (XPROCESS (proc)->read_output_max < GNUTLS_RECORD_MAX)
+    XPROCESS (proc)->read_output_max = GNUTLS_RECORD_MAX;
+
+  return Qnil;
+}
+
+/* Finish the handshake that `gnutls-boot' left running for process P,
+   now that it ended with RET, and tell P's sentinel about it.  */
+static void
+gnutls_finish_boot (struct Lisp_Process *p, int ret)
+{
+  Lisp_Object proc, proplist = p->gnutls_boot_parameters, result;
+
+  XSETPROCESS (proc, p);
+  pset_gnutls_boot_parameters (p, Qnil);
+  result = (ret < GNUTLS_E_SUCCESS
+	    ? gnutls_make_error (ret)
+	    : gnutls_verify_boot (proc, proplist));
+  if (!NILP (result) && !STRINGP (result))
+    result = Fgnutls_error_string (result);
+  finish_process_tls (proc, result);
+}
+
 DEFUN ("gnutls-boot", Fgnutls_boot, Sgnutls_boot, 3, 3, 0,
        doc: /* Initialize GnuTLS client for process PROC with TYPE+PROPLIST.
 Currently only client mode is supported.  Return a success/failure
@@ -764,6 +997,12 @@ instead.
 :min-prime-bits is the minimum accepted number of bits the client will
 accept in Diffie-Hellman key exchange.
 
+:nowait, if non-nil, says not to wait for a handshake that cannot
+complete at once.  The return value is then `gnutls-e-again', and the
+handshake goes on as the peer answers.  When it ends, the process
+sentinel is called with "TLS established\n", or with a string starting
+with "TLS failed" after which the process is closed.
+
 The debug level will be set for this process AND globally for GnuTLS.
 So if you set it higher or lower at any point, it affects global
 debugging.
@@ -786,15 +1025,12 @@ one trustfile (usually a CA bundle).  */)
 {
   int ret = GNUTLS_E_SUCCESS;
   int max_log_level = 0;
-  bool verify_error_all = 0;
 
   gnutls_session_t state;
   gnutls_certificate_credentials_t x509_cred = NULL;
   gnutls_anon_client_credentials_t anon_cred = NULL;
   Lisp_Object global_init;
   char const *priority_string_ptr = "NORMAL"; /* default priority string.  */
-  unsigned int peer_verification;
-  char *c_hostname;
 
   /* Placeholders for the property list elements.  */
   Lisp_Object priority_string;
@@ -806,6 +1042,7 @@ one trustfile (usually a CA bundle).  */)
   Lisp_Object hostname;
   Lisp_Object verify_error;
   Lisp_Object prime_bits;
+  Lisp_Object result;
 
   CHECK_PROCESS (proc);
   CHECK_SYMBOL (type);
@@ -826,18 +1063,13 @@ one trustfile (usually a CA bundle).  */)
   verify_error          = Fplist_get (proplist, QCgnutls_bootprop_verify_error);
   prime_bits            = Fplist_get (proplist, QCgnutls_bootprop_min_prime_bits);
 
-  if (EQ (verify_error, Qt))
-    {
-      verify_error_all = 1;
-    }
-  else if (NILP (Flistp (verify_error)))
+  if (!EQ (verify_error, Qt) && NILP (Flistp (verify_error)))
     {
       error ("gnutls-boot: invalid :verify_error parameter (not a list)");
     }
 
   if (!STRINGP (hostname))
     error ("gnutls-boot: invalid :hostname parameter (not a string)");
-  c_hostname = SSDATA (hostname);
 
   state = XPROCESS (proc)->gnutls_state;
 
@@ -1034,120 +1266,42 @@ one trustfile (usually a CA bundle).  */)
     return gnutls_make_error (ret);
 
   GNUTLS_INITSTAGE (proc) = GNUTLS_STAGE_CRED_SET;
-  ret = emacs_gnutls_handshake (XPROCESS (proc));
-  if (ret < GNUTLS_E_SUCCESS)
-    return gnutls_make_error (ret);
 
-  /* Now verify the peer, following
-     http://www.gnu.org/software/gnutls/manual/html_node/Verifying-peer_0027s-certificate.html.
-     The peer should present at least one certificate in the chain; do a
-     check of the certificate's hostname with
-     gnutls_x509_crt_check_hostname() against :hostname.  */
-
-  ret = fn_gnutls_certificate_verify_peers2 (state, &peer_verification);
-  if (ret < GNUTLS_E_SUCCESS)
-    return gnutls_make_error (ret);
-
-  if (XINT (loglevel) > 0 && peer_verification & GNUTLS_CERT_INVALID)
-    message ("%s certificate could not be verified.", c_hostname);
-
-  if (peer_verification & GNUTLS_CERT_REVOKED)
-    GNUTLS_LOG2 (1, max_log_level, "certificate was revoked (CRL):",
-		 c_hostname);
-
-  if (peer_verification & GNUTLS_CERT_SIGNER_NOT_FOUND)
-    GNUTLS_LOG2 (1, max_log_level, "certificate signer was not found:",
-		 c_hostname);
-
-  if (peer_verification & GNUTLS_CERT_SIGNER_NOT_CA)
-    GNUTLS_LOG2 (1, max_log_level, "certificate signer is not a CA:",
-		 c_hostname);
-
-  if (peer_verification & GNUTLS_CERT_INSECURE_ALGORITHM)
-    GNUTLS_LOG2 (1, max_log_level,
-		 "certificate was signed with an insecure algorithm:",
-		 c_hostname);
-
-  if (peer_verification & GNUTLS_CERT_NOT_ACTIVATED)
-    GNUTLS_LOG2 (1, max_log_level, "certificate is not yet activated:",
-		 c_hostname);
-
-  if (peer_verification & GNUTLS_CERT_EXPIRED)
-    GNUTLS_LOG2 (1, max_log_level, "certificate has expired:",
-		 c_hostname);
-
-  if (peer_verification != 0)
+  if (gnutls_resume_sessions)
     {
-      if (verify_error_all
-          || !NILP (Fmember (QCgnutls_bootprop_trustfiles, verify_error)))
-        {
-	  emacs_gnutls_deinit (proc);
-	  error ("Certificate validation failed %s, verification code %d",
-		 c_hostname, peer_verification);
-        }
-      else
-	{
-          GNUTLS_LOG2 (1, max_log_level, "certificate validation failed:",
-                       c_hostname);
-	}
+      Lisp_Object saved = Fcdr (Fassoc (hostname, gnutls_sessions));
+      if (STRINGP (saved))
+	fn_gnutls_session_set_data (state, SDATA (saved), SBYTES (saved));
     }
 
-  /* Up to here the process is the same for X.509 certificates and
-     OpenPGP keys.  From now on X.509 certificates are assumed.  This
-     can be easily extended to work with openpgp keys as well.  */
-  if (fn_gnutls_certificate_type_get (state) == GNUTLS_CRT_X509)
+  if (!NILP (Fplist_get (proplist, QCgnutls_bootprop_nowait)))
     {
-      gnutls_x509_crt_t gnutls_verify_cert;
-      const gnutls_datum_t *gnutls_verify_cert_list;
-      unsigned int gnutls_verify_cert_list_size;
-
-      ret = fn_gnutls_x509_crt_init (&gnutls_verify_cert);
-      if (ret < GNUTLS_E_SUCCESS)
-	return gnutls_make_error (ret);
-
-      gnutls_verify_cert_list =
-	fn_gnutls_certificate_get_peers (state, &gnutls_verify_cert_list_size);
-
-      if (gnutls_verify_cert_list == NULL)
-	{
-	  fn_gnutls_x509_crt_deinit (gnutls_verify_cert);
-	  emacs_gnutls_deinit (proc);
-	  error ("No x509 certificate was found\n");
-	}
-
-      /* We only check the first certificate in the given chain.  */
-      ret = fn_gnutls_x509_crt_import (gnutls_verify_cert,
-				       &gnutls_verify_cert_list[0],
-				       GNUTLS_X509_FMT_DER);
-
+      /* Let the handshake go on as the peer answers; emacs_gnutls_read
+	 drives it from now on, and gnutls_finish_boot completes it.  */
+      pset_gnutls_boot_parameters (XPROCESS (proc), proplist);
+      XPROCESS (proc)->gnutls_p = 1;
+      ret = emacs_gnutls_handshake (XPROCESS (proc));
       if (ret < GNUTLS_E_SUCCESS)
 	{
-	  fn_gnutls_x509_crt_deinit (gnutls_verify_cert);
+	  if (!fn_gnutls_error_is_fatal (ret))
+	    return Qgnutls_e_again;
+	  pset_gnutls_boot_parameters (XPROCESS (proc), Qnil);
+	  XPROCESS (proc)->gnutls_p = 0;
 	  return gnutls_make_error (ret);
 	}
-
-      if (!fn_gnutls_x509_crt_check_hostname (gnutls_verify_cert, c_hostname))
-	{
-          if (verify_error_all
-              || !NILP (Fmember (QCgnutls_bootprop_hostname, verify_error)))
-            {
-	      fn_gnutls_x509_crt_deinit (gnutls_verify_cert);
-	      emacs_gnutls_deinit (proc);
-	      error ("The x509 certificate does not match \"%s\"", c_hostname);
-            }
-	  else
-	    {
-              GNUTLS_LOG2 (1, max_log_level, "x509 certificate does not match:",
-                           c_hostname);
-	    }
-	}
-      fn_gnutls_x509_crt_deinit (gnutls_verify_cert);
+      pset_gnutls_boot_parameters (XPROCESS (proc), Qnil);
+    }
+  else
+    {
+      ret = emacs_gnutls_handshake (XPROCESS (proc));
+      if (ret < GNUTLS_E_SUCCESS)
+	return gnutls_make_error (ret);
     }
 
-  /* Set this flag only if the whole initialization succeeded.  */
-  XPROCESS (proc)->gnutls_p = 1;
-
-  return gnutls_make_error (ret);
+  result = gnutls_verify_boot (proc, proplist);
+  if (STRINGP (result))
+    error ("%s", SSDATA (result));
+  return NILP (result) ? gnutls_make_error (ret) : result;
 }
 
 DEFUN ("gnutls-bye", Fgnutls_bye,
@@ -1185,6 +1339,8 @@ syms_of_gnutls (void)
 #include "gnutls.x"
 
   gnutls_global_initialized = 0;
+  gnutls_sessions = Qnil;
+  staticpro (&gnutls_sessions);
 
   DEFSYM (Qgnutls_dll, "gnutls");
   DEFSYM (Qgnutls_code, "gnutls-code");
@@ -1201,6 +1357,7 @@ syms_of_gnutls (void)
   DEFSYM (QCgnutls_bootprop_loglevel, ":loglevel");
   DEFSYM (QCgnutls_bootprop_verify_flags, ":verify-flags");
   DEFSYM (QCgnutls_bootprop_verify_error, ":verify-error");
+  DEFSYM (QCgnutls_bootprop_nowait, ":nowait");
 
   DEFSYM (Qgnutls_e_interrupted, "gnutls-e-interrupted");
   Fput (Qgnutls_e_interrupted, Qgnutls_code,
@@ -1224,6 +1381,13 @@ Set this larger than 0 to get debug output in the *Messages* buffer.
 1 is for important messages, 2 is for debug data, and higher numbers
 are as per the GnuTLS logging conventions.  */);
   global_gnutls_log_level = 0;
+
+  DEFVAR_BOOL ("gnutls-resume-sessions", gnutls_resume_sessions,
+	       doc: /* Non-nil means resume earlier TLS sessions where possible.
+`gnutls-boot' then remembers the last few sessions by host name, and
+offers the saved session to the server when connecting to the same
+host again, which saves a full handshake if the server agrees.  */);
+  gnutls_resume_sessions = 1;
 }
 
 #endif /* HAVE_GNUTLS */
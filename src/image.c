@@ -997,6 +997,7 @@ free_image (struct frame *f, struct image *img)
 	img->next->prev = img->prev;
 
       c->images[img->id] = NULL;
+      c->bytes -= img->bytes;
 
       /* Windows NT redefines 'free', but in this file, we need to
          avoid the redefinition.  */
@@ -1038,6 +1039,35 @@ check_image_size (struct frame *f, int width, int height)
     return 1;
 }
 
+#if (defined HAVE_PNG && !defined HAVE_NS) || defined HAVE_JPEG
+
+/* Return the factor, a power of 2 no larger than 8, by which loaders
+   that can cheaply skip pixels should shrink IMG of native size WIDTH
+   x HEIGHT so that it fits within the `:max-width' and `:max-height'
+   of its spec.  Value is 1 if IMG should be loaded at full size.  */
+
+static int
+image_shrink_factor (struct image *img, double width, double height)
+{
+  Lisp_Object value;
+  double max_width = width, max_height = height;
+  int factor = 1;
+
+  value = image_spec_value (img->spec, QCmax_width, NULL);
+  if (NATNUMP (value) && XFASTINT (value) > 0)
+    max_width = XFASTINT (value);
+  value = image_spec_value (img->spec, QCmax_height, NULL);
+  if (NATNUMP (value) && XFASTINT (value) > 0)
+    max_height = XFASTINT (value);
+
+  while (factor < 8
+	 && (width / factor > max_width || height / factor > max_height))
+    factor *= 2;
+  return factor;
+}
+
+#endif /* (HAVE_PNG && !HAVE_NS) || HAVE_JPEG */
+
 /* Prepare image IMG for display on frame F.  Must be called before
    drawing an image.  */
 
@@ -1383,6 +1413,7 @@ make_image_cache (void)
 
   c->size = 50;
   c->used = c->refcount = 0;
+  c->bytes = 0;
   c->images = xmalloc (c->size * sizeof *c->images);
   c->buckets = xzalloc (IMAGE_CACHE_BUCKETS_SIZE * sizeof *c->buckets);
   return c;
@@ -1462,13 +1493,67 @@ free_image_cache (struct frame *f)
 }
 
 
+/* True if an image cache has grown beyond `image-cache-size' since
+   the image caches were last cleared.  */
+
+bool image_cache_full;
+
+static int
+compare_image_timestamps (const void *a, const void *b)
+{
+  struct image *img_a = *(struct image * const *) a;
+  struct image *img_b = *(struct image * const *) b;
+
+  return timespec_cmp (img_a->timestamp, img_b->timestamp);
+}
+
+/* Free the least recently displayed images in the image cache of
+   frame F until its images take no more than LIMIT bytes.  Images
+   displayed within the last second are kept, so that a window showing
+   more than LIMIT bytes of images does not reload them over and over.
+   Value is the number of images freed.  */
+
+static ptrdiff_t
+trim_image_cache (struct frame *f, EMACS_INT limit)
+{
+  struct image_cache *c = FRAME_IMAGE_CACHE (f);
+  struct image **images;
+  struct timespec recent;
+  ptrdiff_t i, n, nfreed = 0;
+  USE_SAFE_ALLOCA;
+
+  if (c->bytes <= limit)
+    return 0;
+
+  SAFE_NALLOCA (images, 1, c->used);
+  for (i = n = 0; i < c->used; ++i)
+    if (c->images[i] && c->images[i]->bytes > 0)
+      images[n++] = c->images[i];
+  qsort (images, n, sizeof *images, compare_image_timestamps);
+
+  recent = timespec_sub (current_timespec (), make_timespec (1, 0));
+  for (i = 0; i < n && c->bytes > limit; ++i)
+    {
+      if (timespec_cmp (images[i]->timestamp, recent) >= 0)
+	break;
+      free_image (f, images[i]);
+      ++nfreed;
+    }
+
+  SAFE_FREE ();
+  return nfreed;
+}
+
+
 /* Clear image cache of frame F.  FILTER=t means free all images.
    FILTER=nil means clear only images that haven't been
    displayed for some time.
    Else, only free the images which have FILTER in their `dependencies'.
    Should be called from time to time to reduce the number of loaded images.
    If image-cache-eviction-delay is non-nil, this frees images in the cache
-   which weren't displayed for at least that many seconds.  */
+   which weren't displayed for at least that many seconds.  If
+   image-cache-size is non-nil, FILTER=nil also frees the least recently
+   displayed images until the cache is no larger than that.  */
 
 static void
 clear_image_cache (struct frame *f, Lisp_Object filter)
@@ -1529,6 +1614,9 @@ clear_image_cache (struct frame *f, Lisp_Object filter)
 	    }
 	}
 
+      if (NILP (filter) && INTEGERP (Vimage_cache_size))
+	nfreed += trim_image_cache (f, XINT (Vimage_cache_size));
+
       /* We may be clearing the image cache because, for example,
 	 Emacs was iconified for a longer period of time.  In that
 	 case, current matrices may still contain references to
@@ -1559,6 +1647,7 @@ clear_image_caches (Lisp_Object filter)
    * for (t = terminal_list; t; t = t->next_terminal)
    *   clear_image_cache (t, filter); */
   Lisp_Object tail, frame;
+  image_cache_full = 0;
   FOR_EACH_FRAME (tail, frame)
     if (FRAME_WINDOW_P (XFRAME (frame)))
       clear_image_cache (XFRAME (frame), filter);
@@ -1683,6 +1772,26 @@ postprocess_image (struct frame *f, struct image *img)
 }
 
 
+/* Count the bytes that IMG, just loaded on frame F, takes in F's image
+   cache.  Pixmaps are assumed to hold 4 bytes per pixel, and masks 1
+   bit.  If that brings the cache over `image-cache-size', arrange for
+   redisplay to trim the cache when it is done.  */
+
+static void
+note_image_bytes (struct frame *f, struct image *img)
+{
+  struct image_cache *c = FRAME_IMAGE_CACHE (f);
+  ptrdiff_t pixels = (ptrdiff_t) img->width * img->height;
+
+  img->bytes = 4 * pixels;
+  if (img->mask != NO_PIXMAP)
+    img->bytes += pixels / 8;
+  c->bytes += img->bytes;
+  if (INTEGERP (Vimage_cache_size) && c->bytes > XINT (Vimage_cache_size))
+    image_cache_full = 1;
+}
+
+
 /* Return the id of image with Lisp specification SPEC on frame F.
    SPEC must be a valid Lisp image specification (see valid_image_p).  */
 
@@ -1778,6 +1887,8 @@ lookup_image (struct frame *f, Lisp_Object spec)
 	     don't have the image yet.  */
 	  if (!EQ (*img->type->type, Qpostscript))
 	    postprocess_image (f, img);
+
+	  note_image_bytes (f, img);
 	}
 
       unblock_input ();
@@ -5523,6 +5634,7 @@ DEF_IMGLIB_FN (void, png_read_update_info, (png_structp, png_infop));
 DEF_IMGLIB_FN (png_byte, png_get_channels, (png_structp, png_infop));
 DEF_IMGLIB_FN (png_size_t, png_get_rowbytes, (png_structp, png_infop));
 DEF_IMGLIB_FN (void, png_read_image, (png_structp, png_bytepp));
+DEF_IMGLIB_FN (void, png_read_row, (png_structp, png_bytep, png_bytep));
 DEF_IMGLIB_FN (void, png_read_end, (png_structp, png_infop));
 DEF_IMGLIB_FN (void, png_error, (png_structp, png_const_charp));
 
@@ -5558,6 +5670,7 @@ init_png_functions (void)
   LOAD_IMGLIB_FN (library, png_get_channels);
   LOAD_IMGLIB_FN (library, png_get_rowbytes);
   LOAD_IMGLIB_FN (library, png_read_image);
+  LOAD_IMGLIB_FN (library, png_read_row);
   LOAD_IMGLIB_FN (library, png_read_end);
   LOAD_IMGLIB_FN (library, png_error);
 
@@ -5589,6 +5702,7 @@ init_png_functions (void)
 #define fn_png_get_channels		png_get_channels
 #define fn_png_get_rowbytes		png_get_rowbytes
 #define fn_png_read_image		png_read_image
+#define fn_png_read_row			png_read_row
 #define fn_png_read_end			png_read_end
 #define fn_png_error			png_error
 
@@ -5717,6 +5831,8 @@ png_load_body (struct frame *f, struct image *img, struct png_load_context *c)
   png_uint_32 row_bytes;
   bool transparent_p;
   struct png_memory_storage tbr;  /* Data to be read */
+  int shrink, ximg_width, ximg_height;
+  ptrdiff_t nrows, row_step;
 
   /* Find out what file to load.  */
   specified_file = image_spec_value (img->spec, QCfile, NULL);
@@ -5836,9 +5952,16 @@ png_load_body (struct frame *f, struct image *img, struct png_load_context *c)
       goto error;
     }
 
+  /* Keep only every SHRINK'th pixel of every SHRINK'th row of images
+     larger than :max-width or :max-height.  */
+  shrink = image_shrink_factor (img, width, height);
+  ximg_width = (width + shrink - 1) / shrink;
+  ximg_height = (height + shrink - 1) / shrink;
+
   /* Create the X image and pixmap now, so that the work below can be
      omitted if the image is too large for X.  */
-  if (!image_create_x_image_and_pixmap (f, img, width, height, 0, &ximg, 0))
+  if (!image_create_x_image_and_pixmap (f, img, ximg_width, ximg_height, 0,
+					&ximg, 0))
     goto error;
 
   /* If image contains simply transparency data, we prefer to
@@ -5908,17 +6031,29 @@ png_load_body (struct frame *f, struct image *img, struct png_load_context *c)
   /* Number of bytes needed for one row of the image.  */
   row_bytes = fn_png_get_rowbytes (png_ptr, info_ptr);
 
-  /* Allocate memory for the image.  */
-  if (min (PTRDIFF_MAX, SIZE_MAX) / sizeof *rows < height
-      || min (PTRDIFF_MAX, SIZE_MAX) / sizeof *pixels / height < row_bytes)
+  /* Allocate memory for the image.  An interlaced image must be read
+     in full; otherwise, keep only the rows that are used, and read
+     the others into one more row that is overwritten each time.  */
+  if (interlace_type == PNG_INTERLACE_NONE)
+    nrows = ximg_height + 1, row_step = 1;
+  else
+    nrows = height, row_step = shrink;
+  if (min (PTRDIFF_MAX, SIZE_MAX) / sizeof *rows < nrows
+      || min (PTRDIFF_MAX, SIZE_MAX) / sizeof *pixels / nrows < row_bytes)
     memory_full (SIZE_MAX);
-  c->pixels = pixels = xmalloc_atomic (sizeof *pixels * row_bytes * height);
-  c->rows = rows = xmalloc_atomic (height * sizeof *rows);
-  for (i = 0; i < height; ++i)
+  c->pixels = pixels = xmalloc_atomic (sizeof *pixels * row_bytes * nrows);
+  c->rows = rows = xmalloc_atomic (nrows * sizeof *rows);
+  for (i = 0; i < nrows; ++i)
     rows[i] = pixels + i * row_bytes;
 
   /* Read the entire image.  */
-  fn_png_read_image (png_ptr, rows);
+  if (interlace_type == PNG_INTERLACE_NONE)
+    for (i = 0; i < height; ++i)
+      fn_png_read_row (png_ptr,
+		       rows[i % shrink == 0 ? i / shrink : ximg_height],
+		       NULL);
+  else
+    fn_png_read_image (png_ptr, rows);
   fn_png_read_end (png_ptr, info_ptr);
   if (fp)
     {
@@ -5930,8 +6065,8 @@ png_load_body (struct frame *f, struct image *img, struct png_load_context *c)
      contains an alpha channel.  */
   if (channels == 4
       && !transparent_p
-      && !image_create_x_image_and_pixmap (f, img, width, height, 1,
-					   &mask_img, 1))
+      && !image_create_x_image_and_pixmap (f, img, ximg_width, ximg_height,
+					   1, &mask_img, 1))
     {
       x_destroy_x_image (ximg);
       x_clear_image_1 (f, img, CLEAR_IMAGE_PIXMAP);
@@ -5941,12 +6076,13 @@ png_load_body (struct frame *f, struct image *img, struct png_load_context *c)
   /* Fill the X image and mask from PNG data.  */
   init_color_table ();
 
-  for (y = 0; y < height; ++y)
+  for (y = 0; y < ximg_height; ++y)
     {
-      png_byte *p = rows[y];
+      png_byte *row = rows[y * row_step];
 
-      for (x = 0; x < width; ++x)
+      for (x = 0; x < ximg_width; ++x)
 	{
+	  png_byte *p = row + (ptrdiff_t) x * shrink * channels;
 	  int r, g, b;
 
 	  r = *p++ << 8;
@@ -6001,8 +6137,8 @@ png_load_body (struct frame *f, struct image *img, struct png_load_context *c)
   xfree (rows);
   xfree (pixels);
 
-  img->width = width;
-  img->height = height;
+  img->width = ximg_width;
+  img->height = ximg_height;
 
   /* Maybe fill in the background field while we have ximg handy.
      Casting avoids a GCC warning.  */
@@ -6525,6 +6661,13 @@ jpeg_load_body (struct frame *f, struct image *img,
 
   fn_jpeg_read_header (&mgr->cinfo, 1);
 
+  /* Let libjpeg shrink large images to :max-width and :max-height
+     while decoding; that is much cheaper than decoding them in
+     full.  */
+  mgr->cinfo.scale_num = 1;
+  mgr->cinfo.scale_denom = image_shrink_factor (img, mgr->cinfo.image_width,
+						mgr->cinfo.image_height);
+
   /* Customize decompression so that color quantization will be used.
 	 Start decompression.  */
   mgr->cinfo.quantize_colors = 1;
@@ -9501,6 +9644,14 @@ The value can also be nil, meaning the cache is never cleared.
 
 The function `clear-image-cache' disregards this variable.  */);
   Vimage_cache_eviction_delay = make_number (300);
+
+  DEFVAR_LISP ("image-cache-size", Vimage_cache_size,
+    doc: /* Maximum number of bytes of images to keep in the image cache.
+When the images in a frame's image cache take more than this, the
+images that were displayed least recently are removed from the cache
+at the end of the next redisplay.  Images are counted as 4 bytes per
+pixel.  The value can also be nil, meaning there is no such limit.  */);
+  Vimage_cache_size = make_number (256 * 1024 * 1024);
 #ifdef HAVE_IMAGEMAGICK
   DEFVAR_INT ("imagemagick-render-type", imagemagick_render_type,
     doc: /* Integer indicating which ImageMagick rendering method to use.
@@ -53,6 +53,37 @@ ptrdiff_t last_known_column_point;
 
 static EMACS_INT last_known_column_modified;
 
+/* Columns of some positions on the line scan_for_column last scanned,
+   so that later scans of the same line can start from the nearest one
+   before their target instead of from the beginning of the line.
+   Positions are recorded only inside runs of printable ASCII text, where
+   no scanning state but the column itself carries over.  */
+
+enum { COLUMN_CHECKPOINTS = 64 };
+
+static struct column_cache
+{
+  /* The buffer and line the checkpoints are for, and the state of the
+     buffer that they are valid in.  */
+  struct buffer *buffer;
+  ptrdiff_t line_start;
+  EMACS_INT modiff, overlay_modiff;
+  Lisp_Object invisibility_spec, selective_display;
+  int tab_width;
+  bool ctl_arrow;
+
+  /* Minimum distance between checkpoints.  It doubles whenever the
+     table fills up and every other checkpoint is dropped.  */
+  ptrdiff_t interval;
+
+  /* Checkpoints, in increasing order of position.  */
+  int n;
+  struct column_checkpoint
+  {
+    ptrdiff_t pos, pos_byte, col, prev_col;
+  } points[COLUMN_CHECKPOINTS];
+} column_cache;
+
 static ptrdiff_t current_column_1 (void);
 static ptrdiff_t position_indentation (ptrdiff_t);
 
@@ -510,6 +541,95 @@ check_display_width (ptrdiff_t pos, ptrdiff_t col, ptrdiff_t *endpos)
   return -1;
 }
 
+/* Return true if the column cache holds checkpoints for the line of the
+   current buffer that starts at LINE_START.  If not, reset it for that
+   line.  */
+
+static bool
+column_cache_valid_p (ptrdiff_t line_start, int tab_width, bool ctl_arrow)
+{
+  struct column_cache *cache = &column_cache;
+
+  if (cache->buffer == current_buffer
+      && cache->line_start == line_start
+      && cache->modiff == MODIFF
+      && cache->overlay_modiff == OVERLAY_MODIFF
+      && EQ (cache->invisibility_spec,
+	     BVAR (current_buffer, invisibility_spec))
+      && EQ (cache->selective_display,
+	     BVAR (current_buffer, selective_display))
+      && cache->tab_width == tab_width
+      && cache->ctl_arrow == ctl_arrow)
+    return true;
+
+  cache->buffer = current_buffer;
+  cache->line_start = line_start;
+  cache->modiff = MODIFF;
+  cache->overlay_modiff = OVERLAY_MODIFF;
+  cache->invisibility_spec = BVAR (current_buffer, invisibility_spec);
+  cache->selective_display = BVAR (current_buffer, selective_display);
+  cache->tab_width = tab_width;
+  cache->ctl_arrow = ctl_arrow;
+  cache->interval = 256;
+  cache->n = 0;
+  return false;
+}
+
+/* Record in the column cache that position POS, POS_BYTE is at column
+   COL, and the character before it at PREV_COL.  */
+
+static void
+column_cache_record (ptrdiff_t pos, ptrdiff_t pos_byte,
+		     ptrdiff_t col, ptrdiff_t prev_col)
+{
+  struct column_cache *cache = &column_cache;
+  struct column_checkpoint *p;
+  int i;
+
+  for (i = cache->n; 0 < i && pos < cache->points[i - 1].pos; i--)
+    continue;
+  if ((0 < i && pos - cache->points[i - 1].pos < cache->interval)
+      || (i < cache->n && cache->points[i].pos - pos < cache->interval)
+      || (pos - cache->line_start < cache->interval))
+    return;
+
+  if (cache->n == COLUMN_CHECKPOINTS)
+    {
+      int j;
+
+      for (j = 0; 2 * j + 1 < cache->n; j++)
+	cache->points[j] = cache->points[2 * j + 1];
+      cache->n = j;
+      cache->interval *= 2;
+      column_cache_record (pos, pos_byte, col, prev_col);
+      return;
+    }
+
+  memmove (&cache->points[i + 1], &cache->points[i],
+	   (cache->n - i) * sizeof *cache->points);
+  cache->n++;
+  p = &cache->points[i];
+  p->pos = pos;
+  p->pos_byte = pos_byte;
+  p->col = col;
+  p->prev_col = prev_col;
+}
+
+/* Return the last checkpoint of the column cache at or before END
+   and before column GOAL, or NULL if there is none.  */
+
+static struct column_checkpoint *
+column_cache_lookup (ptrdiff_t end, EMACS_INT goal)
+{
+  struct column_cache *cache = &column_cache;
+  int i;
+
+  for (i = cache->n; 0 < i; i--)
+    if (cache->points[i - 1].pos <= end && cache->points[i - 1].col < goal)
+      return &cache->points[i - 1];
+  return NULL;
+}
+
 /* Scanning from the beginning of the current line, stop at the buffer
    position ENDPOS or at the column GOALCOL or at the end of line, whichever
    comes first.
@@ -532,9 +652,25 @@ scan_for_column (ptrdiff_t *endpos, EMACS_INT *goalcol, ptrdiff_t *prevcol)
   EMACS_INT goal = goalcol ? *goalcol : MOST_POSITIVE_FIXNUM;
   ptrdiff_t end = endpos ? *endpos : PT;
   ptrdiff_t scan, scan_byte, next_boundary;
+  /* The text before this has no `display' property.  */
+  ptrdiff_t display_limit;
 
   scan = find_newline (PT, PT_BYTE, BEGV, BEGV_BYTE, -1, NULL, &scan_byte, 1);
-  next_boundary = scan;
+
+  /* Start from a known column closer to the target, if there is one.
+     Checkpoints are only made without a display table.  */
+  if (column_cache_valid_p (scan, tab_width, ctl_arrow) && !dp)
+    {
+      struct column_checkpoint *p = column_cache_lookup (end, goal);
+      if (p)
+	{
+	  scan = p->pos;
+	  scan_byte = p->pos_byte;
+	  col = p->col;
+	  prev_col = p->prev_col;
+	}
+    }
+  next_boundary = display_limit = scan;
 
   window = Fget_buffer_window (Fcurrent_buffer (), Qnil);
   w = ! NILP (window) ? XWINDOW (window) : NULL;
@@ -568,6 +704,15 @@ scan_for_column (ptrdiff_t *endpos, EMACS_INT *goalcol, ptrdiff_t *prevcol)
 	break;
       prev_col = col;
 
+      /* Look for the next display property only once per stretch of
+	 text without one.  */
+      if (scan >= display_limit
+	  && NILP (Fget_char_property (make_number (scan), Qdisplay, Qnil)))
+	display_limit
+	  = XFASTINT (Fnext_single_char_property_change (make_number (scan),
+							 Qdisplay, Qnil,
+							 make_number (end)));
+      if (scan >= display_limit)
       { /* Check display property.  */
 	ptrdiff_t endp;
 	int width = check_display_width (scan, col, &endp);
@@ -606,6 +751,30 @@ scan_for_column (ptrdiff_t *endpos, EMACS_INT *goalcol, ptrdiff_t *prevcol)
 	  continue;
 	}
 
+      /* Printable ASCII characters take one column each, so go over a
+	 run of them at once when nothing else can apply to them.  */
+      if (!dp)
+	{
+	  ptrdiff_t limit = min (min (end, next_boundary),
+				 min (display_limit, cmp_it.stop_pos));
+	  ptrdiff_t start = scan;
+
+	  while (scan < limit && col < goal)
+	    {
+	      c = FETCH_BYTE (scan_byte);
+	      if (! (040 <= c && c < 0177))
+		break;
+	      if (scan > start
+		  && scan % column_cache.interval == 0)
+		column_cache_record (scan, scan_byte, col, prev_col);
+	      prev_col = col++;
+	      scan++;
+	      scan_byte++;
+	    }
+	  if (scan > start)
+	    continue;
+	}
+
       c = FETCH_BYTE (scan_byte);
 
       /* See if there is a display table and it relates
@@ -2045,6 +2214,10 @@ whether or not it is currently displayed in some window.  */)
 	 really at some x > 0.  */
       reseat_at_previous_visible_line_start (&it);
       it.current_x = it.hpos = 0;
+      /* In a long line, start from a screen line known to begin
+	 before PT, if there is one.  */
+      if (!disp_string_at_start_p)
+	start_it_checkpoints (&it, PT);
       if (IT_CHARPOS (it) != PT)
 	/* We used to temporarily disable selective display here; the
 	   comment said this is "so we don't move too far" (2005-01-19
@@ -2165,4 +2338,7 @@ syms_of_indent (void)
   DEFVAR_BOOL ("indent-tabs-mode", indent_tabs_mode,
 	       doc: /* Indentation can insert tabs if this is non-nil.  */);
   indent_tabs_mode = 1;
+
+  column_cache.invisibility_spec = Qnil;
+  column_cache.selective_display = Qnil;
 }
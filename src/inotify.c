@@ -52,11 +52,16 @@ static Lisp_Object Qmask_add;      /* IN_MASK_ADD */
 static Lisp_Object Qoneshot;       /* IN_ONESHOT */
 static Lisp_Object Qonlydir;       /* IN_ONLYDIR */
 
+static Lisp_Object Qbatch;
+static Lisp_Object Qrecursive;
+
 static Lisp_Object Qignored;       /* IN_IGNORED */
 static Lisp_Object Qisdir;         /* IN_ISDIR */
 static Lisp_Object Qq_overflow;    /* IN_Q_OVERFLOW */
 static Lisp_Object Qunmount;       /* IN_UNMOUNT */
 
+#include <dirent.h>
+#include <sys/stat.h>
 #include <sys/inotify.h>
 #include <sys/ioctl.h>
 
@@ -76,10 +81,31 @@ static int inotifyfd = -1;
 
 /* Assoc list of files being watched.
    Format:
-   (watch-descriptor . callback)
+   (watch-descriptor . [callback mask flags root directory prefix])
+
+   MASK is the mask asked for, FLAGS the list of `batch' and
+   `recursive' given with it, and DIRECTORY the encoded name of the
+   watched file.  A watch returned by `inotify-add-watch' is its own
+   ROOT and has a nil PREFIX.  A watch that a recursive watch ROOT put
+   on one of its subdirectories has as PREFIX the name of that
+   subdirectory relative to ROOT, with a trailing slash.
  */
 static Lisp_Object watch_list;
 
+enum
+  {
+    WATCH_CALLBACK,
+    WATCH_MASK,
+    WATCH_FLAGS,
+    WATCH_ROOT,
+    WATCH_DIRECTORY,
+    WATCH_PREFIX,
+    WATCH_INFO_SIZE
+  };
+
+/* Events that recursive watches need to follow their subdirectories.  */
+#define RECURSIVE_MASK (IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO)
+
 static Lisp_Object
 make_watch_descriptor (int wd)
 {
@@ -87,6 +113,57 @@ make_watch_descriptor (int wd)
   return make_number (wd);
 }
 
+/* Record a watch WD in the watch list, replacing any older record.  */
+static Lisp_Object
+add_watch_object (int wd, Lisp_Object callback, uint32_t mask,
+		  Lisp_Object flags, Lisp_Object root,
+		  Lisp_Object directory, Lisp_Object prefix)
+{
+  Lisp_Object watch_descriptor = make_watch_descriptor (wd);
+  Lisp_Object watch_object = Fassoc (watch_descriptor, watch_list);
+  Lisp_Object info = Fmake_vector (make_number (WATCH_INFO_SIZE), Qnil);
+
+  if (!NILP (watch_object))
+    watch_list = Fdelete (watch_object, watch_list);
+
+  ASET (info, WATCH_CALLBACK, callback);
+  ASET (info, WATCH_MASK, make_number (mask));
+  ASET (info, WATCH_FLAGS, flags);
+  ASET (info, WATCH_ROOT, NILP (root) ? watch_descriptor : root);
+  ASET (info, WATCH_DIRECTORY, directory);
+  ASET (info, WATCH_PREFIX, prefix);
+  watch_object = Fcons (watch_descriptor, info);
+  watch_list = Fcons (watch_object, watch_list);
+  return watch_object;
+}
+
+/* Remove the watches that ROOT put on subdirectories.  If PREFIX is a
+   string, remove only those on PREFIX and below it.  */
+static void
+remove_subdirectory_watches (Lisp_Object root, Lisp_Object prefix)
+{
+  Lisp_Object tail = watch_list;
+
+  while (CONSP (tail))
+    {
+      Lisp_Object watch_object = XCAR (tail);
+      Lisp_Object info = XCDR (watch_object);
+      Lisp_Object sub_prefix = AREF (info, WATCH_PREFIX);
+
+      tail = XCDR (tail);
+      if (!NILP (sub_prefix)
+	  && EQ (AREF (info, WATCH_ROOT), root)
+	  && (NILP (prefix)
+	      || (SBYTES (sub_prefix) >= SBYTES (prefix)
+		  && !memcmp (SDATA (sub_prefix), SDATA (prefix),
+			      SBYTES (prefix)))))
+	{
+	  inotify_rm_watch (inotifyfd, XINT (XCAR (watch_object)));
+	  watch_list = Fdelete (watch_object, watch_list);
+	}
+    }
+}
+
 static Lisp_Object
 mask_to_aspects (uint32_t mask) {
   Lisp_Object aspects = Qnil;
@@ -125,22 +202,160 @@ mask_to_aspects (uint32_t mask) {
   return aspects;
 }
 
-static Lisp_Object
-inotifyevent_to_event (Lisp_Object watch_object, struct inotify_event const *ev)
+static void
+store_notify_event (Lisp_Object event, Lisp_Object callback)
 {
-  Lisp_Object name = Qnil;
-  if (ev->len > 0)
+  struct input_event ie;
+
+  EVENT_INIT (ie);
+  ie.kind = FILE_NOTIFY_EVENT;
+  ie.arg = list2 (event, callback);
+  kbd_buffer_store_event (&ie);
+}
+
+/* Report an event for the watch ROOT_OBJECT, or add it to *BATCHES
+   if that watch has the `batch' flag.  */
+static void
+report_event (Lisp_Object root_object, uint32_t mask, Lisp_Object name,
+	      uint32_t cookie, Lisp_Object *batches)
+{
+  Lisp_Object info = XCDR (root_object);
+  Lisp_Object event = list4 (XCAR (root_object), mask_to_aspects (mask),
+			     name, make_number (cookie));
+
+  if (!NILP (Fmemq (Qbatch, AREF (info, WATCH_FLAGS))))
     {
-      size_t const len = strlen (ev->name);
-      name = make_unibyte_string (ev->name, min (len, ev->len));
-      name = DECODE_FILE (name);
+      Lisp_Object batch = Fassq (root_object, *batches);
+      if (NILP (batch))
+	*batches = Fcons (list2 (root_object, event), *batches);
+      else
+	XSETCDR (batch, Fcons (event, XCDR (batch)));
     }
+  else
+    store_notify_event (event, AREF (info, WATCH_CALLBACK));
+}
 
-  return list2 (list4 (make_watch_descriptor (ev->wd),
-                       mask_to_aspects (ev->mask),
-                       name,
-                       make_number (ev->cookie)),
-                XCDR (watch_object));
+/* Watch the directory DIRECTORY, named PREFIX relative to the
+   recursive watch ROOT_OBJECT.  Return false if it cannot be watched.  */
+static bool
+add_subdirectory_watch (Lisp_Object root_object, Lisp_Object directory,
+			Lisp_Object prefix)
+{
+  uint32_t mask = XINT (AREF (XCDR (root_object), WATCH_MASK));
+  int wd = inotify_add_watch (inotifyfd, SSDATA (directory),
+			      (mask | RECURSIVE_MASK | IN_ONLYDIR
+			       | IN_DONT_FOLLOW));
+
+  if (wd == -1)
+    return false;
+  add_watch_object (wd, Qnil, mask, Qnil, XCAR (root_object),
+		    directory, prefix);
+  return true;
+}
+
+/* Watch all the directories below DIRECTORY, which is watched already
+   and named PREFIX relative to the recursive watch ROOT_OBJECT.  If
+   BATCHES, report the files found as created; DIRECTORY has just
+   appeared, so they would otherwise go unnoticed.  Directories that
+   cannot be watched are skipped.  */
+static void
+add_subdirectory_watches (Lisp_Object root_object, Lisp_Object directory,
+			  Lisp_Object prefix, Lisp_Object *batches)
+{
+  uint32_t mask = XINT (AREF (XCDR (root_object), WATCH_MASK));
+  Lisp_Object stack = list1 (Fcons (directory, prefix));
+
+  while (CONSP (stack))
+    {
+      Lisp_Object dir = XCAR (XCAR (stack));
+      Lisp_Object dir_prefix = XCDR (XCAR (stack));
+      struct dirent *dp;
+      DIR *d;
+
+      stack = XCDR (stack);
+      block_input ();
+      d = opendir (SSDATA (dir));
+      unblock_input ();
+      if (!d)
+	continue;
+
+      while ((dp = readdir (d)))
+	{
+	  bool isdir;
+	  Lisp_Object child, name;
+
+	  if (!strcmp (dp->d_name, ".") || !strcmp (dp->d_name, ".."))
+	    continue;
+	  child = concat3 (dir, build_unibyte_string ("/"),
+			   build_unibyte_string (dp->d_name));
+#ifdef _DIRENT_HAVE_D_TYPE
+	  if (dp->d_type != DT_UNKNOWN)
+	    isdir = dp->d_type == DT_DIR;
+	  else
+#endif
+	    {
+	      struct stat st;
+	      isdir = (lstat (SSDATA (child), &st) == 0
+		       && S_ISDIR (st.st_mode));
+	    }
+	  name = concat2 (dir_prefix,
+			  DECODE_FILE (build_unibyte_string (dp->d_name)));
+	  if (batches && (mask & IN_CREATE))
+	    report_event (root_object, IN_CREATE | (isdir ? IN_ISDIR : 0),
+			  name, 0, batches);
+	  if (isdir)
+	    {
+	      Lisp_Object child_prefix = concat2 (name, build_string ("/"));
+	      if (add_subdirectory_watch (root_object, child, child_prefix))
+		stack = Fcons (Fcons (child, child_prefix), stack);
+	    }
+	}
+
+      block_input ();
+      closedir (d);
+      unblock_input ();
+    }
+}
+
+/* Consecutive identical events for the same file, as a build or a
+   checkout produces by the thousand, are reported once per read.
+   This table holds the last event mask seen for each file in the
+   read; it is keyed by watch descriptor and name.  */
+struct coalesce_entry
+{
+  char const *name;
+  size_t len;
+  int wd;
+  uint32_t mask;
+  bool used;
+};
+
+/* Return true if EV repeats the last event for its file in TABLE, of
+   SIZE entries, and record EV as that event otherwise.  */
+static bool
+coalesce_event (struct coalesce_entry *table, size_t size,
+		struct inotify_event const *ev)
+{
+  size_t len = ev->len ? strnlen (ev->name, ev->len) : 0;
+  size_t i = ((hash_string (ev->name, len) ^ (EMACS_UINT) ev->wd)
+	      & (size - 1));
+  bool repeated;
+
+  while (table[i].used
+	 && !(table[i].wd == ev->wd && table[i].len == len
+	      && !memcmp (table[i].name, ev->name, len)))
+    i = (i + 1) & (size - 1);
+
+  repeated = (table[i].used && table[i].mask == ev->mask
+	      && ev->cookie == 0
+	      && !(ev->mask & (IN_IGNORED | IN_Q_OVERFLOW | IN_UNMOUNT
+			       | IN_ISDIR)));
+  table[i].used = true;
+  table[i].name = ev->name;
+  table[i].len = len;
+  table[i].wd = ev->wd;
+  table[i].mask = ev->mask;
+  return repeated;
 }
 
 /* This callback is called when the FD is available for read.  The inotify
@@ -148,8 +363,9 @@ inotifyevent_to_event (Lisp_Object watch_object, struct inotify_event const *ev)
 static void
 inotify_callback (int fd, void *_)
 {
-  struct input_event event;
-  Lisp_Object watch_object;
+  Lisp_Object watch_object, batches = Qnil;
+  struct coalesce_entry *table;
+  size_t table_size, count;
   int to_read;
   char *buffer;
   ssize_t n;
@@ -170,30 +386,87 @@ inotify_callback (int fd, void *_)
        build_string ("Error while trying to read file system events"));
     }
 
-  EVENT_INIT (event);
-  event.kind = FILE_NOTIFY_EVENT;
+  count = 0;
+  for (i = 0; i < (size_t) n;
+       i += sizeof (struct inotify_event)
+	 + ((struct inotify_event *) &buffer[i])->len)
+    count++;
+  for (table_size = 16; table_size < 2 * count; table_size *= 2)
+    continue;
+  table = xzalloc (table_size * sizeof *table);
 
   i = 0;
   while (i < (size_t)n)
     {
       struct inotify_event *ev = (struct inotify_event*)&buffer[i];
+      i += sizeof (*ev) + ev->len;
 
       watch_object = Fassoc (make_watch_descriptor (ev->wd), watch_list);
       if (!NILP (watch_object))
         {
-          event.arg = inotifyevent_to_event (watch_object, ev);
+	  Lisp_Object info = XCDR (watch_object);
+	  Lisp_Object prefix = AREF (info, WATCH_PREFIX);
+	  Lisp_Object root_object = NILP (prefix) ? watch_object
+	    : Fassoc (AREF (info, WATCH_ROOT), watch_list);
+	  uint32_t mask = XINT (AREF (info, WATCH_MASK));
+	  Lisp_Object raw_name = Qnil, name = Qnil;
 
           /* If event was removed automatically: Drop it from watch list.  */
           if (ev->mask & IN_IGNORED)
             watch_list = Fdelete (watch_object, watch_list);
 
-	  if (!NILP (event.arg))
-	    kbd_buffer_store_event (&event);
+	  if (NILP (root_object) || coalesce_event (table, table_size, ev))
+	    continue;
+
+	  if (ev->len > 0)
+	    {
+	      raw_name = make_unibyte_string (ev->name,
+					      strnlen (ev->name, ev->len));
+	      name = DECODE_FILE (raw_name);
+	    }
+	  if (!NILP (prefix))
+	    {
+	      /* The directory itself is reported by its parent.  */
+	      if (NILP (name))
+		continue;
+	      name = concat2 (prefix, name);
+	    }
+
+	  /* Recursive watches ask for more events than they report.  */
+	  if (!(ev->mask & IN_ALL_EVENTS) || (ev->mask & mask & IN_ALL_EVENTS))
+	    report_event (root_object, ev->mask, name, ev->cookie, &batches);
+
+	  if ((ev->mask & IN_ISDIR) && !NILP (raw_name)
+	      && !NILP (Fmemq (Qrecursive,
+			       AREF (XCDR (root_object), WATCH_FLAGS))))
+	    {
+	      Lisp_Object sub_prefix = concat2 (name, build_string ("/"));
+	      if (ev->mask & IN_MOVED_FROM)
+		remove_subdirectory_watches (XCAR (root_object), sub_prefix);
+	      if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+		{
+		  Lisp_Object dir = concat3 (AREF (info, WATCH_DIRECTORY),
+					     build_unibyte_string ("/"),
+					     raw_name);
+		  if (add_subdirectory_watch (root_object, dir, sub_prefix))
+		    add_subdirectory_watches (root_object, dir, sub_prefix,
+					      &batches);
+		}
+	    }
         }
+    }
 
-      i += sizeof (*ev) + ev->len;
+  /* Deliver the events of each batched watch as a single vector.  */
+  for (batches = Fnreverse (batches); CONSP (batches);
+       batches = XCDR (batches))
+    {
+      Lisp_Object root_object = XCAR (XCAR (batches));
+      Lisp_Object events = Fnreverse (XCDR (XCAR (batches)));
+      store_notify_event (Fvconcat (1, &events),
+			  AREF (XCDR (root_object), WATCH_CALLBACK));
     }
 
+  xfree (table);
   xfree (buffer);
 }
 
@@ -242,6 +515,10 @@ symbol_to_inotifymask (Lisp_Object symb)
 
   else if (EQ (symb, Qt) || EQ (symb, Qall_events))
     return IN_ALL_EVENTS;
+
+  /* Handled by Emacs rather than inotify.  */
+  else if (EQ (symb, Qbatch) || EQ (symb, Qrecursive))
+    return 0;
   else
       xsignal2 (Qfile_notify_error, build_string ("Unknown aspect"), symb);
 }
@@ -297,11 +574,25 @@ mask-add
 oneshot
 onlydir
 
-Watching a directory is not recursive.  CALLBACK is passed a single argument
-EVENT which contains an event structure of the format
+batch
+recursive
+
+Watching a directory is not recursive, unless `recursive' is given.
+Then all the directories below FILE-NAME are watched too, including
+those created later, and their events are reported as events of
+FILE-NAME, with NAME relative to it.  Files found in a directory that
+was just created or moved in are reported as created.
+
+CALLBACK is passed a single argument EVENT which contains an event
+structure of the format
 
 (WATCH-DESCRIPTOR ASPECTS NAME COOKIE)
 
+If `batch' is given, CALLBACK is instead passed a vector of such
+events, all those that arrived at once.  Either way, an event that
+repeats the previous event for the same file, with nothing in between,
+is reported only once.
+
 WATCH-DESCRIPTOR is the same object that was returned by this function.  It can
 be tested for equality using `equal'.  ASPECTS describes the event.  It is a
 list of ASPECT symbols described above and can also contain one of the following
@@ -323,10 +614,10 @@ is managed internally and there is no corresponding inotify_init.  Use
              */)
      (Lisp_Object file_name, Lisp_Object aspect, Lisp_Object callback)
 {
-  uint32_t mask;
+  uint32_t mask, watch_mask;
   Lisp_Object watch_object;
   Lisp_Object encoded_file_name;
-  Lisp_Object watch_descriptor;
+  Lisp_Object flags = Qnil;
   int watchdesc = -1;
 
   CHECK_STRING (file_name);
@@ -343,24 +634,32 @@ is managed internally and there is no corresponding inotify_init.  Use
     }
 
   mask = aspect_to_inotifymask (aspect);
+  if (CONSP (aspect) && !NILP (Fmemq (Qbatch, aspect)))
+    flags = Fcons (Qbatch, flags);
+  if (CONSP (aspect) && !NILP (Fmemq (Qrecursive, aspect)))
+    flags = Fcons (Qrecursive, flags);
+  watch_mask = NILP (Fmemq (Qrecursive, flags)) ? mask : mask | RECURSIVE_MASK;
+
   encoded_file_name = ENCODE_FILE (file_name);
-  watchdesc = inotify_add_watch (inotifyfd, SSDATA (encoded_file_name), mask);
+  watchdesc = inotify_add_watch (inotifyfd, SSDATA (encoded_file_name),
+				 watch_mask);
   if (watchdesc == -1)
     xsignal2 (Qfile_notify_error,
 	      build_string ("Could not add watch for file"), file_name);
 
-  watch_descriptor = make_watch_descriptor (watchdesc);
+  /* Store watch object in watch list, replacing any existing one.  */
+  watch_object = add_watch_object (watchdesc, callback, mask, flags, Qnil,
+				   encoded_file_name, Qnil);
 
-  /* Delete existing watch object. */
-  watch_object = Fassoc (watch_descriptor, watch_list);
-  if (!NILP (watch_object))
-      watch_list = Fdelete (watch_object, watch_list);
-
-  /* Store watch object in watch list. */
-  watch_object = Fcons (watch_descriptor, callback);
-  watch_list = Fcons (watch_object, watch_list);
+  if (!NILP (Fmemq (Qrecursive, flags)))
+    {
+      /* Start afresh if FILE-NAME was watched recursively already.  */
+      remove_subdirectory_watches (XCAR (watch_object), Qnil);
+      add_subdirectory_watches (watch_object, encoded_file_name,
+				build_string (""), NULL);
+    }
 
-  return watch_descriptor;
+  return XCAR (watch_object);
 }
 
 DEFUN ("inotify-rm-watch", Finotify_rm_watch, Sinotify_rm_watch, 1, 1, 0,
@@ -379,10 +678,12 @@ See inotify_rm_watch(2) for more information.
     xsignal2 (Qfile_notify_error,
 	      build_string ("Could not rm watch"), watch_descriptor);
 
-  /* Remove watch descriptor from watch list. */
+  /* Remove watch descriptor from watch list, with the watches it put
+     on subdirectories.  */
   watch_object = Fassoc (watch_descriptor, watch_list);
   if (!NILP (watch_object))
     watch_list = Fdelete (watch_object, watch_list);
+  remove_subdirectory_watches (watch_descriptor, Qnil);
 
   /* Cleanup if no more files are watched. */
   if (NILP (watch_list))
@@ -423,6 +724,9 @@ syms_of_inotify (void)
   DEFSYM (Qoneshot, "oneshot");
   DEFSYM (Qonlydir, "onlydir");
 
+  DEFSYM (Qbatch, "batch");
+  DEFSYM (Qrecursive, "recursive");
+
   DEFSYM (Qignored, "ignored");
   DEFSYM (Qisdir, "isdir");
   DEFSYM (Qq_overflow, "q-overflow");
@@ -51,6 +51,13 @@ static Lisp_Object combine_after_change_list;
 /* Buffer which combine_after_change_list is about.  */
 static Lisp_Object combine_after_change_buffer;
 
+/* Buffers whose deferred_changes are not empty, for
+   run-deferred-change-functions to visit.  */
+static Lisp_Object deferred_change_buffers;
+
+static Lisp_Object Qdeferred_change_functions;
+static Lisp_Object Qrun_deferred_change_functions;
+
 Lisp_Object Qinhibit_modification_hooks;
 
 static void signal_before_change (ptrdiff_t, ptrdiff_t, ptrdiff_t *);
@@ -142,6 +149,11 @@ gap_left (ptrdiff_t charpos, ptrdiff_t bytepos, bool newgap)
       from -= i, to -= i;
       memmove (to, from, i);
     }
+  if (new_s1 < GPT_BYTE)
+    {
+      current_buffer->text->gap_moves++;
+      current_buffer->text->gap_moved_bytes += GPT_BYTE - new_s1;
+    }
 
   /* Adjust buffer data structure, to put the gap at BYTEPOS.
      BYTEPOS is where the loop above stopped, which may be what
@@ -195,6 +207,8 @@ gap_right (ptrdiff_t charpos, ptrdiff_t bytepos)
       memmove (to, from, i);
       from += i, to += i;
     }
+  current_buffer->text->gap_moves++;
+  current_buffer->text->gap_moved_bytes += new_s1 - GPT_BYTE;
 
   GPT = charpos;
   GPT_BYTE = bytepos;
@@ -208,20 +222,49 @@ gap_right (ptrdiff_t charpos, ptrdiff_t bytepos)
    The range in charpos is FROM to TO.
 
    This function assumes that the gap is adjacent to
-   or inside of the range being deleted.  */
+   or inside of the range being deleted.
+
+   If UNDO_ADJUSTMENTS is non-null, push onto it the undo entries
+   (MARKER . ADJUSTMENT) that record_delete needs for markers in the
+   deleted range, so that the marker chain is walked only once.  */
 
 void
 adjust_markers_for_delete (ptrdiff_t from, ptrdiff_t from_byte,
-			   ptrdiff_t to, ptrdiff_t to_byte)
+			   ptrdiff_t to, ptrdiff_t to_byte,
+			   Lisp_Object *undo_adjustments)
 {
   struct Lisp_Marker *m;
   ptrdiff_t charpos;
 
+  truncate_pos_index (current_buffer, from_byte);
+  invalidate_overlay_index (current_buffer);
+
   for (m = BUF_MARKERS (current_buffer); m; m = m->next)
     {
       charpos = m->charpos;
       eassert (charpos <= Z);
 
+      if (undo_adjustments && from <= charpos && charpos <= to)
+	{
+	  /* insertion_type nil markers will end up at the beginning of
+	     the re-inserted text after undoing a deletion, and must be
+	     adjusted to move them to the correct place.
+
+	     insertion_type t markers will automatically move forward
+	     upon re-inserting the deleted text, so we have to arrange
+	     for them to move backward to the correct position.  */
+	  ptrdiff_t adjustment = (m->insertion_type ? to : from) - charpos;
+
+	  if (adjustment)
+	    {
+	      Lisp_Object marker;
+	      XSETMISC (marker, m);
+	      *undo_adjustments = Fcons (Fcons (marker,
+						make_number (adjustment)),
+					 *undo_adjustments);
+	    }
+	}
+
       /* If the marker is after the deletion,
 	 relocate by number of chars / bytes deleted.  */
       if (charpos > to)
@@ -256,6 +299,9 @@ adjust_markers_for_insert (ptrdiff_t from, ptrdiff_t from_byte,
   ptrdiff_t nchars = to - from;
   ptrdiff_t nbytes = to_byte - from_byte;
 
+  truncate_pos_index (current_buffer, from_byte);
+  invalidate_overlay_index (current_buffer);
+
   for (m = BUF_MARKERS (current_buffer); m; m = m->next)
     {
       eassert (m->bytepos >= m->charpos
@@ -321,6 +367,9 @@ adjust_markers_for_replace (ptrdiff_t from, ptrdiff_t from_byte,
   ptrdiff_t diff_chars = new_chars - old_chars;
   ptrdiff_t diff_bytes = new_bytes - old_bytes;
 
+  truncate_pos_index (current_buffer, from_byte);
+  invalidate_overlay_index (current_buffer);
+
   for (m = BUF_MARKERS (current_buffer); m; m = m->next)
     {
       if (m->bytepos >= prev_to_byte)
@@ -354,14 +403,21 @@ make_gap_larger (ptrdiff_t nbytes_added)
   ptrdiff_t real_gap_loc;
   ptrdiff_t real_gap_loc_byte;
   ptrdiff_t old_gap_size;
+  ptrdiff_t growth;
   ptrdiff_t current_size = Z_BYTE - BEG_BYTE + GAP_SIZE;
 
   if (BUF_BYTES_MAX - current_size < nbytes_added)
     buffer_overflow ();
 
   /* If we have to get more space, get enough to last a while;
-     but do not exceed the maximum buffer size.  */
-  nbytes_added = min (nbytes_added + GAP_BYTES_DFL,
+     but do not exceed the maximum buffer size.  A buffer that keeps
+     growing gets twice as much each time, up to an eighth of its
+     size.  */
+  growth = clip_to_bounds (GAP_BYTES_DFL,
+			   2 * current_buffer->text->gap_growth,
+			   max (GAP_BYTES_DFL, current_size / 8));
+  current_buffer->text->gap_growth = growth;
+  nbytes_added = min (nbytes_added + growth,
 		      BUF_BYTES_MAX - current_size);
 
   enlarge_buffer_text (current_buffer, nbytes_added);
@@ -535,6 +591,176 @@ copy_text (const unsigned char *from_addr, unsigned char *to_addr,
     }
 }
 
+/* Return the length of the longest common prefix of the N bytes at A
+   and the N bytes at B.  Let memcmp, which the C library vectorizes,
+   skip long equal stretches; then narrow down a word at a time.  */
+
+static ptrdiff_t
+memory_prefix_match (const unsigned char *a, const unsigned char *b,
+		     ptrdiff_t n)
+{
+  enum { BLOCK = 256 };
+  ptrdiff_t i = 0;
+
+  while (i + BLOCK <= n && memcmp (a + i, b + i, BLOCK) == 0)
+    i += BLOCK;
+  for (; i + (ptrdiff_t) sizeof (uintptr_t) <= n; i += sizeof (uintptr_t))
+    {
+      uintptr_t x, y;
+      memcpy (&x, a + i, sizeof x);
+      memcpy (&y, b + i, sizeof y);
+      if (x != y)
+	break;
+    }
+  while (i < n && a[i] == b[i])
+    i++;
+  return i;
+}
+
+/* Like memory_prefix_match, but compare the N bytes before A and
+   before B backwards, and return the length of their common suffix.  */
+
+static ptrdiff_t
+memory_suffix_match (const unsigned char *a, const unsigned char *b,
+		     ptrdiff_t n)
+{
+  enum { BLOCK = 256 };
+  ptrdiff_t i = 0;
+
+  while (i + BLOCK <= n && memcmp (a - i - BLOCK, b - i - BLOCK, BLOCK) == 0)
+    i += BLOCK;
+  for (; i + (ptrdiff_t) sizeof (uintptr_t) <= n; i += sizeof (uintptr_t))
+    {
+      uintptr_t x, y;
+      memcpy (&x, a - i - sizeof x, sizeof x);
+      memcpy (&y, b - i - sizeof y, sizeof y);
+      if (x != y)
+	break;
+    }
+  while (i < n && a[-i - 1] == b[-i - 1])
+    i++;
+  return i;
+}
+
+/* Return how many bytes of the text of buffer B from byte position
+   FROM (but not past TO) match the LEN bytes at S.  */
+
+ptrdiff_t
+buffer_prefix_match (struct buffer *b, ptrdiff_t from, ptrdiff_t to,
+		     const unsigned char *s, ptrdiff_t len)
+{
+  ptrdiff_t n = min (to - from, len), matched = 0, chunk;
+
+  if (from < BUF_GPT_BYTE (b))
+    {
+      chunk = min (n, BUF_GPT_BYTE (b) - from);
+      matched = memory_prefix_match (BUF_BYTE_ADDRESS (b, from), s, chunk);
+      if (matched < chunk)
+	return matched;
+    }
+  return matched + memory_prefix_match (BUF_BYTE_ADDRESS (b, from + matched),
+					s + matched, n - matched);
+}
+
+/* Return how many bytes of the text of buffer B before byte position TO
+   (but not before FROM) match the LEN bytes at S, comparing from the
+   end backwards.  */
+
+ptrdiff_t
+buffer_suffix_match (struct buffer *b, ptrdiff_t from, ptrdiff_t to,
+		     const unsigned char *s, ptrdiff_t len)
+{
+  ptrdiff_t n = min (to - from, len), matched = 0, chunk;
+
+  if (n <= 0)
+    return 0;
+  if (to > BUF_GPT_BYTE (b))
+    {
+      chunk = min (n, to - BUF_GPT_BYTE (b));
+      matched = memory_suffix_match (BUF_BYTE_ADDRESS (b, to - 1) + 1,
+				     s + len, chunk);
+      if (matched == n || matched < chunk)
+	return matched;
+    }
+  return matched + memory_suffix_match (BUF_BYTE_ADDRESS (b, to - matched - 1)
+					+ 1,
+					s + len - matched, n - matched);
+}
+
+/* Return the length in bytes of the common prefix of the text of
+   buffer B1 between byte positions FROM1 and TO1 and that of B2
+   between FROM2 and TO2.  */
+
+ptrdiff_t
+buffers_prefix_match (struct buffer *b1, ptrdiff_t from1, ptrdiff_t to1,
+		      struct buffer *b2, ptrdiff_t from2, ptrdiff_t to2)
+{
+  ptrdiff_t matched = 0;
+
+  while (from2 < to2)
+    {
+      ptrdiff_t end = (from2 < BUF_GPT_BYTE (b2)
+		       ? min (to2, BUF_GPT_BYTE (b2)) : to2);
+      ptrdiff_t m = buffer_prefix_match (b1, from1 + matched, to1,
+					 BUF_BYTE_ADDRESS (b2, from2),
+					 end - from2);
+      matched += m;
+      if (m < end - from2)
+	break;
+      from2 = end;
+    }
+  return matched;
+}
+
+/* Likewise for the common suffix of the two texts.  */
+
+ptrdiff_t
+buffers_suffix_match (struct buffer *b1, ptrdiff_t from1, ptrdiff_t to1,
+		      struct buffer *b2, ptrdiff_t from2, ptrdiff_t to2)
+{
+  ptrdiff_t matched = 0;
+
+  while (from2 < to2)
+    {
+      ptrdiff_t beg = (to2 > BUF_GPT_BYTE (b2)
+		       ? max (from2, BUF_GPT_BYTE (b2)) : from2);
+      ptrdiff_t m = buffer_suffix_match (b1, from1, to1 - matched,
+					 BUF_BYTE_ADDRESS (b2, beg),
+					 to2 - beg);
+      matched += m;
+      if (m < to2 - beg)
+	break;
+      to2 = beg;
+    }
+  return matched;
+}
+
+/* Note that the text of the current buffer now may have right-to-left
+   characters.  Rows displayed without reordering cannot be reused for
+   it from then on.  */
+
+void
+note_rtl_text (void)
+{
+  if (!current_buffer->text->rtl)
+    {
+      current_buffer->text->rtl = true;
+      current_buffer->prevent_redisplay_optimizations_p = true;
+    }
+}
+
+/* Note what the NBYTES bytes of text at BYTEPOS, just inserted into
+   the current buffer, have.  */
+
+static void
+note_inserted_text (ptrdiff_t bytepos, ptrdiff_t nbytes)
+{
+  if (!current_buffer->text->rtl
+      && !NILP (BVAR (current_buffer, enable_multibyte_characters))
+      && multibyte_text_rtl_p (BYTE_POS_ADDR (bytepos), nbytes))
+    note_rtl_text ();
+}
+
 /* Insert a string of specified length before point.
    This function judges multibyteness based on
    enable_multibyte_characters in the current buffer;
@@ -805,6 +1031,7 @@ insert_1_both (const char *string,
   if (Z - GPT < END_UNCHANGED)
     END_UNCHANGED = Z - GPT;
 
+  note_inserted_text (PT_BYTE, nbytes);
   adjust_overlays_for_insert (PT, nchars);
   adjust_markers_for_insert (PT, PT_BYTE,
 			     PT + nchars, PT_BYTE + nbytes,
@@ -934,6 +1161,7 @@ insert_from_string_1 (Lisp_Object string, ptrdiff_t pos, ptrdiff_t pos_byte,
   if (Z - GPT < END_UNCHANGED)
     END_UNCHANGED = Z - GPT;
 
+  note_inserted_text (PT_BYTE, outgoing_nbytes);
   adjust_overlays_for_insert (PT, nchars);
   adjust_markers_for_insert (PT, PT_BYTE, PT + nchars,
 			     PT_BYTE + outgoing_nbytes,
@@ -989,6 +1217,7 @@ insert_from_gap (ptrdiff_t nchars, ptrdiff_t nbytes, bool text_at_gap_tail)
 
   eassert (GPT <= GPT_BYTE);
 
+  note_inserted_text (ins_bytepos, nbytes);
   adjust_overlays_for_insert (ins_charpos, nchars);
   adjust_markers_for_insert (ins_charpos, ins_bytepos,
 			     ins_charpos + nchars, ins_bytepos + nbytes, 0);
@@ -1131,6 +1360,7 @@ insert_from_buffer_1 (struct buffer *buf,
   if (Z - GPT < END_UNCHANGED)
     END_UNCHANGED = Z - GPT;
 
+  note_inserted_text (PT_BYTE, outgoing_nbytes);
   adjust_overlays_for_insert (PT, nchars);
   adjust_markers_for_insert (PT, PT_BYTE, PT + nchars,
 			     PT_BYTE + outgoing_nbytes,
@@ -1185,6 +1415,8 @@ adjust_after_replace (ptrdiff_t from, ptrdiff_t from_byte,
   GPT += len; GPT_BYTE += len_byte;
   if (GAP_SIZE > 0) *(GPT_ADDR) = 0; /* Put an anchor. */
 
+  note_inserted_text (from_byte, len_byte);
+
   if (nchars_del > 0)
     adjust_markers_for_replace (from, from_byte, nchars_del, nbytes_del,
 				len, len_byte);
@@ -1193,7 +1425,7 @@ adjust_after_replace (ptrdiff_t from, ptrdiff_t from_byte,
 			       from + len, from_byte + len_byte, 0);
 
   if (nchars_del > 0)
-    record_delete (from, prev_text, false);
+    record_delete (from, prev_text, Qnil);
   record_insert (from, len);
 
   if (len > nchars_del)
@@ -1261,7 +1493,8 @@ replace_range (ptrdiff_t from, ptrdiff_t to, Lisp_Object new,
   struct gcpro gcpro1;
   INTERVAL intervals;
   ptrdiff_t outgoing_insbytes = insbytes;
-  Lisp_Object deletion;
+  Lisp_Object deletion, adjustments = Qnil;
+  bool record_undo = ! EQ (BVAR (current_buffer, undo_list), Qt);
 
   check_markers ();
 
@@ -1303,74 +1536,110 @@ replace_range (ptrdiff_t from, ptrdiff_t to, Lisp_Object new,
 
   GCPRO1 (new);
 
-  /* Make sure the gap is somewhere in or next to what we are deleting.  */
-  if (from > GPT)
-    gap_right (from, from_byte);
-  if (to < GPT)
-    gap_left (to, to_byte, 0);
-
-  /* Even if we don't record for undo, we must keep the original text
-     because we may have to recover it because of inappropriate byte
-     combining.  */
-  if (! EQ (BVAR (current_buffer, undo_list), Qt))
-    deletion = make_buffer_string_both (from, from_byte, to, to_byte, 1);
+  if (outgoing_insbytes == nbytes_del
+      && (to_byte <= GPT_BYTE || GPT_BYTE <= from_byte))
+    {
+      /* The new text fits exactly where the old text was: overwrite
+	 it there.  Moving the gap next to it, as below, would copy all
+	 the text in between, which in a large buffer costs far more
+	 than the replacement itself when edits jump around.  */
+      BUF_COMPUTE_UNCHANGED (current_buffer, from, to);
 
-  GAP_SIZE += nbytes_del;
-  ZV -= nchars_del;
-  Z -= nchars_del;
-  ZV_BYTE -= nbytes_del;
-  Z_BYTE -= nbytes_del;
-  GPT = from;
-  GPT_BYTE = from_byte;
-  if (GAP_SIZE > 0) *(GPT_ADDR) = 0; /* Put an anchor.  */
+      if (record_undo)
+	deletion = make_buffer_string_both (from, from_byte, to, to_byte, 1);
 
-  eassert (GPT <= GPT_BYTE);
+      copy_text (SDATA (new), BYTE_POS_ADDR (from_byte), insbytes,
+		 STRING_MULTIBYTE (new),
+		 ! NILP (BVAR (current_buffer, enable_multibyte_characters)));
 
-  if (GPT - BEG < BEG_UNCHANGED)
-    BEG_UNCHANGED = GPT - BEG;
-  if (Z - GPT < END_UNCHANGED)
-    END_UNCHANGED = Z - GPT;
+      if (!NILP (deletion))
+	{
+	  record_insert (from + SCHARS (deletion), inschars);
+	  record_delete (from, deletion, Qnil);
+	}
 
-  if (GAP_SIZE < outgoing_insbytes)
-    make_gap (outgoing_insbytes - GAP_SIZE);
+      /* The byte positions stay the same, but the number of characters
+	 may differ.  */
+      ZV += inschars - nchars_del;
+      Z += inschars - nchars_del;
+      if (to_byte <= GPT_BYTE)
+	GPT += inschars - nchars_del;
 
-  /* Copy the string text into the buffer, perhaps converting
-     between single-byte and multibyte.  */
-  copy_text (SDATA (new), GPT_ADDR, insbytes,
-	     STRING_MULTIBYTE (new),
-	     ! NILP (BVAR (current_buffer, enable_multibyte_characters)));
+      eassert (GPT <= GPT_BYTE);
+    }
+  else
+    {
+      /* Make sure the gap is somewhere in or next to what we are deleting.  */
+      if (from > GPT)
+	gap_right (from, from_byte);
+      if (to < GPT)
+	gap_left (to, to_byte, 0);
+
+      /* Even if we don't record for undo, we must keep the original text
+	 because we may have to recover it because of inappropriate byte
+	 combining.  */
+      if (! EQ (BVAR (current_buffer, undo_list), Qt))
+	deletion = make_buffer_string_both (from, from_byte, to, to_byte, 1);
+
+      GAP_SIZE += nbytes_del;
+      ZV -= nchars_del;
+      Z -= nchars_del;
+      ZV_BYTE -= nbytes_del;
+      Z_BYTE -= nbytes_del;
+      GPT = from;
+      GPT_BYTE = from_byte;
+      if (GAP_SIZE > 0) *(GPT_ADDR) = 0; /* Put an anchor.  */
+
+      eassert (GPT <= GPT_BYTE);
+
+      if (GPT - BEG < BEG_UNCHANGED)
+	BEG_UNCHANGED = GPT - BEG;
+      if (Z - GPT < END_UNCHANGED)
+	END_UNCHANGED = Z - GPT;
+
+      if (GAP_SIZE < outgoing_insbytes)
+	make_gap (outgoing_insbytes - GAP_SIZE);
+
+      /* Copy the string text into the buffer, perhaps converting
+	 between single-byte and multibyte.  */
+      copy_text (SDATA (new), GPT_ADDR, insbytes,
+		 STRING_MULTIBYTE (new),
+		 ! NILP (BVAR (current_buffer, enable_multibyte_characters)));
 
 #ifdef BYTE_COMBINING_DEBUG
-  /* We have copied text into the gap, but we have not marked
-     it as part of the buffer.  So we can use the old FROM and FROM_BYTE
-     here, for both the previous text and the following text.
-     Meanwhile, GPT_ADDR does point to
-     the text that has been stored by copy_text.  */
-  if (count_combining_before (GPT_ADDR, outgoing_insbytes, from, from_byte)
-      || count_combining_after (GPT_ADDR, outgoing_insbytes, from, from_byte))
-    emacs_abort ();
+      /* We have copied text into the gap, but we have not marked
+	 it as part of the buffer.  So we can use the old FROM and FROM_BYTE
+	 here, for both the previous text and the following text.
+	 Meanwhile, GPT_ADDR does point to
+	 the text that has been stored by copy_text.  */
+      if (count_combining_before (GPT_ADDR, outgoing_insbytes, from, from_byte)
+	  || count_combining_after (GPT_ADDR, outgoing_insbytes, from, from_byte))
+	emacs_abort ();
 #endif
 
-  /* Record the insertion first, so that when we undo,
-     the deletion will be undone first.  Thus, undo
-     will insert before deleting, and thus will keep
-     the markers before and after this text separate.  */
-  if (!NILP (deletion))
-    {
-      record_insert (from + SCHARS (deletion), inschars);
-      record_delete (from, deletion, false);
-    }
+      /* Record the insertion first, so that when we undo,
+	 the deletion will be undone first.  Thus, undo
+	 will insert before deleting, and thus will keep
+	 the markers before and after this text separate.  */
+      if (!NILP (deletion))
+	{
+	  record_insert (from + SCHARS (deletion), inschars);
+	  record_delete (from, deletion, Qnil);
+	}
 
-  GAP_SIZE -= outgoing_insbytes;
-  GPT += inschars;
-  ZV += inschars;
-  Z += inschars;
-  GPT_BYTE += outgoing_insbytes;
-  ZV_BYTE += outgoing_insbytes;
-  Z_BYTE += outgoing_insbytes;
-  if (GAP_SIZE > 0) *(GPT_ADDR) = 0; /* Put an anchor.  */
+      GAP_SIZE -= outgoing_insbytes;
+      GPT += inschars;
+      ZV += inschars;
+      Z += inschars;
+      GPT_BYTE += outgoing_insbytes;
+      ZV_BYTE += outgoing_insbytes;
+      Z_BYTE += outgoing_insbytes;
+      if (GAP_SIZE > 0) *(GPT_ADDR) = 0; /* Put an anchor.  */
 
-  eassert (GPT <= GPT_BYTE);
+      eassert (GPT <= GPT_BYTE);
+    }
+
+  note_inserted_text (from_byte, outgoing_insbytes);
 
   /* Adjust markers for the deletion and the insertion.  */
   if (markers)
@@ -1406,8 +1675,8 @@ replace_range (ptrdiff_t from, ptrdiff_t to, Lisp_Object new,
   CHARS_MODIFF = MODIFF;
   UNGCPRO;
 
-  signal_after_change (from, nchars_del, GPT - from);
-  update_compositions (from, GPT, CHECK_BORDER);
+  signal_after_change (from, nchars_del, inschars);
+  update_compositions (from, from + inschars, CHECK_BORDER);
 }
 
 /* Replace the text from character positions FROM to TO with
@@ -1488,6 +1757,8 @@ replace_range_2 (ptrdiff_t from, ptrdiff_t from_byte,
 
   eassert (GPT <= GPT_BYTE);
 
+  note_inserted_text (from_byte, insbytes);
+
   /* Adjust markers for the deletion and the insertion.  */
   if (markers
       && ! (nchars_del == 1 && inschars == 1 && nbytes_del == insbytes))
@@ -1685,18 +1956,20 @@ del_range_2 (ptrdiff_t from, ptrdiff_t from_byte,
     emacs_abort ();
 #endif
 
-  if (ret_string || ! EQ (BVAR (current_buffer, undo_list), Qt))
+  if (ret_string || record_undo)
     deletion = make_buffer_string_both (from, from_byte, to, to_byte, 1);
   else
     deletion = Qnil;
 
+  /* Relocate all markers pointing into the new, larger gap to point
+     at the end of the text before the gap, collecting the undo
+     entries for the markers inside it on the way.  */
+  adjust_markers_for_delete (from, from_byte, to, to_byte,
+			     record_undo ? &adjustments : NULL);
+
   /* Record marker adjustments, and text deletion into undo
      history.  */
-  record_delete (from, deletion, true);
-
-  /* Relocate all markers pointing into the new, larger gap to point
-     at the end of the text before the gap.  */
-  adjust_markers_for_delete (from, from_byte, to, to_byte);
+  record_delete (from, deletion, adjustments);
 
   MODIFF++;
   CHARS_MODIFF = MODIFF;
@@ -1731,6 +2004,10 @@ del_range_2 (ptrdiff_t from, ptrdiff_t from_byte,
   if (Z - GPT < END_UNCHANGED)
     END_UNCHANGED = Z - GPT;
 
+  /* Nothing is left of any right-to-left text.  */
+  if (Z == BEG)
+    current_buffer->text->rtl = false;
+
   check_markers ();
 
   evaporate_overlays (from);
@@ -1780,6 +2057,7 @@ prepare_to_modify_buffer_1 (ptrdiff_t start, ptrdiff_t end,
     Fbarf_if_buffer_read_only ();
 
   bset_redisplay (current_buffer);
+  parse_cache_flush (start);
 
   if (buffer_intervals (current_buffer))
     {
@@ -2009,6 +2287,84 @@ signal_before_change (ptrdiff_t start_int, ptrdiff_t end_int,
   dynwind_end ();
 }
 
+/* Add the change described by CHARPOS, LENDEL and LENINS (see
+   signal_after_change) to the deferred changes of the current buffer.
+   Ranges it touches are merged with it and the ones after it are
+   shifted; if that leaves too many ranges, the two with the smallest
+   gap between them are merged.  */
+
+static void
+record_deferred_change (ptrdiff_t charpos, ptrdiff_t lendel,
+			ptrdiff_t lenins)
+{
+  struct buffer *b = current_buffer;
+  struct { ptrdiff_t beg, end; } r[DEFERRED_CHANGE_RANGES + 1];
+  ptrdiff_t beg = charpos, end = charpos + lenins;
+  ptrdiff_t old_end = charpos + lendel, delta = lenins - lendel;
+  int i, n = 0, closest;
+  bool placed = false;
+
+  if (b->deferred_change_count == 0)
+    {
+      Lisp_Object buffer;
+      XSETBUFFER (buffer, b);
+      deferred_change_buffers = Fcons (buffer, deferred_change_buffers);
+    }
+
+  for (i = 0; i < b->deferred_change_count; i++)
+    {
+      ptrdiff_t rbeg = b->deferred_changes[i].beg;
+      ptrdiff_t rend = b->deferred_changes[i].end;
+
+      if (rend < charpos)
+	{
+	  r[n].beg = rbeg;
+	  r[n++].end = rend;
+	}
+      else if (rbeg > old_end)
+	{
+	  if (!placed)
+	    {
+	      r[n].beg = beg;
+	      r[n++].end = end;
+	      placed = true;
+	    }
+	  r[n].beg = rbeg + delta;
+	  r[n++].end = rend + delta;
+	}
+      else
+	{
+	  beg = min (beg, rbeg);
+	  if (rend > old_end)
+	    end = max (end, rend + delta);
+	}
+    }
+  if (!placed)
+    {
+      r[n].beg = beg;
+      r[n++].end = end;
+    }
+
+  if (n > DEFERRED_CHANGE_RANGES)
+    {
+      closest = 0;
+      for (i = 1; i < n - 1; i++)
+	if (r[i + 1].beg - r[i].end < r[closest + 1].beg - r[closest].end)
+	  closest = i;
+      r[closest].end = r[closest + 1].end;
+      n--;
+      memmove (r + closest + 1, r + closest + 2,
+	       (n - closest - 1) * sizeof *r);
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      b->deferred_changes[i].beg = r[i].beg;
+      b->deferred_changes[i].end = r[i].end;
+    }
+  b->deferred_change_count = n;
+}
+
 /* Signal a change immediately after it happens.
    CHARPOS is the character position of the start of the changed text.
    LENDEL is the number of characters of the text before the change.
@@ -2027,6 +2383,9 @@ signal_after_change (ptrdiff_t charpos, ptrdiff_t lendel, ptrdiff_t lenins)
     return;
   }
 
+  if (!NILP (Vdeferred_change_functions))
+    record_deferred_change (charpos, lendel, lenins);
+
   /* If we are deferring calls to the after-change functions
      and there are no before-change functions,
      just record the args that we were going to use.  */
@@ -2187,6 +2546,66 @@ DEFUN ("combine-after-change-execute", Fcombine_after_change_execute,
   return Qnil;
 }
 
+DEFUN ("run-deferred-change-functions", Frun_deferred_change_functions,
+       Srun_deferred_change_functions, 0, 0, 0,
+       doc: /* Run `deferred-change-functions' for the changes made so far.
+Each buffer whose text changed since the last time is made current in
+turn, and the functions on its value of `deferred-change-functions' are
+called with one argument, a list of conses (BEG . END) giving the
+changed text in increasing order.  A deletion appears as a range where
+BEG equals END.  The command loop calls this after each command,
+before `post-command-hook'; call it directly to deliver the changes
+sooner, for example at the end of a long batch of edits.  */)
+  (void)
+{
+  dynwind_begin ();
+  Lisp_Object tail, pending = Qnil;
+
+  /* Take all the ranges first, so that an error in one buffer's hook
+     does not leave the others with changes nobody will deliver.  */
+  for (tail = deferred_change_buffers; CONSP (tail); tail = XCDR (tail))
+    {
+      struct buffer *b = XBUFFER (XCAR (tail));
+      Lisp_Object ranges = Qnil;
+      int i;
+
+      for (i = b->deferred_change_count - 1; i >= 0; i--)
+	ranges = Fcons (Fcons (make_number (b->deferred_changes[i].beg),
+			       make_number (b->deferred_changes[i].end)),
+			ranges);
+      b->deferred_change_count = 0;
+      if (BUFFER_LIVE_P (b) && CONSP (ranges))
+	pending = Fcons (Fcons (XCAR (tail), ranges), pending);
+    }
+  deferred_change_buffers = Qnil;
+
+  record_unwind_current_buffer ();
+  specbind (Qinhibit_modification_hooks, Qt);
+
+  for (; CONSP (pending); pending = XCDR (pending))
+    {
+      Lisp_Object args[2];
+
+      set_buffer_internal (XBUFFER (XCAR (XCAR (pending))));
+      args[0] = Qdeferred_change_functions;
+      args[1] = XCDR (XCAR (pending));
+      Frun_hook_with_args (2, args);
+    }
+
+  dynwind_end ();
+  return Qnil;
+}
+
+/* Run `deferred-change-functions' for the pending changes, if any,
+   catching errors.  Called from the command loop.  */
+
+void
+flush_deferred_changes (void)
+{
+  if (!NILP (deferred_change_buffers))
+    safe_call (1, Qrun_deferred_change_functions);
+}
+
 void
 syms_of_insdel (void)
 {
@@ -2197,6 +2616,24 @@ syms_of_insdel (void)
   combine_after_change_list = Qnil;
   combine_after_change_buffer = Qnil;
 
+  staticpro (&deferred_change_buffers);
+  deferred_change_buffers = Qnil;
+  DEFSYM (Qdeferred_change_functions, "deferred-change-functions");
+  DEFSYM (Qrun_deferred_change_functions, "run-deferred-change-functions");
+
+  DEFVAR_LISP ("deferred-change-functions", Vdeferred_change_functions,
+	       doc: /* List of functions to call with the text changed by a command.
+Unlike `after-change-functions', which run after every single change,
+these run once after each command, with a list of conses (BEG . END)
+covering all the text changed during it, with overlapping and adjacent
+changes coalesced.  See `run-deferred-change-functions'.
+
+Changes are only recorded while this variable is non-nil in the buffer
+being changed, so it is normally set buffer-locally with `add-hook'.
+Changes made while `inhibit-modification-hooks' is non-nil are not
+recorded.  */);
+  Vdeferred_change_functions = Qnil;
+
   DEFVAR_LISP ("combine-after-change-calls", Vcombine_after_change_calls,
 	       doc: /* Used internally by the function `combine-after-change-calls' macro.  */);
   Vcombine_after_change_calls = Qnil;
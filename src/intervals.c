@@ -543,6 +543,11 @@ buffer_balance_intervals (struct buffer *b)
    Note that this does not change the position of INTERVAL;  if it is a root,
    it is still a root after this operation.  */
 
+/* Number of intervals made by splitting since the last compaction
+   triggered from maybe_compact_intervals.  */
+
+EMACS_INT interval_splits;
+
 INTERVAL
 split_interval_right (INTERVAL interval, ptrdiff_t offset)
 {
@@ -550,6 +555,8 @@ split_interval_right (INTERVAL interval, ptrdiff_t offset)
   ptrdiff_t position = interval->position;
   ptrdiff_t new_length = LENGTH (interval) - offset;
 
+  interval_splits++;
+
   new->position = position + offset;
   set_interval_parent (new, interval);
 
@@ -593,6 +600,8 @@ split_interval_left (INTERVAL interval, ptrdiff_t offset)
   INTERVAL new = make_interval ();
   ptrdiff_t new_length = offset;
 
+  interval_splits++;
+
   new->position = interval->position;
   interval->position = interval->position + offset;
   set_interval_parent (new, interval);
@@ -1522,6 +1531,45 @@ merge_interval_left (register INTERVAL i)
   emacs_abort ();
 }
 
+/* Merge each interval of the text of OBJECT, a buffer or string, into
+   its predecessor when their properties are equal, then rebalance the
+   tree.  Such neighbors pile up in text whose properties change often,
+   since the property functions merge only what they happen to touch.
+   Return the number of intervals removed.  */
+
+ptrdiff_t
+compact_intervals (Lisp_Object object)
+{
+  INTERVAL tree, prev, i;
+  ptrdiff_t merged = 0;
+
+  tree = (BUFFERP (object) ? buffer_intervals (XBUFFER (object))
+	  : string_intervals (object));
+  if (!tree)
+    return 0;
+
+  prev = find_interval (tree, interval_start_pos (tree));
+  while ((i = next_interval (prev)) != NULL)
+    {
+      if (intervals_equal (prev, i))
+	{
+	  prev = merge_interval_left (i);
+	  merged++;
+	}
+      else
+	prev = i;
+    }
+
+  if (BUFFERP (object))
+    set_buffer_intervals (XBUFFER (object),
+			  balance_intervals (buffer_intervals
+					     (XBUFFER (object))));
+  else
+    set_string_intervals (object,
+			  balance_intervals (string_intervals (object)));
+  return merged;
+}
+
 /* Create a copy of SOURCE but with the default value of UP.  */
 
 static INTERVAL
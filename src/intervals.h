@@ -249,6 +249,8 @@ extern void graft_intervals_into_buffer (INTERVAL, ptrdiff_t, ptrdiff_t,
 extern void verify_interval_modification (struct buffer *,
 					  ptrdiff_t, ptrdiff_t);
 extern INTERVAL balance_intervals (INTERVAL);
+extern EMACS_INT interval_splits;
+extern ptrdiff_t compact_intervals (Lisp_Object);
 extern void copy_intervals_to_string (Lisp_Object, struct buffer *,
                                              ptrdiff_t, ptrdiff_t);
 extern INTERVAL copy_intervals (INTERVAL, ptrdiff_t, ptrdiff_t);
@@ -300,6 +302,7 @@ Lisp_Object get_char_property_and_overlay (Lisp_Object, Lisp_Object,
                                            Lisp_Object, Lisp_Object*);
 extern int text_property_stickiness (Lisp_Object prop, Lisp_Object pos,
                                      Lisp_Object buffer);
+extern void maybe_compact_intervals (void);
 
 extern void syms_of_textprop (void);
 
@@ -0,0 +1,978 @@
+/* JSON parsing and serialization.
+   Copyright (C) 2014 Free Software Foundation, Inc.
+
+This file is part of GNU Emacs.
+
+GNU Emacs is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GNU Emacs is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lisp.h"
+#include "character.h"
+#include "buffer.h"
+
+static Lisp_Object Qjson_error, Qjson_parse_error, Qjson_end_of_file;
+static Lisp_Object Qjson_trailing_content, Qjson_object_too_deep;
+static Lisp_Object Qjson_value_p;
+static Lisp_Object QCobject_type, QCarray_type, QCnull_object, QCfalse_object;
+static Lisp_Object QCnull, QCfalse;
+static Lisp_Object Qhash_table, Qalist, Qplist, Qarray, Qlist;
+
+/* Objects and arrays nested deeper than this are rejected, both when
+   parsing and when serializing; the latter also catches cycles.  */
+enum { JSON_MAX_DEPTH = 2048 };
+
+enum json_object_type
+  {
+    json_object_hashtable,
+    json_object_alist,
+    json_object_plist
+  };
+
+enum json_array_type
+  {
+    json_array_array,
+    json_array_list
+  };
+
+/* How JSON values map to Lisp objects, from the keyword arguments.  */
+struct json_configuration
+{
+  enum json_object_type object_type;
+  enum json_array_type array_type;
+  Lisp_Object null_object;
+  Lisp_Object false_object;
+};
+
+/* Fill in CONF from the NARGS keyword arguments at ARGS.  The object
+   and array types are accepted only if PARSING.  */
+
+static void
+json_parse_args (ptrdiff_t nargs, Lisp_Object *args,
+		 struct json_configuration *conf, bool parsing)
+{
+  ptrdiff_t i;
+
+  conf->object_type = json_object_hashtable;
+  conf->array_type = json_array_array;
+  conf->null_object = QCnull;
+  conf->false_object = QCfalse;
+
+  if (nargs % 2 != 0)
+    signal_error ("Odd number of keyword arguments", Flist (nargs, args));
+
+  for (i = 0; i < nargs; i += 2)
+    {
+      Lisp_Object key = args[i], value = args[i + 1];
+
+      if (parsing && EQ (key, QCobject_type))
+	{
+	  if (EQ (value, Qhash_table))
+	    conf->object_type = json_object_hashtable;
+	  else if (EQ (value, Qalist))
+	    conf->object_type = json_object_alist;
+	  else if (EQ (value, Qplist))
+	    conf->object_type = json_object_plist;
+	  else
+	    signal_error ("Invalid :object-type", value);
+	}
+      else if (parsing && EQ (key, QCarray_type))
+	{
+	  if (EQ (value, Qarray))
+	    conf->array_type = json_array_array;
+	  else if (EQ (value, Qlist))
+	    conf->array_type = json_array_list;
+	  else
+	    signal_error ("Invalid :array-type", value);
+	}
+      else if (EQ (key, QCnull_object))
+	conf->null_object = value;
+      else if (EQ (key, QCfalse_object))
+	conf->false_object = value;
+      else
+	signal_error ("Invalid keyword argument", key);
+    }
+}
+
+
+/***********************************************************************
+				Parsing
+ ***********************************************************************/
+
+/* State of a parse over the bytes START..END, which hold text in
+   Emacs's internal representation.  */
+struct json_parser
+{
+  const unsigned char *start, *p, *end;
+
+  /* Whether the input is multibyte, and the character position of
+     START, used to report error positions.  */
+  bool multibyte;
+  ptrdiff_t base_charpos;
+
+  int depth;
+  struct json_configuration conf;
+
+  /* Scratch space for strings that contain escapes.  */
+  unsigned char *buf;
+  ptrdiff_t buf_size;
+};
+
+/* Signal ERROR at the current position of parser P.  */
+
+static _Noreturn void
+json_signal (struct json_parser *p, Lisp_Object error)
+{
+  ptrdiff_t nbytes = p->p - p->start;
+  ptrdiff_t nchars = (p->multibyte
+		      ? multibyte_chars_in_text (p->start, nbytes)
+		      : nbytes);
+  xsignal1 (error, make_number (p->base_charpos + nchars));
+}
+
+static void
+json_skip_whitespace (struct json_parser *p)
+{
+  while (p->p < p->end
+	 && (*p->p == ' ' || *p->p == '\t' || *p->p == '\n' || *p->p == '\r'))
+    p->p++;
+}
+
+/* Skip whitespace and return the next byte without consuming it.  */
+
+static int
+json_peek (struct json_parser *p)
+{
+  json_skip_whitespace (p);
+  if (p->p == p->end)
+    json_signal (p, Qjson_end_of_file);
+  return *p->p;
+}
+
+/* Consume the byte C, which must come next after whitespace.  */
+
+static void
+json_expect (struct json_parser *p, int c)
+{
+  if (json_peek (p) != c)
+    json_signal (p, Qjson_parse_error);
+  p->p++;
+}
+
+/* Make room for NBYTES more bytes after the first USED bytes of the
+   scratch buffer of P.  */
+
+static void
+json_reserve (struct json_parser *p, ptrdiff_t used, ptrdiff_t nbytes)
+{
+  if (p->buf_size - used < nbytes)
+    p->buf = xpalloc (p->buf, &p->buf_size, nbytes - (p->buf_size - used),
+		      STRING_BYTES_BOUND, 1);
+}
+
+/* Return the value of the four hex digits at P->p, and skip them.  */
+
+static int
+json_read_hex4 (struct json_parser *p)
+{
+  int i, value = 0;
+
+  if (p->end - p->p < 4)
+    json_signal (p, Qjson_end_of_file);
+  for (i = 0; i < 4; i++)
+    {
+      int c = *p->p, digit;
+      if ('0' <= c && c <= '9')
+	digit = c - '0';
+      else if ('a' <= c && c <= 'f')
+	digit = c - 'a' + 10;
+      else if ('A' <= c && c <= 'F')
+	digit = c - 'A' + 10;
+      else
+	json_signal (p, Qjson_parse_error);
+      value = (value << 4) + digit;
+      p->p++;
+    }
+  return value;
+}
+
+/* Read the string that starts at P->p, just after its opening quote.
+   Store in *DATA and *NBYTES the text of the string, which points
+   into the input if the string has no escapes and into the scratch
+   buffer otherwise.  If PREFIX is nonzero, the text always goes into
+   the scratch buffer, preceded by the byte PREFIX.  */
+
+static void
+json_read_string (struct json_parser *p, int prefix,
+		  const unsigned char **data, ptrdiff_t *nbytes)
+{
+  const unsigned char *run = p->p;
+  ptrdiff_t used = 0;
+
+  /* The common case: no escapes, so the text can be used in place.  */
+  while (p->p < p->end && *p->p != '"' && *p->p != '\\' && *p->p >= 0x20)
+    p->p++;
+  if (p->p == p->end)
+    json_signal (p, Qjson_end_of_file);
+  if (*p->p == '"' && !prefix)
+    {
+      *data = run;
+      *nbytes = p->p - run;
+      p->p++;
+      return;
+    }
+
+  if (prefix)
+    {
+      json_reserve (p, used, 1);
+      p->buf[used++] = prefix;
+    }
+
+  for (;;)
+    {
+      int c;
+
+      json_reserve (p, used, p->p - run + MAX_MULTIBYTE_LENGTH);
+      memcpy (p->buf + used, run, p->p - run);
+      used += p->p - run;
+
+      if (p->p == p->end)
+	json_signal (p, Qjson_end_of_file);
+      if (*p->p == '"')
+	break;
+      if (*p->p < 0x20)
+	json_signal (p, Qjson_parse_error);
+
+      /* An escape sequence.  */
+      p->p++;
+      if (p->p == p->end)
+	json_signal (p, Qjson_end_of_file);
+      switch (*p->p++)
+	{
+	case '"': c = '"'; break;
+	case '\\': c = '\\'; break;
+	case '/': c = '/'; break;
+	case 'b': c = '\b'; break;
+	case 'f': c = '\f'; break;
+	case 'n': c = '\n'; break;
+	case 'r': c = '\r'; break;
+	case 't': c = '\t'; break;
+	case 'u':
+	  c = json_read_hex4 (p);
+	  /* Combine a surrogate pair; a lone surrogate stays as is.  */
+	  if (0xD800 <= c && c < 0xDC00
+	      && p->end - p->p >= 6 && p->p[0] == '\\' && p->p[1] == 'u')
+	    {
+	      const unsigned char *save = p->p;
+	      int low;
+
+	      p->p += 2;
+	      low = json_read_hex4 (p);
+	      if (0xDC00 <= low && low < 0xE000)
+		c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+	      else
+		p->p = save;
+	    }
+	  break;
+	default:
+	  p->p--;
+	  json_signal (p, Qjson_parse_error);
+	}
+      used += CHAR_STRING (c, p->buf + used);
+
+      run = p->p;
+      while (p->p < p->end && *p->p != '"' && *p->p != '\\'
+	     && *p->p >= 0x20)
+	p->p++;
+    }
+
+  *data = p->buf;
+  *nbytes = used;
+  p->p++;
+}
+
+/* Read the number that starts at P->p.  Integers that fit in a fixnum
+   become fixnums; everything else becomes a float.  */
+
+static Lisp_Object
+json_read_number (struct json_parser *p)
+{
+  const unsigned char *start = p->p;
+  bool negative = false, integral = true, overflow = false;
+  EMACS_INT value = 0;
+  Lisp_Object result;
+
+  if (*p->p == '-')
+    {
+      negative = true;
+      p->p++;
+    }
+  if (p->p == p->end)
+    json_signal (p, Qjson_end_of_file);
+  if (*p->p == '0')
+    p->p++;
+  else if ('1' <= *p->p && *p->p <= '9')
+    while (p->p < p->end && '0' <= *p->p && *p->p <= '9')
+      {
+	int digit = *p->p++ - '0';
+	if (value > (MOST_POSITIVE_FIXNUM - digit) / 10)
+	  overflow = true;
+	else
+	  value = value * 10 + digit;
+      }
+  else
+    json_signal (p, Qjson_parse_error);
+
+  if (p->p < p->end && *p->p == '.')
+    {
+      integral = false;
+      p->p++;
+      if (p->p == p->end || !('0' <= *p->p && *p->p <= '9'))
+	json_signal (p, Qjson_parse_error);
+      while (p->p < p->end && '0' <= *p->p && *p->p <= '9')
+	p->p++;
+    }
+  if (p->p < p->end && (*p->p == 'e' || *p->p == 'E'))
+    {
+      integral = false;
+      p->p++;
+      if (p->p < p->end && (*p->p == '+' || *p->p == '-'))
+	p->p++;
+      if (p->p == p->end || !('0' <= *p->p && *p->p <= '9'))
+	json_signal (p, Qjson_parse_error);
+      while (p->p < p->end && '0' <= *p->p && *p->p <= '9')
+	p->p++;
+    }
+
+  if (integral && !overflow)
+    return make_number (negative ? - value : value);
+  else
+    {
+      /* The input need not be null-terminated, so copy the number
+	 for strtod.  */
+      ptrdiff_t len = p->p - start;
+      char *copy;
+      USE_SAFE_ALLOCA;
+
+      copy = SAFE_ALLOCA (len + 1);
+      memcpy (copy, start, len);
+      copy[len] = '\0';
+      result = make_float (strtod (copy, NULL));
+      SAFE_FREE ();
+      return result;
+    }
+}
+
+/* Consume the literal NAME of NBYTES bytes, which must come next.  */
+
+static void
+json_read_literal (struct json_parser *p, const char *name, ptrdiff_t nbytes)
+{
+  if (p->end - p->p < nbytes)
+    {
+      if (memcmp (p->p, name, p->end - p->p) == 0)
+	{
+	  p->p = p->end;
+	  json_signal (p, Qjson_end_of_file);
+	}
+      json_signal (p, Qjson_parse_error);
+    }
+  if (memcmp (p->p, name, nbytes) != 0)
+    json_signal (p, Qjson_parse_error);
+  p->p += nbytes;
+}
+
+static Lisp_Object json_read_value (struct json_parser *);
+
+/* Read the object that starts at P->p, just after its opening brace.  */
+
+static Lisp_Object
+json_read_object (struct json_parser *p)
+{
+  Lisp_Object result = Qnil, tail = Qnil;
+
+  if (p->conf.object_type == json_object_hashtable)
+    result = make_hash_table (hashtest_equal, make_number (DEFAULT_HASH_SIZE),
+			      make_float (DEFAULT_REHASH_SIZE),
+			      make_float (DEFAULT_REHASH_THRESHOLD), Qnil);
+
+  if (json_peek (p) == '}')
+    {
+      p->p++;
+      return result;
+    }
+
+  for (;;)
+    {
+      const unsigned char *data;
+      ptrdiff_t nbytes;
+      Lisp_Object key, value, entry;
+
+      json_expect (p, '"');
+      switch (p->conf.object_type)
+	{
+	case json_object_hashtable:
+	  json_read_string (p, 0, &data, &nbytes);
+	  key = make_string ((const char *) data, nbytes);
+	  break;
+	case json_object_alist:
+	  json_read_string (p, 0, &data, &nbytes);
+	  key = intern_1 ((const char *) data, nbytes);
+	  break;
+	default:
+	  json_read_string (p, ':', &data, &nbytes);
+	  key = intern_1 ((const char *) data, nbytes);
+	  break;
+	}
+      json_expect (p, ':');
+      value = json_read_value (p);
+
+      /* Keep document order in alists and plists; in a hash table,
+	 the last of several equal keys wins.  */
+      switch (p->conf.object_type)
+	{
+	case json_object_hashtable:
+	  Fputhash (key, value, result);
+	  break;
+	case json_object_alist:
+	  entry = list1 (Fcons (key, value));
+	  if (NILP (tail))
+	    result = entry;
+	  else
+	    XSETCDR (tail, entry);
+	  tail = entry;
+	  break;
+	default:
+	  entry = list2 (key, value);
+	  if (NILP (tail))
+	    result = entry;
+	  else
+	    XSETCDR (tail, entry);
+	  tail = XCDR (entry);
+	  break;
+	}
+
+      if (json_peek (p) == '}')
+	break;
+      json_expect (p, ',');
+    }
+  p->p++;
+  return result;
+}
+
+/* Read the array that starts at P->p, just after its opening bracket.  */
+
+static Lisp_Object
+json_read_array (struct json_parser *p)
+{
+  Lisp_Object result = Qnil, tail = Qnil, vector;
+  ptrdiff_t n = 0, i;
+
+  if (json_peek (p) != ']')
+    for (;;)
+      {
+	Lisp_Object entry = list1 (json_read_value (p));
+	if (NILP (tail))
+	  result = entry;
+	else
+	  XSETCDR (tail, entry);
+	tail = entry;
+	n++;
+
+	if (json_peek (p) == ']')
+	  break;
+	json_expect (p, ',');
+      }
+  p->p++;
+
+  if (p->conf.array_type == json_array_list)
+    return result;
+
+  vector = make_uninit_vector (n);
+  for (i = 0; i < n; i++, result = XCDR (result))
+    ASET (vector, i, XCAR (result));
+  return vector;
+}
+
+static Lisp_Object
+json_read_value (struct json_parser *p)
+{
+  const unsigned char *data;
+  ptrdiff_t nbytes;
+  Lisp_Object result;
+
+  switch (json_peek (p))
+    {
+    case '{':
+    case '[':
+      if (++p->depth > JSON_MAX_DEPTH)
+	json_signal (p, Qjson_object_too_deep);
+      result = (*p->p++ == '{' ? json_read_object (p) : json_read_array (p));
+      p->depth--;
+      return result;
+
+    case '"':
+      p->p++;
+      json_read_string (p, 0, &data, &nbytes);
+      return make_string ((const char *) data, nbytes);
+
+    case 't':
+      json_read_literal (p, "true", 4);
+      return Qt;
+
+    case 'f':
+      json_read_literal (p, "false", 5);
+      return p->conf.false_object;
+
+    case 'n':
+      json_read_literal (p, "null", 4);
+      return p->conf.null_object;
+
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+      return json_read_number (p);
+
+    default:
+      json_signal (p, Qjson_parse_error);
+    }
+}
+
+/* Initialize parser P over the NBYTES bytes at START, whose first
+   character is at BASE_CHARPOS, using the keyword arguments ARGS.  */
+
+static void
+json_init_parser (struct json_parser *p, const unsigned char *start,
+		  ptrdiff_t nbytes, bool multibyte, ptrdiff_t base_charpos,
+		  ptrdiff_t nargs, Lisp_Object *args)
+{
+  json_parse_args (nargs, args, &p->conf, true);
+  p->start = p->p = start;
+  p->end = start + nbytes;
+  p->multibyte = multibyte;
+  p->base_charpos = base_charpos;
+  p->depth = 0;
+  p->buf = NULL;
+  p->buf_size = 0;
+}
+
+DEFUN ("json-parse-string", Fjson_parse_string, Sjson_parse_string,
+       1, MANY, 0,
+       doc: /* Parse the JSON STRING into a Lisp object.
+STRING must hold exactly one JSON value, optionally surrounded by
+whitespace.  JSON objects become hash tables, alists or plists, arrays
+become vectors or lists, `true' becomes t, and numbers become integers
+when they have no fraction or exponent and fit in a fixnum, and floats
+otherwise.
+
+ARGS are keyword/argument pairs:
+
+The keyword argument `:object-type' specifies which Lisp type is used
+to represent objects; it can be `hash-table' (the default), `alist' or
+`plist'.  Hash tables have string keys and use `equal'; alists have
+symbol keys and plists keyword keys, both in document order.
+
+The keyword argument `:array-type' specifies which Lisp type is used
+to represent arrays; it can be `array' (the default) or `list'.
+
+The keyword argument `:null-object' specifies which object to use to
+represent a JSON null value.  It defaults to `:null'.
+
+The keyword argument `:false-object' specifies which object to use to
+represent a JSON false value.  It defaults to `:false'.
+
+Signal `json-parse-error' for malformed input, `json-end-of-file' if
+STRING ends too early, and `json-trailing-content' if anything but
+whitespace follows the value.  The error data is the character
+position of the problem.
+usage: (json-parse-string STRING &rest ARGS) */)
+  (ptrdiff_t nargs, Lisp_Object *args)
+{
+  struct json_parser p;
+  Lisp_Object string = args[0], value;
+
+  CHECK_STRING (string);
+  json_init_parser (&p, SDATA (string), SBYTES (string),
+		    STRING_MULTIBYTE (string), 0, nargs - 1, args + 1);
+  value = json_read_value (&p);
+  json_skip_whitespace (&p);
+  if (p.p != p.end)
+    json_signal (&p, Qjson_trailing_content);
+  return value;
+}
+
+DEFUN ("json-parse-buffer", Fjson_parse_buffer, Sjson_parse_buffer,
+       0, MANY, 0,
+       doc: /* Read the JSON value that follows point and return it.
+Move point to just after the value.  Unlike `json-parse-string', text
+after the value is left alone.  ARGS are keyword/argument pairs, as
+for `json-parse-string'.
+usage: (json-parse-buffer &rest ARGS) */)
+  (ptrdiff_t nargs, Lisp_Object *args)
+{
+  struct json_parser p;
+  Lisp_Object value;
+  ptrdiff_t pos_byte;
+
+  /* Make the accessible text after point contiguous.  */
+  if (PT_BYTE < GPT_BYTE && GPT_BYTE < ZV_BYTE)
+    move_gap_both (PT, PT_BYTE);
+
+  json_init_parser (&p, PT_ADDR, ZV_BYTE - PT_BYTE,
+		    !NILP (BVAR (current_buffer, enable_multibyte_characters)),
+		    PT, nargs, args);
+  value = json_read_value (&p);
+
+  pos_byte = PT_BYTE + (p.p - p.start);
+  SET_PT_BOTH (BYTE_TO_CHAR (pos_byte), pos_byte);
+  return value;
+}
+
+
+/***********************************************************************
+			      Serialization
+ ***********************************************************************/
+
+/* Append the NBYTES ASCII bytes at S to builder B.  */
+
+static void
+json_out (struct Lisp_String_Builder *b, const char *s, ptrdiff_t nbytes)
+{
+  string_builder_append (b, (const unsigned char *) s, nbytes, nbytes, false);
+}
+
+/* Append STRING to B as a JSON string.  Everything but printable
+   ASCII is escaped, so the output is always plain ASCII.  */
+
+static void
+json_serialize_string (struct Lisp_String_Builder *b, Lisp_Object string)
+{
+  const unsigned char *p = SDATA (string), *end = p + SBYTES (string);
+  bool multibyte = STRING_MULTIBYTE (string);
+
+  json_out (b, "\"", 1);
+  while (p < end)
+    {
+      const unsigned char *run = p;
+      char escape[13];
+      int c, len;
+
+      while (p < end && 0x20 <= *p && *p < 0x7f && *p != '"' && *p != '\\')
+	p++;
+      if (p > run)
+	json_out (b, (const char *) run, p - run);
+      if (p == end)
+	break;
+
+      if (multibyte)
+	{
+	  c = STRING_CHAR_AND_LENGTH (p, len);
+	  p += len;
+	  if (CHAR_BYTE8_P (c))
+	    wrong_type_argument (Qjson_value_p, string);
+	}
+      else
+	c = *p++;
+
+      switch (c)
+	{
+	case '"': json_out (b, "\\\"", 2); break;
+	case '\\': json_out (b, "\\\\", 2); break;
+	case '\b': json_out (b, "\\b", 2); break;
+	case '\f': json_out (b, "\\f", 2); break;
+	case '\n': json_out (b, "\\n", 2); break;
+	case '\r': json_out (b, "\\r", 2); break;
+	case '\t': json_out (b, "\\t", 2); break;
+	default:
+	  if (c < 0x10000)
+	    len = sprintf (escape, "\\u%04x", c);
+	  else
+	    len = sprintf (escape, "\\u%04x\\u%04x",
+			   0xD800 + ((c - 0x10000) >> 10),
+			   0xDC00 + ((c - 0x10000) & 0x3FF));
+	  json_out (b, escape, len);
+	  break;
+	}
+    }
+  json_out (b, "\"", 1);
+}
+
+/* Return true if LIST is an alist whose keys are atoms.  */
+
+static bool
+json_alist_p (Lisp_Object list)
+{
+  for (; CONSP (list); list = XCDR (list))
+    if (!CONSP (XCAR (list)) || CONSP (XCAR (XCAR (list))))
+      return false;
+  return NILP (list);
+}
+
+/* Return true if LIST is a plist whose keys are keywords.  */
+
+static bool
+json_plist_p (Lisp_Object list)
+{
+  for (; CONSP (list); list = XCDR (XCDR (list)))
+    if (NILP (Fkeywordp (XCAR (list))) || !CONSP (XCDR (list)))
+      return false;
+  return NILP (list);
+}
+
+static void json_serialize (struct Lisp_String_Builder *, Lisp_Object,
+			    struct json_configuration *, int);
+
+/* Append KEY to B as an object key.  Keys are strings, or symbols
+   other than the constants that stand for JSON keywords; a keyword
+   symbol loses its colon.  */
+
+static void
+json_serialize_key (struct Lisp_String_Builder *b, Lisp_Object key,
+		    struct json_configuration *conf)
+{
+  if (SYMBOLP (key) && !NILP (key) && !EQ (key, Qt)
+      && !EQ (key, conf->null_object) && !EQ (key, conf->false_object))
+    {
+      Lisp_Object name = SYMBOL_NAME (key);
+      if (!NILP (Fkeywordp (key)))
+	name = Fsubstring (name, make_number (1), Qnil);
+      json_serialize_string (b, name);
+    }
+  else if (STRINGP (key))
+    json_serialize_string (b, key);
+  else
+    wrong_type_argument (Qjson_value_p, key);
+  json_out (b, ":", 1);
+}
+
+/* Append OBJECT to B as JSON.  DEPTH counts the enclosing objects and
+   arrays.  */
+
+static void
+json_serialize (struct Lisp_String_Builder *b, Lisp_Object object,
+		struct json_configuration *conf, int depth)
+{
+  ptrdiff_t i;
+
+  if (EQ (object, Qt))
+    json_out (b, "true", 4);
+  else if (EQ (object, conf->false_object))
+    json_out (b, "false", 5);
+  else if (NILP (object) || EQ (object, conf->null_object))
+    json_out (b, "null", 4);
+  else if (STRINGP (object))
+    json_serialize_string (b, object);
+  else if (SYMBOLP (object))
+    {
+      Lisp_Object name = SYMBOL_NAME (object);
+      if (!NILP (Fkeywordp (object)))
+	name = Fsubstring (name, make_number (1), Qnil);
+      json_serialize_string (b, name);
+    }
+  else if (INTEGERP (object))
+    {
+      char buf[INT_BUFSIZE_BOUND (EMACS_INT)];
+      json_out (b, buf, sprintf (buf, "%"pI"d", XINT (object)));
+    }
+  else if (FLOATP (object))
+    {
+      char buf[FLOAT_TO_STRING_BUFSIZE];
+      if (! isfinite (XFLOAT_DATA (object)))
+	wrong_type_argument (Qjson_value_p, object);
+      json_out (b, buf, float_to_string (buf, XFLOAT_DATA (object)));
+    }
+  else
+    {
+      if (++depth > JSON_MAX_DEPTH)
+	xsignal1 (Qjson_object_too_deep, object);
+
+      if (VECTORP (object))
+	{
+	  json_out (b, "[", 1);
+	  for (i = 0; i < ASIZE (object); i++)
+	    {
+	      if (i > 0)
+		json_out (b, ",", 1);
+	      json_serialize (b, AREF (object, i), conf, depth);
+	    }
+	  json_out (b, "]", 1);
+	}
+      else if (HASH_TABLE_P (object))
+	{
+	  struct Lisp_Hash_Table *h = XHASH_TABLE (object);
+	  bool first = true;
+
+	  json_out (b, "{", 1);
+	  for (i = 0; i < HASH_TABLE_SIZE (h); i++)
+	    if (!NILP (HASH_HASH (h, i)))
+	      {
+		if (!first)
+		  json_out (b, ",", 1);
+		first = false;
+		json_serialize_key (b, HASH_KEY (h, i), conf);
+		json_serialize (b, HASH_VALUE (h, i), conf, depth);
+	      }
+	  json_out (b, "}", 1);
+	}
+      else if (json_alist_p (object))
+	{
+	  json_out (b, "{", 1);
+	  for (; CONSP (object); object = XCDR (object))
+	    {
+	      json_serialize_key (b, XCAR (XCAR (object)), conf);
+	      json_serialize (b, XCDR (XCAR (object)), conf, depth);
+	      if (CONSP (XCDR (object)))
+		json_out (b, ",", 1);
+	    }
+	  json_out (b, "}", 1);
+	}
+      else if (json_plist_p (object))
+	{
+	  json_out (b, "{", 1);
+	  for (; CONSP (object); object = XCDR (XCDR (object)))
+	    {
+	      json_serialize_key (b, XCAR (object), conf);
+	      json_serialize (b, XCAR (XCDR (object)), conf, depth);
+	      if (CONSP (XCDR (XCDR (object))))
+		json_out (b, ",", 1);
+	    }
+	  json_out (b, "}", 1);
+	}
+      else if (CONSP (object))
+	{
+	  Lisp_Object tail;
+
+	  json_out (b, "[", 1);
+	  for (tail = object; CONSP (tail); tail = XCDR (tail))
+	    {
+	      if (!EQ (tail, object))
+		json_out (b, ",", 1);
+	      json_serialize (b, XCAR (tail), conf, depth);
+	    }
+	  if (!NILP (tail))
+	    wrong_type_argument (Qlistp, object);
+	  json_out (b, "]", 1);
+	}
+      else
+	wrong_type_argument (Qjson_value_p, object);
+    }
+}
+
+/* Serialize ARGS[0] using the keyword arguments in the rest of ARGS,
+   and return the builder holding the result.  */
+
+static Lisp_Object
+json_serialize_args (ptrdiff_t nargs, Lisp_Object *args)
+{
+  struct json_configuration conf;
+  Lisp_Object builder = Fmake_string_builder ();
+
+  json_parse_args (nargs - 1, args + 1, &conf, false);
+  json_serialize (XSTRING_BUILDER (builder), args[0], &conf, 0);
+  return builder;
+}
+
+DEFUN ("json-serialize", Fjson_serialize, Sjson_serialize, 1, MANY, 0,
+       doc: /* Return the JSON representation of OBJECT as a string.
+t becomes `true', nil becomes `null', strings and symbols become JSON
+strings (a keyword loses its colon), and numbers become JSON numbers.
+Vectors and lists become arrays, except that hash tables, alists and
+plists with keyword keys become objects.  Object keys must be strings
+or symbols.  The result is plain ASCII: other characters are written
+as \\uXXXX escapes.
+
+ARGS are keyword/argument pairs; `:null-object' and `:false-object'
+name the objects that become `null' and `false', as for
+`json-parse-string'.
+usage: (json-serialize OBJECT &rest ARGS) */)
+  (ptrdiff_t nargs, Lisp_Object *args)
+{
+  return Fstring_builder_string (json_serialize_args (nargs, args), Qnil);
+}
+
+DEFUN ("json-insert", Fjson_insert, Sjson_insert, 1, MANY, 0,
+       doc: /* Insert the JSON representation of OBJECT before point.
+This is the same as (insert (json-serialize OBJECT ARGS...)), but
+does not make an intermediate string.
+usage: (json-insert OBJECT &rest ARGS) */)
+  (ptrdiff_t nargs, Lisp_Object *args)
+{
+  struct Lisp_String_Builder *b
+    = XSTRING_BUILDER (json_serialize_args (nargs, args));
+
+  insert_1_both ((char *) b->data, b->nchars, b->nbytes, 0, 1, 0);
+  return Qnil;
+}
+
+
+/***********************************************************************
+			    Initialization
+ ***********************************************************************/
+void
+syms_of_json (void)
+{
+#include "json.x"
+
+  DEFSYM (Qjson_error, "json-error");
+  DEFSYM (Qjson_parse_error, "json-parse-error");
+  DEFSYM (Qjson_end_of_file, "json-end-of-file");
+  DEFSYM (Qjson_trailing_content, "json-trailing-content");
+  DEFSYM (Qjson_object_too_deep, "json-object-too-deep");
+  DEFSYM (Qjson_value_p, "json-value-p");
+
+  DEFSYM (QCobject_type, ":object-type");
+  DEFSYM (QCarray_type, ":array-type");
+  DEFSYM (QCnull_object, ":null-object");
+  DEFSYM (QCfalse_object, ":false-object");
+  DEFSYM (QCnull, ":null");
+  DEFSYM (QCfalse, ":false");
+
+  DEFSYM (Qhash_table, "hash-table");
+  DEFSYM (Qalist, "alist");
+  DEFSYM (Qplist, "plist");
+  DEFSYM (Qarray, "array");
+  DEFSYM (Qlist, "list");
+
+  Fput (Qjson_error, Qerror_conditions,
+	Fpurecopy (list2 (Qjson_error, Qerror)));
+  Fput (Qjson_error, Qerror_message,
+	build_pure_c_string ("Unknown JSON error"));
+
+  Fput (Qjson_parse_error, Qerror_conditions,
+	Fpurecopy (list3 (Qjson_parse_error, Qjson_error, Qerror)));
+  Fput (Qjson_parse_error, Qerror_message,
+	build_pure_c_string ("Could not parse JSON"));
+
+  /* Also an `end-of-file', which is what json.el used to signal.  */
+  Fput (Qjson_end_of_file, Qerror_conditions,
+	Fpurecopy (list5 (Qjson_end_of_file, Qjson_parse_error, Qend_of_file,
+			  Qjson_error, Qerror)));
+  Fput (Qjson_end_of_file, Qerror_message,
+	build_pure_c_string ("End of JSON input"));
+
+  Fput (Qjson_trailing_content, Qerror_conditions,
+	Fpurecopy (list4 (Qjson_trailing_content, Qjson_parse_error,
+			  Qjson_error, Qerror)));
+  Fput (Qjson_trailing_content, Qerror_message,
+	build_pure_c_string ("Trailing content after JSON value"));
+
+  Fput (Qjson_object_too_deep, Qerror_conditions,
+	Fpurecopy (list3 (Qjson_object_too_deep, Qjson_error, Qerror)));
+  Fput (Qjson_object_too_deep, Qerror_message,
+	build_pure_c_string ("JSON object too deep"));
+}
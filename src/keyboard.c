@@ -230,6 +230,7 @@ static Lisp_Object Qforward_char;
 static Lisp_Object Qbackward_char;
 Lisp_Object Qundefined;
 static Lisp_Object Qtimer_event_handler;
+static Lisp_Object Qtimerp;
 
 /* `read_key_sequence' stores here the command definition of the
    key sequence that it reads.  */
@@ -287,6 +288,13 @@ static struct input_event * volatile kbd_store_ptr;
    dequeuing functions?  Such a flag could be screwed up by interrupts
    at inopportune times.  */
 
+/* Events stored while kbd_buffer was full, in the order they arrived.
+   Those from KBD_OVERFLOW_HEAD to KBD_OVERFLOW_COUNT have not yet been
+   moved into kbd_buffer; kbd_buffer_refill does that as soon as it
+   has room, so that bursts of input are not lost.  */
+static struct input_event *kbd_overflow;
+static ptrdiff_t kbd_overflow_head, kbd_overflow_count, kbd_overflow_size;
+
 /* Symbols to head events.  */
 static Lisp_Object Qmouse_movement;
 static Lisp_Object Qscroll_bar_movement;
@@ -1385,6 +1393,7 @@ command_loop_1 (void)
 	 throw to top level.  */
       /* Note that the value cell will never directly contain nil
 	 if the symbol is a local variable.  */
+      flush_deferred_changes ();
       if (!NILP (Vpost_command_hook) && !NILP (Vrun_hooks))
 	safe_run_hooks (Qpost_command_hook);
 
@@ -1581,6 +1590,7 @@ command_loop_1 (void)
 		     ? Qnil : BVAR (current_buffer, undo_list));
 	      }
             call1 (Qcommand_execute, Vthis_command);
+            note_input_latency (INPUT_LATENCY_COMMAND);
 
 #ifdef HAVE_WINDOW_SYSTEM
 	  /* Do not check display_hourglass_p here, because
@@ -1593,6 +1603,7 @@ command_loop_1 (void)
           }
       kset_last_prefix_arg (current_kboard, Vcurrent_prefix_arg);
 
+      flush_deferred_changes ();
       safe_run_hooks (Qpost_command_hook);
 
       /* If displaying a message, resize the echo area window to fit
@@ -3253,6 +3264,7 @@ read_char_1 (bool jump, volatile struct read_char_state *state)
     }
 
  exit:
+  note_input_latency (INPUT_LATENCY_READ);
   RETURN_UNGCPRO (c);
 #undef commandflag
 #undef map
@@ -3462,6 +3474,27 @@ record_char (Lisp_Object c)
    kbd_buffer_store_event places events in kbd_buffer, and
    kbd_buffer_get_event retrieves them.  */
 
+/* Move events waiting in kbd_overflow into kbd_buffer, as many as
+   fit.  */
+static void
+kbd_buffer_refill (void)
+{
+  while (kbd_overflow_head < kbd_overflow_count)
+    {
+      if (kbd_store_ptr - kbd_buffer == KBD_BUFFER_SIZE)
+	kbd_store_ptr = kbd_buffer;
+      if (kbd_fetch_ptr - 1 == kbd_store_ptr
+	  || (kbd_fetch_ptr == kbd_buffer
+	      && kbd_store_ptr == kbd_buffer + KBD_BUFFER_SIZE - 1))
+	return;
+      *kbd_store_ptr = kbd_overflow[kbd_overflow_head];
+      clear_event (&kbd_overflow[kbd_overflow_head]);
+      kbd_overflow_head++;
+      ++kbd_store_ptr;
+    }
+  kbd_overflow_head = kbd_overflow_count = 0;
+}
+
 /* Return true if there are any events in the queue that read-char
    would return.  If this returns false, a read-char would block.  */
 static bool
@@ -3470,6 +3503,8 @@ readable_events (int flags)
   if (flags & READABLE_EVENTS_DO_TIMERS_NOW)
     timer_check ();
 
+  kbd_buffer_refill ();
+
   /* If the buffer contains only FOCUS_IN_EVENT events, and
      READABLE_EVENTS_FILTER_EVENTS is set, report it as empty.  */
   if (kbd_fetch_ptr != kbd_store_ptr)
@@ -3554,18 +3589,203 @@ event_to_kboard (struct input_event *event)
 #ifdef subprocesses
 /* Return the number of slots occupied in kbd_buffer.  */
 
-static int
+static ptrdiff_t
 kbd_buffer_nr_stored (void)
 {
-  return kbd_fetch_ptr == kbd_store_ptr
-    ? 0
-    : (kbd_fetch_ptr < kbd_store_ptr
-       ? kbd_store_ptr - kbd_fetch_ptr
-       : ((kbd_buffer + KBD_BUFFER_SIZE) - kbd_fetch_ptr
-          + (kbd_store_ptr - kbd_buffer)));
+  return (kbd_overflow_count - kbd_overflow_head
+	  + (kbd_fetch_ptr == kbd_store_ptr
+	     ? 0
+	     : (kbd_fetch_ptr < kbd_store_ptr
+		? kbd_store_ptr - kbd_fetch_ptr
+		: ((kbd_buffer + KBD_BUFFER_SIZE) - kbd_fetch_ptr
+		   + (kbd_store_ptr - kbd_buffer)))));
 }
 #endif	/* Store an event obtained at interrupt level into kbd_buffer, fifo */
 
+/* Input latency tracing.  When `input-latency-tracing' is non-nil,
+   the arrival time of the oldest keystroke or mouse click not yet
+   displayed is kept in input_latency_start, and note_input_latency
+   records the time elapsed since then at each later stage in a
+   histogram.  */
+
+static struct timespec input_latency_start;
+static bool input_latency_pending;
+
+static const char *const input_latency_stage_names[] =
+  { "read", "command", "redisplay", "update" };
+
+/* Buckets are exact below 16 microseconds.  Above, each power of 2
+   is split into 8 buckets, so the bucket bounds are within 12.5% of
+   the recorded values, as in an HDR histogram.  */
+enum { INPUT_LATENCY_MAX_EXPONENT = 34,
+       INPUT_LATENCY_BUCKETS = 16 + (INPUT_LATENCY_MAX_EXPONENT - 3) * 8 };
+
+static EMACS_INT input_latency_histogram
+  [INPUT_LATENCY_STAGES][INPUT_LATENCY_BUCKETS];
+
+static int
+input_latency_bucket (EMACS_INT usecs)
+{
+  int e;
+
+  if (usecs < 16)
+    return usecs < 0 ? 0 : usecs;
+  for (e = 4; e <= INPUT_LATENCY_MAX_EXPONENT && usecs >> (e + 1); e++)
+    ;
+  if (e > INPUT_LATENCY_MAX_EXPONENT)
+    return INPUT_LATENCY_BUCKETS - 1;
+  return 16 + (e - 4) * 8 + ((usecs >> (e - 3)) & 7);
+}
+
+/* Store in *LOW and *HIGH the range of microseconds of BUCKET.  */
+
+static void
+input_latency_bucket_range (int bucket, EMACS_INT *low, EMACS_INT *high)
+{
+  if (bucket < 16)
+    *low = *high = bucket;
+  else
+    {
+      int e = 4 + (bucket - 16) / 8;
+      *low = (EMACS_INT) (8 + (bucket - 16) % 8) << (e - 3);
+      *high = *low + ((EMACS_INT) 1 << (e - 3)) - 1;
+    }
+}
+
+/* Record that input event EVENT arrived now, unless earlier input is
+   still waiting to be displayed.  */
+
+static void
+note_input_arrival (struct input_event *event)
+{
+  if (input_latency_tracing && !input_latency_pending)
+    switch (event->kind)
+      {
+      case ASCII_KEYSTROKE_EVENT:
+      case MULTIBYTE_CHAR_KEYSTROKE_EVENT:
+      case NON_ASCII_KEYSTROKE_EVENT:
+      case MOUSE_CLICK_EVENT:
+      case WHEEL_EVENT:
+      case HORIZ_WHEEL_EVENT:
+	input_latency_start = current_timespec ();
+	input_latency_pending = 1;
+	break;
+      default:
+	break;
+      }
+}
+
+/* Record the time since the pending input arrived for STAGE.  The
+   last stage, INPUT_LATENCY_UPDATE, completes the measurement.  */
+
+void
+note_input_latency (enum input_latency_stage stage)
+{
+  if (input_latency_pending)
+    {
+      struct timespec elapsed
+	= timespec_sub (current_timespec (), input_latency_start);
+      EMACS_INT usecs = (elapsed.tv_sec * (EMACS_INT) 1000000
+			 + elapsed.tv_nsec / 1000);
+
+      input_latency_histogram[stage][input_latency_bucket (usecs)]++;
+      if (stage == INPUT_LATENCY_UPDATE)
+	input_latency_pending = 0;
+    }
+}
+
+static enum input_latency_stage
+check_input_latency_stage (Lisp_Object stage)
+{
+  int i;
+
+  CHECK_SYMBOL (stage);
+  for (i = 0; i < INPUT_LATENCY_STAGES; i++)
+    if (strcmp (SSDATA (SYMBOL_NAME (stage)),
+		input_latency_stage_names[i]) == 0)
+      return i;
+  xsignal2 (Qargs_out_of_range, stage,
+	    list4 (intern ("read"), intern ("command"),
+		   intern ("redisplay"), intern ("update")));
+}
+
+DEFUN ("input-latency-histogram", Finput_latency_histogram,
+       Sinput_latency_histogram, 1, 1, 0,
+       doc: /* Return the histogram of input latencies recorded for STAGE.
+STAGE is one of the symbols `read' (`read-char' returned the input),
+`command' (the command it invoked finished), `redisplay' (redisplay
+started) and `update' (the first frame was updated after it).
+Latencies are measured from the arrival of the input event, and are
+recorded only while `input-latency-tracing' is non-nil.
+Value is a list of elements (LOW HIGH COUNT), one for each non-empty
+bucket in increasing order, meaning that COUNT latencies were between
+LOW and HIGH microseconds, inclusive.  */)
+  (Lisp_Object stage)
+{
+  enum input_latency_stage s = check_input_latency_stage (stage);
+  Lisp_Object result = Qnil;
+  int i;
+
+  for (i = INPUT_LATENCY_BUCKETS - 1; i >= 0; i--)
+    if (input_latency_histogram[s][i])
+      {
+	EMACS_INT low, high;
+	input_latency_bucket_range (i, &low, &high);
+	result = Fcons (list3 (make_number (low), make_number (high),
+			       make_number (input_latency_histogram[s][i])),
+			result);
+      }
+  return result;
+}
+
+DEFUN ("input-latency-percentile", Finput_latency_percentile,
+       Sinput_latency_percentile, 2, 2, 0,
+       doc: /* Return the PERCENTILE input latency recorded for STAGE.
+STAGE is as for `input-latency-histogram'.  PERCENTILE is a number
+between 0 and 100.  Value is an upper bound, in microseconds, of the
+latency that PERCENTILE percent of the recorded latencies do not
+exceed, or nil if no latency has been recorded.  */)
+  (Lisp_Object stage, Lisp_Object percentile)
+{
+  enum input_latency_stage s = check_input_latency_stage (stage);
+  EMACS_INT total = 0, seen = 0;
+  double p;
+  int i;
+
+  CHECK_NUMBER_OR_FLOAT (percentile);
+  p = XFLOATINT (percentile);
+  if (! (0 <= p && p <= 100))
+    args_out_of_range (percentile, make_number (100));
+
+  for (i = 0; i < INPUT_LATENCY_BUCKETS; i++)
+    total += input_latency_histogram[s][i];
+  if (total == 0)
+    return Qnil;
+
+  for (i = 0; i < INPUT_LATENCY_BUCKETS; i++)
+    {
+      seen += input_latency_histogram[s][i];
+      if (seen > 0 && seen >= p / 100 * total)
+	break;
+    }
+  {
+    EMACS_INT low, high;
+    input_latency_bucket_range (min (i, INPUT_LATENCY_BUCKETS - 1),
+				&low, &high);
+    return make_number (high);
+  }
+}
+
+DEFUN ("input-latency-reset", Finput_latency_reset, Sinput_latency_reset,
+       0, 0, 0,
+       doc: /* Discard all input latencies recorded so far.  */)
+  (void)
+{
+  memset (input_latency_histogram, 0, sizeof input_latency_histogram);
+  input_latency_pending = 0;
+  return Qnil;
+}
+
 void
 kbd_buffer_store_event (register struct input_event *event)
 {
@@ -3626,6 +3846,14 @@ kbd_buffer_store_event_hold (register struct input_event *event,
 		      sp->arg = Qnil;
 		    }
 		}
+	      for (sp = kbd_overflow + kbd_overflow_head;
+		   sp < kbd_overflow + kbd_overflow_count; sp++)
+		if (event_to_kboard (sp) == kb)
+		  {
+		    sp->kind = NO_EVENT;
+		    sp->frame_or_window = Qnil;
+		    sp->arg = Qnil;
+		  }
 	      return;
 	    }
 
@@ -3662,10 +3890,12 @@ kbd_buffer_store_event_hold (register struct input_event *event,
   /* Don't insert two BUFFER_SWITCH_EVENT's in a row.
      Just ignore the second one.  */
   else if (event->kind == BUFFER_SWITCH_EVENT
-	   && kbd_fetch_ptr != kbd_store_ptr
-	   && ((kbd_store_ptr == kbd_buffer
-		? kbd_buffer + KBD_BUFFER_SIZE - 1
-		: kbd_store_ptr - 1)->kind) == BUFFER_SWITCH_EVENT)
+	   && (kbd_overflow_head < kbd_overflow_count
+	       ? kbd_overflow[kbd_overflow_count - 1].kind == BUFFER_SWITCH_EVENT
+	       : (kbd_fetch_ptr != kbd_store_ptr
+		  && ((kbd_store_ptr == kbd_buffer
+		       ? kbd_buffer + KBD_BUFFER_SIZE - 1
+		       : kbd_store_ptr - 1)->kind) == BUFFER_SWITCH_EVENT)))
     return;
 
   if (kbd_store_ptr - kbd_buffer == KBD_BUFFER_SIZE)
@@ -3674,8 +3904,29 @@ kbd_buffer_store_event_hold (register struct input_event *event,
   /* Don't let the very last slot in the buffer become full,
      since that would make the two pointers equal,
      and that is indistinguishable from an empty buffer.
-     Discard the event if it would fill the last slot.  */
-  if (kbd_fetch_ptr - 1 != kbd_store_ptr)
+     Queue the event in kbd_overflow instead, and keep queuing there
+     until kbd_buffer_refill has emptied it, to preserve the order.  */
+  if (kbd_overflow_head < kbd_overflow_count
+      || kbd_fetch_ptr - 1 == kbd_store_ptr
+      || (kbd_fetch_ptr == kbd_buffer
+	  && kbd_store_ptr == kbd_buffer + KBD_BUFFER_SIZE - 1))
+    {
+      if (kbd_overflow_count == kbd_overflow_size)
+	{
+	  if (kbd_overflow_head > 0)
+	    {
+	      kbd_overflow_count -= kbd_overflow_head;
+	      memmove (kbd_overflow, kbd_overflow + kbd_overflow_head,
+		       kbd_overflow_count * sizeof *kbd_overflow);
+	      kbd_overflow_head = 0;
+	    }
+	  else
+	    kbd_overflow = xpalloc (kbd_overflow, &kbd_overflow_size, 1, -1,
+				    sizeof *kbd_overflow);
+	}
+      kbd_overflow[kbd_overflow_count++] = *event;
+    }
+  else
     {
       *kbd_store_ptr = *event;
       ++kbd_store_ptr;
@@ -3692,6 +3943,8 @@ kbd_buffer_store_event_hold (register struct input_event *event,
 #endif	/* subprocesses */
     }
 
+  note_input_arrival (event);
+
   /* If we're inside while-no-input, and this event qualifies
      as input, set quit-flag to cause an interrupt.  */
   if (!NILP (Vthrow_on_input)
@@ -3780,6 +4033,8 @@ void
 discard_mouse_events (void)
 {
   struct input_event *sp;
+
+  kbd_buffer_refill ();
   for (sp = kbd_fetch_ptr; sp != kbd_store_ptr; sp++)
     {
       if (sp == kbd_buffer + KBD_BUFFER_SIZE)
@@ -3876,6 +4131,7 @@ kbd_buffer_get_event (KBOARD **kbp,
       if (CONSP (Vunread_command_events))
 	break;
 
+      kbd_buffer_refill ();
       if (kbd_fetch_ptr != kbd_store_ptr)
 	break;
       if (!NILP (do_mouse_tracking) && some_mouse_moved ())
@@ -4268,6 +4524,7 @@ process_special_events (void)
 {
   struct input_event *event;
 
+  kbd_buffer_refill ();
   for (event = kbd_fetch_ptr; event != kbd_store_ptr; ++event)
     {
       if (event == kbd_buffer + KBD_BUFFER_SIZE)
@@ -4354,6 +4611,8 @@ timer_start_idle (void)
   timer_idleness_start_time = current_timespec ();
   timer_last_idleness_start_time = timer_idleness_start_time;
 
+  maybe_compact_intervals ();
+
   /* Mark all idle-time timers as once again candidates for running.  */
   call0 (intern ("internal-timer-start-idle"));
 }
@@ -4563,6 +4822,66 @@ timer_check_2 (Lisp_Object timers, Lisp_Object idle_timers)
 }
 
 
+/* Return a copy of the timers in the sorted list TIMERS that are ripe
+   at time NOW, followed by the first proper timer that is not.  Since
+   timer_check_2 stops at that timer, it need not see the rest.  */
+
+static Lisp_Object
+timer_ripe_prefix (Lisp_Object timers, struct timespec now)
+{
+  Lisp_Object head = Qnil, tail = Qnil;
+
+  for (; CONSP (timers); timers = XCDR (timers))
+    {
+      Lisp_Object timer = XCAR (timers), cell = list1 (timer);
+      struct timespec timer_time;
+      bool proper = decode_timer (timer, &timer_time);
+
+      if (NILP (tail))
+	head = cell;
+      else
+	XSETCDR (tail, cell);
+      tail = cell;
+      if (proper && timespec_cmp (timer_time, now) > 0)
+	break;
+    }
+
+  return head;
+}
+
+DEFUN ("timer--insertion-point", Ftimer__insertion_point,
+       Stimer__insertion_point, 2, 2, 0,
+       doc: /* Return the cell of TIMERS after which to insert TIMER.
+TIMERS is a list of timers sorted by their time.  Value is the last
+cell whose timer is not later than TIMER, or nil if TIMER belongs at
+the front.  Elements whose time cannot be decoded are skipped.  */)
+  (Lisp_Object timer, Lisp_Object timers)
+{
+  struct timespec time, elt_time;
+  Lisp_Object last = Qnil;
+
+  if (! (VECTORP (timer) && ASIZE (timer) == 9
+	 && decode_time_components (AREF (timer, 1), AREF (timer, 2),
+				    AREF (timer, 3), AREF (timer, 8),
+				    &time, 0)))
+    wrong_type_argument (Qtimerp, timer);
+
+  for (; CONSP (timers); timers = XCDR (timers))
+    {
+      Lisp_Object elt = XCAR (timers);
+
+      if (VECTORP (elt) && ASIZE (elt) == 9
+	  && decode_time_components (AREF (elt, 1), AREF (elt, 2),
+				     AREF (elt, 3), AREF (elt, 8),
+				     &elt_time, 0)
+	  && timespec_cmp (time, elt_time) <= 0)
+	break;
+      last = timers;
+    }
+
+  return last;
+}
+
 /* Check whether a timer has fired.  To prevent larger problems we simply
    disregard elements that are not proper timers.  Do not make a circular
    timer list for the time being.
@@ -4575,7 +4894,7 @@ timer_check_2 (Lisp_Object timers, Lisp_Object idle_timers)
 struct timespec
 timer_check (void)
 {
-  struct timespec nexttime;
+  struct timespec nexttime, now;
   Lisp_Object timers, idle_timers;
   struct gcpro gcpro1, gcpro2;
 
@@ -4584,13 +4903,17 @@ timer_check (void)
 
   /* We use copies of the timers' lists to allow a timer to add itself
      again, without locking up Emacs if the newly added timer is
-     already ripe when added.  */
+     already ripe when added.  Since the lists are sorted, only their
+     ripe prefixes need to be copied.  */
 
   /* Always consider the ordinary timers.  */
-  timers = Fcopy_sequence (Vtimer_list);
+  now = current_timespec ();
+  timers = timer_ripe_prefix (Vtimer_list, now);
   /* Consider the idle timers only if Emacs is idle.  */
   if (timespec_valid_p (timer_idleness_start_time))
-    idle_timers = Fcopy_sequence (Vtimer_idle_list);
+    idle_timers = timer_ripe_prefix (Vtimer_idle_list,
+				     timespec_sub (now,
+						   timer_idleness_start_time));
   else
     idle_timers = Qnil;
 
@@ -7120,6 +7443,8 @@ process_pending_signals (void)
   pending_signals = 0;
   handle_async_input ();
   do_pending_atimers ();
+  profiler_record_pending ();
+  gc_update_elapsed ();
 }
 
 /* Undo any number of BLOCK_INPUT calls down to level LEVEL,
@@ -10145,10 +10470,74 @@ Also end any kbd macro being defined.  */)
   discard_tty_input ();
 
   kbd_fetch_ptr =  kbd_store_ptr;
+  while (kbd_overflow_head < kbd_overflow_count)
+    clear_event (&kbd_overflow[kbd_overflow_head++]);
+  kbd_overflow_head = kbd_overflow_count = 0;
   input_pending = 0;
 
   return Qnil;
 }
+
+DEFUN ("read-raw-input-until", Fread_raw_input_until,
+       Sread_raw_input_until, 1, 1, 0,
+       doc: /* Read bytes of terminal input until the string END has been read.
+Return a unibyte string of the bytes read, which ends with END unless
+reading stopped early.  The bytes are taken straight from the input
+queue, without decoding, translation or recording as keystrokes, so
+that a large paste can be read in one call.
+
+Reading stops early, leaving the next event to be read normally, when
+that event is not a byte typed on the selected terminal frame.  It
+also stops at once while a keyboard macro is being defined or
+executed, or when `unread-command-events' is non-nil.  */)
+  (Lisp_Object end)
+{
+  ptrdiff_t endlen, len = 0, size = 0;
+  char *buf = NULL;
+
+  CHECK_STRING (end);
+  endlen = SBYTES (end);
+
+  if (endlen == 0 || noninteractive
+      || !NILP (Vunread_command_events)
+      || !NILP (Vexecuting_kbd_macro)
+      || !NILP (KVAR (current_kboard, defining_kbd_macro)))
+    return empty_unibyte_string;
+
+  while (len < endlen || memcmp (buf + len - endlen, SDATA (end), endlen))
+    {
+      struct input_event *event;
+
+      kbd_buffer_refill ();
+      if (kbd_fetch_ptr == kbd_store_ptr)
+	{
+	  /* Wait for more input; the rest of a paste normally follows
+	     closely.  */
+	  wait_reading_process_output (0, 0, -1, 0, Qnil, NULL, 0);
+	  if (!interrupt_input && kbd_fetch_ptr == kbd_store_ptr)
+	    gobble_input ();
+	  QUIT;
+	  continue;
+	}
+
+      event = ((kbd_fetch_ptr < kbd_buffer + KBD_BUFFER_SIZE)
+	       ? kbd_fetch_ptr : kbd_buffer);
+      if (event->kind != ASCII_KEYSTROKE_EVENT
+	  || (event->modifiers & ~meta_modifier) != 0
+	  || event->code > 0xff
+	  || !EQ (event->frame_or_window, selected_frame))
+	break;
+
+      if (len == size)
+	buf = xpalloc (buf, &size, 1, -1, 1);
+      buf[len++] = (event->code
+		    | (event->modifiers & meta_modifier ? 0x80 : 0));
+      clear_event (event);
+      kbd_fetch_ptr = event + 1;
+    }
+
+  return make_unibyte_string (buf, len);
+}
 
 DEFUN ("suspend-emacs", Fsuspend_emacs, Ssuspend_emacs, 0, 1, "",
        doc: /* Stop Emacs and return to superior process.  You can resume later.
@@ -10235,16 +10624,21 @@ stuff_buffered_input (Lisp_Object stuffstring)
 
      rms: we should stuff everything back into the kboard
      it came from.  */
-  for (; kbd_fetch_ptr != kbd_store_ptr; kbd_fetch_ptr++)
+  do
     {
+      kbd_buffer_refill ();
+      for (; kbd_fetch_ptr != kbd_store_ptr; kbd_fetch_ptr++)
+	{
 
-      if (kbd_fetch_ptr == kbd_buffer + KBD_BUFFER_SIZE)
-	kbd_fetch_ptr = kbd_buffer;
-      if (kbd_fetch_ptr->kind == ASCII_KEYSTROKE_EVENT)
-	stuff_char (kbd_fetch_ptr->code);
+	  if (kbd_fetch_ptr == kbd_buffer + KBD_BUFFER_SIZE)
+	    kbd_fetch_ptr = kbd_buffer;
+	  if (kbd_fetch_ptr->kind == ASCII_KEYSTROKE_EVENT)
+	    stuff_char (kbd_fetch_ptr->code);
 
-      clear_event (kbd_fetch_ptr);
+	  clear_event (kbd_fetch_ptr);
+	}
     }
+  while (kbd_overflow_head < kbd_overflow_count);
 
   input_pending = 0;
 #endif /* SIGTSTP */
@@ -10971,6 +11365,7 @@ syms_of_keyboard (void)
   tool_bar_items_vector = Qnil;
 
   DEFSYM (Qtimer_event_handler, "timer-event-handler");
+  DEFSYM (Qtimerp, "timerp");
   DEFSYM (Qdisabled_command_function, "disabled-command-function");
   DEFSYM (Qself_insert_command, "self-insert-command");
   DEFSYM (Qforward_char, "forward-char");
@@ -11348,6 +11743,11 @@ Otherwise, menu prompting uses the echo area.  */);
 Type this character while in a menu prompt to rotate around the lines of it.  */);
   XSETINT (menu_prompt_more_char, ' ');
 
+  DEFVAR_BOOL ("input-latency-tracing", input_latency_tracing,
+	       doc: /* Non-nil means record the latency of keyboard and mouse input.
+See `input-latency-histogram'.  */);
+  input_latency_tracing = 0;
+
   DEFVAR_INT ("extra-keyboard-modifiers", extra_keyboard_modifiers,
 	      doc: /* A mask of additional modifier keys to use with every keyboard character.
 Emacs applies the modifiers of the character stored here to each keyboard
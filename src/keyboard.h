@@ -463,6 +463,17 @@ extern void stuff_buffered_input (Lisp_Object);
 extern void clear_waiting_for_input (void);
 extern void swallow_events (bool);
 extern bool lucid_event_type_list_p (Lisp_Object);
+/* Stages of the handling of an input event at which its latency is
+   recorded; see note_input_latency.  */
+enum input_latency_stage
+  {
+    INPUT_LATENCY_READ,
+    INPUT_LATENCY_COMMAND,
+    INPUT_LATENCY_REDISPLAY,
+    INPUT_LATENCY_UPDATE,
+    INPUT_LATENCY_STAGES
+  };
+extern void note_input_latency (enum input_latency_stage);
 extern void kbd_buffer_store_event (struct input_event *);
 extern void kbd_buffer_store_event_hold (struct input_event *,
                                          struct input_event *);
@@ -88,12 +88,64 @@ static Lisp_Object exclude_keys;
 /* Pre-allocated 2-element vector for Fcommand_remapping to use.  */
 static Lisp_Object command_remapping_vector;
 
-/* Hash table used to cache a reverse-map to speed up calls to where-is.  */
+/* Calls to where-is without menus use reverse-maps, each a hash table
+   from a definition to the key sequences bound to it in one keymap.
+   A reverse-map is kept for each of the last few keymaps asked about,
+   along with the keymaps it was built from: the keymap, its prefix
+   keymaps and all their parents.  A change made through `define-key'
+   or `set-keymap-parent' discards only the reverse-maps built from the
+   keymap changed, so that defining a key in a mode's keymap does not
+   throw away the reverse-map of the global map.  */
+
+#define WHERE_IS_INDEX_SIZE 16
+
+enum
+  {
+    WHERE_IS_INDEX_KEYMAP,
+    WHERE_IS_INDEX_TABLE,
+    WHERE_IS_INDEX_DEPS,
+    WHERE_IS_INDEX_ENTRY_SIZE
+  };
+
+/* List of reverse-maps, each [KEYMAP TABLE DEPS], most recently used
+   first.  DEPS is a hash table whose keys are the keymaps TABLE was
+   built from.  */
+static Lisp_Object where_is_index;
+
+/* The reverse-map being filled, or nil.  */
 static Lisp_Object where_is_cache;
-/* Which keymaps are reverse-stored in the cache.  */
-static Lisp_Object where_is_cache_keymaps;
+
+/* Lookups in a long run of (EVENT . DEFINITION) bindings use an
+   index of the run, a hash table from each EVENT to its binding.
+   The indexes are kept in a small cache keyed by the first cons of
+   the run.  They are all invalidated by any change made through
+   `define-key' or `set-keymap-parent'; bindings
+   found through an index are the original conses, so changing their
+   definitions in place is seen as well.  */
+
+/* Runs shorter than this are just scanned.  */
+#define KEYMAP_INDEX_MIN 32
+
+#define KEYMAP_INDEX_CACHE_SIZE 256
+
+enum
+  {
+    KEYMAP_INDEX_START,
+    KEYMAP_INDEX_END,
+    KEYMAP_INDEX_TABLE,
+    KEYMAP_INDEX_TICK,
+    KEYMAP_INDEX_SIZE
+  };
+
+/* Vector of cached indexes, each nil or [START END TABLE TICK].  TABLE
+   is nil if the run starting at START cannot be indexed.  */
+static Lisp_Object keymap_index_cache;
+
+/* Incremented whenever the cached indexes become invalid.  */
+static EMACS_INT keymap_index_tick;
 
 static Lisp_Object store_in_keymap (Lisp_Object, Lisp_Object, Lisp_Object);
+static void where_is_index_flush (Lisp_Object);
 
 static Lisp_Object define_as_prefix (Lisp_Object, Lisp_Object);
 static void describe_command (Lisp_Object, Lisp_Object);
@@ -330,12 +382,14 @@ Return PARENT.  PARENT should be nil or another keymap.  */)
   Lisp_Object list, prev;
   struct gcpro gcpro1, gcpro2;
 
-  /* Flush any reverse-map cache.  */
-  where_is_cache = Qnil; where_is_cache_keymaps = Qt;
+  keymap_index_tick++;
 
   GCPRO2 (keymap, parent);
   keymap = get_keymap (keymap, 1, 1);
 
+  /* Flush the reverse-maps that KEYMAP's bindings went into.  */
+  where_is_index_flush (keymap);
+
   if (!NILP (parent))
     {
       parent = get_keymap (parent, 1, 0);
@@ -363,6 +417,87 @@ Return PARENT.  PARENT should be nil or another keymap.  */)
 }
 
 
+/* Return an index of the run of bindings starting at START, setting
+   *END to its last cons.  Return nil if the run is too short, or if
+   it does not extend to the end of the keymap or to its parent, or
+   if it has a default binding or two bindings for the same event;
+   the index would then not give the same answers as a scan.  */
+
+static Lisp_Object
+keymap_index_build (Lisp_Object start, Lisp_Object *end)
+{
+  Lisp_Object tail, table;
+  struct Lisp_Hash_Table *h;
+  EMACS_INT n = 0;
+
+  *end = start;
+  for (tail = start; CONSP (tail); tail = XCDR (tail))
+    {
+      Lisp_Object binding = XCAR (tail);
+
+      if (EQ (binding, Qkeymap))
+	break;
+      if (!CONSP (binding) || EQ (XCAR (binding), Qkeymap)
+	  || EQ (XCAR (binding), Qt))
+	return Qnil;
+      *end = tail;
+      n++;
+    }
+  if (n < KEYMAP_INDEX_MIN)
+    return Qnil;
+
+  table = make_hash_table (hashtest_eql, make_number (n),
+			   make_float (DEFAULT_REHASH_SIZE),
+			   make_float (DEFAULT_REHASH_THRESHOLD),
+			   Qnil);
+  h = XHASH_TABLE (table);
+  for (tail = start; ; tail = XCDR (tail))
+    {
+      EMACS_UINT hash;
+
+      if (hash_lookup (h, XCAR (XCAR (tail)), &hash) >= 0)
+	return Qnil;
+      hash_put (h, XCAR (XCAR (tail)), XCAR (tail), hash);
+      if (EQ (tail, *end))
+	return table;
+    }
+}
+
+/* TAIL is a tail of a keymap, starting with a run of (EVENT . DEF)
+   bindings.  If the run has an index, set *END to the last cons of
+   the run and return the binding of IDX in it, or nil if it has
+   none.  Otherwise, return Qunbound.  */
+
+static Lisp_Object
+keymap_index_lookup (Lisp_Object tail, Lisp_Object idx, Lisp_Object *end)
+{
+  ptrdiff_t slot = scm_ihashq (tail, KEYMAP_INDEX_CACHE_SIZE);
+  Lisp_Object entry = AREF (keymap_index_cache, slot);
+  struct Lisp_Hash_Table *h;
+  ptrdiff_t i;
+
+  if (!VECTORP (entry)
+      || !EQ (AREF (entry, KEYMAP_INDEX_START), tail)
+      || XINT (AREF (entry, KEYMAP_INDEX_TICK)) != keymap_index_tick)
+    {
+      Lisp_Object run_end, table = keymap_index_build (tail, &run_end);
+
+      entry = make_uninit_vector (KEYMAP_INDEX_SIZE);
+      ASET (entry, KEYMAP_INDEX_START, tail);
+      ASET (entry, KEYMAP_INDEX_END, run_end);
+      ASET (entry, KEYMAP_INDEX_TABLE, table);
+      ASET (entry, KEYMAP_INDEX_TICK, make_number (keymap_index_tick));
+      ASET (keymap_index_cache, slot, entry);
+    }
+
+  if (NILP (AREF (entry, KEYMAP_INDEX_TABLE)))
+    return Qunbound;
+  *end = AREF (entry, KEYMAP_INDEX_END);
+  h = XHASH_TABLE (AREF (entry, KEYMAP_INDEX_TABLE));
+  i = hash_lookup (h, idx, NULL);
+  return i < 0 ? Qnil : HASH_VALUE (h, i);
+}
+
 /* Look up IDX in MAP.  IDX may be any sort of event.
    Note that this does only one level of lookup; IDX must be a single
    event, not a sequence.
@@ -435,6 +570,9 @@ access_keymap_1 (Lisp_Object map, Lisp_Object idx,
     Lisp_Object t_binding = Qunbound;
     Lisp_Object retval = Qunbound;
     Lisp_Object retval_tail = Qnil;
+    /* The last cons of an indexed run that we have looked up.  */
+    Lisp_Object run_end = Qnil;
+    bool index_tried = false;
     struct gcpro gcpro1, gcpro2, gcpro3, gcpro4;
 
     GCPRO4 (tail, idx, t_binding, retval);
@@ -449,6 +587,16 @@ access_keymap_1 (Lisp_Object map, Lisp_Object idx,
 	Lisp_Object binding = XCAR (tail);
 	Lisp_Object submap = get_keymap (binding, 0, autoload);
 
+	/* At the first run of bindings, consult its index, and then
+	   skip the rest of the run.  */
+	if (!index_tried && CONSP (binding) && !CONSP (submap))
+	  {
+	    Lisp_Object indexed = keymap_index_lookup (tail, idx, &run_end);
+	    index_tried = true;
+	    if (!EQ (indexed, Qunbound))
+	      binding = indexed;
+	  }
+
 	if (EQ (binding, Qkeymap))
 	  {
 	    if (noinherit || NILP (retval))
@@ -543,6 +691,11 @@ access_keymap_1 (Lisp_Object map, Lisp_Object idx,
 		retval = Fcons (Qkeymap, Fcons (retval, retval_tail));
 	      }
 	  }
+	if (CONSP (run_end))
+	  {
+	    tail = run_end;
+	    run_end = Qnil;
+	  }
 	QUIT;
       }
     UNGCPRO;
@@ -795,9 +948,9 @@ get_keyelt (Lisp_Object object, bool autoload)
 static Lisp_Object
 store_in_keymap (Lisp_Object keymap, register Lisp_Object idx, Lisp_Object def)
 {
-  /* Flush any reverse-map cache.  */
-  where_is_cache = Qnil;
-  where_is_cache_keymaps = Qt;
+  /* Flush the reverse-maps that KEYMAP's bindings went into.  */
+  where_is_index_flush (keymap);
+  keymap_index_tick++;
 
   if (EQ (idx, Qkeymap))
     error ("`keymap' is reserved for embedded parent maps");
@@ -2455,54 +2608,16 @@ struct where_is_internal_data {
   Lisp_Object sequences;
 };
 
-/* This function can't GC, AFAIK.  */
-/* Return the list of bindings found.  This list is ordered "longest
-   to shortest".  It may include bindings that are actually shadowed
-   by others, as well as duplicate bindings and remapping bindings.
-   The list returned is potentially shared with where_is_cache, so
-   be careful not to modify it via side-effects.  */
+/* Look for DEFINITION in MAPS, a list of (PREFIX . KEYMAP) as made by
+   `accessible-keymaps'.  Return the key sequences found, or nil while
+   filling where_is_cache, in which case all the bindings go there.  */
 
 static Lisp_Object
-where_is_internal (Lisp_Object definition, Lisp_Object keymaps,
-		   bool noindirect, bool nomenus)
+where_is_scan (Lisp_Object definition, Lisp_Object maps,
+	       bool noindirect, bool nomenus)
 {
-  Lisp_Object maps = Qnil;
-  Lisp_Object found;
   struct where_is_internal_data data;
 
-  /* Only important use of caching is for the menubar
-     (i.e. where-is-internal called with (def nil t nil nil)).  */
-  if (nomenus && !noindirect)
-    {
-      /* Check heuristic-consistency of the cache.  */
-      if (NILP (Fequal (keymaps, where_is_cache_keymaps)))
-	where_is_cache = Qnil;
-
-      if (NILP (where_is_cache))
-	{
-	  /* We need to create the cache.  */
-	  Lisp_Object args[2];
-	  where_is_cache = Fmake_hash_table (0, args);
-	  where_is_cache_keymaps = Qt;
-	}
-      else
-	/* We can reuse the cache.  */
-	return Fgethash (definition, where_is_cache, Qnil);
-    }
-  else
-    /* Kill the cache so that where_is_internal_1 doesn't think
-       we're filling it up.  */
-    where_is_cache = Qnil;
-
-  found = keymaps;
-  while (CONSP (found))
-    {
-      maps =
-	nconc2 (maps,
-		Faccessible_keymaps (get_keymap (XCAR (found), 1, 0), Qnil));
-      found = XCDR (found);
-    }
-
   data.sequences = Qnil;
   for (; CONSP (maps); maps = XCDR (maps))
     {
@@ -2542,17 +2657,140 @@ where_is_internal (Lisp_Object definition, Lisp_Object keymaps,
 	map_keymap (map, where_is_internal_1, Qnil, &data, 0);
     }
 
+  return data.sequences;
+}
+
+/* Discard the reverse-maps built from KEYMAP.  */
+
+static void
+where_is_index_flush (Lisp_Object keymap)
+{
+  Lisp_Object tail, prev = Qnil;
+
+  for (tail = where_is_index; CONSP (tail); tail = XCDR (tail))
+    {
+      Lisp_Object deps = AREF (XCAR (tail), WHERE_IS_INDEX_DEPS);
+      if (hash_lookup (XHASH_TABLE (deps), keymap, NULL) >= 0)
+	{
+	  if (NILP (prev))
+	    where_is_index = XCDR (tail);
+	  else
+	    XSETCDR (prev, XCDR (tail));
+	}
+      else
+	prev = tail;
+    }
+}
+
+/* Return the reverse-map of KEYMAP, building it if needed.  */
+
+static Lisp_Object
+where_is_index_table (Lisp_Object keymap)
+{
+  Lisp_Object tail, prev = Qnil, entry, maps, table, deps;
+  struct Lisp_Hash_Table *h;
+  EMACS_INT count = 0;
+
+  for (tail = where_is_index; CONSP (tail); prev = tail, tail = XCDR (tail))
+    {
+      entry = XCAR (tail);
+      if (EQ (AREF (entry, WHERE_IS_INDEX_KEYMAP), keymap))
+	{
+	  /* Move it to the front.  */
+	  if (!NILP (prev))
+	    {
+	      XSETCDR (prev, XCDR (tail));
+	      where_is_index = Fcons (entry, where_is_index);
+	    }
+	  return AREF (entry, WHERE_IS_INDEX_TABLE);
+	}
+      /* Make room for the new entry by dropping the oldest.  */
+      if (++count >= WHERE_IS_INDEX_SIZE && CONSP (XCDR (tail)))
+	{
+	  entry = XCAR (XCDR (tail));
+	  if (EQ (AREF (entry, WHERE_IS_INDEX_KEYMAP), keymap))
+	    return AREF (entry, WHERE_IS_INDEX_TABLE);
+	  XSETCDR (tail, Qnil);
+	}
+    }
+
+  maps = Faccessible_keymaps (keymap, Qnil);
+
+  deps = make_hash_table (hashtest_eql, make_number (DEFAULT_HASH_SIZE),
+			  make_float (DEFAULT_REHASH_SIZE),
+			  make_float (DEFAULT_REHASH_THRESHOLD), Qnil);
+  h = XHASH_TABLE (deps);
+  for (tail = maps; CONSP (tail); tail = XCDR (tail))
+    {
+      Lisp_Object map = Fcdr (XCAR (tail));
+      EMACS_UINT hash;
+
+      for (; CONSP (map); map = keymap_parent (map, 0))
+	{
+	  if (hash_lookup (h, map, &hash) >= 0)
+	    break;
+	  hash_put (h, map, Qt, hash);
+	}
+    }
+
+  table = make_hash_table (hashtest_eql, make_number (DEFAULT_HASH_SIZE),
+			   make_float (DEFAULT_REHASH_SIZE),
+			   make_float (DEFAULT_REHASH_THRESHOLD), Qnil);
+  where_is_cache = table;
+  where_is_scan (Qnil, maps, 0, 1);
+  where_is_cache = Qnil;
+
+  entry = Fmake_vector (make_number (WHERE_IS_INDEX_ENTRY_SIZE), Qnil);
+  ASET (entry, WHERE_IS_INDEX_KEYMAP, keymap);
+  ASET (entry, WHERE_IS_INDEX_TABLE, table);
+  ASET (entry, WHERE_IS_INDEX_DEPS, deps);
+  where_is_index = Fcons (entry, where_is_index);
+  return table;
+}
+
+/* Return the list of bindings found.  This list is ordered "longest
+   to shortest".  It may include bindings that are actually shadowed
+   by others, as well as duplicate bindings and remapping bindings.  */
+
+static Lisp_Object
+where_is_internal (Lisp_Object definition, Lisp_Object keymaps,
+		   bool noindirect, bool nomenus)
+{
+  Lisp_Object maps = Qnil;
+  Lisp_Object found;
+
+  /* A quit while filling a reverse-map may have left it set.  */
+  where_is_cache = Qnil;
+
+  /* Only important use of caching is for the menubar
+     (i.e. where-is-internal called with (def nil t nil nil)).  */
   if (nomenus && !noindirect)
-    { /* Remember for which keymaps this cache was built.
-	 We do it here (late) because we want to keep where_is_cache_keymaps
-	 set to t while the cache isn't fully filled.  */
-      where_is_cache_keymaps = keymaps;
-      /* During cache-filling, data.sequences is not filled by
-	 where_is_internal_1.  */
-      return Fgethash (definition, where_is_cache, Qnil);
+    {
+      /* The keymaps are searched in order, and the sequences found
+	 are pushed on the front of the list.  */
+      Lisp_Object sequences = Qnil;
+
+      for (found = keymaps; CONSP (found); found = XCDR (found))
+	{
+	  Lisp_Object table
+	    = where_is_index_table (get_keymap (XCAR (found), 1, 0));
+	  sequences = nconc2 (Fcopy_sequence (Fgethash (definition, table,
+							 Qnil)),
+			      sequences);
+	}
+      return sequences;
     }
-  else
-    return data.sequences;
+
+  found = keymaps;
+  while (CONSP (found))
+    {
+      maps =
+	nconc2 (maps,
+		Faccessible_keymaps (get_keymap (XCAR (found), 1, 0), Qnil));
+      found = XCDR (found);
+    }
+
+  return where_is_scan (definition, maps, noindirect, nomenus);
 }
 
 /* This function can GC if Flookup_key autoloads any keymaps.  */
@@ -3794,10 +4032,14 @@ be preferred.  */);
   command_remapping_vector = Fmake_vector (make_number (2), Qremap);
   staticpro (&command_remapping_vector);
 
-  where_is_cache_keymaps = Qt;
+  where_is_index = Qnil;
+  staticpro (&where_is_index);
   where_is_cache = Qnil;
   staticpro (&where_is_cache);
-  staticpro (&where_is_cache_keymaps);
+
+  keymap_index_cache = Fmake_vector (make_number (KEYMAP_INDEX_CACHE_SIZE),
+				     Qnil);
+  staticpro (&keymap_index_cache);
 }
 
 void
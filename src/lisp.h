@@ -31,6 +31,7 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <intprops.h>
 #include <verify.h>
 #include <libguile.h>
+#include <gc.h>
 
 INLINE_HEADER_BEGIN
 
@@ -300,11 +301,11 @@ DEFINE_GDB_SYMBOL_END (USE_LSB_TAG)
 #define lisp_h_NILP(x) (scm_is_lisp_false (x))
 #define lisp_h_SET_SYMBOL_VAL(sym, v) \
    (eassert (SYMBOL_REDIRECT (sym) == SYMBOL_PLAINVAL), \
-      scm_c_vector_set_x (sym, 4, v))
+      set_symbol_slot (sym, SYMBOL_SLOT_VALUE, v))
 #define lisp_h_SYMBOL_CONSTANT_P(sym) (SYMBOL_CONSTANT (XSYMBOL (sym)))
 #define lisp_h_SYMBOL_VAL(sym) \
    (eassert (SYMBOL_REDIRECT (sym) == SYMBOL_PLAINVAL), \
-    scm_c_vector_ref (sym, 4))
+    symbol_slot (sym, SYMBOL_SLOT_VALUE))
 #define lisp_h_SYMBOLP(x) \
   (x && (scm_is_symbol (x) || EQ (x, Qnil) || EQ (x, Qt)))
 #define lisp_h_VECTORLIKEP(x) (SMOB_TYPEP (x, lisp_vectorlike_tag))
@@ -442,6 +443,8 @@ enum pvec_type
   PVEC_HASH_TABLE,
   PVEC_TERMINAL,
   PVEC_WINDOW_CONFIGURATION,
+  PVEC_STRING_BUILDER,
+  PVEC_ZLIB_STREAM,
   PVEC_OTHER,
   /* These should be last, check internal_equal to see why.  */
   PVEC_COMPILED,
@@ -586,6 +589,9 @@ extern Lisp_Object Qvector_or_char_table_p, Qwholenump;
 extern Lisp_Object Qwindow;
 extern _Noreturn Lisp_Object wrong_type_argument (Lisp_Object, Lisp_Object);
 
+/* Defined in fns.c.  */
+extern Lisp_Object Qstring_builder_p;
+
 /* Defined in emacs.c.  */
 extern bool might_dump;
 /* True means Emacs has already been initialized.
@@ -710,7 +716,7 @@ XBOOL_VECTOR (Lisp_Object a)
 #define XSETFASTINT(a, b) ((a) = make_natnum (b))
 #define XSETVECTOR(a, b) ((a) = (b)->header.self)
 #define XSETSTRING(a, b) ((a) = (b)->self)
-#define XSETSYMBOL(a, b) ((a) = scm_c_vector_ref (b, 0))
+#define XSETSYMBOL(a, b) ((a) = symbol_slot (b, SYMBOL_SLOT_SELF))
 #define XSETMISC(a, b) (a) = ((union Lisp_Misc *) (b))->u_any.self
 #define make_lisp_proc(p) ((p)->header.self)
 
@@ -768,11 +774,30 @@ struct Lisp_String
     ptrdiff_t size_byte;
     INTERVAL intervals;		/* Text properties in this string.  */
     unsigned char *data;
+
+    /* A Guile string with the same text, kept by `string-to-scheme' and
+       `string-from-scheme' so that crossing to Scheme does not convert
+       the text again, or 0.  It is cleared when the text changes.  */
+    Lisp_Object scheme;
   };
 
 LISP_MACRO_DEFUN (XCAR, Lisp_Object, (Lisp_Object c), (c))
 LISP_MACRO_DEFUN (XCDR, Lisp_Object, (Lisp_Object c), (c))
 
+/* True once the collector runs incrementally; see `gc-max-pause'.  */
+extern bool gc_incremental;
+
+/* Tell the collector that the heap object starting at P has been
+   modified.  Collectors that track dirty pages with page protection
+   ignore this, but one built with manual dirty bits needs it after
+   every pointer store into an object it may already have marked.  */
+INLINE void
+gc_write_barrier (const void *p)
+{
+  if (gc_incremental)
+    GC_end_stubborn_change (p);
+}
+
 /* Use these to set the fields of a cons cell.
 
    Note that both arguments may refer to the same object, so 'n'
@@ -781,11 +806,13 @@ INLINE void
 XSETCAR (Lisp_Object c, Lisp_Object n)
 {
   scm_set_car_x (c, n);
+  gc_write_barrier (SCM2PTR (c));
 }
 INLINE void
 XSETCDR (Lisp_Object c, Lisp_Object n)
 {
   scm_set_cdr_x (c, n);
+  gc_write_barrier (SCM2PTR (c));
 }
 
 /* Take the car or cdr of something whose type is not known.  */
@@ -878,10 +905,17 @@ SREF (Lisp_Object string, ptrdiff_t index)
 {
   return SDATA (string)[index];
 }
+/* Forget the Guile copy of the text of STRING, which is changing.  */
+INLINE void
+string_text_changed (Lisp_Object string)
+{
+  XSTRING (string)->scheme = 0;
+}
 INLINE void
 SSET (Lisp_Object string, ptrdiff_t index, unsigned char new)
 {
   SDATA (string)[index] = new;
+  string_text_changed (string);
 }
 INLINE ptrdiff_t
 SCHARS (Lisp_Object string)
@@ -904,6 +938,7 @@ INLINE void
 STRING_SET_CHARS (Lisp_Object string, ptrdiff_t newsize)
 {
   XSTRING (string)->size = newsize;
+  string_text_changed (string);
 }
 
 /* Header of vector-like objects.  This documents the layout constraints on
@@ -1072,6 +1107,7 @@ ASET (Lisp_Object array, ptrdiff_t idx, Lisp_Object val)
 {
   eassert (0 <= idx && idx < ASIZE (array));
   XVECTOR (array)->contents[idx] = val;
+  gc_write_barrier (XVECTOR (array));
 }
 
 INLINE void
@@ -1081,6 +1117,7 @@ gc_aset (Lisp_Object array, ptrdiff_t idx, Lisp_Object val)
      sweep_weak_table calls set_hash_key etc. while the table is marked.  */
   eassert (0 <= idx && idx < (ASIZE (array)));
   XVECTOR (array)->contents[idx] = val;
+  gc_write_barrier (XVECTOR (array));
 }
 
 /* If a struct is made to look like a vector, this macro returns the length
@@ -1129,6 +1166,11 @@ enum CHARTAB_SIZE_BITS
 
 extern const int chartab_size[4];
 
+/* Incremented whenever any slot of any char-table or sub-char-table
+   is set, so that flattened copies of a table can tell they are
+   stale.  */
+extern EMACS_INT char_table_modiff;
+
 struct Lisp_Char_Table
   {
     /* HEADER.SIZE is the vector's size field, which also holds the
@@ -1280,14 +1322,50 @@ struct Lisp_Symbol
   };
 };
 
-#define SYMBOL_SELF(sym) (scm_c_vector_ref (sym, 0))
-#define SET_SYMBOL_SELF(sym, v) (scm_c_vector_set_x (sym, 0, v))
-#define SYMBOL_REDIRECT(sym) (XINT (scm_c_vector_ref (sym, 1)))
-#define SET_SYMBOL_REDIRECT(sym, v) (scm_c_vector_set_x (sym, 1, make_number (v)))
-#define SYMBOL_CONSTANT(sym) (XINT (scm_c_vector_ref (sym, 2)))
-#define SET_SYMBOL_CONSTANT(sym, v) (scm_c_vector_set_x (sym, 2, make_number (v)))
-#define SYMBOL_DECLARED_SPECIAL(sym) (XINT (scm_c_vector_ref (sym, 3)))
-#define SET_SYMBOL_DECLARED_SPECIAL(sym, v) (scm_c_vector_set_x (sym, 3, make_number (v)))
+/* The fields of struct Lisp_Symbol live in the slots of the symbol
+   descriptor, a vector made by the Elisp runtime of Guile, whose
+   compiled code uses the same slots.  They are accessed directly,
+   without the calls and bounds checks of scm_c_vector_ref; the
+   runtime never makes descriptors of fewer than SYMBOL_SLOTS slots.  */
+
+enum symbol_slot
+{
+  SYMBOL_SLOT_SELF,
+  SYMBOL_SLOT_REDIRECT,
+  SYMBOL_SLOT_CONSTANT,
+  SYMBOL_SLOT_DECLARED_SPECIAL,
+  SYMBOL_SLOT_VALUE,
+  SYMBOL_SLOTS
+};
+
+INLINE Lisp_Object
+symbol_slot (sym_t sym, enum symbol_slot slot)
+{
+  eassert (scm_is_simple_vector (sym)
+	   && SCM_SIMPLE_VECTOR_LENGTH (sym) >= SYMBOL_SLOTS);
+  return SCM_SIMPLE_VECTOR_REF (sym, slot);
+}
+
+INLINE void
+set_symbol_slot (sym_t sym, enum symbol_slot slot, Lisp_Object v)
+{
+  eassert (scm_is_simple_vector (sym)
+	   && SCM_SIMPLE_VECTOR_LENGTH (sym) >= SYMBOL_SLOTS);
+  SCM_SIMPLE_VECTOR_SET (sym, slot, v);
+}
+
+#define SYMBOL_SELF(sym) (symbol_slot (sym, SYMBOL_SLOT_SELF))
+#define SET_SYMBOL_SELF(sym, v) (set_symbol_slot (sym, SYMBOL_SLOT_SELF, v))
+#define SYMBOL_REDIRECT(sym) (XINT (symbol_slot (sym, SYMBOL_SLOT_REDIRECT)))
+#define SET_SYMBOL_REDIRECT(sym, v) \
+  (set_symbol_slot (sym, SYMBOL_SLOT_REDIRECT, make_number (v)))
+#define SYMBOL_CONSTANT(sym) (XINT (symbol_slot (sym, SYMBOL_SLOT_CONSTANT)))
+#define SET_SYMBOL_CONSTANT(sym, v) \
+  (set_symbol_slot (sym, SYMBOL_SLOT_CONSTANT, make_number (v)))
+#define SYMBOL_DECLARED_SPECIAL(sym) \
+  (XINT (symbol_slot (sym, SYMBOL_SLOT_DECLARED_SPECIAL)))
+#define SET_SYMBOL_DECLARED_SPECIAL(sym, v) \
+  (set_symbol_slot (sym, SYMBOL_SLOT_DECLARED_SPECIAL, make_number (v)))
 
 /* Value is name of symbol.  */
 
@@ -1295,19 +1373,19 @@ INLINE sym_t
 SYMBOL_ALIAS (sym_t sym)
 {
   eassert (SYMBOL_REDIRECT (sym) == SYMBOL_VARALIAS);
-  return scm_c_vector_ref (sym, 4);
+  return symbol_slot (sym, SYMBOL_SLOT_VALUE);
 }
 INLINE struct Lisp_Buffer_Local_Value *
 SYMBOL_BLV (sym_t sym)
 {
   eassert (SYMBOL_REDIRECT (sym) == SYMBOL_LOCALIZED);
-  return scm_to_pointer (scm_c_vector_ref (sym, 4));
+  return scm_to_pointer (symbol_slot (sym, SYMBOL_SLOT_VALUE));
 }
 INLINE union Lisp_Fwd *
 SYMBOL_FWD (sym_t sym)
 {
   eassert (SYMBOL_REDIRECT (sym) == SYMBOL_FORWARDED);
-  return scm_to_pointer (scm_c_vector_ref (sym, 4));
+  return scm_to_pointer (symbol_slot (sym, SYMBOL_SLOT_VALUE));
 }
 
 LISP_MACRO_DEFUN_VOID (SET_SYMBOL_VAL,
@@ -1317,25 +1395,38 @@ INLINE void
 SET_SYMBOL_ALIAS (sym_t sym, sym_t v)
 {
   eassert (SYMBOL_REDIRECT (sym) == SYMBOL_VARALIAS);
-  scm_c_vector_set_x (sym, 4, v);
+  set_symbol_slot (sym, SYMBOL_SLOT_VALUE, v);
 }
 INLINE void
 SET_SYMBOL_BLV (sym_t sym, struct Lisp_Buffer_Local_Value *v)
 {
   eassert (SYMBOL_REDIRECT (sym) == SYMBOL_LOCALIZED);
-  scm_c_vector_set_x (sym, 4, scm_from_pointer (v, NULL));
+  set_symbol_slot (sym, SYMBOL_SLOT_VALUE, scm_from_pointer (v, NULL));
 }
 INLINE void
 SET_SYMBOL_FWD (sym_t sym, union Lisp_Fwd *v)
 {
   eassert (SYMBOL_REDIRECT (sym) == SYMBOL_FORWARDED);
-  scm_c_vector_set_x (sym, 4, scm_from_pointer (v, NULL));
+  set_symbol_slot (sym, SYMBOL_SLOT_VALUE, scm_from_pointer (v, NULL));
 }
 
+/* Procedures of the Elisp runtime used to access symbols, resolved
+   once at startup.  Defined in emacs.c.  */
+
+extern Lisp_Object xsymbol_fn;
+extern Lisp_Object symbol_function_fn;
+extern Lisp_Object set_symbol_function_fn;
+extern Lisp_Object symbol_name_fn;
+extern Lisp_Object symbol_plist_fn;
+extern Lisp_Object set_symbol_plist_fn;
+
+extern Lisp_Object Fstring_from_scheme (Lisp_Object);
+extern Lisp_Object symbol_name_string (Lisp_Object);
+
 INLINE Lisp_Object
 SYMBOL_NAME (Lisp_Object sym)
 {
-  return build_string (scm_to_locale_string (scm_call_1 (scm_c_public_ref ("language elisp runtime", "symbol-name"), sym)));
+  return symbol_name_string (sym);
 }
 
 /* Value is true if SYM is an interned symbol.  */
@@ -1418,19 +1509,14 @@ struct Lisp_Hash_Table
      I-th entry is unused.  */
   Lisp_Object hash;
 
-  /* Vector used to chain entries.  If entry I is free, next[I] is the
-     entry number of the next free item.  If entry I is non-free,
-     next[I] is the index of the next entry in the collision chain.  */
+  /* Vector used to chain free entries.  If entry I is free, next[I] is
+     the entry number of the next free item.  Its length is the size of
+     the table.  */
   Lisp_Object next;
 
   /* Index of first free entry in free list.  */
   Lisp_Object next_free;
 
-  /* Bucket vector.  A non-nil entry is the index of the first item in
-     a collision chain.  This vector's size can be larger than the
-     hash table size to reduce collisions.  */
-  Lisp_Object index;
-
   /* Only the fields above are traced normally by the GC.  The ones below
      `count' are special and are either ignored by the GC or traced in
      a special way (e.g. because of weakness).  */
@@ -1438,6 +1524,32 @@ struct Lisp_Hash_Table
   /* Number of key/value entries in the table.  */
   ptrdiff_t count;
 
+  /* Open-addressing index of 1 << PROBE_BITS slots, at least twice the
+     table size.  A nonzero slot holds 1 + the number of an entry whose
+     hash code maps to that slot or one probed linearly before it; zero
+     marks an empty slot.  Allocated with xzalloc_atomic.  */
+  ptrdiff_t *probe;
+  int probe_bits;
+
+  /* The probe index from before the last resize, or null.  Its slots
+     below MIGRATE_POS have been copied into PROBE; the rest are
+     copied MIGRATE_STEP at a time by later insertions and removals.
+     A negative slot is an entry removed before it was copied.  */
+  ptrdiff_t *old_probe;
+  int old_probe_bits;
+  ptrdiff_t migrate_pos, migrate_step;
+
+  /* True if the table was made with `:concurrency read-mostly'.  Such
+     a table never moves its index incrementally, and removing an
+     entry leaves a tombstone and keeps the entry out of the free list
+     until the next rebuild, so that readers in other threads can use
+     hash_lookup_concurrent without locking.  */
+  bool read_mostly;
+
+  /* For a read-mostly table, the index and vectors that concurrent
+     readers should use, replaced as a whole on every rebuild.  */
+  struct hash_snapshot *snapshot;
+
   /* Vector of keys and values.  The key of item I is found at index
      2 * I, the value is found at index 2 * I + 1.
      This is gc_marked specially if the table is weak.  */
@@ -1467,6 +1579,45 @@ HASH_TABLE_P (Lisp_Object a)
   return PSEUDOVECTORP (a, PVEC_HASH_TABLE);
 }
 
+/* An appendable text buffer; see string_builder_append in fns.c.  */
+struct Lisp_String_Builder
+{
+  struct vectorlike_header header;
+
+  /* Number of characters and of bytes of text in DATA.  */
+  ptrdiff_t nchars, nbytes;
+
+  /* Allocated size of DATA, which comes from xmalloc_atomic.  */
+  ptrdiff_t size;
+  unsigned char *data;
+
+  /* True if DATA holds multibyte text.  */
+  bool multibyte;
+};
+
+INLINE struct Lisp_String_Builder *
+XSTRING_BUILDER (Lisp_Object a)
+{
+  return SMOB_PTR (a);
+}
+
+#define XSETSTRING_BUILDER(VAR, PTR) \
+     (XSETPSEUDOVECTOR (VAR, PTR, PVEC_STRING_BUILDER))
+
+INLINE bool
+STRING_BUILDER_P (Lisp_Object a)
+{
+  return PSEUDOVECTORP (a, PVEC_STRING_BUILDER);
+}
+
+/* A zlib compression or decompression stream; the structure is private
+   to decompress.c.  */
+INLINE bool
+ZLIB_STREAM_P (Lisp_Object a)
+{
+  return PSEUDOVECTORP (a, PVEC_ZLIB_STREAM);
+}
+
 /* Value is the key part of entry IDX in hash table H.  */
 INLINE Lisp_Object
 HASH_KEY (struct Lisp_Hash_Table *h, ptrdiff_t idx)
@@ -1481,7 +1632,7 @@ HASH_VALUE (struct Lisp_Hash_Table *h, ptrdiff_t idx)
   return AREF (h->key_and_value, 2 * idx + 1);
 }
 
-/* Value is the index of the next entry following the one at IDX
+/* Value is the index of the next free entry following the one at IDX
    in hash table H.  */
 INLINE Lisp_Object
 HASH_NEXT (struct Lisp_Hash_Table *h, ptrdiff_t idx)
@@ -1496,14 +1647,6 @@ HASH_HASH (struct Lisp_Hash_Table *h, ptrdiff_t idx)
   return AREF (h->hash, idx);
 }
 
-/* Value is the index of the element in hash table H that is the
-   start of the collision list at index IDX in the index vector of H.  */
-INLINE Lisp_Object
-HASH_INDEX (struct Lisp_Hash_Table *h, ptrdiff_t idx)
-{
-  return AREF (h->index, idx);
-}
-
 /* Value is the size of hash table H.  */
 INLINE ptrdiff_t
 HASH_TABLE_SIZE (struct Lisp_Hash_Table *h)
@@ -1883,6 +2026,8 @@ struct Lisp_Buffer_Local_Value
     bool_bf found : 1;
     /* If non-NULL, a forwarding to the C var where it should also be set.  */
     union Lisp_Fwd *fwd;	/* Should never be (Buffer|Kboard)_Objfwd.  */
+    /* Index of this variable in each buffer's local_var_cache.  */
+    ptrdiff_t slot;
     /* The buffer or frame for which the loaded binding was found.  */
     Lisp_Object where;
     /* A cons cell that holds the default value.  It has the form
@@ -2182,6 +2327,11 @@ CHECK_BOOL_VECTOR (Lisp_Object x)
   CHECK_TYPE (BOOL_VECTOR_P (x), Qbool_vector_p, x);
 }
 INLINE void
+CHECK_STRING_BUILDER (Lisp_Object x)
+{
+  CHECK_TYPE (STRING_BUILDER_P (x), Qstring_builder_p, x);
+}
+INLINE void
 CHECK_VECTOR_OR_STRING (Lisp_Object x)
 {
   CHECK_TYPE (VECTORP (x) || STRINGP (x), Qarrayp, x);
@@ -2324,25 +2474,42 @@ CHECK_NUMBER_CDR (Lisp_Object x)
 #define GSUBR_ARGS(n) GSUBR_ARGS_PASTE (GSUBR_ARGS_, n)
 #define GSUBR_ARGS_PASTE(a, b) a ## b
 
-#define DEFUN_GSUBR_N(fn, maxargs)                              \
+/* Return the value of CALL, a call of the DEFUN named LNAME, counting
+   and timing it if the call profiler wants it.  The symbol of the
+   DEFUN is interned the first time it is needed.  */
+#define GSUBR_RETURN(lname, call)                               \
+  do {                                                          \
+    static Lisp_Object profile_symbol;                          \
+    struct call_profile_frame profile_frame;                    \
+    Lisp_Object profile_value;                                  \
+    if (!call_profile_enabled                                   \
+        || !call_profile_enter_subr (&profile_frame,            \
+                                     &profile_symbol, lname))   \
+      return call;                                              \
+    profile_value = call;                                       \
+    dynwind_end ();                                             \
+    return profile_value;                                       \
+  } while (0)
+
+#define DEFUN_GSUBR_N(lname, fn, maxargs)                       \
   Lisp_Object                                                   \
   gsubr_ ## fn                                                  \
   (GSUBR_ARGS (maxargs) (Lisp_Object))                          \
   {                                                             \
-    return fn (GSUBR_ARGS (maxargs) (GSUBR_ARG));               \
+    GSUBR_RETURN (lname, fn (GSUBR_ARGS (maxargs) (GSUBR_ARG))); \
   }
 #define GSUBR_ARG(x) (SCM_UNBNDP (x) ? Qnil : x)
 
 #define DEFUN_GSUBR_0(lname, fn, minargs, maxargs)       \
-  Lisp_Object gsubr_ ## fn (void) { return fn (); }
-#define DEFUN_GSUBR_1(lname, fn, min, max) DEFUN_GSUBR_N(fn, max)
-#define DEFUN_GSUBR_2(lname, fn, min, max) DEFUN_GSUBR_N(fn, max)
-#define DEFUN_GSUBR_3(lname, fn, min, max) DEFUN_GSUBR_N(fn, max)
-#define DEFUN_GSUBR_4(lname, fn, min, max) DEFUN_GSUBR_N(fn, max)
-#define DEFUN_GSUBR_5(lname, fn, min, max) DEFUN_GSUBR_N(fn, max)
-#define DEFUN_GSUBR_6(lname, fn, min, max) DEFUN_GSUBR_N(fn, max)
-#define DEFUN_GSUBR_7(lname, fn, min, max) DEFUN_GSUBR_N(fn, max)
-#define DEFUN_GSUBR_8(lname, fn, min, max) DEFUN_GSUBR_N(fn, max)
+  Lisp_Object gsubr_ ## fn (void) { GSUBR_RETURN (lname, fn ()); }
+#define DEFUN_GSUBR_1(lname, fn, min, max) DEFUN_GSUBR_N(lname, fn, max)
+#define DEFUN_GSUBR_2(lname, fn, min, max) DEFUN_GSUBR_N(lname, fn, max)
+#define DEFUN_GSUBR_3(lname, fn, min, max) DEFUN_GSUBR_N(lname, fn, max)
+#define DEFUN_GSUBR_4(lname, fn, min, max) DEFUN_GSUBR_N(lname, fn, max)
+#define DEFUN_GSUBR_5(lname, fn, min, max) DEFUN_GSUBR_N(lname, fn, max)
+#define DEFUN_GSUBR_6(lname, fn, min, max) DEFUN_GSUBR_N(lname, fn, max)
+#define DEFUN_GSUBR_7(lname, fn, min, max) DEFUN_GSUBR_N(lname, fn, max)
+#define DEFUN_GSUBR_8(lname, fn, min, max) DEFUN_GSUBR_N(lname, fn, max)
 
 #define DEFUN_GSUBR_UNEVALLED(lname, fn, minargs, maxargs)  \
   Lisp_Object                                               \
@@ -2352,24 +2519,41 @@ CHECK_NUMBER_CDR (Lisp_Object x)
     if (XINT (len) < minargs)                               \
       xsignal2 (Qwrong_number_of_arguments,                 \
                 intern (lname), len);                       \
-    return fn (rest);                                       \
+    GSUBR_RETURN (lname, fn (rest));                        \
   }
+/* MANY functions are registered by defsubr with this many optional
+   arguments before the rest list.  Guile passes those in registers and
+   conses a rest list only for the arguments beyond them, so a call
+   like (+ a b) or (concat a b c) allocates nothing.  Unsupplied
+   optional arguments arrive as SCM_UNDEFINED.  */
+enum { GSUBR_MANY_INLINE_ARGS = 4 };
+
 #define DEFUN_GSUBR_MANY(lname, fn, minargs, maxargs)        \
   Lisp_Object                                               \
-  gsubr_ ## fn (Lisp_Object rest)                           \
+  gsubr_ ## fn (Lisp_Object arg1, Lisp_Object arg2,         \
+                Lisp_Object arg3, Lisp_Object arg4,         \
+                Lisp_Object rest)                           \
   {                                                         \
-    int len = scm_to_int (scm_length (rest));               \
-    Lisp_Object *args;                                      \
-    SAFE_ALLOCA_LISP (args, len);                           \
-    int i;                                                  \
-    for (i = 0;                                             \
-         i < len && scm_is_pair (rest);                     \
-         i++, rest = SCM_CDR (rest))                        \
-      args[i] = SCM_CAR (rest);                             \
+    Lisp_Object inline_args[GSUBR_MANY_INLINE_ARGS]         \
+      = { arg1, arg2, arg3, arg4 };                         \
+    Lisp_Object *args = inline_args;                        \
+    int i = 0;                                              \
+    while (i < GSUBR_MANY_INLINE_ARGS                       \
+           && !SCM_UNBNDP (inline_args[i]))                 \
+      i++;                                                  \
+    if (scm_is_pair (rest))                                 \
+      {                                                     \
+        int len = i + scm_to_int (scm_length (rest));       \
+        SAFE_ALLOCA_LISP (args, len);                       \
+        memcpy (args, inline_args, i * word_size);          \
+        for (; i < len && scm_is_pair (rest);               \
+             i++, rest = SCM_CDR (rest))                    \
+          args[i] = SCM_CAR (rest);                         \
+      }                                                     \
     if (i < minargs)                                        \
       xsignal2 (Qwrong_number_of_arguments,                 \
                 intern (lname), make_number (i));           \
-    return fn (i, args);                                    \
+    GSUBR_RETURN (lname, fn (i, args));                     \
   }
 
 /* Note that the weird token-substitution semantics of ANSI C makes
@@ -2748,22 +2932,19 @@ set_hash_value_slot (struct Lisp_Hash_Table *h, ptrdiff_t idx, Lisp_Object val)
 INLINE void
 set_symbol_function (Lisp_Object sym, Lisp_Object function)
 {
-  scm_call_2 (scm_c_public_ref ("language elisp runtime", "set-symbol-function!"),
-              sym, function);
+  scm_call_2 (set_symbol_function_fn, sym, function);
 }
 
 INLINE Lisp_Object
 symbol_plist (Lisp_Object sym)
 {
-  return scm_call_1 (scm_c_public_ref ("language elisp runtime", "symbol-plist"),
-                     sym);
+  return scm_call_1 (symbol_plist_fn, sym);
 }
 
 INLINE void
 set_symbol_plist (Lisp_Object sym, Lisp_Object plist)
 {
-  scm_call_2 (scm_c_public_ref ("language elisp runtime", "set-symbol-plist!"),
-              sym, plist);
+  scm_call_2 (set_symbol_plist_fn, sym, plist);
 }
 
 /* Buffer-local (also frame-local) variable access functions.  */
@@ -2806,6 +2987,7 @@ INLINE void
 set_char_table_defalt (Lisp_Object table, Lisp_Object val)
 {
   XCHAR_TABLE (table)->defalt = val;
+  char_table_modiff++;
 }
 INLINE void
 set_char_table_purpose (Lisp_Object table, Lisp_Object val)
@@ -2827,12 +3009,14 @@ set_char_table_contents (Lisp_Object table, ptrdiff_t idx, Lisp_Object val)
 {
   eassert (0 <= idx && idx < (1 << CHARTAB_SIZE_BITS_0));
   XCHAR_TABLE (table)->contents[idx] = val;
+  char_table_modiff++;
 }
 
 INLINE void
 set_sub_char_table_contents (Lisp_Object table, ptrdiff_t idx, Lisp_Object val)
 {
   XSUB_CHAR_TABLE (table)->contents[idx] = val;
+  char_table_modiff++;
 }
 
 /* Defined in data.c.  */
@@ -2927,6 +3111,8 @@ extern void syms_of_coding (void);
 /* Defined in character.c.  */
 extern ptrdiff_t chars_in_text (const unsigned char *, ptrdiff_t);
 extern ptrdiff_t multibyte_chars_in_text (const unsigned char *, ptrdiff_t);
+extern bool char_rtl_p (int);
+extern bool multibyte_text_rtl_p (const unsigned char *, ptrdiff_t);
 extern void syms_of_character (void);
 
 /* Defined in charset.c.  */
@@ -2939,6 +3125,7 @@ struct charset;
 /* Defined in syntax.c.  */
 extern void init_syntax_once (void);
 extern void syms_of_syntax (void);
+extern void parse_cache_flush (ptrdiff_t);
 
 /* Defined in fns.c.  */
 extern Lisp_Object QCrehash_size, QCrehash_threshold;
@@ -2949,6 +3136,12 @@ extern void sweep_weak_hash_tables (void);
 extern Lisp_Object Qcursor_in_echo_area;
 extern Lisp_Object Qstring_lessp;
 extern Lisp_Object QCsize, QCtest, QCweakness, Qequal, Qeq;
+extern Lisp_Object Qstring_builder;
+extern void string_builder_append (struct Lisp_String_Builder *,
+				   const unsigned char *, ptrdiff_t,
+				   ptrdiff_t, bool);
+extern void string_builder_append_string (struct Lisp_String_Builder *,
+					  Lisp_Object);
 EMACS_UINT hash_string (char const *, ptrdiff_t);
 EMACS_UINT sxhash (Lisp_Object, int);
 Lisp_Object make_hash_table (struct hash_table_test, Lisp_Object, Lisp_Object,
@@ -2956,7 +3149,10 @@ Lisp_Object make_hash_table (struct hash_table_test, Lisp_Object, Lisp_Object,
 ptrdiff_t hash_lookup (struct Lisp_Hash_Table *, Lisp_Object, EMACS_UINT *);
 ptrdiff_t hash_put (struct Lisp_Hash_Table *, Lisp_Object, Lisp_Object,
 		    EMACS_UINT);
-extern struct hash_table_test hashtest_eql, hashtest_equal;
+void hash_remove_from_table (struct Lisp_Hash_Table *, Lisp_Object);
+bool hash_lookup_concurrent (struct Lisp_Hash_Table *, Lisp_Object,
+			     Lisp_Object *);
+extern struct hash_table_test hashtest_eq, hashtest_eql, hashtest_equal;
 extern void validate_subarray (Lisp_Object, Lisp_Object, Lisp_Object,
 			       ptrdiff_t, ptrdiff_t *, ptrdiff_t *);
 extern Lisp_Object substring_both (Lisp_Object, ptrdiff_t, ptrdiff_t,
@@ -3004,6 +3200,14 @@ extern void make_gap (ptrdiff_t);
 extern void make_gap_1 (struct buffer *, ptrdiff_t);
 extern ptrdiff_t copy_text (const unsigned char *, unsigned char *,
 			    ptrdiff_t, bool, bool);
+extern ptrdiff_t buffer_prefix_match (struct buffer *, ptrdiff_t, ptrdiff_t,
+				      const unsigned char *, ptrdiff_t);
+extern ptrdiff_t buffer_suffix_match (struct buffer *, ptrdiff_t, ptrdiff_t,
+				      const unsigned char *, ptrdiff_t);
+extern ptrdiff_t buffers_prefix_match (struct buffer *, ptrdiff_t, ptrdiff_t,
+				       struct buffer *, ptrdiff_t, ptrdiff_t);
+extern ptrdiff_t buffers_suffix_match (struct buffer *, ptrdiff_t, ptrdiff_t,
+				       struct buffer *, ptrdiff_t, ptrdiff_t);
 extern int count_combining_before (const unsigned char *,
 				   ptrdiff_t, ptrdiff_t, ptrdiff_t);
 extern int count_combining_after (const unsigned char *,
@@ -3030,14 +3234,16 @@ extern void del_range_both (ptrdiff_t, ptrdiff_t, ptrdiff_t, ptrdiff_t, bool);
 extern Lisp_Object del_range_2 (ptrdiff_t, ptrdiff_t,
 				ptrdiff_t, ptrdiff_t, bool);
 extern void modify_text (ptrdiff_t, ptrdiff_t);
+extern void note_rtl_text (void);
 extern void prepare_to_modify_buffer (ptrdiff_t, ptrdiff_t, ptrdiff_t *);
 extern void prepare_to_modify_buffer_1 (ptrdiff_t, ptrdiff_t, ptrdiff_t *);
 extern void invalidate_buffer_caches (struct buffer *, ptrdiff_t, ptrdiff_t);
 extern void signal_after_change (ptrdiff_t, ptrdiff_t, ptrdiff_t);
+extern void flush_deferred_changes (void);
 extern void adjust_after_insert (ptrdiff_t, ptrdiff_t, ptrdiff_t,
 				 ptrdiff_t, ptrdiff_t);
 extern void adjust_markers_for_delete (ptrdiff_t, ptrdiff_t,
-				       ptrdiff_t, ptrdiff_t);
+				       ptrdiff_t, ptrdiff_t, Lisp_Object *);
 extern void replace_range (ptrdiff_t, ptrdiff_t, Lisp_Object, bool, bool, bool);
 extern void replace_range_2 (ptrdiff_t, ptrdiff_t, ptrdiff_t, ptrdiff_t,
 			     const char *, ptrdiff_t, ptrdiff_t, bool);
@@ -3101,6 +3307,8 @@ extern void syms_of_xsettings (void);
 extern void memory_warnings (void *, void (*warnfun) (const char *));
 
 /* Defined in alloc.c.  */
+extern bool gc_in_progress;
+extern void gc_update_elapsed (void);
 extern void check_pure_size (void);
 extern void free_misc (Lisp_Object);
 extern void allocate_string_data (Lisp_Object, EMACS_INT, EMACS_INT);
@@ -3253,6 +3461,14 @@ extern void r_alloc_inhibit_buffer_relocation (int);
 extern Lisp_Object copy_char_table (Lisp_Object);
 extern Lisp_Object char_table_ref_and_range (Lisp_Object, int,
                                              int *, int *);
+/* A run of characters FROM..TO that all have the value VAL.  */
+struct char_table_run
+{
+  int from, to;
+  Lisp_Object val;
+};
+extern ptrdiff_t char_table_runs (Lisp_Object, int, int,
+				  struct char_table_run *, ptrdiff_t);
 extern void char_table_set_range (Lisp_Object, int, int, Lisp_Object);
 extern void map_char_table (void (*) (Lisp_Object, Lisp_Object,
                             Lisp_Object),
@@ -3302,6 +3518,7 @@ extern Lisp_Object check_obarray (Lisp_Object);
 extern Lisp_Object intern_1 (const char *, ptrdiff_t);
 extern Lisp_Object intern_c_string_1 (const char *, ptrdiff_t);
 extern Lisp_Object obhash (Lisp_Object);
+extern Lisp_Object oblookup (Lisp_Object, const char *, ptrdiff_t, ptrdiff_t);
 INLINE void
 LOADHIST_ATTACH (Lisp_Object x)
 {
@@ -3388,6 +3605,22 @@ extern void record_unwind_protect_void_1 (void (*) (void), bool);
 extern void record_unwind_protect_void (void (*) (void));
 extern void dynwind_begin (void);
 extern void dynwind_end (void);
+
+/* A call being timed by the call profiler.  */
+struct call_profile_frame
+{
+  Lisp_Object symbol;
+  /* When the call started, in nanoseconds.  */
+  intmax_t start;
+  /* The enclosing timed call.  */
+  struct call_profile_frame *outer;
+  /* True if Ffuncall made this frame, and the function has not yet
+     entered call-profile-apply for the same call.  */
+  bool funcall;
+};
+extern bool call_profile_enabled;
+extern bool call_profile_enter_subr (struct call_profile_frame *,
+                                     Lisp_Object *, const char *);
 extern _Noreturn void error (const char *, ...) ATTRIBUTE_FORMAT_PRINTF (1, 2);
 extern _Noreturn void verror (const char *, va_list)
   ATTRIBUTE_FORMAT_PRINTF (1, 0);
@@ -3445,6 +3678,7 @@ extern void keys_of_buffer (void);
 extern ptrdiff_t marker_position (Lisp_Object);
 extern ptrdiff_t marker_byte_position (Lisp_Object);
 extern void clear_charpos_cache (struct buffer *);
+extern void truncate_pos_index (struct buffer *, ptrdiff_t);
 extern ptrdiff_t buf_charpos_to_bytepos (struct buffer *, ptrdiff_t);
 extern ptrdiff_t buf_bytepos_to_charpos (struct buffer *, ptrdiff_t);
 extern void unchain_marker (struct Lisp_Marker *marker);
@@ -3680,7 +3914,7 @@ extern Lisp_Object Qapply;
 extern Lisp_Object Qinhibit_read_only;
 extern void truncate_undo_list (struct buffer *);
 extern void record_insert (ptrdiff_t, ptrdiff_t);
-extern void record_delete (ptrdiff_t, Lisp_Object, bool);
+extern void record_delete (ptrdiff_t, Lisp_Object, Lisp_Object);
 extern void record_first_change (void);
 extern void record_change (ptrdiff_t, ptrdiff_t);
 extern void record_property_change (ptrdiff_t, ptrdiff_t,
@@ -3829,6 +4063,12 @@ extern void syms_of_xterm (void);
 extern char *x_get_keysym_name (int);
 #endif /* HAVE_WINDOW_SYSTEM */
 
+/* Defined in json.c.  */
+extern void syms_of_json (void);
+
+/* Defined in serialize.c.  */
+extern void syms_of_serialize (void);
+
 #ifdef HAVE_LIBXML2
 /* Defined in xml.c.  */
 extern void syms_of_xml (void);
@@ -3849,6 +4089,8 @@ void syms_of_dbusbind (void);
 /* Defined in profiler.c.  */
 extern bool profiler_memory_running;
 extern void malloc_probe (size_t);
+extern void object_probe (size_t);
+extern void profiler_record_pending (void);
 extern void syms_of_profiler (void);
 
 
@@ -4008,7 +4250,6 @@ functionp (Lisp_Object object)
     return false;
 }
 
-extern Lisp_Object xsymbol_fn;
 
 INLINE sym_t
 XSYMBOL (Lisp_Object a)
@@ -40,6 +40,8 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include "termhooks.h"
 #include "blockinput.h"
 #include "guile.h"
+#include "systime.h"
+#include "sha1.h"
 
 #ifdef MSDOS
 #include "msdos.h"
@@ -56,6 +58,7 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #endif /* HAVE_SETLOCALE */
 
 #include <fcntl.h>
+#include <dirent.h>
 
 #ifdef HAVE_FSEEKO
 #define file_offset off_t
@@ -83,6 +86,7 @@ static Lisp_Object Qinhibit_file_name_operation;
 static Lisp_Object Qeval_buffer_list;
 Lisp_Object Qlexical_binding;
 static Lisp_Object Qfile_truename, Qdo_after_load_evaluation; /* ACM 2006/5/16 */
+static Lisp_Object Qsymbol_file, Qdefun;
 
 /* Used instead of Qget_file_char while loading *.elc files compiled
    by Emacs 21 or older.  */
@@ -148,6 +152,7 @@ static int read_emacs_mule_char (int, int (*) (int, Lisp_Object),
 static void readevalloop (Lisp_Object, FILE *, Lisp_Object, bool,
                           Lisp_Object, Lisp_Object,
                           Lisp_Object, Lisp_Object);
+static void build_load_history (Lisp_Object, bool);
 
 /* Functions that read one byte from the current source READCHARFUN
    or unreads one byte.  If the integer argument C is -1, it returns
@@ -576,6 +581,7 @@ static Lisp_Object read1 (Lisp_Object, int *, bool);
 
 static Lisp_Object read_list (bool, Lisp_Object);
 static Lisp_Object read_vector (Lisp_Object, bool);
+static Lisp_Object relocate_load_file_name (Lisp_Object);
 
 static Lisp_Object substitute_object_recurse (Lisp_Object, Lisp_Object,
                                               Lisp_Object);
@@ -980,6 +986,544 @@ load_warn_old_style_backquotes (Lisp_Object file)
     }
 }
 
+
+/* The compiled-object cache.
+
+   When `load-prefer-compiled-cache' is non-nil, loading FOO.el or
+   FOO.elc first looks for a cache file FOO.go.  It holds the Guile
+   bytecode that the top-level forms of the file compiled to, one
+   object per form in the order they were evaluated, after a header
+   line with a key that identifies the contents of the source file
+   and the compiler.  Each object is preceded by a line giving its
+   length in bytes.  If the key matches, `load' runs the cached code
+   instead of reading and compiling the file again.  Otherwise the
+   forms are compiled one at a time as they are loaded, and the cache
+   is written afterwards.
+
+   Compiling a form expands the macros in it, so the cached code also
+   depends on the files that defined those macros.  After the key, the
+   cache lists these files with digests of their contents, and it is
+   out of date if any of them changed.  The macros are found by looking
+   for macro calls in the forms as read; macros that only appear in
+   expansions are usually defined by the same files.  */
+
+/* Version of the cache file format.  */
+enum { LOAD_CACHE_FORMAT = 2 };
+
+/* Guile procedures used by the cache, resolved when first needed.  */
+static Lisp_Object load_cache_compile_fn;
+static Lisp_Object load_cache_load_thunk_fn;
+
+/* While a file is being loaded and its cache is to be written, the
+   name under which `load' passes it to readevalloop, until
+   readevalloop starts reading it; otherwise nil.  */
+static Lisp_Object load_cache_source;
+
+/* The compiled forms of the file whose cache is being written, most
+   recent first, or t if some form could not be compiled.  */
+static Lisp_Object load_cache_objects;
+
+/* The macros called by the forms of that file, and the files that
+   defined them.  */
+static Lisp_Object load_cache_macros, load_cache_deps;
+
+/* Digests of files that caches depend on, computed in this session:
+   an alist of elements (FILE MTIME . DIGEST).  */
+static Lisp_Object load_cache_digests;
+
+/* Statistics for `load-macroexpand-stats'.  */
+static EMACS_INT load_cache_hits, load_cache_misses, load_cache_forms;
+static struct timespec load_cache_compile_time, load_cache_run_time;
+
+static void
+load_cache_init (void)
+{
+  static bool initialized;
+
+  if (!initialized)
+    {
+      load_cache_compile_fn
+        = scm_c_public_ref ("system base compile", "compile");
+      load_cache_load_thunk_fn
+        = scm_c_public_ref ("system vm loader", "load-thunk-from-memory");
+      initialized = true;
+    }
+}
+
+/* Return the name of the cache file for the Lisp file FOUND, or nil
+   if FOUND is not a Lisp file.  */
+
+static Lisp_Object
+load_cache_file_name (Lisp_Object found)
+{
+  ptrdiff_t nbytes = SBYTES (found);
+  int suffix;
+  Lisp_Object name;
+
+  if (nbytes > 3 && !memcmp (SDATA (found) + nbytes - 3, ".el", 3))
+    suffix = 3;
+  else if (nbytes > 4 && !memcmp (SDATA (found) + nbytes - 4, ".elc", 4))
+    suffix = 4;
+  else
+    return Qnil;
+
+  name = concat2 (Fsubstring (found, make_number (0),
+			      make_number (SCHARS (found) - suffix)),
+		  build_string (".go"));
+
+  if (STRINGP (Vload_compiled_cache_directory))
+    {
+      /* Flatten the absolute file name into one file name in the
+	 cache directory, the way backup file names are made.  */
+      ptrdiff_t i;
+
+      name = Fcopy_sequence (Fexpand_file_name (name, Qnil));
+      for (i = 0; i < SBYTES (name); i++)
+	if (IS_DIRECTORY_SEP (SREF (name, i)))
+	  SSET (name, i, '!');
+      name = Fexpand_file_name (name, Vload_compiled_cache_directory);
+    }
+
+  return name;
+}
+
+/* Return the SHA-1 digest of the contents of the file open on FD, in
+   hex, or nil if the file cannot be read.  Leave FD positioned at the
+   start of the file.  */
+
+static Lisp_Object
+load_cache_digest (int fd)
+{
+  struct sha1_ctx ctx;
+  char buf[16 * 1024];
+  unsigned char digest[SHA1_DIGEST_SIZE];
+  char hex[2 * SHA1_DIGEST_SIZE];
+  ptrdiff_t nread;
+  int i;
+
+  sha1_init_ctx (&ctx);
+  while ((nread = emacs_read (fd, buf, sizeof buf)) > 0)
+    sha1_process_bytes (buf, nread, &ctx);
+  if (nread < 0 || lseek (fd, 0, SEEK_SET) != 0)
+    return Qnil;
+  sha1_finish_ctx (&ctx, digest);
+
+  for (i = 0; i < SHA1_DIGEST_SIZE; i++)
+    {
+      static char const hexdigit[16] = "0123456789abcdef";
+      hex[2 * i] = hexdigit[digest[i] >> 4];
+      hex[2 * i + 1] = hexdigit[digest[i] & 0xf];
+    }
+  return make_unibyte_string (hex, sizeof hex);
+}
+
+/* Return the digest of the file named FILE, as by load_cache_digest.
+   Digests are remembered as long as the file is not modified, since
+   many caches depend on the same few files.  */
+
+static Lisp_Object
+load_cache_file_digest (Lisp_Object file)
+{
+  Lisp_Object efile = ENCODE_FILE (file);
+  Lisp_Object entry = Fassoc (file, load_cache_digests);
+  Lisp_Object mtime, digest;
+  struct stat st;
+  int fd;
+
+  fd = emacs_open (SSDATA (efile), O_RDONLY, 0);
+  if (fd < 0)
+    return Qnil;
+  if (fstat (fd, &st) != 0)
+    {
+      emacs_close (fd);
+      return Qnil;
+    }
+  mtime = make_lisp_time (get_stat_mtime (&st));
+  if (CONSP (entry) && !NILP (Fequal (XCAR (XCDR (entry)), mtime)))
+    {
+      emacs_close (fd);
+      return XCDR (XCDR (entry));
+    }
+
+  digest = load_cache_digest (fd);
+  emacs_close (fd);
+  if (CONSP (entry))
+    XSETCDR (entry, Fcons (mtime, digest));
+  else
+    load_cache_digests = Fcons (Fcons (file, Fcons (mtime, digest)),
+				load_cache_digests);
+  return digest;
+}
+
+/* Return the key that identifies the contents of the file open on FD
+   together with the running Emacs and compiler, or nil if the file
+   cannot be read.  Leave FD positioned at the start of the file.  */
+
+static Lisp_Object
+load_cache_key (int fd)
+{
+  Lisp_Object digest = load_cache_digest (fd);
+  Lisp_Object args[5];
+  char *guile_version;
+
+  if (NILP (digest))
+    return Qnil;
+
+  guile_version = scm_to_latin1_string (scm_version ());
+  args[0] = build_string ("guile-emacs-go %d %s %s %s");
+  args[1] = make_number (LOAD_CACHE_FORMAT);
+  args[2] = Vemacs_version;
+  args[3] = build_string (guile_version);
+  args[4] = digest;
+  free (guile_version);
+  return Fformat (5, args);
+}
+
+/* Read the cache file CACHE.  If it is a valid cache for KEY, store
+   the list of thunks it holds, in order, into *THUNKS and return
+   true.  Otherwise return false.  */
+
+static bool
+load_cache_read (Lisp_Object cache, Lisp_Object key, Lisp_Object *thunks)
+{
+  Lisp_Object ecache = ENCODE_FILE (cache);
+  Lisp_Object result = Qnil;
+  struct stat st;
+  char *data, *p, *end;
+  ptrdiff_t size, nread, n;
+  int fd;
+
+  fd = emacs_open (SSDATA (ecache), O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+  if (fstat (fd, &st) != 0
+      || ! (0 <= st.st_size && st.st_size < min (PTRDIFF_MAX, SIZE_MAX)))
+    {
+      emacs_close (fd);
+      return false;
+    }
+  size = st.st_size;
+  data = xmalloc_atomic (size);
+  for (nread = 0; nread < size; nread += n)
+    {
+      n = emacs_read (fd, data + nread, min (size - nread, 1024 * 1024));
+      if (n <= 0)
+	break;
+    }
+  emacs_close (fd);
+  if (nread != size)
+    return false;
+
+  end = data + size;
+  p = memchr (data, '\n', size);
+  if (! (p && p - data == SBYTES (key)
+	 && !memcmp (data, SDATA (key), SBYTES (key))))
+    return false;
+  p++;
+
+  /* Check the files that the code depends on: a line with their
+     number, then for each a line with its digest and name.  */
+  {
+    char *newline = memchr (p, '\n', end - p);
+    char *digits_end;
+    uintmax_t ndeps;
+
+    if (!newline)
+      return false;
+    ndeps = strtoumax (p, &digits_end, 10);
+    if (digits_end != newline)
+      return false;
+    for (p = newline + 1; ndeps > 0; ndeps--, p = newline + 1)
+      {
+	Lisp_Object digest;
+	int len = 2 * SHA1_DIGEST_SIZE;
+
+	newline = memchr (p, '\n', end - p);
+	if (! (newline && newline - p > len && p[len] == ' '))
+	  return false;
+	digest = load_cache_file_digest
+	  (DECODE_FILE (make_unibyte_string (p + len + 1,
+					     newline - (p + len + 1))));
+	if (! (STRINGP (digest) && !memcmp (SDATA (digest), p, len)))
+	  return false;
+      }
+  }
+
+  while (p < end)
+    {
+      char *newline = memchr (p, '\n', end - p);
+      char *digits_end;
+      uintmax_t len;
+      Lisp_Object code;
+
+      if (!newline)
+	return false;
+      len = strtoumax (p, &digits_end, 10);
+      if (digits_end != newline || end - (newline + 1) < len)
+	return false;
+      code = scm_c_make_bytevector (len);
+      memcpy (SCM_BYTEVECTOR_CONTENTS (code), newline + 1, len);
+      result = Fcons (scm_call_1 (load_cache_load_thunk_fn, code), result);
+      p = newline + 1 + len;
+    }
+
+  *thunks = Fnreverse (result);
+  return true;
+}
+
+/* Run THUNKS, read from the cache of the file SOURCENAME, the way
+   readevalloop would evaluate the forms of the file.  */
+
+static void
+load_cache_run (Lisp_Object thunks, Lisp_Object sourcename)
+{
+  dynwind_begin ();
+
+  specbind (Qcurrent_load_list, Qnil);
+  if (!NILP (Ffile_name_absolute_p (sourcename))
+      && !NILP (Ffboundp (Qfile_truename)))
+    sourcename = call1 (Qfile_truename, sourcename);
+  LOADHIST_ATTACH (sourcename);
+
+  for (; CONSP (thunks); thunks = XCDR (thunks))
+    {
+      QUIT;
+      scm_call_0 (XCAR (thunks));
+    }
+
+  build_load_history (sourcename, true);
+  dynwind_end ();
+}
+
+/* Note the macros called in FORM, looking no more than DEPTH levels
+   deep, and add the files that defined them to load_cache_deps.
+   Quoted data is scanned too; that can only add needless
+   dependencies.  */
+
+static void
+load_cache_note_macros (Lisp_Object form, int depth)
+{
+  Lisp_Object head, def;
+
+  if (!CONSP (form) || depth <= 0)
+    return;
+
+  head = XCAR (form);
+  if (SYMBOLP (head) && !NILP (head)
+      && NILP (Fmemq (head, load_cache_macros)))
+    {
+      def = indirect_function (head);
+      if (CONSP (def) && EQ (XCAR (def), Qmacro))
+	{
+	  Lisp_Object file = (NILP (Ffboundp (Qsymbol_file)) ? Qnil
+			      : call2 (Qsymbol_file, head, Qdefun));
+
+	  load_cache_macros = Fcons (head, load_cache_macros);
+	  if (STRINGP (file))
+	    {
+	      if (NILP (Fmember (file, load_cache_deps)))
+		load_cache_deps = Fcons (file, load_cache_deps);
+	    }
+	  else if (NILP (Fmember (Fcons (Qdefun, head), Vcurrent_load_list)))
+	    /* Not defined in a file, nor earlier in this one, so a
+	       cache could not tell when the definition changes.  */
+	    load_cache_objects = Qt;
+	}
+    }
+
+  for (; CONSP (form); form = XCDR (form))
+    load_cache_note_macros (XCAR (form), depth - 1);
+}
+
+static Lisp_Object
+load_cache_compile (Lisp_Object form)
+{
+  return scm_call_5 (load_cache_compile_fn, form,
+		     scm_from_latin1_keyword ("from"),
+		     scm_from_latin1_symbol ("elisp"),
+		     scm_from_latin1_keyword ("to"),
+		     scm_from_latin1_symbol ("bytecode"));
+}
+
+/* Evaluate FORM, a top-level form of the file whose cache is being
+   written, and add the code it compiled to to the cache.  */
+
+static Lisp_Object
+load_cache_eval (Lisp_Object form)
+{
+  Lisp_Object code;
+  struct timespec start;
+
+  if (EQ (load_cache_objects, Qt))
+    return eval_sub (form);
+
+  load_cache_note_macros (form, 100);
+  start = current_timespec ();
+  code = internal_condition_case_1 (load_cache_compile, form, Qerror,
+				    load_error_handler);
+  load_cache_compile_time
+    = timespec_add (load_cache_compile_time,
+		    timespec_sub (current_timespec (), start));
+  load_cache_forms++;
+  if (NILP (code))
+    {
+      /* Let `eval' report the error, if it is one; either way the
+	 file can no longer be cached.  */
+      load_cache_objects = Qt;
+      return eval_sub (form);
+    }
+
+  load_cache_objects = Fcons (code, load_cache_objects);
+  QUIT;
+  return scm_c_value_ref (scm_call_0 (scm_call_1 (load_cache_load_thunk_fn,
+						  code)),
+			  0);
+}
+
+/* Return the files in load_cache_deps as a list of elements
+   (DIGEST . FILE), or t if one of them cannot be read.  */
+
+static Lisp_Object
+load_cache_dependencies (void)
+{
+  Lisp_Object deps = Qnil, tail;
+
+  for (tail = load_cache_deps; CONSP (tail); tail = XCDR (tail))
+    {
+      Lisp_Object digest = load_cache_file_digest (XCAR (tail));
+      if (NILP (digest))
+	return Qt;
+      deps = Fcons (Fcons (digest, XCAR (tail)), deps);
+    }
+  return deps;
+}
+
+/* Write the code recorded in load_cache_objects into the cache file
+   CACHE, under KEY.  Failing to write the cache is not an error.  */
+
+static void
+load_cache_write (Lisp_Object cache, Lisp_Object key)
+{
+  Lisp_Object ecache = ENCODE_FILE (cache);
+  Lisp_Object temp, tail, deps;
+  char buf[INT_BUFSIZE_BOUND (uintmax_t) + sizeof ".tmp"];
+  bool ok;
+  int fd;
+
+  deps = load_cache_dependencies ();
+  if (EQ (deps, Qt))
+    return;
+
+  /* Write a temporary file and rename it, so that concurrent
+     sessions never see a partly written cache.  */
+  sprintf (buf, ".%"pMd".tmp", (printmax_t) getpid ());
+  temp = concat2 (ecache, build_string (buf));
+  fd = emacs_open (SSDATA (temp), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    return;
+
+  ok = (emacs_write (fd, SDATA (key), SBYTES (key)) == SBYTES (key)
+	&& emacs_write (fd, "\n", 1) == 1);
+  if (ok)
+    {
+      int n = sprintf (buf, "%"pD"d\n", list_length (deps));
+      ok = emacs_write (fd, buf, n) == n;
+    }
+  for (tail = deps; ok && CONSP (tail); tail = XCDR (tail))
+    {
+      Lisp_Object digest = XCAR (XCAR (tail));
+      Lisp_Object efile = ENCODE_FILE (XCDR (XCAR (tail)));
+      ok = (emacs_write (fd, SDATA (digest), SBYTES (digest))
+	    == SBYTES (digest)
+	    && emacs_write (fd, " ", 1) == 1
+	    && emacs_write (fd, SDATA (efile), SBYTES (efile)) == SBYTES (efile)
+	    && emacs_write (fd, "\n", 1) == 1);
+    }
+  for (tail = Freverse (load_cache_objects); ok && CONSP (tail);
+       tail = XCDR (tail))
+    {
+      Lisp_Object code = XCAR (tail);
+      ptrdiff_t len = SCM_BYTEVECTOR_LENGTH (code);
+      int n = sprintf (buf, "%"pD"d\n", len);
+      ok = (emacs_write (fd, buf, n) == n
+	    && emacs_write (fd, SCM_BYTEVECTOR_CONTENTS (code), len) == len);
+    }
+
+  if (emacs_close (fd) != 0)
+    ok = false;
+  if (! (ok && rename (SSDATA (temp), SSDATA (ecache)) == 0))
+    unlink (SSDATA (temp));
+}
+
+/* After loading a file whose code was being recorded, write its
+   cache CACHE under KEY, if all of the file was read and compiled.  */
+
+static void
+load_cache_finish (Lisp_Object cache, Lisp_Object key)
+{
+  if (NILP (load_cache_source) && !EQ (load_cache_objects, Qt))
+    load_cache_write (cache, key);
+}
+
+static void
+load_cache_unwind (Lisp_Object saved)
+{
+  load_cache_source = XCAR (saved);
+  load_cache_objects = XCAR (XCDR (saved));
+  load_cache_macros = XCAR (XCDR (XCDR (saved)));
+  load_cache_deps = XCAR (XCDR (XCDR (XCDR (saved))));
+}
+
+DEFUN ("load-macroexpand-stats", Fload_macroexpand_stats,
+       Sload_macroexpand_stats, 0, 1, "P",
+       doc: /* Return statistics about compiling Lisp files as they are loaded.
+Loading a file compiles its top-level forms, which is when their
+macros are expanded, unless `load-prefer-compiled-cache' lets `load'
+run code cached from an earlier session.  The value is an alist:
+
+  (cache-hits . N)    files whose cached code was run,
+  (cache-misses . N)  files compiled because their cache was missing
+                      or out of date,
+  (forms . N)         top-level forms compiled for the cache,
+  (compile-time . S)  seconds spent compiling and expanding them,
+  (cache-time . S)    seconds spent running cached code.
+
+Only loads that use the cache are counted.  If RESET is non-nil,
+clear the statistics after returning them.  Interactively, show them
+in the echo area; a prefix argument resets them.  */)
+  (Lisp_Object reset)
+{
+  Lisp_Object stats
+    = list5 (Fcons (intern ("cache-hits"), make_number (load_cache_hits)),
+	     Fcons (intern ("cache-misses"), make_number (load_cache_misses)),
+	     Fcons (intern ("forms"), make_number (load_cache_forms)),
+	     Fcons (intern ("compile-time"),
+		    make_float (timespectod (load_cache_compile_time))),
+	     Fcons (intern ("cache-time"),
+		    make_float (timespectod (load_cache_run_time))));
+
+  if (INTERACTIVE)
+    {
+      Lisp_Object args[6];
+      args[0] = build_string ("Loads from cache: %d, compiled: %d (%d forms); "
+			      "compiling took %.3fs, cached code %.3fs");
+      args[1] = make_number (load_cache_hits);
+      args[2] = make_number (load_cache_misses);
+      args[3] = make_number (load_cache_forms);
+      args[4] = make_float (timespectod (load_cache_compile_time));
+      args[5] = make_float (timespectod (load_cache_run_time));
+      Fmessage (6, args);
+    }
+
+  if (!NILP (reset))
+    {
+      load_cache_hits = load_cache_misses = load_cache_forms = 0;
+      load_cache_compile_time = load_cache_run_time = make_timespec (0, 0);
+    }
+
+  return stats;
+}
+
 DEFUN ("get-load-suffixes", Fget_load_suffixes, Sget_load_suffixes, 0, 0, 0,
        doc: /* Return the suffixes that `load' should try if a suffix is \
 required.
@@ -1054,6 +1598,10 @@ Return t if the file exists and loads successfully.  */)
   dynwind_begin ();
   struct gcpro gcpro1, gcpro2, gcpro3;
   Lisp_Object found, efound, hist_file_name;
+  /* The compiled-object cache for the file and its key, or nil.  */
+  Lisp_Object cache = Qnil, cache_key = Qnil;
+  /* True means we are recording the file's code into CACHE.  */
+  bool cache_record = false;
   /* True means we printed the ".el is newer" message.  */
   bool newer = 0;
   /* True means we are loading a compiled file.  */
@@ -1224,6 +1772,57 @@ Return t if the file exists and loads successfully.  */)
                                Ffile_name_nondirectory (found))
                     : found) ;
 
+  /* Run the file's code from its compiled-object cache if that is up
+     to date; otherwise arrange to write the cache while loading.  */
+  if (fd >= 0 && !NILP (Vload_prefer_compiled_cache) && NILP (Vpurify_flag))
+    cache = load_cache_file_name (found);
+  if (!NILP (cache))
+    {
+      Lisp_Object thunks;
+
+      load_cache_init ();
+      cache_key = load_cache_key (fd);
+      if (NILP (cache_key))
+	cache = Qnil;
+      else if (load_cache_read (cache, cache_key, &thunks))
+	{
+	  struct timespec start = current_timespec ();
+
+	  if (NILP (nomessage) || force_load_messages)
+	    message_with_string ("Loading %s (cached)...", file, 1);
+
+	  specbind (Qload_file_name, found);
+	  specbind (Qinhibit_file_name_operation, Qnil);
+	  specbind (Qload_in_progress, Qt);
+	  load_cache_run (thunks, hist_file_name);
+	  dynwind_end ();
+
+	  load_cache_hits++;
+	  load_cache_run_time
+	    = timespec_add (load_cache_run_time,
+			    timespec_sub (current_timespec (), start));
+
+	  if (!NILP (Ffboundp (Qdo_after_load_evaluation)))
+	    call1 (Qdo_after_load_evaluation, hist_file_name);
+
+	  if (!noninteractive && (NILP (nomessage) || force_load_messages))
+	    message_with_string ("Loading %s (cached)...done", file, 1);
+	  return Qt;
+	}
+      else if (EQ (Vload_prefer_compiled_cache, Qt))
+	{
+	  record_unwind_protect (load_cache_unwind,
+				 list4 (load_cache_source, load_cache_objects,
+					load_cache_macros, load_cache_deps));
+	  load_cache_source = hist_file_name;
+	  load_cache_objects = Qnil;
+	  load_cache_macros = Qnil;
+	  load_cache_deps = Qnil;
+	  load_cache_misses++;
+	  cache_record = true;
+	}
+    }
+
   version = -1;
 
   /* Check for the presence of old-style quotes and warn about them.  */
@@ -1307,6 +1906,8 @@ Return t if the file exists and loads successfully.  */)
 	  val = call4 (Vload_source_file_function, found, hist_file_name,
 		       NILP (noerror) ? Qnil : Qt,
 		       (NILP (nomessage) || force_load_messages) ? Qnil : Qt);
+	  if (cache_record && !NILP (val))
+	    load_cache_finish (cache, cache_key);
 	  dynwind_end ();
 	  return val;
 	}
@@ -1372,6 +1973,8 @@ Return t if the file exists and loads successfully.  */)
       readevalloop (Qget_emacs_mule_file_char, stream, hist_file_name,
 		    0, Qnil, Qnil, Qnil, Qnil);
     }
+  if (cache_record)
+    load_cache_finish (cache, cache_key);
   dynwind_end ();
 
   /* Run any eval-after-load forms for this file.  */
@@ -1435,6 +2038,110 @@ directories, make sure the PREDICATE function returns `dir-ok' for them.  */)
 
 static Lisp_Object Qdir_ok;
 
+/* The names of the files in directories that openp searched, so that
+   it can tell that a file is not in a directory without trying to
+   open it with each suffix in turn.  The table maps the encoded name
+   of a directory to a cons whose car lists the directory's
+   modification time, inode and device numbers when it was read, and
+   whose cdr is a hash table of the names in it.  An entry is used only while the directory has the
+   same time stamp, inode and device.  */
+static Lisp_Object load_dir_indexes;
+
+#if !defined DOS_NT && !defined DARWIN_OS && !defined CYGWIN
+/* File names are compared exactly, which a file system that folds
+   case or normalizes names would not do.  */
+# define LOAD_DIR_INDEX
+#endif
+
+/* Return the hash table of the names in the directory of the file
+   PFN, a file name with no handler, or nil if the directory's names
+   are not known, so that files in it must be tried.  */
+
+static Lisp_Object
+load_dir_index (char const *pfn)
+{
+#ifdef LOAD_DIR_INDEX
+  char const *slash = strrchr (pfn, '/');
+  char *dir;
+  struct stat st;
+  Lisp_Object key, entry, stamp, names;
+  struct Lisp_Hash_Table *h;
+  EMACS_UINT hash;
+  ptrdiff_t i;
+  DIR *d;
+
+  if (! load_path_index || ! slash)
+    return Qnil;
+  dir = alloca (slash - pfn + 2);
+  memcpy (dir, pfn, slash - pfn + 1);
+  dir[slash - pfn + 1] = 0;
+
+  if (stat (dir, &st) != 0 || ! S_ISDIR (st.st_mode))
+    return Qnil;
+  stamp = list3 (make_lisp_time (get_stat_mtime (&st)),
+		 INTEGER_TO_CONS (st.st_ino), INTEGER_TO_CONS (st.st_dev));
+
+  if (NILP (load_dir_indexes))
+    load_dir_indexes
+      = make_hash_table (hashtest_equal, make_number (DEFAULT_HASH_SIZE),
+			 make_float (DEFAULT_REHASH_SIZE),
+			 make_float (DEFAULT_REHASH_THRESHOLD), Qnil);
+  h = XHASH_TABLE (load_dir_indexes);
+  key = build_unibyte_string (dir);
+  i = hash_lookup (h, key, &hash);
+  if (i >= 0)
+    {
+      entry = HASH_VALUE (h, i);
+      if (! NILP (Fequal (XCAR (entry), stamp)))
+	return XCDR (entry);
+      hash_remove_from_table (h, key);
+      i = hash_lookup (h, key, &hash);
+    }
+
+  /* A directory changed twice within the resolution of its time stamp
+     can keep the same time stamp, so trust only one that is safely in
+     the past.  */
+  if (timespec_cmp (get_stat_mtime (&st),
+		    timespec_sub (current_timespec (), make_timespec (2, 0)))
+      >= 0)
+    return Qnil;
+
+  block_input ();
+  d = opendir (dir);
+  unblock_input ();
+  if (! d)
+    return Qnil;
+  names = make_hash_table (hashtest_equal, make_number (DEFAULT_HASH_SIZE),
+			   make_float (DEFAULT_REHASH_SIZE),
+			   make_float (DEFAULT_REHASH_THRESHOLD), Qnil);
+  for (;;)
+    {
+      struct dirent *dp;
+
+      errno = 0;
+      dp = readdir (d);
+      if (! dp)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  break;
+	}
+      Fputhash (build_unibyte_string (dp->d_name), Qt, names);
+    }
+  if (errno)
+    names = Qnil;
+  block_input ();
+  closedir (d);
+  unblock_input ();
+
+  if (HASH_TABLE_P (names))
+    hash_put (h, key, Fcons (stamp, names), hash);
+  return names;
+#else
+  return Qnil;
+#endif
+}
+
 /* Search for a file whose name is STR, looking in directories
    in the Lisp list PATH, and trying suffixes from SUFFIX.
    On success, return a file descriptor (or 1 or -2 as described below).
@@ -1499,6 +2206,9 @@ openp (Lisp_Object path, Lisp_Object str, Lisp_Object suffixes,
 
   for (; CONSP (path); path = XCDR (path))
     {
+      Lisp_Object index = Qnil;
+      bool index_looked_up = false;
+
       filename = Fexpand_file_name (str, XCAR (path));
       if (!complete_filename_p (filename))
 	/* If there are non-absolute elts in PATH (eg ".").  */
@@ -1594,8 +2304,22 @@ openp (Lisp_Object path, Lisp_Object str, Lisp_Object suffixes,
 	      encoded_fn = ENCODE_FILE (string);
 	      pfn = SSDATA (encoded_fn);
 
+	      /* Suffixes without a slash do not change the directory, so
+		 its index serves them all.  */
+	      bool indexed = ! memchr (SDATA (suffix), '/', lsuffix);
+	      if (indexed && ! index_looked_up)
+		{
+		  index = load_dir_index (pfn);
+		  index_looked_up = true;
+		}
+
 	      /* Check that we can access or open it.  */
-	      if (NATNUMP (predicate))
+	      if (indexed && HASH_TABLE_P (index)
+		  && NILP (Fgethash (build_unibyte_string
+				     (strrchr (pfn, '/') + 1),
+				     index, Qnil)))
+		fd = -1;
+	      else if (NATNUMP (predicate))
 		{
 		  fd = -1;
 		  if (INT_MAX < XFASTINT (predicate))
@@ -1678,6 +2402,35 @@ openp (Lisp_Object path, Lisp_Object str, Lisp_Object suffixes,
 }
 
 
+/* The file names that have entries in load-history, as a hash table
+   mapping each to t, and the value of load-history it was made from.
+   Lisp code that changes load-history usually sets it to a new list,
+   which makes the table be made again; a name whose entry was deleted
+   in place is only a false alarm, which build_load_history checks.  */
+static Lisp_Object load_history_index, load_history_indexed;
+
+/* Return true if load-history may have an entry for FILENAME.  */
+
+static bool
+load_history_has (Lisp_Object filename)
+{
+  Lisp_Object tail;
+
+  if (NILP (load_history_index))
+    load_history_index
+      = make_hash_table (hashtest_equal, make_number (DEFAULT_HASH_SIZE),
+			 make_float (DEFAULT_REHASH_SIZE),
+			 make_float (DEFAULT_REHASH_THRESHOLD), Qnil);
+  if (!EQ (load_history_indexed, Vload_history))
+    {
+      Fclrhash (load_history_index);
+      for (tail = Vload_history; CONSP (tail); tail = XCDR (tail))
+	Fputhash (Fcar (XCAR (tail)), Qt, load_history_index);
+      load_history_indexed = Vload_history;
+    }
+  return hash_lookup (XHASH_TABLE (load_history_index), filename, NULL) >= 0;
+}
+
 /* Merge the list we've accumulated of globals from the current input source
    into the load_history variable.  The details depend on whether
    the source has an associated file name or not.
@@ -1694,7 +2447,9 @@ build_load_history (Lisp_Object filename, bool entire)
   Lisp_Object tem, tem2;
   bool foundit = 0;
 
-  tail = Vload_history;
+  /* Usually FILENAME is being loaded for the first time, and there is
+     no entry to look for.  */
+  tail = load_history_has (filename) ? Vload_history : Qnil;
   prev = Qnil;
 
   while (CONSP (tail))
@@ -1745,6 +2500,9 @@ build_load_history (Lisp_Object filename, bool entire)
   if (entire || !foundit)
     Vload_history = Fcons (Fnreverse (Vcurrent_load_list),
 			   Vload_history);
+
+  Fputhash (filename, Qt, load_history_index);
+  load_history_indexed = Vload_history;
 }
 
 static void
@@ -1814,7 +2572,8 @@ readevalloop (Lisp_Object readcharfun,
   bool whole_buffer = 0;
   /* True on the first time around.  */
   bool first_sexp = 1;
-  Lisp_Object compile_fn = 0;
+  /* True if recording the forms into the compiled-object cache.  */
+  bool cache_forms = false;
 
   if (MARKERP (readcharfun))
     {
@@ -1846,6 +2605,15 @@ readevalloop (Lisp_Object readcharfun,
 
   GCPRO4 (sourcename, readfun, start, end);
 
+  if (!NILP (load_cache_source) && !NILP (sourcename)
+      && !NILP (Fequal (sourcename, load_cache_source)))
+    {
+      /* This is the file `load' wants to cache.  Claim it, so that
+	 nested reads of other text don't get recorded too.  */
+      cache_forms = true;
+      load_cache_source = Qnil;
+    }
+
   /* Try to ensure sourcename is a truename, except whilst preloading.  */
   if (NILP (Vpurify_flag)
       && !NILP (sourcename) && !NILP (Ffile_name_absolute_p (sourcename))
@@ -1943,7 +2711,7 @@ readevalloop (Lisp_Object readcharfun,
       /* Restore saved point and BEGV.  */
       dynwind_end ();
 
-      val = eval_sub (val);
+      val = cache_forms ? load_cache_eval (val) : eval_sub (val);
 
       if (printflag)
 	{
@@ -2139,7 +2907,10 @@ read_internal_start (Lisp_Object stream, Lisp_Object start, Lisp_Object end)
       read_from_string_limit = endval;
     }
 
+  dynwind_begin ();
+  record_unwind_protect_ptr (read_stack_unwind, (void *) read_stack_top);
   retval = read0 (stream);
+  dynwind_end ();
   if (EQ (Vread_with_symbol_positions, Qt)
       || EQ (Vread_with_symbol_positions, stream))
     Vread_symbol_positions_list = Fnreverse (Vread_symbol_positions_list);
@@ -2177,6 +2948,31 @@ read0 (Lisp_Object readcharfun)
 static ptrdiff_t read_buffer_size;
 static char *read_buffer;
 
+/* Elements of the vectors being read, innermost vector last.
+   read_vector pushes each element here rather than consing a
+   temporary list, and pops them once the vector has been built.  */
+
+static Lisp_Object *read_stack;
+static ptrdiff_t read_stack_size;
+static ptrdiff_t read_stack_top;
+
+static void
+read_stack_push (Lisp_Object obj)
+{
+  if (read_stack_top == read_stack_size)
+    read_stack = xpalloc (read_stack, &read_stack_size, 1, -1,
+			  sizeof *read_stack);
+  read_stack[read_stack_top++] = obj;
+}
+
+/* Drop whatever a non-local exit out of the reader left on the stack.  */
+
+static void
+read_stack_unwind (void *top)
+{
+  read_stack_top = (ptrdiff_t) top;
+}
+
 /* Read a \-escape sequence, assuming we already read the `\'.
    If the escape sequence forces unibyte, return eight-bit char.  */
 
@@ -3214,11 +4010,29 @@ read1 (Lisp_Object readcharfun, int *pch, bool first_in_list)
 					  nbytes)
 	       : nbytes);
 
-	  name = ((uninterned_symbol && ! NILP (Vpurify_flag)
-		   ? make_pure_string : make_specified_string)
-		  (read_buffer, nchars, nbytes, multibyte));
-	  result = (uninterned_symbol ? Fmake_symbol (name)
-		    : Fintern (name, Qnil));
+	  if (uninterned_symbol)
+	    {
+	      name = (! NILP (Vpurify_flag)
+		      ? make_pure_string : make_specified_string)
+		(read_buffer, nchars, nbytes, multibyte);
+	      result = Fmake_symbol (name);
+	    }
+	  else
+	    {
+	      /* Don't create the string object for the name unless
+		 we're going to retain it in a new symbol.  */
+	      Lisp_Object obarray = check_obarray (Vobarray);
+	      Lisp_Object tem = oblookup (obarray, read_buffer,
+					  nchars, nbytes);
+	      if (SYMBOLP (tem))
+		result = tem;
+	      else
+		{
+		  name = make_specified_string (read_buffer, nchars, nbytes,
+						multibyte);
+		  result = Fintern (name, obarray);
+		}
+	    }
 
 	  if (EQ (Vread_with_symbol_positions, Qt)
 	      || EQ (Vread_with_symbol_positions, readcharfun))
@@ -3512,19 +4326,30 @@ static Lisp_Object
 read_vector (Lisp_Object readcharfun, bool bytecodeflag)
 {
   ptrdiff_t i, size;
+  ptrdiff_t base = read_stack_top;
   Lisp_Object *ptr;
-  Lisp_Object tem, item, vector;
-  Lisp_Object len;
+  Lisp_Object item, vector;
 
-  tem = read_list (1, readcharfun);
-  len = Flength (tem);
-  vector = Fmake_vector (len, Qnil);
+  while (1)
+    {
+      int ch;
 
-  size = ASIZE (vector);
+      item = read1 (readcharfun, &ch, 0);
+      if (ch == ']')
+	break;
+      if (ch)
+	invalid_syntax (") or . in a vector");
+      read_stack_push (relocate_load_file_name (item));
+    }
+
+  size = read_stack_top - base;
+  vector = Fmake_vector (make_number (size), Qnil);
   ptr = XVECTOR (vector)->contents;
   for (i = 0; i < size; i++)
     {
-      item = Fcar (tem);
+      /* Fetch through read_stack each time, since the Fread below
+	 may reallocate it.  */
+      item = read_stack[base + i];
       /* If `load-force-doc-strings' is t when reading a lazily-loaded
 	 bytecode object, the docstring containing the bytecode and
 	 constants values must be treated as unibyte and passed to
@@ -3576,11 +4401,29 @@ read_vector (Lisp_Object readcharfun, bool bytecodeflag)
 	    }
 	}
       ASET (vector, i, item);
-      tem = Fcdr (tem);
     }
+  read_stack_top = base;
   return vector;
 }
 
+/* If ELT is #$ read while building and Snarf-documentation has
+   already been called, return a relative file name for the file
+   being loaded, so it can be found properly in the installed Lisp
+   directory.  We don't use Fexpand_file_name because that would make
+   the directory absolute now.  Otherwise return ELT.  */
+
+static Lisp_Object
+relocate_load_file_name (Lisp_Object elt)
+{
+  if (EQ (elt, Vload_file_name)
+      && ! NILP (elt)
+      && !NILP (Vpurify_flag)
+      && !NILP (Vdoc_file_name))
+    return concat2 (build_string ("../lisp/"),
+		    Ffile_name_nondirectory (elt));
+  return elt;
+}
+
 /* FLAG means check for ']' to terminate rather than ')' and '.'.  */
 
 static Lisp_Object
@@ -3621,13 +4464,7 @@ read_list (bool flag, Lisp_Object readcharfun)
 	       For now, replace the whole list with 0.  */
 	    doc_reference = 1;
 	  else
-	    /* We have already called Snarf-documentation, so make a relative
-	       file name for this file, so it can be found properly
-	       in the installed Lisp directory.
-	       We don't use Fexpand_file_name because that would make
-	       the directory absolute now.  */
-	    elt = concat2 (build_string ("../lisp/"),
-			 Ffile_name_nondirectory (elt));
+	    elt = relocate_load_file_name (elt);
 	}
       else if (EQ (elt, Vload_file_name)
 	       && ! NILP (elt)
@@ -3761,40 +4598,155 @@ check_obarray (Lisp_Object obarray)
   return obarray;
 }
 
+/* A cache of the symbols found in obarrays, keyed on the bytes of
+   their names, so that looking up an existing symbol does not need a
+   Guile string to be made for its name first.  It is an open-addressing
+   table with linear probing.  Entries are only ever added; the whole
+   cache is flushed when a symbol is uninterned.  */
+
+struct obcache_entry
+{
+  /* The Guile obarray (see `obhash') SYMBOL is interned in, or 0 if
+     this entry is empty.  */
+  Lisp_Object obhash;
+  Lisp_Object symbol;
+  EMACS_UINT hash;
+  ptrdiff_t nbytes;
+  char *name;
+};
+
+static struct obcache_entry *obcache;
+static ptrdiff_t obcache_size;
+static ptrdiff_t obcache_count;
+
+enum { OBCACHE_INITIAL_SIZE = 4096 };
+
+static struct obcache_entry *
+obcache_probe (struct obcache_entry *table, ptrdiff_t size,
+               Lisp_Object ob, const char *ptr, ptrdiff_t nbytes,
+               EMACS_UINT hash)
+{
+  ptrdiff_t i = hash & (size - 1);
+
+  for (;; i = (i + 1) & (size - 1))
+    {
+      struct obcache_entry *e = &table[i];
+      if (! e->obhash
+          || (e->hash == hash && e->nbytes == nbytes && EQ (e->obhash, ob)
+              && memcmp (e->name, ptr, nbytes) == 0))
+        return e;
+    }
+}
+
+static void
+obcache_add (Lisp_Object ob, const char *ptr, ptrdiff_t nbytes,
+             EMACS_UINT hash, Lisp_Object symbol)
+{
+  struct obcache_entry *e;
+
+  if (2 * (obcache_count + 1) > obcache_size)
+    {
+      ptrdiff_t old_size = obcache_size, i;
+      struct obcache_entry *old = obcache;
+
+      obcache_size = old_size ? 2 * old_size : OBCACHE_INITIAL_SIZE;
+      obcache = xnmalloc (obcache_size, sizeof *obcache);
+      memset (obcache, 0, obcache_size * sizeof *obcache);
+      for (i = 0; i < old_size; i++)
+        if (old[i].obhash)
+          *obcache_probe (obcache, obcache_size, old[i].obhash,
+                          old[i].name, old[i].nbytes, old[i].hash)
+            = old[i];
+    }
+
+  e = obcache_probe (obcache, obcache_size, ob, ptr, nbytes, hash);
+  if (! e->obhash)
+    {
+      e->obhash = ob;
+      e->hash = hash;
+      e->nbytes = nbytes;
+      e->name = xmalloc_atomic (nbytes + 1);
+      memcpy (e->name, ptr, nbytes);
+      e->name[nbytes] = '\0';
+      obcache_count++;
+    }
+  e->symbol = symbol;
+}
+
+static void
+obcache_flush (void)
+{
+  if (obcache)
+    memset (obcache, 0, obcache_size * sizeof *obcache);
+  obcache_count = 0;
+}
+
+/* Return the symbol in OBARRAY whose name is the SIZE_BYTE bytes at
+   PTR (SIZE characters).  If there is none, return an integer.  The
+   usual case of an existing symbol allocates nothing.  */
+
+Lisp_Object
+oblookup (Lisp_Object obarray, const char *ptr, ptrdiff_t size,
+          ptrdiff_t size_byte)
+{
+  Lisp_Object ob = obhash (obarray);
+  EMACS_UINT hash = hash_string (ptr, size_byte);
+  Lisp_Object tem;
+
+  if (obcache)
+    {
+      struct obcache_entry *e
+        = obcache_probe (obcache, obcache_size, ob, ptr, size_byte, hash);
+      if (e->obhash)
+        return e->symbol;
+    }
+
+  tem = scm_find_symbol (scm_from_utf8_stringn (ptr, size_byte), ob);
+  if (scm_is_false (tem))
+    return make_number (0);
+  if (EQ (tem, Qnil_))
+    tem = Qnil;
+  else if (EQ (tem, Qt_))
+    tem = Qt;
+  obcache_add (ob, ptr, size_byte, hash, tem);
+  return tem;
+}
+
 /* Intern the C string STR: return a symbol with that name,
    interned in the current obarray.  */
 
 Lisp_Object
 intern_1 (const char *str, ptrdiff_t len)
 {
-  return Fintern (make_string (str, len), Qnil);
+  Lisp_Object obarray = check_obarray (Vobarray);
+  Lisp_Object tem = oblookup (obarray, str, len, len);
+
+  return SYMBOLP (tem) ? tem : Fintern (make_string (str, len), obarray);
 }
 
 Lisp_Object
 intern_c_string_1 (const char *str, ptrdiff_t len)
 {
-  return Fintern (make_pure_c_string (str, len), Qnil);
+  Lisp_Object obarray = check_obarray (Vobarray);
+  Lisp_Object tem = oblookup (obarray, str, len, len);
+
+  if (SYMBOLP (tem))
+    return tem;
+  return Fintern (make_pure_c_string (str, len), obarray);
 }
-
+
 DEFUN ("find-symbol", Ffind_symbol, Sfind_symbol, 1, 2, 0,
        doc: /* find-symbol */)
      (Lisp_Object string, Lisp_Object obarray)
 {
-  Lisp_Object tem, sstring, found;
+  Lisp_Object tem;
 
   obarray = check_obarray (NILP (obarray) ? Vobarray : obarray);
   CHECK_STRING (string);
 
-  sstring = scm_from_utf8_stringn (SSDATA (string), SBYTES (string));
-  tem = scm_find_symbol (sstring, obhash (obarray));
-  if (scm_is_true (tem))
-    {
-      if (EQ (tem, Qnil_))
-        tem = Qnil;
-      else if (EQ (tem, Qt_))
-        tem = Qt;
-      return scm_values (scm_list_2 (tem, Qt));
-    }
+  tem = oblookup (obarray, SSDATA (string), SCHARS (string), SBYTES (string));
+  if (SYMBOLP (tem))
+    return scm_values (scm_list_2 (tem, Qt));
   else
     return scm_values (scm_list_2 (Qnil, Qnil));
 }
@@ -3806,20 +4758,22 @@ A second optional argument specifies the obarray to use;
 it defaults to the value of `obarray'.  */)
   (Lisp_Object string, Lisp_Object obarray)
 {
-  register Lisp_Object tem, sym, *ptr;
+  register Lisp_Object tem, sym;
 
   if (NILP (obarray)) obarray = Vobarray;
   obarray = check_obarray (obarray);
 
   CHECK_STRING (string);
 
-  tem = Ffind_symbol (string, obarray);
-  if (! NILP (scm_c_value_ref (tem, 1)))
-    return scm_c_value_ref (tem, 0);
+  tem = oblookup (obarray, SSDATA (string), SCHARS (string), SBYTES (string));
+  if (SYMBOLP (tem))
+    return tem;
 
   sym = scm_intern (scm_from_utf8_stringn (SSDATA (string),
                                            SBYTES (string)),
                     obhash (obarray));
+  obcache_add (obhash (obarray), SSDATA (string), SBYTES (string),
+               hash_string (SSDATA (string), SBYTES (string)), sym);
 
   if ((SREF (string, 0) == ':')
       && EQ (obarray, initial_obarray))
@@ -3884,7 +4838,10 @@ usage: (unintern NAME OBARRAY)  */)
       
     }
 
-  return (scm_is_true (scm_unintern (name, obhash (obarray))) ? Qt : Qnil);
+  if (scm_is_false (scm_unintern (name, obhash (obarray))))
+    return Qnil;
+  obcache_flush ();
+  return Qt;
 }
 
 struct map_obarray_data
@@ -3966,6 +4923,11 @@ init_obarray (void)
   SET_SYMBOL_CONSTANT (XSYMBOL (Qt_), 1);
   SET_SYMBOL_DECLARED_SPECIAL (XSYMBOL (Qt_), 1);
 
+  /* The lookup cache recorded the raw symbols `nil' and `t' above,
+     before Qnil_ and Qt_ were known; start over so that oblookup maps
+     them to Qnil and Qt.  */
+  obcache_flush ();
+
   Qunbound = scm_c_public_ref ("language elisp runtime", "unbound");
   SET_SYMBOL_VAL (XSYMBOL (Qunbound), Qunbound);
 
@@ -3986,7 +4948,7 @@ defsubr (const char *lname, scm_t_subr gsubr_fn, short min_args, short max_args,
   switch (max_args)
     {
     case MANY:
-      fn = scm_c_make_gsubr (lname, 0, 0, 1, gsubr_fn);
+      fn = scm_c_make_gsubr (lname, 0, GSUBR_MANY_INLINE_ARGS, 1, gsubr_fn);
       break;
     case UNEVALLED:
       fn = Fcons (Qspecial_operator,
@@ -4587,6 +5549,33 @@ variables, this must be set in the first line of a file.  */);
   Vold_style_backquotes = Qnil;
   DEFSYM (Qold_style_backquotes, "old-style-backquotes");
 
+  DEFVAR_LISP ("load-prefer-compiled-cache", Vload_prefer_compiled_cache,
+	       doc: /* Non-nil means `load' uses cached compiled code for Lisp files.
+Loading a file FOO.el or FOO.elc then looks for a cache file FOO.go
+\(see `load-compiled-cache-directory') holding the Guile code that the
+file's forms compiled to.  If the cache was made from the same
+contents of the file, by the same versions of Emacs and Guile, `load'
+runs the cached code instead of reading and compiling the file again.
+
+If the value is t, `load' also writes the cache for a file that has
+none, or an out-of-date one, after loading it.  Any other non-nil
+value means use existing caches but never write them.  Caches are
+not used while dumping Emacs.  */);
+  Vload_prefer_compiled_cache = Qt;
+
+  DEFVAR_LISP ("load-compiled-cache-directory", Vload_compiled_cache_directory,
+	       doc: /* Directory for the cache files of `load-prefer-compiled-cache'.
+If nil, the cache file for FOO.el or FOO.elc is FOO.go in the same
+directory.  If a directory name, cache files go there instead, named
+after the absolute name of the file, as for backup files.  */);
+  Vload_compiled_cache_directory = Qnil;
+
+  load_cache_source = Qnil;
+  load_cache_objects = Qnil;
+  load_cache_macros = Qnil;
+  load_cache_deps = Qnil;
+  load_cache_digests = Qnil;
+
   DEFVAR_BOOL ("load-prefer-newer", load_prefer_newer,
                doc: /* Non-nil means `load' prefers the newest version of a file.
 This applies when a filename suffix is not explicitly specified and
@@ -4622,6 +5611,8 @@ that are loaded before your customizations are read!  */);
   DEFSYM (Qfile_truename, "file-truename");
   DEFSYM (Qdir_ok, "dir-ok");
   DEFSYM (Qdo_after_load_evaluation, "do-after-load-evaluation");
+  DEFSYM (Qsymbol_file, "symbol-file");
+  DEFSYM (Qdefun, "defun");
 
   staticpro (&read_objects);
   read_objects = Qnil;
@@ -4631,6 +5622,21 @@ that are loaded before your customizations are read!  */);
   Vloads_in_progress = Qnil;
   staticpro (&Vloads_in_progress);
 
+  DEFVAR_BOOL ("load-path-index", load_path_index,
+	       doc: /* Non-nil means remember the files in directories searched for files.
+`load' and `locate-file' then look in a directory that has not changed
+since it was last searched without trying to open each candidate file
+in it.  Set this to nil if the directories searched are on a file
+system whose directory modification times cannot be trusted.  */);
+  load_path_index = 1;
+
+  load_dir_indexes = Qnil;
+  staticpro (&load_dir_indexes);
+  load_history_index = Qnil;
+  staticpro (&load_history_index);
+  load_history_indexed = Qnil;
+  staticpro (&load_history_indexed);
+
   DEFSYM (Qhash_table, "hash-table");
   DEFSYM (Qdata, "data");
   DEFSYM (Qtest, "test");
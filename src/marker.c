@@ -74,6 +74,122 @@ clear_charpos_cache (struct buffer *b)
 {
   if (cached_buffer == b)
     cached_buffer = 0;
+  if (b->text)
+    b->text->pos_index_valid = 0;
+}
+
+/* The position index.
+
+   For multibyte text, each buffer_text keeps a list of known
+   character/byte position pairs, one about every POS_INDEX_INTERVAL
+   bytes from the beginning.  Entries are added on demand, in order,
+   by scanning forward from the last one; a change to the text
+   discards the entries after the change.  A conversion that the index
+   covers then needs at most one interval of scanning, however many
+   markers the buffer has.  */
+
+enum { POS_INDEX_INTERVAL = 4096 };
+
+/* Discard the entries of B's position index that come after byte
+   position BYTEPOS, where the text is about to change.  */
+
+void
+truncate_pos_index (struct buffer *b, ptrdiff_t bytepos)
+{
+  struct buffer_text *t = b->text;
+  ptrdiff_t lo = 0, hi = t->pos_index_valid;
+
+  while (lo < hi)
+    {
+      ptrdiff_t mid = lo + (hi - lo) / 2;
+      if (t->pos_index[mid].bytepos <= bytepos)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  t->pos_index_valid = lo;
+}
+
+/* Return the number of characters that start between byte positions
+   FROM and TO of B.  */
+
+static ptrdiff_t
+count_char_heads (struct buffer *b, ptrdiff_t from, ptrdiff_t to)
+{
+  ptrdiff_t n = 0;
+
+  while (from < to)
+    {
+      ptrdiff_t end = (from < BUF_GPT_BYTE (b)
+		       ? min (to, BUF_GPT_BYTE (b)) : to);
+      unsigned char *p = BUF_BYTE_ADDRESS (b, from);
+      unsigned char *pend = p + (end - from);
+
+      for (; p < pend; p++)
+	n += CHAR_HEAD_P (*p);
+      from = end;
+    }
+  return n;
+}
+
+/* Return the last position B's position index knows about.  */
+
+static struct pos_index_entry
+pos_index_end (struct buffer *b)
+{
+  struct buffer_text *t = b->text;
+
+  if (t->pos_index_valid)
+    return t->pos_index[t->pos_index_valid - 1];
+  return (struct pos_index_entry) { BUF_BEG (b), BUF_BEG_BYTE (b) };
+}
+
+/* Add entries to B's position index until it reaches character
+   position CHARPOS or byte position BYTEPOS, or the end of the text.  */
+
+static void
+extend_pos_index (struct buffer *b, ptrdiff_t charpos, ptrdiff_t bytepos)
+{
+  struct buffer_text *t = b->text;
+  struct pos_index_entry last = pos_index_end (b);
+
+  while (last.charpos < charpos && last.bytepos < bytepos
+	 && last.bytepos < BUF_Z_BYTE (b))
+    {
+      ptrdiff_t next = min (last.bytepos + POS_INDEX_INTERVAL,
+			    BUF_Z_BYTE (b));
+
+      while (next < BUF_Z_BYTE (b) && !CHAR_HEAD_P (BUF_FETCH_BYTE (b, next)))
+	next++;
+      last.charpos += count_char_heads (b, last.bytepos, next);
+      last.bytepos = next;
+      if (t->pos_index_valid == t->pos_index_size)
+	t->pos_index = xpalloc (t->pos_index, &t->pos_index_size, 1, -1,
+				sizeof *t->pos_index);
+      t->pos_index[t->pos_index_valid++] = last;
+    }
+}
+
+/* Return the index of the last entry of B's position index whose
+   character position (if BYTE is false) or byte position (if BYTE is
+   true) is at most POS, or -1 if there is none.  */
+
+static ptrdiff_t
+pos_index_search (struct buffer *b, ptrdiff_t pos, bool byte)
+{
+  struct buffer_text *t = b->text;
+  ptrdiff_t lo = 0, hi = t->pos_index_valid;
+
+  while (lo < hi)
+    {
+      ptrdiff_t mid = lo + (hi - lo) / 2;
+      if ((byte ? t->pos_index[mid].bytepos : t->pos_index[mid].charpos)
+	  <= pos)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo - 1;
 }
 
 /* Converting between character positions and byte positions.  */
@@ -173,16 +289,33 @@ buf_charpos_to_bytepos (struct buffer *b, ptrdiff_t charpos)
   if (b == cached_buffer && BUF_MODIFF (b) == cached_modiff)
     CONSIDER (cached_charpos, cached_bytepos);
 
-  for (tail = BUF_MARKERS (b); tail; tail = tail->next)
+  /* Use the position index if it already reaches CHARPOS, or if
+     extending it costs no more than the scan below would.  */
+  if (charpos - pos_index_end (b).charpos
+      < min (charpos - best_below, best_above - charpos))
     {
-      CONSIDER (tail->charpos, tail->bytepos);
-
-      /* If we are down to a range of 50 chars,
-	 don't bother checking any other markers;
-	 scan the intervening chars directly now.  */
-      if (best_above - best_below < 50)
-	break;
+      struct pos_index_entry *index;
+      ptrdiff_t i;
+
+      extend_pos_index (b, charpos, PTRDIFF_MAX);
+      index = b->text->pos_index;
+      i = pos_index_search (b, charpos, false);
+      if (i >= 0)
+	CONSIDER (index[i].charpos, index[i].bytepos);
+      if (i + 1 < b->text->pos_index_valid)
+	CONSIDER (index[i + 1].charpos, index[i + 1].bytepos);
     }
+  else
+    for (tail = BUF_MARKERS (b); tail; tail = tail->next)
+      {
+	CONSIDER (tail->charpos, tail->bytepos);
+
+	/* If we are down to a range of 50 chars,
+	   don't bother checking any other markers;
+	   scan the intervening chars directly now.  */
+	if (best_above - best_below < 50)
+	  break;
+      }
 
   /* We get here if we did not exactly hit one of the known places.
      We have one known above and one known below.
@@ -316,16 +449,36 @@ buf_bytepos_to_charpos (struct buffer *b, ptrdiff_t bytepos)
   if (b == cached_buffer && BUF_MODIFF (b) == cached_modiff)
     CONSIDER (cached_bytepos, cached_charpos);
 
-  for (tail = BUF_MARKERS (b); tail; tail = tail->next)
+  /* Use the position index if it already reaches BYTEPOS, or if
+     extending it costs no more than the scan below would.  Not while
+     Fset_buffer_multibyte has taken the markers off the buffer, since
+     it is then still converting the text.  */
+  if (BUF_MARKERS (b)
+      && (bytepos - pos_index_end (b).bytepos
+	  < min (bytepos - best_below_byte, best_above_byte - bytepos)))
     {
-      CONSIDER (tail->bytepos, tail->charpos);
-
-      /* If we are down to a range of 50 chars,
-	 don't bother checking any other markers;
-	 scan the intervening chars directly now.  */
-      if (best_above - best_below < 50)
-	break;
+      struct pos_index_entry *index;
+      ptrdiff_t i;
+
+      extend_pos_index (b, PTRDIFF_MAX, bytepos);
+      index = b->text->pos_index;
+      i = pos_index_search (b, bytepos, true);
+      if (i >= 0)
+	CONSIDER (index[i].bytepos, index[i].charpos);
+      if (i + 1 < b->text->pos_index_valid)
+	CONSIDER (index[i + 1].bytepos, index[i + 1].charpos);
     }
+  else
+    for (tail = BUF_MARKERS (b); tail; tail = tail->next)
+      {
+	CONSIDER (tail->bytepos, tail->charpos);
+
+	/* If we are down to a range of 50 chars,
+	   don't bother checking any other markers;
+	   scan the intervening chars directly now.  */
+	if (best_above - best_below < 50)
+	  break;
+      }
 
   /* We get here if we did not exactly hit one of the known places.
      We have one known above and one known below.
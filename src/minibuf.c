@@ -21,6 +21,11 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <config.h>
 #include <errno.h>
 #include <stdio.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
 
 #include "lisp.h"
 #include "commands.h"
@@ -1221,6 +1226,895 @@ See also `completing-read-function'.  */)
   return Ffuncall (9, args);
 }
 
+/* Basic completion.  The candidates of a collection are scanned
+   directly, without calling Lisp for each one unless there is a
+   predicate.  */
+
+enum completion_type
+  {
+    COMPLETION_LIST,
+    COMPLETION_OBARRAY,
+    COMPLETION_HASH_TABLE,
+    COMPLETION_FUNCTION
+  };
+
+static enum completion_type
+completion_type (Lisp_Object collection)
+{
+  if (HASH_TABLE_P (collection))
+    return COMPLETION_HASH_TABLE;
+  if (VECTORP (collection))
+    return COMPLETION_OBARRAY;
+  if (NILP (collection) || (CONSP (collection) && !FUNCTIONP (collection)))
+    return COMPLETION_LIST;
+  return COMPLETION_FUNCTION;
+}
+
+/* The state of a scan for `try-completion' or `all-completions'.  */
+
+struct completion_scan
+{
+  Lisp_Object string, predicate;
+  enum completion_type type;
+
+  /* True for `all-completions', false for `try-completion'.  */
+  bool all;
+
+  /* For `all-completions': whether to reject candidates that start
+     with a space, and the matches found so far, most recent first.  */
+  bool hide_spaces;
+  Lisp_Object allmatches;
+
+  /* For `try-completion': the best match so far and the number of
+     characters all matches have in common, and how many matches have
+     been found, counting no more than 2.  */
+  Lisp_Object bestmatch;
+  ptrdiff_t bestmatchsize;
+  int matchcount;
+
+  /* True once `try-completion' has seen enough candidates.  */
+  bool done;
+};
+
+/* Return the length of the common prefix of the first COMPARE
+   characters of strings A and B, in characters, ignoring case if
+   `completion-ignore-case' is non-nil.  */
+
+static ptrdiff_t
+completion_common_prefix (Lisp_Object a, Lisp_Object b, ptrdiff_t compare)
+{
+  Lisp_Object tem;
+
+  if (!completion_ignore_case
+      && STRING_MULTIBYTE (a) == STRING_MULTIBYTE (b))
+    {
+      const unsigned char *p = SDATA (a), *q = SDATA (b);
+      ptrdiff_t i = 0, n = 0;
+
+      if (!STRING_MULTIBYTE (a))
+	{
+	  while (n < compare && p[n] == q[n])
+	    n++;
+	  return n;
+	}
+
+      /* Equal leading bytes give characters of equal length.  */
+      while (n < compare)
+	{
+	  int len = BYTES_BY_CHAR_HEAD (p[i]);
+	  if (memcmp (p + i, q + i, len) != 0)
+	    break;
+	  i += len;
+	  n++;
+	}
+      return n;
+    }
+
+  tem = Fcompare_strings (a, make_number (0), make_number (compare),
+			  b, make_number (0), make_number (compare),
+			  completion_ignore_case ? Qt : Qnil);
+  return EQ (tem, Qt) ? compare : eabs (XINT (tem)) - 1;
+}
+
+/* Return true if STRING is a prefix of ELTSTRING, ignoring case if
+   `completion-ignore-case' is non-nil.  */
+
+static bool
+completion_prefix_p (Lisp_Object string, Lisp_Object eltstring)
+{
+  if (SCHARS (eltstring) < SCHARS (string))
+    return false;
+
+  /* Compare bytes when both strings encode characters the same way.  */
+  if (!completion_ignore_case
+      && (STRING_MULTIBYTE (string) == STRING_MULTIBYTE (eltstring)
+	  || (SCHARS (string) == SBYTES (string)
+	      && SCHARS (eltstring) == SBYTES (eltstring))))
+    return (SBYTES (string) <= SBYTES (eltstring)
+	    && memcmp (SDATA (eltstring), SDATA (string),
+		       SBYTES (string)) == 0);
+
+  return EQ (Fcompare_strings (eltstring, make_number (0),
+			       make_number (SCHARS (string)),
+			       string, make_number (0), Qnil,
+			       completion_ignore_case ? Qt : Qnil),
+	     Qt);
+}
+
+/* Return true if STRING matches every regexp in
+   `completion-regexp-list'.  */
+
+static bool
+completion_regexps_match (Lisp_Object string)
+{
+  Lisp_Object regexps;
+
+  for (regexps = Vcompletion_regexp_list; CONSP (regexps);
+       regexps = XCDR (regexps))
+    if (NILP (Fstring_match (XCAR (regexps), string, make_number (0))))
+      return false;
+  return true;
+}
+
+/* Consider ELT, whose name is ELTSTRING and whose hash table value is
+   VALUE, as a candidate for the scan S.  */
+
+static void
+completion_consider (struct completion_scan *s, Lisp_Object elt,
+		     Lisp_Object eltstring, Lisp_Object value)
+{
+  Lisp_Object string = s->string;
+
+  if (s->done)
+    return;
+  QUIT;
+
+  if (SYMBOLP (eltstring))
+    eltstring = Fsymbol_name (eltstring);
+  if (!STRINGP (eltstring) || !completion_prefix_p (string, eltstring))
+    return;
+
+  /* If HIDE_SPACES, reject alternatives that start with space
+     unless the input starts with space.  */
+  if (s->hide_spaces
+      && SCHARS (eltstring) > 0 && SREF (eltstring, 0) == ' '
+      && !(SCHARS (string) > 0 && SREF (string, 0) == ' '))
+    return;
+
+  if (!completion_regexps_match (eltstring))
+    return;
+
+  /* Ignore this element if there is a predicate and the predicate
+     doesn't like it.  */
+  if (!NILP (s->predicate))
+    {
+      Lisp_Object tem;
+
+      if (EQ (s->predicate, Qcommandp))
+	tem = Fcommandp (elt, Qnil);
+      else if (s->type == COMPLETION_HASH_TABLE)
+	tem = call2 (s->predicate, elt, value);
+      else
+	tem = call1 (s->predicate, elt);
+      if (NILP (tem))
+	return;
+    }
+
+  if (s->all)
+    {
+      s->allmatches = Fcons (eltstring, s->allmatches);
+      return;
+    }
+
+  /* Update computation of how much all possible completions match.  */
+  if (NILP (s->bestmatch))
+    {
+      s->matchcount = 1;
+      s->bestmatch = eltstring;
+      s->bestmatchsize = SCHARS (eltstring);
+    }
+  else
+    {
+      ptrdiff_t compare = min (s->bestmatchsize, SCHARS (eltstring));
+      ptrdiff_t matchsize
+	= completion_common_prefix (s->bestmatch, eltstring, compare);
+
+      if (completion_ignore_case)
+	{
+	  /* If this is an exact match except for case, use it as the
+	     best match rather than one that is not an exact match.
+	     This way, we get the case pattern of the actual match.
+	     If there is more than one exact match ignoring case, and
+	     one of them is exact including case, prefer that one.  If
+	     there is no exact match ignoring case, prefer a match that
+	     does not change the case of the input.  */
+	  bool eltexact = matchsize == SCHARS (eltstring);
+	  bool bestexact = matchsize == SCHARS (s->bestmatch);
+	  Lisp_Object zero = make_number (0);
+	  Lisp_Object len = make_number (SCHARS (string));
+
+	  if ((eltexact && !bestexact)
+	      || (eltexact == bestexact
+		  && EQ (Fcompare_strings (eltstring, zero, len,
+					   string, zero, Qnil, Qnil),
+			 Qt)
+		  && !EQ (Fcompare_strings (s->bestmatch, zero, len,
+					    string, zero, Qnil, Qnil),
+			  Qt)))
+	    s->bestmatch = eltstring;
+	}
+
+      /* Don't count the same string multiple times.  */
+      if ((s->bestmatchsize != SCHARS (eltstring)
+	   || s->bestmatchsize != matchsize)
+	  && s->matchcount <= 1)
+	s->matchcount++;
+      s->bestmatchsize = matchsize;
+
+      /* If completion-ignore-case is non-nil, don't short-circuit
+	 because we want to find the best possible match *including*
+	 case differences.  */
+      if (matchsize <= SCHARS (string)
+	  && !completion_ignore_case
+	  && s->matchcount > 1)
+	s->done = true;
+    }
+}
+
+static void
+completion_consider_symbol (Lisp_Object symbol, Lisp_Object arg)
+{
+  completion_consider (XSAVE_POINTER (arg, 0), symbol, symbol, Qnil);
+}
+
+/* Run the scan S over the candidates in COLLECTION.  */
+
+static void
+completion_scan (struct completion_scan *s, Lisp_Object collection)
+{
+  dynwind_begin ();
+
+  /* The regexps are matched as if by `string-match' with
+     `case-fold-search' bound to `completion-ignore-case'.  Compiled
+     regexps come from the pattern cache, so each is compiled once per
+     scan at most.  */
+  if (CONSP (Vcompletion_regexp_list))
+    specbind (Qcase_fold_search, completion_ignore_case ? Qt : Qnil);
+
+  switch (s->type)
+    {
+    case COMPLETION_LIST:
+      {
+	Lisp_Object tail;
+
+	for (tail = collection; CONSP (tail) && !s->done; tail = XCDR (tail))
+	  {
+	    Lisp_Object elt = XCAR (tail);
+	    completion_consider (s, elt, CONSP (elt) ? XCAR (elt) : elt, Qnil);
+	  }
+      }
+      break;
+
+    case COMPLETION_OBARRAY:
+      map_obarray (check_obarray (collection), completion_consider_symbol,
+		   make_save_ptr (s));
+      break;
+
+    case COMPLETION_HASH_TABLE:
+      {
+	struct Lisp_Hash_Table *h = XHASH_TABLE (collection);
+	ptrdiff_t i;
+
+	for (i = 0; i < HASH_TABLE_SIZE (h) && !s->done; i++)
+	  if (!NILP (HASH_HASH (h, i)))
+	    completion_consider (s, HASH_KEY (h, i), HASH_KEY (h, i),
+				 HASH_VALUE (h, i));
+      }
+      break;
+
+    default:
+      emacs_abort ();
+    }
+
+  dynwind_end ();
+}
+
+/* Return STRING converted to the same representation as BASIS.  */
+
+static Lisp_Object
+minibuf_conform_representation (Lisp_Object string, Lisp_Object basis)
+{
+  if (STRING_MULTIBYTE (string) == STRING_MULTIBYTE (basis))
+    return string;
+  if (STRING_MULTIBYTE (string))
+    return Fstring_make_unibyte (string);
+  return Fstring_make_multibyte (string);
+}
+
+DEFUN ("try-completion", Ftry_completion, Stry_completion, 2, 3, 0,
+       doc: /* Return common substring of all completions of STRING in COLLECTION.
+Test each possible completion specified by COLLECTION
+to see if it begins with STRING.  The possible completions may be
+strings or symbols.  Symbols are converted to strings before testing,
+see `symbol-name'.
+All that match STRING are compared together; the longest initial sequence
+common to all these matches is the return value.
+If there is no match at all, the return value is nil.
+For a unique match which is exact, the return value is t.
+
+If COLLECTION is an alist, the keys (cars of elements) are the
+possible completions.  If an element is not a cons cell, then the
+element itself is the possible completion.
+If COLLECTION is a hash-table, all the keys that are strings or symbols
+are the possible completions.
+If COLLECTION is an obarray, the names of all symbols in the obarray
+are the possible completions.
+
+COLLECTION can also be a function to do the completion itself.
+It receives three arguments: the values STRING, PREDICATE and nil.
+Whatever it returns becomes the value of `try-completion'.
+
+If optional third argument PREDICATE is non-nil,
+it is used to test each possible match.
+The match is a candidate only if PREDICATE returns non-nil.
+The argument given to PREDICATE is the alist element
+or the symbol from the obarray.  If COLLECTION is a hash-table,
+predicate is called with two arguments: the key and the value.
+Additionally to this predicate, `completion-regexp-list'
+is used to further constrain the set of candidates.  */)
+  (Lisp_Object string, Lisp_Object collection, Lisp_Object predicate)
+{
+  struct completion_scan s;
+
+  s.type = completion_type (collection);
+  if (s.type == COMPLETION_FUNCTION)
+    return call3 (collection, string, predicate, Qnil);
+
+  CHECK_STRING (string);
+  s.string = string;
+  s.predicate = predicate;
+  s.all = false;
+  s.hide_spaces = false;
+  s.allmatches = Qnil;
+  s.bestmatch = Qnil;
+  s.bestmatchsize = 0;
+  s.matchcount = 0;
+  s.done = false;
+  completion_scan (&s, collection);
+
+  /* No completions found.  */
+  if (NILP (s.bestmatch))
+    return Qnil;
+
+  /* If we are ignoring case, and there is no exact match, and no
+     additional text was supplied, don't change the case of what the
+     user typed.  */
+  if (completion_ignore_case
+      && s.bestmatchsize == SCHARS (string)
+      && SCHARS (s.bestmatch) > s.bestmatchsize)
+    return minibuf_conform_representation (string, s.bestmatch);
+
+  /* Return t if the supplied string is an exact match (counting case);
+     it does not require any change to be made.  */
+  if (s.matchcount == 1 && !NILP (Fequal (s.bestmatch, string)))
+    return Qt;
+
+  /* Else extract the part in which all completions agree.  */
+  return Fsubstring (s.bestmatch, make_number (0),
+		     make_number (s.bestmatchsize));
+}
+
+DEFUN ("all-completions", Fall_completions, Sall_completions, 2, 4, 0,
+       doc: /* Search for partial matches to STRING in COLLECTION.
+Test each of the possible completions specified by COLLECTION
+to see if it begins with STRING.  The possible completions may be
+strings or symbols.  Symbols are converted to strings before testing,
+see `symbol-name'.
+The value is a list of all the possible completions that match STRING.
+
+If COLLECTION is an alist, the keys (cars of elements) are the
+possible completions.  If an element is not a cons cell, then the
+element itself is the possible completion.
+If COLLECTION is a hash-table, all the keys that are strings or symbols
+are the possible completions.
+If COLLECTION is an obarray, the names of all symbols in the obarray
+are the possible completions.
+
+COLLECTION can also be a function to do the completion itself.
+It receives three arguments: the values STRING, PREDICATE and t.
+Whatever it returns becomes the value of `all-completions'.
+
+If optional third argument PREDICATE is non-nil,
+it is used to test each possible match.
+The match is a candidate only if PREDICATE returns non-nil.
+The argument given to PREDICATE is the alist element
+or the symbol from the obarray.  If COLLECTION is a hash-table,
+predicate is called with two arguments: the key and the value.
+Additionally to this predicate, `completion-regexp-list'
+is used to further constrain the set of candidates.
+
+An obsolete optional fourth argument HIDE-SPACES is still accepted for
+backward compatibility.  If non-nil, strings in COLLECTION that start
+with a space are ignored unless STRING itself starts with a space.  */)
+  (Lisp_Object string, Lisp_Object collection, Lisp_Object predicate,
+   Lisp_Object hide_spaces)
+{
+  struct completion_scan s;
+
+  s.type = completion_type (collection);
+  if (s.type == COMPLETION_FUNCTION)
+    return call3 (collection, string, predicate, Qt);
+
+  CHECK_STRING (string);
+  s.string = string;
+  s.predicate = predicate;
+  s.all = true;
+  s.hide_spaces = !NILP (hide_spaces);
+  s.allmatches = Qnil;
+  s.bestmatch = Qnil;
+  s.bestmatchsize = 0;
+  s.matchcount = 0;
+  s.done = false;
+  completion_scan (&s, collection);
+
+  return Fnreverse (s.allmatches);
+}
+
+static void
+test_completion_symbol (Lisp_Object symbol, Lisp_Object arg)
+{
+  Lisp_Object *data = XSAVE_POINTER (arg, 0);
+
+  if (!SYMBOLP (data[1])
+      && EQ (Fcompare_strings (data[0], make_number (0), Qnil,
+			       SYMBOL_NAME (symbol), make_number (0), Qnil,
+			       Qt),
+	     Qt))
+    data[1] = symbol;
+}
+
+DEFUN ("test-completion", Ftest_completion, Stest_completion, 2, 3, 0,
+       doc: /* Return non-nil if STRING is a valid completion.
+Takes the same arguments as `all-completions' and `try-completion'.
+If COLLECTION is a function, it is called with three arguments:
+the values STRING, PREDICATE and `lambda'.  */)
+  (Lisp_Object string, Lisp_Object collection, Lisp_Object predicate)
+{
+  Lisp_Object tem = Qnil, value = Qnil;
+
+  switch (completion_type (collection))
+    {
+    case COMPLETION_LIST:
+      CHECK_STRING (string);
+      tem = Fassoc_string (string, collection,
+			   completion_ignore_case ? Qt : Qnil);
+      if (NILP (tem))
+	return Qnil;
+      break;
+
+    case COMPLETION_OBARRAY:
+      CHECK_STRING (string);
+      collection = check_obarray (collection);
+      tem = oblookup (collection, SSDATA (string), SCHARS (string),
+		      SBYTES (string));
+      if (INTEGERP (tem))
+	{
+	  Lisp_Object string2 = (STRING_MULTIBYTE (string)
+				 ? Fstring_make_unibyte (string)
+				 : Fstring_make_multibyte (string));
+	  tem = oblookup (collection, SSDATA (string2), SCHARS (string2),
+			  SBYTES (string2));
+	}
+      if (INTEGERP (tem) && completion_ignore_case)
+	{
+	  Lisp_Object data[2];
+
+	  data[0] = string;
+	  data[1] = Qnil;
+	  map_obarray (collection, test_completion_symbol,
+		       make_save_ptr (data));
+	  tem = SYMBOLP (data[1]) ? data[1] : tem;
+	}
+      if (INTEGERP (tem))
+	return Qnil;
+      break;
+
+    case COMPLETION_HASH_TABLE:
+      {
+	struct Lisp_Hash_Table *h = XHASH_TABLE (collection);
+	ptrdiff_t i;
+
+	CHECK_STRING (string);
+	i = hash_lookup (h, string, NULL);
+	if (i < 0)
+	  for (i = 0; i < HASH_TABLE_SIZE (h); i++)
+	    if (!NILP (HASH_HASH (h, i)))
+	      {
+		Lisp_Object key = HASH_KEY (h, i);
+		if (SYMBOLP (key))
+		  key = Fsymbol_name (key);
+		if (STRINGP (key)
+		    && EQ (Fcompare_strings (string, make_number (0), Qnil,
+					     key, make_number (0), Qnil,
+					     completion_ignore_case
+					     ? Qt : Qnil),
+			   Qt))
+		  break;
+		QUIT;
+	      }
+	if (i >= HASH_TABLE_SIZE (h))
+	  return Qnil;
+	tem = HASH_KEY (h, i);
+	value = HASH_VALUE (h, i);
+	if (SYMBOLP (tem))
+	  tem = Fsymbol_name (tem);
+	if (!STRINGP (tem))
+	  return Qnil;
+      }
+      break;
+
+    default:
+      return call3 (collection, string, predicate, Qlambda);
+    }
+
+  /* Reject this element if it fails to match all the regexps.  */
+  if (CONSP (Vcompletion_regexp_list))
+    {
+      Lisp_Object name = CONSP (tem) ? XCAR (tem) : tem;
+      bool match;
+
+      dynwind_begin ();
+      specbind (Qcase_fold_search, completion_ignore_case ? Qt : Qnil);
+      match = completion_regexps_match (STRINGP (name) ? name : string);
+      dynwind_end ();
+      if (!match)
+	return Qnil;
+    }
+
+  /* Finally, check the predicate.  */
+  if (!NILP (predicate))
+    return (HASH_TABLE_P (collection)
+	    ? call2 (predicate, tem, value)
+	    : call1 (predicate, tem));
+  return Qt;
+}
+
+/* Flex matching.  A pattern matches a candidate if its characters
+   occur in the candidate in order, not necessarily next to each
+   other.  Each match is scored as fzf does: the shortest substring
+   containing the match is found, and within it each matched character
+   scores points, more when it starts a word or follows another
+   matched character, while each gap loses points.  Scoring reads only
+   the text of the candidates, so large collections are split among
+   several threads.  */
+
+enum
+  {
+    FLEX_SCORE_MATCH = 16,
+    FLEX_SCORE_GAP_START = -3,
+    FLEX_SCORE_GAP_EXTENSION = -1,
+    FLEX_BONUS_BOUNDARY = 8,
+    FLEX_BONUS_CAMEL = 7,
+    FLEX_BONUS_CONSECUTIVE = 4,
+    FLEX_BONUS_FIRST_CHAR_MULTIPLIER = 2
+  };
+
+/* Candidates at least this many are scored by several threads.  */
+#define FLEX_PARALLEL_CANDIDATES 4096
+
+/* The most threads that score one collection.  */
+#define FLEX_MAX_THREADS 16
+
+enum flex_class { FLEX_NONWORD, FLEX_LOWER, FLEX_UPPER, FLEX_OTHER };
+
+struct flex_candidate
+{
+  Lisp_Object elt;
+  const unsigned char *text;
+  ptrdiff_t nchars, nbytes;
+  bool multibyte;
+  bool matched;
+  EMACS_INT score;
+};
+
+struct flex_job
+{
+  struct flex_candidate *cands;
+  ptrdiff_t lo, hi;
+  const int *pattern;
+  ptrdiff_t npattern;
+  bool fold;
+};
+
+static enum flex_class
+flex_class (int c)
+{
+  if ('a' <= c && c <= 'z')
+    return FLEX_LOWER;
+  if ('A' <= c && c <= 'Z')
+    return FLEX_UPPER;
+  if (('0' <= c && c <= '9') || c >= 0x80)
+    return FLEX_OTHER;
+  return FLEX_NONWORD;
+}
+
+/* Return the character at byte P of candidate C, storing its length in
+   *LEN, folded to lower case if FOLD.  Only ASCII letters are folded,
+   since case tables cannot be consulted from other threads.  */
+
+static int
+flex_char (struct flex_candidate *c, const unsigned char *p, int *len,
+	   bool fold)
+{
+  int ch;
+
+  if (c->multibyte)
+    ch = STRING_CHAR_AND_LENGTH (p, *len);
+  else
+    {
+      ch = *p;
+      *len = 1;
+      if (ch >= 0x80)
+	ch = BYTE8_TO_CHAR (ch);
+    }
+  if (fold && 'A' <= ch && ch <= 'Z')
+    ch += 'a' - 'A';
+  return ch;
+}
+
+/* Score candidate C against the NPATTERN characters of PATTERN.  */
+
+static void
+flex_score (struct flex_candidate *c, const int *pattern,
+	    ptrdiff_t npattern, bool fold)
+{
+  const unsigned char *text = c->text, *end = text + c->nbytes;
+  const unsigned char *p, *start = text, *stop = text;
+  enum flex_class prev;
+  ptrdiff_t pi = 0, consecutive = 0;
+  bool in_gap = false;
+  EMACS_INT score = 0;
+  int len;
+
+  c->matched = false;
+
+  /* Find where the first match ends...  */
+  for (p = text; pi < npattern && p < end; p += len)
+    if (flex_char (c, p, &len, fold) == pattern[pi])
+      {
+	pi++;
+	stop = p + len;
+      }
+  if (pi < npattern)
+    return;
+
+  /* ...and the last place it could start.  */
+  for (p = stop; pi > 0; )
+    {
+      do
+	p--;
+      while (c->multibyte && p > text && !CHAR_HEAD_P (*p));
+      if (flex_char (c, p, &len, fold) == pattern[pi - 1])
+	pi--;
+    }
+  start = p;
+
+  prev = FLEX_NONWORD;
+  if (start > text)
+    {
+      p = start;
+      do
+	p--;
+      while (c->multibyte && p > text && !CHAR_HEAD_P (*p));
+      prev = flex_class (flex_char (c, p, &len, false));
+    }
+
+  for (p = start; p < stop; p += len)
+    {
+      int ch = flex_char (c, p, &len, false);
+      int folded = fold && 'A' <= ch && ch <= 'Z' ? ch + 'a' - 'A' : ch;
+      enum flex_class class = flex_class (ch);
+
+      if (pi < npattern && folded == pattern[pi])
+	{
+	  int bonus = 0;
+
+	  if (prev == FLEX_NONWORD && class != FLEX_NONWORD)
+	    bonus = FLEX_BONUS_BOUNDARY;
+	  else if (prev == FLEX_LOWER && class == FLEX_UPPER)
+	    bonus = FLEX_BONUS_CAMEL;
+	  if (pi == 0)
+	    bonus *= FLEX_BONUS_FIRST_CHAR_MULTIPLIER;
+	  else if (consecutive > 0)
+	    bonus = max (bonus, FLEX_BONUS_CONSECUTIVE);
+	  score += FLEX_SCORE_MATCH + bonus;
+	  consecutive++;
+	  in_gap = false;
+	  pi++;
+	}
+      else
+	{
+	  score += in_gap ? FLEX_SCORE_GAP_EXTENSION : FLEX_SCORE_GAP_START;
+	  in_gap = true;
+	  consecutive = 0;
+	}
+      prev = class;
+    }
+
+  c->matched = true;
+  c->score = score;
+}
+
+static void *
+flex_thread (void *arg)
+{
+  struct flex_job *job = arg;
+  ptrdiff_t i;
+
+  for (i = job->lo; i < job->hi; i++)
+    flex_score (&job->cands[i], job->pattern, job->npattern, job->fold);
+  return NULL;
+}
+
+/* Run JOB, splitting it among as many threads as there are
+   processors if it is large enough.  */
+
+static void
+flex_run (struct flex_job *job)
+{
+#ifdef HAVE_PTHREAD
+  struct flex_job jobs[FLEX_MAX_THREADS];
+  pthread_t thread[FLEX_MAX_THREADS];
+  bool started[FLEX_MAX_THREADS];
+  long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+  ptrdiff_t n = job->hi - job->lo;
+  int njobs = min (ncpu, min (FLEX_MAX_THREADS,
+			      n / FLEX_PARALLEL_CANDIDATES));
+  sigset_t blocked, oldset;
+  int i;
+
+  if (njobs >= 2)
+    {
+      for (i = 0; i < njobs; i++)
+	{
+	  jobs[i] = *job;
+	  jobs[i].lo = job->lo + n * i / njobs;
+	  jobs[i].hi = job->lo + n * (i + 1) / njobs;
+	}
+
+      /* Signals must go to the main thread, so the others block them.  */
+      sigfillset (&blocked);
+      pthread_sigmask (SIG_BLOCK, &blocked, &oldset);
+      for (i = 0; i < njobs - 1; i++)
+	started[i] = pthread_create (&thread[i], NULL, flex_thread,
+				     &jobs[i]) == 0;
+      pthread_sigmask (SIG_SETMASK, &oldset, 0);
+
+      flex_thread (&jobs[njobs - 1]);
+      for (i = 0; i < njobs - 1; i++)
+	{
+	  if (started[i])
+	    pthread_join (thread[i], NULL);
+	  else
+	    flex_thread (&jobs[i]);
+	}
+      return;
+    }
+#endif
+
+  flex_thread (job);
+}
+
+/* Order candidates by decreasing score, then by increasing length,
+   then as they were given.  */
+
+static int
+compare_flex_candidates (const void *a, const void *b)
+{
+  const struct flex_candidate *c1 = *(struct flex_candidate *const *) a;
+  const struct flex_candidate *c2 = *(struct flex_candidate *const *) b;
+
+  if (c1->score != c2->score)
+    return c1->score < c2->score ? 1 : -1;
+  if (c1->nchars != c2->nchars)
+    return c1->nchars < c2->nchars ? -1 : 1;
+  return c1 < c2 ? -1 : c1 > c2;
+}
+
+DEFUN ("completion-flex-match", Fcompletion_flex_match,
+       Scompletion_flex_match, 2, 3, 0,
+       doc: /* Return the elements of CANDIDATES that flex-match PATTERN, best first.
+PATTERN flex-matches a string if the characters of PATTERN occur in
+the string in the same order, though not necessarily next to each
+other.  Case is ignored, for ASCII letters only, if
+`completion-ignore-case' is non-nil.
+
+CANDIDATES is a vector or list of strings and symbols; symbols are
+matched by their names, and other elements are ignored.  Each match
+is scored: matched characters that start a word, follow a
+lower-case letter in camelCase, or follow other matched characters
+score more, and each gap in the match costs points.
+
+The value is a list of conses (ELT . SCORE), ordered by decreasing
+SCORE, then by increasing length, then by position in CANDIDATES.
+If LIMIT is non-nil, it is the most elements to return.  */)
+  (Lisp_Object pattern, Lisp_Object candidates, Lisp_Object limit)
+{
+  struct flex_job job;
+  struct flex_candidate *cands, **matches;
+  int *pat;
+  ptrdiff_t n, i, j, nmatches, npattern, limit_n;
+  Lisp_Object result = Qnil;
+  USE_SAFE_ALLOCA;
+
+  CHECK_STRING (pattern);
+  if (!VECTORP (candidates))
+    candidates = Fvconcat (1, &candidates);
+  if (NILP (limit))
+    limit_n = PTRDIFF_MAX;
+  else
+    {
+      CHECK_NATNUM (limit);
+      limit_n = min (XFASTINT (limit), PTRDIFF_MAX);
+    }
+
+  npattern = SCHARS (pattern);
+  SAFE_NALLOCA (pat, 1, npattern);
+  {
+    struct flex_candidate c;
+
+    c.multibyte = STRING_MULTIBYTE (pattern);
+    for (i = 0, j = 0; i < npattern; i++)
+      {
+	int len;
+	pat[i] = flex_char (&c, SDATA (pattern) + j, &len,
+			    completion_ignore_case);
+	j += len;
+      }
+  }
+
+  n = ASIZE (candidates);
+  cands = xnmalloc (n, sizeof *cands);
+  for (i = 0, j = 0; i < n; i++)
+    {
+      Lisp_Object elt = AREF (candidates, i);
+      Lisp_Object string = SYMBOLP (elt) ? SYMBOL_NAME (elt) : elt;
+
+      if (!STRINGP (string))
+	continue;
+      cands[j].elt = elt;
+      cands[j].text = SDATA (string);
+      cands[j].nchars = SCHARS (string);
+      cands[j].nbytes = SBYTES (string);
+      cands[j].multibyte = STRING_MULTIBYTE (string);
+      j++;
+    }
+
+  job.cands = cands;
+  job.lo = 0;
+  job.hi = j;
+  job.pattern = pat;
+  job.npattern = npattern;
+  job.fold = completion_ignore_case;
+  flex_run (&job);
+
+  matches = xnmalloc (j, sizeof *matches);
+  for (i = 0, nmatches = 0; i < j; i++)
+    if (cands[i].matched)
+      matches[nmatches++] = &cands[i];
+  qsort (matches, nmatches, sizeof *matches, compare_flex_candidates);
+
+  for (i = min (nmatches, limit_n); i > 0; i--)
+    result = Fcons (Fcons (matches[i - 1]->elt,
+			   make_number (matches[i - 1]->score)),
+		    result);
+
+  xfree (matches);
+  xfree (cands);
+  SAFE_FREE ();
+  return result;
+}
+
 /* Like assoc but assumes KEY is a string, and ignores case if appropriate.  */
 
 DEFUN ("assoc-string", Fassoc_string, Sassoc_string, 2, 3, 0,
@@ -103,6 +103,7 @@ bool print_output_debug_flag EXTERNALLY_VISIBLE = 1;
    ptrdiff_t old_point_byte = -1, start_point_byte = -1;		\
    dynwind_begin ();                                                    \
    bool free_print_buffer = 0;						\
+   Lisp_Object print_string_fun = Qnil;					\
    bool multibyte							\
      = !NILP (BVAR (current_buffer, enable_multibyte_characters));	\
    Lisp_Object original
@@ -162,9 +163,20 @@ bool print_output_debug_flag EXTERNALLY_VISIBLE = 1;
        print_buffer_pos_byte = 0;					\
      }									\
    if (EQ (printcharfun, Qt) && ! noninteractive)			\
-     setup_echo_area_for_printing (multibyte);
+     setup_echo_area_for_printing (multibyte);				\
+   if (print_function_accepts_strings					\
+       && ! NILP (printcharfun) && ! EQ (printcharfun, Qt)		\
+       && ! STRING_BUILDER_P (printcharfun))				\
+     {									\
+       print_string_fun = printcharfun;					\
+       printcharfun = Fmake_string_builder ();				\
+     }
 
 #define PRINTFINISH							\
+   if (! NILP (print_string_fun)					\
+       && XSTRING_BUILDER (printcharfun)->nchars > 0)			\
+     call1 (print_string_fun,						\
+	    Fstring_builder_string (printcharfun, Qnil));		\
    if (NILP (printcharfun))						\
      {									\
        if (print_buffer_pos != print_buffer_pos_byte			\
@@ -217,7 +229,13 @@ print_unwind (Lisp_Object saved_text)
 static void
 printchar (unsigned int ch, Lisp_Object fun)
 {
-  if (!NILP (fun) && !EQ (fun, Qt))
+  if (STRING_BUILDER_P (fun))
+    {
+      unsigned char str[MAX_MULTIBYTE_LENGTH];
+      int len = CHAR_STRING (ch, str);
+      string_builder_append (XSTRING_BUILDER (fun), str, 1, len, true);
+    }
+  else if (!NILP (fun) && !EQ (fun, Qt))
     call1 (fun, make_number (ch));
   else
     {
@@ -281,6 +299,10 @@ strout (const char *ptr, ptrdiff_t size, ptrdiff_t size_byte,
       print_buffer_pos += size;
       print_buffer_pos_byte += size_byte;
     }
+  else if (STRING_BUILDER_P (printcharfun))
+    string_builder_append (XSTRING_BUILDER (printcharfun),
+			   (const unsigned char *) ptr, size, size_byte,
+			   size != size_byte);
   else if (noninteractive && EQ (printcharfun, Qt))
     {
       fwrite (ptr, 1, size_byte, stdout);
@@ -403,6 +425,9 @@ print_string (Lisp_Object string, Lisp_Object printcharfun)
 	/* No need to copy, since output to print_buffer can't GC.  */
 	strout (SSDATA (string), chars, SBYTES (string), printcharfun);
     }
+  else if (STRING_BUILDER_P (printcharfun))
+    /* Appending to a builder cannot relocate STRING.  */
+    string_builder_append_string (XSTRING_BUILDER (printcharfun), string);
   else
     {
       /* Otherwise, string may be relocated by printing one char.
@@ -1105,9 +1130,13 @@ print (Lisp_Object obj, Lisp_Object printcharfun, bool escapeflag)
       print_depth = 0;
       print_preprocess (obj);
 
-      if (HASH_TABLE_P (Vprint_number_table))
-	{ /* Remove unnecessary objects, which appear only once in OBJ;
-	     that is, whose status is Qt.  */
+      /* Remove unnecessary objects, which appear only once in OBJ;
+	 that is, whose status is Qt.  print_object only looks at
+	 numbered objects, so this matters only if the table is kept for
+	 the next print call.  */
+      if (HASH_TABLE_P (Vprint_number_table)
+	  && !NILP (Vprint_continuous_numbering))
+	{
 	  struct Lisp_Hash_Table *h = XHASH_TABLE (Vprint_number_table);
 	  ptrdiff_t i;
 
@@ -1180,8 +1209,12 @@ print_preprocess (Lisp_Object obj)
 	 add OBJ to Vprint_number_table only when OBJ is a symbol.  */
       if (! NILP (Vprint_circle) || SYMBOLP (obj))
 	{
-	  Lisp_Object num = Fgethash (obj, Vprint_number_table, Qnil);
-	  if (!NILP (num)
+	  /* Look OBJ up only once, whether or not it is already there.  */
+	  struct Lisp_Hash_Table *h = XHASH_TABLE (Vprint_number_table);
+	  EMACS_UINT hash;
+	  ptrdiff_t i = hash_lookup (h, obj, &hash);
+	  Lisp_Object num = i < 0 ? Qnil : HASH_VALUE (h, i);
+	  if (i >= 0
 	      /* If Vprint_continuous_numbering is non-nil and OBJ is a gensym,
 		 always print the gensym with a number.  This is a special for
 		 the lisp function byte-compile-output-docform.  */
@@ -1193,15 +1226,17 @@ print_preprocess (Lisp_Object obj)
 		{
 		  print_number_index++;
 		  /* Negative number indicates it hasn't been printed yet.  */
-		  Fputhash (obj, make_number (- print_number_index),
-			    Vprint_number_table);
+		  if (i >= 0)
+		    set_hash_value_slot (h, i, make_number (- print_number_index));
+		  else
+		    hash_put (h, obj, make_number (- print_number_index), hash);
 		}
 	      print_depth--;
 	      return;
 	    }
 	  else
 	    /* OBJ is not yet recorded.  Let's add to the table.  */
-	    Fputhash (obj, Qt, Vprint_number_table);
+	    hash_put (h, obj, Qt, hash);
 	}
 
       switch (XTYPE (obj))
@@ -1362,7 +1397,10 @@ print_object (Lisp_Object obj, Lisp_Object printcharfun, bool escapeflag)
   else if (PRINT_CIRCLE_CANDIDATE_P (obj))
     {
       /* With the print-circle feature.  */
-      Lisp_Object num = Fgethash (obj, Vprint_number_table, Qnil);
+      struct Lisp_Hash_Table *h = (HASH_TABLE_P (Vprint_number_table)
+				   ? XHASH_TABLE (Vprint_number_table) : 0);
+      ptrdiff_t i = h ? hash_lookup (h, obj, NULL) : -1;
+      Lisp_Object num = i < 0 ? Qnil : HASH_VALUE (h, i);
       if (INTEGERP (num))
 	{
 	  EMACS_INT n = XINT (num);
@@ -1372,7 +1410,7 @@ print_object (Lisp_Object obj, Lisp_Object printcharfun, bool escapeflag)
 	      int len = sprintf (buf, "#%"pI"d=", -n);
 	      strout (buf, len, len, printcharfun);
 	      /* OBJ is going to be printed.  Remember that fact.  */
-	      Fputhash (obj, make_number (- n), Vprint_number_table);
+	      set_hash_value_slot (h, i, make_number (- n));
 	    }
 	  else
 	    {
@@ -1894,6 +1932,16 @@ print_object (Lisp_Object obj, Lisp_Object printcharfun, bool escapeflag)
 	{
 	  strout ("#<window-configuration>", -1, -1, printcharfun);
 	}
+      else if (STRING_BUILDER_P (obj))
+	{
+	  int len = sprintf (buf, "#<string-builder %"pD"d>",
+			     XSTRING_BUILDER (obj)->nchars);
+	  strout (buf, len, len, printcharfun);
+	}
+      else if (ZLIB_STREAM_P (obj))
+	{
+	  strout ("#<zlib-stream>", -1, -1, printcharfun);
+	}
       else if (FRAMEP (obj))
 	{
 	  int len;
@@ -2277,6 +2325,17 @@ This affects only `prin1'.  */);
 I.e., (quote foo) prints as 'foo, (function foo) as #'foo.  */);
   print_quoted = 0;
 
+  DEFVAR_BOOL ("print-function-accepts-strings",
+	       print_function_accepts_strings,
+	       doc: /* Non-nil means a function used as a print stream accepts strings.
+Normally, when the output stream of a print function such as `prin1'
+or `princ' is a function, it is called once for each character output,
+with that character as argument.  If this variable is non-nil, the
+output of each print call is collected instead and the function is
+called once, with all of it as a string.  Bind this variable with
+`let' around calls that print to such a function.  */);
+  print_function_accepts_strings = 0;
+
   DEFVAR_LISP ("print-gensym", Vprint_gensym,
 	       doc: /* Non-nil means print uninterned symbols so they will read as uninterned.
 I.e., the value of (make-symbol \"foobar\") prints as #:foobar.
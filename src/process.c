@@ -31,6 +31,10 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 
 #include "lisp.h"
 
+#ifndef DOS_NT
+#include <sys/uio.h>
+#endif
+
 /* Only MS-DOS does not define `subprocesses'.  */
 #ifdef subprocesses
 
@@ -88,6 +92,12 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <pty.h>
 #endif
 
+/* Wait with epoll where the toolkit does not do the waiting.  */
+#if defined HAVE_SYS_EPOLL_H && !defined HAVE_NS && !defined HAVE_GLIB
+#define USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #include <c-ctype.h>
 #include <sig2str.h>
 #include <verify.h>
@@ -238,6 +248,15 @@ enum { SELECT_CAN_DO_WRITE_MASK = true };
 #endif /* NON_BLOCKING_CONNECT */
 #endif /* BROKEN_NON_BLOCKING_CONNECT */
 
+/* Define ASYNC_NETWORK_LOOKUP if the host names of non-blocking
+   client connections can be looked up on a thread of their own.  */
+#if (defined HAVE_GETADDRINFO && defined HAVE_PTHREAD \
+     && defined NON_BLOCKING_CONNECT)
+#define ASYNC_NETWORK_LOOKUP
+#include <pthread.h>
+#include <signal.h>
+#endif
+
 /* Define DATAGRAM_SOCKETS if datagrams can be used safely on
    this system.  We need to read full packets, so we need a
    "non-destructive" select.  So we require either native select,
@@ -277,7 +296,12 @@ static bool process_output_skip;
 #define process_output_delay_count 0
 #endif
 
-static void create_process (Lisp_Object, char **, Lisp_Object);
+/* Upper bound on `read-process-output-max'.  Output is read into a
+   buffer of that size, and decoded into a string all at once.  */
+
+#define READ_OUTPUT_MAX_MAX (64 * 1024 * 1024)
+
+static void create_process (Lisp_Object, char **, Lisp_Object, Lisp_Object);
 #ifdef USABLE_SIGIO
 static bool keyboard_bit_set (fd_set *);
 #endif
@@ -439,11 +463,6 @@ pset_type (struct Lisp_Process *p, Lisp_Object val)
 {
   p->type = val;
 }
-static void
-pset_write_queue (struct Lisp_Process *p, Lisp_Object val)
-{
-  p->write_queue = val;
-}
 
 
 
@@ -457,6 +476,176 @@ static struct fd_callback_data
 } fd_callback_info[FD_SETSIZE];
 
 
+#ifdef USE_EPOLL
+
+/* The epoll instance wait_reading_process_output waits on instead of
+   calling pselect; -1 if not made yet, -2 if it could not be made.  */
+static int epoll_fd = -1;
+
+/* The events each descriptor is registered for with EPOLL_FD, or 0 if
+   it is not registered.  Registrations outlive the wait they are made
+   for, so that waiting on the same descriptors again costs no system
+   calls; a registration is only narrowed when its descriptor is ready
+   for something no longer waited for, and dropped when the descriptor
+   stops being monitored.  */
+static unsigned char epoll_events[FD_SETSIZE];
+
+/* Descriptors that epoll cannot wait on, such as regular files.  Like
+   pselect, epoll_select reports them always ready.  */
+static fd_set epoll_unpollable;
+
+/* Register FD with EPOLL_FD for EVENTS, or drop it if EVENTS is 0.
+   Return true if successful.  */
+
+static bool
+epoll_set_events (int fd, int events)
+{
+  struct epoll_event ev;
+  int op = (events == 0 ? EPOLL_CTL_DEL
+	    : epoll_events[fd] ? EPOLL_CTL_MOD : EPOLL_CTL_ADD);
+  int ret;
+
+  ev.events = events;
+  ev.data.fd = fd;
+  ret = epoll_ctl (epoll_fd, op, fd, &ev);
+  /* FD may have been closed and reopened behind our back.  */
+  if (ret < 0 && op == EPOLL_CTL_MOD && errno == ENOENT)
+    ret = epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+  else if (ret < 0 && op == EPOLL_CTL_ADD && errno == EEXIST)
+    ret = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+  if (ret < 0 && op != EPOLL_CTL_DEL)
+    return false;
+  epoll_events[fd] = events;
+  return true;
+}
+
+/* FD is about to be closed or no longer monitored; forget it.  */
+
+static void
+epoll_forget (int fd)
+{
+  if (fd >= FD_SETSIZE)
+    return;
+  if (epoll_fd >= 0 && epoll_events[fd])
+    epoll_set_events (fd, 0);
+  FD_CLR (fd, &epoll_unpollable);
+}
+
+/* Like pselect, but wait with epoll.  EFDS must be null.  */
+
+static int
+epoll_select (int nfds, fd_set *rfds, fd_set *wfds, fd_set *efds,
+	      struct timespec *timeout, sigset_t *sigmask)
+{
+  struct epoll_event events[64];
+  fd_set want_r, want_w;
+  int fd, i, n, ms, ready = 0;
+  bool dropped;
+
+  eassert (!efds);
+  if (epoll_fd == -1)
+    {
+      epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+      if (epoll_fd < 0)
+	epoll_fd = -2;
+    }
+  if (epoll_fd < 0)
+    return pselect (nfds, rfds, wfds, efds, timeout, sigmask);
+
+  FD_ZERO (&want_r);
+  FD_ZERO (&want_w);
+  if (rfds)
+    {
+      want_r = *rfds;
+      FD_ZERO (rfds);
+    }
+  if (wfds)
+    {
+      want_w = *wfds;
+      FD_ZERO (wfds);
+    }
+
+  /* Add what is waited for to the registrations.  */
+  for (fd = 0; fd < nfds; fd++)
+    {
+      int want = ((FD_ISSET (fd, &want_r) ? EPOLLIN : 0)
+		  | (FD_ISSET (fd, &want_w) ? EPOLLOUT : 0));
+
+      if (!want)
+	continue;
+      if (!FD_ISSET (fd, &epoll_unpollable)
+	  && (want & ~epoll_events[fd])
+	  && !epoll_set_events (fd, epoll_events[fd] | want))
+	{
+	  if (errno != EPERM)
+	    return -1;
+	  FD_SET (fd, &epoll_unpollable);
+	}
+      if (FD_ISSET (fd, &epoll_unpollable))
+	{
+	  if (want & EPOLLIN)
+	    {
+	      FD_SET (fd, rfds);
+	      ready++;
+	    }
+	  if (want & EPOLLOUT)
+	    {
+	      FD_SET (fd, wfds);
+	      ready++;
+	    }
+	}
+    }
+
+  if (ready || !timeout)
+    ms = ready ? 0 : -1;
+  else if (timeout->tv_sec >= INT_MAX / 1000)
+    ms = INT_MAX;
+  else
+    ms = timeout->tv_sec * 1000 + (timeout->tv_nsec + 999999) / 1000000;
+
+  do
+    {
+      n = epoll_pwait (epoll_fd, events, ARRAYELTS (events), ms, sigmask);
+      if (n < 0)
+	return -1;
+      dropped = false;
+      for (i = 0; i < n; i++)
+	{
+	  bool reported = false;
+
+	  fd = events[i].data.fd;
+	  if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+	      && FD_ISSET (fd, &want_r))
+	    {
+	      FD_SET (fd, rfds);
+	      ready++;
+	      reported = true;
+	    }
+	  if ((events[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+	      && FD_ISSET (fd, &want_w))
+	    {
+	      FD_SET (fd, wfds);
+	      ready++;
+	      reported = true;
+	    }
+	  /* Stop FD waking us up for what nobody waits for now.  */
+	  if (!reported)
+	    {
+	      epoll_set_events (fd, (epoll_events[fd]
+				     & ((FD_ISSET (fd, &want_r) ? EPOLLIN : 0)
+					| (FD_ISSET (fd, &want_w)
+					   ? EPOLLOUT : 0))));
+	      dropped = true;
+	    }
+	}
+    }
+  while (!ready && dropped);
+
+  return ready;
+}
+
+#endif /* USE_EPOLL */
+
 /* Add a file descriptor FD to be monitored for when read is possible.
    When read is possible, call FUNC with argument DATA.  */
 
@@ -521,6 +710,9 @@ delete_input_desc (int fd)
 void
 delete_write_fd (int fd)
 {
+#ifdef USE_EPOLL
+  epoll_forget (fd);
+#endif
   FD_CLR (fd, &write_mask);
   fd_callback_info[fd].condition &= ~FOR_WRITE;
   if (fd_callback_info[fd].condition == 0)
@@ -737,6 +929,10 @@ make_process (Lisp_Object name)
   p->gnutls_initstage = GNUTLS_STAGE_EMPTY;
 #endif
 
+  p->read_output_max = clip_to_bounds (1, read_process_output_max,
+				       READ_OUTPUT_MAX_MAX);
+  p->coalesce_output = read_process_output_coalesce;
+
   /* If name is already in use, modify it until it is unused.  */
 
   name1 = name;
@@ -1386,8 +1582,27 @@ usage: (start-process NAME BUFFER PROGRAM &rest PROGRAM-ARGS)  */)
   (ptrdiff_t nargs, Lisp_Object *args)
 {
   Lisp_Object buffer, name, program, proc, current_dir, tem;
+  Lisp_Object destination = Vprocess_pipe_destination;
   register unsigned char **new_argv;
   ptrdiff_t i;
+
+  if (!NILP (destination))
+    {
+      struct Lisp_Process *d;
+
+      CHECK_PROCESS (destination);
+      d = XPROCESS (destination);
+      if (d->raw_status_new)
+	update_status (d);
+      if (!EQ (d->type, Qreal) || d->pty_flag || d->outfd < 0
+	  || !EQ (d->status, Qrun))
+	error ("Process %s cannot read a pipe from a new process",
+	       SDATA (d->name));
+#ifdef WINDOWSNT
+      error ("Piping processes into each other is not supported");
+#endif
+    }
+
   dynwind_begin ();
 
   buffer = args[1];
@@ -1437,6 +1652,7 @@ usage: (start-process NAME BUFFER PROGRAM &rest PROGRAM-ARGS)  */)
   /* AKA GNUTLS_INITSTAGE(proc).  */
   XPROCESS (proc)->gnutls_initstage = GNUTLS_STAGE_EMPTY;
   pset_gnutls_cred_type (XPROCESS (proc), Qnil);
+  pset_gnutls_boot_parameters (XPROCESS (proc), Qnil);
 #endif
 
 #ifdef ADAPTIVE_READ_BUFFERING
@@ -1587,7 +1803,7 @@ usage: (start-process NAME BUFFER PROGRAM &rest PROGRAM-ARGS)  */)
 	  tem = XCDR (tem);
 	}
 
-      create_process (proc, (char **) new_argv, current_dir);
+      create_process (proc, (char **) new_argv, current_dir, destination);
     }
   else
     create_pty (proc);
@@ -1621,6 +1837,9 @@ close_process_fd (int *fd_addr)
   if (0 <= fd)
     {
       *fd_addr = -1;
+#ifdef USE_EPOLL
+      epoll_forget (fd);
+#endif
       emacs_close (fd);
     }
 }
@@ -1644,8 +1863,14 @@ enum
 
 verify (PROCESS_OPEN_FDS == EXEC_MONITOR_OUTPUT + 1);
 
+/* Start the program NEW_ARGV for PROCESS in CURRENT_DIR.  If
+   DESTINATION is a process, the program writes straight to its input
+   pipe, and Emacs stops writing there itself; see
+   `process-pipe-destination'.  */
+
 static void
-create_process (Lisp_Object process, char **new_argv, Lisp_Object current_dir)
+create_process (Lisp_Object process, char **new_argv, Lisp_Object current_dir,
+		Lisp_Object destination)
 {
   struct Lisp_Process *p = XPROCESS (process);
   int inchannel, outchannel;
@@ -1659,7 +1884,7 @@ create_process (Lisp_Object process, char **new_argv, Lisp_Object current_dir)
 
   inchannel = outchannel = -1;
 
-  if (!NILP (Vprocess_connection_type))
+  if (!NILP (Vprocess_connection_type) && NILP (destination))
     outchannel = inchannel = allocate_pty (pty_name);
 
   if (inchannel >= 0)
@@ -1680,6 +1905,18 @@ create_process (Lisp_Object process, char **new_argv, Lisp_Object current_dir)
       pty_flag = 1;
       lisp_pty_name = build_string (pty_name);
     }
+  else if (!NILP (destination))
+    {
+      /* There is no pipe from the child to Emacs.  The child inherits
+	 the destination's input pipe, which must block for it as it
+	 would in a shell pipeline.  */
+      if (emacs_pipe (p->open_fd + SUBPROCESS_STDIN) != 0)
+	report_file_error ("Creating pipe", Qnil);
+      forkin = p->open_fd[SUBPROCESS_STDIN];
+      outchannel = p->open_fd[WRITE_TO_SUBPROCESS];
+      forkout = XPROCESS (destination)->outfd;
+      fcntl (forkout, F_SETFL, fcntl (forkout, F_GETFL) & ~O_NONBLOCK);
+    }
   else
     {
       if (emacs_pipe (p->open_fd + SUBPROCESS_STDIN) != 0
@@ -1696,11 +1933,13 @@ create_process (Lisp_Object process, char **new_argv, Lisp_Object current_dir)
     report_file_error ("Creating pipe", Qnil);
 #endif
 
-  fcntl (inchannel, F_SETFL, O_NONBLOCK);
+  if (inchannel >= 0)
+    fcntl (inchannel, F_SETFL, O_NONBLOCK);
   fcntl (outchannel, F_SETFL, O_NONBLOCK);
 
   /* Record this as an active process, with its channels.  */
-  chan_process[inchannel] = process;
+  if (inchannel >= 0)
+    chan_process[inchannel] = process;
   p->infd = inchannel;
   p->outfd = outchannel;
 
@@ -1712,10 +1951,13 @@ create_process (Lisp_Object process, char **new_argv, Lisp_Object current_dir)
   p->pty_flag = pty_flag;
   pset_status (p, Qrun);
 
-  FD_SET (inchannel, &input_wait_mask);
-  FD_SET (inchannel, &non_keyboard_wait_mask);
-  if (inchannel > max_process_desc)
-    max_process_desc = inchannel;
+  if (inchannel >= 0)
+    {
+      FD_SET (inchannel, &input_wait_mask);
+      FD_SET (inchannel, &non_keyboard_wait_mask);
+      if (inchannel > max_process_desc)
+	max_process_desc = inchannel;
+    }
 
   /* This may signal an error. */
   setup_process_coding_systems (process);
@@ -1897,6 +2139,11 @@ create_process (Lisp_Object process, char **new_argv, Lisp_Object current_dir)
 	close_process_fd (&p->open_fd[READ_FROM_EXEC_MONITOR]);
       }
 #endif
+
+      /* Now only the child writes to the destination, which sees
+	 end-of-file when the child exits.  */
+      if (!NILP (destination))
+	Fprocess_send_eof (destination);
     }
 }
 
@@ -2655,6 +2902,204 @@ usage:  (make-serial-process &rest ARGS)  */)
   return proc;
 }
 
+#ifdef ASYNC_NETWORK_LOOKUP
+
+/* A host name lookup for a non-blocking client connection.
+   getaddrinfo runs on a thread of its own, so that a slow name server
+   does not freeze Emacs; the thread writes a byte to PIPE when it is
+   done, and wait_reading_process_output then calls
+   network_lookup_done, which starts the actual connect.  */
+
+struct network_lookup
+{
+  /* The process being connected.  Its status is `connect' and it has
+     no descriptors until the lookup is done.  */
+  Lisp_Object proc;
+
+  char *host, *service;
+  struct addrinfo hints;
+
+  /* What getaddrinfo returned, and errno if that was EAI_SYSTEM.  */
+  struct addrinfo *res;
+  int ret, err;
+
+  int pipe[2];
+  pthread_t thread;
+};
+
+static void *
+network_lookup_thread (void *arg)
+{
+  struct network_lookup *lookup = arg;
+  char c = 0;
+
+  lookup->ret = getaddrinfo (lookup->host, lookup->service,
+			     &lookup->hints, &lookup->res);
+  lookup->err = errno;
+  while (write (lookup->pipe[1], &c, 1) < 0 && errno == EINTR)
+    continue;
+  return NULL;
+}
+
+/* Start looking up HOST and SERVICE as specified by HINTS.
+   Return NULL if no thread could be started; the caller should then
+   call getaddrinfo itself.  */
+
+static struct network_lookup *
+start_network_lookup (const char *host, const char *service,
+		      const struct addrinfo *hints)
+{
+  struct network_lookup *lookup = xzalloc (sizeof *lookup);
+  sigset_t blocked, oldset;
+  int err;
+
+  if (emacs_pipe (lookup->pipe) != 0)
+    return NULL;
+  lookup->proc = Qnil;
+  lookup->host = xstrdup (host);
+  lookup->service = xstrdup (service);
+  lookup->hints = *hints;
+
+  /* Signals must keep being delivered to the main thread.  */
+  sigfillset (&blocked);
+  pthread_sigmask (SIG_BLOCK, &blocked, &oldset);
+  err = pthread_create (&lookup->thread, NULL, network_lookup_thread, lookup);
+  pthread_sigmask (SIG_SETMASK, &oldset, 0);
+  if (err != 0)
+    {
+      emacs_close (lookup->pipe[0]);
+      emacs_close (lookup->pipe[1]);
+      return NULL;
+    }
+  return lookup;
+}
+
+/* Start connecting process PROC, whose host name lookup returned the
+   addresses RES, the way Fmake_network_process does for :nowait.
+   Set the status of PROC to `failed' if no address can be tried.  */
+
+static void
+connect_network_lookup (Lisp_Object proc, struct addrinfo *res)
+{
+  struct Lisp_Process *p = XPROCESS (proc);
+  Lisp_Object contact = p->childp;
+  struct addrinfo *lres;
+  int s = -1, xerrno = 0;
+
+  for (lres = res; lres; lres = lres->ai_next)
+    {
+      Lisp_Object tail;
+
+      s = socket (lres->ai_family, lres->ai_socktype | SOCK_CLOEXEC,
+		  lres->ai_protocol);
+      if (s < 0)
+	{
+	  xerrno = errno;
+	  continue;
+	}
+      if (fcntl (s, F_SETFL, O_NONBLOCK) == 0)
+	{
+	  dynwind_begin ();
+	  record_unwind_protect_int_1 (close_file_unwind, s, false);
+	  for (tail = contact; CONSP (tail) && CONSP (XCDR (tail));
+	       tail = XCDR (XCDR (tail)))
+	    set_socket_option (s, XCAR (tail), XCAR (XCDR (tail)));
+	  dynwind_end ();
+
+	  if (connect (s, lres->ai_addr, lres->ai_addrlen) == 0)
+	    break;
+	  xerrno = errno;
+#ifdef EINPROGRESS
+	  if (xerrno == EINPROGRESS)
+	    break;
+#else
+	  if (xerrno == EWOULDBLOCK)
+	    break;
+#endif
+	  if (xerrno == EISCONN)
+	    break;
+	}
+      else
+	xerrno = errno;
+      emacs_close (s);
+      s = -1;
+    }
+
+  if (s < 0)
+    {
+      p->tick = ++process_tick;
+      pset_status (p, list2 (Qfailed, make_number (xerrno)));
+      return;
+    }
+
+  contact = Fplist_put (contact, QCremote,
+			conv_sockaddr_to_lisp (lres->ai_addr, lres->ai_addrlen));
+#ifdef HAVE_GETSOCKNAME
+  {
+    struct sockaddr_in sa1;
+    socklen_t len1 = sizeof (sa1);
+    if (getsockname (s, (struct sockaddr *)&sa1, &len1) == 0)
+      contact = Fplist_put (contact, QClocal,
+			    conv_sockaddr_to_lisp ((struct sockaddr *)&sa1, len1));
+  }
+#endif
+  pset_childp (p, contact);
+
+  p->open_fd[SUBPROCESS_STDIN] = s;
+  p->infd  = s;
+  p->outfd = s;
+  chan_process[s] = proc;
+  if (s > max_process_desc)
+    max_process_desc = s;
+  setup_process_coding_systems (proc);
+
+  /* From here on, the connection completes like any other.  */
+  FD_SET (s, &connect_wait_mask);
+  FD_SET (s, &write_mask);
+  num_pending_connects++;
+}
+
+/* Called by wait_reading_process_output when the lookup DATA is done.  */
+
+static void
+network_lookup_done (int fd, void *data)
+{
+  struct network_lookup *lookup = data;
+  struct Lisp_Process *p = XPROCESS (lookup->proc);
+
+  FD_CLR (fd, &non_keyboard_wait_mask);
+  delete_read_fd (fd);
+  emacs_close (lookup->pipe[0]);
+  emacs_close (lookup->pipe[1]);
+  pthread_join (lookup->thread, NULL);
+
+  /* If the process was deleted meanwhile, just clean up.  */
+  if (EQ (p->status, Qconnect) && p->infd < 0)
+    {
+      if (lookup->ret == 0)
+	connect_network_lookup (lookup->proc, lookup->res);
+      else
+	{
+	  int code = lookup->ret;
+#ifdef EAI_SYSTEM
+	  if (code == EAI_SYSTEM)
+	    code = lookup->err;
+#endif
+	  p->tick = ++process_tick;
+	  pset_status (p, list2 (Qfailed, make_number (code)));
+	}
+    }
+
+  if (lookup->ret == 0)
+    {
+      block_input ();
+      freeaddrinfo (lookup->res);
+      unblock_input ();
+    }
+}
+
+#endif /* ASYNC_NETWORK_LOOKUP */
+
 /* Create a network stream/datagram client/server process.  Treated
    exactly like a normal process when reading and writing.  Primary
    differences are in status display and process deletion.  A network
@@ -2736,7 +3181,8 @@ ENCODING is used for writing.
 :nowait BOOL -- If BOOL is non-nil for a stream type client process,
 return without waiting for the connection to complete; instead, the
 sentinel function will be called with second arg matching "open" (if
-successful) or "failed" when the connect completes.  Default is to use
+successful) or "failed" when the connect completes.  Where possible,
+the host name is also looked up without waiting.  Default is to use
 a blocking connect (i.e. wait) for stream type connections.
 
 :noquery BOOL -- Query the user unless BOOL is non-nil, and process is
@@ -2823,6 +3269,9 @@ usage: (make-network-process &rest ARGS)  */)
   struct addrinfo hints;
   const char *portstring;
   char portbuf[128];
+#ifdef ASYNC_NETWORK_LOOKUP
+  struct network_lookup *lookup = NULL;
+#endif
 #else /* HAVE_GETADDRINFO */
   struct _emacs_addrinfo
   {
@@ -3041,6 +3490,20 @@ usage: (make-network-process &rest ARGS)  */)
       res_init ();
 #endif
 
+#ifdef ASYNC_NETWORK_LOOKUP
+      /* Don't wait for the name server either; the connect is started
+	 when the lookup is done.  */
+      if (is_non_blocking_client
+	  && (lookup = start_network_lookup (SSDATA (host), portstring,
+					     &hints)))
+	{
+	  immediate_quit = 0;
+	  dynwind_begin ();
+	  s = -1;
+	  goto create_process;
+	}
+#endif
+
       ret = getaddrinfo (SSDATA (host), portstring, &hints, &res);
       if (ret)
 #ifdef HAVE_GAI_STRERROR
@@ -3352,6 +3815,7 @@ usage: (make-network-process &rest ARGS)  */)
 			 contact, xerrno);
     }
 
+ create_process:
   inch = s;
   outch = s;
 
@@ -3359,9 +3823,12 @@ usage: (make-network-process &rest ARGS)  */)
     buffer = Fget_buffer_create (buffer);
   proc = make_process (name);
 
-  chan_process[inch] = proc;
-
-  fcntl (inch, F_SETFL, O_NONBLOCK);
+  /* INCH is -1 while a host name lookup is pending.  */
+  if (inch >= 0)
+    {
+      chan_process[inch] = proc;
+      fcntl (inch, F_SETFL, O_NONBLOCK);
+    }
 
   p = XPROCESS (proc);
 
@@ -3402,6 +3869,15 @@ usage: (make-network-process &rest ARGS)  */)
 	 in that case, we still need to signal this like a non-blocking
 	 connection.  */
       pset_status (p, Qconnect);
+#ifdef ASYNC_NETWORK_LOOKUP
+      if (lookup)
+	{
+	  lookup->proc = proc;
+	  add_read_fd (lookup->pipe[0], network_lookup_done, lookup);
+	  FD_SET (lookup->pipe[0], &non_keyboard_wait_mask);
+	}
+      else
+#endif
       if (!FD_ISSET (inch, &connect_wait_mask))
 	{
 	  FD_SET (inch, &connect_wait_mask);
@@ -3868,6 +4344,13 @@ deactivate_process (Lisp_Object proc)
   emacs_gnutls_deinit (proc);
 #endif /* HAVE_GNUTLS */
 
+  /* Output that was not written yet is lost.  */
+  if (p->write_buf_len > 0)
+    {
+      delete_write_fd (p->outfd);
+      p->write_buf_len = 0;
+    }
+
 #ifdef ADAPTIVE_READ_BUFFERING
   if (p->read_output_delay > 0)
     {
@@ -3922,6 +4405,27 @@ deactivate_process (Lisp_Object proc)
     }
 }
 
+#ifdef HAVE_GNUTLS
+/* Tell the sentinel of network process PROC how the TLS handshake
+   that `gnutls-boot' left running ended.  If REASON is nil, the session
+   is established; otherwise REASON is a string saying why it failed,
+   and PROC is closed.  */
+
+void
+finish_process_tls (Lisp_Object proc, Lisp_Object reason)
+{
+  if (NILP (reason))
+    exec_sentinel (proc, build_string ("TLS established\n"));
+  else
+    {
+      deactivate_process (proc);
+      pset_status (XPROCESS (proc), Qfailed);
+      exec_sentinel (proc, concat3 (build_string ("TLS failed: "), reason,
+				    build_string ("\n")));
+    }
+}
+#endif
+
 
 DEFUN ("accept-process-output", Faccept_process_output, Saccept_process_output,
        0, 4, 0,
@@ -4596,6 +5100,8 @@ wait_reading_process_output (intmax_t time_limit, int nsecs, int read_kbd,
 # define SELECT ns_select
 #elif defined (HAVE_GLIB)
 # define SELECT xg_select
+#elif defined USE_EPOLL
+# define SELECT epoll_select
 #else
 # define SELECT pselect
 #endif
@@ -4759,7 +5265,7 @@ wait_reading_process_output (intmax_t time_limit, int nsecs, int read_kbd,
 	      && ((d->condition & FOR_READ
 		   && FD_ISSET (channel, &Available))
 		  || (d->condition & FOR_WRITE
-		      && FD_ISSET (channel, &write_mask))))
+		      && check_write && FD_ISSET (channel, &Writeok))))
             d->func (channel, d->data);
 	}
 
@@ -4964,11 +5470,25 @@ read_and_dispose_of_process_output (struct Lisp_Process *p, char *chars,
 				    ssize_t nbytes,
 				    struct coding_system *coding);
 
+/* Read at most NBYTES bytes of output of process P from CHANNEL into
+   BUF.  Return what emacs_read would.  */
+
+static ptrdiff_t
+read_process_chunk (struct Lisp_Process *p, int channel, char *buf,
+		    ptrdiff_t nbytes)
+{
+#ifdef HAVE_GNUTLS
+  if (p->gnutls_p && p->gnutls_state)
+    return emacs_gnutls_read (p, buf, nbytes);
+#endif
+  return emacs_read (channel, buf, nbytes);
+}
+
 /* Read pending output from the process channel,
    starting with our buffered-ahead character if we have one.
    Yield number of decoded characters read.
 
-   This function reads at most 4096 characters.
+   This function reads at most PROC's read_output_max characters.
    If you want to read all available subprocess output,
    you must call it repeatedly until it returns zero.
 
@@ -4983,11 +5503,12 @@ read_process_output (Lisp_Object proc, register int channel)
   register struct Lisp_Process *p = XPROCESS (proc);
   struct coding_system *coding = proc_decode_coding_system[channel];
   int carryover = p->decoding_carryover;
-  int readmax = 4096;
+  int readmax = p->read_output_max;
   dynwind_begin ();
   Lisp_Object odeactivate;
+  USE_SAFE_ALLOCA;
 
-  chars = alloca (carryover + readmax);
+  chars = SAFE_ALLOCA (carryover + readmax);
   if (carryover)
     /* See the comment above.  */
     memcpy (chars, SDATA (p->decoding_buf), carryover);
@@ -5009,14 +5530,21 @@ read_process_output (Lisp_Object proc, register int channel)
 	  chars[carryover] = proc_buffered_char[channel];
 	  proc_buffered_char[channel] = -1;
 	}
-#ifdef HAVE_GNUTLS
-      if (p->gnutls_p && p->gnutls_state)
-	nbytes = emacs_gnutls_read (p, chars + carryover + buffered,
-				    readmax - buffered);
-      else
-#endif
-	nbytes = emacs_read (channel, chars + carryover + buffered,
-			     readmax - buffered);
+      nbytes = read_process_chunk (p, channel, chars + carryover + buffered,
+				   readmax - buffered);
+      /* Read on while more output is there, so that the filter
+	 sees it all at once.  The descriptor is nonblocking.  */
+      if (p->coalesce_output)
+	while (0 < nbytes && nbytes < readmax - buffered)
+	  {
+	    ptrdiff_t more
+	      = read_process_chunk (p, channel,
+				    chars + carryover + buffered + nbytes,
+				    readmax - buffered - nbytes);
+	    if (more <= 0)
+	      break;
+	    nbytes += more;
+	  }
 #ifdef ADAPTIVE_READ_BUFFERING
       if (nbytes > 0 && p->adaptive_read_buffering)
 	{
@@ -5055,6 +5583,7 @@ read_process_output (Lisp_Object proc, register int channel)
   if (nbytes <= 0)
     {
       if (nbytes < 0 || coding->mode & CODING_MODE_LAST_BLOCK) {
+        SAFE_FREE ();
         dynwind_end ();
         return nbytes;
       }
@@ -5075,6 +5604,7 @@ read_process_output (Lisp_Object proc, register int channel)
   /* Handling the process output should not deactivate the mark.  */
   Vdeactivate_mark = odeactivate;
 
+  SAFE_FREE ();
   dynwind_end ();
   return nbytes;
 }
@@ -5287,76 +5817,187 @@ Otherwise it discards the output.  */)
 
 /* Sending data to subprocess.  */
 
-/* In send_process, when a write fails temporarily,
-   wait_reading_process_output is called.  It may execute user code,
-   e.g. timers, that attempts to write new data to the same process.
-   We must ensure that data is sent in the right order, and not
-   interspersed half-completed with other writes (Bug#10815).  This is
-   handled by the write_queue element of struct process.  It is a list
-   with each entry having the form
+/* send_process never blocks on a full pipe.  What the process does
+   not take at once is appended to its write buffer, and written out by
+   process_write_ready when wait_reading_process_output sees that the
+   descriptor is writable.  While output is buffered, new output goes
+   behind it, so that data is sent in the right order even if timers
+   or filters send more in the meantime (Bug#10815).  */
 
-   (string . (offset . length))
+/* The most output send_process lets pile up in the write buffer of a
+   process before waiting for the process to read some.  */
+enum { PROCESS_WRITE_BUF_MAX = 64 * 1024 * 1024 };
 
-   where STRING is a lisp string, OFFSET is the offset into the
-   string's byte sequence from which we should begin to send, and
-   LENGTH is the number of bytes left to send.  */
+/* Return true if errno value ERR means a write would have blocked.  */
 
-/* Create a new entry in write_queue.
-   INPUT_OBJ should be a buffer, string Qt, or Qnil.
-   BUF is a pointer to the string sequence of the input_obj or a C
-   string in case of Qt or Qnil.  */
+static bool
+write_would_block (int err)
+{
+  return (err == EAGAIN
+#ifdef EWOULDBLOCK
+	  || err == EWOULDBLOCK
+#endif
+	  );
+}
 
-static void
-write_queue_push (struct Lisp_Process *p, Lisp_Object input_obj,
-                  const char *buf, ptrdiff_t len, bool front)
+/* Write LEN bytes at BUF to process P, as much as it takes without
+   blocking.  Return the number of bytes written, setting errno if
+   this is less than LEN.  */
+
+static ptrdiff_t
+process_write_some (struct Lisp_Process *p, const char *buf, ptrdiff_t len)
 {
-  ptrdiff_t offset;
-  Lisp_Object entry, obj;
+  ptrdiff_t written;
 
-  if (STRINGP (input_obj))
+#ifdef HAVE_GNUTLS
+  if (p->gnutls_p && p->gnutls_state)
+    written = emacs_gnutls_write (p, buf, len);
+  else
+#endif
+    written = emacs_write_sig (p->outfd, buf, len);
+#ifdef ADAPTIVE_READ_BUFFERING
+  if (p->read_output_delay > 0
+      && p->adaptive_read_buffering == 1)
     {
-      offset = buf - SSDATA (input_obj);
-      obj = input_obj;
+      p->read_output_delay = 0;
+      process_output_delay_count--;
+      p->read_output_skip = 0;
     }
-  else
+#endif
+  return written;
+}
+
+static void process_write_ready (int, void *);
+
+/* Append LEN bytes at BUF to the write buffer of process P, and start
+   watching for its descriptor to become writable if need be.  */
+
+static void
+process_write_buf_push (struct Lisp_Process *p, const char *buf,
+			ptrdiff_t len)
+{
+  ptrdiff_t end, first;
+
+  if (p->write_buf_size - p->write_buf_len < len)
     {
-      offset = 0;
-      obj = make_unibyte_string (buf, len);
+      /* Grow the ring, moving its contents to the front.  */
+      ptrdiff_t size = p->write_buf_size;
+      char *nbuf = xpalloc (NULL, &size,
+			    p->write_buf_len + len - p->write_buf_size,
+			    -1, 1);
+
+      first = min (p->write_buf_len, p->write_buf_size - p->write_buf_start);
+      if (first)
+	memcpy (nbuf, p->write_buf + p->write_buf_start, first);
+      if (first < p->write_buf_len)
+	memcpy (nbuf + first, p->write_buf, p->write_buf_len - first);
+      xfree (p->write_buf);
+      p->write_buf = nbuf;
+      p->write_buf_size = size;
+      p->write_buf_start = 0;
     }
 
-  entry = Fcons (obj, Fcons (make_number (offset), make_number (len)));
+  if (p->write_buf_len == 0)
+    add_write_fd (p->outfd, process_write_ready, p);
 
-  if (front)
-    pset_write_queue (p, Fcons (entry, p->write_queue));
-  else
-    pset_write_queue (p, nconc2 (p->write_queue, list1 (entry)));
+  end = p->write_buf_start + p->write_buf_len;
+  if (end >= p->write_buf_size)
+    end -= p->write_buf_size;
+  first = min (len, p->write_buf_size - end);
+  memcpy (p->write_buf + end, buf, first);
+  memcpy (p->write_buf, buf + first, len - first);
+  p->write_buf_len += len;
 }
 
-/* Remove the first element in the write_queue of process P, put its
-   contents in OBJ, BUF and LEN, and return true.  If the
-   write_queue is empty, return false.  */
+/* Write as much of the buffered output of process P as it takes
+   without blocking.  Return false, with errno set, if writing failed
+   for another reason than a full pipe.  */
 
 static bool
-write_queue_pop (struct Lisp_Process *p, Lisp_Object *obj,
-		 const char **buf, ptrdiff_t *len)
+process_write_buf_flush (struct Lisp_Process *p)
 {
-  Lisp_Object entry, offset_length;
-  ptrdiff_t offset;
+  while (p->write_buf_len > 0)
+    {
+      char *start = p->write_buf + p->write_buf_start;
+      ptrdiff_t first = min (p->write_buf_len,
+			     p->write_buf_size - p->write_buf_start);
+      ptrdiff_t n;
+      bool tls = false;
+
+#ifdef HAVE_GNUTLS
+      tls = p->gnutls_p && p->gnutls_state;
+#endif
+#ifndef DOS_NT
+      if (first < p->write_buf_len && !tls)
+	{
+	  /* The output wraps around; write both parts at once.  */
+	  struct iovec iov[2];
+
+	  iov[0].iov_base = start;
+	  iov[0].iov_len = first;
+	  iov[1].iov_base = p->write_buf;
+	  iov[1].iov_len = p->write_buf_len - first;
+	  while ((n = writev (p->outfd, iov, 2)) < 0 && errno == EINTR)
+	    if (pending_signals)
+	      process_pending_signals ();
+	  if (n < 0)
+	    n = 0;
+	}
+      else
+#endif
+	n = process_write_some (p, start, first);
 
-  if (NILP (p->write_queue))
-    return 0;
+      if (n == 0)
+	return write_would_block (errno);
+      p->write_buf_start += n;
+      if (p->write_buf_start >= p->write_buf_size)
+	p->write_buf_start -= p->write_buf_size;
+      p->write_buf_len -= n;
+    }
+  p->write_buf_start = 0;
+  return true;
+}
 
-  entry = XCAR (p->write_queue);
-  pset_write_queue (p, XCDR (p->write_queue));
+/* Called by wait_reading_process_output when FD, the output descriptor
+   of the process DATA with buffered output, is writable.  */
 
-  *obj = XCAR (entry);
-  offset_length = XCDR (entry);
+static void
+process_write_ready (int fd, void *data)
+{
+  struct Lisp_Process *p = data;
+  Lisp_Object proc;
 
-  *len = XINT (XCDR (offset_length));
-  offset = XINT (XCAR (offset_length));
-  *buf = SSDATA (*obj) + offset;
+  if (process_write_buf_flush (p))
+    {
+      if (p->write_buf_len == 0)
+	delete_write_fd (fd);
+      return;
+    }
 
-  return 1;
+  /* The process cannot take output anymore; close it as
+     send_process does.  */
+  XSETPROCESS (proc, p);
+  p->raw_status_new = 0;
+  pset_status (p, list2 (Qexit, make_number (256)));
+  p->tick = ++process_tick;
+  deactivate_process (proc);
+}
+
+/* Wait until at most LIMIT bytes of output are buffered for process
+   P, or P's output is closed.  */
+
+static void
+wait_for_process_write_buf (struct Lisp_Process *p, ptrdiff_t limit)
+{
+  while (p->write_buf_len > limit && p->outfd >= 0)
+    {
+      wait_reading_process_output (0, 20 * 1000 * 1000,
+				   0, 0, Qnil, NULL, 0);
+      /* Without a write mask, nothing tells when to write.  */
+      if (!SELECT_CAN_DO_WRITE_MASK
+	  && p->write_buf_len > 0 && p->outfd >= 0)
+	process_write_ready (p->outfd, p);
+    }
 }
 
 /* Send some data to process PROC.
@@ -5374,7 +6015,6 @@ send_process (Lisp_Object proc, const char *buf, ptrdiff_t len,
 	      Lisp_Object object)
 {
   struct Lisp_Process *p = XPROCESS (proc);
-  ssize_t rv;
   struct coding_system *coding;
 
   if (p->raw_status_new)
@@ -5469,123 +6109,90 @@ send_process (Lisp_Object proc, const char *buf, ptrdiff_t len,
       buf = SSDATA (object);
     }
 
-  /* If there is already data in the write_queue, put the new data
-     in the back of queue.  Otherwise, ignore it.  */
-  if (!NILP (p->write_queue))
-    write_queue_push (p, object, buf, len, 0);
-
-  do   /* while !NILP (p->write_queue) */
+#ifdef DATAGRAM_SOCKETS
+  if (DATAGRAM_CHAN_P (p->outfd))
     {
-      ptrdiff_t cur_len = -1;
-      const char *cur_buf;
-      Lisp_Object cur_object;
-
-      /* If write_queue is empty, ignore it.  */
-      if (!write_queue_pop (p, &cur_object, &cur_buf, &cur_len))
+      /* Datagrams cannot be merged in the write buffer; wait until
+	 this one can be sent.  */
+      for (;;)
 	{
-	  cur_len = len;
-	  cur_buf = buf;
-	  cur_object = object;
+	  int outfd = p->outfd;
+	  ssize_t rv;
+
+	  if (outfd < 0)
+	    error ("Output file descriptor of %s is closed", SDATA (p->name));
+	  rv = sendto (outfd, buf, len, 0, datagram_address[outfd].sa,
+		       datagram_address[outfd].len);
+	  if (rv >= 0)
+	    return;
+	  if (errno == EMSGSIZE)
+	    report_file_error ("Sending datagram", proc);
+	  if (!write_would_block (errno) && errno != EINTR)
+	    report_file_error ("Writing to process", proc);
+	  wait_reading_process_output (0, 20 * 1000 * 1000,
+				       0, 0, Qnil, NULL, 0);
 	}
+    }
+#endif
 
-      while (cur_len > 0)
+  /* Unless output is already waiting, write what the process takes
+     now.  */
+  if (len > 0 && p->write_buf_len == 0)
+    {
+      ptrdiff_t written = process_write_some (p, buf, len);
+
+      if (written == 0 && !write_would_block (errno))
 	{
-	  /* Send this batch, using one or more write calls.  */
-	  ptrdiff_t written = 0;
-	  int outfd = p->outfd;
-#ifdef DATAGRAM_SOCKETS
-	  if (DATAGRAM_CHAN_P (outfd))
+	  if (errno == EPIPE)
 	    {
-	      rv = sendto (outfd, cur_buf, cur_len,
-			   0, datagram_address[outfd].sa,
-			   datagram_address[outfd].len);
-	      if (rv >= 0)
-		written = rv;
-	      else if (errno == EMSGSIZE)
-		report_file_error ("Sending datagram", proc);
+	      p->raw_status_new = 0;
+	      pset_status (p, list2 (Qexit, make_number (256)));
+	      p->tick = ++process_tick;
+	      deactivate_process (proc);
+	      error ("process %s no longer connected to pipe; closed it",
+		     SDATA (p->name));
 	    }
 	  else
-#endif
-	    {
-#ifdef HAVE_GNUTLS
-	      if (p->gnutls_p && p->gnutls_state)
-		written = emacs_gnutls_write (p, cur_buf, cur_len);
-	      else
-#endif
-		written = emacs_write_sig (outfd, cur_buf, cur_len);
-	      rv = (written ? 0 : -1);
-#ifdef ADAPTIVE_READ_BUFFERING
-	      if (p->read_output_delay > 0
-		  && p->adaptive_read_buffering == 1)
-		{
-		  p->read_output_delay = 0;
-		  process_output_delay_count--;
-		  p->read_output_skip = 0;
-		}
-#endif
-	    }
+	    /* This is a real error.  */
+	    report_file_error ("Writing to process", proc);
+	}
 
-	  if (rv < 0)
-	    {
-	      if (errno == EAGAIN
-#ifdef EWOULDBLOCK
-		  || errno == EWOULDBLOCK
-#endif
-		  )
-		/* Buffer is full.  Wait, accepting input;
-		   that may allow the program
-		   to finish doing output and read more.  */
-		{
 #ifdef BROKEN_PTY_READ_AFTER_EAGAIN
-		  /* A gross hack to work around a bug in FreeBSD.
-		     In the following sequence, read(2) returns
-		     bogus data:
-
-		     write(2)	 1022 bytes
-		     write(2)   954 bytes, get EAGAIN
-		     read(2)   1024 bytes in process_read_output
-		     read(2)     11 bytes in process_read_output
-
-		     That is, read(2) returns more bytes than have
-		     ever been written successfully.  The 1033 bytes
-		     read are the 1022 bytes written successfully
-		     after processing (for example with CRs added if
-		     the terminal is set up that way which it is
-		     here).  The same bytes will be seen again in a
-		     later read(2), without the CRs.  */
-
-		  if (errno == EAGAIN)
-		    {
-		      int flags = FWRITE;
-		      ioctl (p->outfd, TIOCFLUSH, &flags);
-		    }
+      /* A gross hack to work around a bug in FreeBSD.
+	 In the following sequence, read(2) returns
+	 bogus data:
+
+	 write(2)	 1022 bytes
+	 write(2)   954 bytes, get EAGAIN
+	 read(2)   1024 bytes in process_read_output
+	 read(2)     11 bytes in process_read_output
+
+	 That is, read(2) returns more bytes than have
+	 ever been written successfully.  The 1033 bytes
+	 read are the 1022 bytes written successfully
+	 after processing (for example with CRs added if
+	 the terminal is set up that way which it is
+	 here).  The same bytes will be seen again in a
+	 later read(2), without the CRs.  */
+
+      if (written < len && errno == EAGAIN)
+	{
+	  int flags = FWRITE;
+	  ioctl (p->outfd, TIOCFLUSH, &flags);
+	}
 #endif /* BROKEN_PTY_READ_AFTER_EAGAIN */
 
-		  /* Put what we should have written in wait_queue.  */
-		  write_queue_push (p, cur_object, cur_buf, cur_len, 1);
-		  wait_reading_process_output (0, 20 * 1000 * 1000,
-					       0, 0, Qnil, NULL, 0);
-		  /* Reread queue, to see what is left.  */
-		  break;
-		}
-	      else if (errno == EPIPE)
-		{
-		  p->raw_status_new = 0;
-		  pset_status (p, list2 (Qexit, make_number (256)));
-		  p->tick = ++process_tick;
-		  deactivate_process (proc);
-		  error ("process %s no longer connected to pipe; closed it",
-			 SDATA (p->name));
-		}
-	      else
-		/* This is a real error.  */
-		report_file_error ("Writing to process", proc);
-	    }
-	  cur_buf += written;
-	  cur_len -= written;
-	}
+      buf += written;
+      len -= written;
     }
-  while (!NILP (p->write_queue));
+
+  /* Leave the rest to process_write_ready.  */
+  if (len > 0)
+    process_write_buf_push (p, buf, len);
+
+  /* Don't let the buffered output grow without bound.  */
+  wait_for_process_write_buf (p, (SELECT_CAN_DO_WRITE_MASK
+				  ? PROCESS_WRITE_BUF_MAX : 0));
 }
 
 DEFUN ("process-send-region", Fprocess_send_region, Sprocess_send_region,
@@ -6058,6 +6665,10 @@ process has been transmitted to the serial port.  */)
       send_process (proc, "", 0, Qnil);
     }
 
+  /* The EOF must come after the output still buffered.  */
+  if (!XPROCESS (proc)->pty_flag)
+    wait_for_process_write_buf (XPROCESS (proc), 0);
+
   if (XPROCESS (proc)->pty_flag)
     send_process (proc, "\004", 1, Qnil);
   else if (EQ (XPROCESS (proc)->type, Qserial))
@@ -6850,6 +7461,9 @@ void
 delete_keyboard_wait_descriptor (int desc)
 {
 #ifdef subprocesses
+#ifdef USE_EPOLL
+  epoll_forget (desc);
+#endif
   FD_CLR (desc, &input_wait_mask);
   FD_CLR (desc, &non_process_wait_mask);
   delete_input_desc (desc);
@@ -6867,20 +7481,24 @@ setup_process_coding_systems (Lisp_Object process)
   int outch = p->outfd;
   Lisp_Object coding_system;
 
-  if (inch < 0 || outch < 0)
-    return;
-
-  if (!proc_decode_coding_system[inch])
-    proc_decode_coding_system[inch] = xmalloc (sizeof (struct coding_system));
-  coding_system = p->decode_coding_system;
-  if (EQ (p->filter, Qinternal_default_process_filter)
-      && BUFFERP (p->buffer))
+  /* A process piped into another has no INCH.  */
+  if (inch >= 0)
     {
-      if (NILP (BVAR (XBUFFER (p->buffer), enable_multibyte_characters)))
-	coding_system = raw_text_coding_system (coding_system);
+      if (!proc_decode_coding_system[inch])
+	proc_decode_coding_system[inch]
+	  = xmalloc (sizeof (struct coding_system));
+      coding_system = p->decode_coding_system;
+      if (EQ (p->filter, Qinternal_default_process_filter)
+	  && BUFFERP (p->buffer))
+	{
+	  if (NILP (BVAR (XBUFFER (p->buffer), enable_multibyte_characters)))
+	    coding_system = raw_text_coding_system (coding_system);
+	}
+      setup_coding_system (coding_system, proc_decode_coding_system[inch]);
     }
-  setup_coding_system (coding_system, proc_decode_coding_system[inch]);
 
+  if (outch < 0)
+    return;
   if (!proc_encode_coding_system[outch])
     proc_encode_coding_system[outch] = xmalloc (sizeof (struct coding_system));
   setup_coding_system (p->encode_coding_system,
@@ -7320,6 +7938,18 @@ then a pipe is used in any case.
 The value takes effect when `start-process' is called.  */);
   Vprocess_connection_type = Qt;
 
+  DEFVAR_LISP ("process-pipe-destination", Vprocess_pipe_destination,
+	       doc: /* If non-nil, a process to read the output of new processes.
+When this is a running process that reads its input through a pipe,
+the standard output and error of a program that `start-process'
+starts go straight into that pipe, as in a shell pipeline, rather than
+through Emacs.  The new process reads its own input through a pipe,
+whatever `process-connection-type' says, and its filter never gets any
+output.  Emacs can no longer send text to the destination, which sees
+end-of-file once the new process and any others piped into it exit.
+Bind this around a call to `start-process'; do not set it.  */);
+  Vprocess_pipe_destination = Qnil;
+
 #ifdef ADAPTIVE_READ_BUFFERING
   DEFVAR_LISP ("process-adaptive-read-buffering", Vprocess_adaptive_read_buffering,
 	       doc: /* If non-nil, improve receive buffering by delaying after short reads.
@@ -7333,5 +7963,19 @@ non-nil value means that the delay is not reset on write.
 The variable takes effect when `start-process' is called.  */);
   Vprocess_adaptive_read_buffering = Qt;
 #endif
+
+  DEFVAR_INT ("read-process-output-max", read_process_output_max,
+	      doc: /* Maximum number of bytes to read from a subprocess at once.
+Larger values let output that arrives quickly be decoded and passed
+to the process filter in fewer, bigger chunks.
+The variable takes effect when a process is created.  */);
+  read_process_output_max = 4096;
+
+  DEFVAR_BOOL ("read-process-output-coalesce", read_process_output_coalesce,
+	       doc: /* Non-nil means read all available output before filtering it.
+Emacs then keeps reading from a subprocess while it has output ready,
+up to `read-process-output-max' bytes, before calling the filter once.
+The variable takes effect when a process is created.  */);
+  read_process_output_coalesce = 0;
 #endif	/* subprocesses */
 }
@@ -98,11 +98,12 @@ struct Lisp_Process
     /* Working buffer for encoding.  */
     Lisp_Object encoding_buf;
 
-    /* Queue for storing waiting writes */
-    Lisp_Object write_queue;
-
 #ifdef HAVE_GNUTLS
     Lisp_Object gnutls_cred_type;
+
+    /* The property list given to `gnutls-boot' with :nowait, while
+       the handshake goes on in the background; nil otherwise.  */
+    Lisp_Object gnutls_boot_parameters;
 #endif
 
     /* After this point, there are no Lisp_Objects any more.  */
@@ -126,6 +127,9 @@ struct Lisp_Process
     EMACS_INT update_tick;
     /* Size of carryover in decoding.  */
     int decoding_carryover;
+    /* Most bytes to read from the process at once.
+       Initialized from `read-process-output-max'.  */
+    int read_output_max;
     /* Hysteresis to try to read process output in larger blocks.
        On some systems, e.g. GNU/Linux, Emacs is seen as
        an interactive app also when reading process output, meaning
@@ -139,6 +143,10 @@ struct Lisp_Process
     unsigned int adaptive_read_buffering : 2;
     /* Skip reading this process on next read.  */
     bool_bf read_output_skip : 1;
+    /* True means read all the output available, up to read_output_max
+       bytes, before passing any of it to the filter.
+       Initialized from `read-process-output-coalesce'.  */
+    bool_bf coalesce_output : 1;
     /* True means kill silently if Emacs is exited.
        This is the inverse of the `query-on-exit' flag.  */
     bool_bf kill_without_query : 1;
@@ -157,6 +165,12 @@ struct Lisp_Process
     bool_bf raw_status_new : 1;
     int raw_status;
 
+    /* Output that could not be written yet without blocking, in a ring
+       buffer of WRITE_BUF_SIZE bytes: WRITE_BUF_LEN bytes starting at
+       offset WRITE_BUF_START, wrapping around at the end.  */
+    char *write_buf;
+    ptrdiff_t write_buf_size, write_buf_start, write_buf_len;
+
 #ifdef HAVE_GNUTLS
     gnutls_initstage_t gnutls_initstage;
     gnutls_session_t gnutls_state;
@@ -188,6 +202,12 @@ pset_gnutls_cred_type (struct Lisp_Process *p, Lisp_Object val)
 {
   p->gnutls_cred_type = val;
 }
+
+INLINE void
+pset_gnutls_boot_parameters (struct Lisp_Process *p, Lisp_Object val)
+{
+  p->gnutls_boot_parameters = val;
+}
 #endif
 
 /* True means don't run process sentinels.  This is used
@@ -237,6 +257,9 @@ extern void delete_read_fd (int fd);
 extern void add_write_fd (int fd, fd_callback func, void *data);
 extern void delete_write_fd (int fd);
 extern void catch_child_signal (void);
+#ifdef HAVE_GNUTLS
+extern void finish_process_tls (Lisp_Object, Lisp_Object);
+#endif
 
 #ifdef WINDOWSNT
 extern Lisp_Object network_interface_list (void);
@@ -0,0 +1,622 @@
+/* Profiler implementation.
+
+Copyright (C) 2012-2014 Free Software Foundation, Inc.
+
+This file is part of GNU Emacs.
+
+GNU Emacs is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GNU Emacs is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include <config.h>
+#include "lisp.h"
+#include "syssignal.h"
+#include "systime.h"
+#include "keyboard.h"
+
+/* Return A + B, but return the maximum fixnum if the result would overflow.
+   Assume A and B are nonnegative and in fixnum range.  */
+
+static EMACS_INT
+saturated_add (EMACS_INT a, EMACS_INT b)
+{
+  return min (a + b, MOST_POSITIVE_FIXNUM);
+}
+
+/* Logs.  */
+
+/* A log is a hash table mapping backtraces to counts.  Every backtrace
+   is a vector of `profiler-max-stack-depth' functions, innermost
+   first, where the last few elements may be nil.  */
+
+typedef Lisp_Object log_t;
+
+static Lisp_Object Qautomatic_gc;
+
+static log_t
+make_log (EMACS_INT heap_size)
+{
+  return make_hash_table (hashtest_equal, make_number (heap_size),
+			  make_float (DEFAULT_REHASH_SIZE),
+			  make_float (DEFAULT_REHASH_THRESHOLD),
+			  Qnil);
+}
+
+/* Evict the least used half of the hash_table.
+
+   When the table is full, we have to evict someone.
+   The easiest and most efficient is to evict the value we're about to add
+   (i.e. once the table is full, stop sampling).
+
+   We could also pick the element with the lowest count and evict it,
+   but finding it is O(N) and for that amount of work we could actually
+   evict all the N/2 lowest elements: approximate the median by sampling
+   a few counts and remove everything below it.  */
+
+static EMACS_INT
+approximate_median (struct Lisp_Hash_Table *log,
+		    ptrdiff_t start, ptrdiff_t size)
+{
+  eassert (size > 0);
+  if (size < 2)
+    return XINT (HASH_VALUE (log, start));
+  if (size < 3)
+    /* Not an actual median, but better for our application than
+       choosing either of the two numbers.  */
+    return ((XINT (HASH_VALUE (log, start))
+	     + XINT (HASH_VALUE (log, start + 1)))
+	    / 2);
+  else
+    {
+      ptrdiff_t newsize = size / 3;
+      ptrdiff_t start2 = start + newsize;
+      EMACS_INT i1 = approximate_median (log, start, newsize);
+      EMACS_INT i2 = approximate_median (log, start2, newsize);
+      EMACS_INT i3 = approximate_median (log, start2 + newsize,
+					 size - 2 * newsize);
+      return (i1 < i2
+	      ? (i2 < i3 ? i2 : (i1 < i3 ? i3 : i1))
+	      : (i1 < i3 ? i1 : (i2 < i3 ? i3 : i2)));
+    }
+}
+
+static void
+evict_lower_half (struct Lisp_Hash_Table *log)
+{
+  ptrdiff_t size = HASH_TABLE_SIZE (log);
+  EMACS_INT median = approximate_median (log, 0, size);
+  ptrdiff_t i;
+
+  for (i = 0; i < size; i++)
+    /* Evict not only values smaller but also values equal to the median,
+       so as to make sure we evict something no matter what.  */
+    if (!NILP (HASH_HASH (log, i))
+	&& XINT (HASH_VALUE (log, i)) <= median)
+      hash_remove_from_table (log, HASH_KEY (log, i));
+}
+
+/* Return the name under which the Guile procedure FUN should appear in
+   a backtrace: the Elisp symbol of the same name if it has one, the
+   procedure itself otherwise.  */
+
+static Lisp_Object
+backtrace_function (Lisp_Object fun)
+{
+  Lisp_Object name = scm_procedure_name (fun);
+  size_t nbytes;
+  char *str;
+
+  if (!scm_is_symbol (name))
+    return fun;
+
+  str = scm_to_utf8_stringn (scm_symbol_to_string (name), &nbytes);
+  name = intern_1 (str, nbytes);
+  free (str);
+  return name;
+}
+
+/* Return a vector of the functions of the innermost DEPTH frames of
+   the Guile VM stack, which includes the frames of the Elisp
+   functions being run.  */
+
+static Lisp_Object
+get_backtrace (ptrdiff_t depth)
+{
+  Lisp_Object backtrace = Fmake_vector (make_number (depth), Qnil);
+  SCM stack = scm_make_stack (SCM_BOOL_T, SCM_EOL);
+  SCM frame;
+  ptrdiff_t i = 0;
+
+  if (scm_is_false (stack))
+    return backtrace;
+
+  for (frame = scm_stack_ref (stack, SCM_INUM0);
+       i < depth && scm_is_true (frame);
+       frame = scm_frame_previous (frame))
+    {
+      Lisp_Object fun = scm_frame_procedure (frame);
+      if (scm_is_true (scm_procedure_p (fun)))
+	ASET (backtrace, i++, backtrace_function (fun));
+    }
+
+  return backtrace;
+}
+
+/* Record the current backtrace in LOG.  COUNT is the weight of this
+   current backtrace: interrupt counts for CPU, and the allocation
+   size for memory.  */
+
+static void
+record_backtrace (log_t log, EMACS_INT count)
+{
+  struct Lisp_Hash_Table *h = XHASH_TABLE (log);
+  Lisp_Object backtrace;
+  EMACS_UINT hash;
+  ptrdiff_t j;
+
+  if (h->count >= profiler_log_size)
+    evict_lower_half (h);
+
+  backtrace = get_backtrace (profiler_max_stack_depth);
+  j = hash_lookup (h, backtrace, &hash);
+  if (j >= 0)
+    {
+      EMACS_INT old_val = XINT (HASH_VALUE (h, j));
+      EMACS_INT new_val = saturated_add (old_val, count);
+      set_hash_value_slot (h, j, make_number (new_val));
+    }
+  else
+    hash_put (h, backtrace, make_number (count), hash);
+}
+
+/* Sampling profiler.  */
+
+#ifdef PROFILER_CPU_SUPPORT
+
+/* The profiler timer and whether it was properly initialized, if
+   POSIX timers are available.  */
+#ifdef HAVE_ITIMERSPEC
+static timer_t profiler_timer;
+static bool profiler_timer_ok;
+#endif
+
+/* Status of sampling profiler.  */
+static enum profiler_cpu_running
+  { NOT_RUNNING, TIMER_SETTIME_RUNNING, SETITIMER_RUNNING }
+  profiler_cpu_running;
+
+/* Hash-table log of CPU profiler.  */
+static Lisp_Object cpu_log;
+
+/* Separate counter for the time spent in the GC.  */
+static EMACS_INT cpu_gc_count;
+
+/* Number of ticks that arrived since the last backtrace was recorded.
+   Walking the Guile stack allocates, so it cannot be done in the
+   signal handler; it is done by process_pending_signals instead.  */
+static volatile sig_atomic_t cpu_pending_ticks;
+
+/* The current sampling interval in nanoseconds.  */
+static EMACS_INT current_sampling_interval;
+
+/* Signal handler for sampling profiler.  */
+
+static void
+handle_profiler_signal (int signal)
+{
+  EMACS_INT count = 1;
+
+#ifdef HAVE_ITIMERSPEC
+  if (profiler_timer_ok)
+    {
+      int overruns = timer_getoverrun (profiler_timer);
+      eassert (overruns >= 0);
+      count += overruns;
+    }
+#endif
+
+  if (gc_in_progress)
+    /* Special case the time spent in the GC: the collector has the
+       world stopped, so there is no meaningful Lisp backtrace.  */
+    cpu_gc_count = saturated_add (cpu_gc_count, count);
+  else
+    {
+      cpu_pending_ticks += count;
+      pending_signals = 1;
+    }
+}
+
+static void
+deliver_profiler_signal (int signal)
+{
+  deliver_process_signal (signal, handle_profiler_signal);
+}
+
+static int
+setup_cpu_timer (Lisp_Object sampling_interval)
+{
+  struct sigaction action;
+  struct itimerval timer;
+  struct timespec interval;
+  int billion = 1000000000;
+
+  if (! RANGED_INTEGERP (1, sampling_interval,
+			 (TYPE_MAXIMUM (time_t) < EMACS_INT_MAX / billion
+			  ? ((EMACS_INT) TYPE_MAXIMUM (time_t) * billion
+			     + (billion - 1))
+			  : EMACS_INT_MAX)))
+    return -1;
+
+  current_sampling_interval = XINT (sampling_interval);
+  interval = make_timespec (current_sampling_interval / billion,
+			    current_sampling_interval % billion);
+  emacs_sigaction_init (&action, deliver_profiler_signal);
+  sigaction (SIGPROF, &action, 0);
+
+#ifdef HAVE_ITIMERSPEC
+  if (! profiler_timer_ok)
+    {
+      /* System clocks to try, in decreasing order of desirability.  */
+      static clockid_t const system_clock[] = {
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	CLOCK_THREAD_CPUTIME_ID,
+#endif
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+	CLOCK_PROCESS_CPUTIME_ID,
+#endif
+#ifdef CLOCK_MONOTONIC
+	CLOCK_MONOTONIC,
+#endif
+	CLOCK_REALTIME
+      };
+      int i;
+      struct sigevent sigev;
+      sigev.sigev_value.sival_ptr = &profiler_timer;
+      sigev.sigev_signo = SIGPROF;
+      sigev.sigev_notify = SIGEV_SIGNAL;
+
+      for (i = 0; i < sizeof system_clock / sizeof *system_clock; i++)
+	if (timer_create (system_clock[i], &sigev, &profiler_timer) == 0)
+	  {
+	    profiler_timer_ok = 1;
+	    break;
+	  }
+    }
+
+  if (profiler_timer_ok)
+    {
+      struct itimerspec ispec;
+      ispec.it_value = ispec.it_interval = interval;
+      if (timer_settime (profiler_timer, 0, &ispec, 0) == 0)
+	return TIMER_SETTIME_RUNNING;
+    }
+#endif
+
+#ifdef HAVE_SETITIMER
+  timer.it_value = timer.it_interval = make_timeval (interval);
+  if (setitimer (ITIMER_PROF, &timer, 0) == 0)
+    return SETITIMER_RUNNING;
+#endif
+
+  return NOT_RUNNING;
+}
+
+DEFUN ("profiler-cpu-start", Fprofiler_cpu_start, Sprofiler_cpu_start,
+       1, 1, 0,
+       doc: /* Start or restart the cpu profiler.
+It takes call-stack samples each SAMPLING-INTERVAL nanoseconds, approximately.
+See also `profiler-log-size' and `profiler-max-stack-depth'.  */)
+  (Lisp_Object sampling_interval)
+{
+  int status;
+
+  if (profiler_cpu_running)
+    error ("CPU profiler is already running");
+
+  if (NILP (cpu_log))
+    {
+      cpu_gc_count = 0;
+      cpu_log = make_log (profiler_log_size);
+    }
+
+  status = setup_cpu_timer (sampling_interval);
+  if (status == -1)
+    {
+      profiler_cpu_running = NOT_RUNNING;
+      error ("Invalid sampling interval");
+    }
+  else
+    {
+      profiler_cpu_running = status;
+      if (! profiler_cpu_running)
+	error ("Unable to start profiler timer");
+    }
+
+  return Qt;
+}
+
+DEFUN ("profiler-cpu-stop", Fprofiler_cpu_stop, Sprofiler_cpu_stop,
+       0, 0, 0,
+       doc: /* Stop the cpu profiler.  The profiler log is not affected.
+Return non-nil if the profiler was running.  */)
+  (void)
+{
+  switch (profiler_cpu_running)
+    {
+    case NOT_RUNNING:
+      return Qnil;
+
+#ifdef HAVE_ITIMERSPEC
+    case TIMER_SETTIME_RUNNING:
+      {
+	struct itimerspec disable;
+	memset (&disable, 0, sizeof disable);
+	timer_settime (profiler_timer, 0, &disable, 0);
+      }
+      break;
+#endif
+
+#ifdef HAVE_SETITIMER
+    case SETITIMER_RUNNING:
+      {
+	struct itimerval disable;
+	memset (&disable, 0, sizeof disable);
+	setitimer (ITIMER_PROF, &disable, 0);
+      }
+      break;
+#endif
+    }
+
+  signal (SIGPROF, SIG_IGN);
+  profiler_cpu_running = NOT_RUNNING;
+  cpu_pending_ticks = 0;
+  return Qt;
+}
+
+DEFUN ("profiler-cpu-running-p",
+       Fprofiler_cpu_running_p, Sprofiler_cpu_running_p,
+       0, 0, 0,
+       doc: /* Return non-nil if cpu profiler is running.  */)
+  (void)
+{
+  return profiler_cpu_running ? Qt : Qnil;
+}
+
+DEFUN ("profiler-cpu-log", Fprofiler_cpu_log, Sprofiler_cpu_log,
+       0, 0, 0,
+       doc: /* Return the current cpu profiler log.
+The log is a hash-table mapping backtraces to counters which represent
+the amount of time spent at those points.  Every backtrace is a vector
+of functions, where the last few elements may be nil.
+Before returning, a new log is allocated for future samples.  */)
+  (void)
+{
+  Lisp_Object result = cpu_log;
+
+  if (NILP (result))
+    return Qnil;
+
+  /* Here we're making the log visible to Elisp, so it's not safe any
+     more for our use afterwards.  So we have to allocate a new one.  */
+  cpu_log = profiler_cpu_running ? make_log (profiler_log_size) : Qnil;
+  Fputhash (Fmake_vector (make_number (1), Qautomatic_gc),
+	    make_number (cpu_gc_count),
+	    result);
+  cpu_gc_count = 0;
+  return result;
+}
+#endif /* PROFILER_CPU_SUPPORT */
+
+/* Record the samples taken by the CPU profiler since the last call.
+   Called from process_pending_signals, where it is safe to walk the
+   stack and allocate.  */
+
+void
+profiler_record_pending (void)
+{
+#ifdef PROFILER_CPU_SUPPORT
+  EMACS_INT count = cpu_pending_ticks;
+
+  if (count == 0 || NILP (cpu_log))
+    return;
+  cpu_pending_ticks = 0;
+  record_backtrace (cpu_log, count);
+#endif
+}
+
+/* Memory profiler.  */
+
+/* True if memory profiler is running.  */
+bool profiler_memory_running;
+
+static Lisp_Object memory_log;
+
+/* Bytes allocated since the last backtrace was recorded.  */
+static EMACS_INT memory_pending_bytes;
+
+/* If positive, the memory profiler counts Lisp objects instead of
+   bytes, and takes a backtrace every this many objects.  This is the
+   value `profiler-memory-allocation-interval' had when it started.  */
+static EMACS_INT memory_allocation_interval;
+
+/* Lisp objects made since the last backtrace was recorded.  */
+static EMACS_INT memory_pending_objects;
+
+/* True while a backtrace is being recorded.  That allocates too, and
+   those allocations are not sampled.  */
+static bool memory_in_probe;
+
+DEFUN ("profiler-memory-start", Fprofiler_memory_start, Sprofiler_memory_start,
+       0, 0, 0,
+       doc: /* Start/restart the memory profiler.
+The memory profiler will take samples of the call-stack whenever a new
+allocation takes place.  Allocations are sampled: a backtrace is taken
+once every `profiler-memory-sampling-interval' bytes allocated, or once
+every `profiler-memory-allocation-interval' conses, floats, strings and
+vectors made if that is positive.
+See also `profiler-log-size' and `profiler-max-stack-depth'.  */)
+  (void)
+{
+  if (profiler_memory_running)
+    error ("Memory profiler is already running");
+
+  if (NILP (memory_log))
+    memory_log = make_log (profiler_log_size);
+
+  memory_pending_bytes = 0;
+  memory_pending_objects = 0;
+  memory_allocation_interval = max (profiler_memory_allocation_interval, 0);
+  profiler_memory_running = true;
+
+  return Qt;
+}
+
+DEFUN ("profiler-memory-stop",
+       Fprofiler_memory_stop, Sprofiler_memory_stop,
+       0, 0, 0,
+       doc: /* Stop the memory profiler.  The profiler log is not affected.
+Return non-nil if the profiler was running.  */)
+  (void)
+{
+  if (!profiler_memory_running)
+    return Qnil;
+  profiler_memory_running = false;
+  return Qt;
+}
+
+DEFUN ("profiler-memory-running-p",
+       Fprofiler_memory_running_p, Sprofiler_memory_running_p,
+       0, 0, 0,
+       doc: /* Return non-nil if memory profiler is running.
+The value is `allocations' if it counts the objects made rather than
+the bytes allocated.  */)
+  (void)
+{
+  if (!profiler_memory_running)
+    return Qnil;
+  return memory_allocation_interval > 0 ? Qallocations : Qt;
+}
+
+DEFUN ("profiler-memory-log",
+       Fprofiler_memory_log, Sprofiler_memory_log,
+       0, 0, 0,
+       doc: /* Return the current memory profiler log.
+The log is a hash-table mapping backtraces to counters which represent
+the amount of memory allocated at those points, or the number of
+objects made there if the profiler counts objects.  Every backtrace is a vector
+of functions, where the last few elements may be nil.
+Before returning, a new log is allocated for future samples.  */)
+  (void)
+{
+  Lisp_Object result = memory_log;
+  /* Here we're making the log visible to Elisp, so it's not safe any
+     more for our use afterwards.  So we have to allocate a new one.  */
+  memory_log = (profiler_memory_running
+		? make_log (profiler_log_size)
+		: Qnil);
+  return result;
+}
+
+
+/* Signals and probes.  */
+
+/* Record that the current backtrace allocated SIZE bytes.  */
+
+void
+malloc_probe (size_t size)
+{
+  EMACS_INT count;
+
+  if (memory_allocation_interval > 0)
+    return;
+  memory_pending_bytes = saturated_add (memory_pending_bytes,
+					min (size, MOST_POSITIVE_FIXNUM));
+  if (memory_in_probe
+      || memory_pending_bytes < profiler_memory_sampling_interval
+      || NILP (memory_log))
+    return;
+
+  count = memory_pending_bytes;
+  memory_pending_bytes = 0;
+  memory_in_probe = true;
+  record_backtrace (memory_log, count);
+  memory_in_probe = false;
+}
+
+/* Record that the current backtrace made a Lisp object, and allocated
+   SIZE bytes for it that malloc_probe was not told about.  */
+
+void
+object_probe (size_t size)
+{
+  EMACS_INT count;
+
+  if (memory_allocation_interval <= 0)
+    {
+      if (size)
+	malloc_probe (size);
+      return;
+    }
+  memory_pending_objects++;
+  if (memory_in_probe || memory_pending_objects < memory_allocation_interval
+      || NILP (memory_log))
+    return;
+
+  count = memory_pending_objects;
+  memory_pending_objects = 0;
+  memory_in_probe = true;
+  record_backtrace (memory_log, count);
+  memory_in_probe = false;
+}
+
+void
+syms_of_profiler (void)
+{
+#include "profiler.x"
+
+  DEFVAR_INT ("profiler-max-stack-depth", profiler_max_stack_depth,
+	      doc: /* Number of elements from the call-stack recorded in the log.  */);
+  profiler_max_stack_depth = 16;
+  DEFVAR_INT ("profiler-log-size", profiler_log_size,
+	      doc: /* Number of distinct call-stacks that can be recorded in a profiler log.
+If the log gets full, some of the least-seen call-stacks will be evicted
+to make room for new entries.  */);
+  profiler_log_size = 10000;
+  DEFVAR_INT ("profiler-memory-sampling-interval",
+	      profiler_memory_sampling_interval,
+	      doc: /* Number of bytes allocated between two memory profiler samples.
+Each sample is charged with all the bytes allocated since the previous
+one.  Smaller values give more precise profiles at a higher cost.  */);
+  profiler_memory_sampling_interval = 16384;
+  DEFVAR_INT ("profiler-memory-allocation-interval",
+	      profiler_memory_allocation_interval,
+	      doc: /* If positive, the memory profiler counts objects instead of bytes.
+It then takes a sample every this many conses, floats, strings and
+vectors made, and charges it with all the objects made since the
+previous one, so that its report shows where the objects that keep
+the garbage collector busy come from.  This takes effect when the
+memory profiler is started.  */);
+  profiler_memory_allocation_interval = 0;
+
+  DEFSYM (Qallocations, "allocations");
+
+  DEFSYM (Qautomatic_gc, "Automatic GC");
+
+#ifdef PROFILER_CPU_SUPPORT
+  profiler_cpu_running = NOT_RUNNING;
+  cpu_log = Qnil;
+  staticpro (&cpu_log);
+#endif
+  profiler_memory_running = false;
+  memory_log = Qnil;
+  staticpro (&memory_log);
+}
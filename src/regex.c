@@ -538,6 +538,13 @@ static regoff_t re_match_2_internal (struct re_pattern_buffer *bufp,
 				     ssize_t pos,
 				     struct re_registers *regs,
 				     ssize_t stop);
+static regoff_t nfa_search_2 (struct re_pattern_buffer *bufp,
+			      re_char *string1, size_t size1,
+			      re_char *string2, size_t size2,
+			      ssize_t startpos, ssize_t range,
+			      struct re_registers *regs, ssize_t stop,
+			      ssize_t *endp);
+static boolean nfa_usable_p (struct re_pattern_buffer *bufp);
 
 /* These are the command codes that appear in compiled regular
    expressions.  Some opcodes are followed by argument bytes.  A
@@ -2495,6 +2502,7 @@ regex_compile (const_re_char *pattern, size_t size, reg_syntax_t syntax,
   bufp->fastmap_accurate = 0;
   bufp->not_bol = bufp->not_eol = 0;
   bufp->used_syntax = 0;
+  bufp->nfa_checked = 0;
 
   /* Set `used' to zero, so that if we return an error, the pattern
      printer (for debugging) will think there's no pattern.  We reset it
@@ -4220,6 +4228,93 @@ re_search (struct re_pattern_buffer *bufp, const char *string, size_t size,
 }
 WEAK_ALIAS (__re_search, re_search)
 
+/* If every match of the pattern in BUFP starts with a fixed string of
+   ASCII bytes, return its address in the pattern and store its length
+   in *LENP.  Otherwise return NULL.  Group starts and zero-width
+   assertions at the front of the pattern are skipped, so this finds
+   the literal in patterns like "\\_<defun\\_>".  ASCII bytes match the
+   same way in unibyte and multibyte text, and always start a
+   character.  */
+
+static re_char *
+literal_prefix (struct re_pattern_buffer *bufp, int *lenp)
+{
+  re_char *p = bufp->buffer;
+  re_char *pend = p + bufp->used;
+
+  while (p < pend)
+    switch (*p)
+      {
+      case start_memory:
+	p += 2;
+	break;
+
+      case wordbeg:
+      case wordend:
+      case wordbound:
+      case notwordbound:
+      case symbeg:
+      case symend:
+	p++;
+	break;
+
+      case exactn:
+	{
+	  int n = p[1], len = 0;
+
+	  while (len < n && p[2 + len] < 0x80)
+	    len++;
+	  *lenp = len;
+	  return len ? p + 2 : NULL;
+	}
+
+      default:
+	return NULL;
+      }
+  return NULL;
+}
+
+/* Return the offset of the first occurrence of the LEN bytes at PAT
+   among the SIZE bytes at S, or -1 if there is none.  Short searches
+   look for the first byte with memchr; long ones use Boyer-Moore-
+   Horspool.  */
+
+static ssize_t
+find_literal (re_char *s, ssize_t size, re_char *pat, int len)
+{
+  ssize_t i;
+
+  if (size < len)
+    return -1;
+
+  if (len < 4 || size < 256)
+    {
+      re_char *p = s, *end = s + size - len + 1;
+
+      while (p < end && (p = memchr (p, pat[0], end - p)))
+	{
+	  if (!memcmp (p + 1, pat + 1, len - 1))
+	    return p - s;
+	  p++;
+	}
+    }
+  else
+    {
+      int skip[1 << BYTEWIDTH];
+      re_char last = pat[len - 1];
+
+      for (i = 0; i < (1 << BYTEWIDTH); i++)
+	skip[i] = len;
+      for (i = 0; i < len - 1; i++)
+	skip[pat[i]] = len - 1 - i;
+
+      for (i = 0; i <= size - len; i += skip[s[i + len - 1]])
+	if (s[i + len - 1] == last && !memcmp (s + i, pat, len - 1))
+	  return i;
+    }
+  return -1;
+}
+
 /* Head address of virtual concatenation of string.  */
 #define HEAD_ADDR_VSTRING(P)		\
   (((P) >= size1 ? string2 : string1))
@@ -4264,11 +4359,24 @@ re_search_2 (struct re_pattern_buffer *bufp, const char *str1, size_t size1,
   boolean anchored_start;
   /* Nonzero if we are searching multibyte string.  */
   const boolean multibyte = RE_TARGET_MULTIBYTE_P (bufp);
+  /* The literal every match starts with, if any; see literal_prefix.  */
+  re_char *prefix = NULL;
+  int prefix_len = 0;
+  /* Whether to match with the NFA matcher; see nfa_search_2.  */
+  boolean use_nfa;
 
   /* Check for out-of-range STARTPOS.  */
   if (startpos < 0 || startpos > total_size)
     return -1;
 
+  /* Search text that is contiguous in memory as a single string.  */
+  if (size1 && size2 && string1 + size1 == string2)
+    {
+      string2 = string1;
+      size2 += size1;
+      size1 = 0;
+    }
+
   /* Fix up RANGE if it might eventually take us outside
      the virtual concatenation of STRING1 and STRING2.
      Make sure we won't move STARTPOS below 0 or above TOTAL_SIZE.  */
@@ -4305,6 +4413,11 @@ re_search_2 (struct re_pattern_buffer *bufp, const char *str1, size_t size1,
   /* See whether the pattern is anchored.  */
   anchored_start = (bufp->buffer[0] == begline);
 
+  /* Forward searches for a literal can skip straight to where it
+     occurs, unless the text is translated.  */
+  if (range > 0 && !RE_TRANSLATE_P (translate))
+    prefix = literal_prefix (bufp, &prefix_len);
+
 #ifdef emacs
   gl_state.object = re_match_object; /* Used by SYNTAX_TABLE_BYTE_TO_CHAR. */
   {
@@ -4314,6 +4427,13 @@ re_search_2 (struct re_pattern_buffer *bufp, const char *str1, size_t size1,
   }
 #endif
 
+  /* The NFA matcher tries all the starting places of a forward search
+     at once.  */
+  use_nfa = nfa_usable_p (bufp);
+  if (use_nfa && range >= 0)
+    return nfa_search_2 (bufp, string1, size1, string2, size2,
+			 startpos, range, regs, stop, NULL);
+
   /* Loop through the string, looking for a place to start matching.  */
   for (;;)
     {
@@ -4329,6 +4449,40 @@ re_search_2 (struct re_pattern_buffer *bufp, const char *str1, size_t size1,
 	    goto advance;
 	}
 
+      /* If the pattern starts with a literal, jump to its next
+	 occurrence within the current string.  */
+      if (prefix && range > 0 && startpos < total_size)
+	{
+	  ssize_t lim = startpos < size1 ? size1 : total_size;
+	  ssize_t off
+	    = find_literal (POS_ADDR_VSTRING (startpos),
+			    MIN (lim, startpos + range + prefix_len) - startpos,
+			    prefix, prefix_len);
+
+	  if (off >= 0)
+	    {
+	      startpos += off;
+	      range -= off;
+	    }
+	  else if (lim == total_size || startpos + range + prefix_len <= lim)
+	    return -1;
+	  else
+	    {
+	      /* A match can still straddle the end of STRING1.  */
+	      ssize_t next = lim - prefix_len + 1;
+
+	      if (multibyte)
+		while (next > startpos
+		       && (*POS_ADDR_VSTRING (next) & 0xC0) == 0x80)
+		  next--;
+	      if (next > startpos)
+		{
+		  range -= next - startpos;
+		  startpos = next;
+		}
+	    }
+	}
+
       /* If a fastmap is supplied, skip quickly over characters that
 	 cannot be the start of a match.  If the pattern can match the
 	 null string, however, we don't need to skip characters; we want
@@ -4434,8 +4588,12 @@ re_search_2 (struct re_pattern_buffer *bufp, const char *str1, size_t size1,
 	  && !bufp->can_be_null)
 	return -1;
 
-      val = re_match_2_internal (bufp, string1, size1, string2, size2,
-				 startpos, regs, stop);
+      if (use_nfa)
+	val = nfa_search_2 (bufp, string1, size1, string2, size2,
+			    startpos, 0, regs, stop, NULL);
+      else
+	val = re_match_2_internal (bufp, string1, size1, string2, size2,
+				   startpos, regs, stop);
 
       if (val >= 0)
 	return startpos;
@@ -4869,8 +5027,18 @@ regoff_t
 re_match (struct re_pattern_buffer *bufp, const char *string,
 	  size_t size, ssize_t pos, struct re_registers *regs)
 {
-  regoff_t result = re_match_2_internal (bufp, NULL, 0, (re_char*) string,
-					 size, pos, regs, size);
+  regoff_t result;
+  ssize_t end;
+
+  if (nfa_usable_p (bufp))
+    {
+      result = nfa_search_2 (bufp, NULL, 0, (re_char*) string, size,
+			     pos, 0, regs, size, &end);
+      return result >= 0 ? end - pos : result;
+    }
+
+  result = re_match_2_internal (bufp, NULL, 0, (re_char*) string,
+				size, pos, regs, size);
   return result;
 }
 WEAK_ALIAS (__re_match, re_match)
@@ -4909,6 +5077,15 @@ re_match_2 (struct re_pattern_buffer *bufp, const char *string1,
   SETUP_SYNTAX_TABLE_FOR_OBJECT (re_match_object, charpos, 1);
 #endif
 
+  if (nfa_usable_p (bufp))
+    {
+      ssize_t end;
+
+      result = nfa_search_2 (bufp, (re_char*) string1, size1,
+			     (re_char*) string2, size2, pos, 0, regs, stop, &end);
+      return result >= 0 ? end - pos : result;
+    }
+
   result = re_match_2_internal (bufp, (re_char*) string1, size1,
 				(re_char*) string2, size2,
 				pos, regs, stop);
@@ -4917,6 +5094,99 @@ re_match_2 (struct re_pattern_buffer *bufp, const char *string1,
 WEAK_ALIAS (__re_match_2, re_match_2)
 
 
+/* Return true if the character at D matches the charset or
+   charset_not operation at P in the pattern BUFP, and store its
+   length in *LENP.  */
+static boolean
+charset_match_p (struct re_pattern_buffer *bufp, re_char *p, re_char *d,
+		 int *lenp)
+{
+  RE_TRANSLATE_TYPE translate = bufp->translate;
+  const boolean target_multibyte = RE_TARGET_MULTIBYTE_P (bufp);
+  register unsigned int c;
+  boolean not = (re_opcode_t) *p == charset_not;
+
+  /* Start of actual range_table, or end of bitmap if there is no
+     range table.  */
+  re_char *range_table IF_LINT (= NULL);
+
+  /* Nonzero if there is a range table.  */
+  int range_table_exists;
+
+  /* Number of ranges of range table.  This is not included
+     in the initial byte-length of the command.  */
+  int count = 0;
+
+  /* Whether matching against a unibyte character.  */
+  boolean unibyte_char = false;
+
+  range_table_exists = CHARSET_RANGE_TABLE_EXISTS_P (p);
+
+  if (range_table_exists)
+    {
+      range_table = CHARSET_RANGE_TABLE (p); /* Past the bitmap.  */
+      EXTRACT_NUMBER_AND_INCR (count, range_table);
+    }
+
+  c = RE_STRING_CHAR_AND_LENGTH (d, *lenp, target_multibyte);
+  if (target_multibyte)
+    {
+      int c1;
+
+      c = TRANSLATE (c);
+      c1 = RE_CHAR_TO_UNIBYTE (c);
+      if (c1 >= 0)
+	{
+	  unibyte_char = true;
+	  c = c1;
+	}
+    }
+  else
+    {
+      int c1 = RE_CHAR_TO_MULTIBYTE (c);
+
+      if (! CHAR_BYTE8_P (c1))
+	{
+	  c1 = TRANSLATE (c1);
+	  c1 = RE_CHAR_TO_UNIBYTE (c1);
+	  if (c1 >= 0)
+	    {
+	      unibyte_char = true;
+	      c = c1;
+	    }
+	}
+      else
+	unibyte_char = true;
+    }
+
+  if (unibyte_char && c < (1 << BYTEWIDTH))
+    {			/* Lookup bitmap.  */
+      /* Cast to `unsigned' instead of `unsigned char' in
+	 case the bit list is a full 32 bytes long.  */
+      if (c < (unsigned) (CHARSET_BITMAP_SIZE (p) * BYTEWIDTH)
+	  && p[2 + c / BYTEWIDTH] & (1 << (c % BYTEWIDTH)))
+	not = !not;
+    }
+#ifdef emacs
+  else if (range_table_exists)
+    {
+      int class_bits = CHARSET_RANGE_TABLE_BITS (p);
+
+      if (  (class_bits & BIT_LOWER && ISLOWER (c))
+	  | (class_bits & BIT_MULTIBYTE)
+	  | (class_bits & BIT_PUNCT && ISPUNCT (c))
+	  | (class_bits & BIT_SPACE && ISSPACE (c))
+	  | (class_bits & BIT_UPPER && ISUPPER (c))
+	  | (class_bits & BIT_WORD  && ISWORD (c)))
+	not = !not;
+      else
+	CHARSET_LOOKUP_RANGE_TABLE_RAW (not, c, range_table, count);
+    }
+#endif /* emacs */
+
+  return not;
+}
+
 /* This is a separate function so that we can force an alloca cleanup
    afterwards.  */
 static regoff_t
@@ -5070,6 +5340,16 @@ re_match_2_internal (struct re_pattern_buffer *bufp, const_re_char *string1,
       string1 = 0;
       size1 = 0;
     }
+  /* Likewise if `string2' directly follows `string1' in memory, as a
+     buffer's text does when its gap is empty; then PREFETCH need never
+     switch strings.  */
+  else if (size1 && string1 + size1 == string2)
+    {
+      string2 = string1;
+      size2 += size1;
+      string1 = 0;
+      size1 = 0;
+    }
   end1 = string1 + size1;
   end2 = string2 + size2;
 
@@ -5309,6 +5589,19 @@ re_match_2_internal (struct re_pattern_buffer *bufp, const_re_char *string1,
 	  /* Remember the start point to rollback upon failure.  */
 	  dfail = d;
 
+	  /* Untranslated text that holds the whole literal before the
+	     end of the current string can be compared at once, without
+	     a PREFETCH for each byte.  */
+	  if (!RE_TRANSLATE_P (translate) && multibyte == target_multibyte
+	      && dend - d >= mcnt)
+	    {
+	      if (memcmp (d, p, mcnt))
+		goto fail;
+	      d += mcnt;
+	      p += mcnt;
+	      break;
+	    }
+
 #ifndef emacs
 	  /* This is written out as an if-else so we don't waste time
 	     testing `translate' inside the loop.  */
@@ -5432,98 +5725,16 @@ re_match_2_internal (struct re_pattern_buffer *bufp, const_re_char *string1,
 	case charset:
 	case charset_not:
 	  {
-	    register unsigned int c;
-	    boolean not = (re_opcode_t) *(p - 1) == charset_not;
 	    int len;
 
-	    /* Start of actual range_table, or end of bitmap if there is no
-	       range table.  */
-	    re_char *range_table IF_LINT (= NULL);
-
-	    /* Nonzero if there is a range table.  */
-	    int range_table_exists;
-
-	    /* Number of ranges of range table.  This is not included
-	       in the initial byte-length of the command.  */
-	    int count = 0;
-
-	    /* Whether matching against a unibyte character.  */
-	    boolean unibyte_char = false;
-
-	    DEBUG_PRINT ("EXECUTING charset%s.\n", not ? "_not" : "");
-
-	    range_table_exists = CHARSET_RANGE_TABLE_EXISTS_P (&p[-1]);
-
-	    if (range_table_exists)
-	      {
-		range_table = CHARSET_RANGE_TABLE (&p[-1]); /* Past the bitmap.  */
-		EXTRACT_NUMBER_AND_INCR (count, range_table);
-	      }
+	    DEBUG_PRINT ("EXECUTING charset%s.\n",
+			 (re_opcode_t) *(p - 1) == charset_not ? "_not" : "");
 
 	    PREFETCH ();
-	    c = RE_STRING_CHAR_AND_LENGTH (d, len, target_multibyte);
-	    if (target_multibyte)
-	      {
-		int c1;
-
-		c = TRANSLATE (c);
-		c1 = RE_CHAR_TO_UNIBYTE (c);
-		if (c1 >= 0)
-		  {
-		    unibyte_char = true;
-		    c = c1;
-		  }
-	      }
-	    else
-	      {
-		int c1 = RE_CHAR_TO_MULTIBYTE (c);
-
-		if (! CHAR_BYTE8_P (c1))
-		  {
-		    c1 = TRANSLATE (c1);
-		    c1 = RE_CHAR_TO_UNIBYTE (c1);
-		    if (c1 >= 0)
-		      {
-			unibyte_char = true;
-			c = c1;
-		      }
-		  }
-		else
-		  unibyte_char = true;
-	      }
-
-	    if (unibyte_char && c < (1 << BYTEWIDTH))
-	      {			/* Lookup bitmap.  */
-		/* Cast to `unsigned' instead of `unsigned char' in
-		   case the bit list is a full 32 bytes long.  */
-		if (c < (unsigned) (CHARSET_BITMAP_SIZE (&p[-1]) * BYTEWIDTH)
-		    && p[1 + c / BYTEWIDTH] & (1 << (c % BYTEWIDTH)))
-		  not = !not;
-	      }
-#ifdef emacs
-	    else if (range_table_exists)
-	      {
-		int class_bits = CHARSET_RANGE_TABLE_BITS (&p[-1]);
-
-		if (  (class_bits & BIT_LOWER && ISLOWER (c))
-		    | (class_bits & BIT_MULTIBYTE)
-		    | (class_bits & BIT_PUNCT && ISPUNCT (c))
-		    | (class_bits & BIT_SPACE && ISSPACE (c))
-		    | (class_bits & BIT_UPPER && ISUPPER (c))
-		    | (class_bits & BIT_WORD  && ISWORD (c)))
-		  not = !not;
-		else
-		  CHARSET_LOOKUP_RANGE_TABLE_RAW (not, c, range_table, count);
-	      }
-#endif /* emacs */
-
-	    if (range_table_exists)
-	      p = CHARSET_RANGE_TABLE_END (range_table, count);
-	    else
-	      p += CHARSET_BITMAP_SIZE (&p[-1]) + 1;
-
-	    if (!not) goto fail;
+	    if (!charset_match_p (bufp, p - 1, d, &len))
+	      goto fail;
 
+	    p = skip_one_char (p - 1);
 	    d += len;
 	  }
 	  break;
@@ -6293,6 +6504,698 @@ bcmp_translate (const_re_char *s1, const_re_char *s2, register ssize_t len,
   return 0;
 }
 
+/* The NFA matcher.
+
+   The backtracking matcher above can take time exponential in the
+   length of the text for patterns that nest repetitions, like
+   "\\(a*\\)*b" failing against a long run of a's.  For patterns built
+   only from the operations `nfa_skip_op' knows, which leaves out
+   backreferences, counted repetitions and the syntax-dependent
+   operations, re_search_2 and re_match_2 can instead follow every way
+   of matching at once, in the manner of Thompson and Pike.
+
+   A thread is a state of the pattern plus the registers it has set.
+   A state is the offset in the pattern of an operation, or of one
+   character of the literal of an exactn.  All threads move over the
+   text together, one character at a time, and no two threads at one
+   text position share a state, so the work per character depends on
+   the pattern but not on the text.  Threads are kept in the order in which
+   the backtracking matcher would try them, so the first thread to
+   reach `succeed' finds the match, and the registers, that the
+   backtracking matcher would have found.  */
+
+/* Kinds of offsets in a compiled pattern.  */
+enum nfa_kind { NFA_NONE, NFA_OP, NFA_LITERAL };
+
+/* Patterns that would need more than this many register slots for all
+   their threads are left to the backtracking matcher.  */
+#define NFA_MAX_SLOTS (1 << 20)
+
+/* Nonzero if OP splits a thread in two.  */
+#define NFA_SPLIT_P(op)							\
+  ((op) == on_failure_jump || (op) == on_failure_keep_string_jump	\
+   || (op) == on_failure_jump_loop || (op) == on_failure_jump_nastyloop \
+   || (op) == on_failure_jump_smart)
+
+/* A list of threads, in priority order.  */
+struct nfa_list
+{
+  ssize_t n;
+  ssize_t *state;
+  /* For each thread, the start and end of each register as offsets in
+     the text, or -1 if unset.  */
+  regoff_t *regs;
+};
+
+/* A choice `nfa_add' has left for later.  */
+struct nfa_choice
+{
+  /* The operation that made the choice.  */
+  ssize_t op;
+  /* The state to go on from, or -1 for the marker that an
+     on_failure_jump_nastyloop loop leaves when it goes round again.  */
+  ssize_t state;
+};
+
+/* The state of one run of the NFA matcher.  */
+struct nfa
+{
+  struct re_pattern_buffer *bufp;
+  re_char *string1, *string2;
+  ssize_t size1, total;
+  /* The kind of each offset in the pattern.  */
+  unsigned char *kind;
+  /* The step in which each state last joined a list, and the current
+     step.  Each step is one text position.  */
+  size_t *mark, step;
+  /* Register slots per thread.  */
+  ssize_t nslots;
+  /* The choices `nfa_add' has left for later, with the registers to
+     go on with, and the registers of the thread it is following.  */
+  struct nfa_choice *stack;
+  regoff_t *stack_regs, *regs;
+  ssize_t stack_size;
+};
+
+/* The address of position POS in the text.  */
+#define NFA_ADDR(nfa, pos)						\
+  ((pos) < (nfa)->size1 ? (nfa)->string1 + (pos)			\
+   : (nfa)->string2 + ((pos) - (nfa)->size1))
+
+/* Return the operation after the one at P, or NULL if the NFA matcher
+   does not support the one at P.  */
+static re_char *
+nfa_skip_op (re_char *p)
+{
+  switch (*p)
+    {
+    case no_op:
+    case succeed:
+    case begline:
+    case endline:
+    case begbuf:
+    case endbuf:
+      return p + 1;
+
+    case start_memory:
+    case stop_memory:
+      return p + 2;
+
+    case exactn:
+    case anychar:
+    case charset:
+    case charset_not:
+      return skip_one_char (p);
+
+    case jump:
+    case on_failure_jump:
+    case on_failure_keep_string_jump:
+    case on_failure_jump_loop:
+    case on_failure_jump_nastyloop:
+    case on_failure_jump_smart:
+      return p + 3;
+
+    default:
+      return NULL;
+    }
+}
+
+/* Return true if the NFA matcher supports the pattern in BUFP and is
+   worth using for it, because some loop in the pattern contains
+   another loop or an alternative.  The backtracking matcher is faster
+   for everything else.  */
+static boolean
+nfa_supported_p (struct re_pattern_buffer *bufp)
+{
+  re_char *pattern = bufp->buffer;
+  re_char *pend = pattern + bufp->used;
+  re_char *p, *q;
+  boolean nested = false;
+  int mcnt;
+
+  /* Without a final `succeed', the backtracking matcher looks for the
+     longest match, as POSIX asks, rather than the first.  */
+  if (bufp->used == 0 || pend[-1] != succeed
+      || bufp->used * 2 * (bufp->re_nsub + 1) > NFA_MAX_SLOTS)
+    return false;
+
+  for (p = pattern; p < pend; p = nfa_skip_op (p))
+    {
+      if (nfa_skip_op (p) == NULL || (*p == succeed && p != pend - 1))
+	return false;
+      if (*p != jump && !NFA_SPLIT_P (*p))
+	continue;
+
+      /* A backward jump closes a loop.  Look for a split inside it,
+	 other than the loop's own.  */
+      EXTRACT_NUMBER (mcnt, p + 1);
+      if (mcnt < 0)
+	for (q = p + 3 + mcnt; !nested && q && q < p - 3; q = nfa_skip_op (q))
+	  if (q > p + 3 + mcnt && NFA_SPLIT_P (*q))
+	    nested = true;
+    }
+
+  return nested;
+}
+
+/* Return true if re_search_2 and re_match_2 should use the NFA matcher
+   for BUFP.  */
+static boolean
+nfa_usable_p (struct re_pattern_buffer *bufp)
+{
+  if (!bufp->nfa_checked)
+    {
+      bufp->use_nfa = nfa_supported_p (bufp);
+      bufp->nfa_checked = 1;
+    }
+  return bufp->use_nfa;
+}
+
+/* Push onto the stack of NFA a choice made by the operation at OP to
+   go on from STATE with registers REGS.  Return false if memory is
+   exhausted.  */
+static boolean
+nfa_push (struct nfa *nfa, ssize_t *top, ssize_t op, ssize_t state,
+	  const regoff_t *regs)
+{
+  ssize_t nslots = nfa->nslots;
+
+  if (*top == nfa->stack_size)
+    {
+      nfa->stack_size *= 2;
+      RETALLOC (nfa->stack, nfa->stack_size, struct nfa_choice);
+      RETALLOC (nfa->stack_regs, nfa->stack_size * nslots, regoff_t);
+      if (nfa->stack == NULL || nfa->stack_regs == NULL)
+	return false;
+    }
+  nfa->stack[*top].op = op;
+  nfa->stack[*top].state = state;
+  memcpy (nfa->stack_regs + *top * nslots, regs, nslots * sizeof *regs);
+  ++*top;
+  return true;
+}
+
+/* Return true if a choice made by the operation at OP is on the stack
+   of NFA, below TOP.  */
+static boolean
+nfa_pending_p (struct nfa *nfa, ssize_t top, ssize_t op)
+{
+  while (top > 0)
+    if (nfa->stack[--top].op == op)
+      return true;
+  return false;
+}
+
+/* Add to LIST the threads that a thread in STATE with registers REGS
+   leads to at text position POS, in priority order.  Only threads that
+   are to consume a character or have matched join LIST, and only the
+   first to reach each state; the others would do no better.  The way
+   there is found as the backtracking matcher finds it, choices and
+   loop checks included, so the registers come out the same.  Return
+   false if memory is exhausted.  */
+static boolean
+nfa_add (struct nfa *nfa, struct nfa_list *list, ssize_t state,
+	 const regoff_t *regs, ssize_t pos)
+{
+  struct re_pattern_buffer *bufp = nfa->bufp;
+  re_char *pattern = bufp->buffer;
+  ssize_t nslots = nfa->nslots;
+  regoff_t *r = nfa->regs;
+  ssize_t top = 0;
+  int mcnt;
+
+  memcpy (r, regs, nslots * sizeof *r);
+
+  for (;;)
+    {
+      re_char *p = pattern + state;
+
+      if (nfa->kind[state] == NFA_LITERAL)
+	goto add;
+
+      switch (*p)
+	{
+	case succeed:
+	case anychar:
+	case charset:
+	case charset_not:
+	  goto add;
+
+	case exactn:
+	  state += 2;
+	  continue;
+
+	case no_op:
+	  state += 1;
+	  continue;
+
+	case start_memory:
+	  r[2 * p[1]] = pos;
+	  r[2 * p[1] + 1] = -1;
+	  state += 2;
+	  continue;
+
+	case stop_memory:
+	  r[2 * p[1] + 1] = pos;
+	  state += 2;
+	  continue;
+
+	case begline:
+	  if (pos == 0 ? bufp->not_bol : *NFA_ADDR (nfa, pos - 1) != '\n')
+	    goto fail;
+	  state += 1;
+	  continue;
+
+	case endline:
+	  if (pos == nfa->total ? bufp->not_eol : *NFA_ADDR (nfa, pos) != '\n')
+	    goto fail;
+	  state += 1;
+	  continue;
+
+	case begbuf:
+	  if (pos != 0)
+	    goto fail;
+	  state += 1;
+	  continue;
+
+	case endbuf:
+	  if (pos != nfa->total)
+	    goto fail;
+	  state += 1;
+	  continue;
+
+	case jump:
+	  EXTRACT_NUMBER (mcnt, p + 1);
+	  state += 3 + mcnt;
+	  /* When on_failure_jump_smart has turned its loop into an
+	     on_failure_keep_string_jump loop, the loop jumps back past the
+	     on_failure_keep_string_jump; go back to it instead, so that
+	     each time round makes the choice again.  */
+	  if (state >= 3 && nfa->kind[state - 3] == NFA_OP
+	      && pattern[state - 3] == on_failure_keep_string_jump)
+	    {
+	      EXTRACT_NUMBER (mcnt, pattern + state - 2);
+	      if (pattern + state + mcnt == p + 3)
+		state -= 3;
+	    }
+	  continue;
+
+	case on_failure_jump_loop:
+	  EXTRACT_NUMBER (mcnt, p + 1);
+	  /* A loop that came back here without consuming anything is
+	     left.  */
+	  if (nfa_pending_p (nfa, top, state))
+	    {
+	      state += 3 + mcnt;
+	      continue;
+	    }
+	  goto split;
+
+	case on_failure_jump_nastyloop:
+	  EXTRACT_NUMBER (mcnt, p + 1);
+	  /* Likewise, a non-greedy loop that went round without
+	     consuming anything does not try to go round again.  */
+	  if (nfa_pending_p (nfa, top, state - 1))
+	    {
+	      state += 3;
+	      continue;
+	    }
+	  goto split;
+
+	case on_failure_jump:
+	case on_failure_keep_string_jump:
+	case on_failure_jump_smart:
+	  EXTRACT_NUMBER (mcnt, p + 1);
+	split:
+	  /* Go on with the next operation and leave the jump's
+	     destination for later.  */
+	  if (!nfa_push (nfa, &top, state, state + 3 + mcnt, r))
+	    return false;
+	  state += 3;
+	  continue;
+
+	default:
+	  abort ();
+	}
+
+    add:
+      if (nfa->mark[state] != nfa->step)
+	{
+	  nfa->mark[state] = nfa->step;
+	  list->state[list->n] = state;
+	  memcpy (list->regs + list->n * nslots, r, nslots * sizeof *r);
+	  list->n++;
+	}
+
+    fail:
+      /* Take up the latest choice left for later.  */
+      do
+	{
+	  ssize_t op;
+
+	  if (top == 0)
+	    return true;
+	  top--;
+	  op = nfa->stack[top].op;
+	  state = nfa->stack[top].state;
+	  memcpy (r, nfa->stack_regs + top * nslots, nslots * sizeof *r);
+	  /* A non-greedy loop going round again leaves a marker, so
+	     that it can tell whether it consumed anything.  */
+	  if (state >= 0 && pattern[op] == on_failure_jump_nastyloop
+	      && !nfa_push (nfa, &top, op - 1, -1, r))
+	    return false;
+	}
+      while (state < 0);
+    }
+}
+
+/* If a thread in STATE can consume the character at D, return the
+   state it moves to, otherwise -1.  */
+static ssize_t
+nfa_consume (struct nfa *nfa, ssize_t state, re_char *d)
+{
+  struct re_pattern_buffer *bufp = nfa->bufp;
+  re_char *p = bufp->buffer + state;
+  RE_TRANSLATE_TYPE translate = bufp->translate;
+  const boolean multibyte = RE_MULTIBYTE_P (bufp);
+  const boolean target_multibyte = RE_TARGET_MULTIBYTE_P (bufp);
+  int len, pat_charlen, pat_ch, buf_ch;
+
+  if (nfa->kind[state] == NFA_LITERAL)
+    {
+      /* This is the comparison exactn makes in re_match_2_internal.  */
+      if (target_multibyte)
+	{
+	  if (multibyte)
+	    pat_ch = STRING_CHAR_AND_LENGTH (p, pat_charlen);
+	  else
+	    {
+	      pat_ch = RE_CHAR_TO_MULTIBYTE (*p);
+	      pat_charlen = 1;
+	    }
+	  buf_ch = STRING_CHAR_AND_LENGTH (d, len);
+	  if (TRANSLATE (buf_ch) != pat_ch)
+	    return -1;
+	}
+      else
+	{
+	  if (multibyte)
+	    {
+	      pat_ch = STRING_CHAR_AND_LENGTH (p, pat_charlen);
+	      pat_ch = RE_CHAR_TO_UNIBYTE (pat_ch);
+	    }
+	  else
+	    {
+	      pat_ch = *p;
+	      pat_charlen = 1;
+	    }
+	  buf_ch = RE_CHAR_TO_MULTIBYTE (*d);
+	  if (! CHAR_BYTE8_P (buf_ch))
+	    {
+	      buf_ch = TRANSLATE (buf_ch);
+	      buf_ch = RE_CHAR_TO_UNIBYTE (buf_ch);
+	      if (buf_ch < 0)
+		buf_ch = *d;
+	    }
+	  else
+	    buf_ch = *d;
+	  if (buf_ch != pat_ch)
+	    return -1;
+	}
+      return state + pat_charlen;
+    }
+
+  switch (*p)
+    {
+    case anychar:
+      buf_ch = RE_STRING_CHAR_AND_LENGTH (d, len, target_multibyte);
+      buf_ch = TRANSLATE (buf_ch);
+      if ((!(bufp->syntax & RE_DOT_NEWLINE) && buf_ch == '\n')
+	  || ((bufp->syntax & RE_DOT_NOT_NULL) && buf_ch == '\000'))
+	return -1;
+      return state + 1;
+
+    case charset:
+    case charset_not:
+      if (!charset_match_p (bufp, p, d, &len))
+	return -1;
+      return skip_one_char (p) - bufp->buffer;
+
+    default:
+      return -1;
+    }
+}
+
+/* Like re_search_2, but with the NFA matcher, for a pattern that
+   nfa_usable_p accepts; STARTPOS and RANGE must already fit in the
+   text and RANGE must not be negative.  If ENDP is non-null, store in
+   *ENDP where the match ends.  */
+static regoff_t
+nfa_search_2 (struct re_pattern_buffer *bufp,
+	      re_char *string1, size_t size1,
+	      re_char *string2, size_t size2,
+	      ssize_t startpos, ssize_t range,
+	      struct re_registers *regs, ssize_t stop,
+	      ssize_t *endp)
+{
+  re_char *pattern = bufp->buffer;
+  ssize_t used = bufp->used;
+  size_t num_regs = bufp->re_nsub + 1;
+  size_t reg;
+  const boolean multibyte = RE_MULTIBYTE_P (bufp);
+  const boolean target_multibyte = RE_TARGET_MULTIBYTE_P (bufp);
+  char *fastmap = bufp->fastmap;
+  struct nfa nfa;
+  struct nfa_list lists[2];
+  struct nfa_list *clist = &lists[0], *nlist = &lists[1], *tmp;
+  regoff_t *start_regs, *best;
+  ssize_t endpos = startpos + range, pos = startpos;
+  ssize_t match_start = -1, match_end = -1;
+  ssize_t nslots = 2 * num_regs;
+  ssize_t i, len = 0;
+  re_char *p, *d = NULL;
+  regoff_t result = -1;
+
+  /* Like re_match_2_internal, use only STRING2 if there is one
+     string.  */
+  if (size2 == 0 && string1 != NULL)
+    {
+      string2 = string1;
+      size2 = size1;
+      string1 = 0;
+      size1 = 0;
+    }
+
+  nfa.bufp = bufp;
+  nfa.string1 = string1;
+  nfa.string2 = string2;
+  nfa.size1 = size1;
+  nfa.total = size1 + size2;
+  nfa.nslots = nslots;
+  nfa.step = 1;
+  if (stop > nfa.total)
+    stop = nfa.total;
+
+  nfa.kind = TALLOC (used, unsigned char);
+  nfa.mark = TALLOC (used, size_t);
+  nfa.stack_size = used + 1;
+  nfa.stack = TALLOC (nfa.stack_size, struct nfa_choice);
+  nfa.stack_regs = TALLOC (nfa.stack_size * nslots, regoff_t);
+  nfa.regs = TALLOC (nslots, regoff_t);
+  start_regs = TALLOC (nslots, regoff_t);
+  best = TALLOC (nslots, regoff_t);
+  for (i = 0; i < 2; i++)
+    {
+      lists[i].n = 0;
+      lists[i].state = TALLOC (used, ssize_t);
+      lists[i].regs = TALLOC (used * nslots, regoff_t);
+    }
+  if (!nfa.kind || !nfa.mark || !nfa.stack || !nfa.stack_regs || !nfa.regs
+      || !start_regs || !best || !lists[0].state || !lists[0].regs
+      || !lists[1].state || !lists[1].regs)
+    {
+      result = -2;
+      goto done;
+    }
+
+  memset (nfa.kind, NFA_NONE, used);
+  memset (nfa.mark, 0, used * sizeof *nfa.mark);
+  for (p = pattern; p < pattern + used; p = nfa_skip_op (p))
+    {
+      nfa.kind[p - pattern] = NFA_OP;
+      if (*p == exactn)
+	{
+	  re_char *lit = p + 2, *end = lit + p[1];
+
+	  for (; lit < end; lit += multibyte ? BYTES_BY_CHAR_HEAD (*lit) : 1)
+	    nfa.kind[lit - pattern] = NFA_LITERAL;
+	}
+    }
+  for (i = 0; i < nslots; i++)
+    start_regs[i] = -1;
+
+  for (;;)
+    {
+      IMMEDIATE_QUIT_CHECK;
+
+      if (match_start < 0 && pos <= endpos)
+	{
+	  /* With no thread left, skip the places where the fastmap says
+	     no match can start.  */
+	  if (clist->n == 0 && fastmap && bufp->fastmap_accurate
+	      && !bufp->can_be_null && !RE_TRANSLATE_P (bufp->translate))
+	    {
+	      ssize_t from = pos;
+
+	      while (pos < endpos && pos < nfa.total)
+		{
+		  re_char *q = NFA_ADDR (&nfa, pos);
+
+		  if (fastmap[target_multibyte
+			      ? CHAR_LEADING_CODE (STRING_CHAR (q)) : *q])
+		    break;
+		  pos += target_multibyte ? BYTES_BY_CHAR_HEAD (*q) : 1;
+		}
+	      if (pos != from)
+		nfa.step++;
+	    }
+
+	  /* A match starting here comes after all the threads that
+	     started earlier.  */
+	  if (pos <= endpos)
+	    {
+	      start_regs[0] = pos;
+	      if (!nfa_add (&nfa, clist, 0, start_regs, pos))
+		{
+		  result = -2;
+		  goto done;
+		}
+	    }
+	}
+
+      if (pos < stop)
+	{
+	  d = NFA_ADDR (&nfa, pos);
+	  len = target_multibyte ? BYTES_BY_CHAR_HEAD (*d) : 1;
+	}
+
+      nfa.step++;
+      nlist->n = 0;
+      for (i = 0; i < clist->n; i++)
+	{
+	  ssize_t state = clist->state[i];
+	  regoff_t *r = clist->regs + i * nslots;
+
+	  if (nfa.kind[state] == NFA_OP && pattern[state] == succeed)
+	    {
+	      /* The threads after this one have lower priority; drop
+		 them.  The ones before it, which have moved on to NLIST,
+		 may still find a better match.  */
+	      memcpy (best, r, nslots * sizeof *r);
+	      match_start = r[0];
+	      match_end = pos;
+	      break;
+	    }
+
+	  if (pos < stop)
+	    {
+	      ssize_t next = nfa_consume (&nfa, state, d);
+
+	      if (next >= 0 && !nfa_add (&nfa, nlist, next, r, pos + len))
+		{
+		  result = -2;
+		  goto done;
+		}
+	    }
+	}
+
+      if (nlist->n == 0 && (match_start >= 0 || pos >= endpos))
+	break;
+      if (pos >= stop)
+	break;
+
+      pos += len;
+      tmp = clist;
+      clist = nlist;
+      nlist = tmp;
+    }
+
+  if (match_start >= 0)
+    {
+      result = match_start;
+      if (endp)
+	*endp = match_end;
+
+      /* Fill in REGS as re_match_2_internal does.  */
+      if (regs && !bufp->no_sub)
+	{
+	  if (bufp->regs_allocated == REGS_UNALLOCATED)
+	    {
+	      regs->num_regs = MAX (RE_NREGS, num_regs + 1);
+	      regs->start = TALLOC (regs->num_regs, regoff_t);
+	      regs->end = TALLOC (regs->num_regs, regoff_t);
+	      if (regs->start == NULL || regs->end == NULL)
+		{
+		  result = -2;
+		  goto done;
+		}
+	      bufp->regs_allocated = REGS_REALLOCATE;
+	    }
+	  else if (bufp->regs_allocated == REGS_REALLOCATE)
+	    {
+	      if (regs->num_regs < num_regs + 1)
+		{
+		  regs->num_regs = num_regs + 1;
+		  RETALLOC (regs->start, regs->num_regs, regoff_t);
+		  RETALLOC (regs->end, regs->num_regs, regoff_t);
+		  if (regs->start == NULL || regs->end == NULL)
+		    {
+		      result = -2;
+		      goto done;
+		    }
+		}
+	    }
+	  else
+	    {
+	      assert (bufp->regs_allocated == REGS_FIXED);
+	    }
+
+	  if (regs->num_regs > 0)
+	    {
+	      regs->start[0] = match_start;
+	      regs->end[0] = match_end;
+	    }
+	  for (reg = 1; reg < MIN (num_regs, regs->num_regs); reg++)
+	    {
+	      if (best[2 * reg] < 0 || best[2 * reg + 1] < 0)
+		regs->start[reg] = regs->end[reg] = -1;
+	      else
+		{
+		  regs->start[reg] = best[2 * reg];
+		  regs->end[reg] = best[2 * reg + 1];
+		}
+	    }
+	  for (reg = num_regs; reg < regs->num_regs; reg++)
+	    regs->start[reg] = regs->end[reg] = -1;
+	}
+    }
+
+ done:
+  free (nfa.kind);
+  free (nfa.mark);
+  free (nfa.stack);
+  free (nfa.stack_regs);
+  free (nfa.regs);
+  free (start_regs);
+  free (best);
+  for (i = 0; i < 2; i++)
+    {
+      free (lists[i].state);
+      free (lists[i].regs);
+    }
+  return result;
+}
+
 /* Entry points for GNU code.  */
 
 /* re_compile_pattern is the GNU regular expression compiler: it
@@ -394,6 +394,12 @@ struct re_pattern_buffer
      so the compiled pattern is only valid for the current syntax table.  */
   unsigned used_syntax : 1;
 
+        /* Set to zero when `regex_compile' compiles a pattern; set to one
+           once `re_search_2' or `re_match_2' has decided, in `use_nfa',
+           whether to match the pattern with the NFA matcher.  */
+  unsigned nfa_checked : 1;
+  unsigned use_nfa : 1;
+
 #ifdef emacs
   /* If true, multi-byte form in the regexp pattern should be
      recognized as a multibyte character.  */
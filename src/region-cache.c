@@ -136,8 +136,8 @@ new_region_cache (void)
   c->gap_start = 0;
   c->gap_len = NEW_CACHE_GAP;
   c->cache_len = 0;
-  c->boundaries = xmalloc ((c->gap_len + c->cache_len)
-			   * sizeof (*c->boundaries));
+  c->boundaries = xmalloc_atomic ((c->gap_len + c->cache_len)
+				  * sizeof (*c->boundaries));
 
   c->beg_unchanged = 0;
   c->end_unchanged = 0;
@@ -820,6 +820,213 @@ scrolling_1 (struct frame *frame, int window_size, int unchanged_at_top,
 }
 
 
+/* Perform insert-lines and delete-lines operations on the frame by
+   matching lines through their hash codes, instead of computing the
+   cost matrix of scrolling_1, which is quadratic in WINDOW_SIZE.
+
+   Lines whose hash code occurs exactly once among the old lines and
+   once among the new lines are paired first, and each pair is then
+   extended to equal neighbors below and above, as in Heckel's
+   algorithm.  Of these pairs we keep the longest subsequence in
+   which old lines appear in the same order as new lines, since only
+   those can be moved into place by deleting and inserting lines.
+   This takes O(N log N) time for N lines.
+
+   The arguments are as for scrolling_1; DRAW_COST, OLD_HASH and
+   NEW_HASH are indexed from 1.  Value is false, with nothing done,
+   if some line must not be redrawn; the caller should use
+   scrolling_1 then.  */
+
+bool
+scrolling_by_hash (struct frame *frame, int window_size, int unchanged_at_top,
+		   int *draw_cost, int *old_hash, int *new_hash)
+{
+  struct line_count { int hash, nold, nnew, old, new; } *table;
+  int size, mask, i, j, k, n, nkept, last_new, last_old;
+  int *from, *to, *tail, *prev, *copy_from;
+  char *retained_p;
+  bool terminal_window_p = 0;
+  USE_SAFE_ALLOCA;
+
+  for (i = 1; i <= window_size; i++)
+    if (draw_cost[i] >= INFINITY)
+      return 0;
+
+  for (size = 16; size < 2 * window_size; size *= 2)
+    ;
+  mask = size - 1;
+  SAFE_NALLOCA (table, 1, size);
+  memset (table, 0, size * sizeof *table);
+  SAFE_NALLOCA (from, 1, window_size + 1);
+  SAFE_NALLOCA (to, 1, window_size + 1);
+  SAFE_NALLOCA (tail, 1, window_size + 1);
+  SAFE_NALLOCA (prev, 1, window_size + 1);
+  SAFE_NALLOCA (copy_from, 1, window_size);
+  retained_p = SAFE_ALLOCA (window_size);
+
+  /* Count the occurrences of each hash code among the old and the
+     new lines.  */
+  for (k = 0; k < 2 * window_size; k++)
+    {
+      bool old_p = k < window_size;
+      int line = old_p ? k + 1 : k - window_size + 1;
+      int hash = old_p ? old_hash[line] : new_hash[line];
+
+      for (n = hash & mask;
+	   table[n].nold + table[n].nnew > 0 && table[n].hash != hash;
+	   n = (n + 1) & mask)
+	;
+      table[n].hash = hash;
+      if (old_p)
+	table[n].nold++, table[n].old = line;
+      else
+	table[n].nnew++, table[n].new = line;
+    }
+
+  /* FROM[I] is the old line paired with new line I, and TO[J] the
+     new line paired with old line J, or 0 if there is none.  */
+  for (i = 1; i <= window_size; i++)
+    from[i] = to[i] = 0;
+  for (n = 0; n < size; n++)
+    if (table[n].nold == 1 && table[n].nnew == 1)
+      {
+	from[table[n].new] = table[n].old;
+	to[table[n].old] = table[n].new;
+      }
+
+  for (i = 1; i < window_size; i++)
+    {
+      j = from[i];
+      if (j && j < window_size && !from[i + 1] && !to[j + 1]
+	  && new_hash[i + 1] == old_hash[j + 1])
+	{
+	  from[i + 1] = j + 1;
+	  to[j + 1] = i + 1;
+	}
+    }
+  for (i = window_size; i > 1; i--)
+    {
+      j = from[i];
+      if (j > 1 && !from[i - 1] && !to[j - 1]
+	  && new_hash[i - 1] == old_hash[j - 1])
+	{
+	  from[i - 1] = j - 1;
+	  to[j - 1] = i - 1;
+	}
+    }
+
+  /* Find the longest order-preserving subsequence of pairs.  TAIL[L]
+     is the new line ending the best subsequence of length L found so
+     far, and PREV[I] the new line before I in its subsequence.  */
+  nkept = 0;
+  for (i = 1; i <= window_size; i++)
+    if (from[i])
+      {
+	int lo = 1, hi = nkept + 1;
+	while (lo < hi)
+	  {
+	    int mid = (lo + hi) / 2;
+	    if (from[tail[mid]] < from[i])
+	      lo = mid + 1;
+	    else
+	      hi = mid;
+	  }
+	prev[i] = lo > 1 ? tail[lo - 1] : 0;
+	tail[lo] = i;
+	if (lo > nkept)
+	  nkept = lo;
+      }
+
+  /* Put the kept new lines in TAIL[1..NKEPT] in ascending order.  */
+  for (k = nkept, i = nkept ? tail[nkept] : 0; i; i = prev[i])
+    tail[k--] = i;
+
+  memset (retained_p, 0, window_size);
+  for (k = 0; k < window_size; k++)
+    copy_from[k] = -1;
+
+  /* Keep the kept lines, and also the lines between two kept pairs
+     that are the same distance apart in the old and the new lines;
+     those need no insertion or deletion, just redrawing.  */
+  for (k = 0; k <= nkept; k++)
+    {
+      int i1 = k > 0 ? tail[k] : 0;
+      int j1 = k > 0 ? from[i1] : 0;
+      int i2 = k < nkept ? tail[k + 1] : window_size + 1;
+      int j2 = k < nkept ? from[i2] : window_size + 1;
+
+      if (k > 0)
+	{
+	  copy_from[i1 - 1] = j1 - 1;
+	  retained_p[j1 - 1] = 1;
+	}
+      if (i2 - i1 == j2 - j1)
+	for (n = 1; n < i2 - i1; n++)
+	  {
+	    copy_from[i1 + n - 1] = j1 + n - 1;
+	    retained_p[j1 + n - 1] = 1;
+	  }
+    }
+
+  /* Lines below the last retained line are redrawn anyway, so don't
+     delete or insert lines there.  */
+  for (last_new = window_size; last_new > 0; last_new--)
+    if (copy_from[last_new - 1] >= 0)
+      break;
+  last_old = last_new ? copy_from[last_new - 1] + 1 : 0;
+
+  /* Delete the old lines not retained, bottom first so that the
+     vpos of the lines above stays valid.  */
+  for (j = last_old; j > 0; j--)
+    if (!retained_p[j - 1])
+      {
+	for (k = j; k > 1 && !retained_p[k - 2]; k--)
+	  ;
+	if (!terminal_window_p)
+	  {
+	    set_terminal_window (frame, window_size + unchanged_at_top);
+	    terminal_window_p = 1;
+	  }
+	ins_del_lines (frame, k - 1 + unchanged_at_top, k - j - 1);
+	j = k;
+      }
+
+  /* The retained lines are now contiguous at the top.  Open up room
+     for the new lines not retained, top first.  */
+  for (i = 1; i <= last_new; i++)
+    if (copy_from[i - 1] < 0)
+      {
+	for (k = i; k < last_new && copy_from[k] < 0; k++)
+	  ;
+	if (!terminal_window_p)
+	  {
+	    set_terminal_window (frame, window_size + unchanged_at_top);
+	    terminal_window_p = 1;
+	  }
+	ins_del_lines (frame, i - 1 + unchanged_at_top, k - i + 1);
+	i = k;
+      }
+
+  /* Assign glyph rows that are not retained to the empty lines.  */
+  for (k = 0, n = -1; k < window_size; k++)
+    if (copy_from[k] < 0)
+      {
+	while (retained_p[++n])
+	  ;
+	copy_from[k] = n;
+      }
+
+  mirrored_line_dance (frame->current_matrix, unchanged_at_top, window_size,
+		       copy_from, retained_p);
+  CHECK_MATRIX (frame->current_matrix);
+
+  if (terminal_window_p)
+    set_terminal_window (frame, 0);
+  SAFE_FREE ();
+  return 1;
+}
+
+
 
 /* Return number of lines in common between current and desired frame
    contents described to us only as vectors of hash codes OLDHASH and
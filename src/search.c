@@ -21,6 +21,8 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 
 #include <config.h>
 
+#include <count-one-bits.h>
+
 #include "lisp.h"
 #include "category.h"
 #include "character.h"
@@ -35,13 +37,20 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <sys/types.h>
 #include "regex.h"
 
-#define REGEXP_CACHE_SIZE 20
+/* The largest allowed value of `regexp-cache-size'.  */
+#define REGEXP_CACHE_SIZE_MAX 10000
 
 /* If the regexp is non-nil, then the buffer contains the compiled form
    of that regexp, suitable for searching.  */
 struct regexp_cache
 {
-  struct regexp_cache *next;
+  /* The neighbors in the list of entries in order of use.  */
+  struct regexp_cache *next, *prev;
+  /* The next entry in the same hash bucket.  */
+  struct regexp_cache *hash_next;
+  /* The hash of the key the regexp was compiled with; see
+     regexp_cache_hash.  */
+  EMACS_UINT hash;
   Lisp_Object regexp, whitespace_regexp;
   /* Syntax table for which the regexp applies.  We need this because
      of character classes.  If this is t, then the compiled pattern is valid
@@ -53,11 +62,22 @@ struct regexp_cache
   bool posix;
 };
 
-/* The instances of that struct.  */
-static struct regexp_cache searchbufs[REGEXP_CACHE_SIZE];
+/* The instances of that struct, and their number.  */
+static struct regexp_cache *searchbufs;
+static ptrdiff_t searchbufs_size;
+
+/* The head of the linked list; points to the most recently used buffer.
+   The tail is the least recently used one, which is reused first.  */
+static struct regexp_cache *searchbuf_head, *searchbuf_tail;
+
+/* Hash buckets chaining the entries with a regexp, indexed by the low
+   bits of their hash.  The number of buckets is a power of 2.  */
+static struct regexp_cache **searchbuf_buckets;
+static ptrdiff_t searchbuf_bucket_count;
 
-/* The head of the linked list; points to the most recently used buffer.  */
-static struct regexp_cache *searchbuf_head;
+/* The number of times compile_pattern found, or did not find, its
+   pattern in the cache.  */
+static EMACS_INT regexp_cache_hits, regexp_cache_misses;
 
 
 /* Every call to re_match, etc., must pass &search_regs as the regs
@@ -164,6 +184,97 @@ compile_pattern_1 (struct regexp_cache *cp, Lisp_Object pattern,
   cp->regexp = Fcopy_sequence (pattern);
 }
 
+/* Return the hash of the cache key for compiling PATTERN with
+   TRANSLATE and POSIX, given the current value of
+   Vsearch_spaces_regexp.  The syntax table and unibyte charset are
+   not part of the hash, just compared, since a compiled pattern may be
+   valid for any syntax table.  */
+
+static EMACS_UINT
+regexp_cache_hash (Lisp_Object pattern, Lisp_Object translate, bool posix)
+{
+  EMACS_UINT hash = hash_string (SSDATA (pattern), SBYTES (pattern));
+
+  hash = sxhash_combine (hash, STRING_MULTIBYTE (pattern));
+  hash = sxhash_combine (hash, scm_ihashq (translate, MOST_POSITIVE_FIXNUM));
+  hash = sxhash_combine (hash, posix);
+  if (STRINGP (Vsearch_spaces_regexp))
+    hash = sxhash_combine (hash, hash_string (SSDATA (Vsearch_spaces_regexp),
+					      SBYTES (Vsearch_spaces_regexp)));
+  return hash;
+}
+
+static struct regexp_cache **
+regexp_cache_bucket (EMACS_UINT hash)
+{
+  return &searchbuf_buckets[hash & (searchbuf_bucket_count - 1)];
+}
+
+/* Remove CP from its hash bucket, if it is in one.  */
+
+static void
+regexp_cache_unhash (struct regexp_cache *cp)
+{
+  struct regexp_cache **p;
+
+  for (p = regexp_cache_bucket (cp->hash); *p; p = &(*p)->hash_next)
+    if (*p == cp)
+      {
+	*p = cp->hash_next;
+	cp->hash_next = NULL;
+	return;
+      }
+}
+
+/* Move CP to the front of the list of entries in order of use.  */
+
+static void
+regexp_cache_use (struct regexp_cache *cp)
+{
+  if (cp == searchbuf_head)
+    return;
+  cp->prev->next = cp->next;
+  if (cp->next)
+    cp->next->prev = cp->prev;
+  else
+    searchbuf_tail = cp->prev;
+  cp->prev = NULL;
+  cp->next = searchbuf_head;
+  searchbuf_head->prev = cp;
+  searchbuf_head = cp;
+}
+
+/* Discard the cache and make a new, empty one with SIZE entries.  */
+
+static void
+resize_regexp_cache (ptrdiff_t size)
+{
+  ptrdiff_t i, buckets;
+
+  searchbufs = xnmalloc (size, sizeof *searchbufs);
+  for (i = 0; i < size; i++)
+    {
+      struct regexp_cache *cp = &searchbufs[i];
+      memset (cp, 0, sizeof *cp);
+      cp->buf.allocated = 100;
+      cp->buf.buffer = xmalloc_atomic (100);
+      cp->buf.fastmap = cp->fastmap;
+      cp->regexp = Qnil;
+      cp->whitespace_regexp = Qnil;
+      cp->syntax_table = Qnil;
+      cp->prev = i == 0 ? NULL : &searchbufs[i - 1];
+      cp->next = i == size - 1 ? NULL : &searchbufs[i + 1];
+    }
+  searchbufs_size = size;
+  searchbuf_head = &searchbufs[0];
+  searchbuf_tail = &searchbufs[size - 1];
+
+  for (buckets = 1; buckets < 2 * size; buckets *= 2)
+    continue;
+  searchbuf_buckets = xzalloc (buckets * sizeof *searchbuf_buckets);
+  searchbuf_bucket_count = buckets;
+}
+
 /* Shrink each compiled regexp buffer in the cache
    to the size actually used right now.
    This is called from garbage collection.  */
@@ -188,14 +299,17 @@ shrink_regexp_cache (void)
 void
 clear_regexp_cache (void)
 {
-  int i;
+  ptrdiff_t i;
 
-  for (i = 0; i < REGEXP_CACHE_SIZE; ++i)
+  for (i = 0; i < searchbufs_size; ++i)
     /* It's tempting to compare with the syntax-table we've actually changed,
        but it's not sufficient because char-table inheritance means that
        modifying one syntax-table can change others at the same time.  */
     if (!EQ (searchbufs[i].syntax_table, Qt))
-      searchbufs[i].regexp = Qnil;
+      {
+	regexp_cache_unhash (&searchbufs[i]);
+	searchbufs[i].regexp = Qnil;
+      }
 }
 
 /* Compile a regexp if necessary, but first check to see if there's one in
@@ -213,46 +327,54 @@ struct re_pattern_buffer *
 compile_pattern (Lisp_Object pattern, struct re_registers *regp,
 		 Lisp_Object translate, bool posix, bool multibyte)
 {
-  struct regexp_cache *cp, **cpp;
-
-  for (cpp = &searchbuf_head; ; cpp = &cp->next)
+  struct regexp_cache *cp, **bucket;
+  Lisp_Object translate_key = ! NILP (translate) ? translate : make_number (0);
+  EMACS_UINT hash;
+  ptrdiff_t size = max (1, min (regexp_cache_size, REGEXP_CACHE_SIZE_MAX));
+
+  if (size != searchbufs_size)
+    resize_regexp_cache (size);
+
+  hash = regexp_cache_hash (pattern, translate_key, posix);
+  bucket = regexp_cache_bucket (hash);
+
+  /* Entries may be set to nil by compile_pattern_1 if the pattern
+     isn't valid, or by clear_regexp_cache.  Don't apply string
+     accessors in those cases.  */
+  for (cp = *bucket; cp; cp = cp->hash_next)
+    if (cp->hash == hash
+	&& !NILP (cp->regexp)
+	&& SCHARS (cp->regexp) == SCHARS (pattern)
+	&& STRING_MULTIBYTE (cp->regexp) == STRING_MULTIBYTE (pattern)
+	&& !NILP (Fstring_equal (cp->regexp, pattern))
+	&& EQ (cp->buf.translate, translate_key)
+	&& cp->posix == posix
+	&& (EQ (cp->syntax_table, Qt)
+	    || EQ (cp->syntax_table, BVAR (current_buffer, syntax_table)))
+	&& !NILP (Fequal (cp->whitespace_regexp, Vsearch_spaces_regexp))
+	&& cp->buf.charset_unibyte == charset_unibyte)
+      break;
+
+  if (cp)
+    regexp_cache_hits++;
+  else
     {
-      cp = *cpp;
-      /* Entries are initialized to nil, and may be set to nil by
-	 compile_pattern_1 if the pattern isn't valid.  Don't apply
-	 string accessors in those cases.  However, compile_pattern_1
-	 is only applied to the cache entry we pick here to reuse.  So
-	 nil should never appear before a non-nil entry.  */
-      if (NILP (cp->regexp))
-	goto compile_it;
-      if (SCHARS (cp->regexp) == SCHARS (pattern)
-	  && STRING_MULTIBYTE (cp->regexp) == STRING_MULTIBYTE (pattern)
-	  && !NILP (Fstring_equal (cp->regexp, pattern))
-	  && EQ (cp->buf.translate, (! NILP (translate) ? translate : make_number (0)))
-	  && cp->posix == posix
-	  && (EQ (cp->syntax_table, Qt)
-	      || EQ (cp->syntax_table, BVAR (current_buffer, syntax_table)))
-	  && !NILP (Fequal (cp->whitespace_regexp, Vsearch_spaces_regexp))
-	  && cp->buf.charset_unibyte == charset_unibyte)
-	break;
-
-      /* If we're at the end of the cache, compile into the nil cell
-	 we found, or the last (least recently used) cell with a
-	 string value.  */
-      if (cp->next == 0)
-	{
-	compile_it:
-	  compile_pattern_1 (cp, pattern, translate, posix);
-	  break;
-	}
+      /* Compile into the least recently used cell.  If compiling
+	 signals an error, the cell is left with a nil regexp, out of
+	 the hash buckets, to be reused first next time.  */
+      regexp_cache_misses++;
+      cp = searchbuf_tail;
+      regexp_cache_unhash (cp);
+      compile_pattern_1 (cp, pattern, translate, posix);
+      cp->hash = hash;
+      cp->hash_next = *bucket;
+      *bucket = cp;
     }
 
-  /* When we get here, cp (aka *cpp) contains the compiled pattern,
-     either because we found it in the cache or because we just compiled it.
-     Move it to the front of the queue to mark it as most recently used.  */
-  *cpp = cp->next;
-  cp->next = searchbuf_head;
-  searchbuf_head = cp;
+  /* When we get here, cp contains the compiled pattern, either because
+     we found it in the cache or because we just compiled it.  Move it
+     to the front of the queue to mark it as most recently used.  */
+  regexp_cache_use (cp);
 
   /* Advise the searching functions about the space we have allocated
      for register data.  */
@@ -647,6 +769,108 @@ newline_cache_on_off (struct buffer *buf)
 }
 
 
+/* Newline-free stretches shorter than this many bytes are not worth
+   recording in the newline cache: scanning them again costs less than
+   looking them up, and recording every short line of a big buffer
+   makes the cache itself the bottleneck.  */
+#define NEWLINE_CACHE_MIN_RUN 256
+
+/* The bulk scanning kernels below count newlines a word at a time and
+   skip long lines with memchr and memrchr.  */
+
+enum { NL_WORD_SIZE = sizeof (unsigned long) };
+#define NL_ONES (ULONG_MAX / UCHAR_MAX)
+
+/* Return the number of newline bytes in the word W.  X has a zero byte
+   for each newline, and NONNL the top bit of every other byte set.  */
+
+static int
+newlines_in_word (unsigned long w)
+{
+  unsigned long x = w ^ (NL_ONES * '\n');
+  unsigned long nonnl = ((((x & (NL_ONES * 0x7f)) + NL_ONES * 0x7f) | x)
+			 & (NL_ONES * 0x80));
+  return NL_WORD_SIZE - count_one_bits_l (nonnl);
+}
+
+/* Scan the LEN bytes at P forward for *COUNT newlines.  If they are
+   there, set *COUNT to zero and return the offset just past the last
+   one.  Otherwise subtract the number found from *COUNT and return
+   LEN.  */
+
+static ptrdiff_t
+forward_newlines (unsigned char const *p, ptrdiff_t len, ptrdiff_t *count)
+{
+  ptrdiff_t i = 0, n = *count;
+
+  while (i + NL_WORD_SIZE <= len)
+    {
+      unsigned long w;
+      int k;
+
+      memcpy (&w, p + i, NL_WORD_SIZE);
+      k = newlines_in_word (w);
+      if (k >= n)
+	break;
+      if (k == 0)
+	{
+	  unsigned char const *nl = memchr (p + i, '\n', len - i);
+	  i = nl ? nl - p : len;
+	  continue;
+	}
+      n -= k;
+      i += NL_WORD_SIZE;
+    }
+
+  for (; i < len; i++)
+    if (p[i] == '\n' && --n == 0)
+      {
+	*count = 0;
+	return i + 1;
+      }
+  *count = n;
+  return len;
+}
+
+/* Scan the LEN bytes at P backward for *COUNT newlines.  If they are
+   there, set *COUNT to zero and return the offset of the last one
+   found.  Otherwise subtract the number found from *COUNT and return
+   -1.  */
+
+static ptrdiff_t
+backward_newlines (unsigned char const *p, ptrdiff_t len, ptrdiff_t *count)
+{
+  ptrdiff_t i = len, n = *count;
+
+  while (NL_WORD_SIZE <= i)
+    {
+      unsigned long w;
+      int k;
+
+      memcpy (&w, p + i - NL_WORD_SIZE, NL_WORD_SIZE);
+      k = newlines_in_word (w);
+      if (k >= n)
+	break;
+      if (k == 0)
+	{
+	  unsigned char const *nl = memrchr (p, '\n', i);
+	  i = nl ? nl - p + 1 : 0;
+	  continue;
+	}
+      n -= k;
+      i -= NL_WORD_SIZE;
+    }
+
+  for (; 0 < i; i--)
+    if (p[i - 1] == '\n' && --n == 0)
+      {
+	*count = 0;
+	return i - 1;
+      }
+  *count = n;
+  return -1;
+}
+
 /* Search for COUNT newlines between START/START_BYTE and END/END_BYTE.
 
    If COUNT is positive, search forwards; END must be >= START.
@@ -799,6 +1023,19 @@ find_newline (ptrdiff_t start, ptrdiff_t start_byte, ptrdiff_t end,
 	  ptrdiff_t base = start_byte - lim_byte;
 	  ptrdiff_t cursor, next;
 
+	  if (!newline_cache)
+	    {
+	      next = forward_newlines (lim_addr + base, - base, &count);
+	      if (count == 0)
+		{
+		  immediate_quit = 0;
+		  if (bytepos)
+		    *bytepos = lim_byte + base + next;
+		  return BYTE_TO_CHAR (lim_byte + base + next);
+		}
+	      base = 0;
+	    }
+
 	  for (cursor = base; cursor < 0; cursor = next)
 	    {
               /* The dumb loop.  */
@@ -807,7 +1044,7 @@ find_newline (ptrdiff_t start, ptrdiff_t start_byte, ptrdiff_t end,
 
               /* If we're using the newline cache, cache the fact that
                  the region we just traversed is free of newlines. */
-              if (newline_cache && cursor != next)
+              if (NEWLINE_CACHE_MIN_RUN <= next - cursor)
 		{
 		  know_region_cache (cache_buffer, newline_cache,
 				     BYTE_TO_CHAR (lim_byte + cursor),
@@ -909,6 +1146,22 @@ find_newline (ptrdiff_t start, ptrdiff_t start_byte, ptrdiff_t end,
 	  ptrdiff_t base = start_byte - ceiling_byte;
 	  ptrdiff_t cursor, prev;
 
+	  if (!newline_cache)
+	    {
+	      ptrdiff_t n = - count;
+
+	      prev = backward_newlines (ceiling_addr, base, &n);
+	      count = - n;
+	      if (count == 0)
+		{
+		  immediate_quit = 0;
+		  if (bytepos)
+		    *bytepos = ceiling_byte + prev + 1;
+		  return BYTE_TO_CHAR (ceiling_byte + prev + 1);
+		}
+	      base = 0;
+	    }
+
 	  for (cursor = base; 0 < cursor; cursor = prev)
             {
 	      unsigned char *nl = memrchr (ceiling_addr, '\n', cursor);
@@ -916,7 +1169,7 @@ find_newline (ptrdiff_t start, ptrdiff_t start_byte, ptrdiff_t end,
 
               /* If we're looking for newlines, cache the fact that
                  this line's region is free of them. */
-              if (newline_cache && cursor != prev + 1)
+              if (NEWLINE_CACHE_MIN_RUN <= cursor - (prev + 1))
 		{
 		  know_region_cache (cache_buffer, newline_cache,
 				     BYTE_TO_CHAR (ceiling_byte + prev + 1),
@@ -2142,8 +2395,8 @@ set_search_regs (ptrdiff_t beg_byte, ptrdiff_t nbytes)
      the match position.  */
   if (search_regs.num_regs == 0)
     {
-      search_regs.start = xmalloc (2 * sizeof (regoff_t));
-      search_regs.end = xmalloc (2 * sizeof (regoff_t));
+      search_regs.start = xmalloc_atomic (2 * sizeof (regoff_t));
+      search_regs.end = xmalloc_atomic (2 * sizeof (regoff_t));
       search_regs.num_regs = 2;
     }
 
@@ -2287,6 +2540,358 @@ and `replace-match'.  */)
   return search_command (regexp, bound, noerror, count, 1, 1, 1);
 }
 
+/* Return the index in the fastmaps of the character at POS_BYTE, as
+   re_search_2 computes it for a pattern compiled with translation
+   table TRT.  */
+
+static int
+fastmap_index (ptrdiff_t pos_byte, Lisp_Object trt, bool multibyte)
+{
+  int c;
+
+  if (multibyte)
+    {
+      if (NILP (trt))
+	return FETCH_BYTE (pos_byte);
+      c = char_table_translate (trt, FETCH_MULTIBYTE_CHAR (pos_byte));
+      return CHAR_LEADING_CODE (c);
+    }
+  else
+    {
+      int b = FETCH_BYTE (pos_byte);
+
+      if (NILP (trt))
+	return b;
+      c = char_table_translate (trt, UNIBYTE_TO_CHAR (b));
+      c = CHAR_TO_BYTE_SAFE (c);
+      return c >= 0 ? c : b;
+    }
+}
+
+DEFUN ("re-search-forward-multi", Fre_search_forward_multi,
+       Sre_search_forward_multi, 1, 3, 0,
+       doc: /* Search forward for the first match of any regexp in REGEXPS.
+REGEXPS is a vector of regular expressions.  Return the index in
+REGEXPS of the one whose match starts first, or of the first of those
+that match at the same place; set point to the end of its match, and
+set the match data to it.  If none matches, return nil and leave point
+alone.  An optional second argument bounds the search; it is a buffer
+position.  The match found must not extend after that position.
+
+Optional third argument CACHE, a vector as long as REGEXPS initially
+filled with nil, lets successive calls scan the text once for all of
+REGEXPS, rather than once per regexp.  Each regexp is looked for from
+point the first time, and after a match of it is returned, from where
+point is at the next call.  Successive calls thus return the matches
+that successive calls of `re-search-forward' would find for each
+regexp, merged in buffer order, however point moves meanwhile.  Use a
+CACHE only while the buffer text, BOUND, and `case-fold-search' stay
+the same, and not for regexps that use `\\='.  With a CACHE, point
+may be after BOUND.  */)
+  (Lisp_Object regexps, Lisp_Object bound, Lisp_Object cache)
+{
+  ptrdiff_t n, i, npending = 0, nlive, best = -1;
+  ptrdiff_t lim, lim_byte, best_start = 0, from = PTRDIFF_MAX;
+  ptrdiff_t pos, pos_byte, np;
+  ptrdiff_t *pending, *cursor;
+  struct re_pattern_buffer **bufs;
+  unsigned char *p1, *p2;
+  ptrdiff_t s1, s2;
+  char any[0400];
+  bool any_null = false;
+  bool multibyte = !NILP (BVAR (current_buffer, enable_multibyte_characters));
+  Lisp_Object trt = (!NILP (BVAR (current_buffer, case_fold_search))
+		     ? BVAR (current_buffer, case_canon_table) : Qnil);
+  Lisp_Object inverse_trt = (!NILP (BVAR (current_buffer, case_fold_search))
+			     ? BVAR (current_buffer, case_eqv_table) : Qnil);
+  USE_SAFE_ALLOCA;
+
+  CHECK_VECTOR (regexps);
+  n = ASIZE (regexps);
+  if (!NILP (cache))
+    {
+      CHECK_VECTOR (cache);
+      if (ASIZE (cache) != n)
+	args_out_of_range (regexps, cache);
+    }
+
+  if (NILP (bound))
+    lim = ZV, lim_byte = ZV_BYTE;
+  else
+    {
+      CHECK_NUMBER_COERCE_MARKER (bound);
+      lim = XINT (bound);
+      /* With a CACHE, the regexps need not be looked for from point.  */
+      if (lim < PT && NILP (cache))
+	error ("Invalid search bound (wrong side of point)");
+      if (lim > ZV)
+	lim = ZV, lim_byte = ZV_BYTE;
+      else if (lim < BEGV)
+	lim = BEGV, lim_byte = BEGV_BYTE;
+      else
+	lim_byte = CHAR_TO_BYTE (lim);
+    }
+  if (NILP (cache))
+    cache = Fmake_vector (make_number (n), Qnil);
+
+  /* This is so set_image_of_range_1 in regex.c can find the EQV table.  */
+  set_char_table_extras (BVAR (current_buffer, case_canon_table), 2,
+			 BVAR (current_buffer, case_eqv_table));
+
+  /* Each entry of CACHE is nil if its regexp is to be looked for from
+     point, (FROM) if it does not match before FROM, the start of its
+     next match, or t if it does not match before LIM.  */
+  SAFE_NALLOCA (pending, 2, n);
+  cursor = pending + n;
+  SAFE_NALLOCA (bufs, 1, n);
+  for (i = 0; i < n; i++)
+    {
+      Lisp_Object entry = AREF (cache, i);
+
+      CHECK_STRING (AREF (regexps, i));
+      if (NILP (entry) || CONSP (entry))
+	{
+	  cursor[npending] = NILP (entry) ? PT : XINT (XCAR (entry));
+	  from = min (from, cursor[npending]);
+	  pending[npending++] = i;
+	}
+      else if (INTEGERP (entry) && (best < 0 || XINT (entry) < best_start))
+	best = i, best_start = XINT (entry);
+    }
+
+  if (npending > searchbufs_size)
+    {
+      /* The compiled patterns would not all fit in the cache at once;
+	 look for each regexp in turn.  */
+      for (i = 0; i < npending; i++)
+	{
+	  ptrdiff_t k = pending[i];
+
+	  np = search_buffer (AREF (regexps, k), cursor[i],
+			      CHAR_TO_BYTE (cursor[i]), lim, lim_byte,
+			      1, 1, trt, inverse_trt, 0);
+	  if (np > 0)
+	    {
+	      ASET (cache, k, make_number (search_regs.start[0]));
+	      if (best < 0 || search_regs.start[0] < best_start
+		  || (search_regs.start[0] == best_start && k < best))
+		best = k, best_start = search_regs.start[0];
+	    }
+	  else
+	    ASET (cache, k, Qt);
+	}
+      npending = 0;
+    }
+
+  /* Otherwise scan the text once for the regexps still to be looked
+     for, trying a regexp only where its fastmap allows a match.  */
+  memset (any, 0, sizeof any);
+  for (i = 0; i < npending; i++)
+    {
+      struct re_pattern_buffer *bufp
+	= compile_pattern (AREF (regexps, pending[i]), NULL, trt, 0,
+			   multibyte);
+      int c;
+
+      if (!bufp->fastmap_accurate)
+	re_compile_fastmap (bufp);
+      if (bufp->can_be_null)
+	any_null = true;
+      for (c = 0; c < 0400; c++)
+	any[c] |= bufp->fastmap[c];
+      bufs[i] = bufp;
+    }
+
+  p1 = BEGV_ADDR;
+  s1 = GPT_BYTE - BEGV_BYTE;
+  p2 = GAP_END_ADDR;
+  s2 = ZV_BYTE - GPT_BYTE;
+  if (s1 < 0)
+    {
+      p2 = p1;
+      s2 = ZV_BYTE - BEGV_BYTE;
+      s1 = 0;
+    }
+  if (s2 < 0)
+    {
+      s1 = ZV_BYTE - BEGV_BYTE;
+      s2 = 0;
+    }
+  re_match_object = Qnil;
+
+  immediate_quit = 1;
+  QUIT;
+  nlive = npending;
+  pos = max (from, BEGV);
+  pos_byte = pos <= lim ? CHAR_TO_BYTE (pos) : lim_byte;
+  while (nlive > 0 && pos <= lim && (best < 0 || pos <= best_start))
+    {
+      int c = pos < lim ? fastmap_index (pos_byte, trt, multibyte) : -1;
+
+      if (any_null || (c >= 0 && any[c]))
+	for (i = 0; i < npending; i++)
+	  {
+	    struct re_pattern_buffer *bufp = bufs[i];
+	    ptrdiff_t k = pending[i], val;
+
+	    if (cursor[i] > pos || (best >= 0 && pos == best_start && k > best))
+	      continue;
+	    if (!bufp->can_be_null && (c < 0 || !bufp->fastmap[c]))
+	      continue;
+	    val = re_match_2 (bufp, (char *) p1, s1, (char *) p2, s2,
+			      pos_byte - BEGV_BYTE, NULL, lim_byte - BEGV_BYTE);
+	    if (val == -2)
+	      {
+		immediate_quit = 0;
+		matcher_overflow ();
+	      }
+	    if (val >= 0)
+	      {
+		ASET (cache, k, make_number (pos));
+		best = k, best_start = pos;
+		cursor[i] = PTRDIFF_MAX;
+		nlive--;
+		break;
+	      }
+	  }
+      if (pos == lim)
+	break;
+      pos++;
+      pos_byte += multibyte ? BYTES_BY_CHAR_HEAD (FETCH_BYTE (pos_byte)) : 1;
+    }
+  immediate_quit = 0;
+
+  /* Record how far the scan got for the regexps not found.  If none
+     was, it got to LIM.  */
+  for (i = 0; i < npending; i++)
+    if (cursor[i] != PTRDIFF_MAX)
+      ASET (cache, pending[i],
+	    best < 0 ? Qt
+	    : list1 (make_number (max (cursor[i], min (pos, best_start)))));
+  SAFE_FREE ();
+
+  if (best < 0)
+    return Qnil;
+
+  /* Find the match again, to set the match data.  */
+  np = search_buffer (AREF (regexps, best), best_start,
+		      CHAR_TO_BYTE (best_start), lim, lim_byte, 1, 1,
+		      trt, inverse_trt, 0);
+  if (np <= 0)
+    return Qnil;
+  ASET (cache, best, Qnil);
+  SET_PT (np);
+  return make_number (best);
+}
+
+DEFUN ("re-search-forward-all", Fre_search_forward_all,
+       Sre_search_forward_all, 1, 2, 0,
+       doc: /* Return the positions of the matches for REGEXP after point.
+The value is a vector [BEG1 END1 BEG2 END2 ...] of the start and end
+of each match, in buffer order.  Each match is looked for from where
+the previous one ended, as successive calls of `re-search-forward'
+would look for it; but an empty match where the search starts is left
+out, and the search starts again one character later.
+An optional second argument bounds the search; it is a buffer position.
+No match found extends after that position.
+Point and the match data are left alone.  */)
+  (Lisp_Object regexp, Lisp_Object bound)
+{
+  ptrdiff_t lim, lim_byte, pos_byte, i;
+  ptrdiff_t *found = NULL, nfound = 0, found_size = 0;
+  struct re_pattern_buffer *bufp;
+  struct re_registers regs;
+  unsigned char *p1, *p2;
+  ptrdiff_t s1, s2;
+  bool multibyte = !NILP (BVAR (current_buffer, enable_multibyte_characters));
+  Lisp_Object result;
+
+  CHECK_STRING (regexp);
+  if (NILP (bound))
+    lim = ZV, lim_byte = ZV_BYTE;
+  else
+    {
+      CHECK_NUMBER_COERCE_MARKER (bound);
+      lim = XINT (bound);
+      if (lim < PT)
+	error ("Invalid search bound (wrong side of point)");
+      if (lim > ZV)
+	lim = ZV, lim_byte = ZV_BYTE;
+      else
+	lim_byte = CHAR_TO_BYTE (lim);
+    }
+
+  /* This is so set_image_of_range_1 in regex.c can find the EQV table.  */
+  set_char_table_extras (BVAR (current_buffer, case_canon_table), 2,
+			 BVAR (current_buffer, case_eqv_table));
+
+  bufp = compile_pattern (regexp, NULL,
+			  (!NILP (BVAR (current_buffer, case_fold_search))
+			   ? BVAR (current_buffer, case_canon_table) : Qnil),
+			  0, multibyte);
+
+  p1 = BEGV_ADDR;
+  s1 = GPT_BYTE - BEGV_BYTE;
+  p2 = GAP_END_ADDR;
+  s2 = ZV_BYTE - GPT_BYTE;
+  if (s1 < 0)
+    {
+      p2 = p1;
+      s2 = ZV_BYTE - BEGV_BYTE;
+      s1 = 0;
+    }
+  if (s2 < 0)
+    {
+      s1 = ZV_BYTE - BEGV_BYTE;
+      s2 = 0;
+    }
+  re_match_object = Qnil;
+
+  /* The matches are found without going back to Lisp, and without
+     touching the match data, each with registers of its own.  */
+  regs.num_regs = 0;
+  regs.start = regs.end = NULL;
+  immediate_quit = 1;
+  QUIT;
+  pos_byte = PT_BYTE;
+  while (pos_byte < lim_byte)
+    {
+      ptrdiff_t val, beg, end;
+
+      val = re_search_2 (bufp, (char *) p1, s1, (char *) p2, s2,
+			 pos_byte - BEGV_BYTE, lim_byte - pos_byte, &regs,
+			 lim_byte - BEGV_BYTE);
+      if (val == -2)
+	{
+	  immediate_quit = 0;
+	  matcher_overflow ();
+	}
+      if (val < 0)
+	break;
+      beg = regs.start[0] + BEGV_BYTE;
+      end = regs.end[0] + BEGV_BYTE;
+      if (end == pos_byte)
+	{
+	  pos_byte += multibyte ? BYTES_BY_CHAR_HEAD (FETCH_BYTE (pos_byte)) : 1;
+	  continue;
+	}
+      if (found_size - nfound < 2)
+	found = xpalloc (found, &found_size, 2, -1, sizeof *found);
+      found[nfound++] = beg;
+      found[nfound++] = end;
+      pos_byte = end;
+    }
+  immediate_quit = 0;
+  xfree (regs.start);
+  xfree (regs.end);
+
+  result = make_uninit_vector (nfound);
+  for (i = 0; i < nfound; i++)
+    ASET (result, i, make_number (BYTE_TO_CHAR (found[i])));
+  xfree (found);
+  return result;
+}
+
 DEFUN ("replace-match", Freplace_match, Sreplace_match, 1, 5, 0,
        doc: /* Replace text matched by last search with NEWTEXT.
 Leave point at the end of the replacement text.
@@ -2589,7 +3194,7 @@ since only regular expressions have distinguished subexpressions.  */)
 	{
 	  unsigned char str[MAX_MULTIBYTE_LENGTH];
 	  const unsigned char *add_stuff = NULL;
-	  ptrdiff_t add_len = 0;
+	  ptrdiff_t add_len = 0, after_gap_len = 0;
 	  ptrdiff_t idx = -1;
 
 	  if (str_multibyte)
@@ -2655,19 +3260,26 @@ since only regular expressions have distinguished subexpressions.  */)
 	    {
 	      ptrdiff_t begbyte = CHAR_TO_BYTE (search_regs.start[idx]);
 	      add_len = CHAR_TO_BYTE (search_regs.end[idx]) - begbyte;
-	      if (search_regs.start[idx] < GPT && GPT < search_regs.end[idx])
-		move_gap_both (search_regs.start[idx], begbyte);
 	      add_stuff = BYTE_POS_ADDR (begbyte);
+	      /* Copy a part that straddles the gap in two pieces, rather
+		 than move the gap to make it contiguous.  */
+	      if (begbyte < GPT_BYTE && GPT_BYTE < begbyte + add_len)
+		{
+		  after_gap_len = begbyte + add_len - GPT_BYTE;
+		  add_len -= after_gap_len;
+		}
 	    }
 
-	  /* Now the stuff we want to add to SUBSTED
-	     is invariably ADD_LEN bytes starting at ADD_STUFF.  */
+	  /* Now the stuff we want to add to SUBSTED is invariably
+	     ADD_LEN bytes starting at ADD_STUFF, and then AFTER_GAP_LEN
+	     bytes from the end of the gap.  */
 
 	  /* Make sure SUBSTED is big enough.  */
-	  if (substed_alloc_size - substed_len < add_len)
+	  if (substed_alloc_size - substed_len < add_len + after_gap_len)
 	    substed =
 	      xpalloc (substed, &substed_alloc_size,
-		       add_len - (substed_alloc_size - substed_len),
+		       add_len + after_gap_len
+		       - (substed_alloc_size - substed_len),
 		       STRING_BYTES_BOUND, 1);
 
 	  /* Now add to the end of SUBSTED.  */
@@ -2675,6 +3287,8 @@ since only regular expressions have distinguished subexpressions.  */)
 	    {
 	      memcpy (substed + substed_len, add_stuff, add_len);
 	      substed_len += add_len;
+	      memcpy (substed + substed_len, GAP_END_ADDR, after_gap_len);
+	      substed_len += after_gap_len;
 	    }
 	}
 
@@ -3188,6 +3802,29 @@ find_newline1 (ptrdiff_t start, ptrdiff_t start_byte, ptrdiff_t end,
   return start;
 }
 
+DEFUN ("regexp-cache-statistics", Fregexp_cache_statistics,
+       Sregexp_cache_statistics, 0, 0, 0,
+       doc: /* Return a property list of statistics about the regexp cache.
+The properties are:
+- `size', the number of compiled regexps the cache can hold,
+- `entries', the number it holds now,
+- `hits', the number of searches that found their regexp in the cache,
+- `misses', the number of searches that had to compile their regexp.
+See `regexp-cache-size'.  */)
+  (void)
+{
+  ptrdiff_t i, entries = 0;
+
+  for (i = 0; i < searchbufs_size; i++)
+    if (!NILP (searchbufs[i].regexp))
+      entries++;
+  return listn (CONSTYPE_HEAP, 8,
+		intern ("size"), make_number (searchbufs_size),
+		intern ("entries"), make_number (entries),
+		intern ("hits"), make_number (regexp_cache_hits),
+		intern ("misses"), make_number (regexp_cache_misses));
+}
+
 DEFUN ("newline-cache-check", Fnewline_cache_check, Snewline_cache_check,
        0, 1, 0,
        doc: /* Check the newline cache of BUFFER against buffer contents.
@@ -3285,23 +3922,6 @@ syms_of_search (void)
 {
 #include "search.x"
 
-  register int i;
-
-  for (i = 0; i < REGEXP_CACHE_SIZE; ++i)
-    {
-      searchbufs[i].buf.allocated = 100;
-      searchbufs[i].buf.buffer = xmalloc_atomic (100);
-      searchbufs[i].buf.fastmap = searchbufs[i].fastmap;
-      searchbufs[i].regexp = Qnil;
-      searchbufs[i].whitespace_regexp = Qnil;
-      searchbufs[i].syntax_table = Qnil;
-      staticpro (&searchbufs[i].regexp);
-      staticpro (&searchbufs[i].whitespace_regexp);
-      staticpro (&searchbufs[i].syntax_table);
-      searchbufs[i].next = (i == REGEXP_CACHE_SIZE-1 ? 0 : &searchbufs[i+1]);
-    }
-  searchbuf_head = &searchbufs[0];
-
   DEFSYM (Qsearch_failed, "search-failed");
   DEFSYM (Qinvalid_regexp, "invalid-regexp");
 
@@ -3336,4 +3956,13 @@ such as `looking-at', `string-match', `re-search-forward', etc.,
 do not set the match data.  The proper way to use this variable
 is to bind it with `let' around a small expression.  */);
   Vinhibit_changing_match_data = Qnil;
+
+  DEFVAR_INT ("regexp-cache-size", regexp_cache_size,
+	      doc: /* Number of compiled regexps to keep for reuse.
+Searching and matching functions compile their regexp argument, and
+keep the most recently used compiled regexps so that searching for
+the same regexp again needs no compilation.  Changing this value
+discards the kept regexps.  See also `regexp-cache-statistics'.  */);
+  regexp_cache_size = 100;
+  resize_regexp_cache (regexp_cache_size);
 }
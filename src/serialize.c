@@ -0,0 +1,777 @@
+/* Binary serialization of Lisp objects.
+   Copyright (C) 2014 Free Software Foundation, Inc.
+
+This file is part of GNU Emacs.
+
+GNU Emacs is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+GNU Emacs is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* The format is the magic SERIALIZE_MAGIC followed by one object.
+   Each object starts with a tag byte:
+
+     n  nil
+     t  t
+     i  a fixnum, as a zigzag-encoded number
+     f  a float, as the 8 bytes of its IEEE double, least significant
+	first
+     s  a string: a multibyte flag byte, the number of characters, the
+	number of bytes, and the bytes
+     P  a string with text properties: the same as `s', then the number
+	of property runs, then for each run its start, its end and its
+	property list
+     y  an interned symbol: its name, as for `s'
+     u  an uninterned symbol: its name, as for `s'
+     l  a list: its length N, the N elements, then the last cdr
+     v  a vector: its length, then the elements
+     h  a hash table: its test, its weakness, its rehash size and its
+	rehash threshold, the number of entries, then the keys and values
+     b  a bool vector: its length, then its bytes
+     d  the definition of a label, followed by the labeled object
+     r  a reference to a label, followed by the label
+
+   Numbers are unsigned LEB128: 7 bits a byte, least significant first,
+   with the high bit set in all but the last byte.  An object that
+   occurs more than once is labeled where it first occurs and referred
+   to by its label afterwards, which preserves sharing and cycles.
+   Labels are numbered from 0 in the order they are defined.  A list
+   stops where its tail is shared, so that the tail can be labeled.  */
+
+#include <config.h>
+
+#include <string.h>
+
+#include "lisp.h"
+#include "character.h"
+
+#define SERIALIZE_MAGIC "\177ELSER1\n"
+enum { SERIALIZE_MAGIC_LEN = sizeof SERIALIZE_MAGIC - 1 };
+
+/* Objects nested deeper than this are rejected, to keep the recursion
+   from overflowing the C stack.  Long lists do not count, only their
+   nested elements.  */
+enum { SERIALIZE_MAX_DEPTH = 10000 };
+
+
+/***********************************************************************
+			      Serialization
+ ***********************************************************************/
+
+struct serializer
+{
+  struct Lisp_String_Builder *b;
+
+  /* An eq hash table of the objects found so far.  The value is nil if
+     the object was found once, t if it was found more than once, and
+     its label once it has been written.  */
+  Lisp_Object seen;
+
+  /* The next label to define.  */
+  EMACS_INT next_label;
+};
+
+/* Return true if OBJECT is of a type whose identity is preserved.  */
+
+static bool
+serialize_shareable_p (Lisp_Object object)
+{
+  return (CONSP (object) || STRINGP (object) || VECTORP (object)
+	  || HASH_TABLE_P (object) || BOOL_VECTOR_P (object)
+	  || (SYMBOLP (object) && !NILP (object) && !EQ (object, Qt)));
+}
+
+/* Return true if OBJECT was found more than once.  */
+
+static bool
+serialize_shared_p (struct serializer *s, Lisp_Object object)
+{
+  struct Lisp_Hash_Table *h = XHASH_TABLE (s->seen);
+  ptrdiff_t i = hash_lookup (h, object, NULL);
+
+  return i >= 0 && !NILP (HASH_VALUE (h, i));
+}
+
+/* Return a list of the runs of text properties of STRING, each a list
+   (START END PLIST).  Runs without properties are left out.  */
+
+static Lisp_Object
+serialize_string_properties (Lisp_Object string)
+{
+  Lisp_Object runs = Qnil, start, end;
+
+  if (!string_intervals (string))
+    return Qnil;
+
+  for (start = make_number (0); XINT (start) < SCHARS (string); start = end)
+    {
+      Lisp_Object plist = Ftext_properties_at (start, string);
+
+      end = Fnext_property_change (start, string, Qnil);
+      if (NILP (end))
+	end = make_number (SCHARS (string));
+      if (!NILP (plist))
+	runs = Fcons (list3 (start, end, plist), runs);
+    }
+  return Fnreverse (runs);
+}
+
+/* Record the objects in OBJECT in the table of S, noting which ones
+   occur more than once.  DEPTH counts the enclosing objects.  */
+
+static void
+serialize_scan (struct serializer *s, Lisp_Object object, int depth)
+{
+  ptrdiff_t i;
+
+  if (depth > SERIALIZE_MAX_DEPTH)
+    error ("Object too deep to serialize");
+
+  while (serialize_shareable_p (object))
+    {
+      struct Lisp_Hash_Table *h = XHASH_TABLE (s->seen);
+      EMACS_UINT hash;
+
+      i = hash_lookup (h, object, &hash);
+      if (i >= 0)
+	{
+	  set_hash_value_slot (h, i, Qt);
+	  return;
+	}
+      hash_put (h, object, Qnil, hash);
+
+      if (!CONSP (object))
+	break;
+      serialize_scan (s, XCAR (object), depth + 1);
+      object = XCDR (object);
+    }
+
+  if (STRINGP (object))
+    {
+      Lisp_Object runs;
+
+      for (runs = serialize_string_properties (object); CONSP (runs);
+	   runs = XCDR (runs))
+	serialize_scan (s, XCAR (XCDR (XCDR (XCAR (runs)))), depth + 1);
+    }
+  else if (VECTORP (object))
+    {
+      for (i = 0; i < ASIZE (object); i++)
+	serialize_scan (s, AREF (object, i), depth + 1);
+    }
+  else if (HASH_TABLE_P (object))
+    {
+      struct Lisp_Hash_Table *h = XHASH_TABLE (object);
+
+      for (i = 0; i < HASH_TABLE_SIZE (h); i++)
+	if (!NILP (HASH_HASH (h, i)))
+	  {
+	    serialize_scan (s, HASH_KEY (h, i), depth + 1);
+	    serialize_scan (s, HASH_VALUE (h, i), depth + 1);
+	  }
+    }
+}
+
+static void
+serialize_byte (struct serializer *s, int byte)
+{
+  unsigned char c = byte;
+  string_builder_append (s->b, &c, 1, 1, false);
+}
+
+static void
+serialize_bytes (struct serializer *s, const unsigned char *data,
+		 ptrdiff_t nbytes)
+{
+  string_builder_append (s->b, data, nbytes, nbytes, false);
+}
+
+static void
+serialize_uint (struct serializer *s, EMACS_UINT n)
+{
+  unsigned char buf[(sizeof n * CHAR_BIT + 6) / 7];
+  int len = 0;
+
+  do
+    {
+      buf[len] = n & 0x7f;
+      n >>= 7;
+      if (n)
+	buf[len] |= 0x80;
+      len++;
+    }
+  while (n);
+  serialize_bytes (s, buf, len);
+}
+
+/* Write the multibyte flag, the length and the bytes of STRING.  */
+
+static void
+serialize_string_data (struct serializer *s, Lisp_Object string)
+{
+  serialize_byte (s, STRING_MULTIBYTE (string));
+  serialize_uint (s, SCHARS (string));
+  serialize_uint (s, SBYTES (string));
+  serialize_bytes (s, SDATA (string), SBYTES (string));
+}
+
+static void
+serialize_write (struct serializer *s, Lisp_Object object)
+{
+  ptrdiff_t i;
+
+ tail_recurse:
+  if (NILP (object))
+    {
+      serialize_byte (s, 'n');
+      return;
+    }
+  if (EQ (object, Qt))
+    {
+      serialize_byte (s, 't');
+      return;
+    }
+  if (INTEGERP (object))
+    {
+      EMACS_INT n = XINT (object);
+
+      serialize_byte (s, 'i');
+      serialize_uint (s, (n < 0
+			  ? ~ ((EMACS_UINT) n << 1)
+			  : (EMACS_UINT) n << 1));
+      return;
+    }
+  if (FLOATP (object))
+    {
+      double d = XFLOAT_DATA (object);
+      uint64_t bits;
+      unsigned char buf[8];
+
+      memcpy (&bits, &d, sizeof bits);
+      for (i = 0; i < 8; i++)
+	buf[i] = bits >> (8 * i);
+      serialize_byte (s, 'f');
+      serialize_bytes (s, buf, 8);
+      return;
+    }
+  if (!serialize_shareable_p (object))
+    signal_error ("Cannot serialize object", object);
+
+  {
+    struct Lisp_Hash_Table *h = XHASH_TABLE (s->seen);
+    ptrdiff_t label = hash_lookup (h, object, NULL);
+
+    if (label >= 0)
+      {
+	Lisp_Object value = HASH_VALUE (h, label);
+
+	if (INTEGERP (value))
+	  {
+	    serialize_byte (s, 'r');
+	    serialize_uint (s, XINT (value));
+	    return;
+	  }
+	if (EQ (value, Qt))
+	  {
+	    set_hash_value_slot (h, label, make_number (s->next_label++));
+	    serialize_byte (s, 'd');
+	  }
+      }
+  }
+
+  if (CONSP (object))
+    {
+      Lisp_Object tail = XCDR (object);
+      EMACS_INT n = 1;
+
+      while (CONSP (tail) && !serialize_shared_p (s, tail))
+	n++, tail = XCDR (tail);
+      serialize_byte (s, 'l');
+      serialize_uint (s, n);
+      for (; n > 0; n--, object = XCDR (object))
+	serialize_write (s, XCAR (object));
+      /* A shared tail may be the start of a long list.  */
+      object = tail;
+      goto tail_recurse;
+    }
+  else if (STRINGP (object))
+    {
+      Lisp_Object runs = serialize_string_properties (object);
+
+      serialize_byte (s, NILP (runs) ? 's' : 'P');
+      serialize_string_data (s, object);
+      if (!NILP (runs))
+	{
+	  serialize_uint (s, XFASTINT (Flength (runs)));
+	  for (; CONSP (runs); runs = XCDR (runs))
+	    {
+	      Lisp_Object run = XCAR (runs);
+
+	      serialize_uint (s, XFASTINT (XCAR (run)));
+	      serialize_uint (s, XFASTINT (XCAR (XCDR (run))));
+	      serialize_write (s, XCAR (XCDR (XCDR (run))));
+	    }
+	}
+    }
+  else if (SYMBOLP (object))
+    {
+      serialize_byte (s, SYMBOL_INTERNED_P (object) ? 'y' : 'u');
+      serialize_string_data (s, SYMBOL_NAME (object));
+    }
+  else if (VECTORP (object))
+    {
+      serialize_byte (s, 'v');
+      serialize_uint (s, ASIZE (object));
+      for (i = 0; i < ASIZE (object); i++)
+	serialize_write (s, AREF (object, i));
+    }
+  else if (HASH_TABLE_P (object))
+    {
+      struct Lisp_Hash_Table *h = XHASH_TABLE (object);
+
+      serialize_byte (s, 'h');
+      serialize_write (s, h->test.name);
+      serialize_write (s, h->weak);
+      serialize_write (s, h->rehash_size);
+      serialize_write (s, h->rehash_threshold);
+      serialize_uint (s, h->count);
+      for (i = 0; i < HASH_TABLE_SIZE (h); i++)
+	if (!NILP (HASH_HASH (h, i)))
+	  {
+	    serialize_write (s, HASH_KEY (h, i));
+	    serialize_write (s, HASH_VALUE (h, i));
+	  }
+    }
+  else
+    {
+      EMACS_INT nbits = bool_vector_size (object);
+
+      serialize_byte (s, 'b');
+      serialize_uint (s, nbits);
+      serialize_bytes (s, bool_vector_uchar_data (object),
+		       bool_vector_bytes (nbits));
+    }
+}
+
+DEFUN ("serialize-object", Fserialize_object, Sserialize_object, 1, 1, 0,
+       doc: /* Return a unibyte string that represents OBJECT.
+`deserialize-object' turns the string back into an object equal to
+OBJECT.  Shared structure and cycles are preserved, and so are the
+text properties of strings.
+
+OBJECT may be made of numbers, symbols, strings, conses, vectors,
+bool vectors and hash tables.  Other objects signal an error.  Only
+the names of symbols are recorded; an interned symbol is interned
+again when it is read, and an uninterned one is made anew.
+
+This is much faster than printing and reading OBJECT back, but the
+result is not meant for people to read.  */)
+  (Lisp_Object object)
+{
+  struct serializer s;
+  Lisp_Object builder = Fmake_string_builder ();
+  Lisp_Object args[2];
+
+  args[0] = QCtest;
+  args[1] = Qeq;
+  s.b = XSTRING_BUILDER (builder);
+  s.seen = Fmake_hash_table (2, args);
+  s.next_label = 0;
+
+  serialize_scan (&s, object, 0);
+  serialize_bytes (&s, (const unsigned char *) SERIALIZE_MAGIC,
+		   SERIALIZE_MAGIC_LEN);
+  serialize_write (&s, object);
+  return Fstring_builder_string (builder, Qnil);
+}
+
+
+/***********************************************************************
+			     Deserialization
+ ***********************************************************************/
+
+struct deserializer
+{
+  const unsigned char *p, *end;
+
+  /* The objects labeled so far, in the order of their labels.  */
+  Lisp_Object *labels;
+  ptrdiff_t nlabels, labels_size;
+};
+
+static _Noreturn void
+deserialize_invalid (void)
+{
+  error ("Invalid serialized data");
+}
+
+static int
+deserialize_byte (struct deserializer *d)
+{
+  if (d->p == d->end)
+    deserialize_invalid ();
+  return *d->p++;
+}
+
+static EMACS_UINT
+deserialize_uint (struct deserializer *d)
+{
+  EMACS_UINT n = 0;
+  int shift = 0, byte;
+
+  do
+    {
+      byte = deserialize_byte (d);
+      if (shift >= sizeof n * CHAR_BIT
+	  || ((EMACS_UINT) (byte & 0x7f) << shift >> shift) != (byte & 0x7f))
+	deserialize_invalid ();
+      n |= (EMACS_UINT) (byte & 0x7f) << shift;
+      shift += 7;
+    }
+  while (byte & 0x80);
+  return n;
+}
+
+/* Read a count of things that take at least one byte each, and check
+   that there are that many bytes left.  */
+
+static ptrdiff_t
+deserialize_count (struct deserializer *d)
+{
+  EMACS_UINT n = deserialize_uint (d);
+
+  if (n > d->end - d->p)
+    deserialize_invalid ();
+  return n;
+}
+
+/* Read the string data written by serialize_string_data.  */
+
+static Lisp_Object
+deserialize_string_data (struct deserializer *d)
+{
+  bool multibyte = deserialize_byte (d);
+  ptrdiff_t nchars = deserialize_count (d);
+  ptrdiff_t nbytes = deserialize_count (d);
+  const unsigned char *data = d->p;
+
+  if (nbytes > d->end - d->p)
+    deserialize_invalid ();
+  d->p += nbytes;
+
+  if (multibyte)
+    {
+      const unsigned char *q = data, *end = data + nbytes;
+      ptrdiff_t n = 0;
+
+      while (q < end)
+	{
+	  int len = MULTIBYTE_LENGTH (q, end);
+
+	  if (len == 0)
+	    deserialize_invalid ();
+	  q += len;
+	  n++;
+	}
+      if (n != nchars)
+	deserialize_invalid ();
+    }
+  else if (nchars != nbytes)
+    deserialize_invalid ();
+
+  return make_specified_string ((const char *) data, nchars, nbytes,
+				multibyte);
+}
+
+/* Return a new label, to be defined by the object read next.  */
+
+static ptrdiff_t
+deserialize_new_label (struct deserializer *d)
+{
+  if (d->nlabels == d->labels_size)
+    d->labels = xpalloc (d->labels, &d->labels_size, 1, -1,
+			 sizeof *d->labels);
+  d->labels[d->nlabels] = Qnil;
+  return d->nlabels++;
+}
+
+/* Record OBJECT as the object labeled LABEL, unless LABEL is
+   negative.  */
+
+static void
+deserialize_label (struct deserializer *d, ptrdiff_t label,
+		   Lisp_Object object)
+{
+  if (label >= 0)
+    d->labels[label] = object;
+}
+
+static Lisp_Object deserialize_read (struct deserializer *, int);
+
+/* Read a list, whose `l' tag has been read, labeling it LABEL unless
+   that is negative.  A tail that is another list, as when it is
+   shared, is read in the same loop.  */
+
+static Lisp_Object
+deserialize_list (struct deserializer *d, ptrdiff_t label, int depth)
+{
+  Lisp_Object head = Qnil, last = Qnil, run, tail;
+  ptrdiff_t i, n;
+
+  while (true)
+    {
+      n = deserialize_count (d);
+      if (n == 0)
+	deserialize_invalid ();
+      run = Qnil;
+      for (i = 0; i < n; i++)
+	run = Fcons (Qnil, run);
+      deserialize_label (d, label, run);
+      if (NILP (last))
+	head = run;
+      else
+	XSETCDR (last, run);
+
+      for (tail = run; ; tail = XCDR (tail))
+	{
+	  XSETCAR (tail, deserialize_read (d, depth + 1));
+	  if (NILP (XCDR (tail)))
+	    break;
+	}
+      last = tail;
+
+      if (d->end - d->p >= 2 && d->p[0] == 'd' && d->p[1] == 'l')
+	{
+	  d->p += 2;
+	  label = deserialize_new_label (d);
+	}
+      else if (d->p < d->end && d->p[0] == 'l')
+	{
+	  d->p++;
+	  label = -1;
+	}
+      else
+	{
+	  XSETCDR (last, deserialize_read (d, depth));
+	  return head;
+	}
+    }
+}
+
+/* Read an object, labeling it LABEL unless that is negative.  An
+   object is labeled as soon as it exists, before its elements are
+   read, so that they can refer to it.  */
+
+static Lisp_Object
+deserialize_read_1 (struct deserializer *d, ptrdiff_t label, int depth)
+{
+  Lisp_Object object;
+  ptrdiff_t i, n;
+
+  if (depth > SERIALIZE_MAX_DEPTH)
+    deserialize_invalid ();
+
+  switch (deserialize_byte (d))
+    {
+    case 'n':
+      return Qnil;
+
+    case 't':
+      return Qt;
+
+    case 'i':
+      {
+	EMACS_UINT u = deserialize_uint (d);
+	EMACS_INT v = u & 1 ? ~ (EMACS_INT) (u >> 1) : (EMACS_INT) (u >> 1);
+
+	if (FIXNUM_OVERFLOW_P (v))
+	  deserialize_invalid ();
+	return make_number (v);
+      }
+
+    case 'f':
+      {
+	uint64_t bits = 0;
+	double v;
+
+	if (d->end - d->p < 8)
+	  deserialize_invalid ();
+	for (i = 0; i < 8; i++)
+	  bits |= (uint64_t) d->p[i] << (8 * i);
+	d->p += 8;
+	memcpy (&v, &bits, sizeof v);
+	return make_float (v);
+      }
+
+    case 's':
+      object = deserialize_string_data (d);
+      deserialize_label (d, label, object);
+      return object;
+
+    case 'P':
+      object = deserialize_string_data (d);
+      deserialize_label (d, label, object);
+      for (n = deserialize_count (d); n > 0; n--)
+	{
+	  EMACS_UINT start = deserialize_uint (d);
+	  EMACS_UINT end = deserialize_uint (d);
+	  Lisp_Object plist = deserialize_read (d, depth + 1);
+
+	  if (! (start < end && end <= SCHARS (object)))
+	    deserialize_invalid ();
+	  Fset_text_properties (make_number (start), make_number (end),
+				plist, object);
+	}
+      return object;
+
+    case 'y':
+      object = Fintern (deserialize_string_data (d), Qnil);
+      deserialize_label (d, label, object);
+      return object;
+
+    case 'u':
+      object = Fmake_symbol (deserialize_string_data (d));
+      deserialize_label (d, label, object);
+      return object;
+
+    case 'l':
+      return deserialize_list (d, label, depth);
+
+    case 'v':
+      n = deserialize_count (d);
+      object = Fmake_vector (make_number (n), Qnil);
+      deserialize_label (d, label, object);
+      for (i = 0; i < n; i++)
+	ASET (object, i, deserialize_read (d, depth + 1));
+      return object;
+
+    case 'h':
+      {
+	Lisp_Object args[10];
+
+	args[0] = QCtest;
+	args[1] = deserialize_read (d, depth + 1);
+	args[2] = QCweakness;
+	args[3] = deserialize_read (d, depth + 1);
+	args[4] = QCrehash_size;
+	args[5] = deserialize_read (d, depth + 1);
+	args[6] = QCrehash_threshold;
+	args[7] = deserialize_read (d, depth + 1);
+	n = deserialize_count (d);
+	args[8] = QCsize;
+	args[9] = make_number (n);
+	object = Fmake_hash_table (10, args);
+	deserialize_label (d, label, object);
+	for (i = 0; i < n; i++)
+	  {
+	    Lisp_Object key = deserialize_read (d, depth + 1);
+	    Fputhash (key, deserialize_read (d, depth + 1), object);
+	  }
+	return object;
+      }
+
+    case 'b':
+      {
+	EMACS_UINT nbits = deserialize_uint (d);
+	ptrdiff_t nbytes;
+
+	if (nbits > (EMACS_UINT) (d->end - d->p) * BOOL_VECTOR_BITS_PER_CHAR)
+	  deserialize_invalid ();
+	nbytes = bool_vector_bytes (nbits);
+	if (nbytes > d->end - d->p)
+	  deserialize_invalid ();
+	object = make_uninit_bool_vector (nbits);
+	if (nbytes > 0)
+	  {
+	    memcpy (bool_vector_uchar_data (object), d->p, nbytes);
+	    /* Clear the bits past the end, as bool vectors must.  */
+	    if (nbits % BOOL_VECTOR_BITS_PER_CHAR)
+	      bool_vector_uchar_data (object)[nbytes - 1]
+		&= (1 << (nbits % BOOL_VECTOR_BITS_PER_CHAR)) - 1;
+	  }
+	d->p += nbytes;
+	deserialize_label (d, label, object);
+	return object;
+      }
+
+    default:
+      deserialize_invalid ();
+    }
+}
+
+static Lisp_Object
+deserialize_read (struct deserializer *d, int depth)
+{
+  int tag;
+
+  if (d->p == d->end)
+    deserialize_invalid ();
+  tag = *d->p;
+
+  if (tag == 'd')
+    {
+      d->p++;
+      return deserialize_read_1 (d, deserialize_new_label (d), depth);
+    }
+  if (tag == 'r')
+    {
+      EMACS_UINT label;
+
+      d->p++;
+      label = deserialize_uint (d);
+      if (label >= d->nlabels)
+	deserialize_invalid ();
+      return d->labels[label];
+    }
+  return deserialize_read_1 (d, -1, depth);
+}
+
+DEFUN ("deserialize-object", Fdeserialize_object, Sdeserialize_object,
+       1, 1, 0,
+       doc: /* Return the object represented by DATA.
+DATA is a string made by `serialize-object'.  Signal an error if it
+is not valid.  */)
+  (Lisp_Object data)
+{
+  struct deserializer d;
+  Lisp_Object object;
+
+  CHECK_STRING (data);
+  if (STRING_MULTIBYTE (data))
+    data = Fstring_to_unibyte (data);
+
+  d.p = SDATA (data);
+  d.end = d.p + SBYTES (data);
+  d.labels = NULL;
+  d.nlabels = d.labels_size = 0;
+
+  if (SBYTES (data) < SERIALIZE_MAGIC_LEN
+      || memcmp (d.p, SERIALIZE_MAGIC, SERIALIZE_MAGIC_LEN) != 0)
+    deserialize_invalid ();
+  d.p += SERIALIZE_MAGIC_LEN;
+
+  object = deserialize_read (&d, 0);
+  if (d.p != d.end)
+    deserialize_invalid ();
+  xfree (d.labels);
+  return object;
+}
+
+
+/***********************************************************************
+			    Initialization
+ ***********************************************************************/
+
+void
+syms_of_serialize (void)
+{
+#include "serialize.x"
+}
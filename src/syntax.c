@@ -183,6 +183,7 @@ static Lisp_Object scan_lists (EMACS_INT, EMACS_INT, EMACS_INT, bool);
 static void scan_sexps_forward (struct lisp_parse_state *,
                                 ptrdiff_t, ptrdiff_t, ptrdiff_t, EMACS_INT,
                                 bool, Lisp_Object, int);
+static Lisp_Object parse_cache_lookup (ptrdiff_t, bool, ptrdiff_t *);
 static bool in_classes (int, Lisp_Object);
 
 /* This setter is used only in this file, so it can be private.  */
@@ -201,6 +202,37 @@ syntax_prefix_flag_p (int c)
 
 struct gl_state_s gl_state;		/* Global state of syntax parser.  */
 
+struct syntax_flat syntax_flat_cache[SYNTAX_FLAT_ENTRIES];
+
+/* Return the entry of syntax_flat_cache for TABLE, moved to the front
+   and refilled if it was missing or stale.  When TABLE is not cached,
+   the least recently used entry is reused.  */
+struct syntax_flat *
+syntax_flat_lookup (Lisp_Object table)
+{
+  struct syntax_flat tem;
+  int i, c;
+
+  for (i = 0; i < SYNTAX_FLAT_ENTRIES - 1; i++)
+    if (EQ (syntax_flat_cache[i].table, table))
+      break;
+  tem = syntax_flat_cache[i];
+  if (! (EQ (tem.table, table) && tem.modiff == char_table_modiff))
+    {
+      tem.table = table;
+      tem.modiff = char_table_modiff;
+      for (c = 0; c < 0400; c++)
+	{
+	  Lisp_Object ent = CHAR_TABLE_REF (table, c);
+	  tem.flags[c] = CONSP (ent) ? XINT (XCAR (ent)) : Swhitespace;
+	}
+    }
+  memmove (syntax_flat_cache + 1, syntax_flat_cache,
+	   i * sizeof *syntax_flat_cache);
+  syntax_flat_cache[0] = tem;
+  return syntax_flat_cache;
+}
+
 enum { INTERVALS_AT_ONCE = 10 };	/* 1 + max-number of intervals
 					   to scan to property-change.  */
 
@@ -529,16 +561,21 @@ static ptrdiff_t
 find_defun_start (ptrdiff_t pos, ptrdiff_t pos_byte)
 {
   ptrdiff_t opoint = PT, opoint_byte = PT_BYTE;
+  ptrdiff_t limit = BEGV;
+
+  /* A cached parse state at top level is as good a start as BEGV,
+     and nearer.  */
+  parse_cache_lookup (pos, 1, &limit);
 
   if (!open_paren_in_column_0_is_defun_start)
     {
-      find_start_value = BEGV;
-      find_start_value_byte = BEGV_BYTE;
+      find_start_value = limit;
+      find_start_value_byte = CHAR_TO_BYTE (limit);
       find_start_buffer = current_buffer;
       find_start_modiff = MODIFF;
       find_start_begv = BEGV;
       find_start_pos = pos;
-      return BEGV;
+      return limit;
     }
 
   /* Use previous finding, if it's valid and applies to this inquiry.  */
@@ -559,7 +596,7 @@ find_defun_start (ptrdiff_t pos, ptrdiff_t pos_byte)
      only those `^\s(' which are good in global _and_ text-property
      syntax-tables.  */
   SETUP_BUFFER_SYNTAX_TABLE ();
-  while (PT > BEGV)
+  while (PT > limit)
     {
       int c;
 
@@ -578,6 +615,8 @@ find_defun_start (ptrdiff_t pos, ptrdiff_t pos_byte)
       /* Move to beg of previous line.  */
       scan_newline (PT, PT_BYTE, BEGV, BEGV_BYTE, -2, 1);
     }
+  if (PT < limit)
+    TEMP_SET_PT_BOTH (limit, CHAR_TO_BYTE (limit));
 
   /* Record what we found, for the next try.  */
   find_start_value = PT;
@@ -841,6 +880,8 @@ back_comment (ptrdiff_t from, ptrdiff_t from_byte, ptrdiff_t stop,
   else
     {
       struct lisp_parse_state state;
+      Lisp_Object oldstate;
+      ptrdiff_t cached_pos;
     lossage:
       /* We had two kinds of string delimiters mixed up
 	 together.  Decode this going forwards.
@@ -853,12 +894,23 @@ back_comment (ptrdiff_t from, ptrdiff_t from_byte, ptrdiff_t stop,
 	  defun_start = find_defun_start (comment_end, comment_end_byte);
 	  defun_start_byte = find_start_value_byte;
 	}
+      /* Resume from a cached parse state after the defun start, if
+	 there is one.  */
+      oldstate = parse_cache_lookup (comment_end, 0, &cached_pos);
+      if (!NILP (oldstate) && cached_pos > defun_start)
+	{
+	  defun_start = cached_pos;
+	  defun_start_byte = CHAR_TO_BYTE (cached_pos);
+	}
+      else
+	oldstate = Qnil;
       do
 	{
 	  scan_sexps_forward (&state,
 			      defun_start, defun_start_byte,
 			      comment_end, TYPE_MINIMUM (EMACS_INT),
-			      0, Qnil, 0);
+			      0, oldstate, 0);
+	  oldstate = Qnil;
 	  defun_start = comment_end;
 	  if (state.incomment == (comnested ? 1 : -1)
 	      && state.comstyle == comstyle)
@@ -1900,6 +1952,18 @@ skip_chars (bool forwardp, Lisp_Object string, Lisp_Object lim,
 		  p = GAP_END_ADDR;
 		  stop = endp;
 		}
+	      if (NILP (iso_classes))
+		{
+		  /* Skip a run of ASCII characters without decoding
+		     them; each is a single byte.  */
+		  unsigned char *q = p;
+		  while (q < stop && ASCII_CHAR_P (*q) && fastmap[*q])
+		    q++;
+		  pos += q - p, pos_byte += q - p;
+		  p = q;
+		  if (p >= stop)
+		    continue;
+		}
 	      c = STRING_CHAR_AND_LENGTH (p, nbytes);
 	      if (! NILP (iso_classes) && in_classes (c, iso_classes))
 		{
@@ -1969,6 +2033,16 @@ skip_chars (bool forwardp, Lisp_Object string, Lisp_Object lim,
 		  p = GPT_ADDR;
 		  stop = endp;
 		}
+	      if (NILP (iso_classes))
+		{
+		  unsigned char *q = p;
+		  while (q > stop && ASCII_CHAR_P (q[-1]) && fastmap[q[-1]])
+		    q--;
+		  pos -= p - q, pos_byte -= p - q;
+		  p = q;
+		  if (p <= stop)
+		    continue;
+		}
 	      prev_p = p;
 	      while (--p >= stop && ! CHAR_HEAD_P (*p));
 	      c = STRING_CHAR (p);
@@ -2034,6 +2108,12 @@ skip_syntaxes (bool forwardp, Lisp_Object string, Lisp_Object lim)
 {
   int c;
   unsigned char fastmap[0400];
+  /* SKIPMAP[B] is nonzero if the character B is to be skipped, for
+     all B if the buffer is unibyte, else for ASCII B.  It is valid
+     only if USE_SKIPMAP, that is, if the syntax of a character does
+     not depend on its position.  */
+  unsigned char skipmap[0400];
+  bool use_skipmap;
   bool negate = 0;
   ptrdiff_t i, i_byte;
   bool multibyte;
@@ -2108,6 +2188,10 @@ skip_syntaxes (bool forwardp, Lisp_Object string, Lisp_Object lim)
 
     immediate_quit = 1;
     SETUP_SYNTAX_TABLE (pos, forwardp ? 1 : -1);
+    use_skipmap = !parse_sexp_lookup_properties;
+    if (use_skipmap)
+      for (i = 0; i < (multibyte ? 0200 : 0400); i++)
+	skipmap[i] = fastmap[SYNTAX (i)];
     if (forwardp)
       {
 	if (multibyte)
@@ -2123,6 +2207,16 @@ skip_syntaxes (bool forwardp, Lisp_Object string, Lisp_Object lim)
 		    p = GAP_END_ADDR;
 		    stop = endp;
 		  }
+		if (use_skipmap)
+		  {
+		    unsigned char *q = p;
+		    while (q < stop && ASCII_CHAR_P (*q) && skipmap[*q])
+		      q++;
+		    pos += q - p, pos_byte += q - p;
+		    p = q;
+		    if (p >= stop)
+		      continue;
+		  }
 		c = STRING_CHAR_AND_LENGTH (p, nbytes);
 		if (! fastmap[SYNTAX (c)])
 		  break;
@@ -2141,6 +2235,17 @@ skip_syntaxes (bool forwardp, Lisp_Object string, Lisp_Object lim)
 		    p = GAP_END_ADDR;
 		    stop = endp;
 		  }
+		if (use_skipmap)
+		  {
+		    unsigned char *q = p;
+		    while (q < stop && skipmap[*q])
+		      q++;
+		    pos += q - p, pos_byte += q - p;
+		    p = q;
+		    if (p >= stop)
+		      continue;
+		    break;
+		  }
 		if (! fastmap[SYNTAX (*p)])
 		  break;
 		p++, pos++, pos_byte++;
@@ -2163,6 +2268,16 @@ skip_syntaxes (bool forwardp, Lisp_Object string, Lisp_Object lim)
 		    p = GPT_ADDR;
 		    stop = endp;
 		  }
+		if (use_skipmap)
+		  {
+		    unsigned char *q = p;
+		    while (q > stop && ASCII_CHAR_P (q[-1]) && skipmap[q[-1]])
+		      q--;
+		    pos -= p - q, pos_byte -= p - q;
+		    p = q;
+		    if (p <= stop)
+		      continue;
+		  }
 		UPDATE_SYNTAX_TABLE_BACKWARD (pos - 1);
 		prev_p = p;
 		while (--p >= stop && ! CHAR_HEAD_P (*p));
@@ -2183,6 +2298,17 @@ skip_syntaxes (bool forwardp, Lisp_Object string, Lisp_Object lim)
 		    p = GPT_ADDR;
 		    stop = endp;
 		  }
+		if (use_skipmap)
+		  {
+		    unsigned char *q = p;
+		    while (q > stop && skipmap[q[-1]])
+		      q--;
+		    pos -= p - q, pos_byte -= p - q;
+		    p = q;
+		    if (p <= stop)
+		      continue;
+		    break;
+		  }
 		UPDATE_SYNTAX_TABLE_BACKWARD (pos - 1);
 		if (! fastmap[SYNTAX (p[-1])])
 		  break;
@@ -3400,6 +3526,316 @@ do { prev_from = from;				\
   *stateptr = state;
 }
 
+/* Return the value of parse-partial-sexp for the parse state STATE.  */
+
+static Lisp_Object
+parse_state_list (struct lisp_parse_state *state)
+{
+  return Fcons (make_number (state->depth),
+	   Fcons (state->prevlevelstart < 0
+		  ? Qnil : make_number (state->prevlevelstart),
+	     Fcons (state->thislevelstart < 0
+		    ? Qnil : make_number (state->thislevelstart),
+	       Fcons (state->instring >= 0
+		      ? (state->instring == ST_STRING_STYLE
+			 ? Qt : make_number (state->instring)) : Qnil,
+		 Fcons (state->incomment < 0 ? Qt :
+			(state->incomment == 0 ? Qnil :
+			 make_number (state->incomment)),
+		   Fcons (state->quoted ? Qt : Qnil,
+		     Fcons (make_number (state->mindepth),
+		       Fcons ((state->comstyle
+			       ? (state->comstyle == ST_COMMENT_STYLE
+				  ? Qsyntax_table
+				  : make_number (state->comstyle))
+			       : Qnil),
+			      Fcons (((state->incomment
+				       || (state->instring >= 0))
+				      ? make_number (state->comstr_start)
+				      : Qnil),
+				     Fcons (state->levelstarts, Qnil))))))))));
+}
+
+
+/* Parse states that parse-partial-sexp has computed without OLDSTATE
+   or stopping conditions, so that a later parse from the same start
+   can resume from the nearest of them instead of starting over.
+
+   parse_state_cache maps each buffer to a vector of PARSE_CACHE_SLOTS
+   elements, described below.  The states are at increasing positions
+   about PARSE_CACHE_INTERVAL characters apart.  Changes to the buffer
+   discard the states beyond the change in parse_cache_flush; the
+   recorded MODIFF catches any change that bypasses that.  */
+
+enum
+  {
+    PARSE_CACHE_FROM,		/* Start of the parse.  */
+    PARSE_CACHE_TABLE,		/* Syntax table used.  */
+    PARSE_CACHE_FLAGS,		/* parse_cache_flags when used.  */
+    PARSE_CACHE_MODIFF,		/* Expected MODIFF.  */
+    PARSE_CACHE_COUNT,		/* Number of states.  */
+    PARSE_CACHE_POSITIONS,	/* Vector of their positions.  */
+    PARSE_CACHE_STATES,		/* Vector of their values.  */
+    PARSE_CACHE_SLOTS
+  };
+
+enum { PARSE_CACHE_INTERVAL = 5000 };
+
+static Lisp_Object parse_state_cache;
+
+/* Return the settings other than the syntax table that a parse from
+   FROM depends on.  */
+
+static EMACS_INT
+parse_cache_flags (ptrdiff_t from)
+{
+  return (parse_sexp_ignore_comments
+	  | parse_sexp_lookup_properties << 1
+	  | (from == BEGV) << 2);
+}
+
+/* Return the number of states in the cache ENTRY at positions not
+   after POS.  */
+
+static ptrdiff_t
+parse_cache_count_upto (Lisp_Object entry, ptrdiff_t pos)
+{
+  Lisp_Object positions = AREF (entry, PARSE_CACHE_POSITIONS);
+  ptrdiff_t lo = 0, hi = XINT (AREF (entry, PARSE_CACHE_COUNT));
+
+  while (lo < hi)
+    {
+      ptrdiff_t mid = lo + (hi - lo) / 2;
+      if (XINT (AREF (positions, mid)) <= pos)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo;
+}
+
+/* Forget the parse states of the current buffer that may be affected
+   by a change of the text starting at POS.  Called before the
+   change.  */
+
+void
+parse_cache_flush (ptrdiff_t pos)
+{
+  struct Lisp_Hash_Table *h;
+  Lisp_Object buffer, entry;
+  ptrdiff_t i;
+
+  if (NILP (parse_state_cache))
+    return;
+  h = XHASH_TABLE (parse_state_cache);
+  XSETBUFFER (buffer, current_buffer);
+  i = hash_lookup (h, buffer, NULL);
+  if (i < 0)
+    return;
+  entry = HASH_VALUE (h, i);
+  if (XINT (AREF (entry, PARSE_CACHE_MODIFF)) != MODIFF
+      || pos < XINT (AREF (entry, PARSE_CACHE_FROM)))
+    ASET (entry, PARSE_CACHE_COUNT, make_number (0));
+  else
+    ASET (entry, PARSE_CACHE_COUNT,
+	  make_number (parse_cache_count_upto (entry, pos)));
+  /* The change about to be made increments MODIFF once.  */
+  ASET (entry, PARSE_CACHE_MODIFF, make_number (MODIFF + 1));
+}
+
+/* Return the parse state cache of the current buffer for parses
+   starting at FROM, emptying it if it is out of date.  */
+
+static Lisp_Object
+parse_cache_entry (ptrdiff_t from)
+{
+  struct Lisp_Hash_Table *h;
+  Lisp_Object buffer, entry;
+  EMACS_UINT hash;
+  ptrdiff_t i;
+
+  if (NILP (parse_state_cache))
+    parse_state_cache
+      = make_hash_table (hashtest_eql, make_number (DEFAULT_HASH_SIZE),
+			 make_float (DEFAULT_REHASH_SIZE),
+			 make_float (DEFAULT_REHASH_THRESHOLD),
+			 intern ("key"));
+  h = XHASH_TABLE (parse_state_cache);
+  XSETBUFFER (buffer, current_buffer);
+  i = hash_lookup (h, buffer, &hash);
+  if (i >= 0)
+    entry = HASH_VALUE (h, i);
+  else
+    {
+      entry = Fmake_vector (make_number (PARSE_CACHE_SLOTS), Qnil);
+      ASET (entry, PARSE_CACHE_POSITIONS,
+	    Fmake_vector (make_number (16), Qnil));
+      ASET (entry, PARSE_CACHE_STATES, Fmake_vector (make_number (16), Qnil));
+      hash_put (h, buffer, entry, hash);
+    }
+
+  if (! (EQ (AREF (entry, PARSE_CACHE_FROM), make_number (from))
+	 && EQ (AREF (entry, PARSE_CACHE_TABLE),
+		BVAR (current_buffer, syntax_table))
+	 && EQ (AREF (entry, PARSE_CACHE_FLAGS),
+		make_number (parse_cache_flags (from)))
+	 && EQ (AREF (entry, PARSE_CACHE_MODIFF), make_number (MODIFF))))
+    {
+      ASET (entry, PARSE_CACHE_FROM, make_number (from));
+      ASET (entry, PARSE_CACHE_TABLE, BVAR (current_buffer, syntax_table));
+      ASET (entry, PARSE_CACHE_FLAGS, make_number (parse_cache_flags (from)));
+      ASET (entry, PARSE_CACHE_MODIFF, make_number (MODIFF));
+      ASET (entry, PARSE_CACHE_COUNT, make_number (0));
+    }
+  return entry;
+}
+
+/* Return the last parse state cached for the current buffer at or
+   before POS, storing its position in *FOUND_POS, or nil if there is
+   none.  Only parses from BEGV count, since they start at top level.
+   If TOP_LEVEL, consider only states outside any parens, strings and
+   comments.  */
+
+static Lisp_Object
+parse_cache_lookup (ptrdiff_t pos, bool top_level, ptrdiff_t *found_pos)
+{
+  Lisp_Object buffer, entry;
+  ptrdiff_t i, k;
+
+  if (NILP (parse_state_cache))
+    return Qnil;
+  XSETBUFFER (buffer, current_buffer);
+  i = hash_lookup (XHASH_TABLE (parse_state_cache), buffer, NULL);
+  if (i < 0)
+    return Qnil;
+  entry = HASH_VALUE (XHASH_TABLE (parse_state_cache), i);
+  if (! (EQ (AREF (entry, PARSE_CACHE_FROM), make_number (BEGV))
+	 && EQ (AREF (entry, PARSE_CACHE_TABLE),
+		BVAR (current_buffer, syntax_table))
+	 && EQ (AREF (entry, PARSE_CACHE_FLAGS),
+		make_number (parse_cache_flags (BEGV)))
+	 && EQ (AREF (entry, PARSE_CACHE_MODIFF), make_number (MODIFF))))
+    return Qnil;
+
+  for (k = parse_cache_count_upto (entry, pos); k > 0; k--)
+    {
+      Lisp_Object state = AREF (AREF (entry, PARSE_CACHE_STATES), k - 1);
+
+      if (!top_level
+	  || (EQ (Fcar (state), make_number (0))
+	      && NILP (Fnth (make_number (3), state))
+	      && NILP (Fnth (make_number (4), state))
+	      && NILP (Fnth (make_number (5), state))))
+	{
+	  Lisp_Object positions = AREF (entry, PARSE_CACHE_POSITIONS);
+	  *found_pos = XINT (AREF (positions, k - 1));
+	  return state;
+	}
+    }
+  return Qnil;
+}
+
+/* Return a position near POS, and after it, at which a parse can be
+   split without losing a two-character comment delimiter whose first
+   character is before the position.  */
+
+static ptrdiff_t
+parse_cache_split_position (ptrdiff_t pos, ptrdiff_t end)
+{
+  while (pos < end)
+    {
+      int c = FETCH_CHAR_AS_MULTIBYTE (CHAR_TO_BYTE (pos - 1));
+      int syntax;
+
+      UPDATE_SYNTAX_TABLE_FORWARD (pos - 1);
+      syntax = SYNTAX_WITH_FLAGS (c);
+      if (! (SYNTAX_FLAGS_COMSTART_FIRST (syntax)
+	     || SYNTAX_FLAGS_COMEND_FIRST (syntax)))
+	break;
+      pos++;
+    }
+  return pos;
+}
+
+/* Like parse-partial-sexp from FROM to TO with no other arguments,
+   but resume from the nearest cached state before TO, and cache the
+   states passed on the way.  */
+
+static Lisp_Object
+parse_partial_sexp_cached (ptrdiff_t from, ptrdiff_t to)
+{
+  Lisp_Object entry = parse_cache_entry (from);
+  ptrdiff_t count = XINT (AREF (entry, PARSE_CACHE_COUNT));
+  ptrdiff_t k = parse_cache_count_upto (entry, to);
+  ptrdiff_t pos = from;
+  Lisp_Object value = Qnil;
+  struct lisp_parse_state state;
+
+  if (k > 0)
+    {
+      pos = XINT (AREF (AREF (entry, PARSE_CACHE_POSITIONS), k - 1));
+      value = AREF (AREF (entry, PARSE_CACHE_STATES), k - 1);
+    }
+
+  while (pos < to || NILP (value))
+    {
+      ptrdiff_t end = to;
+      bool checkpoint = 0;
+
+      if (k == count && to - pos > PARSE_CACHE_INTERVAL)
+	{
+	  SETUP_SYNTAX_TABLE (pos + PARSE_CACHE_INTERVAL - 1, 1);
+	  end = parse_cache_split_position (pos + PARSE_CACHE_INTERVAL, to);
+	  checkpoint = end < to;
+	}
+
+      scan_sexps_forward (&state, pos, CHAR_TO_BYTE (pos), end,
+			  TYPE_MINIMUM (EMACS_INT), 0, value, 0);
+
+      /* A resumed parse ignores elements 2 and 6 of the old state;
+	 combine them with the new ones.  */
+      if (!NILP (value))
+	{
+	  EMACS_INT depth = XINT (Fcar (value));
+	  Lisp_Object last = Fnth (make_number (2), value);
+	  Lisp_Object mindepth = Fnth (make_number (6), value);
+
+	  if (state.thislevelstart < 0 && state.depth == depth
+	      && state.mindepth >= depth && INTEGERP (last))
+	    state.thislevelstart = XINT (last);
+	  if (INTEGERP (mindepth))
+	    state.mindepth = min (state.mindepth, XINT (mindepth));
+	}
+
+      value = parse_state_list (&state);
+      pos = state.location;
+
+      if (checkpoint && pos == end)
+	{
+	  Lisp_Object positions = AREF (entry, PARSE_CACHE_POSITIONS);
+	  Lisp_Object states = AREF (entry, PARSE_CACHE_STATES);
+
+	  if (count == ASIZE (positions))
+	    {
+	      positions = larger_vector (positions, 1, -1);
+	      states = larger_vector (states, 1, -1);
+	      ASET (entry, PARSE_CACHE_POSITIONS, positions);
+	      ASET (entry, PARSE_CACHE_STATES, states);
+	    }
+	  ASET (positions, count, make_number (pos));
+	  ASET (states, count, value);
+	  count++;
+	  k = count;
+	  ASET (entry, PARSE_CACHE_COUNT, make_number (count));
+	}
+      else if (pos != end)
+	break;
+    }
+
+  SET_PT (pos);
+  return Fcopy_sequence (value);
+}
+
 DEFUN ("parse-partial-sexp", Fparse_partial_sexp, Sparse_partial_sexp, 2, 6, 0,
        doc: /* Parse Lisp syntax starting at FROM until TO; return status of parse at TO.
 Parsing stops at TO or when certain criteria are met;
@@ -3445,6 +3881,10 @@ Sixth arg COMMENTSTOP non-nil means stop at the start of a comment.
     target = TYPE_MINIMUM (EMACS_INT);	/* We won't reach this depth */
 
   validate_region (&from, &to);
+  if (NILP (targetdepth) && NILP (stopbefore) && NILP (oldstate)
+      && NILP (commentstop))
+    return parse_partial_sexp_cached (XINT (from), XINT (to));
+
   scan_sexps_forward (&state, XINT (from), CHAR_TO_BYTE (XINT (from)),
 		      XINT (to),
 		      target, !NILP (stopbefore), oldstate,
@@ -3453,31 +3893,9 @@ Sixth arg COMMENTSTOP non-nil means stop at the start of a comment.
 
   SET_PT_BOTH (state.location, state.location_byte);
 
-  return Fcons (make_number (state.depth),
-	   Fcons (state.prevlevelstart < 0
-		  ? Qnil : make_number (state.prevlevelstart),
-	     Fcons (state.thislevelstart < 0
-		    ? Qnil : make_number (state.thislevelstart),
-	       Fcons (state.instring >= 0
-		      ? (state.instring == ST_STRING_STYLE
-			 ? Qt : make_number (state.instring)) : Qnil,
-		 Fcons (state.incomment < 0 ? Qt :
-			(state.incomment == 0 ? Qnil :
-			 make_number (state.incomment)),
-		   Fcons (state.quoted ? Qt : Qnil,
-		     Fcons (make_number (state.mindepth),
-		       Fcons ((state.comstyle
-			       ? (state.comstyle == ST_COMMENT_STYLE
-				  ? Qsyntax_table
-				  : make_number (state.comstyle))
-			       : Qnil),
-			      Fcons (((state.incomment
-				       || (state.instring >= 0))
-				      ? make_number (state.comstr_start)
-				      : Qnil),
-				     Fcons (state.levelstarts, Qnil))))))))));
+  return parse_state_list (&state);
 }
-
+
 void
 init_syntax_once (void)
 {
@@ -3569,12 +3987,24 @@ init_syntax_once (void)
 void
 syms_of_syntax (void)
 {
+  int i;
+
 #include "syntax.x"
 
   DEFSYM (Qsyntax_table_p, "syntax-table-p");
 
   staticpro (&Vsyntax_code_object);
 
+  parse_state_cache = Qnil;
+  staticpro (&parse_state_cache);
+
+  for (i = 0; i < SYNTAX_FLAT_ENTRIES; i++)
+    {
+      syntax_flat_cache[i].table = Qnil;
+      syntax_flat_cache[i].modiff = -1;
+      staticpro (&syntax_flat_cache[i].table);
+    }
+
   staticpro (&gl_state.object);
   staticpro (&gl_state.global_code);
   staticpro (&gl_state.current_syntax_table);
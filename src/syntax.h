@@ -102,13 +102,49 @@ SYNTAX_ENTRY (int c)
   return syntax_property_entry (c, false);
 }
 
+/* A flattened copy of the codes and flags of the first 0400
+   characters of syntax table TABLE, valid while MODIFF equals
+   char_table_modiff.  Scanning loops look up the same few tables
+   over and over, mostly for ASCII text, so this saves walking the
+   char-table and its parents for each character.  */
+struct syntax_flat
+{
+  Lisp_Object table;
+  EMACS_INT modiff;
+  int flags[0400];
+};
+
+enum { SYNTAX_FLAT_ENTRIES = 4 };
+
+/* Most recently used first.  */
+extern struct syntax_flat syntax_flat_cache[SYNTAX_FLAT_ENTRIES];
+extern struct syntax_flat *syntax_flat_lookup (Lisp_Object);
+
 /* Extract the information from the entry for character C
    in the current syntax table.  */
 
 INLINE int
 syntax_property_with_flags (int c, bool via_property)
 {
-  Lisp_Object ent = syntax_property_entry (c, via_property);
+  Lisp_Object table, ent;
+
+  if (via_property && gl_state.use_global)
+    ent = gl_state.global_code;
+  else
+    {
+      table = (via_property
+	       ? gl_state.current_syntax_table
+	       : BVAR (current_buffer, syntax_table));
+      if (0 <= c && c < 0400)
+	{
+	  struct syntax_flat *flat = syntax_flat_cache;
+	  if (! (EQ (flat->table, table)
+		 && flat->modiff == char_table_modiff))
+	    flat = syntax_flat_lookup (table);
+	  return flat->flags[c];
+	}
+      ent = CHAR_TABLE_REF (table, c);
+    }
   return CONSP (ent) ? XINT (XCAR (ent)) : Swhitespace;
 }
 INLINE int
@@ -1038,10 +1038,20 @@ init_sys_modes (struct tty_display_info *tty_out)
 #endif /* F_GETOWN */
 
 #ifdef _IOFBF
-  /* This symbol is defined on recent USG systems.
-     Someone says without this call USG won't really buffer the file
-     even with a call to setbuf. */
-  setvbuf (tty_out->output, (char *) _sobuf, _IOFBF, sizeof _sobuf);
+  /* A large buffer lets a whole frame update go out in one write,
+     which matters over slow links.  Let stdio allocate it, since
+     _sobuf is shared by all ttys.  */
+  tty_out->output_buffer_size = 0;
+  if (tty_output_buffer_size > BUFSIZ
+      && tty_output_buffer_size <= min (PTRDIFF_MAX, SIZE_MAX)
+      && setvbuf (tty_out->output, NULL, _IOFBF,
+		  tty_output_buffer_size) == 0)
+    tty_out->output_buffer_size = tty_output_buffer_size;
+  else
+    /* This symbol is defined on recent USG systems.
+       Someone says without this call USG won't really buffer the file
+       even with a call to setbuf. */
+    setvbuf (tty_out->output, (char *) _sobuf, _IOFBF, sizeof _sobuf);
 #else
   setbuf (tty_out->output, (char *) _sobuf);
 #endif
@@ -730,6 +730,26 @@ encode_terminal_code (struct glyph *src, int src_len,
 
 
 
+/* Return true if faces FACE_ID1 and FACE_ID2 on tty frame F would
+   produce the same terminal output, so that a run of glyphs spanning
+   both needs no attribute changes in between.  */
+
+static bool
+tty_same_appearance_p (struct frame *f, int face_id1, int face_id2)
+{
+  struct face *face1 = FACE_FROM_ID (f, face_id1);
+  struct face *face2 = FACE_FROM_ID (f, face_id2);
+
+  return (face1 == face2
+	  || (face1 && face2
+	      && face1->foreground == face2->foreground
+	      && face1->background == face2->background
+	      && face1->tty_bold_p == face2->tty_bold_p
+	      && face1->tty_italic_p == face2->tty_italic_p
+	      && face1->tty_underline_p == face2->tty_underline_p
+	      && face1->tty_reverse_p == face2->tty_reverse_p));
+}
+
 /* An implementation of write_glyphs for termcap frames. */
 
 static void
@@ -767,11 +787,13 @@ tty_write_glyphs (struct frame *f, struct glyph *string, int len)
 
   for (stringlen = len; stringlen != 0; stringlen -= n)
     {
-      /* Identify a run of glyphs with the same face.  */
+      /* Identify a run of glyphs that look the same on the terminal,
+	 so that we don't emit redundant attribute sequences.  */
       int face_id = string->face_id;
 
       for (n = 1; n < stringlen; ++n)
-	if (string[n].face_id != face_id)
+	if (string[n].face_id != face_id
+	    && !tty_same_appearance_p (f, face_id, string[n].face_id))
 	  break;
 
       /* Turn appearance modes of the face of the run on.  */
@@ -4213,6 +4235,26 @@ use the Bourne shell command `TERM=... export TERM' (C-shell:\n\
       tty->TN_max_colors = tgetnum ("Co");
       tty->TN_max_pairs = tgetnum ("pa");
 
+#ifdef TERMINFO
+      /* Terminals that advertise direct color through COLORTERM
+	 accept ISO 8613-6 SGR sequences.  The color index is then
+	 the 24-bit RGB value itself, except that indices below 8
+	 still select the standard ANSI colors.  */
+      {
+	const char *colorterm = getenv ("COLORTERM");
+	if (tty->TN_max_colors >= 8 && colorterm
+	    && (strcmp (colorterm, "truecolor") == 0
+		|| strcmp (colorterm, "24bit") == 0))
+	  {
+	    tty->TS_set_foreground = "\033[%?%p1%{8}%<%t3%p1%d%e38;2;"
+	      "%p1%{65536}%/%d;%p1%{256}%/%{255}%&%d;%p1%{255}%&%d%;m";
+	    tty->TS_set_background = "\033[%?%p1%{8}%<%t4%p1%d%e48;2;"
+	      "%p1%{65536}%/%d;%p1%{256}%/%{255}%&%d;%p1%{255}%&%d%;m";
+	    tty->TN_max_colors = 16777216;
+	  }
+      }
+#endif
+
       tty->TN_no_color_video = tgetnum ("NC");
       if (tty->TN_no_color_video == -1)
         tty->TN_no_color_video = 0;
@@ -4565,6 +4607,15 @@ The functions are run with one argument, the terminal object that was revived.
 See `resume-tty'.  */);
   Vresume_tty_functions = Qnil;
 
+  DEFVAR_INT ("tty-output-buffer-size", tty_output_buffer_size,
+    doc: /* Size in bytes of the output buffer for text terminals.
+If this is larger than the system's default stdio buffer, each frame
+update on a text terminal is collected in a buffer of this size and
+sent with a single write, which helps over high-latency connections.
+Zero means use the default buffer and flush it every few lines.
+The value takes effect when a terminal is opened or resumed.  */);
+  tty_output_buffer_size = 0;
+
   DEFVAR_BOOL ("visible-cursor", visible_cursor,
 	       doc: /* Non-nil means to make the cursor very visible.
 This only has an effect when running in a text terminal.
@@ -52,6 +52,10 @@ struct tty_display_info
   FILE *termscript;             /* If nonzero, send all terminal output
                                    characters to this stream also.  */
 
+  ptrdiff_t output_buffer_size; /* Size of the stdio buffer of OUTPUT if
+                                   it was allocated according to
+                                   tty-output-buffer-size, else 0.  */
+
   struct emacs_tty *old_tty;    /* The initial tty mode bits */
 
   bool_bf term_initted : 1;	/* True if we have been through
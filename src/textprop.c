@@ -650,8 +650,7 @@ get_char_property_and_overlay (Lisp_Object position, register Lisp_Object prop,
     }
   if (BUFFERP (object))
     {
-      ptrdiff_t noverlays;
-      Lisp_Object *overlay_vec;
+      Lisp_Object tem, ov;
       struct buffer *obuf = current_buffer;
 
       if (XINT (position) < BUF_BEGV (XBUFFER (object))
@@ -660,22 +659,17 @@ get_char_property_and_overlay (Lisp_Object position, register Lisp_Object prop,
 
       set_buffer_temp (XBUFFER (object));
 
-      GET_OVERLAYS_AT (XINT (position), overlay_vec, noverlays, NULL, 0);
-      noverlays = sort_overlays (overlay_vec, noverlays, w);
+      /* Find the overlay with the highest priority that has PROP.  */
+      tem = overlay_property_at (XINT (position), prop, w, &ov);
 
       set_buffer_temp (obuf);
 
-      /* Now check the overlays in order of decreasing priority.  */
-      while (--noverlays >= 0)
+      if (!NILP (ov))
 	{
-	  Lisp_Object tem = Foverlay_get (overlay_vec[noverlays], prop);
-	  if (!NILP (tem))
-	    {
-	      if (overlay)
-		/* Return the overlay we got the property from.  */
-		*overlay = overlay_vec[noverlays];
-	      return tem;
-	    }
+	  if (overlay)
+	    /* Return the overlay we got the property from.  */
+	    *overlay = ov;
+	  return tem;
 	}
     }
 
@@ -1304,6 +1298,160 @@ Return t if any property value actually changed, nil otherwise.  */)
 				TEXT_PROPERTY_REPLACE);
 }
 
+/* Add PROPERTIES to the text from S to E, which starts within
+   interval I.  Set *MODIFIED if any property value changed.  Return
+   the interval containing E - 1, from which the caller can continue
+   with text further right.  */
+
+static INTERVAL
+add_properties_in_range (INTERVAL i, ptrdiff_t s, ptrdiff_t e,
+			 Lisp_Object properties, Lisp_Object object,
+			 bool *modified)
+{
+  INTERVAL unchanged;
+
+  for (;;)
+    {
+      ptrdiff_t i_end = i->position + LENGTH (i);
+
+      if (! interval_has_all_properties (properties, i))
+	{
+	  if (i->position < s)
+	    {
+	      unchanged = i;
+	      i = split_interval_right (unchanged, s - unchanged->position);
+	      copy_properties (unchanged, i);
+	    }
+	  if (i_end > e)
+	    {
+	      unchanged = i;
+	      i = split_interval_left (unchanged, e - unchanged->position);
+	      copy_properties (unchanged, i);
+	    }
+	  *modified |= add_properties (properties, i, object,
+				       TEXT_PROPERTY_REPLACE);
+	}
+      if (i_end >= e)
+	return i;
+      i = next_interval (i);
+    }
+}
+
+/* Return true if every interval from I up to position E already has
+   all of PROPERTIES.  */
+
+static bool
+range_has_all_properties (INTERVAL i, ptrdiff_t e, Lisp_Object properties)
+{
+  for (; i && i->position < e; i = next_interval (i))
+    if (! interval_has_all_properties (properties, i))
+      return false;
+  return true;
+}
+
+/* Callers note, this can GC when OBJECT is a buffer (or nil).  */
+
+DEFUN ("add-text-properties-ranges", Fadd_text_properties_ranges,
+       Sadd_text_properties_ranges, 1, 2, 0,
+       doc: /* Add properties to several ranges of text at once.
+RANGES is a vector of lists (START END PROPERTIES), sorted by START,
+whose ranges do not overlap.  Each PROPERTIES is added to the text
+from START to END as if by `add-text-properties'.  OBJECT, if non-nil,
+is the buffer or string holding the text, as in `add-text-properties'.
+
+This is faster than calling `add-text-properties' for each element,
+because the text properties are visited in a single left-to-right
+pass, and the modification hooks run only once, for the text from
+the first range that needs a change to the end of the last range.
+
+Return t if any property value actually changed, nil otherwise.  */)
+  (Lisp_Object ranges, Lisp_Object object)
+{
+  ptrdiff_t n, k, *bounds;
+  ptrdiff_t changed_start = 0, last_end;
+  Lisp_Object plists, range, beg, end;
+  INTERVAL i = NULL;
+  bool notified = false, modified = false;
+  struct gcpro gcpro1, gcpro2;
+  USE_SAFE_ALLOCA;
+
+  CHECK_VECTOR (ranges);
+  if (NILP (object))
+    XSETBUFFER (object, current_buffer);
+  n = ASIZE (ranges);
+  if (n == 0)
+    return Qnil;
+
+  /* Check every range before touching the text, so that an error
+     leaves it unchanged.  */
+  plists = Fmake_vector (make_number (n), Qnil);
+  SAFE_NALLOCA (bounds, 2, n);
+  last_end = PTRDIFF_MIN;
+  for (k = 0; k < n; k++)
+    {
+      range = AREF (ranges, k);
+      beg = Fcar (range);
+      end = Fcar (Fcdr (range));
+      validate_interval_range (object, &beg, &end, soft);
+      if (XINT (beg) < last_end)
+	error ("Ranges are not sorted or overlap");
+      bounds[2 * k] = XINT (beg);
+      bounds[2 * k + 1] = last_end = XINT (end);
+      ASET (plists, k, validate_plist (Fcar (Fcdr (Fcdr (range)))));
+    }
+
+  GCPRO2 (object, plists);
+
+  for (k = 0; k < n; k++)
+    {
+      ptrdiff_t s = bounds[2 * k], e = bounds[2 * k + 1];
+      Lisp_Object properties = AREF (plists, k);
+
+      if (s == e || NILP (properties))
+	continue;
+
+      if (!i)
+	{
+	  beg = make_number (s);
+	  end = make_number (e);
+	  i = validate_interval_range (object, &beg, &end, hard);
+	  if (!i)
+	    continue;
+	}
+      else
+	while (i->position + LENGTH (i) <= s)
+	  i = next_interval (i);
+
+      if (BUFFERP (object) && !notified)
+	{
+	  if (range_has_all_properties (i, e, properties))
+	    continue;
+	  modify_text_properties (object, make_number (s),
+				  make_number (last_end));
+	  notified = true;
+	  changed_start = s;
+	  /* The hooks may have rearranged the intervals; find our
+	     place again.  */
+	  beg = make_number (s);
+	  end = make_number (e);
+	  i = validate_interval_range (object, &beg, &end, hard);
+	  if (!i)
+	    continue;
+	}
+
+      i = add_properties_in_range (i, s, e, properties, object, &modified);
+    }
+
+  UNGCPRO;
+  SAFE_FREE ();
+
+  if (notified)
+    signal_after_change (changed_start, last_end - changed_start,
+			 last_end - changed_start);
+
+  return modified ? Qt : Qnil;
+}
+
 /* Callers note, this can GC when OBJECT is a buffer (or nil).  */
 
 DEFUN ("put-text-property", Fput_text_property,
@@ -1757,6 +1905,48 @@ Return t if any property was actually removed, nil otherwise.  */)
     }
 }
 
+DEFUN ("compact-text-properties", Fcompact_text_properties,
+       Scompact_text_properties, 0, 1, 0,
+       doc: /* Merge adjacent runs of text with identical properties.
+OBJECT is the buffer or string to compact, and defaults to the current
+buffer.  No property value changes; this only reduces the memory used
+to record the properties and speeds up later lookups.
+Return the number of runs merged away.  */)
+  (Lisp_Object object)
+{
+  if (NILP (object))
+    XSETBUFFER (object, current_buffer);
+  CHECK_STRING_OR_BUFFER (object);
+  if (BUFFERP (object))
+    {
+      if (!BUFFER_LIVE_P (XBUFFER (object)))
+	return make_number (0);
+      if (XBUFFER (object)->base_buffer)
+	XSETBUFFER (object, XBUFFER (object)->base_buffer);
+    }
+  return make_number (compact_intervals (object));
+}
+
+/* Compact the text properties of every live buffer once
+   `text-property-compaction-threshold' intervals have been split since
+   the last time.  Called when Emacs becomes idle, when nothing holds
+   on to intervals.  */
+
+void
+maybe_compact_intervals (void)
+{
+  Lisp_Object tail, buffer;
+
+  if (text_property_compaction_threshold <= 0
+      || interval_splits < text_property_compaction_threshold)
+    return;
+
+  FOR_EACH_LIVE_BUFFER (tail, buffer)
+    if (!XBUFFER (buffer)->base_buffer)
+      compact_intervals (buffer);
+  interval_splits = 0;
+}
+
 DEFUN ("text-property-any", Ftext_property_any,
        Stext_property_any, 4, 5, 0,
        doc: /* Check text from START to END for property PROPERTY equaling VALUE.
@@ -1829,6 +2019,54 @@ markers).  If OBJECT is a string, START and END are 0-based indices into it.  */
   return Qnil;
 }
 
+DEFUN ("text-property-runs", Ftext_property_runs,
+       Stext_property_runs, 3, 4, 0,
+       doc: /* Return the runs of property PROPERTY in the text from START to END.
+The value is a vector of elements (RUN-START RUN-END VALUE), in order,
+one for each maximal stretch of text in which PROPERTY is `eq' to VALUE.
+The runs cover the text from START to END exactly.
+This is like calling `get-text-property' and `next-single-property-change'
+for each run, but walks the text properties only once.
+If the optional fourth argument OBJECT is a buffer (or nil, which means
+the current buffer), START and END are buffer positions (integers or
+markers).  If OBJECT is a string, START and END are 0-based indices into it.  */)
+  (Lisp_Object start, Lisp_Object end, Lisp_Object property, Lisp_Object object)
+{
+  register INTERVAL i;
+  ptrdiff_t s, e, run_start;
+  Lisp_Object runs = Qnil, value;
+
+  if (NILP (object))
+    XSETBUFFER (object, current_buffer);
+  i = validate_interval_range (object, &start, &end, soft);
+  s = XINT (start);
+  e = XINT (end);
+  if (!i)
+    return (s < e
+	    ? make_vector (1, list3 (start, end, Qnil))
+	    : make_vector (0, Qnil));
+
+  run_start = s;
+  value = textget (i->plist, property);
+  for (i = next_interval (i); i && i->position < e; i = next_interval (i))
+    {
+      Lisp_Object here = textget (i->plist, property);
+      if (! EQ (here, value))
+	{
+	  runs = Fcons (list3 (make_number (run_start),
+			       make_number (i->position), value),
+			runs);
+	  run_start = i->position;
+	  value = here;
+	}
+    }
+  if (run_start < e)
+    runs = Fcons (list3 (make_number (run_start), end, value), runs);
+
+  runs = Fnreverse (runs);
+  return Fvconcat (1, &runs);
+}
+
 
 /* Return the direction from which the text-property PROP would be
    inherited by any new text inserted at POS: 1 if it would be
@@ -2369,6 +2607,16 @@ inherits it if NONSTICKINESS is nil.  The `front-sticky' and
     = list2 (Fcons (intern_c_string ("syntax-table"), Qt),
 	     Fcons (intern_c_string ("display"), Qt));
 
+  DEFVAR_INT ("text-property-compaction-threshold",
+	      text_property_compaction_threshold,
+	      doc: /* Number of interval splits that triggers compaction.
+Each change to the text properties of part of a run of text splits
+the run in two, and the pieces are not always merged again once their
+properties become equal.  When Emacs becomes idle after this many
+splits, it merges such neighbors in all buffers, as by
+`compact-text-properties'.  Zero or negative means never do it.  */);
+  text_property_compaction_threshold = 20000;
+
   staticpro (&interval_insert_behind_hooks);
   staticpro (&interval_insert_in_front_hooks);
   interval_insert_behind_hooks = Qnil;
@@ -47,6 +47,53 @@ Lisp_Object Qapply;
    an undo-boundary.  */
 static Lisp_Object pending_boundary;
 
+static const size_t sizeof_cons = sizeof (scm_t_cell);
+
+/* Return the memory that truncate_undo_list counts for the undo
+   entry ELT and its link in the list.  */
+
+static EMACS_INT
+undo_entry_size (Lisp_Object elt)
+{
+  EMACS_INT size = sizeof_cons;
+
+  if (CONSP (elt))
+    {
+      size += sizeof_cons;
+      if (STRINGP (XCAR (elt)))
+	size += sizeof (struct Lisp_String) - 1 + SCHARS (XCAR (elt));
+    }
+  return size;
+}
+
+/* Record that the undo list of B changed from OLD to NEW by adding
+   entries of SIZE in total.  */
+
+static void
+undo_size_add (struct buffer *b, Lisp_Object old, Lisp_Object new,
+	       EMACS_INT size)
+{
+  if (NILP (old))
+    b->undo_size = size;
+  else if (b->undo_size >= 0 && EQ (b->undo_size_list, old))
+    b->undo_size += size;
+  else
+    b->undo_size = -1;
+  b->undo_size_list = new;
+}
+
+/* Push ELT onto the undo list of the current buffer.  */
+
+static void
+undo_push (Lisp_Object elt)
+{
+  Lisp_Object old = BVAR (current_buffer, undo_list);
+  Lisp_Object new = Fcons (elt, old);
+
+  bset_undo_list (current_buffer, new);
+  undo_size_add (current_buffer, old, new, undo_entry_size (elt));
+}
+
 /* Record point as it was at beginning of this command (if necessary)
    and prepare the undo info for recording a change.
    PT is the position of point that will naturally occur as a result of the
@@ -86,9 +133,7 @@ record_point (ptrdiff_t pt)
   if (at_boundary
       && current_buffer == last_boundary_buffer
       && last_boundary_position != pt)
-    bset_undo_list (current_buffer,
-		    Fcons (make_number (last_boundary_position),
-			   BVAR (current_buffer, undo_list)));
+    undo_push (make_number (last_boundary_position));
 }
 
 /* Record an insertion that just happened or is about to happen,
@@ -124,65 +169,19 @@ record_insert (ptrdiff_t beg, ptrdiff_t length)
 
   XSETFASTINT (lbeg, beg);
   XSETINT (lend, beg + length);
-  bset_undo_list (current_buffer,
-		  Fcons (Fcons (lbeg, lend), BVAR (current_buffer, undo_list)));
-}
-
-/* Record the fact that markers in the region of FROM, TO are about to
-   be adjusted.  This is done only when a marker points within text
-   being deleted, because that's the only case where an automatic
-   marker adjustment won't be inverted automatically by undoing the
-   buffer modification.  */
-
-static void
-record_marker_adjustments (ptrdiff_t from, ptrdiff_t to)
-{
-  Lisp_Object marker;
-  register struct Lisp_Marker *m;
-  register ptrdiff_t charpos, adjustment;
-
-  /* Allocate a cons cell to be the undo boundary after this command.  */
-  if (NILP (pending_boundary))
-    pending_boundary = Fcons (Qnil, Qnil);
-
-  if (current_buffer != last_undo_buffer)
-    Fundo_boundary ();
-  last_undo_buffer = current_buffer;
-
-  for (m = BUF_MARKERS (current_buffer); m; m = m->next)
-    {
-      charpos = m->charpos;
-      eassert (charpos <= Z);
-
-      if (from <= charpos && charpos <= to)
-        {
-          /* insertion_type nil markers will end up at the beginning of
-             the re-inserted text after undoing a deletion, and must be
-             adjusted to move them to the correct place.
-
-             insertion_type t markers will automatically move forward
-             upon re-inserting the deleted text, so we have to arrange
-             for them to move backward to the correct position.  */
-          adjustment = (m->insertion_type ? to : from) - charpos;
-
-          if (adjustment)
-            {
-              XSETMISC (marker, m);
-              bset_undo_list
-                (current_buffer,
-                 Fcons (Fcons (marker, make_number (adjustment)),
-                        BVAR (current_buffer, undo_list)));
-            }
-        }
-    }
+  undo_push (Fcons (lbeg, lend));
 }
 
 /* Record that a deletion is about to take place, of the characters in
-   STRING, at location BEG.  Optionally record adjustments for markers
-   in the region STRING occupies in the current buffer.  */
+   STRING, at location BEG.  MARKER_ADJUSTMENTS is a list of undo
+   entries (MARKER . ADJUSTMENT) for the markers in the region STRING
+   occupies in the current buffer, most recent first, as collected by
+   adjust_markers_for_delete; they are recorded just below the
+   deletion itself.  */
 
 void
-record_delete (ptrdiff_t beg, Lisp_Object string, bool record_markers)
+record_delete (ptrdiff_t beg, Lisp_Object string,
+	       Lisp_Object marker_adjustments)
 {
   Lisp_Object sbeg;
 
@@ -203,12 +202,18 @@ record_delete (ptrdiff_t beg, Lisp_Object string, bool record_markers)
   /* primitive-undo assumes marker adjustments are recorded
      immediately before the deletion is recorded.  See bug 16818
      discussion.  */
-  if (record_markers)
-    record_marker_adjustments (beg, beg + SCHARS (string));
+  if (CONSP (marker_adjustments))
+    {
+      Lisp_Object old = BVAR (current_buffer, undo_list), tail;
+      EMACS_INT size = 0;
 
-  bset_undo_list
-    (current_buffer,
-     Fcons (Fcons (string, sbeg), BVAR (current_buffer, undo_list)));
+      for (tail = marker_adjustments; CONSP (tail); tail = XCDR (tail))
+	size += undo_entry_size (XCAR (tail));
+      bset_undo_list (current_buffer, nconc2 (marker_adjustments, old));
+      undo_size_add (current_buffer, old, marker_adjustments, size);
+    }
+
+  undo_push (Fcons (string, sbeg));
 }
 
 /* Record that a replacement is about to take place,
@@ -218,7 +223,7 @@ record_delete (ptrdiff_t beg, Lisp_Object string, bool record_markers)
 void
 record_change (ptrdiff_t beg, ptrdiff_t length)
 {
-  record_delete (beg, make_buffer_string (beg, beg + length, 1), false);
+  record_delete (beg, make_buffer_string (beg, beg + length, 1), Qnil);
   record_insert (beg, length);
 }
 
@@ -241,9 +246,7 @@ record_first_change (void)
   if (base_buffer->base_buffer)
     base_buffer = base_buffer->base_buffer;
 
-  bset_undo_list (current_buffer,
-		  Fcons (Fcons (Qt, Fvisited_file_modtime ()),
-			 BVAR (current_buffer, undo_list)));
+  undo_push (Fcons (Qt, Fvisited_file_modtime ()));
 }
 
 /* Record a change in property PROP (whose old value was VAL)
@@ -281,8 +284,7 @@ record_property_change (ptrdiff_t beg, ptrdiff_t length,
   XSETINT (lbeg, beg);
   XSETINT (lend, beg + length);
   entry = Fcons (Qnil, Fcons (prop, Fcons (value, Fcons (lbeg, lend))));
-  bset_undo_list (current_buffer,
-		  Fcons (entry, BVAR (current_buffer, undo_list)));
+  undo_push (entry);
 
   current_buffer = obuf;
 }
@@ -304,19 +306,54 @@ but another undo command will undo to the previous boundary.  */)
 	{
 	  /* If we have preallocated the cons cell to use here,
 	     use that one.  */
-	  XSETCDR (pending_boundary, BVAR (current_buffer, undo_list));
+	  Lisp_Object old = BVAR (current_buffer, undo_list);
+
+	  XSETCDR (pending_boundary, old);
 	  bset_undo_list (current_buffer, pending_boundary);
+	  undo_size_add (current_buffer, old, pending_boundary,
+			 sizeof_cons);
 	  pending_boundary = Qnil;
 	}
       else
-	bset_undo_list (current_buffer,
-			Fcons (Qnil, BVAR (current_buffer, undo_list)));
+	undo_push (Qnil);
     }
   last_boundary_position = PT;
   last_boundary_buffer = current_buffer;
   return Qnil;
 }
 
+DEFUN ("buffer-undo-size", Fbuffer_undo_size, Sbuffer_undo_size, 0, 1, 0,
+       doc: /* Return the approximate memory used by the undo list of BUFFER.
+BUFFER defaults to the current buffer.  The value is in bytes, counted
+the same way as for `undo-limit', and is 0 if undo is disabled.  */)
+  (Lisp_Object buffer)
+{
+  struct buffer *b;
+  Lisp_Object list, tail;
+  EMACS_INT size = 0;
+
+  if (NILP (buffer))
+    b = current_buffer;
+  else
+    {
+      CHECK_BUFFER (buffer);
+      b = XBUFFER (buffer);
+    }
+  list = BVAR (b, undo_list);
+
+  if (b->undo_size >= 0 && EQ (b->undo_size_list, list))
+    return make_number (b->undo_size);
+
+  for (tail = list; CONSP (tail); tail = XCDR (tail))
+    size += undo_entry_size (XCAR (tail));
+  if (CONSP (list))
+    {
+      b->undo_size = size;
+      b->undo_size_list = list;
+    }
+  return make_number (size);
+}
+
 /* At garbage collection time, make an undo list shorter at the end,
    returning the truncated list.  How this is done depends on the
    variables undo-limit, undo-strong-limit and undo-outer-limit.
@@ -327,9 +364,8 @@ truncate_undo_list (struct buffer *b)
 {
   Lisp_Object list;
   Lisp_Object prev, next, last_boundary;
-  EMACS_INT size_so_far = 0;
+  EMACS_INT size_so_far = 0, kept_size = 0;
   dynwind_begin ();
-  static const size_t sizeof_cons = sizeof (scm_t_cell);
 
   /* Make the buffer current to get its local values of variables such
      as undo_limit.  Also so that Vundo_outer_limit_function can
@@ -339,6 +375,17 @@ truncate_undo_list (struct buffer *b)
 
   list = BVAR (b, undo_list);
 
+  /* If the running size shows that the whole list is within the
+     limits, there is nothing to truncate and no need to walk it.  */
+  if (b->undo_size >= 0 && EQ (b->undo_size_list, list)
+      && b->undo_size <= undo_limit
+      && (!INTEGERP (Vundo_outer_limit)
+	  || b->undo_size <= XINT (Vundo_outer_limit)))
+    {
+      dynwind_end ();
+      return;
+    }
+
   prev = Qnil;
   next = list;
   last_boundary = Qnil;
@@ -366,14 +413,7 @@ truncate_undo_list (struct buffer *b)
       elt = XCAR (next);
 
       /* Add in the space occupied by this element and its chain link.  */
-      size_so_far += sizeof_cons;
-      if (CONSP (elt))
-	{
-	  size_so_far += sizeof_cons;
-	  if (STRINGP (XCAR (elt)))
-	    size_so_far += (sizeof (struct Lisp_String) - 1
-			    + SCHARS (XCAR (elt)));
-	}
+      size_so_far += undo_entry_size (elt);
 
       /* Advance to next element.  */
       prev = next;
@@ -405,7 +445,10 @@ truncate_undo_list (struct buffer *b)
     }
 
   if (CONSP (next))
-    last_boundary = prev;
+    {
+      last_boundary = prev;
+      kept_size = size_so_far;
+    }
 
   /* Keep additional undo data, if it fits in the limits.  */
   while (CONSP (next))
@@ -422,19 +465,13 @@ truncate_undo_list (struct buffer *b)
 	  if (size_so_far > undo_strong_limit)
 	    break;
 	  last_boundary = prev;
+	  kept_size = size_so_far;
 	  if (size_so_far > undo_limit)
 	    break;
 	}
 
       /* Add in the space occupied by this element and its chain link.  */
-      size_so_far += sizeof_cons;
-      if (CONSP (elt))
-	{
-	  size_so_far += sizeof_cons;
-	  if (STRINGP (XCAR (elt)))
-	    size_so_far += (sizeof (struct Lisp_String) - 1
-			    + SCHARS (XCAR (elt)));
-	}
+      size_so_far += undo_entry_size (elt);
 
       /* Advance to next element.  */
       prev = next;
@@ -443,13 +480,19 @@ truncate_undo_list (struct buffer *b)
 
   /* If we scanned the whole list, it is short enough; don't change it.  */
   if (NILP (next))
-    ;
+    kept_size = size_so_far;
   /* Truncate at the boundary where we decided to truncate.  */
   else if (!NILP (last_boundary))
     XSETCDR (last_boundary, Qnil);
   /* There's nothing we decided to keep, so clear it out.  */
   else
-    bset_undo_list (b, Qnil);
+    {
+      bset_undo_list (b, Qnil);
+      list = Qnil;
+      kept_size = 0;
+    }
+  b->undo_size = kept_size;
+  b->undo_size_list = list;
 
   dynwind_end ();
 }
@@ -2774,6 +2774,14 @@ window_loop (enum window_loop type, Lisp_Object obj, int mini, Lisp_Object frame
   else
     window = FRAME_SELECTED_WINDOW (SELECTED_FRAME ());
 
+  /* Every window showing a buffer is counted in its base buffer, so
+     a buffer without windows needs no walk over the window list.  */
+  if ((type == GET_BUFFER_WINDOW
+       || type == REPLACE_BUFFER_IN_WINDOWS_SAFELY
+       || type == REDISPLAY_BUFFER_WINDOWS)
+      && BUFFERP (obj) && buffer_window_count (XBUFFER (obj)) == 0)
+    return Qnil;
+
   windows = window_list_1 (window, mini ? Qt : Qnil, frame_arg);
   GCPRO1 (windows);
   best_window = Qnil;
@@ -3498,6 +3506,13 @@ This function runs `window-scroll-functions' before running
   if (!BUFFER_LIVE_P (XBUFFER (buffer)))
     error ("Attempt to display deleted buffer");
 
+  /* A placeholder buffer is filled in before it is first shown.  */
+  materialize_buffer (buffer);
+  if (!BUFFER_LIVE_P (XBUFFER (buffer)))
+    error ("Attempt to display deleted buffer");
+  if (!WINDOW_LIVE_P (window))
+    error ("Window is deleted");
+
   tem = w->contents;
   if (NILP (tem))
     error ("Window is deleted");
@@ -4014,7 +4029,7 @@ window_resize_apply_total (struct window *w, bool horflag)
     }
 }
 
-DEFUN ("window-resize-apply", Fwindow_resize_apply, Swindow_resize_apply, 0, 2, 0,
+DEFUN ("window-resize-apply", Fwindow_resize_apply, Swindow_resize_apply, 0, 3, 0,
        doc: /* Apply requested size values for window-tree of FRAME.
 If FRAME is omitted or nil, it defaults to the selected frame.
 
@@ -4027,8 +4042,12 @@ and calculates and assigns the new start positions of these windows.
 
 Note: This function does not check any of `window-fixed-size-p',
 `window-min-height' or `window-min-width'.  All these checks have to
-be applied on the Elisp level.  */)
-     (Lisp_Object frame, Lisp_Object horizontal)
+be applied on the Elisp level.
+
+Optional argument DEFER non-nil means do not reallocate the glyph
+matrices of FRAME now but leave that to the next redisplay.  This saves
+work when several resizes are applied in a row.  */)
+     (Lisp_Object frame, Lisp_Object horizontal, Lisp_Object defer)
 {
   struct frame *f = decode_live_frame (frame);
   struct window *r = XWINDOW (FRAME_ROOT_WINDOW (f));
@@ -4045,7 +4064,13 @@ be applied on the Elisp level.  */)
   fset_redisplay (f);
   FRAME_WINDOW_SIZES_CHANGED (f) = 1;
 
-  adjust_frame_glyphs (f);
+  /* Redisplay reallocates the matrices of a frame with fonts_changed
+     set before it displays anything, and display routines give up
+     early on such a frame meanwhile.  */
+  if (NILP (defer))
+    adjust_frame_glyphs (f);
+  else
+    f->fonts_changed = 1;
   unblock_input ();
 
   return Qt;
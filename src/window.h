@@ -166,6 +166,9 @@ struct window
     struct glyph_matrix *current_matrix;
     struct glyph_matrix *desired_matrix;
 
+    /* Glyph rows recently produced for this window; see xdisp.c.  */
+    struct glyph_row_cache *glyph_row_cache;
+
     /* The two Lisp_Object fields below are marked in a special way,
        which is why they're placed after `current_matrix'.  */
     /* Alist of <buffer, window-start, window-point> triples listing
@@ -230,6 +233,13 @@ struct window
        line, or -1 if column numbers are not being displayed.  */
     ptrdiff_t column_number_displayed;
 
+    /* Buffer modification count, window start, and bounds of the line
+       containing point, as of the last time the mode line displayed a
+       line number.  While they stay the same, so does the number.  */
+    EMACS_INT mode_line_modified;
+    ptrdiff_t mode_line_start;
+    ptrdiff_t mode_line_line_beg, mode_line_line_end;
+
     /* Scaling factor for the glyph_matrix size calculation in this window.
        Used if window contains many small images or uses proportional fonts,
        as the normal  may yield a matrix which is too small.  */
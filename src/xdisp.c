@@ -853,6 +853,7 @@ static int single_display_spec_string_p (Lisp_Object, Lisp_Object);
 static int display_prop_string_p (Lisp_Object, Lisp_Object);
 static int row_for_charpos_p (struct glyph_row *, ptrdiff_t);
 static int cursor_row_p (struct glyph_row *);
+static void save_it_checkpoint (struct it *);
 static int redisplay_mode_lines (Lisp_Object, bool);
 static char *decode_mode_spec_coding (Lisp_Object, char *, int);
 
@@ -2568,7 +2569,7 @@ remember_mouse_glyph (struct frame *f, int gx, int gy, NativeRectangle *rect)
   /* Visible feedback for debugging.  */
 #if 0
 #if HAVE_X_WINDOWS
-  XDrawRectangle (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
+  XDrawRectangle (FRAME_X_DISPLAY (f), FRAME_X_DRAWABLE (f),
 		  f->output_data.x->normal_gc,
 		  gx, gy, width, height);
 #endif
@@ -3044,14 +3045,20 @@ init_iterator (struct it *it, struct window *w,
       /* Do we need to reorder bidirectional text?  Not if this is a
 	 unibyte buffer: by definition, none of the single-byte
 	 characters are strong R2L, so no reordering is needed.  And
-	 bidi.c doesn't support unibyte buffers anyway.  Also, don't
+	 bidi.c doesn't support unibyte buffers anyway.  Nor if the
+	 buffer has no right-to-left text and its paragraphs are not
+	 forced to be right-to-left: every paragraph is then
+	 left-to-right and displayed in logical order.  Also, don't
 	 reorder while we are loading loadup.el, since the tables of
 	 character properties needed for reordering are not yet
 	 available.  */
       it->bidi_p =
 	NILP (Vpurify_flag)
 	&& !NILP (BVAR (current_buffer, bidi_display_reordering))
-	&& it->multibyte_p;
+	&& it->multibyte_p
+	&& (current_buffer->text->rtl
+	    || EQ (BVAR (current_buffer, bidi_paragraph_direction),
+		   Qright_to_left));
 
       /* If we are to reorder bidirectional text, init the bidi
 	 iterator.  */
@@ -6116,15 +6123,61 @@ pop_it (struct it *it)
 			  Moving over lines
  ***********************************************************************/
 
+/* Value is true if the line of the current buffer containing POS is
+   longer than THRESHOLD characters.  */
+
+static bool
+long_line_p (ptrdiff_t pos, ptrdiff_t threshold)
+{
+  ptrdiff_t shortage, bol, eol;
+
+  bol = find_newline (pos, CHAR_TO_BYTE (pos), max (BEGV, pos - threshold),
+		      -1, -1, &shortage, NULL, false);
+  if (shortage && bol > BEGV)
+    return true;
+  eol = find_newline (pos, CHAR_TO_BYTE (pos), min (ZV, bol + threshold),
+		      -1, 1, &shortage, NULL, false);
+  return shortage && eol < ZV;
+}
+
+/* In a buffer with long lines, redisplay treats the text as divided
+   into chunks, and looks for the start or end of a line no further
+   than the start or end of the chunk it is in.  Each chunk start then
+   counts as a line start, so that moving over a line costs at most
+   the size of a chunk, not the size of the line.  Value is the size of
+   a chunk for window W, large enough for several windowfuls of text,
+   or zero if the current buffer has no long lines.  */
+
+static ptrdiff_t
+long_line_chunk (struct window *w)
+{
+  if (!current_buffer->long_line_optimizations_p)
+    return 0;
+  return 3 * max (1, w->total_cols) * max (1, w->total_lines);
+}
+
+/* Return the start of the chunk of size CHUNK that contains POS.  */
+
+static ptrdiff_t
+long_line_chunk_start (ptrdiff_t pos, ptrdiff_t chunk)
+{
+  return max (BEGV, pos - (pos - BEG) % chunk);
+}
+
 /* Set IT's current position to the previous line start.  */
 
 static void
 back_to_previous_line_start (struct it *it)
 {
   ptrdiff_t cp = IT_CHARPOS (*it), bp = IT_BYTEPOS (*it);
+  ptrdiff_t chunk = long_line_chunk (it->w);
 
   DEC_BOTH (cp, bp);
-  IT_CHARPOS (*it) = find_newline_no_quit (cp, bp, -1, &IT_BYTEPOS (*it));
+  if (chunk)
+    IT_CHARPOS (*it) = find_newline (cp, bp, long_line_chunk_start (cp, chunk),
+				     -1, -1, NULL, &IT_BYTEPOS (*it), false);
+  else
+    IT_CHARPOS (*it) = find_newline_no_quit (cp, bp, -1, &IT_BYTEPOS (*it));
 }
 
 
@@ -6196,8 +6249,13 @@ forward_to_next_line_start (struct it *it, int *skipped_p,
   if (!newline_found_p)
     {
       ptrdiff_t bytepos, start = IT_CHARPOS (*it);
-      ptrdiff_t limit = find_newline_no_quit (start, IT_BYTEPOS (*it),
-					      1, &bytepos);
+      ptrdiff_t chunk = long_line_chunk (it->w);
+      ptrdiff_t limit
+	= (chunk
+	   ? find_newline (start, IT_BYTEPOS (*it),
+			   min (ZV, long_line_chunk_start (start, chunk) + chunk),
+			   -1, 1, NULL, &bytepos, false)
+	   : find_newline_no_quit (start, IT_BYTEPOS (*it), 1, &bytepos));
       Lisp_Object pos;
 
       eassert (!STRINGP (it->string));
@@ -6249,6 +6307,11 @@ forward_to_next_line_start (struct it *it, int *skipped_p,
 	      if (newline_found_p && it->bidi_p && bidi_it_prev)
 		*bidi_it_prev = it->bidi_it;
 	      set_iterator_to_next (it, 0);
+	      /* The end of a chunk of a long line counts as a line
+		 end, as it did above.  */
+	      if (chunk && !it->bidi_p && !STRINGP (it->string)
+		  && IT_CHARPOS (*it) >= limit)
+		newline_found_p = true;
 	    }
 	}
     }
@@ -6503,6 +6566,7 @@ reseat_1 (struct it *it, struct text_pos pos, int set_stop_p)
 
   it->current.pos = it->position = pos;
   it->end_charpos = ZV;
+  it->checkpoint_line_start = 0;
   it->dpvec = NULL;
   it->current.dpvec_index = -1;
   it->current.overlay_string_index = -1;
@@ -9267,6 +9331,8 @@ move_it_to (struct it *it, ptrdiff_t to_charpos, int to_x, int to_y, int to_vpos
       ++it->vpos;
       last_height = it->max_ascent + it->max_descent;
       it->max_ascent = it->max_descent = 0;
+      if (it->checkpoint_line_start > 0)
+	save_it_checkpoint (it);
     }
 
  out:
@@ -9351,6 +9417,10 @@ move_it_vertically_backward (struct it *it, int dy)
 				   reordering is in effect.  */
   it->continuation_lines_width = 0;
 
+  /* To move to the start of the screen line, we can start from any
+     screen line start before START_POS.  */
+  start_it_checkpoints (it, dy == 0 ? start_pos : 0);
+
   /* Move forward and see what y-distance we moved.  First move to the
      start of the next line so that we get its height.  We need this
      height to be able to tell whether we reached the specified
@@ -9566,12 +9636,12 @@ move_it_by_lines (struct it *it, ptrdiff_t dvpos)
     }
   else
     {
-      struct it it2;
+      struct it it2, at_line_start;
       void *it2data = NULL;
       ptrdiff_t start_charpos, i;
       int nchars_per_row
 	= (it->last_visible_x - it->first_visible_x) / FRAME_COLUMN_WIDTH (it->f);
-      bool hit_pos_limit = false;
+      bool hit_pos_limit = false, moved_in_string_p = false, checkpoint_p;
       ptrdiff_t pos_limit;
 
       /* Start at the beginning of the screen line containing IT's
@@ -9609,15 +9679,33 @@ move_it_by_lines (struct it *it, ptrdiff_t dvpos)
 	  back_to_previous_visible_line_start (it);
 	  reseat (it, it->current.pos, 1);
 	  dvpos--;
+	  moved_in_string_p = true;
 	}
 
       it->current_x = it->hpos = 0;
 
+      /* Start from a screen line before START_CHARPOS, if one is
+	 known, instead of from the line start.  */
+      at_line_start = *it;
+      checkpoint_p = (!moved_in_string_p
+		      && start_it_checkpoints (it, start_charpos - 1));
+
       /* Above call may have moved too far if continuation lines
 	 are involved.  Scan forward and see if it did.  */
+    scan_forward:
       SAVE_IT (it2, *it, it2data);
       it2.vpos = it2.current_y = 0;
       move_it_to (&it2, start_charpos, -1, -1, -1, MOVE_TO_POS);
+      if (checkpoint_p && it2.vpos < -dvpos)
+	{
+	  /* The checkpoint is less than -DVPOS lines back; start from
+	     the line start after all.  IT is not bidi-reordered if it
+	     started from a checkpoint.  */
+	  RESTORE_IT (&it2, &it2, it2data);
+	  *it = at_line_start;
+	  checkpoint_p = false;
+	  goto scan_forward;
+	}
       it->vpos -= it2.vpos;
       it->current_y -= it2.current_y;
       it->current_x = it->hpos = 0;
@@ -13376,6 +13464,7 @@ redisplay_internal (void)
   record_unwind_protect_void (unwind_redisplay);
   redisplaying_p = 1;
   specbind (Qinhibit_free_realized_faces, Qnil);
+  note_input_latency (INPUT_LATENCY_REDISPLAY);
 
   /* Record this function, so it appears on the profiler's backtraces.  */
   /*record_in_backtrace (Qredisplay_internal, &Qnil, 0);*/
@@ -13978,8 +14067,18 @@ redisplay_internal (void)
       clear_face_cache_count = 0;
     }
 
+  /* Likewise, forget glyph-strings of automatic composition that have
+     not been used for a while once there are too many.  */
+  if (composition_gstring_trim_cache ())
+    {
+      FOR_EACH_FRAME (tail, frame)
+	clear_current_matrices (XFRAME (frame));
+      windows_or_buffers_changed = 61;
+    }
+
 #ifdef HAVE_WINDOW_SYSTEM
-  if (clear_image_cache_count > CLEAR_IMAGE_CACHE_COUNT)
+  if (clear_image_cache_count > CLEAR_IMAGE_CACHE_COUNT
+      || image_cache_full)
     {
       clear_image_caches (Qnil);
       clear_image_cache_count = 0;
@@ -14143,7 +14242,19 @@ disp_char_vector (struct Lisp_Char_Table *dp, int c)
 			   Window Redisplay
  ***********************************************************************/
 
-/* Redisplay all leaf windows in the window tree rooted at WINDOW.  */
+/* Redisplay all leaf windows in the window tree rooted at WINDOW.
+
+   The windows are redisplayed one after the other, on the main
+   thread.  Producing the glyphs of one window cannot overlap with
+   producing those of another, even for windows whose text calls no
+   Lisp: display_line and the functions it calls work on
+   current_buffer, which redisplay_window sets, realize faces into the
+   frame's face cache, share the bidi cache and the this_line_*
+   variables, and lay rows out in the frame's glyph pool, all without
+   locking.  What makes redisplay of many windows fast is thus that
+   each window does as little as it can: try_cursor_movement,
+   try_window_id and try_window_reusing_current_matrix before
+   try_window, and the glyph row cache in display_line.  */
 
 static void
 redisplay_windows (Lisp_Object window)
@@ -15707,6 +15818,95 @@ set_vertical_scroll_bar (struct window *w)
 }
 
 
+/* The log of how windows were redisplayed: a vector used as a ring of
+   the last `redisplay-log-size' records, or nil.  REDISPLAY_LOG_NEXT
+   is the index of the slot the next record goes in.  */
+
+static Lisp_Object redisplay_log;
+static ptrdiff_t redisplay_log_next;
+
+/* The largest number of records the redisplay log holds.  */
+
+#define REDISPLAY_LOG_MAX 100000
+
+/* Symbols naming the ways redisplay_window redisplays a window.  */
+
+static Lisp_Object Qforce_start, Qcursor_movement, Qtry_window_id;
+static Lisp_Object Qreuse_current_matrix, Qtry_window, Qtry_scrolling;
+static Lisp_Object Qrecenter;
+
+/* Number of glyph rows display_line has produced so far.  */
+
+static EMACS_INT display_lines_produced;
+
+/* Record in the redisplay log that WINDOW was redisplayed by METHOD,
+   producing LINES glyph rows and realizing FACES faces, in the time
+   since START.  */
+
+static void
+log_redisplay (Lisp_Object window, Lisp_Object method, EMACS_INT lines,
+	       EMACS_INT faces, struct timespec start)
+{
+  struct timespec elapsed = timespec_sub (current_timespec (), start);
+  EMACS_INT size = min (redisplay_log_size, REDISPLAY_LOG_MAX);
+  Lisp_Object record;
+
+  if (! VECTORP (redisplay_log) || ASIZE (redisplay_log) != size)
+    {
+      redisplay_log = Fmake_vector (make_number (size), Qnil);
+      redisplay_log_next = 0;
+    }
+
+  record = make_uninit_vector (5);
+  ASET (record, 0, window);
+  ASET (record, 1, method);
+  ASET (record, 2, make_number (lines));
+  ASET (record, 3, make_number (faces));
+  ASET (record, 4, make_float (timespectod (elapsed)));
+  ASET (redisplay_log, redisplay_log_next, record);
+  redisplay_log_next = (redisplay_log_next + 1) % size;
+}
+
+DEFUN ("redisplay-log", Fredisplay_log, Sredisplay_log, 0, 1, 0,
+       doc: /* Return the records of the redisplay log, most recent first.
+Windows are logged only while `redisplay-log-size' is positive; see
+that variable for what a record holds.
+If CLEAR is non-nil, empty the log after returning its records.  */)
+  (Lisp_Object clear)
+{
+  Lisp_Object records = Qnil;
+  ptrdiff_t i, size;
+
+  if (! VECTORP (redisplay_log))
+    return Qnil;
+
+  size = ASIZE (redisplay_log);
+  for (i = 0; i < size; i++)
+    {
+      Lisp_Object record
+	= AREF (redisplay_log, (redisplay_log_next + i) % size);
+      if (! NILP (record))
+	records = Fcons (record, records);
+    }
+
+  if (! NILP (clear))
+    redisplay_log = Qnil;
+  return records;
+}
+
+/* Return true if the line number in the mode line of W, which is
+   showing the current buffer, is still right: the buffer text and the
+   window start are as they were when it was displayed, and point is
+   still on the same line.  */
+
+static bool
+mode_line_number_unchanged_p (struct window *w)
+{
+  return (w->mode_line_modified == MODIFF
+	  && w->mode_line_start == marker_position (w->start)
+	  && w->mode_line_line_beg <= PT && PT <= w->mode_line_line_end);
+}
+
 /* Redisplay leaf window WINDOW.  JUST_THIS_ONE_P non-zero means only
    selected_window is redisplayed.
 
@@ -15780,6 +15980,12 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
   int last_line_misfit = 0;
   ptrdiff_t beg_unchanged, end_unchanged;
   int frame_line_height;
+  /* How the window was redisplayed, and what that cost, for the
+     redisplay log.  */
+  bool log_p = 0 < redisplay_log_size;
+  Lisp_Object method = Qnil;
+  struct timespec log_start IF_LINT (= { 0, });
+  EMACS_INT log_lines IF_LINT (= 0), log_faces IF_LINT (= 0);
 
   SET_TEXT_POS (lpoint, PT, PT_BYTE);
   opoint = lpoint;
@@ -15800,6 +16006,13 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
   eassert (XMARKER (w->start)->buffer == buffer);
   eassert (XMARKER (w->pointm)->buffer == buffer);
 
+  if (log_p)
+    {
+      log_start = current_timespec ();
+      log_lines = display_lines_produced;
+      log_faces = faces_realized;
+    }
+
   dynwind_begin ();
 
   /* We come here again if we need to run window-text-change-functions
@@ -15862,6 +16075,18 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
      variables.  */
   set_buffer_internal_1 (XBUFFER (w->contents));
 
+  /* Look for long lines around point and the window start, whose
+     display would cost too much unless scans over lines are bounded;
+     see long_line_chunk.  */
+  if (!current_buffer->long_line_optimizations_p
+      && RANGED_INTEGERP (1, Vlong_line_threshold, PTRDIFF_MAX)
+      && (long_line_p (PT, XINT (Vlong_line_threshold))
+	  || (XMARKER (w->start)->buffer == current_buffer
+	      && long_line_p (clip_to_bounds (BEGV, marker_position (w->start),
+					      ZV),
+			      XINT (Vlong_line_threshold)))))
+    current_buffer->long_line_optimizations_p = true;
+
   current_matrix_up_to_date_p
     = (w->window_end_valid
        && !current_buffer->clip_changed
@@ -16118,6 +16343,7 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
 #ifdef GLYPH_DEBUG
       debug_method_add (w, "forced window start");
 #endif
+      method = Qforce_start;
       goto done;
     }
 
@@ -16132,6 +16358,7 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
 	{
 	case CURSOR_MOVEMENT_SUCCESS:
 	  used_current_matrix_p = 1;
+	  method = Qcursor_movement;
 	  goto done;
 
 	case CURSOR_MOVEMENT_MUST_SCROLL:
@@ -16162,6 +16389,7 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
       debug_method_add (w, "try_window_id %d", tem);
 #endif
 
+      method = Qtry_window_id;
       if (f->fonts_changed)
 	goto need_larger_matrices;
       if (tem > 0)
@@ -16236,6 +16464,7 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
 	       is set in that case, so we will detect it below.  */
 	    goto try_to_scroll;
 	}
+      method = used_current_matrix_p ? Qreuse_current_matrix : Qtry_window;
 
       if (f->fonts_changed)
 	goto need_larger_matrices;
@@ -16285,6 +16514,7 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
 			      scroll_conservatively,
 			      emacs_scroll_step,
 			      temp_scroll_step, last_line_misfit);
+      method = Qtry_scrolling;
       switch (ss)
 	{
 	case SCROLLING_SUCCESS:
@@ -16309,6 +16539,7 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
 #ifdef GLYPH_DEBUG
   debug_method_add (w, "recenter");
 #endif
+  method = Qrecenter;
 
   /* Forget any previously recorded base line for line number display.  */
   if (!buffer_unchanged_p)
@@ -16573,8 +16804,8 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
        || (!just_this_one_p
 	   && !FRAME_WINDOW_P (f)
 	   && !WINDOW_FULL_WIDTH_P (w))
-       /* Line number to display.  */
-       || w->base_line_pos > 0
+       /* Line number to display, and point may be on another line.  */
+       || (w->base_line_pos > 0 && !mode_line_number_unchanged_p (w))
        /* Column number is displayed and different from the one displayed.  */
        || (w->column_number_displayed != -1
 	   && (w->column_number_displayed != current_column ())))
@@ -16715,6 +16946,10 @@ redisplay_window (Lisp_Object window, bool just_this_one_p)
   if (CHARPOS (lpoint) <= ZV)
     TEMP_SET_PT_BOTH (CHARPOS (lpoint), BYTEPOS (lpoint));
 
+  if (log_p)
+    log_redisplay (window, method, display_lines_produced - log_lines,
+		   faces_realized - log_faces, log_start);
+
   dynwind_end ();
 }
 
@@ -19800,6 +20035,442 @@ find_row_edges (struct it *it, struct glyph_row *row,
     row->maxpos = it->current.pos;
 }
 
+/***********************************************************************
+			     Glyph row cache
+ ***********************************************************************/
+
+/* A window remembers the glyph rows display_line produced for it
+   recently, so that a line displayed again with the same text, faces
+   and iterator state, as when scrolling back and forth, is copied
+   instead of being produced again.  Only rows of buffer text that
+   display_line starts and ends with nothing pushed on the iterator
+   stack, and that show no images, compositions or overlay arrows, are
+   remembered.  A remembered row is used only as long as nothing it
+   depends on has changed, as recorded in its key.  */
+
+/* Number of rows a window remembers.  */
+
+#define GLYPH_ROW_CACHE_SIZE 128
+
+/* What a row depends on.  Keys are compared with memcmp, so each key
+   is cleared before it is filled in.  */
+
+struct glyph_row_cache_key
+{
+  struct buffer *buffer;
+  EMACS_INT modiff, overlay_modiff, face_generation, generation;
+  Lisp_Object face_remapping, invisibility_spec, line_spacing;
+  Lisp_Object auto_composition, nobreak_char_display;
+  Lisp_Object glyphless_char_display;
+  struct Lisp_Char_Table *dp;
+  ptrdiff_t charpos, bytepos, stop_charpos, end_charpos, selective;
+  int face_id, base_face_id, continuation_lines_width;
+  int first_visible_x, last_visible_x, last_visible_y;
+  int frame_line_spacing, tab_width;
+  enum line_wrap_method line_wrap;
+  bool multibyte_p, ctl_arrow_p, start_of_box_run_p, long_lines_p;
+};
+
+struct glyph_row_cache_entry
+{
+  struct glyph_row_cache_key key;
+
+  /* The value of the cache's clock when the entry was last used.  */
+  EMACS_INT used;
+
+  /* The row, whose glyph pointers are not used, and its glyphs.  The
+     glyphs of each area follow those of the area before it.  */
+  struct glyph_row row;
+  struct glyph *glyphs;
+  ptrdiff_t glyphs_size;
+
+  /* The state of the iterator after the row was produced.  */
+  struct it it;
+};
+
+struct glyph_row_cache
+{
+  /* The window whose rows these are.  A window copied with its
+     cache pointer does not use the cache.  */
+  struct window *w;
+
+  EMACS_INT clock;
+
+  /* The entries, allocated as they are first needed.  */
+  struct glyph_row_cache_entry *entries[GLYPH_ROW_CACHE_SIZE];
+};
+
+/* Incremented to make windows forget the rows they remember.  */
+
+static EMACS_INT glyph_row_cache_generation;
+
+/* Make all windows forget the glyph rows they remember.  */
+
+void
+clear_glyph_row_caches (void)
+{
+  glyph_row_cache_generation++;
+}
+
+/* Fill in KEY for the state of IT, which is at the start of a screen
+   line.  Value is false if IT is not in plain buffer text, so that
+   its state cannot be reused.  */
+
+static bool
+layout_key (struct it *it, struct glyph_row_cache_key *key)
+{
+  if (it->bidi_p
+      || it->sp != 0
+      || it->method != GET_FROM_BUFFER
+      || it->area != TEXT_AREA
+      || it->current.overlay_string_index >= 0
+      || it->current.dpvec_index >= 0
+      || it->starts_in_middle_of_char_p
+      || it->redisplay_end_trigger_charpos > 0
+      || XBUFFER (it->w->contents) != current_buffer)
+    return false;
+
+  memset (key, 0, sizeof *key);
+  key->buffer = current_buffer;
+  key->modiff = MODIFF;
+  key->overlay_modiff = OVERLAY_MODIFF;
+  key->face_generation = face_cache_generation;
+  key->generation = glyph_row_cache_generation;
+  key->face_remapping = Vface_remapping_alist;
+  key->invisibility_spec = BVAR (current_buffer, invisibility_spec);
+  key->line_spacing = BVAR (current_buffer, extra_line_spacing);
+  key->auto_composition = Vauto_composition_mode;
+  key->nobreak_char_display = Vnobreak_char_display;
+  key->glyphless_char_display = Vglyphless_char_display;
+  key->dp = it->dp;
+  key->charpos = IT_CHARPOS (*it);
+  key->bytepos = IT_BYTEPOS (*it);
+  key->stop_charpos = it->stop_charpos;
+  key->end_charpos = it->end_charpos;
+  key->selective = it->selective;
+  key->face_id = it->face_id;
+  key->base_face_id = it->base_face_id;
+  key->continuation_lines_width = it->continuation_lines_width;
+  key->first_visible_x = it->first_visible_x;
+  key->last_visible_x = it->last_visible_x;
+  key->last_visible_y = it->last_visible_y;
+  key->frame_line_spacing = it->f->extra_line_spacing;
+  key->tab_width = it->tab_width;
+  key->line_wrap = it->line_wrap;
+  key->multibyte_p = it->multibyte_p;
+  key->ctl_arrow_p = it->ctl_arrow_p;
+  key->start_of_box_run_p = it->start_of_box_run_p;
+  key->long_lines_p = current_buffer->long_line_optimizations_p;
+  return true;
+}
+
+/* Fill in KEY for the row that IT is about to produce.  Value is
+   false if the row cannot be remembered.  */
+
+static bool
+glyph_row_cache_key (struct it *it, struct glyph_row_cache_key *key)
+{
+  return (cache_glyph_rows
+	  && !it->w->pseudo_window_p
+	  && NILP (Vshow_trailing_whitespace)
+	  && it->glyph_row != MATRIX_FIRST_TEXT_ROW (it->w->desired_matrix)
+	  && layout_key (it, key));
+}
+
+/* Return the entry of window W's cache whose key is KEY, or null.  */
+
+static struct glyph_row_cache_entry *
+glyph_row_cache_lookup (struct window *w, struct glyph_row_cache_key *key)
+{
+  struct glyph_row_cache *cache = w->glyph_row_cache;
+  int i;
+
+  if (cache && cache->w == w)
+    for (i = 0; i < GLYPH_ROW_CACHE_SIZE; i++)
+      {
+	struct glyph_row_cache_entry *e = cache->entries[i];
+	if (e && memcmp (&e->key, key, sizeof *key) == 0)
+	  return e;
+      }
+  return NULL;
+}
+
+/* Produce the row IT->glyph_row by copying the row remembered in
+   entry E, and leave IT after it as display_line would.  Value is
+   false, with nothing changed, if the row cannot be used here.  */
+
+static bool
+display_line_from_cache (struct it *it, struct glyph_row_cache_entry *e)
+{
+  struct glyph_row *row = it->glyph_row;
+  struct glyph *glyphs[LAST_AREA + 1];
+  struct glyph *from = e->glyphs;
+  int y = it->current_y, vpos = it->vpos;
+  int area;
+
+  for (area = LEFT_MARGIN_AREA; area < LAST_AREA; area++)
+    if (row->glyphs[area + 1] - row->glyphs[area] < e->row.used[area])
+      return false;
+  if (!NILP (overlay_arrow_at_row (it, &e->row)))
+    return false;
+
+  memcpy (glyphs, row->glyphs, sizeof glyphs);
+  *row = e->row;
+  memcpy (row->glyphs, glyphs, sizeof glyphs);
+  for (area = LEFT_MARGIN_AREA; area < LAST_AREA; area++)
+    {
+      memcpy (row->glyphs[area], from, row->used[area] * sizeof *from);
+      from += row->used[area];
+    }
+  row->y = y;
+
+  /* Compute how much of the line is visible, as
+     compute_line_metrics does.  */
+  if (FRAME_WINDOW_P (it->f))
+    {
+      int min_y = WINDOW_HEADER_LINE_HEIGHT (it->w);
+      int max_y = WINDOW_BOX_HEIGHT_NO_MODE_LINE (it->w);
+
+      row->visible_height = row->height;
+      if (row->y < min_y)
+	row->visible_height -= min_y - row->y;
+      if (row->y + row->height > max_y)
+	row->visible_height -= row->y + row->height - max_y;
+    }
+
+  *it = e->it;
+  e->used = ++it->w->glyph_row_cache->clock;
+
+  if (it->w->cursor.vpos < 0
+      && PT >= MATRIX_ROW_START_CHARPOS (row)
+      && PT <= MATRIX_ROW_END_CHARPOS (row)
+      && cursor_row_p (row))
+    set_cursor_from_row (it->w, row, it->w->desired_matrix, 0, 0, 0, 0);
+
+  it->current_y = y + row->height;
+  it->vpos = vpos + 1;
+  it->glyph_row = row + 1;
+  if (it->glyph_row < MATRIX_BOTTOM_TEXT_ROW (it->w->desired_matrix, it->w))
+    it->glyph_row->reversed_p = row->reversed_p;
+  return true;
+}
+
+/* Remember ROW, which display_line has just produced from the state
+   described by KEY, leaving IT after it.  */
+
+static void
+glyph_row_cache_store (struct it *it, struct glyph_row *row,
+		       struct glyph_row_cache_key *key)
+{
+  struct window *w = it->w;
+  struct glyph_row_cache *cache = w->glyph_row_cache;
+  struct glyph_row_cache_entry *e;
+  struct glyph *to, *glyph, *end;
+  ptrdiff_t nglyphs = 0;
+  int area, i, oldest;
+
+  if (it->sp != 0
+      || it->method != GET_FROM_BUFFER
+      || it->current.overlay_string_index >= 0
+      || it->current.dpvec_index >= 0
+      || !row->displays_text_p
+      || row->ends_at_zv_p
+      || row->ends_in_ellipsis_p
+      || row->overlay_arrow_bitmap != 0)
+    return;
+  for (area = LEFT_MARGIN_AREA; area < LAST_AREA; area++)
+    {
+      end = row->glyphs[area] + row->used[area];
+      for (glyph = row->glyphs[area]; glyph < end; glyph++)
+	if (glyph->type != CHAR_GLYPH
+	    && glyph->type != STRETCH_GLYPH
+	    && glyph->type != GLYPHLESS_GLYPH)
+	  return;
+      nglyphs += row->used[area];
+    }
+
+  if (!cache || cache->w != w)
+    {
+      cache = xzalloc (sizeof *cache);
+      cache->w = w;
+      w->glyph_row_cache = cache;
+    }
+
+  /* Replace the entry used least recently, one that is free if
+     there is one.  */
+  for (i = oldest = 0; i < GLYPH_ROW_CACHE_SIZE; i++)
+    {
+      e = cache->entries[i];
+      if (!e)
+	{
+	  oldest = i;
+	  break;
+	}
+      if (e->used < cache->entries[oldest]->used)
+	oldest = i;
+    }
+  e = cache->entries[oldest];
+  if (!e)
+    e = cache->entries[oldest] = xzalloc (sizeof *e);
+
+  if (e->glyphs_size < nglyphs)
+    e->glyphs = xpalloc (e->glyphs, &e->glyphs_size,
+			 nglyphs - e->glyphs_size, -1, sizeof *e->glyphs);
+  to = e->glyphs;
+  for (area = LEFT_MARGIN_AREA; area < LAST_AREA; area++)
+    {
+      memcpy (to, row->glyphs[area], row->used[area] * sizeof *to);
+      to += row->used[area];
+    }
+
+  e->key = *key;
+  e->row = *row;
+  e->it = *it;
+  e->used = ++cache->clock;
+}
+
+/***********************************************************************
+			   Iterator checkpoints
+ ***********************************************************************/
+
+/* Moving an iterator to the screen line containing a position means
+   moving it from the start of the position's buffer line, which takes
+   long in a buffer line shown in many screen lines.  So while an
+   iterator moves over screen lines from a line start, the state it has
+   at some of the screen line starts is saved, and a later move from
+   the same line start to a position past one of these checkpoints
+   continues from the checkpoint instead.  A checkpoint is used only
+   as long as nothing that affects the layout of the text has changed,
+   as recorded in its key.  */
+
+/* Number of checkpoints remembered, for all windows.  */
+
+#define IT_CHECKPOINTS 64
+
+/* Least number of characters between successive checkpoints.  */
+
+#define IT_CHECKPOINT_DISTANCE 1000
+
+struct it_checkpoint
+{
+  /* What the layout depends on, not counting the position.  */
+  struct glyph_row_cache_key key;
+
+  /* The window, and the start of the buffer line the iterator moved
+     from to reach the checkpoint.  */
+  struct window *w;
+  ptrdiff_t line_start;
+
+  /* The value of it_checkpoint_clock when the entry was last used.  */
+  EMACS_INT used;
+
+  struct it it;
+};
+
+static struct it_checkpoint *it_checkpoints[IT_CHECKPOINTS];
+static EMACS_INT it_checkpoint_clock;
+
+/* Fill in KEY for the layout at checkpoints of IT, leaving out what
+   changes as IT moves along a line.  */
+
+static bool
+it_checkpoint_key (struct it *it, struct glyph_row_cache_key *key)
+{
+  if (!layout_key (it, key))
+    return false;
+  key->charpos = key->bytepos = key->stop_charpos = 0;
+  key->face_id = key->continuation_lines_width = key->last_visible_y = 0;
+  key->start_of_box_run_p = false;
+  return true;
+}
+
+/* IT is at the start of a buffer line.  Make IT save checkpoints as
+   it moves on from there, and if LIMIT is positive, move IT to the
+   last checkpoint at or before LIMIT that was saved moving from the
+   same line start, if there is one.  IT's vertical position is kept,
+   as if IT had moved there without changing it.  Value is true if IT
+   was moved.  */
+
+bool
+start_it_checkpoints (struct it *it, ptrdiff_t limit)
+{
+  struct glyph_row_cache_key key;
+  struct it_checkpoint *best = NULL;
+  ptrdiff_t line_start = IT_CHARPOS (*it);
+  int i;
+
+  if (!it_checkpoint_key (it, &key))
+    return false;
+  it->checkpoint_line_start = it->last_checkpoint = line_start;
+
+  for (i = 0; i < IT_CHECKPOINTS; i++)
+    {
+      struct it_checkpoint *c = it_checkpoints[i];
+      if (c && c->w == it->w && c->line_start == line_start
+	  && IT_CHARPOS (c->it) <= limit
+	  && (!best || IT_CHARPOS (best->it) < IT_CHARPOS (c->it))
+	  && memcmp (&c->key, &key, sizeof key) == 0)
+	best = c;
+    }
+
+  if (best)
+    {
+      int vpos = it->vpos, current_y = it->current_y;
+      int last_visible_y = it->last_visible_y;
+      struct glyph_row *glyph_row = it->glyph_row;
+
+      *it = best->it;
+      it->vpos = vpos;
+      it->current_y = current_y;
+      it->last_visible_y = last_visible_y;
+      it->glyph_row = glyph_row;
+      best->used = ++it_checkpoint_clock;
+    }
+  return best != NULL;
+}
+
+/* IT has moved to the start of a screen line.  Save its state as a
+   checkpoint if it is saving checkpoints and the last one is far
+   enough behind.  */
+
+static void
+save_it_checkpoint (struct it *it)
+{
+  struct glyph_row_cache_key key;
+  struct it_checkpoint *c;
+  int i, oldest;
+
+  if (IT_CHARPOS (*it) - it->last_checkpoint < IT_CHECKPOINT_DISTANCE
+      || it->current_x != 0
+      || !it_checkpoint_key (it, &key))
+    return;
+  it->last_checkpoint = IT_CHARPOS (*it);
+
+  /* Replace a checkpoint at the same place, or else the one used
+     least recently, one that is free if there is one.  */
+  for (i = oldest = 0; i < IT_CHECKPOINTS; i++)
+    {
+      c = it_checkpoints[i];
+      if (!c
+	  || (c->w == it->w && IT_CHARPOS (c->it) == IT_CHARPOS (*it)))
+	{
+	  oldest = i;
+	  break;
+	}
+      if (c->used < it_checkpoints[oldest]->used)
+	oldest = i;
+    }
+  c = it_checkpoints[oldest];
+  if (!c)
+    c = it_checkpoints[oldest] = xzalloc (sizeof *c);
+
+  c->key = key;
+  c->w = it->w;
+  c->line_start = it->checkpoint_line_start;
+  c->it = *it;
+  c->used = ++it_checkpoint_clock;
+}
+
 /* Construct the glyph row IT->glyph_row in the desired matrix of
    IT->w from text at the current position of IT.  See dispextern.h
    for an overview of struct it.  Value is non-zero if
@@ -19823,6 +20494,8 @@ display_line (struct it *it)
   int cvpos;
   ptrdiff_t min_pos = ZV + 1, max_pos = 0;
   ptrdiff_t min_bpos IF_LINT (= 0), max_bpos IF_LINT (= 0);
+  struct glyph_row_cache_key cache_key;
+  bool cache_p;
 
   /* We always start displaying at hpos zero even if hscrolled.  */
   eassert (it->hpos == 0 && it->current_x == 0);
@@ -19835,6 +20508,18 @@ display_line (struct it *it)
       return 0;
     }
 
+  /* Use a row remembered from an earlier redisplay if there is one.  */
+  cache_p = glyph_row_cache_key (it, &cache_key);
+  if (cache_p)
+    {
+      struct glyph_row_cache_entry *e
+	= glyph_row_cache_lookup (it->w, &cache_key);
+      if (e && display_line_from_cache (it, e))
+	return MATRIX_ROW_DISPLAYS_TEXT_P (row);
+    }
+
+  display_lines_produced++;
+
   /* Clear the result glyph row and enable it.  */
   prepare_desired_row (row);
 
@@ -20502,6 +21187,7 @@ display_line (struct it *it)
 	  row->overlay_arrow_bitmap = XINT (overlay_arrow_string);
 	}
       overlay_arrow_seen = 1;
+      cache_p = false;
     }
 
   /* Highlight trailing whitespace.  */
@@ -20566,6 +21252,8 @@ display_line (struct it *it)
   if (it->glyph_row < MATRIX_BOTTOM_TEXT_ROW (it->w->desired_matrix, it->w))
     it->glyph_row->reversed_p = row->reversed_p;
   it->start = row->end;
+  if (cache_p)
+    glyph_row_cache_store (it, row, &cache_key);
   return MATRIX_ROW_DISPLAYS_TEXT_P (row);
 
 #undef RECORD_MAX_MIN_POS
@@ -20602,6 +21290,9 @@ See also `bidi-paragraph-direction'.  */)
     return Qleft_to_right;
   else if (!NILP (BVAR (buf, bidi_paragraph_direction)))
     return BVAR (buf, bidi_paragraph_direction);
+  else if (!buf->text->rtl)
+    /* No paragraph has a strong right-to-left character.  */
+    return Qleft_to_right;
   else
     {
       /* Determine the direction from buffer text.  We could try to
@@ -22707,8 +23398,17 @@ decode_mode_spec (struct window *w, register int c, int field_width,
 	nlines = display_count_lines (startpos_byte,
 				      PT_BYTE, PT, &junk);
 
-	/* Record that we did display the line number.  */
+	/* Record that we did display the line number, and what it
+	   depends on, so that redisplay_window need not redo the mode
+	   line while point stays on this line.  */
 	line_number_displayed = 1;
+	if (mode_line_target == MODE_LINE_DISPLAY)
+	  {
+	    w->mode_line_modified = BUF_MODIFF (b);
+	    w->mode_line_start = startpos;
+	    w->mode_line_line_beg = find_newline_no_quit (PT, PT_BYTE, -1, NULL);
+	    w->mode_line_line_end = find_before_next_newline (PT, ZV, 1, NULL);
+	  }
 
 	/* Make the string to show.  */
 	pint2str (decode_mode_spec_buf, width, topline + nlines);
@@ -23599,7 +24299,7 @@ init_glyph_string (struct glyph_string *s,
   s->hdc = hdc;
 #endif
   s->display = FRAME_X_DISPLAY (s->f);
-  s->window = FRAME_X_WINDOW (s->f);
+  s->window = FRAME_X_DRAWABLE (s->f);
   s->char2b = char2b;
   s->hl = hl;
   s->row = row;
@@ -23677,7 +24377,7 @@ get_char_face_and_encoding (struct frame *f, int c, int face_id,
 
   if (face->font)
     {
-      code = face->font->driver->encode_char (face->font, c);
+      code = font_glyph_code (face->font, c);
 
       if (code == FONT_INVALID_CODE)
 	code = 0;
@@ -23723,7 +24423,7 @@ get_glyph_face_and_encoding (struct frame *f, struct glyph *glyph,
       if (CHAR_BYTE8_P (glyph->u.ch))
 	code = CHAR_TO_BYTE8 (glyph->u.ch);
       else
-	code = face->font->driver->encode_char (face->font, glyph->u.ch);
+	code = font_glyph_code (face->font, glyph->u.ch);
 
       if (code == FONT_INVALID_CODE)
 	code = 0;
@@ -23745,7 +24445,7 @@ get_char_glyph_code (int c, struct font *font, XChar2b *char2b)
   if (CHAR_BYTE8_P (c))
     code = CHAR_TO_BYTE8 (c);
   else
-    code = font->driver->encode_char (font, c);
+    code = font_glyph_code (font, c);
 
   if (code == FONT_INVALID_CODE)
     return 0;
@@ -24046,7 +24746,7 @@ get_per_char_metric (struct font *font, XChar2b *char2b)
   code = (XCHAR2B_BYTE1 (char2b) << 8) | XCHAR2B_BYTE2 (char2b);
   if (code == FONT_INVALID_CODE)
     return NULL;
-  font->driver->text_extents (font, &code, 1, &metrics);
+  font_glyph_metrics (font, code, &metrics);
   return &metrics;
 }
 
@@ -25738,7 +26438,7 @@ produce_glyphless_glyph (struct it *it, int for_no_font, Lisp_Object acronym)
 	  str = buf;
 	}
       for (len = 0; str[len] && ASCII_CHAR_P (str[len]) && len < 6; len++)
-	code[len] = font->driver->encode_char (font, str[len]);
+	code[len] = font_glyph_code (font, str[len]);
       upper_len = (len + 1) / 2;
       font->driver->text_extents (font, code, upper_len,
 				  &metrics_upper);
@@ -29932,6 +30632,17 @@ syms_of_xdisp (void)
   staticpro (&Vmessage_stack);
 
   DEFSYM (Qinhibit_redisplay, "inhibit-redisplay");
+
+  redisplay_log = Qnil;
+  staticpro (&redisplay_log);
+
+  DEFSYM (Qforce_start, "force-start");
+  DEFSYM (Qcursor_movement, "cursor-movement");
+  DEFSYM (Qtry_window_id, "try-window-id");
+  DEFSYM (Qreuse_current_matrix, "reuse-current-matrix");
+  DEFSYM (Qtry_window, "try-window");
+  DEFSYM (Qtry_scrolling, "try-scrolling");
+  DEFSYM (Qrecenter, "recenter");
   DEFSYM (Qredisplay_internal, "redisplay_internal (C function)");
 
   message_dolog_marker1 = Fmake_marker ();
@@ -30104,6 +30815,43 @@ where to display overlay arrows.  */);
   Voverlay_arrow_variable_list
     = list1 (intern_c_string ("overlay-arrow-position"));
 
+  DEFVAR_LISP ("long-line-threshold", Vlong_line_threshold,
+    doc: /* Line length above which redisplay bounds its scans over lines.
+When redisplay finds a line longer than this many characters around
+point or the start of a window showing a buffer, it remembers that the
+buffer has long lines until the buffer is erased.  In such a buffer,
+redisplay treats the text as divided into chunks of a few windowfuls,
+each starting a line, so that displaying the text and moving over it
+cost no more than a few windowfuls of characters.  Lines may then be
+broken at unexpected places.  The value nil means never do this.  */);
+  Vlong_line_threshold = make_number (50000);
+
+  DEFVAR_BOOL ("cache-glyph-rows", cache_glyph_rows,
+    doc: /* Non-nil means windows remember the display of lines they show.
+A line shown again with nothing that affects its display changed, as
+when scrolling back to it, is then not laid out again.  */);
+  cache_glyph_rows = 1;
+
+  DEFVAR_INT ("redisplay-log-size", redisplay_log_size,
+    doc: /* Number of window redisplays that `redisplay-log' remembers.
+If this is positive, each redisplay of a window adds a record to the
+log, a vector [WINDOW METHOD LINES FACES SECONDS].  METHOD is how the
+window was redisplayed, the last of these that redisplay tried:
+
+ `cursor-movement'      only the cursor moved;
+ `try-window-id'        only the changed lines were redisplayed;
+ `reuse-current-matrix' lines already displayed were reused;
+ `try-window'           the window was redisplayed from its start;
+ `try-scrolling'        the window was scrolled to show point;
+ `recenter'             the window was redisplayed around point;
+ `force-start'          the window was redisplayed from a forced start;
+ nil                    the window's text was not redisplayed.
+
+LINES is the number of glyph rows produced, FACES the number of faces
+realized, and SECONDS the time taken.  Changing this variable empties
+the log.  The log holds no more than 100000 records.  */);
+  redisplay_log_size = 0;
+
   DEFVAR_INT ("scroll-step", emacs_scroll_step,
     doc: /* The number of lines to try scrolling a window by when point moves out.
 If that fails to bring point back on frame, point is centered instead.
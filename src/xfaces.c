@@ -278,6 +278,11 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 
 #define FACE_CACHE_BUCKETS_SIZE 1001
 
+/* Size of the memo of face_at_buffer_position in face caches (should
+   be a prime number).  */
+
+#define FACE_MEMO_SIZE 251
+
 /* Keyword symbols used for face attribute names.  */
 
 Lisp_Object QCfamily, QCheight, QCweight, QCslant;
@@ -401,6 +406,15 @@ static int clear_font_table_count;
 
 int face_change_count;
 
+/* Number of faces realized so far.  Used to log redisplay.  */
+
+EMACS_INT faces_realized;
+
+/* Incremented whenever a realized face is freed, so that the face IDs
+   in glyphs produced before might now name other faces.  */
+
+EMACS_INT face_cache_generation;
+
 /* Non-zero means don't display bold text if a face's foreground
    and background colors are the inverse of the default colors of the
    display.   This is a kluge to suppress `bold black' foreground text
@@ -4168,6 +4182,20 @@ If FRAME is unspecified or nil, the current frame is used.  */)
 			      Face Cache
  ***********************************************************************/
 
+/* Forget the faces remembered in the memo of face cache C.  */
+
+static void
+clear_face_memo (struct face_cache *c)
+{
+  int i;
+
+  for (i = 0; i < FACE_MEMO_SIZE; i++)
+    {
+      c->memo[i].prop = Qnil;
+      c->memo[i].face_id = -1;
+    }
+}
+
 /* Return a new face cache for frame F.  */
 
 static struct face_cache *
@@ -4179,6 +4207,8 @@ make_face_cache (struct frame *f)
   c->size = 50;
   c->used = 0;
   c->faces_by_id = xmalloc (c->size * sizeof *c->faces_by_id);
+  c->memo = xmalloc (FACE_MEMO_SIZE * sizeof *c->memo);
+  clear_face_memo (c);
   c->f = f;
   c->menu_face_changed_p = menu_face_changed_default;
   return c;
@@ -4241,6 +4271,8 @@ free_realized_faces (struct face_cache *c)
       c->used = 0;
       size = FACE_CACHE_BUCKETS_SIZE * sizeof *c->buckets;
       memset (c->buckets, 0, size);
+      clear_face_memo (c);
+      face_cache_generation++;
 
       /* Must do a thorough redisplay the next time.  Mark current
 	 matrices as invalid because they will reference faces freed
@@ -4285,6 +4317,7 @@ free_face_cache (struct face_cache *c)
       free_realized_faces (c);
       xfree (c->buckets);
       xfree (c->faces_by_id);
+      xfree (c->memo);
       xfree (c);
     }
 }
@@ -4383,6 +4416,8 @@ uncache_face (struct face_cache *c, struct face *face)
   c->faces_by_id[face->id] = NULL;
   if (face->id == c->used)
     --c->used;
+  clear_face_memo (c);
+  face_cache_generation++;
 }
 
 
@@ -5417,6 +5452,7 @@ realize_face (struct face_cache *cache, Lisp_Object attrs[LFACE_VECTOR_SIZE],
   /* LFACE must be fully specified.  */
   eassert (cache != NULL);
   check_lface_attrs (attrs);
+  faces_realized++;
 
   if (former_face_id >= 0 && cache->used > former_face_id)
     {
@@ -5996,6 +6032,34 @@ face_at_buffer_position (struct window *w, ptrdiff_t pos,
       && NILP (prop))
     return default_face->id;
 
+  /* If only a text property specifies the face, look for the face
+     merged from the same property value before.  Values are compared
+     with `eq', like the text property functions do.  Face remapping
+     is buffer-local, so don't use the memo when it is in effect, nor
+     when named faces have changed and realized faces are yet to be
+     freed.  */
+  if (noverlays == 0
+      && NILP (Vface_remapping_alist)
+      && face_change_count == 0)
+    {
+      struct face_cache *c = FRAME_FACE_CACHE (f);
+      struct face_memo *m
+	= &c->memo[((EMACS_UINT) XHASH (prop) + default_face->id)
+		   % FACE_MEMO_SIZE];
+
+      if (m->face_id >= 0
+	  && m->base_face_id == default_face->id
+	  && EQ (m->prop, prop))
+	return m->face_id;
+
+      memcpy (attrs, default_face->lface, sizeof attrs);
+      merge_face_ref (f, prop, attrs, 1, 0);
+      m->face_id = lookup_face (f, attrs);
+      m->base_face_id = default_face->id;
+      m->prop = prop;
+      return m->face_id;
+    }
+
   /* Begin with attributes from the default face.  */
   memcpy (attrs, default_face->lface, sizeof attrs);
 
@@ -399,7 +399,33 @@ x_defined_color (struct frame *f, const char *color_name,
   success_p = xg_check_special_colors (f, color_name, color);
 #endif
   if (!success_p)
-    success_p = XParseColor (dpy, cmap, color_name, color) != 0;
+    {
+      /* Parsing a color name is a round trip to the server, and every
+	 new frame parses the colors of all its faces.  The names mean
+	 the same for all frames of a display, so remember them.  */
+      struct x_display_info *dpyinfo = FRAME_DISPLAY_INFO (f);
+      struct x_color_name **bucket
+	= &dpyinfo->color_names[hash_string (color_name, strlen (color_name))
+				% ARRAYELTS (dpyinfo->color_names)];
+      struct x_color_name *entry;
+
+      for (entry = *bucket; entry; entry = entry->next)
+	if (!strcmp (entry->name, color_name))
+	  break;
+      if (!entry)
+	{
+	  entry = xmalloc (offsetof (struct x_color_name, name)
+			   + strlen (color_name) + 1);
+	  strcpy (entry->name, color_name);
+	  entry->defined_p
+	    = XParseColor (dpy, cmap, color_name, &entry->color) != 0;
+	  entry->next = *bucket;
+	  *bucket = entry;
+	}
+      success_p = entry->defined_p;
+      if (success_p)
+	*color = entry->color;
+    }
   if (success_p && alloc_p)
     success_p = x_alloc_nearest_color (f, cmap, color);
   unblock_input ();
@@ -1021,8 +1047,7 @@ x_set_menu_bar_lines (struct frame *f, Lisp_Object value, Lisp_Object oldval)
 	  y = FRAME_TOP_MARGIN_HEIGHT (f);
 
 	  block_input ();
-	  x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
-			0, y, width, height);
+	  x_clear_area (f, 0, y, width, height);
 	  unblock_input ();
 	}
 
@@ -1032,8 +1057,7 @@ x_set_menu_bar_lines (struct frame *f, Lisp_Object value, Lisp_Object oldval)
 	  height = nlines * FRAME_LINE_HEIGHT (f) - y;
 
 	  block_input ();
-	  x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
-			0, y, width, height);
+	  x_clear_area (f, 0, y, width, height);
 	  unblock_input ();
 	}
 
@@ -1148,8 +1172,7 @@ x_set_tool_bar_lines (struct frame *f, Lisp_Object value, Lisp_Object oldval)
       if (height > 0 && width > 0)
 	{
           block_input ();
-	  x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
-			0, y, width, height);
+	  x_clear_area (f, 0, y, width, height);
           unblock_input ();
         }
 
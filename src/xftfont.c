@@ -599,13 +599,16 @@ xftfont_get_xft_draw (struct frame *f)
     {
       block_input ();
       xft_draw= XftDrawCreate (FRAME_X_DISPLAY (f),
-			       FRAME_X_WINDOW (f),
+			       FRAME_X_DRAWABLE (f),
 			       FRAME_X_VISUAL (f),
 			       FRAME_X_COLORMAP (f));
       unblock_input ();
       eassert (xft_draw != NULL);
       font_put_frame_data (f, &xftfont_driver, xft_draw);
     }
+  else if (XftDrawDrawable (xft_draw) != FRAME_X_DRAWABLE (f))
+    /* The frame's back buffer was created or freed.  */
+    XftDrawChange (xft_draw, FRAME_X_DRAWABLE (f));
   return xft_draw;
 }
 
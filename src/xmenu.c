@@ -702,6 +702,24 @@ apply_systemfont_to_menu (struct frame *f, Widget w)
    The argument FIRST_TIME is currently ignored;
    it is set the first time this is called, from initialize_frame_menubar.  */
 
+/* Return a hash code of the names of the menu bar items in ITEMS.  */
+
+static EMACS_UINT
+menubar_names_hash (Lisp_Object items)
+{
+  EMACS_UINT hash = 0;
+  int i;
+
+  for (i = 0; i < ASIZE (items); i += 4)
+    {
+      Lisp_Object string = AREF (items, i + 1);
+      if (NILP (string))
+	break;
+      hash = sxhash_combine (hash, sxhash (string, 0));
+    }
+  return hash;
+}
+
 void
 set_frame_menubar (struct frame *f, bool first_time, bool deep_p)
 {
@@ -715,6 +733,7 @@ set_frame_menubar (struct frame *f, bool first_time, bool deep_p)
   int *submenu_start, *submenu_end;
   bool *submenu_top_level_items;
   int *submenu_n_panes;
+  EMACS_UINT names_hash;
 
   eassert (FRAME_X_P (f));
 
@@ -787,6 +806,7 @@ set_frame_menubar (struct frame *f, bool first_time, bool deep_p)
       fset_menu_bar_items (f, menu_bar_items (FRAME_MENU_BAR_ITEMS (f)));
 
       items = FRAME_MENU_BAR_ITEMS (f);
+      names_hash = menubar_names_hash (items);
 
       /* Save the frame's previous menu bar contents data.  */
       if (previous_menu_items_used)
@@ -895,6 +915,14 @@ set_frame_menubar (struct frame *f, bool first_time, bool deep_p)
     }
   else
     {
+      items = FRAME_MENU_BAR_ITEMS (f);
+
+      /* This is done after most commands, so don't touch the widgets
+	 if the names they show are still the right ones.  */
+      names_hash = menubar_names_hash (items);
+      if (names_hash == f->output_data.x->menubar_names_hash)
+	return;
+
       /* Make a widget-value tree containing
 	 just the top level menu bar strings.  */
 
@@ -902,7 +930,6 @@ set_frame_menubar (struct frame *f, bool first_time, bool deep_p)
       wv->button_type = BUTTON_TYPE_NONE;
       first_wv = wv;
 
-      items = FRAME_MENU_BAR_ITEMS (f);
       for (i = 0; i < ASIZE (items); i += 4)
 	{
 	  Lisp_Object string;
@@ -934,6 +961,8 @@ set_frame_menubar (struct frame *f, bool first_time, bool deep_p)
 
   /* Create or update the menu bar widget.  */
 
+  f->output_data.x->menubar_names_hash = names_hash;
+
   block_input ();
 
 #ifdef USE_GTK
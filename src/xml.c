@@ -23,6 +23,8 @@ along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.  */
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <libxml/HTMLparser.h>
+#include <libxml/parserInternals.h>
+#include <libxml/SAX2.h>
 
 #include "lisp.h"
 #include "character.h"
@@ -53,6 +55,18 @@ DEF_XML2_FN (xmlNodePtr, xmlDocGetRootElement, (xmlDocPtr));
 DEF_XML2_FN (void, xmlFreeDoc, (xmlDocPtr));
 DEF_XML2_FN (void, xmlCleanupParser, (void));
 DEF_XML2_FN (void, xmlCheckVersion, (int));
+DEF_XML2_FN (xmlParserCtxtPtr, xmlCreatePushParserCtxt,
+	     (xmlSAXHandlerPtr, void *, const char *, int, const char *));
+DEF_XML2_FN (htmlParserCtxtPtr, htmlCreatePushParserCtxt,
+	     (htmlSAXHandlerPtr, void *, const char *, int, const char *,
+	      xmlCharEncoding));
+DEF_XML2_FN (int, xmlParseChunk, (xmlParserCtxtPtr, const char *, int, int));
+DEF_XML2_FN (int, htmlParseChunk, (htmlParserCtxtPtr, const char *, int, int));
+DEF_XML2_FN (int, xmlCtxtUseOptions, (xmlParserCtxtPtr, int));
+DEF_XML2_FN (int, htmlCtxtUseOptions, (htmlParserCtxtPtr, int));
+DEF_XML2_FN (int, xmlSwitchEncoding, (xmlParserCtxtPtr, xmlCharEncoding));
+DEF_XML2_FN (void, xmlFreeParserCtxt, (xmlParserCtxtPtr));
+DEF_XML2_FN (int, xmlSAXVersion, (xmlSAXHandler *, int));
 
 static int
 libxml2_loaded_p (void)
@@ -72,6 +86,15 @@ libxml2_loaded_p (void)
 #define fn_xmlFreeDoc           xmlFreeDoc
 #define fn_xmlCleanupParser     xmlCleanupParser
 #define fn_xmlCheckVersion      xmlCheckVersion
+#define fn_xmlCreatePushParserCtxt  xmlCreatePushParserCtxt
+#define fn_htmlCreatePushParserCtxt htmlCreatePushParserCtxt
+#define fn_xmlParseChunk        xmlParseChunk
+#define fn_htmlParseChunk       htmlParseChunk
+#define fn_xmlCtxtUseOptions    xmlCtxtUseOptions
+#define fn_htmlCtxtUseOptions   htmlCtxtUseOptions
+#define fn_xmlSwitchEncoding    xmlSwitchEncoding
+#define fn_xmlFreeParserCtxt    xmlFreeParserCtxt
+#define fn_xmlSAXVersion        xmlSAXVersion
 
 static int
 libxml2_loaded_p (void)
@@ -105,6 +128,15 @@ init_libxml2_functions (void)
       LOAD_XML2_FN (library, xmlFreeDoc);
       LOAD_XML2_FN (library, xmlCleanupParser);
       LOAD_XML2_FN (library, xmlCheckVersion);
+      LOAD_XML2_FN (library, xmlCreatePushParserCtxt);
+      LOAD_XML2_FN (library, htmlCreatePushParserCtxt);
+      LOAD_XML2_FN (library, xmlParseChunk);
+      LOAD_XML2_FN (library, htmlParseChunk);
+      LOAD_XML2_FN (library, xmlCtxtUseOptions);
+      LOAD_XML2_FN (library, htmlCtxtUseOptions);
+      LOAD_XML2_FN (library, xmlSwitchEncoding);
+      LOAD_XML2_FN (library, xmlFreeParserCtxt);
+      LOAD_XML2_FN (library, xmlSAXVersion);
 
       Vlibrary_cache = Fcons (Fcons (Qlibxml2_dll, Qt), Vlibrary_cache);
       return 1;
@@ -242,6 +274,273 @@ parse_region (Lisp_Object start, Lisp_Object end, Lisp_Object base_url, int html
   return result;
 }
 
+/* Incremental parsing.  The region is fed to a libxml2 push parser a
+   chunk at a time, and SAX callbacks build only the nodes at or below
+   the level the caller asked for.  Finished nodes are queued and handed
+   to the Lisp callback between chunks, never from inside libxml2, so
+   that a non-local exit from the callback cannot leave the parser in
+   an inconsistent state.  */
+
+/* Bytes fed to the parser at a time.  */
+enum { XML_CHUNK_SIZE = 64 * 1024 };
+
+struct xml_stream
+{
+  /* Nesting level of the next node; the root element is at 0.  */
+  int depth;
+
+  /* Nodes at level TARGET go to the callback.  Nodes at level
+     MAX_DEPTH or deeper are dropped, unless MAX_DEPTH is negative.  */
+  int target, max_depth;
+
+  /* Elements under construction, innermost first.  Each is a list
+     (CHILDREN... ATTRIBUTES NAME) in reverse order.  */
+  Lisp_Object open;
+
+  /* Finished nodes at level TARGET, most recent first.  */
+  Lisp_Object done;
+
+  /* Character data not yet made into a string.  */
+  char *text;
+  ptrdiff_t text_len, text_size;
+};
+
+static bool
+xml_stream_wanted (struct xml_stream *s, int level)
+{
+  return level >= s->target && (s->max_depth < 0 || level < s->max_depth);
+}
+
+/* Add NODE, which is at LEVEL, to its parent or to the queue.  */
+
+static void
+xml_stream_add (struct xml_stream *s, int level, Lisp_Object node)
+{
+  if (level == s->target)
+    s->done = Fcons (node, s->done);
+  else
+    XSETCAR (s->open, Fcons (node, XCAR (s->open)));
+}
+
+/* Turn pending character data into a text node, unless it is all
+   blank; the non-incremental parser drops blank nodes too.  */
+
+static void
+xml_stream_flush_text (struct xml_stream *s)
+{
+  ptrdiff_t i;
+
+  for (i = 0; i < s->text_len; i++)
+    if (!(s->text[i] == ' ' || s->text[i] == '\t'
+	  || s->text[i] == '\n' || s->text[i] == '\r'))
+      {
+	xml_stream_add (s, s->depth, make_string (s->text, s->text_len));
+	break;
+      }
+  s->text_len = 0;
+}
+
+static void
+xml_stream_start_element (void *ctx, const xmlChar *name,
+			  const xmlChar **atts)
+{
+  struct xml_stream *s = ((xmlParserCtxtPtr) ctx)->_private;
+  int level;
+
+  xml_stream_flush_text (s);
+  level = s->depth++;
+  if (xml_stream_wanted (s, level))
+    {
+      Lisp_Object plist = Qnil;
+      int i;
+
+      for (i = 0; atts && atts[i]; i += 2)
+	if (atts[i + 1])
+	  plist = Fcons (Fcons (intern ((char *) atts[i]),
+				build_string ((char *) atts[i + 1])),
+			 plist);
+      s->open = Fcons (list2 (Fnreverse (plist), intern ((char *) name)),
+		       s->open);
+    }
+}
+
+static void
+xml_stream_end_element (void *ctx, const xmlChar *name)
+{
+  struct xml_stream *s = ((xmlParserCtxtPtr) ctx)->_private;
+  int level;
+
+  xml_stream_flush_text (s);
+  level = --s->depth;
+  if (xml_stream_wanted (s, level))
+    {
+      Lisp_Object element = Fnreverse (XCAR (s->open));
+      s->open = XCDR (s->open);
+      xml_stream_add (s, level, element);
+    }
+}
+
+static void
+xml_stream_characters (void *ctx, const xmlChar *ch, int len)
+{
+  struct xml_stream *s = ((xmlParserCtxtPtr) ctx)->_private;
+
+  if (xml_stream_wanted (s, s->depth))
+    {
+      if (s->text_size - s->text_len < len)
+	s->text = xpalloc (s->text, &s->text_size,
+			   len - (s->text_size - s->text_len), -1, 1);
+      memcpy (s->text + s->text_len, ch, len);
+      s->text_len += len;
+    }
+}
+
+static void
+xml_stream_comment (void *ctx, const xmlChar *value)
+{
+  struct xml_stream *s = ((xmlParserCtxtPtr) ctx)->_private;
+
+  xml_stream_flush_text (s);
+  if (xml_stream_wanted (s, s->depth))
+    xml_stream_add (s, s->depth,
+		    list3 (intern ("comment"), Qnil,
+			   build_string ((char *) value)));
+}
+
+static void
+free_stream_parser (void *ptr)
+{
+  xmlParserCtxtPtr ctxt = ptr;
+
+  if (ctxt->myDoc)
+    fn_xmlFreeDoc (ctxt->myDoc);
+  fn_xmlFreeParserCtxt (ctxt);
+}
+
+static Lisp_Object
+map_region (Lisp_Object start, Lisp_Object end, Lisp_Object function,
+	    Lisp_Object base_url, Lisp_Object depth, Lisp_Object max_depth,
+	    int htmlp)
+{
+  struct xml_stream s;
+  xmlSAXHandler sax;
+  xmlParserCtxtPtr ctxt;
+  const char *burl = "";
+  struct buffer *buf = current_buffer;
+  EMACS_INT modiff;
+  ptrdiff_t pos_byte, end_byte;
+
+  fn_xmlCheckVersion (LIBXML_VERSION);
+
+  validate_region (&start, &end);
+
+  if (! NILP (base_url))
+    {
+      CHECK_STRING (base_url);
+      burl = SSDATA (base_url);
+    }
+
+  s.depth = 0;
+  if (NILP (depth))
+    s.target = 1;
+  else
+    {
+      CHECK_RANGED_INTEGER (depth, 0, INT_MAX);
+      s.target = XINT (depth);
+    }
+  if (NILP (max_depth))
+    s.max_depth = -1;
+  else
+    {
+      CHECK_RANGED_INTEGER (max_depth, 0, INT_MAX);
+      s.max_depth = XINT (max_depth);
+    }
+  s.open = s.done = Qnil;
+  s.text = NULL;
+  s.text_len = s.text_size = 0;
+
+  /* Start from the default handlers, so that entities and the like
+     are handled as usual, but build no nodes except our own.  */
+  memset (&sax, 0, sizeof sax);
+  fn_xmlSAXVersion (&sax, 1);
+  sax.startElement = xml_stream_start_element;
+  sax.endElement = xml_stream_end_element;
+  sax.characters = xml_stream_characters;
+  sax.ignorableWhitespace = xml_stream_characters;
+  sax.cdataBlock = xml_stream_characters;
+  sax.comment = xml_stream_comment;
+  sax.reference = NULL;
+  sax.processingInstruction = NULL;
+
+  if (htmlp)
+    ctxt = fn_htmlCreatePushParserCtxt (&sax, NULL, NULL, 0, burl,
+					XML_CHAR_ENCODING_UTF8);
+  else
+    {
+      ctxt = fn_xmlCreatePushParserCtxt (&sax, NULL, NULL, 0, burl);
+      if (ctxt)
+	fn_xmlSwitchEncoding (ctxt, XML_CHAR_ENCODING_UTF8);
+    }
+  if (!ctxt)
+    return Qnil;
+
+  dynwind_begin ();
+  ctxt->_private = &s;
+  record_unwind_protect_ptr (free_stream_parser, ctxt);
+  record_unwind_current_buffer ();
+
+  if (htmlp)
+    fn_htmlCtxtUseOptions (ctxt,
+			   HTML_PARSE_RECOVER|HTML_PARSE_NONET|
+			   HTML_PARSE_NOWARNING|HTML_PARSE_NOERROR);
+  else
+    fn_xmlCtxtUseOptions (ctxt,
+			  XML_PARSE_NOENT|XML_PARSE_NONET|
+			  XML_PARSE_NOWARNING|XML_PARSE_NOERROR);
+
+  pos_byte = CHAR_TO_BYTE (XINT (start));
+  end_byte = CHAR_TO_BYTE (XINT (end));
+  modiff = BUF_MODIFF (buf);
+
+  for (;;)
+    {
+      /* Feed the text on one side of the gap at a time, so the gap
+	 need not be moved.  */
+      ptrdiff_t chunk_end = min (end_byte, pos_byte + XML_CHUNK_SIZE);
+      char *chunk;
+      bool last;
+      Lisp_Object nodes;
+
+      if (pos_byte < GPT_BYTE && GPT_BYTE < chunk_end)
+	chunk_end = GPT_BYTE;
+      last = chunk_end == end_byte;
+      chunk = (char *) BYTE_POS_ADDR (pos_byte);
+      if (htmlp)
+	fn_htmlParseChunk (ctxt, chunk, chunk_end - pos_byte, last);
+      else
+	fn_xmlParseChunk (ctxt, chunk, chunk_end - pos_byte, last);
+      pos_byte = chunk_end;
+
+      nodes = Fnreverse (s.done);
+      s.done = Qnil;
+      for (; CONSP (nodes); nodes = XCDR (nodes))
+	call1 (function, XCAR (nodes));
+
+      /* Stop at the end of the region, or once libxml2 has given up
+	 on a malformed document.  */
+      if (last || ctxt->disableSAX)
+	break;
+
+      if (!BUFFER_LIVE_P (buf) || BUF_MODIFF (buf) != modiff)
+	error ("Buffer modified during XML parsing");
+      set_buffer_internal (buf);
+      QUIT;
+    }
+
+  dynwind_end ();
+  return Qnil;
+}
+
 void
 xml_cleanup_parser (void)
 {
@@ -273,6 +572,43 @@ If BASE-URL is non-nil, it is used to expand relative URLs.  */)
   return Qnil;
 }
 
+DEFUN ("libxml-map-html-region", Flibxml_map_html_region,
+       Slibxml_map_html_region,
+       3, 6, 0,
+       doc: /* Parse the region as an HTML document, calling FUNCTION on its nodes.
+The region is parsed incrementally.  Each node at nesting level DEPTH
+is built as `libxml-parse-html-region' would build it, passed to
+FUNCTION, and then dropped, so memory use is bounded by the largest
+such node rather than by the whole document.  DEPTH defaults to 1,
+meaning the children of the root element; 0 means the root element
+itself.  The elements enclosing those nodes are not built at all.
+
+If MAX-DEPTH is non-nil, nodes that many levels or more below the root
+element are skipped, with their whole subtrees.
+If BASE-URL is non-nil, it is used to expand relative URLs.
+FUNCTION must not modify the buffer.  Return nil.  */)
+  (Lisp_Object start, Lisp_Object end, Lisp_Object function,
+   Lisp_Object base_url, Lisp_Object depth, Lisp_Object max_depth)
+{
+  if (init_libxml2_functions ())
+    return map_region (start, end, function, base_url, depth, max_depth, 1);
+  return Qnil;
+}
+
+DEFUN ("libxml-map-xml-region", Flibxml_map_xml_region,
+       Slibxml_map_xml_region,
+       3, 6, 0,
+       doc: /* Parse the region as an XML document, calling FUNCTION on its nodes.
+This is like `libxml-map-html-region', which see, but parses XML.
+Parsing stops at the first well-formedness error.  */)
+  (Lisp_Object start, Lisp_Object end, Lisp_Object function,
+   Lisp_Object base_url, Lisp_Object depth, Lisp_Object max_depth)
+{
+  if (init_libxml2_functions ())
+    return map_region (start, end, function, base_url, depth, max_depth, 0);
+  return Qnil;
+}
+
 
 /***********************************************************************
 			    Initialization
@@ -62,6 +62,8 @@ static Lisp_Object selection_data_to_lisp_data (Display *,
 static void lisp_data_to_selection_data (Display *, Lisp_Object,
                                          unsigned char **, Atom *,
 					 ptrdiff_t *, int *, int *);
+static bool x_handle_async_selection_notify (const XSelectionEvent *);
+static bool x_handle_async_property_notify (const XPropertyEvent *);
 
 /* Printing traces to stderr.  */
 
@@ -1144,6 +1146,9 @@ x_handle_property_notify (const XPropertyEvent *event)
 {
   struct prop_location *rest;
 
+  if (x_handle_async_property_notify (event))
+    return;
+
   for (rest = property_change_wait_list; rest; rest = rest->next)
     {
       if (!rest->arrived
@@ -1878,6 +1883,8 @@ clean_local_selection_data (Lisp_Object obj)
 void
 x_handle_selection_notify (const XSelectionEvent *event)
 {
+  if (x_handle_async_selection_notify (event))
+    return;
   if (event->requestor != reading_selection_window)
     return;
   if (event->selection != reading_which_selection)
@@ -1888,6 +1895,283 @@ x_handle_selection_notify (const XSelectionEvent *event)
 	   (event->property != 0 ? Qt : Qlambda));
 }
 
+/* Selection values being retrieved for x-request-selection-internal.
+   Unlike x_get_foreign_selection, these requests do not wait: the
+   SelectionNotify and PropertyNotify events of the transfer are
+   handled as they arrive, and the callback of the request is put on
+   pending_funcalls once the value is complete.  */
+
+struct async_selection
+{
+  Display *display;
+  Window window;
+  Atom selection, target, property;
+  Lisp_Object callback;
+
+  /* When the request was made, to drop requests whose owner never
+     answers.  */
+  struct timespec start;
+
+  /* True once the owner has started an INCR transfer.  DATA holds the
+     USED bytes received so far, in SIZE bytes of storage, of TYPE and
+     FORMAT.  */
+  bool incr;
+  unsigned char *data;
+  ptrdiff_t size, used;
+  Atom type;
+  int format;
+
+  /* The number in the name of PROPERTY.  */
+  int slot;
+
+  struct async_selection *next;
+};
+
+static struct async_selection *async_selections;
+
+/* Unlink REQ and arrange for its callback to be called with VALUE.  */
+
+static void
+async_selection_done (struct async_selection *req, Lisp_Object value)
+{
+  struct async_selection **p;
+
+  for (p = &async_selections; *p; p = &(*p)->next)
+    if (*p == req)
+      {
+	*p = req->next;
+	break;
+      }
+
+  /* Stop getting property changes if nobody else wants them.  */
+  if (req->incr && ! waiting_for_other_props_on_window (req->display,
+							   req->window))
+    {
+      struct async_selection *other;
+
+      for (other = async_selections; other; other = other->next)
+	if (other->incr && other->window == req->window)
+	  break;
+      if (!other)
+	{
+	  block_input ();
+	  XSelectInput (req->display, req->window, STANDARD_EVENT_SET);
+	  unblock_input ();
+	}
+    }
+
+  pending_funcalls = Fcons (list2 (req->callback, value), pending_funcalls);
+  xfree (req->data);
+  xfree (req);
+}
+
+/* Read the first reply to REQ, which the owner stored in its property.
+   This is either the value, or the start of an INCR transfer.  */
+
+static void
+async_selection_read (struct async_selection *req)
+{
+  struct x_display_info *dpyinfo = x_display_info_for_display (req->display);
+  unsigned char *data;
+  ptrdiff_t bytes;
+  Atom type;
+  int format;
+  unsigned long size;
+  Lisp_Object value;
+
+  x_get_window_property (req->display, req->window, req->property,
+			 &data, &bytes, &type, &format, &size, 1);
+  if (!data)
+    {
+      async_selection_done (req, Qnil);
+      return;
+    }
+
+  if (type == dpyinfo->Xatom_INCR)
+    {
+      unsigned int min_size_bytes = * ((unsigned int *) data);
+
+      TRACE1 ("Read %u bytes incrementally", min_size_bytes);
+      if (min (PTRDIFF_MAX, SIZE_MAX) < min_size_bytes)
+	memory_full (SIZE_MAX);
+      xfree (data);
+      req->incr = 1;
+      req->size = max (min_size_bytes, 1);
+      req->data = xmalloc_atomic (req->size);
+      req->used = 0;
+
+      /* Ask for the first chunk by deleting the property.  */
+      block_input ();
+      XSelectInput (req->display, req->window,
+		    STANDARD_EVENT_SET | PropertyChangeMask);
+      XDeleteProperty (req->display, req->window, req->property);
+      XFlush (req->display);
+      unblock_input ();
+      return;
+    }
+
+  block_input ();
+  XDeleteProperty (req->display, req->window, req->property);
+  XFlush (req->display);
+  unblock_input ();
+  value = selection_data_to_lisp_data (req->display, data, bytes,
+				       type, format);
+  xfree (data);
+  async_selection_done (req, value);
+}
+
+/* Handle the SelectionNotify EVENT if it answers an async request.
+   Return true if it does.  */
+
+static bool
+x_handle_async_selection_notify (const XSelectionEvent *event)
+{
+  struct async_selection *req;
+
+  for (req = async_selections; req; req = req->next)
+    if (!req->incr
+	&& req->display == event->display
+	&& req->window == event->requestor
+	&& req->selection == event->selection
+	&& req->target == event->target
+	&& (event->property == req->property || event->property == None))
+      {
+	TRACE0 ("Received SelectionNotify for async request");
+	if (event->property == None)
+	  async_selection_done (req, Qnil);
+	else
+	  async_selection_read (req);
+	return 1;
+      }
+
+  return 0;
+}
+
+/* Handle the PropertyNotify EVENT if it brings a chunk of an INCR
+   transfer to an async request.  Return true if it does.  */
+
+static bool
+x_handle_async_property_notify (const XPropertyEvent *event)
+{
+  struct async_selection *req;
+  unsigned char *data;
+  ptrdiff_t bytes;
+  unsigned long size;
+
+  if (event->state != PropertyNewValue)
+    return 0;
+
+  for (req = async_selections; req; req = req->next)
+    if (req->incr
+	&& req->display == event->display
+	&& req->window == event->window
+	&& req->property == event->atom)
+      break;
+  if (!req)
+    return 0;
+
+  x_get_window_property (req->display, req->window, req->property,
+			 &data, &bytes, &req->type, &req->format, &size, 1);
+  TRACE1 ("  Read increment of %"pD"d bytes", bytes);
+
+  /* Deleting the property acknowledges the chunk.  */
+  block_input ();
+  XDeleteProperty (req->display, req->window, req->property);
+  XFlush (req->display);
+  unblock_input ();
+
+  if (bytes == 0)
+    {
+      TRACE0 ("Done reading incrementally");
+      xfree (data);
+      async_selection_done (req,
+			    selection_data_to_lisp_data (req->display,
+							 req->data, req->used,
+							 req->type,
+							 req->format));
+      return 1;
+    }
+
+  if (req->size - req->used < bytes)
+    req->data = xpalloc (req->data, &req->size,
+			 bytes - (req->size - req->used), -1, 1);
+  memcpy (req->data + req->used, data, bytes);
+  req->used += bytes;
+  xfree (data);
+  return 1;
+}
+
+/* Request the value of SELECTION_SYMBOL as TARGET_TYPE for frame F,
+   without waiting.  CALLBACK will be called with the value.  */
+
+static void
+x_request_foreign_selection (Lisp_Object selection_symbol,
+			     Lisp_Object target_type, Lisp_Object time_stamp,
+			     Lisp_Object callback, struct frame *f)
+{
+  struct x_display_info *dpyinfo = FRAME_DISPLAY_INFO (f);
+  struct async_selection *req, **p;
+  Time requestor_time = dpyinfo->last_user_time;
+  struct timespec now = current_timespec ();
+  EMACS_INT timeout = max (0, x_selection_timeout);
+  struct timespec limit = make_timespec (timeout / 1000,
+					 (timeout % 1000) * 1000000);
+  char name[sizeof "_EMACS_ASYNC_" + INT_STRLEN_BOUND (int)];
+  int slot;
+
+  if (! NILP (time_stamp))
+    CONS_TO_INTEGER (time_stamp, Time, requestor_time);
+
+  /* Forget requests whose owner did not answer in time;
+     `x-get-selection-async' has already told their callbacks.  */
+  for (p = &async_selections; *p; )
+    if (timeout > 0
+	&& timespec_cmp (timespec_add ((*p)->start, limit), now) < 0)
+      {
+	req = *p;
+	*p = req->next;
+	xfree (req->data);
+	xfree (req);
+      }
+    else
+      p = &(*p)->next;
+
+  /* Each pending request on a display gets a property of its own, so
+     that the transfers do not mix.  */
+  for (slot = 0; ; slot++)
+    {
+      for (req = async_selections; req; req = req->next)
+	if (req->display == dpyinfo->display && req->slot == slot)
+	  break;
+      if (!req)
+	break;
+    }
+
+  req = xzalloc (sizeof *req);
+  req->display = dpyinfo->display;
+  req->window = FRAME_X_WINDOW (f);
+  req->selection = symbol_to_x_atom (dpyinfo, selection_symbol);
+  req->target = symbol_to_x_atom (dpyinfo, target_type);
+  req->callback = callback;
+  req->start = now;
+  req->slot = slot;
+  sprintf (name, "_EMACS_ASYNC_%d", slot);
+
+  block_input ();
+  req->property = XInternAtom (req->display, name, False);
+  TRACE2 ("Request selection %s, type %s without waiting",
+	  XGetAtomName (req->display, req->selection),
+	  XGetAtomName (req->display, req->target));
+  x_catch_errors (req->display);
+  XConvertSelection (req->display, req->selection, req->target,
+		     req->property, req->window, requestor_time);
+  x_check_errors (req->display, "Can't convert selection: %s");
+  x_uncatch_errors ();
+  req->next = async_selections;
+  async_selections = req;
+  unblock_input ();
+}
+
 
 /* From a Lisp_Object, return a suitable frame for selection
    operations.  OBJECT may be a frame, a terminal object, or nil
@@ -2015,6 +2299,50 @@ On Nextstep, TIME-STAMP and TERMINAL are unused.  */)
   return clean_local_selection_data (val);
 }
 
+DEFUN ("x-request-selection-internal", Fx_request_selection_internal,
+       Sx_request_selection_internal, 3, 5, 0,
+       doc: /* Request text selected from some X window, without waiting.
+Arrange for CALLBACK to be called with the value of the selection, or
+with nil if it cannot be converted, once it has arrived.  Large
+selections arrive in chunks while Emacs goes on with other work.
+
+SELECTION-SYMBOL, TARGET-TYPE, TIME-STAMP and TERMINAL are as for
+`x-get-selection-internal'.  If the selection owner does not answer,
+CALLBACK is never called; `x-get-selection-async' handles this.  */)
+  (Lisp_Object selection_symbol, Lisp_Object target_type,
+   Lisp_Object callback, Lisp_Object time_stamp, Lisp_Object terminal)
+{
+  Lisp_Object val;
+  struct frame *f = frame_for_x_selection (terminal);
+
+  CHECK_SYMBOL (selection_symbol);
+  CHECK_SYMBOL (target_type);
+  if (EQ (target_type, QMULTIPLE))
+    error ("Retrieving MULTIPLE selections is currently unimplemented");
+  if (!f)
+    error ("X selection unavailable for this frame");
+
+  val = x_get_local_selection (selection_symbol, target_type, 1,
+			       FRAME_DISPLAY_INFO (f));
+
+  if (NILP (val) && FRAME_LIVE_P (f))
+    {
+      x_request_foreign_selection (selection_symbol, target_type, time_stamp,
+				   callback, f);
+      return Qnil;
+    }
+
+  if (CONSP (val) && SYMBOLP (XCAR (val)))
+    {
+      val = XCDR (val);
+      if (CONSP (val) && NILP (XCDR (val)))
+	val = XCAR (val);
+    }
+  pending_funcalls = Fcons (list2 (callback, clean_local_selection_data (val)),
+			    pending_funcalls);
+  return Qnil;
+}
+
 DEFUN ("x-disown-selection-internal", Fx_disown_selection_internal,
        Sx_disown_selection_internal, 1, 3, 0,
        doc: /* If we own the selection SELECTION, disown it.
@@ -2620,6 +2948,7 @@ syms_of_xselect (void)
 
   property_change_wait_list = 0;
   prop_location_identifier = 0;
+  async_selections = NULL;
   property_change_reply = Fcons (Qnil, Qnil);
   staticpro (&property_change_reply);
 
@@ -246,6 +246,9 @@ static void x_clip_to_row (struct window *, struct glyph_row *,
 static void x_flush (struct frame *f);
 static void x_update_begin (struct frame *);
 static void x_update_window_begin (struct window *);
+static void x_flush_pending_clear (struct frame *);
+static void x_note_damage (struct frame *, int, int, int, int);
+static void x_show_back_buffer (struct frame *);
 static struct scroll_bar *x_window_to_scroll_bar (Display *, Window);
 static void x_scroll_bar_report_motion (struct frame **, Lisp_Object *,
                                         enum scroll_bar_part *,
@@ -281,6 +284,7 @@ x_flush (struct frame *f)
     return;
 
   block_input ();
+  x_show_back_buffer (f);
   XFlush (FRAME_X_DISPLAY (f));
   unblock_input ();
 }
@@ -295,6 +299,120 @@ x_flush (struct frame *f)
 
 #define XFlush(DISPLAY)	(void) 0
 
+
+/***********************************************************************
+			      Back Buffers
+ ***********************************************************************/
+
+/* When `x-double-buffer' is non-nil, a frame is drawn into a pixmap
+   of its size, its back buffer, rather than into its window.  The
+   area drawn into is remembered as the frame's damage and copied to
+   the window in one request when the frame has been updated, so that
+   the window never shows an update half done.  */
+
+/* Create or free the back buffer of frame F, as `x-double-buffer'
+   says, and make sure it has F's size.  Called when an update of F
+   begins.  */
+
+static void
+x_update_back_buffer (struct frame *f)
+{
+  struct x_output *output = f->output_data.x;
+  Display *dpy = FRAME_X_DISPLAY (f);
+  int width = FRAME_PIXEL_WIDTH (f);
+  int height = FRAME_PIXEL_HEIGHT (f);
+
+  if (output->back_buffer
+      && (!x_double_buffer
+	  || output->back_buffer_width != width
+	  || output->back_buffer_height != height))
+    {
+      x_show_back_buffer (f);
+      XFreePixmap (dpy, output->back_buffer);
+      output->back_buffer = 0;
+    }
+
+  if (x_double_buffer && !output->back_buffer
+      && FRAME_X_WINDOW (f) && width > 0 && height > 0)
+    {
+      if (!output->back_buffer_gc)
+	{
+	  XGCValues xgcv;
+
+	  xgcv.graphics_exposures = False;
+	  output->back_buffer_gc = XCreateGC (dpy, FRAME_X_WINDOW (f),
+					      GCGraphicsExposures, &xgcv);
+	}
+      output->back_buffer
+	= XCreatePixmap (dpy, FRAME_X_WINDOW (f), width, height,
+			 FRAME_DISPLAY_INFO (f)->n_planes);
+      output->back_buffer_width = width;
+      output->back_buffer_height = height;
+      output->damage.width = 0;
+
+      /* Start with what the window shows, because only the parts that
+	 change are drawn again.  Parts of the window that are obscured
+	 now are drawn again when they are exposed.  */
+      XCopyArea (dpy, FRAME_X_WINDOW (f), output->back_buffer,
+		 output->back_buffer_gc, 0, 0, width, height, 0, 0);
+    }
+}
+
+
+/* Note that the area of frame F at X, Y of size WIDTH x HEIGHT has
+   been drawn into.  Do nothing if F has no back buffer.  */
+
+static void
+x_note_damage (struct frame *f, int x, int y, int width, int height)
+{
+  struct x_output *output = f->output_data.x;
+  XRectangle *r = &output->damage;
+  int right = x + width, bottom = y + height;
+
+  if (!output->back_buffer || width <= 0 || height <= 0)
+    return;
+
+  if (r->width > 0)
+    {
+      x = min (x, r->x);
+      y = min (y, r->y);
+      right = max (right, r->x + r->width);
+      bottom = max (bottom, r->y + r->height);
+    }
+  x = max (x, 0);
+  y = max (y, 0);
+  right = min (right, output->back_buffer_width);
+  bottom = min (bottom, output->back_buffer_height);
+
+  if (right > x && bottom > y)
+    {
+      r->x = x;
+      r->y = y;
+      r->width = right - x;
+      r->height = bottom - y;
+    }
+}
+
+
+/* Copy the damaged area of the back buffer of frame F, if any, to
+   F's window.  Do nothing while F is being updated; the update is
+   shown when it is complete.  */
+
+static void
+x_show_back_buffer (struct frame *f)
+{
+  struct x_output *output = f->output_data.x;
+  XRectangle *r = &output->damage;
+
+  if (output->back_buffer && r->width > 0 && !output->defer_clears_p)
+    {
+      XCopyArea (FRAME_X_DISPLAY (f), output->back_buffer,
+		 FRAME_X_WINDOW (f), output->back_buffer_gc,
+		 r->x, r->y, r->width, r->height, r->x, r->y);
+      r->width = 0;
+    }
+}
+
 
 /***********************************************************************
 			      Debugging
@@ -462,13 +580,18 @@ x_display_pixel_width (struct x_display_info *dpyinfo)
 /* Start an update of frame F.  This function is installed as a hook
    for update_begin, i.e. it is called when update_begin is called.
    This function is called prior to calls to x_update_window_begin for
-   each window being updated.  Currently, there is nothing to do here
-   because all interesting stuff is done on a window basis.  */
+   each window being updated.  Most interesting stuff is done on a
+   window basis; here we only set up the back buffer, and start
+   deferring clears, so that the clears of adjacent rows can be
+   merged.  */
 
 static void
 x_update_begin (struct frame *f)
 {
-  /* Nothing to do.  */
+  block_input ();
+  x_update_back_buffer (f);
+  unblock_input ();
+  f->output_data.x->defer_clears_p = 1;
 }
 
 
@@ -507,13 +630,16 @@ x_draw_vertical_window_border (struct window *w, int x, int y0, int y1)
   struct frame *f = XFRAME (WINDOW_FRAME (w));
   struct face *face;
 
+  x_flush_pending_clear (f);
+
   face = FACE_FROM_ID (f, VERTICAL_BORDER_FACE_ID);
   if (face)
     XSetForeground (FRAME_X_DISPLAY (f), f->output_data.x->normal_gc,
 		    face->foreground);
 
-  XDrawLine (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
+  XDrawLine (FRAME_X_DISPLAY (f), FRAME_X_DRAWABLE (f),
 	     f->output_data.x->normal_gc, x, y0, x, y1);
+  x_note_damage (f, x, y0, 1, y1 - y0 + 1);
 }
 
 /* Draw a window divider from (x0,y0) to (x1,y1)  */
@@ -533,38 +659,41 @@ x_draw_window_divider (struct window *w, int x0, int x1, int y0, int y1)
 			      ? face_last->foreground
 			      : FRAME_FOREGROUND_PIXEL (f));
   Display *display = FRAME_X_DISPLAY (f);
-  Window window = FRAME_X_WINDOW (f);
+  Drawable drawable = FRAME_X_DRAWABLE (f);
+
+  x_flush_pending_clear (f);
+  x_note_damage (f, x0, y0, x1 - x0, y1 - y0);
 
   if (y1 - y0 > x1 - x0 && x1 - x0 > 2)
     /* Vertical.  */
     {
       XSetForeground (display, f->output_data.x->normal_gc, color_first);
-      XFillRectangle (display, window, f->output_data.x->normal_gc,
+      XFillRectangle (display, drawable, f->output_data.x->normal_gc,
 		      x0, y0, 1, y1 - y0);
       XSetForeground (display, f->output_data.x->normal_gc, color);
-      XFillRectangle (display, window, f->output_data.x->normal_gc,
+      XFillRectangle (display, drawable, f->output_data.x->normal_gc,
 		      x0 + 1, y0, x1 - x0 - 2, y1 - y0);
       XSetForeground (display, f->output_data.x->normal_gc, color_last);
-      XFillRectangle (display, window, f->output_data.x->normal_gc,
+      XFillRectangle (display, drawable, f->output_data.x->normal_gc,
 		      x1 - 1, y0, 1, y1 - y0);
     }
   else if (x1 - x0 > y1 - y0 && y1 - y0 > 3)
     /* Horizontal.  */
     {
       XSetForeground (display, f->output_data.x->normal_gc, color_first);
-      XFillRectangle (display, window, f->output_data.x->normal_gc,
+      XFillRectangle (display, drawable, f->output_data.x->normal_gc,
 		      x0, y0, x1 - x0, 1);
       XSetForeground (display, f->output_data.x->normal_gc, color);
-      XFillRectangle (display, window, f->output_data.x->normal_gc,
+      XFillRectangle (display, drawable, f->output_data.x->normal_gc,
 		      x0, y0 + 1, x1 - x0, y1 - y0 - 2);
       XSetForeground (display, f->output_data.x->normal_gc, color_last);
-      XFillRectangle (display, window, f->output_data.x->normal_gc,
+      XFillRectangle (display, drawable, f->output_data.x->normal_gc,
 		      x0, y1 - 1, x1 - x0, 1);
     }
   else
     {
       XSetForeground (display, f->output_data.x->normal_gc, color);
-      XFillRectangle (display, window, f->output_data.x->normal_gc,
+      XFillRectangle (display, drawable, f->output_data.x->normal_gc,
 		      x0, y0, x1 - x0, y1 - y0);
     }
 }
@@ -590,6 +719,8 @@ x_update_window_end (struct window *w, bool cursor_on_p,
     {
       block_input ();
 
+      x_flush_pending_clear (XFRAME (w->frame));
+
       if (cursor_on_p)
 	display_and_set_cursor (w, 1,
 				w->output_cursor.hpos, w->output_cursor.vpos,
@@ -628,6 +759,12 @@ x_update_end (struct frame *f)
   /* Mouse highlight may be displayed again.  */
   MOUSE_HL_INFO (f)->mouse_face_defer = 0;
 
+  block_input ();
+  x_flush_pending_clear (f);
+  f->output_data.x->defer_clears_p = 0;
+  x_show_back_buffer (f);
+  unblock_input ();
+
 #ifndef XFlush
   block_input ();
   XFlush (FRAME_X_DISPLAY (f));
@@ -643,7 +780,12 @@ static void
 XTframe_up_to_date (struct frame *f)
 {
   if (FRAME_X_P (f))
-    FRAME_MOUSE_UPDATE (f);
+    {
+      FRAME_MOUSE_UPDATE (f);
+      block_input ();
+      x_show_back_buffer (f);
+      unblock_input ();
+    }
 }
 
 
@@ -656,18 +798,16 @@ x_clear_under_internal_border (struct frame *f)
 {
   if (FRAME_INTERNAL_BORDER_WIDTH (f) > 0)
     {
-      Display *display = FRAME_X_DISPLAY (f);
-      Window window = FRAME_X_WINDOW (f);
       int border = FRAME_INTERNAL_BORDER_WIDTH (f);
       int width = FRAME_PIXEL_WIDTH (f);
       int height = FRAME_PIXEL_HEIGHT (f);
       int margin = FRAME_TOP_MARGIN_HEIGHT (f);
 
       block_input ();
-      x_clear_area (display, window, 0, 0, border, height);
-      x_clear_area (display, window, 0, margin, width, border);
-      x_clear_area (display, window, width - border, 0, border, height);
-      x_clear_area (display, window, 0, height - border, width, border);
+      x_clear_area (f, 0, 0, border, height);
+      x_clear_area (f, 0, margin, width, border);
+      x_clear_area (f, width - border, 0, border, height);
+      x_clear_area (f, 0, height - border, width, border);
       unblock_input ();
     }
 }
@@ -709,26 +849,96 @@ x_after_update_window_line (struct window *w, struct glyph_row *desired_row)
 	int y = WINDOW_TO_FRAME_PIXEL_Y (w, max (0, desired_row->y));
 
 	block_input ();
-	x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
-		      0, y, width, height);
-	x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
-		      FRAME_PIXEL_WIDTH (f) - width,
-		      y, width, height);
+	x_clear_area (f, 0, y, width, height);
+	x_clear_area (f, FRAME_PIXEL_WIDTH (f) - width, y, width, height);
 	unblock_input ();
       }
   }
 #endif
 }
 
+/* Return the cache entry of DPYINFO for drawing fringe bitmap WHICH,
+   made of BITS, of size WD x H, in colors FOREGROUND and BACKGROUND.
+   Create the pixmap if it is not cached.  */
+
+static struct x_fringe_pixmap *
+x_fringe_pixmap (struct x_display_info *dpyinfo, int which, const char *bits,
+		 int wd, int h, unsigned long foreground,
+		 unsigned long background)
+{
+  size_t hash = (((uintptr_t) bits >> 1) ^ h
+		 ^ (foreground * 31) ^ (background * 7));
+  struct x_fringe_pixmap *e
+    = &dpyinfo->fringe_pixmaps[hash % ARRAYELTS (dpyinfo->fringe_pixmaps)];
+  int depth = DefaultDepthOfScreen (dpyinfo->screen);
+
+  if (e->bits == bits && e->which == which && e->wd == wd && e->h == h
+      && e->foreground == foreground && e->background == background)
+    return e;
+
+  if (e->bits)
+    {
+      XFreePixmap (dpyinfo->display, e->pixmap);
+      if (e->clipmask)
+	XFreePixmap (dpyinfo->display, e->clipmask);
+    }
+  e->which = which;
+  e->bits = bits;
+  e->wd = wd;
+  e->h = h;
+  e->foreground = foreground;
+  e->background = background;
+  e->pixmap = XCreatePixmapFromBitmapData (dpyinfo->display,
+					   dpyinfo->root_window,
+					   (char *) bits, wd, h,
+					   foreground, background, depth);
+  e->clipmask = 0;
+  return e;
+}
+
+/* Forget the cached pixmaps of fringe bitmap WHICH, which is being
+   redefined or destroyed.  */
+
+static void
+x_destroy_fringe_bitmap (int which)
+{
+  struct x_display_info *dpyinfo;
+  int i;
+
+  block_input ();
+  for (dpyinfo = x_display_list; dpyinfo; dpyinfo = dpyinfo->next)
+    for (i = 0; i < ARRAYELTS (dpyinfo->fringe_pixmaps); i++)
+      {
+	struct x_fringe_pixmap *e = &dpyinfo->fringe_pixmaps[i];
+
+	if (e->bits && e->which == which)
+	  {
+	    XFreePixmap (dpyinfo->display, e->pixmap);
+	    if (e->clipmask)
+	      XFreePixmap (dpyinfo->display, e->clipmask);
+	    e->bits = NULL;
+	  }
+      }
+  unblock_input ();
+}
+
+static void
+x_define_fringe_bitmap (int which, unsigned short *bits, int h, int wd)
+{
+  x_destroy_fringe_bitmap (which);
+}
+
 static void
 x_draw_fringe_bitmap (struct window *w, struct glyph_row *row, struct draw_fringe_bitmap_params *p)
 {
   struct frame *f = XFRAME (WINDOW_FRAME (w));
   Display *display = FRAME_X_DISPLAY (f);
-  Window window = FRAME_X_WINDOW (f);
+  Drawable drawable = FRAME_X_DRAWABLE (f);
   GC gc = f->output_data.x->normal_gc;
   struct face *face = p->face;
 
+  x_flush_pending_clear (f);
+
   /* Must clip because of partially visible lines.  */
   x_clip_to_row (w, row, ANY_AREA, gc);
 
@@ -743,7 +953,7 @@ x_draw_fringe_bitmap (struct window *w, struct glyph_row *row, struct draw_fring
       else
 	XSetForeground (display, face->gc, face->background);
 
-      XFillRectangle (display, window, face->gc,
+      XFillRectangle (display, drawable, face->gc,
 		      p->bx, p->by, p->nx, p->ny);
 
       if (!face->stipple)
@@ -753,8 +963,7 @@ x_draw_fringe_bitmap (struct window *w, struct glyph_row *row, struct draw_fring
   if (p->which)
     {
       char *bits;
-      Pixmap pixmap, clipmask = (Pixmap) 0;
-      int depth = DefaultDepthOfScreen (FRAME_X_SCREEN (f));
+      struct x_fringe_pixmap *cached;
       XGCValues gcv;
 
       if (p->wd > 8)
@@ -762,36 +971,37 @@ x_draw_fringe_bitmap (struct window *w, struct glyph_row *row, struct draw_fring
       else
 	bits = (char *) p->bits + p->dh;
 
-      /* Draw the bitmap.  I believe these small pixmaps can be cached
-	 by the server.  */
-      pixmap = XCreatePixmapFromBitmapData (display, window, bits, p->wd, p->h,
-					    (p->cursor_p
-					     ? (p->overlay_p ? face->background
-						: f->output_data.x->cursor_pixel)
-					     : face->foreground),
-					    face->background, depth);
+      /* Fringe indicators on many lines draw the same few bitmaps over
+	 and over, so keep their pixmaps on the server.  */
+      cached = x_fringe_pixmap (FRAME_DISPLAY_INFO (f), p->which, bits,
+				p->wd, p->h,
+				(p->cursor_p
+				 ? (p->overlay_p ? face->background
+				    : f->output_data.x->cursor_pixel)
+				 : face->foreground),
+				face->background);
 
       if (p->overlay_p)
 	{
-	  clipmask = XCreatePixmapFromBitmapData (display,
-						  FRAME_DISPLAY_INFO (f)->root_window,
-						  bits, p->wd, p->h,
-						  1, 0, 1);
-	  gcv.clip_mask = clipmask;
+	  if (!cached->clipmask)
+	    cached->clipmask
+	      = XCreatePixmapFromBitmapData (display,
+					     FRAME_DISPLAY_INFO (f)->root_window,
+					     bits, p->wd, p->h,
+					     1, 0, 1);
+	  gcv.clip_mask = cached->clipmask;
 	  gcv.clip_x_origin = p->x;
 	  gcv.clip_y_origin = p->y;
 	  XChangeGC (display, gc, GCClipMask | GCClipXOrigin | GCClipYOrigin, &gcv);
 	}
 
-      XCopyArea (display, pixmap, window, gc, 0, 0,
+      XCopyArea (display, cached->pixmap, drawable, gc, 0, 0,
 		 p->wd, p->h, p->x, p->y);
-      XFreePixmap (display, pixmap);
 
       if (p->overlay_p)
 	{
 	  gcv.clip_mask = (Pixmap) 0;
 	  XChangeGC (display, gc, GCClipMask, &gcv);
-	  XFreePixmap (display, clipmask);
 	}
     }
 
@@ -1003,7 +1213,15 @@ x_set_glyph_string_clipping (struct glyph_string *s)
   int n = get_glyph_string_clip_rects (s, r, 2);
 
   if (n > 0)
-    XSetClipRectangles (s->display, s->gc, 0, 0, r, n, Unsorted);
+    {
+      int i;
+
+      XSetClipRectangles (s->display, s->gc, 0, 0, r, n, Unsorted);
+      for (i = 0; i < n; i++)
+	x_note_damage (s->f, r[i].x, r[i].y, r[i].width, r[i].height);
+    }
+  else
+    x_note_damage (s->f, s->x, s->y, s->background_width, s->height);
   s->num_clips = n;
 }
 
@@ -1024,6 +1242,7 @@ x_set_glyph_string_clipping_exactly (struct glyph_string *src, struct glyph_stri
   dst->clip[0] = r;
   dst->num_clips = 1;
   XSetClipRectangles (dst->display, dst->gc, 0, 0, &r, 1, Unsorted);
+  x_note_damage (dst->f, r.x, r.y, r.width, r.height);
 }
 
 
@@ -1314,7 +1533,7 @@ x_draw_glyphless_glyph_string_foreground (struct glyph_string *s)
 	  /* It is assured that all LEN characters in STR is ASCII.  */
 	  for (j = 0; j < len; j++)
 	    {
-	      code = s->font->driver->encode_char (s->font, str[j]);
+	      code = font_glyph_code (s->font, str[j]);
 	      STORE_XCHAR2B (char2b + j, code >> 8, code & 0xFF);
 	    }
 	  s->font->driver->draw (s, 0, upper_len,
@@ -1611,6 +1830,22 @@ static bool
 x_alloc_nearest_color_1 (Display *dpy, Colormap cmap, XColor *color)
 {
   bool rc;
+  struct x_display_info *dpyinfo = x_display_info_for_display (dpy);
+
+  /* On TrueColor visuals, pixel values specify RGB values directly,
+     so compose the pixel here instead of asking the server, as
+     lookup_rgb_color in image.c does.  */
+  if (dpyinfo && dpyinfo->red_bits > 0)
+    {
+      color->pixel
+	= (((unsigned long) (color->red >> (16 - dpyinfo->red_bits))
+	    << dpyinfo->red_offset)
+	   | ((unsigned long) (color->green >> (16 - dpyinfo->green_bits))
+	      << dpyinfo->green_offset)
+	   | ((unsigned long) (color->blue >> (16 - dpyinfo->blue_bits))
+	      << dpyinfo->blue_offset));
+      return 1;
+    }
 
   rc = XAllocColor (dpy, cmap, color) != 0;
   if (rc == 0)
@@ -1650,7 +1885,6 @@ x_alloc_nearest_color_1 (Display *dpy, Colormap cmap, XColor *color)
       /* If allocation succeeded, and the allocated pixel color is not
          equal to a cached pixel color recorded earlier, there was a
          change in the colormap, so clear the color cache.  */
-      struct x_display_info *dpyinfo = x_display_info_for_display (dpy);
       XColor *cached_color;
 
       if (dpyinfo->color_cells
@@ -1899,7 +2133,7 @@ x_draw_relief_rect (struct frame *f,
 		    XRectangle *clip_rect)
 {
   Display *dpy = FRAME_X_DISPLAY (f);
-  Window window = FRAME_X_WINDOW (f);
+  Drawable drawable = FRAME_X_DRAWABLE (f);
   int i;
   GC gc;
 
@@ -1918,12 +2152,12 @@ x_draw_relief_rect (struct frame *f,
   if (top_p)
     {
       if (width == 1)
-	XDrawLine (dpy, window, gc,
+	XDrawLine (dpy, drawable, gc,
 		   left_x  + (left_p  ? 1 : 0), top_y,
 		   right_x + (right_p ? 0 : 1), top_y);
 
       for (i = 1; i < width; ++i)
-	XDrawLine (dpy, window, gc,
+	XDrawLine (dpy, drawable, gc,
 		   left_x  + i * left_p, top_y + i,
 		   right_x + 1 - i * right_p, top_y + i);
     }
@@ -1932,13 +2166,13 @@ x_draw_relief_rect (struct frame *f,
   if (left_p)
     {
       if (width == 1)
-	XDrawLine (dpy, window, gc, left_x, top_y + 1, left_x, bottom_y);
+	XDrawLine (dpy, drawable, gc, left_x, top_y + 1, left_x, bottom_y);
 
-      XClearArea (dpy, window, left_x, top_y, 1, 1, False);
-      XClearArea (dpy, window, left_x, bottom_y, 1, 1, False);
+      x_clear_area (f, left_x, top_y, 1, 1);
+      x_clear_area (f, left_x, bottom_y, 1, 1);
 
       for (i = (width > 1 ? 1 : 0); i < width; ++i)
-	XDrawLine (dpy, window, gc,
+	XDrawLine (dpy, drawable, gc,
 		   left_x + i, top_y + (i + 1) * top_p,
 		   left_x + i, bottom_y + 1 - (i + 1) * bot_p);
     }
@@ -1954,23 +2188,23 @@ x_draw_relief_rect (struct frame *f,
     {
       /* Outermost top line.  */
       if (top_p)
-	XDrawLine (dpy, window, gc,
+	XDrawLine (dpy, drawable, gc,
 		   left_x  + (left_p  ? 1 : 0), top_y,
 		   right_x + (right_p ? 0 : 1), top_y);
 
       /* Outermost left line.  */
       if (left_p)
-	XDrawLine (dpy, window, gc, left_x, top_y + 1, left_x, bottom_y);
+	XDrawLine (dpy, drawable, gc, left_x, top_y + 1, left_x, bottom_y);
     }
 
   /* Bottom.  */
   if (bot_p)
     {
-      XDrawLine (dpy, window, gc,
+      XDrawLine (dpy, drawable, gc,
 		 left_x  + (left_p  ? 1 : 0), bottom_y,
 		 right_x + (right_p ? 0 : 1), bottom_y);
       for (i = 1; i < width; ++i)
-	XDrawLine (dpy, window, gc,
+	XDrawLine (dpy, drawable, gc,
 		   left_x  + i * left_p, bottom_y - i,
 		   right_x + 1 - i * right_p, bottom_y - i);
     }
@@ -1978,10 +2212,10 @@ x_draw_relief_rect (struct frame *f,
   /* Right.  */
   if (right_p)
     {
-      XClearArea (dpy, window, right_x, top_y, 1, 1, False);
-      XClearArea (dpy, window, right_x, bottom_y, 1, 1, False);
+      x_clear_area (f, right_x, top_y, 1, 1);
+      x_clear_area (f, right_x, bottom_y, 1, 1);
       for (i = 0; i < width; ++i)
-	XDrawLine (dpy, window, gc,
+	XDrawLine (dpy, drawable, gc,
 		   right_x - i, top_y + (i + 1) * top_p,
 		   right_x - i, bottom_y + 1 - (i + 1) * bot_p);
     }
@@ -2632,6 +2866,8 @@ x_draw_glyph_string (struct glyph_string *s)
 {
   bool relief_drawn_p = 0;
 
+  x_flush_pending_clear (s->f);
+
   /* If S draws into the background of its successors, draw the
      background of the successors first so that S can draw into it.
      This makes S->next use XDrawString instead of XDrawImageString.  */
@@ -2909,10 +3145,12 @@ x_draw_glyph_string (struct glyph_string *s)
 static void
 x_shift_glyphs_for_insert (struct frame *f, int x, int y, int width, int height, int shift_by)
 {
-  XCopyArea (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f), FRAME_X_WINDOW (f),
+  x_flush_pending_clear (f);
+  XCopyArea (FRAME_X_DISPLAY (f), FRAME_X_DRAWABLE (f), FRAME_X_DRAWABLE (f),
 	     f->output_data.x->normal_gc,
 	     x, y, width, height,
 	     x + shift_by, y);
+  x_note_damage (f, x + shift_by, y, width, height);
 }
 
 /* Delete N glyphs at the nominal cursor position.  Not implemented
@@ -2925,14 +3163,49 @@ x_delete_glyphs (struct frame *f, register int n)
 }
 
 
-/* Like XClearArea, but check that WIDTH and HEIGHT are reasonable.
-   If they are <= 0, this is probably an error.  */
+/* Clear an area of frame F, like XClearArea on its window, but check
+   that WIDTH and HEIGHT are reasonable.  If they are <= 0, this is
+   probably an error.  If F has a back buffer, fill the area of the
+   back buffer with the background color instead.  */
 
 void
-x_clear_area (Display *dpy, Window window, int x, int y, int width, int height)
+x_clear_area (struct frame *f, int x, int y, int width, int height)
 {
   eassert (width > 0 && height > 0);
-  XClearArea (dpy, window, x, y, width, height, False);
+  if (f->output_data.x->back_buffer)
+    {
+      GC gc = f->output_data.x->back_buffer_gc;
+
+      XSetForeground (FRAME_X_DISPLAY (f), gc, FRAME_BACKGROUND_PIXEL (f));
+      XFillRectangle (FRAME_X_DISPLAY (f), f->output_data.x->back_buffer,
+		      gc, x, y, width, height);
+      x_note_damage (f, x, y, width, height);
+    }
+  else
+    XClearArea (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
+		x, y, width, height, False);
+}
+
+
+/* Clear the area that x_clear_frame_area deferred on frame F, if
+   any.  This must be done before anything is drawn on F, lest the
+   clear erase it.  */
+
+static void
+x_flush_pending_clear (struct frame *f)
+{
+  XRectangle *r = &f->output_data.x->pending_clear;
+
+  if (r->width > 0)
+    {
+      x_clear_area (f, r->x, r->y, r->width, r->height);
+#ifdef USE_GTK
+      /* Must queue a redraw, because scroll bars might have been cleared.  */
+      if (FRAME_GTK_WIDGET (f))
+	gtk_widget_queue_draw (FRAME_GTK_WIDGET (f));
+#endif
+      r->width = 0;
+    }
 }
 
 
@@ -2947,7 +3220,13 @@ x_clear_frame (struct frame *f)
 
   block_input ();
 
-  XClearWindow (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f));
+  /* Any deferred clear is part of this one.  */
+  f->output_data.x->pending_clear.width = 0;
+  if (f->output_data.x->back_buffer)
+    x_clear_area (f, 0, 0, f->output_data.x->back_buffer_width,
+		  f->output_data.x->back_buffer_height);
+  else
+    XClearWindow (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f));
 
   /* We have to clear the scroll bars.  If we have changed colors or
      something like that, then they should be notified.  */
@@ -3169,6 +3448,9 @@ x_scroll_run (struct window *w, struct run *run)
      fringe of W.  */
   window_box (w, ANY_AREA, &x, &y, &width, &height);
 
+  /* The area copied from must be cleared first.  */
+  x_flush_pending_clear (f);
+
   from_y = WINDOW_TO_FRAME_PIXEL_Y (w, run->current_y);
   to_y = WINDOW_TO_FRAME_PIXEL_Y (w, run->desired_y);
   bottom_y = y + height;
@@ -3198,11 +3480,12 @@ x_scroll_run (struct window *w, struct run *run)
   x_clear_cursor (w);
 
   XCopyArea (FRAME_X_DISPLAY (f),
-	     FRAME_X_WINDOW (f), FRAME_X_WINDOW (f),
+	     FRAME_X_DRAWABLE (f), FRAME_X_DRAWABLE (f),
 	     f->output_data.x->normal_gc,
 	     x, from_y,
 	     width, height,
 	     x, to_y);
+  x_note_damage (f, x, to_y, width, height);
 
   unblock_input ();
 }
@@ -4979,8 +5262,7 @@ x_scroll_bar_create (struct window *w, int top, int left, int width, int height)
        for the case that a window has been split horizontally.  In
        this case, no clear_frame is generated to reduce flickering.  */
     if (width > 0 && window_box_height (w) > 0)
-      x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
-		    left, top, width, window_box_height (w));
+      x_clear_area (f, left, top, width, window_box_height (w));
 
     window = XCreateWindow (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
 			    /* Position and size of scroll bar.  */
@@ -5106,10 +5388,10 @@ x_scroll_bar_set_handle (struct scroll_bar *bar, int start, int end, int rebuild
     /* Draw the empty space above the handle.  Note that we can't clear
        zero-height areas; that means "clear to end of window."  */
     if (start > 0)
-      x_clear_area (FRAME_X_DISPLAY (f), w,
-		    VERTICAL_SCROLL_BAR_LEFT_BORDER,
-		    VERTICAL_SCROLL_BAR_TOP_BORDER,
-		    inside_width, start);
+      XClearArea (FRAME_X_DISPLAY (f), w,
+		  VERTICAL_SCROLL_BAR_LEFT_BORDER,
+		  VERTICAL_SCROLL_BAR_TOP_BORDER,
+		  inside_width, start, False);
 
     /* Change to proper foreground color if one is specified.  */
     if (f->output_data.x->scroll_bar_foreground_pixel != -1)
@@ -5131,10 +5413,10 @@ x_scroll_bar_set_handle (struct scroll_bar *bar, int start, int end, int rebuild
     /* Draw the empty space below the handle.  Note that we can't
        clear zero-height areas; that means "clear to end of window." */
     if (end < inside_height)
-      x_clear_area (FRAME_X_DISPLAY (f), w,
-		    VERTICAL_SCROLL_BAR_LEFT_BORDER,
-		    VERTICAL_SCROLL_BAR_TOP_BORDER + end,
-		    inside_width, inside_height - end);
+      XClearArea (FRAME_X_DISPLAY (f), w,
+		  VERTICAL_SCROLL_BAR_LEFT_BORDER,
+		  VERTICAL_SCROLL_BAR_TOP_BORDER + end,
+		  inside_width, inside_height - end, False);
   }
 
   unblock_input ();
@@ -5197,8 +5479,7 @@ XTset_vertical_scroll_bar (struct window *w, int portion, int whole, int positio
       if (width > 0 && height > 0)
 	{
 	  block_input ();
-	  x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
-			left, top, width, height);
+	  x_clear_area (f, left, top, width, height);
 	  unblock_input ();
 	}
 
@@ -5230,8 +5511,7 @@ XTset_vertical_scroll_bar (struct window *w, int portion, int whole, int positio
 	  /* Since toolkit scroll bars are smaller than the space reserved
 	     for them on the frame, we have to clear "under" them.  */
 	  if (width > 0 && height > 0)
-	    x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f),
-			  left, top, width, height);
+	    x_clear_area (f, left, top, width, height);
 #ifdef USE_GTK
           xg_update_scrollbar_pos (f, bar->x_window, top,
 				   left, width, max (height, 1));
@@ -6058,8 +6338,7 @@ handle_one_xevent (struct x_display_info *dpyinfo,
 #ifdef USE_GTK
 	      /* This seems to be needed for GTK 2.6 and later, see
 		 http://debbugs.gnu.org/cgi/bugreport.cgi?bug=15398.  */
-	      x_clear_area (event->xexpose.display,
-			    event->xexpose.window,
+	      x_clear_area (f,
 			    event->xexpose.x, event->xexpose.y,
 			    event->xexpose.width, event->xexpose.height);
 #endif
@@ -6968,6 +7247,7 @@ XTread_socket (struct terminal *terminal, struct input_event *hold_quit)
   int count = 0;
   int event_found = 0;
   struct x_display_info *dpyinfo = terminal->display_info.x;
+  Lisp_Object tail, frame;
 
   block_input ();
 
@@ -7055,6 +7335,16 @@ XTread_socket (struct terminal *terminal, struct input_event *hold_quit)
       dpyinfo->x_pending_autoraise_frame = NULL;
     }
 
+  /* Show what was drawn while handling the events, such as mouse
+     highlighting, on frames with a back buffer.  */
+  FOR_EACH_FRAME (tail, frame)
+    {
+      struct frame *f = XFRAME (frame);
+
+      if (FRAME_X_P (f) && FRAME_DISPLAY_INFO (f) == dpyinfo)
+	x_show_back_buffer (f);
+    }
+
   unblock_input ();
 
   return count;
@@ -7091,6 +7381,8 @@ x_clip_to_row (struct window *w, struct glyph_row *row,
   clip_rect.height = row->visible_height;
 
   XSetClipRectangles (FRAME_X_DISPLAY (f), gc, 0, 0, &clip_rect, 1, Unsorted);
+  x_note_damage (f, clip_rect.x, clip_rect.y,
+		 clip_rect.width, clip_rect.height);
 }
 
 
@@ -7129,7 +7421,7 @@ x_draw_hollow_cursor (struct window *w, struct glyph_row *row)
 
   /* Set clipping, draw the rectangle, and reset clipping again.  */
   x_clip_to_row (w, row, TEXT_AREA, gc);
-  XDrawRectangle (dpy, FRAME_X_WINDOW (f), gc, x, y, wd, h - 1);
+  XDrawRectangle (dpy, FRAME_X_DRAWABLE (f), gc, x, y, wd, h - 1);
   XSetClipMask (dpy, gc, None);
 }
 
@@ -7166,7 +7458,7 @@ x_draw_bar_cursor (struct window *w, struct glyph_row *row, int width, enum text
   else
     {
       Display *dpy = FRAME_X_DISPLAY (f);
-      Window window = FRAME_X_WINDOW (f);
+      Drawable drawable = FRAME_X_DRAWABLE (f);
       GC gc = FRAME_DISPLAY_INFO (f)->scratch_cursor_gc;
       unsigned long mask = GCForeground | GCBackground | GCGraphicsExposures;
       struct face *face = FACE_FROM_ID (f, cursor_glyph->face_id);
@@ -7187,7 +7479,7 @@ x_draw_bar_cursor (struct window *w, struct glyph_row *row, int width, enum text
 	XChangeGC (dpy, gc, mask, &xgcv);
       else
 	{
-	  gc = XCreateGC (dpy, window, mask, &xgcv);
+	  gc = XCreateGC (dpy, drawable, mask, &xgcv);
 	  FRAME_DISPLAY_INFO (f)->scratch_cursor_gc = gc;
 	}
 
@@ -7208,7 +7500,7 @@ x_draw_bar_cursor (struct window *w, struct glyph_row *row, int width, enum text
 	  if ((cursor_glyph->resolved_level & 1) != 0)
 	    x += cursor_glyph->pixel_width - width;
 
-	  XFillRectangle (dpy, window, gc, x,
+	  XFillRectangle (dpy, drawable, gc, x,
 			  WINDOW_TO_FRAME_PIXEL_Y (w, w->phys_cursor.y),
 			  width, row->height);
 	}
@@ -7224,7 +7516,7 @@ x_draw_bar_cursor (struct window *w, struct glyph_row *row, int width, enum text
 	  get_phys_cursor_geometry (w, row, cursor_glyph, &dummy_x,
 				    &dummy_y, &dummy_h);
 
-	  XFillRectangle (dpy, window, gc,
+	  XFillRectangle (dpy, drawable, gc,
 			  WINDOW_TEXT_TO_FRAME_PIXEL_X (w, w->phys_cursor.x),
 			  WINDOW_TO_FRAME_PIXEL_Y (w, w->phys_cursor.y +
 						   row->height - width),
@@ -7248,12 +7540,36 @@ x_define_frame_cursor (struct frame *f, Cursor cursor)
 }
 
 
-/* RIF: Clear area on frame F.  */
+/* RIF: Clear area on frame F.  While F is updated, the clear is
+   deferred and merged with the clears of adjacent areas that follow,
+   such as the ends of consecutive rows, so that they go to the server
+   as one request.  */
 
 static void
 x_clear_frame_area (struct frame *f, int x, int y, int width, int height)
 {
-  x_clear_area (FRAME_X_DISPLAY (f), FRAME_X_WINDOW (f), x, y, width, height);
+  XRectangle *r = &f->output_data.x->pending_clear;
+
+  if (f->output_data.x->defer_clears_p)
+    {
+      if (r->width > 0 && r->x == x && r->width == width
+	  && r->y + r->height == y)
+	r->height += height;
+      else if (r->width > 0 && r->y == y && r->height == height
+	       && r->x + r->width == x)
+	r->width += width;
+      else
+	{
+	  x_flush_pending_clear (f);
+	  r->x = x;
+	  r->y = y;
+	  r->width = width;
+	  r->height = height;
+	}
+      return;
+    }
+
+  x_clear_area (f, x, y, width, height);
 #ifdef USE_GTK
   /* Must queue a redraw, because scroll bars might have been cleared.  */
   if (FRAME_GTK_WIDGET (f))
@@ -7271,6 +7587,8 @@ x_draw_window_cursor (struct window *w, struct glyph_row *glyph_row, int x,
 {
   struct frame *f = XFRAME (WINDOW_FRAME (w));
 
+  x_flush_pending_clear (f);
+
   if (on_p)
     {
       w->phys_cursor_type = cursor_type;
@@ -9218,6 +9536,11 @@ x_free_frame_resources (struct frame *f)
 	 face.  */
       free_frame_faces (f);
 
+      if (f->output_data.x->back_buffer)
+	XFreePixmap (FRAME_X_DISPLAY (f), f->output_data.x->back_buffer);
+      if (f->output_data.x->back_buffer_gc)
+	XFreeGC (FRAME_X_DISPLAY (f), f->output_data.x->back_buffer_gc);
+
       if (f->output_data.x->icon_desc)
 	XDestroyWindow (FRAME_X_DISPLAY (f), f->output_data.x->icon_desc);
 
@@ -10424,8 +10747,8 @@ static struct redisplay_interface x_redisplay_interface =
     x_get_glyph_overhangs,
     x_fix_overlapping_area,
     x_draw_fringe_bitmap,
-    0, /* define_fringe_bitmap */
-    0, /* destroy_fringe_bitmap */
+    x_define_fringe_bitmap,
+    x_destroy_fringe_bitmap,
     x_compute_glyph_string_overhangs,
     x_draw_glyph_string,
     x_define_frame_cursor,
@@ -10635,6 +10958,15 @@ variable `x-use-underline-position-properties', which is usually at the
 baseline level.  The default value is nil.  */);
   x_underline_at_descent_line = 0;
 
+  DEFVAR_BOOL ("x-double-buffer", x_double_buffer,
+    doc: /* Non-nil means to draw X frames into an offscreen pixmap first.
+Each update of a frame is then drawn into a pixmap, and the parts that
+changed are copied to the frame's window when the update is complete,
+so that partial updates never show.  This uses a pixmap of the size of
+each frame in the X server.  Changes to this variable take effect the
+next time a frame is updated.  */);
+  x_double_buffer = 0;
+
   DEFVAR_BOOL ("x-mouse-click-focus-ignore-position",
 	       x_mouse_click_focus_ignore_position,
     doc: /* Non-nil means that a mouse click to focus a frame does not move point.
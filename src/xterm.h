@@ -357,6 +357,16 @@ struct x_display_info
   int red_bits, blue_bits, green_bits;
   int red_offset, blue_offset, green_offset;
 
+  /* Colors looked up by name on this display, so that frames created
+     later need not ask the server again; see x_defined_color.  */
+  struct x_color_name
+  {
+    struct x_color_name *next;
+    XColor color;
+    bool defined_p;
+    char name[FLEXIBLE_ARRAY_MEMBER];
+  } *color_names[64];
+
   /* The type of window manager we have.  If we move FRAME_OUTER_WINDOW
      to x/y 0/0, some window managers (type A) puts the window manager
      decorations outside the screen and FRAME_OUTER_WINDOW exactly at 0/0.
@@ -403,6 +413,21 @@ struct x_display_info
 
   /* SM */
   Atom Xatom_SM_CLIENT_ID;
+
+  /* Pixmaps of recently drawn fringe bitmaps, see
+     x_draw_fringe_bitmap.  */
+  struct x_fringe_pixmap
+  {
+    /* The bitmap, the bits the pixmap was made of, and its size and
+       colors.  BITS is null if the entry is unused.  */
+    int which;
+    const char *bits;
+    int wd, h;
+    unsigned long foreground, background;
+
+    /* The pixmap, and the mask for drawing it as an overlay or 0.  */
+    Pixmap pixmap, clipmask;
+  } fringe_pixmaps[64];
 };
 
 #ifdef HAVE_X_I18N
@@ -554,6 +579,25 @@ struct x_output
   Cursor vertical_drag_cursor;
   Cursor current_cursor;
 
+  /* While the frame is updated, the area that x_clear_frame_area has
+     yet to clear, if its width is nonzero.  Clears of adjacent areas
+     are merged into it and sent as one request.  */
+  XRectangle pending_clear;
+
+  /* True while the frame is updated, see x_update_begin.  */
+  bool_bf defer_clears_p : 1;
+
+  /* If nonzero, the pixmap the frame is drawn into instead of its
+     window, when `x-double-buffer' is non-nil.  Its size, and a GC to
+     copy it to the window and to clear it with.  */
+  Pixmap back_buffer;
+  int back_buffer_width, back_buffer_height;
+  GC back_buffer_gc;
+
+  /* The area of back_buffer drawn into since it was last copied to
+     the window, if its width is nonzero.  */
+  XRectangle damage;
+
   /* Window whose cursor is hourglass_cursor.  This window is temporarily
      mapped to display an hourglass cursor.  */
   Window hourglass_window;
@@ -578,6 +622,9 @@ struct x_output
      We save it here until the command loop gets to think about it.  */
   XEvent *saved_menu_event;
 
+  /* Hash code of the menu bar item names that menubar_widget shows.  */
+  EMACS_UINT menubar_names_hash;
+
   /* This is the widget id used for this frame's menubar in lwlib.  */
 #ifdef USE_X_TOOLKIT
   int id;
@@ -665,6 +712,13 @@ enum
 /* Return the X window used for displaying data in frame F.  */
 #define FRAME_X_WINDOW(f) ((f)->output_data.x->window_desc)
 
+/* Return the drawable that is drawn into to display data in frame F:
+   its back buffer if it has one, else its window.  */
+#define FRAME_X_DRAWABLE(f)			\
+  ((f)->output_data.x->back_buffer		\
+   ? (f)->output_data.x->back_buffer		\
+   : FRAME_X_WINDOW (f))
+
 /* Return the outermost X window associated with the frame F.  */
 #ifdef USE_X_TOOLKIT
 #define FRAME_OUTER_WINDOW(f) ((f)->output_data.x->widget ?             \
@@ -944,7 +998,7 @@ extern bool x_alloc_lighter_color_for_widget (Widget, Display *, Colormap,
 					      double, int);
 #endif
 extern bool x_alloc_nearest_color (struct frame *, Colormap, XColor *);
-extern void x_clear_area (Display *, Window, int, int, int, int);
+extern void x_clear_area (struct frame *, int, int, int, int);
 #if !defined USE_X_TOOLKIT && !defined USE_GTK
 extern void x_mouse_leave (struct x_display_info *);
 #endif
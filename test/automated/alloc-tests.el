@@ -0,0 +1,65 @@
+;;; alloc-tests.el --- tests for src/alloc.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+(require 'cl-lib)
+
+(ert-deftest alloc-tests-garbage-collect ()
+  (let ((gcs gcs-done)
+        (stats (garbage-collect)))
+    (should (consp stats))
+    (dolist (entry stats)
+      (should (symbolp (car entry)))
+      (should (= (length entry) 4))
+      (should (cl-every #'natnump (cdr entry))))
+    (should (assq 'strings stats))
+    (should (assq 'heap stats))
+    (should (> (nth 2 (assq 'buffers stats)) 0))
+    (should (> gcs-done gcs))
+    (should (floatp gc-elapsed))))
+
+(ert-deftest alloc-tests-gc-statistics ()
+  (let ((stats (gc-statistics)))
+    (dolist (prop '(heap-size free-bytes bytes-since-gc total-bytes gcs-done))
+      (should (natnump (plist-get stats prop))))
+    (should (>= (plist-get stats 'heap-size) (plist-get stats 'free-bytes)))
+    (should (floatp (plist-get stats 'gc-elapsed)))))
+
+(defvar alloc-tests--census-cache nil)
+
+(ert-deftest alloc-tests-memory-census ()
+  (setq alloc-tests--census-cache (make-list 1000 "leak"))
+  (let* ((census (memory-census))
+         (types (nth 0 census))
+         (roots (nth 1 census))
+         (cache (assq 'alloc-tests--census-cache roots)))
+    (should (assq 'conses types))
+    (should (assq 'symbols types))
+    (should (>= (nth 1 cache) 1000))
+    (should (> (nth 2 cache) 1000))
+    ;; Sorted by decreasing bytes.
+    (should (>= (nth 2 (car roots)) (nth 2 cache)))
+    (should (bufferp (car (cl-find-if (lambda (root) (bufferp (car root)))
+                                      roots))))))
+
+;;; alloc-tests.el ends here
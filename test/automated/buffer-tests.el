@@ -0,0 +1,115 @@
+;;; buffer-tests.el --- tests for src/buffer.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+(require 'cl-lib)
+
+(defun buffer-tests--overlays-at (pos)
+  "Return the overlays containing POS, found without `overlays-at'."
+  (let (result)
+    (dolist (ov (overlays-in (point-min) (point-max)))
+      (when (and (<= (overlay-start ov) pos) (< pos (overlay-end ov)))
+        (push ov result)))
+    result))
+
+(defun buffer-tests--same-set (a b)
+  (and (= (length a) (length b))
+       (null (cl-set-difference a b))))
+
+(ert-deftest buffer-tests-overlay-queries ()
+  (with-temp-buffer
+    (insert (make-string 1000 ?x))
+    (let ((state 17)
+          overlays)
+      (dotimes (_ 300)
+        (setq state (% (+ (* state 1103) 12345) 65536))
+        (let ((beg (1+ (% state 1000))))
+          (push (make-overlay beg (min 1001 (+ beg (% state 40))))
+                overlays)))
+      (should (= (length (overlays-in (point-min) (point-max))) 300))
+      (dolist (pos '(1 2 100 500 999 1000 1001))
+        (should (buffer-tests--same-set (overlays-at pos)
+                                        (buffer-tests--overlays-at pos))))
+      ;; The queries must follow text changes and moved overlays.
+      (goto-char 300)
+      (insert (make-string 50 ?y))
+      (delete-region 600 700)
+      (move-overlay (car overlays) 10 20)
+      (delete-overlay (cadr overlays))
+      (dolist (pos '(1 15 299 300 349 350 650 950))
+        (should (buffer-tests--same-set (overlays-at pos)
+                                        (buffer-tests--overlays-at pos))))
+      (should (memq (car overlays) (overlays-in 12 13)))
+      (should-not (memq (cadr overlays)
+                        (overlays-in (point-min) (point-max)))))))
+
+(ert-deftest buffer-tests-empty-overlay ()
+  (with-temp-buffer
+    (insert "abcdef")
+    (let ((ov (make-overlay 3 3)))
+      (should-not (overlays-at 3))
+      (should (memq ov (overlays-in 3 3)))
+      (should (memq ov (overlays-in 1 3)))
+      (should (= (previous-overlay-change 4) 3))
+      (should (= (next-overlay-change 1) 3)))))
+
+(ert-deftest buffer-tests-gap-statistics ()
+  (with-temp-buffer
+    (insert "abcdef")
+    (let ((stats (gap-statistics)))
+      (goto-char 2)
+      (insert "x")
+      (should (= (gap-position) 3))
+      (should (equal (gap-statistics)
+                     (list (1+ (nth 0 stats)) (+ (nth 1 stats) 5))))
+      ;; Inserting where the gap is already does not move it.
+      (insert "y")
+      (should (= (car (gap-statistics)) (1+ (nth 0 stats)))))
+    (should (equal (gap-statistics (current-buffer)) (gap-statistics)))))
+
+(ert-deftest buffer-tests-placeholder ()
+  (let ((buffer (generate-new-buffer " *placeholder*"))
+        (calls 0))
+    (unwind-protect
+        (progn
+          (set-buffer-placeholder
+           buffer (lambda ()
+                    (setq calls (1+ calls))
+                    (insert "filled in")))
+          (should (buffer-placeholder buffer))
+          ;; Looking the buffer up or visiting it does not fill it in.
+          (should (eq (get-buffer (buffer-name buffer)) buffer))
+          (should (memq buffer (buffer-list)))
+          (with-current-buffer buffer
+            (should (= (buffer-size) 0)))
+          (should (= calls 0))
+          (should (eq (materialize-buffer buffer) buffer))
+          (should (= calls 1))
+          (should-not (buffer-placeholder buffer))
+          (should (equal (with-current-buffer buffer (buffer-string))
+                         "filled in"))
+          (materialize-buffer buffer)
+          (should (= calls 1)))
+      (kill-buffer buffer))))
+
+;;; buffer-tests.el ends here
@@ -34,6 +34,18 @@
     (should (math-negp n))
     (should (cl-notany #'cl-minusp (cdr n)))))
 
+(ert-deftest test-math-bignum-mul-div ()
+  (let* ((a (math-read-number (make-string 60 ?7)))
+         (b (math-neg (math-read-number (make-string 45 ?3))))
+         (ab (math-mul a b)))
+    (should (equal (math-normalize (cons 'bigpos (math-mul-bignum-lisp
+                                                  (cdr a) (cdr b))))
+                   (math-normalize (cons 'bigpos (math-mul-bignum
+                                                  (cdr a) (cdr b))))))
+    (should (equal (math-quotient ab b) a))
+    (should (equal (math-idivmod (math-add (math-mul a a) 5) a)
+                   (cons a 5)))))
+
 (provide 'calc-tests)
 ;;; calc-tests.el ends here
 
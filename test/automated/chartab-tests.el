@@ -0,0 +1,85 @@
+;;; chartab-tests.el --- tests for src/chartab.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+;; A frozen table gives the same values as before, and changes to it
+;; or to its parent show up at once.
+(ert-deftest chartab-tests-freeze-char-table ()
+  (let ((parent (make-char-table 'test 'parent-default))
+        (table (make-char-table 'test)))
+    (set-char-table-parent table parent)
+    (set-char-table-range table '(?a . ?z) 'lower)
+    (set-char-table-range table '(#x3000 . #x30ff) 'kana)
+    (aset table #x10000 'linear-b)
+    (aset parent ?A 'upper)
+    (should (freeze-char-table table))
+    (dotimes (_ 2)
+      (should (eq (aref table ?a) 'lower))
+      (should (eq (aref table ?A) 'upper))
+      (should (eq (aref table ?0) 'parent-default))
+      (should (eq (aref table #x3042) 'kana))
+      (should (eq (aref table #x10000) 'linear-b))
+      (should (eq (aref table #x10001) 'parent-default))
+      (should (eq (aref table #x40000) 'parent-default)))
+    (aset table #x3042 'hiragana)
+    (should (eq (aref table #x3042) 'hiragana))
+    (aset parent ?B 'upper)
+    (should (eq (aref table ?B) 'upper))
+    (set-char-table-parent table nil)
+    (should-not (aref table ?B))
+    (dotimes (i 2000)
+      (should (eq (aref table (+ #x3000 (% i #x100)))
+                  (if (= (% i #x100) #x42) 'hiragana 'kana))))))
+
+;; Uniform blocks are merged without changing any value.
+(ert-deftest chartab-tests-optimize-char-table ()
+  (let ((table (make-char-table 'test)))
+    (set-char-table-range table '(#x10000 . #x1ffff) 'same)
+    (aset table #x10000 'same)
+    (set-char-table-range table '(#x20000 . #x2ffff) (list 1))
+    (aset table #x20005 (list 1))
+    (aset table #x30005 'other)
+    (optimize-char-table table)
+    (should (eq (aref table #x10000) 'same))
+    (should (eq (aref table #x1ffff) 'same))
+    (should (equal (aref table #x20005) '(1)))
+    (should (eq (aref table #x30005) 'other))
+    (should-not (aref table #x30006))))
+
+(ert-deftest chartab-tests-map-char-table-parent ()
+  (let ((parent (make-char-table 'test))
+        (table (make-char-table 'test))
+        ranges)
+    (set-char-table-range parent '(?a . ?z) 'p)
+    (set-char-table-range table '(?m . ?n) 't)
+    (set-char-table-parent table parent)
+    (map-char-table (lambda (k v)
+                      (push (cons (if (consp k) (cons (car k) (cdr k)) k) v)
+                            ranges))
+                    table)
+    (should (equal (sort ranges (lambda (a b) (< (caar a) (caar b))))
+                   '(((?a . ?l) . p) ((?m . ?n) . t) ((?o . ?z) . p))))
+    (should (eq (char-table-parent table) parent))))
+
+;;; chartab-tests.el ends here
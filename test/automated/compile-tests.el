@@ -353,4 +353,32 @@ The test data is in `compile-tests--test-regexps-data'."
     (dolist (test compile-tests--test-regexps-data)
       (should (compile--test-error-line test)))))
 
+(defun compile--test-messages ()
+  "Return the positions, lines and columns of the messages parsed."
+  (let ((pos (point-min))
+        messages)
+    (while (setq pos (next-single-property-change pos 'compilation-message))
+      (let ((msg (get-text-property pos 'compilation-message)))
+        (when msg
+          (let ((loc (compilation--message->loc msg)))
+            (push (list pos (compilation--loc->line loc)
+                        (compilation--loc->col loc))
+                  messages)))))
+    messages))
+
+(ert-deftest compile-test-single-pass ()
+  "Test that searching for all regexps at once finds the same messages."
+  (with-temp-buffer
+    (font-lock-mode -1)
+    (dolist (test compile-tests--test-regexps-data)
+      (insert (car test) "\n"))
+    (let (results)
+      (dolist (compilation-parse-single-pass '(nil t))
+        (compilation--remove-properties)
+        (setq compilation-locs (make-hash-table))
+        (compilation-parse-errors (point-min) (point-max))
+        (push (compile--test-messages) results))
+      (should (car results))
+      (should (equal (car results) (cadr results))))))
+
 ;;; compile-tests.el ends here.
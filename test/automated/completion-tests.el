@@ -42,5 +42,61 @@
         (should (equal (buffer-string)
                        "test: "))))))
 
+;; The basic completion functions over each kind of collection.
+(ert-deftest completion-test-basic ()
+  (let ((alist '(("foobar" . 1) ("foobaz" . 2) ("quux" . 3) "fooé"))
+        (table (make-hash-table :test 'equal))
+        (ob (make-vector 7 0)))
+    (dolist (name '("foobar" "foobaz" "quux" "fooé"))
+      (puthash name t table)
+      (intern name ob))
+    (dolist (coll (list alist table ob))
+      (should (equal (try-completion "foo" coll) "foo"))
+      (should (equal (try-completion "foob" coll) "fooba"))
+      (should (eq (try-completion "quux" coll) t))
+      (should (null (try-completion "x" coll)))
+      (should (equal (sort (all-completions "foo" coll) #'string<)
+                     '("foobar" "foobaz" "fooé")))
+      (should (equal (all-completions "fooé" coll) '("fooé")))
+      (should (test-completion "quux" coll))
+      (should-not (test-completion "quu" coll))
+      (let ((completion-regexp-list '("z\\'")))
+        (should (equal (try-completion "foo" coll) "foobaz"))
+        (should-not (test-completion "foobar" coll)))
+      (let ((completion-ignore-case t))
+        (should (equal (try-completion "FOOBA" coll) "FOOBA"))
+        (should (test-completion "QUUX" coll))))
+    (should (equal (all-completions "foo" alist
+                                    (lambda (elt) (equal (cdr-safe elt) 2)))
+                   '("foobaz")))
+    (should (equal (sort (all-completions "foo" table (lambda (_k v) v))
+                         #'string<)
+                   '("foobar" "foobaz" "fooé")))
+    (should (equal (all-completions "" '(" a" "b") nil t) '("b")))
+    (should (equal (try-completion "a" (lambda (s _p a) (list s a)))
+                   '("a" nil)))))
+
+(ert-deftest completion-test-flex-match ()
+  (let ((cands ["find-file" "font-lock-fontify-buffer" "fill" 'forward-line
+                "xyz" 42]))
+    (should (equal (mapcar #'car (completion-flex-match "ff" cands))
+                   '("find-file" "font-lock-fontify-buffer")))
+    ;; Word starts score more; ties go to the shorter candidate.
+    (should (equal (mapcar #'car (completion-flex-match "fl" cands))
+                   '("font-lock-fontify-buffer" forward-line "fill"
+                     "find-file")))
+    (should (equal (mapcar #'car (completion-flex-match "fl" cands 1))
+                   '("font-lock-fontify-buffer")))
+    (should (null (completion-flex-match "FF" cands)))
+    (let ((completion-ignore-case t))
+      (should (= (length (completion-flex-match "FF" (append cands nil)))
+                 2)))
+    ;; Enough candidates to be scored by several threads.
+    (let ((many (make-vector 20000 "abc")))
+      (aset many 12345 "a-b-c")
+      (should (equal (car (car (completion-flex-match "abc" many)))
+                     "a-b-c"))
+      (should (= (length (completion-flex-match "ac" many)) 20000)))))
+
 (provide 'completion-tests)
 ;;; completion-tests.el ends here
@@ -255,3 +255,52 @@ comparing the subr with a much slower lisp implementation."
          (v2 (test-bool-vector-bv-from-hex-string "0000C"))
          (v3 (bool-vector-not v1)))
     (should (equal v2 v3))))
+
+(defvar data-tests--local 'default)
+
+(ert-deftest data-tests-buffer-local-alternation ()
+  ;; Reading a local variable while alternating between buffers must
+  ;; see each buffer's own binding, including after it is killed.
+  (with-temp-buffer
+    (let ((a (current-buffer)))
+      (set (make-local-variable 'data-tests--local) 'a)
+      (with-temp-buffer
+	(let ((b (current-buffer)))
+	  (dotimes (_ 3)
+	    (should (eq data-tests--local 'default))
+	    (with-current-buffer a
+	      (should (eq data-tests--local 'a)))
+	    (set (make-local-variable 'data-tests--local) 'b)
+	    (should (eq data-tests--local 'b))
+	    (with-current-buffer a
+	      (should (eq data-tests--local 'a)))
+	    (kill-local-variable 'data-tests--local)
+	    (should (eq data-tests--local 'default))
+	    (should (eq (buffer-local-value 'data-tests--local b)
+			'default))))))))
+
+(ert-deftest data-tests-fixnum-arith2 ()
+  (should (= (+ 2 3) 5))
+  (should (= (- 2 3) -1))
+  (should (= (* -4 3) -12))
+  (should (= (+ 1 2 3 4 5 6) 21))
+  (should (= (- 7) -7))
+  ;; Overflow still wraps like the general driver.
+  (should (= (+ most-positive-fixnum 1) (+ most-positive-fixnum 1 0)))
+  (should (= (* most-positive-fixnum 2) (* most-positive-fixnum 2 1)))
+  (should (< 1 2))
+  (should-not (< 2 1))
+  (should (<= 1 1.0))
+  (should (= 3 3))
+  (should (< 1 2 3 4 5))
+  (should-error (< 1 'a)))
+
+(ert-deftest data-tests-digits ()
+  (should (equal (digits-multiply '(5 1) '(2) 10) '(0 3)))
+  (should (equal (digits-multiply '(0) '(9) 10) nil))
+  (should (equal (digits-divide '(0 3) '(7) 10) '((4) 2)))
+  (let ((big (make-list 40 999)))
+    (should (equal (digits-divide (digits-multiply big big 1000) big 1000)
+                   (cons big nil))))
+  (should-error (digits-divide '(1) '(0 0) 10) :type 'arith-error)
+  (should-error (digits-multiply '(10) '(1) 10) :type 'args-out-of-range))
@@ -265,6 +265,68 @@
     (decoder-tests-remove-files)))
 
 
+;;; Check decoding of strings and process output by copying.
+
+(ert-deftest ert-test-decoder-copy ()
+  (let ((text (concat (make-string 100 ?a) "é€😀\nx")))
+    (dolist (disable-ascii-optimization '(nil t))
+      (should (equal (decode-coding-string (encode-coding-string text 'utf-8)
+                                           'utf-8-unix)
+                     text))
+      (should (equal (decode-coding-string (encode-coding-string text 'utf-8)
+                                           'undecided)
+                     text))
+      ;; CRs, invalid UTF-8 and BOMs still go through the decoder.
+      (should (equal (decode-coding-string "ab\r\ncd\r\n" 'utf-8-dos)
+                     "ab\ncd\n"))
+      (should (equal (decode-coding-string "ab\r\ncd\r\n" 'utf-8-unix)
+                     "ab\r\ncd\r\n"))
+      (should (equal (decode-coding-string "a\xff\xc3" 'utf-8-unix)
+                     (string ?a (unibyte-char-to-multibyte #xff)
+                             (unibyte-char-to-multibyte #xc3))))
+      (should (equal (decode-coding-string "\xef\xbb\xbfab"
+                                           'utf-8-with-signature-unix)
+                     "ab"))
+      (should (equal (decode-coding-string "\xef\xbb\xbfab" 'utf-8-auto-unix)
+                     "ab"))
+      (with-temp-buffer
+        (insert "<>")
+        (goto-char 2)
+        (decode-coding-string (encode-coding-string text 'utf-8)
+                              'utf-8-unix nil (current-buffer))
+        (should (equal (buffer-string) (concat "<" text ">")))))))
+
+;;; Check writing text that needs no encoding straight from the buffer.
+
+(ert-deftest ert-test-encoder-write-buffer ()
+  (let ((file (make-temp-file "decoder-tests"))
+        (text (concat (make-string 100 ?a) "é€😀\nx")))
+    (unwind-protect
+        (with-temp-buffer
+          (insert text text)
+          ;; Put the gap in the middle of the text written.
+          (goto-char 150)
+          (insert "z")
+          (delete-char -1)
+          (dolist (coding '(utf-8-unix us-ascii-unix latin-1-unix utf-8-dos))
+            (let ((coding-system-for-write coding))
+              (write-region 30 (point-max) file))
+            (should (equal (with-temp-buffer
+                             (insert-file-contents-literally file)
+                             (buffer-string))
+                           (encode-coding-string
+                            (buffer-substring 30 (point-max)) coding))))
+          ;; Raw bytes are written as the bytes they stand for.
+          (erase-buffer)
+          (insert "a" (unibyte-char-to-multibyte #xff) "b")
+          (let ((coding-system-for-write 'utf-8-unix))
+            (write-region nil nil file))
+          (should (equal (with-temp-buffer
+                           (insert-file-contents-literally file)
+                           (buffer-string))
+                         "a\xffb")))
+      (delete-file file))))
+
 ;;; The following is for benchmark testing of the new optimized
 ;;; decoder, not for regression testing.
 
@@ -0,0 +1,131 @@
+;;; dired-tests.el --- tests for src/dired.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; GNU Emacs is free software: you can redistribute it and/or modify
+;; it under the terms of the GNU General Public License as published by
+;; the Free Software Foundation, either version 3 of the License, or
+;; (at your option) any later version.
+
+;; GNU Emacs is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+
+;; You should have received a copy of the GNU General Public License
+;; along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.
+
+;;; Code:
+
+(require 'ert)
+
+(ert-deftest dired-tests-directory-files-and-attributes ()
+  "Each file's attributes are those `file-attributes' returns."
+  (let ((dir (make-temp-file "dired-tests" t)))
+    (unwind-protect
+        (progn
+          (dotimes (i 20)
+            (write-region (make-string i ?x) nil
+                          (expand-file-name (format "f%02d" i) dir)))
+          (dolist (id-format '(integer string))
+            (let ((entries (directory-files-and-attributes
+                            dir nil "\\`f" nil id-format)))
+              (should (= (length entries) 20))
+              (dolist (entry entries)
+                (should (equal (cdr entry)
+                               (file-attributes
+                                (expand-file-name (car entry) dir)
+                                id-format))))
+              ;; Owner names are not shared between entries.
+              (when (stringp (nth 2 (cdr (car entries))))
+                (should-not (eq (nth 2 (cdr (nth 0 entries)))
+                                (nth 2 (cdr (nth 1 entries)))))))))
+      (delete-directory dir t))))
+
+(ert-deftest dired-tests-directory-files-recursively ()
+  "The files below a directory are found in order, with pruning."
+  (let* ((dir (file-name-as-directory (make-temp-file "dired-tests" t)))
+         (files '("a.el" "b/c.el" "b/d.txt" "b/e/f.el" "b.el" "g/h.el")))
+    (unwind-protect
+        (progn
+          (dolist (file files)
+            (let ((file (expand-file-name file dir)))
+              (make-directory (file-name-directory file) t)
+              (write-region "" nil file)))
+          (should (equal (directory-files-recursively dir)
+                         (mapcar (lambda (file) (concat dir file))
+                                 files)))
+          (should (equal (directory-files-recursively dir "\\.el\\'" nil "\\`e\\'")
+                         (mapcar (lambda (file) (concat dir file))
+                                 '("a.el" "b/c.el" "b.el" "g/h.el"))))
+          (should (equal (directory-files-recursively dir "\\`[bg]\\'" t)
+                         (mapcar (lambda (file) (concat dir file))
+                                 '("b" "g"))))
+          (should-error (directory-files-recursively
+                         (expand-file-name "none" dir))
+                        :type 'file-error))
+      (delete-directory dir t))))
+
+(ert-deftest dired-tests-file-name-completion ()
+  "Completion sees the names a directory has when it completes."
+  (let ((dir (file-name-as-directory (make-temp-file "dired-tests" t))))
+    (unwind-protect
+        (progn
+          (dolist (file '("abc" "abd" "b" "xyz"))
+            (write-region "" nil (expand-file-name file dir)))
+          (make-directory (expand-file-name "abe" dir))
+          ;; An old time stamp lets the names be reused.
+          (set-file-times dir '(0 0))
+          (dotimes (_ 2)
+            (should (equal (file-name-completion "a" dir) "ab"))
+            (should (equal (sort (file-name-all-completions "ab" dir)
+                                 #'string-lessp)
+                           '("abc" "abd" "abe/")))
+            (should (eq (file-name-completion "xyz" dir) t))
+            (should-not (file-name-completion "q" dir)))
+          (write-region "" nil (expand-file-name "q1" dir))
+          (should (equal (file-name-completion "q" dir) "q1"))
+          (should (equal (file-name-completion "ab" dir #'file-directory-p)
+                         "abe/")))
+      (delete-directory dir t))))
+
+(ert-deftest dired-tests-insert-directory-native ()
+  "A native listing has a line for each file, in the requested order."
+  (let ((dir (make-temp-file "dired-tests" t)))
+    (unwind-protect
+        (progn
+          (write-region "xxx" nil (expand-file-name "b" dir))
+          (write-region "x" nil (expand-file-name "a" dir))
+          (write-region "" nil (expand-file-name ".hidden" dir))
+          (make-directory (expand-file-name "c" dir))
+          (with-temp-buffer
+            (should (insert-directory-native dir "--dired -alF"))
+            (goto-char (point-min))
+            (should (looking-at "  total "))
+            (let (names)
+              (while (re-search-forward "^  [-d]" nil t)
+                (goto-char (next-single-property-change
+                            (point) 'dired-filename))
+                (push (buffer-substring
+                       (point) (next-single-property-change
+                                (point) 'dired-filename))
+                      names)
+                (forward-line 1))
+              (should (equal (nreverse names)
+                             '("." ".." ".hidden" "a" "b" "c"))))
+            (should (re-search-backward " c/$" nil t)))
+          (with-temp-buffer
+            (should (insert-directory-native dir '("-l" "-S")))
+            (should (string-match-p
+                     "\\`total [0-9]+\n.* 3 .* b\n.* 1 .* a\n"
+                     (replace-regexp-in-string "^d.*\n" "" (buffer-string)))))
+          (with-temp-buffer
+            ;; Formats it cannot do are left to `ls'.
+            (should-not (insert-directory-native dir "-l --sort=size"))
+            (should-not (insert-directory-native dir "-a"))
+            (should (= (buffer-size) 0))))
+      (delete-directory dir t))))
+
+;;; dired-tests.el ends here
@@ -0,0 +1,210 @@
+;;; editfns-tests.el --- tests for src/editfns.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+(ert-deftest editfns-tests-format-simple ()
+  (dotimes (_ 2)
+    (should (equal (format "%s:%d" "a" 42) "a:42"))
+    (should (equal (format "%s %s %d%%" 'foo 7 -3) "foo 7 -3%"))
+    (should (equal (format "%s" "é") "é"))
+    (should (multibyte-string-p (format "%s" "é")))
+    (should (equal (format "%s/%s" "x" (string-to-multibyte "y")) "x/y"))
+    (should (multibyte-string-p (format "%s" "x" "é")))
+    (should (equal (format "%d %s" 1.5 2.5) "1 2.5"))
+    (should-error (format "%s %s" "a") :type 'error)
+    (should-error (format "%d" "a") :type 'error)))
+
+(ert-deftest editfns-tests-format-modified-string ()
+  (let ((fmt (copy-sequence "<%s>")))
+    (should (equal (format fmt 1) "<1>"))
+    (aset fmt 0 ?\[)
+    (aset fmt 3 ?\])
+    (should (equal (format fmt 1) "[1]"))))
+
+(ert-deftest editfns-tests-format-properties ()
+  (let ((s (format "%s-%s" (propertize "a" 'face 'bold) "b")))
+    (should (equal s "a-b"))
+    (should (eq (get-text-property 0 'face s) 'bold))
+    (should (null (get-text-property 2 'face s))))
+  (let ((s (format (propertize "%s!" 'face 'italic) "x")))
+    (should (eq (get-text-property 1 'face s) 'italic))))
+
+;; Build text longer than the comparison block size, with the buffer
+;; gap in the middle, so that the fast paths see split text.
+(defun editfns-tests--buffer (text gap)
+  (let ((buf (generate-new-buffer " *editfns-test*")))
+    (with-current-buffer buf
+      (insert text)
+      (goto-char gap)
+      (insert "x")
+      (delete-char -1))
+    buf))
+
+(ert-deftest editfns-tests-compare-buffer-substrings ()
+  (let* ((text (concat (make-string 1000 ?a) "é" (make-string 1000 ?b)))
+         (b1 (editfns-tests--buffer text 500))
+         (b2 (editfns-tests--buffer (concat (substring text 0 1500) "c")
+                                    1200)))
+    (unwind-protect
+        (let ((case-fold-search nil))
+          (should (= (compare-buffer-substrings b1 nil nil b1 nil nil) 0))
+          (should (= (compare-buffer-substrings b1 1 1001 b2 1 1001) 0))
+          (should (= (compare-buffer-substrings b1 nil nil b2 nil nil) -1501))
+          (should (= (compare-buffer-substrings b1 nil 1501 b2 nil 1501) 0))
+          (should (= (compare-buffer-substrings b1 nil 1600 b2 nil nil) -1501)))
+      (kill-buffer b1)
+      (kill-buffer b2))))
+
+(ert-deftest editfns-tests-compare-buffer-substrings-affixes ()
+  (let* ((b1 (editfns-tests--buffer
+              (concat (make-string 700 ?a) "xé" (make-string 900 ?z)) 300))
+         (b2 (editfns-tests--buffer
+              (concat (make-string 700 ?a) "yé" (make-string 900 ?z)) 1500))
+         (b3 (editfns-tests--buffer (make-string 10 ?a) 5)))
+    (unwind-protect
+        (progn
+          (should (equal (compare-buffer-substrings-affixes
+                          b1 nil nil b2 nil nil)
+                         '(700 . 901)))
+          (should (equal (compare-buffer-substrings-affixes
+                          b1 nil nil b1 nil nil)
+                         '(1602 . 0)))
+          (should (equal (compare-buffer-substrings-affixes
+                          b3 nil nil b1 1 11)
+                         '(10 . 0)))
+          (should (equal (compare-buffer-substrings-affixes
+                          b1 1 5 b1 2 5)
+                         '(3 . 0)))
+          (with-current-buffer b3
+            (set-buffer-multibyte nil))
+          (should (equal (compare-buffer-substrings-affixes
+                          b3 nil nil b1 1 11)
+                         '(10 . 0))))
+      (kill-buffer b1)
+      (kill-buffer b2)
+      (kill-buffer b3))))
+
+(ert-deftest editfns-tests-replace-buffer-contents ()
+  (let ((source (generate-new-buffer " *editfns-source*")))
+    (unwind-protect
+        (with-temp-buffer
+          (insert "one\ntwo\nthree\nfour\nfive\n")
+          (let ((m2 (copy-marker 5))
+                (m4 (copy-marker 15))
+                (m5 (copy-marker 20)))
+            (put-text-property 20 24 'face 'bold)
+            (goto-char 16)
+            (with-current-buffer source
+              (insert "zero\none\ntwo\n3\nfour\nfive\nsix\n"))
+            (replace-buffer-contents source)
+            (should (equal (buffer-string)
+                           (with-current-buffer source (buffer-string))))
+            (should (equal (buffer-substring-no-properties m2 (+ m2 3)) "two"))
+            (should (equal (buffer-substring-no-properties m4 (+ m4 4)) "four"))
+            (should (= (point) (1+ m4)))
+            (should (eq (get-text-property m5 'face) 'bold))
+            (should (eq (replace-buffer-contents source) t))
+            (erase-buffer)
+            (replace-buffer-contents source)
+            (should (equal (buffer-string)
+                           (with-current-buffer source (buffer-string))))
+            (should-error (replace-buffer-contents (current-buffer)))))
+      (kill-buffer source))))
+
+;; The codes follow `ansi-color-apply-sequence', and the runs and
+;; fragment are given in positions after the deletions.
+(ert-deftest editfns-tests-ansi-color-scan-region ()
+  (require 'ansi-color)
+  (with-temp-buffer
+    (insert "a\e[1mb\e[2Kc\e[31;1md\e[0me\e[3")
+    (should (equal (ansi-color-scan-region (point-min) (point-max) nil)
+                   '([(1 2 nil) (2 4 (1)) (4 5 (1 31)) (5 6 nil)] nil 6)))
+    (should (equal (buffer-string) "abcde\e[3"))
+    (should (equal (ansi-color-apply-sequence "31;1m" '(1))
+                   '(1 31))))
+  (with-temp-buffer
+    (insert "xy")
+    (should (equal (ansi-color-scan-region 1 3 '(4))
+                   '([(1 3 (4))] (4) nil))))
+  (with-temp-buffer
+    (let ((ansi-color-context nil))
+      (let ((s (ansi-color-apply "x\e[32my\e[0")))
+        (should (equal s "xy"))
+        (should (null (get-text-property 0 'font-lock-face s)))
+        (should (equal (get-text-property 1 'font-lock-face s)
+                       (ansi-color--find-face '(32)))))
+      (should (equal ansi-color-context '((32) "\e[0")))
+      (let ((s (ansi-color-apply "mz")))
+        (should (equal s "z"))
+        (should (null ansi-color-context))))))
+
+(ert-deftest editfns-tests-delete-leading-lines ()
+  (with-temp-buffer
+    (setq buffer-undo-list nil)
+    (insert "1\n2\n3\n4\n5")
+    (should buffer-undo-list)
+    (should (= (delete-leading-lines 2) 4))
+    (should (equal (buffer-string) "3\n4\n5"))
+    (should (null buffer-undo-list))
+    (should (= (delete-leading-lines 1 nil 2) 0))
+    (should (= (delete-leading-lines 1 nil 1) 2))
+    (should (equal (buffer-string) "4\n5"))
+    (should (= (delete-leading-lines 0 2) 0))
+    (should (= (delete-leading-lines 5) 0))))
+
+;; `replace-match' with text of the same byte length, on either side
+;; of the gap, and with a different number of characters.
+(ert-deftest editfns-tests-replace-match-in-place ()
+  (with-temp-buffer
+    (buffer-enable-undo)
+    (insert "aa bb cc")
+    (undo-boundary)
+    (should (re-search-backward "cc" nil t))
+    (replace-match "dd")
+    (goto-char (point-min))
+    (insert "x")
+    (should (re-search-forward "aa" nil t))
+    (replace-match (string ?é))
+    (should (equal (buffer-string) (concat "x" (string ?é) " bb dd")))
+    (should (= (point-max) 9))
+    (goto-char (point-max))
+    (insert "!")
+    (should (equal (buffer-string) (concat "x" (string ?é) " bb dd!")))
+    (undo-boundary)
+    (primitive-undo 1 (cdr buffer-undo-list))
+    (should (equal (buffer-string) "aa bb cc"))))
+
+(ert-deftest editfns-tests-buffer-line-fields ()
+  (with-temp-buffer
+    (insert "1\tSubject\t\t" (string ?é) "\n2")
+    (goto-char (point-min))
+    (should (equal (buffer-line-fields ?\t)
+                   (list "1" "Subject" "" (string ?é))))
+    (should (eolp))
+    (forward-line 1)
+    (should (equal (buffer-line-fields ?\t) '("2")))
+    (should (equal (buffer-line-fields ?\t) '("")))
+    (should-error (buffer-line-fields ?\n))))
+
+;;; editfns-tests.el ends here
@@ -216,6 +216,18 @@ e.g. \"{(+ 1 2)} 3\" => 3"
    (goto-char eshell-last-input-start)
    (string= (eshell-get-old-input) "echo alpha")))
 
+(ert-deftest eshell-test/direct-pipe ()
+  "Pipe an external command straight into another one."
+  (skip-unless (and (executable-find "echo") (executable-find "sed")))
+  (with-temp-eshell
+   (let ((eshell-direct-pipes t))
+     (eshell-insert-command "*echo alpha | sed s/alpha/beta/")
+     (let ((count 10))
+       (while (and eshell-current-command (> count 0))
+         (sit-for 1)
+         (setq count (1- count))))
+     (eshell-match-result "beta\n"))))
+
 (provide 'esh-test)
 
 ;;; tests/eshell.el ends here
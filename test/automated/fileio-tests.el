@@ -0,0 +1,68 @@
+;;; fileio-tests.el --- tests for src/fileio.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; GNU Emacs is free software: you can redistribute it and/or modify
+;; it under the terms of the GNU General Public License as published by
+;; the Free Software Foundation, either version 3 of the License, or
+;; (at your option) any later version.
+
+;; GNU Emacs is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+
+;; You should have received a copy of the GNU General Public License
+;; along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.
+
+;;; Code:
+
+(require 'ert)
+
+(put 'fileio-tests-handler-2 'operations '(file-exists-p))
+
+(ert-deftest fileio-tests-find-file-name-handler ()
+  "Handlers are found anew whenever the alist changes."
+  (let* ((file-name-handler-alist
+          (list (cons "\\`/fileio-tests:" 'fileio-tests-handler-1)))
+         (name "/fileio-tests:a.gz"))
+    (dotimes (_ 2)
+      (should (eq (find-file-name-handler name 'file-exists-p)
+                  'fileio-tests-handler-1)))
+    ;; The handler whose match starts last wins, for its operations.
+    (push (cons "\\.gz\\'" 'fileio-tests-handler-2) file-name-handler-alist)
+    (should (eq (find-file-name-handler name 'file-exists-p)
+                'fileio-tests-handler-2))
+    (should (eq (find-file-name-handler name 'expand-file-name)
+                'fileio-tests-handler-1))
+    (let ((inhibit-file-name-handlers '(fileio-tests-handler-2))
+          (inhibit-file-name-operation 'file-exists-p))
+      (should (eq (find-file-name-handler name 'file-exists-p)
+                  'fileio-tests-handler-1)))
+    ;; Changing an element in place counts as a change too.
+    (setcar (cadr file-name-handler-alist) "\\`/other:")
+    (should-not (find-file-name-handler name 'expand-file-name))
+    (should (find-file-name-handler "/other:b" 'expand-file-name))
+    (let ((file-name-handler-alist nil))
+      (should-not (find-file-name-handler name 'file-exists-p)))))
+
+(ert-deftest fileio-tests-stale-file-buffers ()
+  (let* ((file (make-temp-file "fileio-tests"))
+         (buf (find-file-noselect file))
+         (other (generate-new-buffer " *fileio-tests*")))
+    (unwind-protect
+        (progn
+          (should-not (stale-file-buffers (list buf other)))
+          (with-current-buffer buf
+            ;; Pretend the file was visited long ago.
+            (set-visited-file-modtime '(0 1)))
+          (should (equal (stale-file-buffers (list buf other)) (list buf)))
+          (should (memq buf (stale-file-buffers)))
+          (should-error (stale-file-buffers '(foo))))
+      (kill-buffer buf)
+      (kill-buffer other)
+      (delete-file file))))
+
+;;; fileio-tests.el ends here
@@ -100,3 +100,219 @@
   (should (compare-strings "こんにちはｺﾝﾆﾁﾊ" nil nil "こんにちはｺﾝﾆﾁﾊ" nil nil))
   (should (= (compare-strings "んにちはｺﾝﾆﾁﾊこ" nil nil "こんにちはｺﾝﾆﾁﾊ" nil nil) 1))
   (should (= (compare-strings "こんにちはｺﾝﾆﾁﾊ" nil nil "んにちはｺﾝﾆﾁﾊこ" nil nil) -1)))
+
+(ert-deftest fns-tests-sort ()
+  (should (equal (sort (list 9 5 2 -1 5 3 8 7 7 0 -2 10) #'<)
+		 '(-2 -1 0 2 3 5 5 7 7 8 9 10)))
+  (should (equal (sort (vector 9 5 2 -1 5 3 8 7 7 0 -2 10) #'<)
+		 [-2 -1 0 2 3 5 5 7 7 8 9 10]))
+  (should (equal (sort (vector "b" "c" "a") #'string<) ["a" "b" "c"]))
+  (should (equal (sort (list 1.5 1 0.5) #'<) '(0.5 1 1.5)))
+  (should (equal (sort nil #'<) nil))
+  (should (equal (sort [] #'<) []))
+  ;; Stability, across several merge passes.
+  (let* ((n 100)
+	 (v (make-vector n nil)))
+    (dotimes (i n)
+      (aset v i (cons (% (* i 7) 5) i)))
+    (sort v (lambda (a b) (< (car a) (car b))))
+    (dotimes (i (1- n))
+      (let ((a (aref v i)) (b (aref v (1+ i))))
+	(should (or (< (car a) (car b))
+		    (and (= (car a) (car b)) (< (cdr a) (cdr b)))))))))
+
+(ert-deftest fns-tests-sxhash-equal ()
+  (dolist (obj (list "abc" "a longer string than one word" 1.5 -7
+		     (list 1 "two" 3.0 (list 'four))
+		     (vector 1 2 (list 3))
+		     (number-sequence 1 20)
+		     (make-bool-vector 10 t)))
+    (should (= (sxhash obj) (sxhash (copy-tree obj t)))))
+  (let ((h (make-hash-table :test 'equal)))
+    (puthash (list "key" 1) 'found h)
+    (should (eq (gethash (list "key" 1) h) 'found))))
+
+(ert-deftest fns-tests-hash-table-remove ()
+  ;; Deleting from the middle of probe runs must keep later keys
+  ;; reachable, including across resizes and copies.
+  (dolist (test '(eq eql equal))
+    (let ((h (make-hash-table :test test :size 3)))
+      (dotimes (i 200)
+	(puthash i (* i i) h))
+      (dotimes (i 200)
+	(when (zerop (% i 3))
+	  (remhash i h)))
+      (let ((c (copy-hash-table h)))
+	(dotimes (i 200)
+	  (should (eq (gethash i h 'none)
+		      (if (zerop (% i 3)) 'none (* i i))))
+	  (should (eq (gethash i c 'none) (gethash i h 'none)))))
+      (should (= (hash-table-count h) 133))
+      (clrhash h)
+      (should (eq (gethash 1 h 'none) 'none)))))
+
+(ert-deftest fns-tests-hash-table-from-pairs ()
+  (let ((h (hash-table-from-pairs '((a . 1) (b . 2) (a . 3)))))
+    (should (= (hash-table-count h) 2))
+    (should (eq (gethash 'a h) 1))
+    (should (eq (gethash 'b h) 2)))
+  (let ((h (hash-table-from-pairs (vector (cons "x" 1) (cons "y" 2)) 'equal)))
+    (should (eq (gethash "y" h) 2)))
+  (should (= (hash-table-count (hash-table-from-pairs nil)) 0))
+  (should-error (hash-table-from-pairs '(a))))
+
+(ert-deftest fns-tests-hash-table-growth ()
+  ;; Lookups and removals must see entries whose move into the grown
+  ;; index is still pending.
+  (let ((h (make-hash-table :test 'eq :size 4 :rehash-size 2)))
+    (dotimes (i 1000)
+      (puthash i i h)
+      (when (and (>= i 5) (zerop (% i 7)))
+	(remhash (- i 5) h))
+      (should (eq (gethash i h) i)))
+    (dotimes (i 1000)
+      (should (eq (gethash i h 'none)
+		  (if (and (< i 990) (zerop (% (+ i 5) 7))) 'none i))))))
+
+(ert-deftest fns-tests-hash-table-read-mostly ()
+  (let ((h (make-hash-table :test 'equal :size 4 :concurrency 'read-mostly)))
+    (dotimes (i 100)
+      (puthash (number-to-string i) i h)
+      (remhash (number-to-string (/ i 2)) h))
+    (should (= (hash-table-count h) 50))
+    (dotimes (i 100)
+      (should (eq (gethash (number-to-string i) h) (and (>= i 50) i))))
+    (clrhash h)
+    (should (= (hash-table-count h) 0))
+    (puthash "a" 1 h)
+    (should (eq (gethash "a" (copy-hash-table h)) 1)))
+  (should-error (make-hash-table :concurrency 'bogus))
+  (define-hash-table-test 'fns-tests-test #'eq #'sxhash)
+  (should-error (make-hash-table :test 'fns-tests-test
+				 :concurrency 'read-mostly)))
+
+(ert-deftest fns-tests-concat-plain-strings ()
+  (should (equal (concat "ab" "" "cd") "abcd"))
+  (should (equal (concat "é" "ü") "éü"))
+  (should (multibyte-string-p (concat "é" "ü")))
+  (should (equal (concat "a" "é") "aé"))
+  (let ((s (concat "x")))
+    (should (equal s "x"))
+    (should-not (eq s (concat s))))
+  (should (equal (get-text-property 1 'face (concat "a" (propertize "b" 'face 'bold)))
+		 'bold)))
+
+(ert-deftest fns-tests-string-builder ()
+  (let ((b (make-string-builder)))
+    (should (string-builder-p b))
+    (should (eq (type-of b) 'string-builder))
+    (should (equal (string-builder-string b) ""))
+    (string-builder-append b "foo" ?\s)
+    (should-not (multibyte-string-p (string-builder-string b)))
+    (string-builder-append b "bär" "\377")
+    (should (= (string-builder-length b) 8))
+    (should (equal (string-builder-string b)
+		   (concat "foo bär" (string-to-multibyte "\377"))))
+    (should (equal (string-builder-string b t)
+		   (string-builder-string (string-builder-append
+					   (make-string-builder)
+					   "foo " "bär" "\377"))))
+    (should (= (string-builder-length b) 0))
+    (prin1 '(a "b" 1.5) b)
+    (princ " é" b)
+    (should (equal (string-builder-string b) "(a \"b\" 1.5) é"))
+    (should-error (string-builder-append b 'foo))
+    (should-error (string-builder-append [1 2 3] "x"))))
+
+(ert-deftest fns-tests-base64 ()
+  (should (equal (base64-encode-string "") ""))
+  (should (equal (base64-encode-string "f") "Zg=="))
+  (should (equal (base64-encode-string "fo") "Zm8="))
+  (should (equal (base64-encode-string "foo") "Zm9v"))
+  (should (equal (base64-decode-string "Zm9v\nYmFy") "foobar"))
+  (should-error (base64-decode-string "Zm9v!"))
+  ;; Lines break after 76 characters, with no trailing newline.
+  (dolist (n '(56 57 58 113 114 115 171 1000))
+    (let* ((data (apply 'unibyte-string
+			(mapcar (lambda (i) (% (* i 7) 256))
+				(number-sequence 1 n))))
+	   (encoded (base64-encode-string data)))
+      (should (equal (base64-decode-string encoded) data))
+      (should (equal (base64-decode-string (base64-encode-string data t))
+		     data))
+      (should-not (string-match-p "\n\\'" encoded))
+      (dolist (line (split-string encoded "\n"))
+	(should (<= (length line) 76)))
+      (should (equal (length (car (split-string encoded "\n")))
+		     (min 76 (* 4 (/ (+ n 2) 3)))))))
+  (with-temp-buffer
+    (insert "abcé")
+    (should-error (base64-encode-region (point-min) (point-max)))
+    (erase-buffer)
+    (insert "hello")
+    (base64-encode-region (point-min) (point-max))
+    (should (equal (buffer-string) "aGVsbG8="))
+    (base64-decode-region (point-min) (point-max))
+    (should (equal (buffer-string) "hello"))))
+
+(ert-deftest fns-tests-secure-hash-buffer ()
+  (let ((text (concat (make-string 1000 ?a) "\nbc\n")))
+    (with-temp-buffer
+      (setq buffer-file-coding-system 'utf-8-unix)
+      (insert text)
+      ;; Move the gap into the middle of the text.
+      (goto-char 500)
+      (insert "x")
+      (delete-char -1)
+      (should (equal (secure-hash 'sha256 (current-buffer))
+                     (secure-hash 'sha256 text)))
+      (should (equal (md5 (current-buffer) 10 600)
+                     (md5 (substring text 9 599))))
+      (insert "é")
+      (should (equal (secure-hash 'sha1 (current-buffer) nil nil t)
+                     (secure-hash 'sha1 (encode-coding-string
+                                         (buffer-string) 'utf-8-unix)
+                                  nil nil t))))))
+
+(ert-deftest fns-tests-buffer-hash ()
+  (with-temp-buffer
+    (insert (make-string 100 ?a))
+    (let ((hash (buffer-hash)))
+      (should (= (length hash) 16))
+      (goto-char 37)
+      (insert "b")
+      (should-not (equal (buffer-hash) hash))
+      (delete-char -1)
+      (goto-char (point-min))
+      (should (equal (buffer-hash) hash))
+      (narrow-to-region 1 2)
+      (should (equal (buffer-hash (current-buffer)) hash)))))
+
+(ert-deftest fns-tests-string-scheme ()
+  (let* ((string (string ?h ?é ?l ?l ?o))
+         (scheme (string-to-scheme string)))
+    (should (equal (string-from-scheme scheme) string))
+    (should (equal (string-from-scheme (string-to-scheme string)) string))
+    (aset string 1 ?e)
+    (should (equal (string-from-scheme (string-to-scheme string)) "hello"))
+    (should (equal (string-from-scheme scheme) (string ?h ?é ?l ?l ?o)))
+    (should (equal (string-from-scheme (string-to-scheme "")) ""))))
+
+(ert-deftest fns-tests-hexl-region ()
+  (with-temp-buffer
+    (set-buffer-multibyte nil)
+    (insert "Hello\0\377")
+    (should (= (hexl-encode-region (point-min) (point-max)) 59))
+    (should (equal (buffer-string)
+                   "00000000: 4865 6c6c 6f00 ff                        Hello..\n"))
+    (should (= (hexl-decode-region (point-min) (point-max)) 7))
+    (should (equal (buffer-string) "Hello\0\377")))
+  (with-temp-buffer
+    (let ((bytes (apply #'unibyte-string (number-sequence 0 255))))
+      (insert bytes)
+      (dolist (group '(1 2 4 8))
+        (hexl-encode-region (point-min) (point-max) group t)
+        (should (= (count-lines (point-min) (point-max)) 16))
+        (hexl-decode-region (point-min) (point-max) group)
+        (should (equal (encode-coding-string (buffer-string) 'raw-text)
+                       bytes))))))
@@ -83,6 +83,28 @@ function ABC_D()
 }
 " '("a" "b" "c" "ABC_D"))
 
+;; Rescanning after an edit reuses the items outside the changed
+;; definition, but must give the same index as a full scan.
+(ert-deftest imenu-incremental-rescan ()
+  (with-temp-buffer
+    (emacs-lisp-mode)
+    (insert "(defun a () 1)\n\n(defvar b nil)\n\n(defun c ()\n  2)\n")
+    (funcall imenu-create-index-function)
+    (goto-char (point-min))
+    (search-forward "(defun c")
+    (replace-match "(defun cc")
+    (goto-char (point-max))
+    (insert "\n(defun d () 3)\n")
+    (goto-char (point-min))
+    (search-forward "(defvar b nil)")
+    (replace-match "")
+    (let ((result (imenu-simple-scan-deftest-gather-strings-from-list
+                   (funcall imenu-create-index-function))))
+      (should (equal (sort result #'string-lessp) '("a" "cc" "d")))
+      (should (equal result
+                     (imenu-simple-scan-deftest-gather-strings-from-list
+                      (imenu--generic-function imenu-generic-expression)))))))
+
 (provide 'imenu-tests)
 
 ;;; imenu-tests.el ends here
@@ -59,6 +59,33 @@
 	(inotify-rm-watch wd)
 	(delete-file temp-file)))))
 
+(ert-deftest inotify-file-watch-recursive ()
+  "Test if watching a directory tree in batches works."
+
+  (skip-unless (featurep 'inotify))
+  (let* ((temp-dir (make-temp-file "inotify-recursive" t))
+	 (events nil)
+	 (wd (inotify-add-watch temp-dir '(create batch recursive)
+				(lambda (batch)
+				  (setq events
+					(append events
+						(append batch nil))))))
+	 (names (lambda () (mapcar (lambda (ev) (nth 2 ev)) events))))
+    (unwind-protect
+	(let ((end (+ (float-time) 5)))
+	  (make-directory (expand-file-name "sub" temp-dir))
+	  (read-event nil nil 1)
+	  (write-region "" nil (expand-file-name "sub/file" temp-dir))
+	  (while (and (not (member "sub/file" (funcall names)))
+		      (< (float-time) end))
+	    (read-event nil nil 0.1))
+	  (should (member "sub" (funcall names)))
+	  (should (member "sub/file" (funcall names)))
+	  (dolist (ev events)
+	    (should (equal (car ev) wd))))
+      (inotify-rm-watch wd)
+      (delete-directory temp-dir t))))
+
 (provide 'inotify-tests)
 
 ;;; inotify-tests.el ends here.
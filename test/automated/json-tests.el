@@ -0,0 +1,92 @@
+;;; json-tests.el --- Test suite for JSON parsing and serialization.
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; GNU Emacs is free software: you can redistribute it and/or modify
+;; it under the terms of the GNU General Public License as published by
+;; the Free Software Foundation, either version 3 of the License, or
+;; (at your option) any later version.
+
+;; GNU Emacs is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+
+;; You should have received a copy of the GNU General Public License
+;; along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.
+
+;;; Code:
+
+(require 'ert)
+(require 'json)
+
+(ert-deftest json-tests-parse-string ()
+  (should (equal (json-parse-string "[1, -2.5, \"a\\nb\", true, false, null]")
+                 [1 -2.5 "a\nb" t :false :null]))
+  (should (equal (json-parse-string "{\"a\": [], \"b\": {\"c\": 1}}"
+                                    :object-type 'alist :array-type 'list)
+                 '((a) (b (c . 1)))))
+  (should (equal (json-parse-string "{\"a\": 1, \"b\": 2}" :object-type 'plist)
+                 '(:a 1 :b 2)))
+  (let ((table (json-parse-string "{\"k\": 1, \"k\": 2}")))
+    (should (= (hash-table-count table) 1))
+    (should (equal (gethash "k" table) 2)))
+  (should (equal (json-parse-string "\"\\u00e9\\ud83d\\ude00\"")
+                 (string ?é #x1f600)))
+  (should (floatp (json-parse-string "1e400")))
+  (should (equal (json-parse-string "null" :null-object nil) nil)))
+
+(ert-deftest json-tests-parse-errors ()
+  (should-error (json-parse-string "[1,]") :type 'json-parse-error)
+  (should-error (json-parse-string "[1") :type 'json-end-of-file)
+  (should-error (json-parse-string "[1") :type 'end-of-file)
+  (should-error (json-parse-string "1 2") :type 'json-trailing-content)
+  (should-error (json-parse-string (concat (make-string 3000 ?\[)
+                                           (make-string 3000 ?\])))
+                :type 'json-object-too-deep))
+
+(ert-deftest json-tests-parse-buffer ()
+  (with-temp-buffer
+    (insert "  {\"a\": \"é\"} rest")
+    (goto-char (point-min))
+    (should (equal (json-parse-buffer :object-type 'alist) '((a . "é"))))
+    (should (looking-at " rest"))))
+
+(ert-deftest json-tests-serialize ()
+  (should (equal (json-serialize [1 2.5 "a\"b" t :false :null nil])
+                 "[1,2.5,\"a\\\"b\",true,false,null,null]"))
+  (should (equal (json-serialize '((a . 1) (b . [])))
+                 "{\"a\":1,\"b\":[]}"))
+  (should (equal (json-serialize '(:a 1 :b (1 2)))
+                 "{\"a\":1,\"b\":[1,2]}"))
+  (should (equal (json-serialize (string ?é #x1f600))
+                 "\"\\u00e9\\ud83d\\ude00\""))
+  (should-error (json-serialize '((1 . 2))) :type 'wrong-type-argument)
+  (should-error (json-serialize 1.0e+INF) :type 'wrong-type-argument)
+  (with-temp-buffer
+    (json-insert '((a . t)))
+    (should (equal (buffer-string) "{\"a\":true}"))))
+
+(ert-deftest json-tests-round-trip ()
+  (let ((json "{\"name\":\"x\",\"items\":[1,{\"deep\":[true,false,null]}]}"))
+    (should (equal (json-serialize (json-parse-string json :object-type 'alist))
+                   json))
+    (should (equal (json-serialize (json-parse-string json :object-type 'plist))
+                   json))))
+
+(ert-deftest json-tests-json-el ()
+  (let ((json-object-type 'alist))
+    (should (equal (json-read-from-string "{\"a\": 1, \"b\": [2, null]}")
+                   '((a . 1) (b . [2 nil]))))
+    (let ((json-key-type 'string))
+      (should (equal (json-read-from-string "{\"a\": 1, \"b\": 2}")
+                     '(("a" . 1) ("b" . 2))))))
+  (let ((json-object-type 'plist))
+    (should (equal (json-read-from-string "{\"a\": 1, \"b\": false}")
+                   '(:a 1 :b :json-false))))
+  (should (equal (json-encode '((a . 1) (b . :json-false)))
+                 "{\"a\":1,\"b\":false}")))
+
+;;; json-tests.el ends here
@@ -0,0 +1,97 @@
+;;; keymap-tests.el --- tests for src/keymap.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+;; Sparse keymaps with many bindings are looked up through an index,
+;; which must give the same answers as a scan of the keymap.
+(ert-deftest keymap-tests-large-sparse-keymap ()
+  (let ((map (make-sparse-keymap))
+        (parent (make-sparse-keymap))
+        (prefix (make-sparse-keymap)))
+    (dotimes (i 200)
+      (define-key map (vector (intern (format "f%d" i)))
+        (intern (format "cmd-%d" i))))
+    (define-key parent [f1000] 'parent-cmd)
+    (define-key parent [f3] 'shadowed-cmd)
+    (set-keymap-parent map parent)
+    (dotimes (_ 2)
+      (should (eq (lookup-key map [f3]) 'cmd-3))
+      (should (eq (lookup-key map [f199]) 'cmd-199))
+      (should (eq (lookup-key map [f1000]) 'parent-cmd))
+      (should-not (lookup-key map [f2000])))
+    ;; Changes show up at once.
+    (define-key map [f3] 'new-cmd)
+    (should (eq (lookup-key map [f3]) 'new-cmd))
+    (define-key map [f3] nil)
+    (should-not (lookup-key map [f3]))
+    (define-key map [f2000] 'added-cmd)
+    (should (eq (lookup-key map [f2000]) 'added-cmd))
+    (set-keymap-parent map nil)
+    (should-not (lookup-key map [f1000]))
+    ;; Prefix keys in large maps still merge with the parent.
+    (define-key prefix [f1] 'inner-cmd)
+    (define-key parent [f5 f2] 'parent-inner-cmd)
+    (set-keymap-parent map parent)
+    (define-key map [f5] prefix)
+    (should (eq (lookup-key map [f5 f1]) 'inner-cmd))
+    (should (eq (lookup-key map [f5 f2]) 'parent-inner-cmd))
+    ;; A default binding makes the map be scanned.
+    (define-key map [t] 'default-cmd)
+    (should (eq (lookup-key map [f2001] t) 'default-cmd))
+    (should (eq (lookup-key map [f7] t) 'cmd-7))))
+
+;; Reverse-maps are kept for each keymap, and dropped only when a
+;; keymap they were built from changes.
+(defun keymap-tests--where-is (maps)
+  (sort (mapcar #'key-description
+                (where-is-internal 'keymap-tests-cmd maps))
+        #'string<))
+
+(ert-deftest keymap-tests-where-is-internal ()
+  (let ((map (make-sparse-keymap))
+        (other (make-sparse-keymap))
+        (parent (make-sparse-keymap))
+        (prefix (make-sparse-keymap)))
+    (define-key map [f1] 'keymap-tests-cmd)
+    (define-key other [f2] 'keymap-tests-cmd)
+    (should (equal (keymap-tests--where-is (list map other)) '("<f1>" "<f2>")))
+    (should (equal (keymap-tests--where-is (list map)) '("<f1>")))
+    (define-key other [f3] 'keymap-tests-cmd)
+    (should (equal (keymap-tests--where-is (list other)) '("<f2>" "<f3>")))
+    (should (equal (keymap-tests--where-is (list map other))
+                   '("<f1>" "<f2>" "<f3>")))
+    ;; Changes to prefix keymaps and their parents show up.
+    (define-key map [f4] prefix)
+    (should (equal (keymap-tests--where-is (list map)) '("<f1>")))
+    (define-key prefix [f5] 'keymap-tests-cmd)
+    (should (equal (keymap-tests--where-is (list map)) '("<f1>" "<f4> <f5>")))
+    (set-keymap-parent prefix parent)
+    (define-key parent [f6] 'keymap-tests-cmd)
+    (should (equal (keymap-tests--where-is (list map))
+                   '("<f1>" "<f4> <f5>" "<f4> <f6>")))
+    (define-key map [f1] nil)
+    (should (equal (keymap-tests--where-is (list map other))
+                   '("<f2>" "<f3>" "<f4> <f5>" "<f4> <f6>")))))
+
+;;; keymap-tests.el ends here
@@ -0,0 +1,101 @@
+;;; lread-tests.el --- tests for src/lread.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+(ert-deftest lread-tests-intern ()
+  (let ((ob (make-vector 17 0)))
+    (should-not (intern-soft "lread-tests-foo" ob))
+    (let ((sym (intern "lread-tests-foo" ob)))
+      (should (eq sym (intern "lread-tests-foo" ob)))
+      (should (eq sym (intern-soft "lread-tests-foo" ob)))
+      (should (eq sym (intern-soft sym ob)))
+      ;; Symbols with the same name in different obarrays are distinct.
+      (should-not (eq sym (intern "lread-tests-foo")))
+      (should (unintern sym ob))
+      (should-not (intern-soft "lread-tests-foo" ob))
+      (should-not (eq sym (intern "lread-tests-foo" ob))))))
+
+(ert-deftest lread-tests-intern-nil-t ()
+  (should (eq (intern "nil") nil))
+  (should (eq (intern "t") t))
+  (should (eq (intern-soft "nil") nil))
+  (should (eq (read "nil") nil))
+  (should (eq (read "t") t)))
+
+(ert-deftest lread-tests-intern-multibyte ()
+  (let ((sym (intern "lread-tests-été")))
+    (should (eq sym (read "lread-tests-été")))
+    (should (equal (symbol-name sym) "lread-tests-été"))))
+
+(ert-deftest lread-tests-read-large-file ()
+  "Every symbol read from a large file is the interned symbol."
+  (let ((file (expand-file-name "../../lisp/subr.el"
+                                (file-name-directory
+                                 (or load-file-name buffer-file-name))))
+        (forms 0))
+    (skip-unless (file-readable-p file))
+    (with-temp-buffer
+      (insert-file-contents file)
+      (goto-char (point-min))
+      (condition-case nil
+          (while t
+            (let ((form (read (current-buffer))))
+              (setq forms (1+ forms))
+              (when (and (consp form) (symbolp (car form)))
+                (should (eq (car form)
+                            (intern (symbol-name (car form))))))))
+        (end-of-file nil)))
+    (should (> forms 100))))
+
+(ert-deftest lread-tests-read-vector ()
+  (should (equal (read "[]") []))
+  (should (equal (read "[a (b [c d]) \"e\" [[]]]")
+                 (vector 'a '(b [c d]) "e" [[]])))
+  (should (equal (read "[1 [2 [3 [4]]] 5]") [1 [2 [3 [4]]] 5]))
+  (should-error (read "[1 . 2]") :type 'invalid-read-syntax)
+  (should-error (read "[1 2)") :type 'invalid-read-syntax)
+  ;; An error inside a vector must not leave its elements behind.
+  (should-error (read "[1 [2 3") :type 'end-of-file)
+  (should (equal (read "[4 5]") [4 5]))
+  (let ((v (read "#1=[a #1# b]")))
+    (should (eq (aref v 1) v))))
+
+;; A directory's index must follow files added to it, and must not be
+;; trusted while the directory was changed too recently to tell.
+(ert-deftest lread-tests-locate-file-index ()
+  (let ((dir (make-temp-file "lread-tests" t)))
+    (unwind-protect
+        (progn
+          (write-region "" nil (expand-file-name "a.el" dir))
+          (set-file-times dir '(0 0))
+          (should (equal (locate-file "a" (list dir) '(".elc" ".el"))
+                         (expand-file-name "a.el" dir)))
+          (should-not (locate-file "b" (list dir) '(".elc" ".el")))
+          (write-region "" nil (expand-file-name "b.el" dir))
+          (should (locate-file "b" (list dir) '(".elc" ".el")))
+          (set-file-times dir '(0 0))
+          (should (locate-file "b" (list dir) '(".elc" ".el"))))
+      (delete-directory dir t))))
+
+;;; lread-tests.el ends here
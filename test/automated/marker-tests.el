@@ -0,0 +1,59 @@
+;;; marker-tests.el --- tests for src/marker.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+(defun marker-tests--check-positions (step)
+  "Check `position-bytes' and `byte-to-position' every STEP chars."
+  (let ((pos (point-min))
+        (byte (position-bytes (point-min))))
+    (while (< pos (point-max))
+      (should (= (position-bytes pos) byte))
+      (should (= (byte-to-position byte) pos))
+      (dotimes (_ step)
+        (when (< pos (point-max))
+          (setq byte (+ byte (string-bytes (string (char-after pos))))
+                pos (1+ pos)))))))
+
+(ert-deftest marker-tests-position-index ()
+  "Conversions stay right in a large multibyte buffer being edited."
+  (with-temp-buffer
+    (dotimes (i 3000)
+      (insert (format "line %d: ascii, é, 日本語, %c\n" i (+ ?α (% i 20)))))
+    (marker-tests--check-positions 97)
+    ;; Edits at the start, the middle and the end.
+    (goto-char (point-min))
+    (insert "日本")
+    (goto-char (/ (point-max) 2))
+    (delete-char 10)
+    (insert "ééé")
+    (goto-char (point-max))
+    (insert "末尾")
+    (marker-tests--check-positions 89)
+    (transpose-regions 1 20 (- (point-max) 40) (- (point-max) 10))
+    (marker-tests--check-positions 101)
+    (set-buffer-multibyte nil)
+    (set-buffer-multibyte t)
+    (marker-tests--check-positions 103)))
+
+;;; marker-tests.el ends here
@@ -0,0 +1,37 @@
+;;; print-tests.el --- tests for src/print.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+(ert-deftest print-tests-function-accepts-strings ()
+  (let* ((out nil)
+         (fun (lambda (x) (push x out))))
+    (prin1 '(a "b" 1) fun)
+    (should (equal (apply #'string (nreverse out)) "(a \"b\" 1)"))
+    (setq out nil)
+    (let ((print-function-accepts-strings t))
+      (prin1 '(a "b" 1) fun)
+      (print "é" fun))
+    (should (equal (nreverse out) '("(a \"b\" 1)" "\n\"é\"\n")))))
+
+;;; print-tests.el ends here
@@ -50,4 +50,85 @@
   (should
    (process-test-sentinel-wait-function-working-p (lambda () (sit-for 0.01 t)))))
 
+(ert-deftest process-test-read-output-max ()
+  "Large reads pass all of a process's output to the filter intact."
+  (skip-unless (executable-find "bash"))
+  (let* ((output nil)
+         (proc (let ((read-process-output-max (* 1024 1024))
+                     (read-process-output-coalesce t)
+                     (process-connection-type nil))
+                 (start-process "test" nil "bash" "-c"
+                                "printf 'x%.0s' {1..100000}")))
+         (start-time (float-time)))
+    (set-process-filter proc (lambda (_proc string)
+                               (push string output)))
+    (while (and (process-live-p proc)
+                (< (- (float-time) start-time) 10))
+      (accept-process-output proc 0.1))
+    (let ((text (apply #'concat (nreverse output))))
+      (should (= (length text) 100000))
+      (should (string-match-p "\\`x+\\'" text)))))
+
+(ert-deftest process-test-call-process-large-output ()
+  "Output of `call-process' is decoded and inserted at point."
+  (skip-unless (executable-find "bash"))
+  (with-temp-buffer
+    (insert "<>")
+    (goto-char 2)
+    (let ((coding-system-for-read 'utf-8-unix))
+      (should (eq (call-process "bash" nil t nil "-c"
+                                "for i in {1..20000}; do echo \"$i é\"; done")
+                  0)))
+    (should (= (char-after) ?>))
+    (should (= (count-lines (point-min) (point)) 20000))
+    (goto-char (point-min))
+    (should (looking-at "<1 é\n2 é\n"))
+    (goto-char (point-max))
+    (should (looking-back "\n20000 é\n>" nil))))
+
+(ert-deftest process-test-call-process-region-pipe ()
+  "A large region is streamed to the process while its output is read."
+  (skip-unless (executable-find "cat"))
+  (with-temp-buffer
+    (let ((coding-system-for-read 'utf-8-unix)
+          (coding-system-for-write 'utf-8-unix))
+      (dotimes (i 50000)
+        (insert (format "%d é\n" i)))
+      (let ((text (buffer-string))
+            (call-process-region-use-pipe t))
+        (with-temp-buffer
+          (let ((out (current-buffer)))
+            (with-temp-buffer
+              (insert text)
+              (should (eq (call-process-region (point-min) (point-max)
+                                               "cat" nil out)
+                          0))))
+          (should (equal (buffer-string) text)))
+        ;; Replace the region with the output, as a filter does.
+        (goto-char (point-min))
+        (insert "<")
+        (goto-char (point-max))
+        (insert ">")
+        (goto-char 10)
+        (should (eq (call-process-region 2 (1- (point-max)) "cat" t t) 0))
+        (should (equal (buffer-string) (concat "<" text ">")))))))
+
+(ert-deftest process-test-undecided-output ()
+  "Output is detected as UTF-8 once it stops being ASCII."
+  (skip-unless (executable-find "bash"))
+  (let* ((output nil)
+         (proc (let ((process-connection-type nil))
+                 (start-process "test" nil "bash" "-c"
+                                "printf 'x%.0s' {1..50000}; sleep 0.2; \
+printf '\\n\\303\\251\\n'")))
+         (start-time (float-time)))
+    (set-process-coding-system proc 'prefer-utf-8 'prefer-utf-8)
+    (set-process-filter proc (lambda (_proc string)
+                               (push string output)))
+    (while (and (process-live-p proc)
+                (< (- (float-time) start-time) 10))
+      (accept-process-output proc 0.1))
+    (let ((text (apply #'concat (nreverse output))))
+      (should (equal text (concat (make-string 50000 ?x) "\né\n"))))))
+
 (provide 'process-tests)
@@ -28,4 +28,86 @@
 The test data is in `compile-tests--test-regexps-data'."
   (should (string-match (regexp-opt-charset '(?^)) "a^b")))
 
+(ert-deftest regexp-tests-cache ()
+  "Compiled regexps are reused, and evicted least recently used first."
+  (let ((regexp-cache-size 10)
+        (case-fold-search t))
+    (string-match "regexp-tests-[a-z]+" "x")
+    (let* ((stats (regexp-cache-statistics))
+           (hits (plist-get stats 'hits)))
+      (should (= (plist-get stats 'size) 10))
+      (string-match "regexp-tests-[a-z]+" "regexp-tests-foo")
+      (should (= (plist-get (regexp-cache-statistics) 'hits) (1+ hits))))
+    ;; The same pattern under a different case table or POSIX mode
+    ;; is a separate entry.
+    (let ((misses (plist-get (regexp-cache-statistics) 'misses)))
+      (let ((case-fold-search nil))
+        (string-match "regexp-tests-[a-z]+" "regexp-tests-foo"))
+      (posix-string-match "regexp-tests-[a-z]+" "regexp-tests-foo")
+      (should (= (plist-get (regexp-cache-statistics) 'misses)
+                 (+ 2 misses))))
+    (dotimes (i 20)
+      (string-match (format "regexp-tests-%d" i) "x"))
+    (should (<= (plist-get (regexp-cache-statistics) 'entries) 10))
+    (let ((misses (plist-get (regexp-cache-statistics) 'misses)))
+      (string-match "regexp-tests-19" "regexp-tests-19")
+      (string-match "regexp-tests-0" "regexp-tests-0")
+      (should (= (plist-get (regexp-cache-statistics) 'misses)
+                 (1+ misses))))
+    (should-error (string-match "regexp-tests-\\(" "x")
+                  :type 'invalid-regexp)
+    (should (string-match "regexp-tests-19" "regexp-tests-19"))))
+
+(ert-deftest regexp-tests-literal-prefix ()
+  "Searches for patterns starting with a literal find every match."
+  (with-temp-buffer
+    (insert (make-string 500 ?x) "(defun foo)" (make-string 500 ?y)
+            "(defunct)" "\u00e9defun")
+    (goto-char (point-min))
+    (should (re-search-forward "\\_<defun\\_>" nil t))
+    (should (= (match-beginning 0) 502))
+    (should-not (re-search-forward "\\_<defun\\_>" nil t))
+    (goto-char (point-min))
+    (should (= (how-many "def\\(un\\)") 3))
+    ;; Move the gap into the middle of the literal.
+    (goto-char 505)
+    (insert "z")
+    (delete-char -1)
+    (goto-char (point-min))
+    (should (re-search-forward "(defun f" nil t))
+    (should (= (match-beginning 0) 501))
+    (goto-char (point-min))
+    (should (re-search-forward "defunct" nil t))
+    (should (re-search-forward "defun" nil t))
+    (should (eobp)))
+  (should (= (string-match "abcd" (concat (make-string 300 ?a) "abcd")) 300))
+  (should-not (string-match "abcd" (concat (make-string 300 ?a) "abc"))))
+
+;; Without the NFA matcher, each of these takes exponential time.
+(ert-deftest regexp-tests-nested-loops ()
+  "Patterns that nest repetitions match in linear time."
+  (let ((text (make-string 5000 ?a)))
+    (should-not (string-match "\\(a*\\)*b" text))
+    (should-not (string-match "\\(?:a\\|aa\\)*c" text))
+    (should (eq (string-match "\\(a+\\)*$" text) 0))
+    (with-temp-buffer
+      (insert text "b")
+      (goto-char (point-min))
+      (should (re-search-forward "\\(\\(a\\|b\\)+\\)+b" nil t))
+      (should (eobp))
+      (goto-char (point-min))
+      (should-not (re-search-forward "\\(a*\\)*c" nil t))
+      (should (bobp))
+      (should (looking-at "\\(?:a*\\)*b"))
+      (goto-char (point-max))
+      (should (re-search-backward "\\(?:a*\\)*b" nil t))
+      (should (= (point) (1- (point-max))))))
+  ;; The groups come out as the backtracking matcher sets them.
+  (should (eq (string-match "x\\(a*\\)*\\(b\\)" "xaaab") 0))
+  (should (equal (match-data) '(0 5 4 4 4 5)))
+  (should (eq (string-match "\\([ab]?\\)+c" "abc") 0))
+  (should (equal (match-data) '(0 3 2 2)))
+  (should (eq (string-match "\\(?:\\(a\\)\\|\\(b\\)\\)*$" "ab") 0))
+  (should (equal (match-data) '(0 2 0 1 1 2))))
+
 ;;; regexp-tests.el ends here.
@@ -0,0 +1,106 @@
+;;; search-tests.el --- tests for src/search.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+(ert-deftest search-tests-count-lines ()
+  "Line motion agrees with and without the newline cache."
+  (dolist (cache '(nil t))
+    (with-temp-buffer
+      (setq cache-long-scans cache)
+      ;; Lines of varying length, some longer than a word or the
+      ;; cache's minimum run, some empty.
+      (dotimes (i 2000)
+        (insert (make-string (% (* i 37) 300) ?a) "\n"))
+      (insert "tail")
+      (should (= (count-lines (point-min) (point-max)) 2001))
+      (goto-char (point-min))
+      (should (= (forward-line 1000) 0))
+      (should (= (line-number-at-pos) 1001))
+      (should (= (forward-line -999) 0))
+      (should (= (line-number-at-pos) 2))
+      (should (= (forward-line -5) -4))
+      (should (bobp))
+      (should (= (forward-line 5000) 2999))
+      (should (eobp))
+      (goto-char (point-max))
+      (should (= (forward-line -2000) 0))
+      (should (= (line-number-at-pos) 1))
+      (should (= (count-lines 2 (point-max)) 2000)))))
+
+(ert-deftest search-tests-re-search-forward-multi ()
+  "Matches of several regexps come back merged in buffer order."
+  (with-temp-buffer
+    (insert "(defun foo) bar foo")
+    (goto-char (point-min))
+    (let ((regexps ["(defun \\(\\w+\\)" "foo" "bar"])
+          (cache (make-vector 3 nil))
+          found)
+      (while (let ((i (re-search-forward-multi regexps nil cache)))
+               (when i
+                 (push (list i (match-beginning 0) (match-end 0)) found))))
+      ;; The match of "foo" inside the first one is found too.
+      (should (equal (nreverse found)
+                     '((0 1 11) (1 8 11) (2 13 16) (1 17 20)))))
+    ;; Without a cache, the first of the regexps matching earliest wins.
+    (goto-char (point-min))
+    (should (eq (re-search-forward-multi ["fo+" "\\w+" "("]) 2))
+    (should (= (point) 2))
+    (should (eq (re-search-forward-multi ["fo+" "\\w+"]) 1))
+    (should (equal (match-data t) '(2 7)))
+    (should (eq (re-search-forward-multi ["xyz" "o+"] 10) 1))
+    (should (= (point) 10))
+    (should-not (re-search-forward-multi ["xyz" "bar"] 15))
+    (should (= (point) 10))))
+
+(ert-deftest search-tests-replace-match-across-gap ()
+  "Subexpressions that straddle the gap are substituted whole."
+  (with-temp-buffer
+    (insert "xx abcdef yy")
+    ;; Leave the gap in the middle of the match.
+    (goto-char 7)
+    (insert "-")
+    (delete-char -1)
+    (goto-char (point-min))
+    (should (re-search-forward "a\\(b\\(cd\\)e\\)f" nil t))
+    (replace-match "[\\2|\\1|\\&]")
+    (should (equal (buffer-string) "xx [cd|bcde|abcdef] yy"))))
+
+(ert-deftest search-tests-re-search-forward-all ()
+  "All the matches are returned, as successive searches find them."
+  (with-temp-buffer
+    (insert "foo bar\nbaz\n\nfoo")
+    (goto-char (point-min))
+    (should (equal (re-search-forward-all "ba.") [5 8 9 12]))
+    (should (equal (re-search-forward-all "ba." 11) [5 8]))
+    (should (equal (re-search-forward-all "x*") []))
+    ;; An empty match is only left out where the search starts.
+    (should (equal (re-search-forward-all "^") [9 9 13 13 14 14]))
+    (should (equal (re-search-forward-all "o*") [2 4 15 17]))
+    (should (= (point) (point-min)))
+    (should (= (how-many "^") 3))
+    (should (= (how-many "o" 3) 3))
+    (let ((case-fold-search t))
+      (should (equal (re-search-forward-all "FOO") [1 4 14 17])))))
+
+;;; search-tests.el ends here
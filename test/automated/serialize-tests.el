@@ -0,0 +1,87 @@
+;;; serialize-tests.el --- tests for src/serialize.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+(defun serialize-tests-round-trip (object)
+  (deserialize-object (serialize-object object)))
+
+(ert-deftest serialize-tests-atoms ()
+  (dolist (object (list nil t 0 1 -1 most-positive-fixnum
+                        most-negative-fixnum 1.5 -0.0 1.0e+INF
+                        'foo :bar "" "abc" "été" "\377"
+                        (string-to-multibyte "\377")))
+    (should (equal (serialize-tests-round-trip object) object)))
+  (let ((s (serialize-tests-round-trip (make-symbol "foo"))))
+    (should (equal (symbol-name s) "foo"))
+    (should-not (eq s (intern-soft "foo"))))
+  (should (eq (serialize-tests-round-trip 'serialize-tests-atoms)
+              'serialize-tests-atoms))
+  (should (multibyte-string-p
+           (serialize-tests-round-trip (string-to-multibyte "\377"))))
+  (should-error (serialize-object (current-buffer))))
+
+(ert-deftest serialize-tests-structure ()
+  (let* ((shared (list 1 2))
+         (v (vector shared shared "x" (make-bool-vector 10 t)))
+         (result (serialize-tests-round-trip v)))
+    (should (equal result v))
+    (should (eq (aref result 0) (aref result 1))))
+  ;; Cycles, through a car, a cdr and a vector.
+  (let* ((l (list 1 2 3))
+         (v (vector nil)))
+    (setcdr (cddr l) l)
+    (setcar l v)
+    (aset v 0 l)
+    (let ((result (serialize-tests-round-trip l)))
+      (should (eq (nthcdr 3 result) result))
+      (should (eq (aref (car result) 0) result))
+      (should (equal (cadr result) 2))))
+  (should (equal (serialize-tests-round-trip '(1 2 . 3)) '(1 2 . 3))))
+
+(ert-deftest serialize-tests-text-properties ()
+  (let* ((s (concat "ab" (propertize "cd" 'face 'bold) "e"))
+         (result (serialize-tests-round-trip s)))
+    (should (equal result s))
+    (should (equal-including-properties result s))))
+
+(ert-deftest serialize-tests-hash-table ()
+  (let ((h (make-hash-table :test 'equal :weakness 'key)))
+    (puthash "a" 1 h)
+    (puthash '(b) h h)
+    (let ((result (serialize-tests-round-trip h)))
+      (should (hash-table-p result))
+      (should (eq (hash-table-test result) 'equal))
+      (should (eq (hash-table-weakness result) 'key))
+      (should (= (hash-table-count result) 2))
+      (should (= (gethash "a" result) 1))
+      (should (eq (gethash '(b) result) result)))))
+
+(ert-deftest serialize-tests-invalid ()
+  (let ((data (serialize-object '(1 "two" [3]))))
+    (should-error (deserialize-object ""))
+    (should-error (deserialize-object "not serialized"))
+    (should-error (deserialize-object (substring data 0 -1)))
+    (should-error (deserialize-object (concat data "x")))))
+
+;;; serialize-tests.el ends here
@@ -0,0 +1,70 @@
+;;; textprop-tests.el --- tests for src/textprop.c
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'ert)
+
+(ert-deftest textprop-tests-text-property-runs ()
+  (with-temp-buffer
+    (insert "abcdefghij")
+    (should (equal (text-property-runs 1 11 'face) [(1 11 nil)]))
+    (put-text-property 3 5 'face 'bold)
+    (put-text-property 5 7 'face 'bold)
+    (put-text-property 4 6 'mouse-face 'highlight)
+    (put-text-property 8 9 'face 'italic)
+    (should (equal (text-property-runs 1 11 'face)
+                   [(1 3 nil) (3 7 bold) (7 8 nil) (8 9 italic) (9 11 nil)]))
+    (should (equal (text-property-runs 4 8 'face)
+                   [(4 7 bold) (7 8 nil)]))
+    (should (equal (text-property-runs 8 4 'mouse-face)
+                   [(4 6 highlight) (6 8 nil)]))
+    (should (equal (text-property-runs 5 5 'face) []))
+    (should-error (text-property-runs 1 20 'face)))
+  (let ((s (concat "ab" (propertize "cd" 'face 'bold) "e")))
+    (should (equal (text-property-runs 0 5 'face s)
+                   [(0 2 nil) (2 4 bold) (4 5 nil)]))))
+
+;; Overlays are consulted in priority order; among equal priorities
+;; the overlay nested inside the other wins.
+(ert-deftest textprop-tests-get-char-property-overlays ()
+  (with-temp-buffer
+    (insert "abcdefghij")
+    (put-text-property 1 11 'face 'text)
+    (let ((outer (make-overlay 2 9))
+          (inner (make-overlay 4 6))
+          (high (make-overlay 5 8)))
+      (overlay-put outer 'face 'outer)
+      (overlay-put inner 'face 'inner)
+      (overlay-put high 'priority 5)
+      (should (eq (get-char-property 1 'face) 'text))
+      (should (eq (get-char-property 3 'face) 'outer))
+      (should (eq (get-char-property 4 'face) 'inner))
+      (should (equal (get-char-property-and-overlay 5 'face)
+                     (cons 'inner inner)))
+      (overlay-put high 'face 'high)
+      (should (equal (get-char-property-and-overlay 5 'face)
+                     (cons 'high high)))
+      (should (eq (get-char-property 7 'face) 'high))
+      (should (equal (get-char-property-and-overlay 9 'face)
+                     (cons 'text nil))))))
+
+;;; textprop-tests.el ends here
@@ -1040,6 +1040,29 @@ This tests also `file-readable-p' and `file-regular-p'."
 	  (should (equal (mapcar 'car attr) '("bar" "boz"))))
       (ignore-errors (delete-directory tmp-name1 'recursive)))))
 
+(ert-deftest tramp-test19-prefetch-file-attributes ()
+  "Check `prefetch-file-attributes'."
+  (skip-unless (tramp--test-enabled))
+
+  (let* ((tmp-name1 (tramp--test-make-temp-name))
+	 (tmp-name2 (expand-file-name "foo" tmp-name1))
+	 (tmp-name3 (expand-file-name "bar" tmp-name1))
+	 attr)
+    (unwind-protect
+	(progn
+	  (make-directory tmp-name1)
+	  (write-region "foo" nil tmp-name2)
+	  (should-not
+	   (prefetch-file-attributes (list tmp-name1 tmp-name2 tmp-name3)))
+	  (should (file-exists-p tmp-name2))
+	  (should-not (file-exists-p tmp-name3))
+	  (should (file-directory-p tmp-name1))
+	  ;; Prefetched attributes are those asked for one by one.
+	  (setq attr (file-attributes tmp-name2))
+	  (let ((remote-file-name-inhibit-cache t))
+	    (should (equal (file-attributes tmp-name2) attr))))
+      (ignore-errors (delete-directory tmp-name1 'recursive)))))
+
 (ert-deftest tramp-test20-file-modes ()
   "Check `file-modes'.
 This tests also `file-executable-p', `file-writable-p' and `set-file-modes'."
@@ -0,0 +1,56 @@
+;;; view-large-file-tests.el --- tests for view-large-file.el
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; GNU Emacs is free software: you can redistribute it and/or modify
+;; it under the terms of the GNU General Public License as published by
+;; the Free Software Foundation, either version 3 of the License, or
+;; (at your option) any later version.
+
+;; GNU Emacs is distributed in the hope that it will be useful,
+;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;; GNU General Public License for more details.
+
+;; You should have received a copy of the GNU General Public License
+;; along with GNU Emacs.  If not, see <http://www.gnu.org/licenses/>.
+
+;;; Code:
+
+(require 'ert)
+(require 'view-large-file)
+
+(ert-deftest view-large-file-tests-windows ()
+  "Only a window of the file is read, and searches cross windows."
+  (let ((file (make-temp-file "view-large-file-tests"))
+        (view-large-file-window-size 100))
+    (unwind-protect
+        (progn
+          (with-temp-file file
+            (dotimes (i 100)
+              (insert (format "line %04d\n" i))))
+          (let ((buffer (save-window-excursion (view-large-file file))))
+            (unwind-protect
+                (with-current-buffer buffer
+                  (should (= (buffer-size) 100))
+                  (should (looking-at "line 0000\n"))
+                  (view-large-file-next)
+                  (should (= view-large-file-start 100))
+                  (should (looking-at "line 0010\n"))
+                  (view-large-file-previous)
+                  (should (= view-large-file-start 0))
+                  (view-large-file-goto-offset 995)
+                  (should (= view-large-file-start 900))
+                  (should (looking-at "0099\n\\'"))
+                  (view-large-file-goto-offset 0)
+                  (view-large-file-re-search-forward "line 0075")
+                  (should (= (view-large-file-offset (point)) 759))
+                  (should-error (view-large-file-re-search-forward "line 0075")
+                                :type 'search-failed)
+                  (should (= (view-large-file-offset (point)) 759)))
+              (kill-buffer buffer))))
+      (delete-file file))))
+
+;;; view-large-file-tests.el ends here
@@ -40,6 +40,39 @@
 	       (buffer-string))
 	     "foo\n"))))
 
+(ert-deftest zlib--stream ()
+  "Test compressing and decompressing with streams, a byte at a time."
+  (when (and (fboundp 'zlib-make-stream)
+	     (zlib-available-p))
+    (let* ((text (apply 'string (number-sequence 0 255)))
+	   (data (concat text text text))
+	   (compressed (zlib-stream-feed (zlib-make-stream 'compress)
+					 data t))
+	   (stream (zlib-make-stream 'decompress))
+	   (result ""))
+      (dotimes (i (length compressed))
+	(setq result (concat result (zlib-stream-feed
+				     stream (substring compressed i (1+ i))))))
+      (setq result (concat result (zlib-stream-feed stream "" t)))
+      (should (string= result data))
+      (should-error (zlib-stream-feed stream "x") :type 'error)
+      (should-error (zlib-stream-feed (zlib-make-stream 'decompress)
+				      (substring compressed 0 10) t)
+		    :type 'zlib-error))))
+
+(ert-deftest zlib--stream-file ()
+  "Test decompressing a gzipped file with a stream."
+  (when (and (fboundp 'zlib-make-stream)
+	     (zlib-available-p))
+    (should (string=
+	     (with-temp-buffer
+	       (set-buffer-multibyte nil)
+	       (insert-file-contents-literally
+		(expand-file-name "foo-gzipped" zlib-tests-data-directory))
+	       (zlib-stream-feed (zlib-make-stream 'decompress)
+				 (buffer-string) t))
+	     "foo\n"))))
+
 (provide 'zlib-tests)
 
 ;;; zlib-tests.el ends here.
@@ -0,0 +1,138 @@
+;;; bench-harness.el --- run the benchmarks in test/benchmarks  -*- lexical-binding:t -*-
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;; Each benchmark is defined with `bench-define', and times a body of
+;; code that exercises one hot path of the C core.  The body runs
+;; several times, each time in a fresh buffer prepared by the
+;; benchmark's setup form, after a garbage collection, so that one run
+;; does not pay for the garbage of another.  The data the benchmarks
+;; work on is generated with a fixed random seed, so that the runs of
+;; different builds do the same work.
+;;
+;; `bench-run-batch-and-exit' runs the benchmarks and writes the
+;; results to a JSON file, to be compared across builds:
+;;
+;;   emacs -batch -l bench-harness -l search-bench \
+;;         -f bench-run-batch-and-exit results.json
+
+;;; Code:
+
+(require 'cl-lib)
+(require 'benchmark)
+(require 'json)
+
+(defvar bench-repetitions 5
+  "How many times each benchmark is run.")
+
+(defvar bench-benchmarks nil
+  "The benchmarks defined, last first.
+Each element is (NAME DOC SETUP BODY), where SETUP and BODY are
+functions of no arguments.")
+
+(defmacro bench-define (name doc &rest body)
+  "Define a benchmark NAME, described by DOC, that times BODY.
+BODY may start with the keyword argument :setup FORM; FORM is
+evaluated before each run of BODY, in the same fresh buffer, and is
+not timed."
+  (declare (indent 1) (doc-string 2))
+  (let (setup)
+    (when (eq (car body) :setup)
+      (setq setup (cadr body)
+            body (cddr body)))
+    `(progn
+       (setq bench-benchmarks (cl-delete ',name bench-benchmarks
+                                         :key #'car))
+       (push (list ',name ,doc (lambda () ,setup) (lambda () ,@body))
+             bench-benchmarks)
+       ',name)))
+
+(defun bench-random-words (n &optional seed)
+  "Return a string of N pseudo-random words, the same for the same SEED."
+  (random (or seed "bench"))
+  (let ((syllables ["ka" "lo" "mi" "ne" "tu" "ra" "si" "po" "e" "an"]))
+    (mapconcat (lambda (_)
+                 (let ((word ""))
+                   (dotimes (_ (1+ (random 4)))
+                     (setq word (concat word (aref syllables
+                                                   (random (length syllables))))))
+                   (if (zerop (random 12))
+                       (concat word (number-to-string (random 1000)) "\n")
+                     word)))
+               (make-list n nil)
+               " ")))
+
+(defun bench-run-1 (benchmark)
+  "Run BENCHMARK, and return an alist of its timings."
+  (let (times (gcs 0) (gc-time 0.0))
+    (dotimes (_ bench-repetitions)
+      (with-temp-buffer
+        (funcall (nth 2 benchmark))
+        (garbage-collect)
+        (let ((result (benchmark-run (funcall (nth 3 benchmark)))))
+          (push (nth 0 result) times)
+          (setq gcs (+ gcs (nth 1 result))
+                gc-time (+ gc-time (nth 2 result))))))
+    (setq times (sort times #'<))
+    `((min . ,(car times))
+      (median . ,(nth (/ (length times) 2) times))
+      (mean . ,(/ (apply #'+ times) (length times)))
+      (max . ,(car (last times)))
+      (gcs . ,gcs)
+      (gc-time . ,gc-time)
+      (repetitions . ,bench-repetitions))))
+
+(defun bench-run (&optional selector)
+  "Run the benchmarks whose names match the regexp SELECTOR, or all.
+Return the results as an alist, ready for `json-encode'."
+  (let (results)
+    (dolist (benchmark (reverse bench-benchmarks))
+      (when (or (null selector)
+                (string-match selector (symbol-name (car benchmark))))
+        (message "Running %s..." (car benchmark))
+        (let ((timings (bench-run-1 benchmark)))
+          (message "  %-36s %10.6f s (median of %d)"
+                   (car benchmark) (cdr (assq 'median timings))
+                   bench-repetitions)
+          (push (cons (car benchmark) timings) results))))
+    `((emacs-version . ,emacs-version)
+      (system-configuration . ,system-configuration)
+      (date . ,(format-time-string "%Y-%m-%dT%H:%M:%SZ" nil t))
+      (benchmarks . ,(nreverse results)))))
+
+(defun bench-run-batch-and-exit ()
+  "Run the benchmarks and write their results to a JSON file.
+The file is named by the first command-line argument left, and the
+benchmarks are selected by the regexp in the environment variable
+BENCH_SELECTOR, if set."
+  (or noninteractive
+      (user-error "This function is only for use in batch mode"))
+  (let ((file (or (pop command-line-args-left) "results.json"))
+        (selector (getenv "BENCH_SELECTOR")))
+    (when (equal selector "")
+      (setq selector nil))
+    (with-temp-file file
+      (insert (json-encode (bench-run selector)) "\n"))
+    (message "Results written to %s" file)
+    (kill-emacs 0)))
+
+(provide 'bench-harness)
+
+;;; bench-harness.el ends here
@@ -0,0 +1,65 @@
+;;; display-bench.el --- benchmarks for the display code  -*- lexical-binding:t -*-
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;; In batch mode nothing is drawn, so these time the display iterator
+;; that redisplay uses to lay out text, by moving through a buffer by
+;; screen lines in the selected window.  Run interactively, with
+;; -l bench-harness -l display-bench and M-: (bench-run "display"),
+;; `display-redraw' also times redisplay itself.
+
+;;; Code:
+
+(require 'bench-harness)
+
+(defun display-bench-setup ()
+  "Fill the buffer with fixed text, and show it in the selected window."
+  (insert (bench-random-words 100000))
+  (put-text-property 1 (point-max) 'face 'bold)
+  (let ((pos 1))
+    (while (< pos (point-max))
+      (put-text-property pos (min (+ pos 7) (point-max)) 'face 'italic)
+      (setq pos (+ pos 97))))
+  (set-window-buffer nil (current-buffer))
+  (goto-char (point-min)))
+
+(bench-define display-vertical-motion
+  "Move through a buffer by screen lines, with line truncation."
+  :setup (progn (display-bench-setup)
+                (setq truncate-lines t))
+  (while (not (eobp))
+    (vertical-motion 1)))
+
+(bench-define display-vertical-motion-wrapped
+  "Move through a buffer by screen lines, with continuation lines."
+  :setup (progn (display-bench-setup)
+                (setq truncate-lines nil))
+  (while (not (eobp))
+    (vertical-motion 1)))
+
+(bench-define display-redraw
+  "Redisplay a window while scrolling through a buffer."
+  :setup (display-bench-setup)
+  (unless noninteractive
+    (dotimes (_ 200)
+      (scroll-up)
+      (redisplay t))))
+
+;;; display-bench.el ends here
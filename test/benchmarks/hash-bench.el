@@ -0,0 +1,64 @@
+;;; hash-bench.el --- benchmarks for the hash tables of src/fns.c  -*- lexical-binding:t -*-
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'bench-harness)
+
+(defvar hash-bench-keys nil
+  "A vector of the keys used by the benchmarks of one run.")
+
+(bench-define hash-fixnum
+  "Insert and look up 200000 fixnum keys in an eql table."
+  (let ((table (make-hash-table :test 'eql)))
+    (dotimes (i 200000)
+      (puthash i i table))
+    (dotimes (i 200000)
+      (gethash i table))))
+
+(bench-define hash-string
+  "Insert and look up 100000 string keys in an equal table."
+  :setup (progn
+           (setq hash-bench-keys (make-vector 100000 nil))
+           (dotimes (i 100000)
+             (aset hash-bench-keys i (format "key-%d" i))))
+  (let ((table (make-hash-table :test 'equal)))
+    (dotimes (i 100000)
+      (puthash (aref hash-bench-keys i) i table))
+    (dotimes (i 100000)
+      (gethash (aref hash-bench-keys i) table))
+    (dotimes (i 100000)
+      (remhash (aref hash-bench-keys i) table))))
+
+(bench-define hash-symbol
+  "Insert and look up 100000 symbol keys in an eq table."
+  :setup (progn
+           (setq hash-bench-keys (make-vector 100000 nil))
+           (dotimes (i 100000)
+             (aset hash-bench-keys i (make-symbol "key"))))
+  (let ((table (make-hash-table :test 'eq)))
+    (dotimes (i 100000)
+      (puthash (aref hash-bench-keys i) i table))
+    (dotimes (_ 5)
+      (dotimes (i 100000)
+        (gethash (aref hash-bench-keys i) table)))))
+
+;;; hash-bench.el ends here
@@ -0,0 +1,51 @@
+;;; insdel-bench.el --- benchmarks for src/insdel.c  -*- lexical-binding:t -*-
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'bench-harness)
+
+(bench-define insdel-append
+  "Insert 200000 short strings at the end of a buffer."
+  (dotimes (i 200000)
+    (insert "line " (if (zerop (% i 10)) "\n" ""))))
+
+(bench-define insdel-scattered
+  "Insert and delete text at positions all over a buffer.
+This moves the gap each time."
+  :setup (progn
+           (insert (bench-random-words 100000))
+           (random "insdel"))
+  (let ((size (buffer-size)))
+    (dotimes (_ 20000)
+      (goto-char (1+ (random size)))
+      (insert "xyzzy")
+      (goto-char (1+ (random size)))
+      (delete-char 5))))
+
+(bench-define insdel-delete-lines
+  "Delete a buffer of 20000 lines one line at a time from the front."
+  :setup (insert (bench-random-words 200000))
+  (goto-char (point-min))
+  (while (not (eobp))
+    (delete-region (point) (progn (forward-line 1) (point)))))
+
+;;; insdel-bench.el ends here
@@ -0,0 +1,65 @@
+;;; read-bench.el --- benchmarks for src/lread.c  -*- lexical-binding:t -*-
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'bench-harness)
+
+(defvar read-bench-file nil
+  "A file of Lisp data that the benchmarks read.")
+
+(defun read-bench-make-file ()
+  "Write `read-bench-file', unless it exists, and return its name."
+  (unless (and read-bench-file (file-exists-p read-bench-file))
+    (setq read-bench-file (make-temp-file "read-bench" nil ".el"))
+    (add-hook 'kill-emacs-hook
+              (lambda () (delete-file read-bench-file)))
+    (random "read")
+    (with-temp-file read-bench-file
+      (let ((print-escape-newlines t))
+        (dotimes (i 20000)
+          (prin1 `(defvar ,(intern (format "read-bench-%d" i))
+                    '(,i ,(* i 1.5) ,(format "string %d\n" i)
+                         [a b ,(random 100)] (x . y) ?c)
+                    "Documentation.")
+                 (current-buffer))
+          (insert "\n")))))
+  read-bench-file)
+
+(bench-define read-file-forms
+  "Read the 20000 forms of a file, from a buffer."
+  :setup (insert-file-contents (read-bench-make-file))
+  (goto-char (point-min))
+  (condition-case nil
+      (while t (read (current-buffer)))
+    (end-of-file nil)))
+
+(bench-define read-from-string
+  "Read the forms of a file one at a time from a string."
+  :setup (insert-file-contents (read-bench-make-file))
+  (let ((string (buffer-string))
+        (pos 0))
+    (condition-case nil
+        (while t
+          (setq pos (cdr (read-from-string string pos))))
+      (end-of-file nil))))
+
+;;; read-bench.el ends here
@@ -0,0 +1,50 @@
+;;; search-bench.el --- benchmarks for src/search.c and src/regex.c  -*- lexical-binding:t -*-
+
+;; Copyright (C) 2014 Free Software Foundation, Inc.
+
+;; This file is part of GNU Emacs.
+
+;; This program is free software: you can redistribute it and/or
+;; modify it under the terms of the GNU General Public License as
+;; published by the Free Software Foundation, either version 3 of the
+;; License, or (at your option) any later version.
+;;
+;; This program is distributed in the hope that it will be useful, but
+;; WITHOUT ANY WARRANTY; without even the implied warranty of
+;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;; General Public License for more details.
+;;
+;; You should have received a copy of the GNU General Public License
+;; along with this program.  If not, see `http://www.gnu.org/licenses/'.
+
+;;; Commentary:
+
+;;; Code:
+
+(require 'bench-harness)
+
+(bench-define search-regexp-forward
+  "Find every match of a regexp in a buffer of 200000 words."
+  :setup (insert (bench-random-words 200000))
+  (goto-char (point-min))
+  (while (re-search-forward "\\<\\(ka\\|mi\\)[a-z]*[0-9]+$" nil t)))
+
+(bench-define search-regexp-backward
+  "Find every match of a regexp, searching backward."
+  :setup (insert (bench-random-words 100000))
+  (goto-char (point-max))
+  (while (re-search-backward "po[a-z]*an" nil t)))
+
+(bench-define search-literal
+  "Find every occurrence of a string in a buffer of 200000 words."
+  :setup (insert (bench-random-words 200000))
+  (goto-char (point-min))
+  (while (search-forward "kalo" nil t)))
+
+(bench-define search-string-match
+  "Match a regexp against each line of a buffer, as strings."
+  :setup (insert (bench-random-words 200000))
+  (dolist (line (split-string (buffer-string) "\n"))
+    (string-match "\\([a-z]+\\) \\([a-z]+\\)[0-9]*\\'" line)))
+
+;;; search-bench.el ends here